@@ -13,8 +13,42 @@
 
 #include "MetricFuncs.h"
 #include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDThreads.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include <boost/cstdint.hpp>
 
 namespace RDDataManip {
+
+  /*! \brief Converts metric values to the type stored in a metric matrix
+   *
+   *  Floating point types are stored directly (after scaling). Integer types
+   *  (e.g. boost::uint16_t) are quantized: the value is multiplied by \c scale,
+   *  rounded to the nearest integer and clamped to the range of the type.
+   *  So a Tanimoto distance matrix can be stored with two bytes per entry
+   *  using:  MetricValueConverter<boost::uint16_t>(65535)
+   *
+   */
+  template <typename outType> struct MetricValueConverter {
+    explicit MetricValueConverter(double scaleFactor=1.0) : scale(scaleFactor) {};
+    outType operator()(double val) const {
+      val *= scale;
+      if (!std::numeric_limits<outType>::is_integer) {
+        return static_cast<outType>(val);
+      }
+      if (val <= static_cast<double>(std::numeric_limits<outType>::min())) {
+        return std::numeric_limits<outType>::min();
+      }
+      if (val >= static_cast<double>(std::numeric_limits<outType>::max())) {
+        return std::numeric_limits<outType>::max();
+      }
+      return static_cast<outType>(floor(val + 0.5));
+    };
+    double scale;
+  };
   
   /*! \brief A generic metric matrix calculator (e.g similarity matrix or
    *         distance matrix) 
@@ -73,14 +107,166 @@ namespace RDDataManip {
       CHECK_INVARIANT(distMat, "invalid pointer to a distance matix");
       
       for (unsigned int i = 1; i < nItems; i++) {
-        unsigned int itab = i*(i-1)/2;
+        size_t itab = static_cast<size_t>(i)*(i-1)/2;
         for (unsigned int j = 0; j < i; j++) {
           distMat[itab+j] = dp_metricFunc(descripts[i], descripts[j], dim);
         }
       }
     };
+
+    /*! \brief The blocked (and optionally multi-threaded) calculator function
+     *
+     * The lower triangle is split into square tiles of \c blockSize items so
+     * that the descriptors of a tile stay in cache while it is filled.
+     * Bands of tiles are distributed over the threads. The values in the
+     * resulting matrix are identical to those from the serial version.
+     *
+     * ARGUMENTS:
+     *
+     *  descrips - vectType container with a entryType for each item
+     *  nItems - the number of item in the descripts.
+     *  dim - the dimension of the sequences
+     *  distMat - pointer to an array to write the distance matrix to,
+     *            it must hold at least nItems*(nItems-1)/2 entries.
+     *  numThreads - the number of threads to use (see getNumThreadsToUse()).
+     *            NOTE: the vectType container and the metric function must be
+     *            safe to use from multiple threads (PySequenceHolder is not).
+     *  conv - converter used to store the values in distMat
+     *  blockSize - the number of items in each tile
+     *
+     */
+    template <typename outType>
+    void calcMetricMatrix(const vectType &descripts, unsigned int nItems, unsigned int dim,
+                          outType *distMat, int numThreads,
+                          const MetricValueConverter<outType> &conv=MetricValueConverter<outType>(),
+                          unsigned int blockSize=64) const {
+      CHECK_INVARIANT(distMat, "invalid pointer to a distance matix");
+      PRECONDITION(blockSize>0, "bad block size");
+      
+      TileParams<outType> params(dim, blockSize, conv);
+      unsigned int nThreads = RDKit::getNumThreadsToUse(numThreads);
+      if (nThreads == 1) {
+        calcBands<outType>(descripts, params, nItems, distMat, 0, 1);
+      }
+#ifdef RDK_THREADSAFE_SSS
+      else {
+        boost::thread_group tg;
+        for (unsigned int ti = 0; ti < nThreads; ++ti) {
+          tg.add_thread(new boost::thread(&MetricMatrixCalc::template calcBands<outType>, this,
+                                          boost::cref(descripts), boost::cref(params),
+                                          nItems, distMat, ti, nThreads));
+        }
+        tg.join_all();
+      }
+#endif
+    };
+
+    /*! \brief Calculates the metric matrix and writes it to a stream
+     *
+     * This is intended for matrices that do not fit in memory: rows are
+     * computed in bands of \c rowsPerBand items (each band is tiled and
+     * its tiles are distributed over the threads) and every band is written
+     * to the stream as soon as it is finished, so only one band is held in
+     * memory at a time.
+     *
+     * The data written is the binary (native byte order) lower triangle in the same
+     * layout as the in-memory versions, so the resulting file can be
+     * memory-mapped and used directly as a distance matrix.
+     *
+     * ARGUMENTS:
+     *
+     *  descrips - vectType container with a entryType for each item
+     *  nItems - the number of item in the descripts.
+     *  dim - the dimension of the sequences
+     *  outStream - the (binary) stream to write to
+     *  numThreads - the number of threads to use (see getNumThreadsToUse())
+     *  conv - converter used to store the values
+     *  blockSize - the number of items in each tile
+     *  rowsPerBand - the number of rows computed before they are written out
+     *
+     */
+    template <typename outType>
+    void writeMetricMatrix(const vectType &descripts, unsigned int nItems, unsigned int dim,
+                           std::ostream &outStream, int numThreads=1,
+                           const MetricValueConverter<outType> &conv=MetricValueConverter<outType>(),
+                           unsigned int blockSize=64, unsigned int rowsPerBand=1024) const {
+      PRECONDITION(blockSize>0, "bad block size");
+      PRECONDITION(rowsPerBand>0, "bad band size");
+      
+      TileParams<outType> params(dim, blockSize, conv);
+      unsigned int nThreads = RDKit::getNumThreadsToUse(numThreads);
+      std::vector<outType> buffer;
+      for (unsigned int rowStart = 1; rowStart < nItems; rowStart += rowsPerBand) {
+        unsigned int rowEnd = std::min(rowStart+rowsPerBand, nItems);
+        size_t bandLen = static_cast<size_t>(rowEnd)*(rowEnd-1)/2 -
+          static_cast<size_t>(rowStart)*(rowStart-1)/2;
+        buffer.resize(bandLen);
+        if (nThreads == 1) {
+          calcBand<outType>(descripts, params, rowStart, rowEnd, &buffer[0], 0, 1);
+        }
+#ifdef RDK_THREADSAFE_SSS
+        else {
+          boost::thread_group tg;
+          for (unsigned int ti = 0; ti < nThreads; ++ti) {
+            tg.add_thread(new boost::thread(&MetricMatrixCalc::template calcBand<outType>, this,
+                                            boost::cref(descripts), boost::cref(params),
+                                            rowStart, rowEnd, &buffer[0], ti, nThreads));
+          }
+          tg.join_all();
+        }
+#endif
+        outStream.write(reinterpret_cast<const char *>(&buffer[0]), bandLen*sizeof(outType));
+        CHECK_INVARIANT(outStream.good(), "error writing metric matrix");
+      }
+    };
     
   private:
+    // the settings shared by all tiles of a calculation
+    template <typename outType> struct TileParams {
+      TileParams(unsigned int d, unsigned int bs, const MetricValueConverter<outType> &c) :
+        dim(d), blockSize(bs), conv(c) {};
+      unsigned int dim;
+      unsigned int blockSize;
+      MetricValueConverter<outType> conv;
+    };
+
+    // fills the tiles in rows [rowStart,rowEnd) whose column-block index is
+    // congruent to blockOffset modulo blockStride. res points to the entry
+    // for (rowStart,0).
+    template <typename outType>
+    void calcBand(const vectType &descripts, const TileParams<outType> &params,
+                  unsigned int rowStart, unsigned int rowEnd, outType *res,
+                  unsigned int blockOffset, unsigned int blockStride) const {
+      const unsigned int dim = params.dim, blockSize = params.blockSize;
+      size_t base = static_cast<size_t>(rowStart)*(rowStart-1)/2;
+      for (unsigned int colStart = blockOffset*blockSize; colStart < rowEnd-1;
+           colStart += blockStride*blockSize) {
+        unsigned int colEnd = std::min(colStart+blockSize, rowEnd-1);
+        for (unsigned int i = std::max(rowStart, colStart+1); i < rowEnd; i++) {
+          outType *row = res + (static_cast<size_t>(i)*(i-1)/2 - base);
+          unsigned int jEnd = std::min(colEnd, i);
+          for (unsigned int j = colStart; j < jEnd; j++) {
+            row[j] = params.conv(dp_metricFunc(descripts[i], descripts[j], dim));
+          }
+        }
+      }
+    };
+
+    // fills the bands of blockSize rows whose index is congruent to
+    // bandOffset modulo bandStride
+    template <typename outType>
+    void calcBands(const vectType &descripts, const TileParams<outType> &params,
+                   unsigned int nItems, outType *distMat,
+                   unsigned int bandOffset, unsigned int bandStride) const {
+      const unsigned int blockSize = params.blockSize;
+      for (unsigned int rowStart = 1 + bandOffset*blockSize; rowStart < nItems;
+           rowStart += bandStride*blockSize) {
+        unsigned int rowEnd = std::min(rowStart+blockSize, nItems);
+        calcBand<outType>(descripts, params, rowStart, rowEnd,
+                          distMat + static_cast<size_t>(rowStart)*(rowStart-1)/2, 0, 1);
+      }
+    };
+
     // pointer to the metric function
     /*! \brief pointer to the metric function
      *
@@ -13,8 +13,69 @@
 
 #include <cstdlib>
 #include <time.h>
+#include <cstring>
+#include <sstream>
+#include <boost/cstdint.hpp>
 
 using namespace RDDataManip;
+
+void testBlocked(){
+  std::cout << "Testing the blocked calculator\n";
+  unsigned int n = 301;
+  unsigned int m = 5;
+  size_t dlen = n*(n-1)/2;
+  std::vector<double> desc(n*m);
+  std::vector<double *> desc2D(n);
+  for (unsigned int i = 0; i < n; i++) {
+    desc2D[i] = &desc[i*m];
+    for (unsigned int j = 0; j < m ; j++) {
+      desc[i*m + j] = ((double)rand())/RAND_MAX;
+    }
+  }
+
+  MetricMatrixCalc<std::vector<double *>, double*> mmCalc;
+  mmCalc.setMetricFunc(&EuclideanDistanceMetric<double *, double *>);
+  std::vector<double> ref(dlen);
+  mmCalc.calcMetricMatrix(desc2D, n, m, &ref[0]);
+
+  // block sizes that do and do not divide the number of items, different numbers of threads:
+  unsigned int blockSizes[] = {1, 7, 32, 64, 500};
+  for (unsigned int bi = 0; bi < 5; bi++) {
+    for (int nThreads = 1; nThreads < 5; nThreads++) {
+      std::vector<double> dmat(dlen, -1.0);
+      mmCalc.calcMetricMatrix(desc2D, n, m, &dmat[0], nThreads,
+                              MetricValueConverter<double>(), blockSizes[bi]);
+      TEST_ASSERT(dmat == ref);
+    }
+  }
+
+  // reduced precision:
+  std::vector<float> fmat(dlen);
+  mmCalc.calcMetricMatrix(desc2D, n, m, &fmat[0], 2);
+  for (size_t i = 0; i < dlen; i++) {
+    TEST_ASSERT(fmat[i] == static_cast<float>(ref[i]));
+  }
+  double maxVal = *std::max_element(ref.begin(), ref.end());
+  std::vector<boost::uint16_t> qmat(dlen);
+  MetricValueConverter<boost::uint16_t> qconv(65535/maxVal);
+  mmCalc.calcMetricMatrix(desc2D, n, m, &qmat[0], 2, qconv);
+  for (size_t i = 0; i < dlen; i++) {
+    TEST_ASSERT(fabs(qmat[i]*maxVal/65535 - ref[i]) <= 0.5*maxVal/65535 + 1e-12);
+  }
+  TEST_ASSERT(qconv(-1.0) == 0);
+  TEST_ASSERT(qconv(2*maxVal) == 65535);
+
+  // streamed output:
+  for (int nThreads = 1; nThreads < 4; nThreads++) {
+    std::stringstream ss(std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+    mmCalc.writeMetricMatrix(desc2D, n, m, ss, nThreads, MetricValueConverter<double>(), 16, 45);
+    std::string data = ss.str();
+    TEST_ASSERT(data.size() == dlen*sizeof(double));
+    TEST_ASSERT(!memcmp(data.c_str(), &ref[0], data.size()));
+  }
+  std::cout << "done\n";
+}
+
 int main() {
   
   int n = 10;
@@ -49,6 +110,8 @@ int main() {
   delete [] desc2D;
   delete [] desc;
   delete [] dmat;
+
+  testBlocked();
   
   exit(0);
 }
@@ -20,6 +20,8 @@
 #include <sstream>
 
 #include <boost/lexical_cast.hpp>
+#include <boost/cstdint.hpp>
+#include <cstring>
 
 using namespace RDKit;
 
@@ -760,6 +762,111 @@ UpdateBitVectFromBinaryText(T1& bv1,const std::string &fps){
 }
 
 
+namespace {
+  inline unsigned int packedPopCount(boost::uint64_t v){
+#ifdef USE_BUILTIN_POPCOUNT
+    return __builtin_popcountll(v);
+#else
+    v = v - ((v >> 1) & 0x5555555555555555ULL);
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<unsigned int>((v * 0x0101010101010101ULL) >> 56);
+#endif
+  }
+
+  // counts the bits set in fp and the bits it has in common with query,
+  // a word at a time
+  void packedCounts(const unsigned char *query,const unsigned char *fp,
+                    unsigned int numBytes,
+                    unsigned int &numInCommon,unsigned int &numOn){
+    numInCommon=0;
+    numOn=0;
+    unsigned int i=0;
+    for(;i+sizeof(boost::uint64_t)<=numBytes;i+=sizeof(boost::uint64_t)){
+      boost::uint64_t w1,w2;
+      memcpy(&w1,query+i,sizeof(w1));
+      memcpy(&w2,fp+i,sizeof(w2));
+      numInCommon += packedPopCount(w1&w2);
+      numOn += packedPopCount(w2);
+    }
+    for(;i<numBytes;++i){
+      numInCommon += packedPopCount(query[i]&fp[i]);
+      numOn += packedPopCount(fp[i]);
+    }
+  }
+
+  unsigned int packedNumOnBits(const unsigned char *fp,unsigned int numBytes){
+    unsigned int res,tmp;
+    packedCounts(fp,fp,numBytes,tmp,res);
+    return res;
+  }
+
+  // the metrics in terms of x=(V1&V2)_o, y=V1_o and z=V2_o; these follow
+  // the functions on bit vectors above, including their handling of
+  // empty vectors
+  struct PackedTanimoto {
+    double operator()(double x,double y,double z) const {
+      if((y+z-x)==0.0) return 1.0;
+      else return x / (y+z-x);
+    }
+  };
+  struct PackedDice {
+    double operator()(double x,double y,double z) const {
+      if(y+z>0.0) return 2*x/(y+z);
+      else return 0.0;
+    }
+  };
+  struct PackedTversky {
+    PackedTversky(double a,double b) : d_a(a), d_b(b) {};
+    double operator()(double x,double y,double z) const {
+      double denom = d_a*y + d_b*z + (1-d_a-d_b)*x;
+      if(denom==0.0) return 1.0;
+      else return x / denom;
+    }
+    double d_a,d_b;
+  };
+
+  template <typename MetricT>
+  void bulkPackedSimilarity(const unsigned char *query,const unsigned char *fps,
+                            unsigned int numFps,unsigned int numBytes,
+                            double *res,bool returnDistance,const MetricT &metric){
+    PRECONDITION(query || !numBytes,"no query");
+    PRECONDITION(fps || !numFps || !numBytes,"no fingerprints");
+    PRECONDITION(res || !numFps,"no result storage");
+    double y=packedNumOnBits(query,numBytes);
+    for(unsigned int i=0;i<numFps;++i){
+      unsigned int x,z;
+      packedCounts(query,fps+static_cast<size_t>(i)*numBytes,numBytes,x,z);
+      res[i] = metric(x,y,z);
+      if(returnDistance) res[i] = 1.0-res[i];
+    }
+  }
+}
+
+void
+BulkTanimotoSimilarityPacked(const unsigned char *query,const unsigned char *fps,
+                             unsigned int numFps,unsigned int numBytes,
+                             double *res,bool returnDistance){
+  bulkPackedSimilarity(query,fps,numFps,numBytes,res,returnDistance,PackedTanimoto());
+}
+
+void
+BulkDiceSimilarityPacked(const unsigned char *query,const unsigned char *fps,
+                         unsigned int numFps,unsigned int numBytes,
+                         double *res,bool returnDistance){
+  bulkPackedSimilarity(query,fps,numFps,numBytes,res,returnDistance,PackedDice());
+}
+
+void
+BulkTverskySimilarityPacked(const unsigned char *query,const unsigned char *fps,
+                            unsigned int numFps,unsigned int numBytes,
+                            double a,double b,
+                            double *res,bool returnDistance){
+  RANGE_CHECK(0,a,1);
+  RANGE_CHECK(0,b,1);
+  bulkPackedSimilarity(query,fps,numFps,numBytes,res,returnDistance,PackedTversky(a,b));
+}
+
 template double TanimotoSimilarity(const SparseBitVect& bv1,const SparseBitVect& bv2);
 template double TverskySimilarity(const SparseBitVect& bv1,const SparseBitVect& bv2,double a, double b);
 template double CosineSimilarity(const SparseBitVect& bv1,const SparseBitVect& bv2);
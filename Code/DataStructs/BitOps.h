@@ -330,6 +330,39 @@ template <typename T1>
 void
 UpdateBitVectFromBinaryText(T1& bv1,const std::string &fps);
 
+//! \name Similarities against blocks of packed fingerprints
+/*!
+  These compare a query with \c numFps fingerprints stored one after
+  another in \c fps, \c numBytes bytes each, in the layout produced by
+  BitVectToBinaryText() (bit \c i is bit <tt>i%8</tt> of byte <tt>i/8</tt>).
+  The query uses the same layout. The results match those of the
+  corresponding functions on bit vectors.
+
+  \param query          the packed query
+  \param fps            the packed fingerprints
+  \param numFps         the number of fingerprints in \c fps
+  \param numBytes       the number of bytes per fingerprint
+  \param res            used to return the results, must have room for
+                        \c numFps values
+  \param returnDistance if set, 1-similarity is returned
+
+ */
+//@{
+void
+BulkTanimotoSimilarityPacked(const unsigned char *query,const unsigned char *fps,
+                             unsigned int numFps,unsigned int numBytes,
+                             double *res,bool returnDistance=false);
+void
+BulkDiceSimilarityPacked(const unsigned char *query,const unsigned char *fps,
+                         unsigned int numFps,unsigned int numBytes,
+                         double *res,bool returnDistance=false);
+void
+BulkTverskySimilarityPacked(const unsigned char *query,const unsigned char *fps,
+                            unsigned int numFps,unsigned int numBytes,
+                            double a,double b,
+                            double *res,bool returnDistance=false);
+//@}
+
 
 
 #endif
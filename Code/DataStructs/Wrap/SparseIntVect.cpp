@@ -13,6 +13,7 @@
 #include <RDGeneral/types.h>
 #include <RDGeneral/Invariant.h>
 #include <RDBoost/PySequenceHolder.h>
+#include <RDBoost/Wrap.h>
 #include <DataStructs/SparseIntVect.h>
 #include <boost/cstdint.hpp>
 
@@ -50,43 +51,71 @@ namespace {
   }
 
 
+  // the vectors are extracted while holding the GIL, the similarities
+  // are then calculated without it.
   template <typename T>
-  python::list BulkDice(const T &siv1,python::list sivs,bool returnDistance){
-    python::list res;
+  void CollectSIVs(python::list sivs,std::vector<python::object> &holders,
+                   std::vector<const T *> &res){
     unsigned int nsivs=python::extract<unsigned int>(sivs.attr("__len__")());
+    holders.reserve(nsivs);
+    res.reserve(nsivs);
     for(unsigned int i=0;i<nsivs;++i){
-      double simVal;
-      const T &siv2=python::extract<T>(sivs[i])();
-      simVal = DiceSimilarity(siv1,siv2,returnDistance);
-      res.append(simVal);
+      holders.push_back(sivs[i]);
+      const T &siv2=python::extract<const T &>(holders.back())();
+      res.push_back(&siv2);
+    }
+  }
+  python::list SimsToList(const std::vector<double> &sims){
+    python::list res;
+    for(unsigned int i=0;i<sims.size();++i){
+      res.append(sims[i]);
     }
     return res;
   }
+
+  template <typename T>
+  python::list BulkDice(const T &siv1,python::list sivs,bool returnDistance){
+    std::vector<python::object> holders;
+    std::vector<const T *> siv2s;
+    CollectSIVs(sivs,holders,siv2s);
+    std::vector<double> sims(siv2s.size());
+    {
+      NOGIL gil;
+      for(unsigned int i=0;i<siv2s.size();++i){
+        sims[i] = DiceSimilarity(siv1,*siv2s[i],returnDistance);
+      }
+    }
+    return SimsToList(sims);
+  }
   template <typename T>
   python::list BulkTanimoto(const T &siv1,python::list sivs,bool returnDistance){
-    python::list res;
-    unsigned int nsivs=python::extract<unsigned int>(sivs.attr("__len__")());
-    for(unsigned int i=0;i<nsivs;++i){
-      double simVal;
-      const T &siv2=python::extract<T>(sivs[i])();
-      simVal = TanimotoSimilarity(siv1,siv2,returnDistance);
-      res.append(simVal);
+    std::vector<python::object> holders;
+    std::vector<const T *> siv2s;
+    CollectSIVs(sivs,holders,siv2s);
+    std::vector<double> sims(siv2s.size());
+    {
+      NOGIL gil;
+      for(unsigned int i=0;i<siv2s.size();++i){
+        sims[i] = TanimotoSimilarity(siv1,*siv2s[i],returnDistance);
+      }
     }
-    return res;
+    return SimsToList(sims);
   }
 
 
   template <typename T>
   python::list BulkTversky(const T &siv1,python::list sivs,double a,double b,bool returnDistance){
-    python::list res;
-    unsigned int nsivs=python::extract<unsigned int>(sivs.attr("__len__")());
-    for(unsigned int i=0;i<nsivs;++i){
-      double simVal;
-      const T &siv2=python::extract<T>(sivs[i])();
-      simVal = TverskySimilarity(siv1,siv2,a,b,returnDistance);
-      res.append(simVal);
+    std::vector<python::object> holders;
+    std::vector<const T *> siv2s;
+    CollectSIVs(sivs,holders,siv2s);
+    std::vector<double> sims(siv2s.size());
+    {
+      NOGIL gil;
+      for(unsigned int i=0;i<siv2s.size();++i){
+        sims[i] = TverskySimilarity(siv1,*siv2s[i],a,b,returnDistance);
+      }
     }
-    return res;
+    return SimsToList(sims);
   }
 }
 
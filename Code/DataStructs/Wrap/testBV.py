@@ -290,6 +290,38 @@ class TestCase(unittest.TestCase):
         sim = DataStructs.DiceSimilarity(bvs[0],bvs[i])
         self.failUnless(feq(sim,sims[i]))
 
+   def test11PackedBulkOps(self):
+      nbits = 2048
+      bvs = []
+      for bvi in range(10):
+        bv = DataStructs.ExplicitBitVect(nbits)
+        for j in range(nbits/10) :
+           x = random.randrange(0,nbits)
+           bv.SetBit(x)
+        bvs.append(bv)
+      packed = ''.join([DataStructs.BitVectToBinaryText(x) for x in bvs])
+
+      sims = DataStructs.BulkTanimotoSimilarityPacked(bvs[0],packed)
+      self.failUnless(len(sims)==len(bvs))
+      for i in range(len(bvs)):
+        sim = DataStructs.TanimotoSimilarity(bvs[0],bvs[i])
+        self.failUnless(feq(sim,sims[i]))
+
+      sims = DataStructs.BulkDiceSimilarityPacked(bvs[0],bytearray(packed),returnDistance=True)
+      for i in range(len(bvs)):
+        sim = DataStructs.DiceSimilarity(bvs[0],bvs[i],returnDistance=True)
+        self.failUnless(feq(sim,sims[i]))
+
+      sims = DataStructs.BulkTverskySimilarityPacked(bvs[0],packed,.3,.7)
+      for i in range(len(bvs)):
+        sim = DataStructs.TverskySimilarity(bvs[0],bvs[i],.3,.7)
+        self.failUnless(feq(sim,sims[i]))
+
+      self.failUnlessRaises(ValueError,
+                            lambda :DataStructs.BulkTanimotoSimilarityPacked(bvs[0],packed[:-1]))
+      self.failUnlessRaises(ValueError,
+                            lambda :DataStructs.BulkTanimotoSimilarityPacked(DataStructs.ExplicitBitVect(0),packed))
+
       
 if __name__ == '__main__':
    unittest.main()
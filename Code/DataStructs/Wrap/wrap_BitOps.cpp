@@ -8,9 +8,15 @@
 //  which is included in the file license.txt, found at the root
 //  of the RDKit source tree.
 //
+#define NO_IMPORT_ARRAY
+#define PY_ARRAY_UNIQUE_SYMBOL rddatastructs_array_API
 #include <boost/python.hpp>
+#include <RDBoost/Wrap.h>
 #include <DataStructs/BitVects.h>
 #include <DataStructs/BitOps.h>
+#include <numpy/npy_common.h>
+#include <numpy/arrayobject.h>
+#include <vector>
 
 
 namespace python = boost::python;
@@ -37,15 +43,39 @@ double SimilarityWrapper(const T &bv1,const std::string &pkl,double a,double b,
 }
 
 
+// collects the vectors from a python sequence. The sequence's items are
+// held in holders so that the vectors stay alive while the similarities
+// are calculated without the GIL.
+template <typename T>
+void CollectBitVects(python::object bvs,std::vector<python::object> &holders,
+                     std::vector<const T *> &res){
+  unsigned int nbvs=python::extract<unsigned int>(bvs.attr("__len__")());
+  holders.reserve(nbvs);
+  res.reserve(nbvs);
+  for(unsigned int i=0;i<nbvs;++i){
+    holders.push_back(bvs[i]);
+    const T &bv2=python::extract<const T &>(holders.back())();
+    res.push_back(&bv2);
+  }
+}
+
 template <typename T>
 python::list BulkWrapper(const T &bv1,python::object bvs,
                          double (*metric)(const T &,const T &),
                          bool returnDistance){
+  std::vector<python::object> holders;
+  std::vector<const T *> bv2s;
+  CollectBitVects(bvs,holders,bv2s);
+  std::vector<double> sims(bv2s.size());
+  {
+    NOGIL gil;
+    for(unsigned int i=0;i<bv2s.size();++i){
+      sims[i]=SimilarityWrapper(bv1,*bv2s[i],metric,returnDistance);
+    }
+  }
   python::list res;
-  unsigned int nbvs=python::extract<unsigned int>(bvs.attr("__len__")());
-  for(unsigned int i=0;i<nbvs;++i){
-    const T &bv2=python::extract<T>(bvs[i])();
-    res.append(SimilarityWrapper(bv1,bv2,metric,returnDistance));
+  for(unsigned int i=0;i<sims.size();++i){
+    res.append(sims[i]);
   }
   return res;
 }
@@ -54,15 +84,98 @@ template <typename T>
 python::list BulkWrapper(const T &bv1,python::object bvs,double a,double b,
                          double (*metric)(const T &,const T &,double,double),
                          bool returnDistance){
+  std::vector<python::object> holders;
+  std::vector<const T *> bv2s;
+  CollectBitVects(bvs,holders,bv2s);
+  std::vector<double> sims(bv2s.size());
+  {
+    NOGIL gil;
+    for(unsigned int i=0;i<bv2s.size();++i){
+      sims[i]=SimilarityWrapper(bv1,*bv2s[i],a,b,metric,returnDistance);
+    }
+  }
   python::list res;
-  unsigned int nbvs=python::extract<unsigned int>(bvs.attr("__len__")());
-  for(unsigned int i=0;i<nbvs;++i){
-    const T &bv2=python::extract<T>(bvs[i])();
-    res.append(SimilarityWrapper(bv1,bv2,a,b,metric,returnDistance));
+  for(unsigned int i=0;i<sims.size();++i){
+    res.append(sims[i]);
   }
   return res;
 }
 
+// the query and the block of fingerprints for the packed similarity
+// functions. The fingerprints come from any object supporting the buffer
+// protocol (a str, bytearray, contiguous numpy array, etc.)
+class PackedFPArgs {
+public:
+  PackedFPArgs(const ExplicitBitVect &bv1,python::object fps) :
+    d_query(BitVectToBinaryText(bv1)) {
+    if(d_query.empty()){
+      throw_value_error("the query fingerprint is empty");
+    }
+    if(PyObject_GetBuffer(fps.ptr(),&d_view,PyBUF_SIMPLE)!=0){
+      python::throw_error_already_set();
+    }
+    if(d_view.len%d_query.size()){
+      PyBuffer_Release(&d_view);
+      throw_value_error("the buffer size is not a multiple of the fingerprint size");
+    }
+  };
+  ~PackedFPArgs() { PyBuffer_Release(&d_view); };
+  const unsigned char *query() const {
+    return reinterpret_cast<const unsigned char *>(d_query.c_str());
+  };
+  const unsigned char *fps() const {
+    return static_cast<const unsigned char *>(d_view.buf);
+  };
+  unsigned int numBytes() const { return d_query.size(); };
+  unsigned int numFps() const { return d_view.len/d_query.size(); };
+  PyArrayObject *newResult() const {
+    npy_intp dims[1];
+    dims[0]=numFps();
+    PyArrayObject *res=(PyArrayObject *)PyArray_SimpleNew(1,dims,NPY_DOUBLE);
+    if(!res) python::throw_error_already_set();
+    return res;
+  };
+private:
+  PackedFPArgs(const PackedFPArgs &);
+  PackedFPArgs &operator=(const PackedFPArgs &);
+  std::string d_query;
+  Py_buffer d_view;
+};
+
+PyObject *BulkTanimotoSimilarityPacked_w(const ExplicitBitVect &bv1,python::object fps,
+                                         bool returnDistance){
+  PackedFPArgs args(bv1,fps);
+  PyArrayObject *res=args.newResult();
+  {
+    NOGIL gil;
+    BulkTanimotoSimilarityPacked(args.query(),args.fps(),args.numFps(),args.numBytes(),
+                                 static_cast<double *>(PyArray_DATA(res)),returnDistance);
+  }
+  return PyArray_Return(res);
+}
+PyObject *BulkDiceSimilarityPacked_w(const ExplicitBitVect &bv1,python::object fps,
+                                     bool returnDistance){
+  PackedFPArgs args(bv1,fps);
+  PyArrayObject *res=args.newResult();
+  {
+    NOGIL gil;
+    BulkDiceSimilarityPacked(args.query(),args.fps(),args.numFps(),args.numBytes(),
+                             static_cast<double *>(PyArray_DATA(res)),returnDistance);
+  }
+  return PyArray_Return(res);
+}
+PyObject *BulkTverskySimilarityPacked_w(const ExplicitBitVect &bv1,python::object fps,
+                                        double a,double b,bool returnDistance){
+  PackedFPArgs args(bv1,fps);
+  PyArrayObject *res=args.newResult();
+  {
+    NOGIL gil;
+    BulkTverskySimilarityPacked(args.query(),args.fps(),args.numFps(),args.numBytes(),a,b,
+                                static_cast<double *>(PyArray_DATA(res)),returnDistance);
+  }
+  return PyArray_Return(res);
+}
+
 template <typename T1, typename T2>
 double TanimotoSimilarity_w(const T1 &bv1,const T2 &bv2,bool returnDistance){
   return SimilarityWrapper(bv1,bv2,
@@ -299,6 +412,31 @@ struct BitOps_wrapper {
                     python::args("b"),python::args("returnDistance")=0),help.c_str());
     }
 
+    {
+      std::string help="Returns the similarities between a bit vector and a block of\n\
+  packed fingerprints as a numpy array.\n\
+\n\
+  ARGUMENTS:\n\
+    - bv1: an ExplicitBitVect\n\
+    - fps: any object supporting the buffer protocol (str, bytearray,\n\
+      contiguous numpy array, etc.) holding the fingerprints one after another\n\
+      in the format produced by BitVectToBinaryText(), e.g.\n\
+      ''.join([BitVectToBinaryText(x) for x in bvs])\n\
+    - returnDistance: (optional) if set, 1-similarity is returned\n\
+\n\
+  The calculation is done without holding the GIL.\n";
+      python::def("BulkTanimotoSimilarityPacked",BulkTanimotoSimilarityPacked_w,
+                  (python::args("bv1"),python::args("fps"),python::args("returnDistance")=0),
+                  help.c_str());
+      python::def("BulkDiceSimilarityPacked",BulkDiceSimilarityPacked_w,
+                  (python::args("bv1"),python::args("fps"),python::args("returnDistance")=0),
+                  help.c_str());
+      python::def("BulkTverskySimilarityPacked",BulkTverskySimilarityPacked_w,
+                  (python::args("bv1"),python::args("fps"),python::args("a"),
+                   python::args("b"),python::args("returnDistance")=0),
+                  help.c_str());
+    }
+
     DBL_DEF(OnBitSimilarity,BulkOnBitSimilarity,
             "B(bv1&bv2) / B(bv1|bv2)");
     DBL_DEF(AllBitSimilarity,BulkAllBitSimilarity,
@@ -1284,6 +1284,54 @@ void test12SimilaritiesSparseBV() {
 	TEST_ASSERT(feq(AllBitSimilarity(sbv,sbv2),0.6));
 }
 
+void test13BulkPackedSimilarity() {
+  // sizes with and without a partial last word/byte:
+  unsigned int sizes[]={2048,77,8};
+  for(unsigned int si=0;si<3;++si){
+    unsigned int nBits=sizes[si];
+    std::vector<ExplicitBitVect> bvs;
+    srand(23);
+    for(unsigned int i=0;i<20;++i){
+      ExplicitBitVect bv(nBits);
+      // leave the first one empty:
+      if(i){
+        for(unsigned int j=0;j<nBits;++j){
+          if(rand()%(i+1)==0) bv.setBit(j);
+        }
+      }
+      bvs.push_back(bv);
+    }
+    std::string packed;
+    for(unsigned int i=0;i<bvs.size();++i){
+      packed += BitVectToBinaryText(bvs[i]);
+    }
+    unsigned int numBytes=BitVectToBinaryText(bvs[0]).size();
+    TEST_ASSERT(packed.size()==bvs.size()*numBytes);
+    const unsigned char *fps=reinterpret_cast<const unsigned char *>(packed.c_str());
+
+    std::vector<double> res(bvs.size());
+    for(unsigned int qi=0;qi<bvs.size();qi+=3){
+      const unsigned char *query=fps+qi*numBytes;
+      BulkTanimotoSimilarityPacked(query,fps,bvs.size(),numBytes,&res.front());
+      for(unsigned int i=0;i<bvs.size();++i){
+        TEST_ASSERT(feq(res[i],TanimotoSimilarity(bvs[qi],bvs[i])));
+      }
+      BulkTanimotoSimilarityPacked(query,fps,bvs.size(),numBytes,&res.front(),true);
+      for(unsigned int i=0;i<bvs.size();++i){
+        TEST_ASSERT(feq(res[i],1.-TanimotoSimilarity(bvs[qi],bvs[i])));
+      }
+      BulkDiceSimilarityPacked(query,fps,bvs.size(),numBytes,&res.front());
+      for(unsigned int i=0;i<bvs.size();++i){
+        TEST_ASSERT(feq(res[i],DiceSimilarity(bvs[qi],bvs[i])));
+      }
+      BulkTverskySimilarityPacked(query,fps,bvs.size(),numBytes,0.3,0.7,&res.front());
+      for(unsigned int i=0;i<bvs.size();++i){
+        TEST_ASSERT(feq(res[i],TverskySimilarity(bvs[qi],bvs[i],0.3,0.7)));
+      }
+    }
+  }
+}
+
 int main(){
   RDLog::InitLogs();
   try{
@@ -1348,6 +1396,9 @@ int main(){
   BOOST_LOG(rdInfoLog) << " Test Similarity Measures SparseBitVect -------------------------------" << std::endl;
     test12SimilaritiesSparseBV();
 
+  BOOST_LOG(rdInfoLog) << " Test Similarities on packed BitVects -------------------------------" << std::endl;
+  test13BulkPackedSimilarity();
+
   return 0;
   
 }
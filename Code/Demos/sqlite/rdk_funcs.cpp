@@ -9,7 +9,7 @@
 //  of the RDKit source tree.
 //
 
-#include <sqlite3ext.h>
+#include "rdk_sqlite.h"
 SQLITE_EXTENSION_INIT1
 #include <GraphMol/RDKitBase.h>
 #include <GraphMol/MolPickler.h>
@@ -19,10 +19,11 @@ SQLITE_EXTENSION_INIT1
 #include <DataStructs/BitOps.h>
 #include <DataStructs/SparseIntVect.h>
 #include <GraphMol/Fingerprints/Fingerprints.h>
+#include <GraphMol/Fingerprints/AtomPairs.h>
 #include <GraphMol/Descriptors/MolDescriptors.h>
+#include <GraphMol/Descriptors/Crippen.h>
 #include <boost/cstdint.hpp>
 #include <string>
-#include <map>
 
 std::string stringFromTextArg(sqlite3_value *arg){
   const unsigned char *text=sqlite3_value_text(arg);
@@ -50,6 +51,66 @@ RDKit::ROMol *molFromBlobArg(sqlite3_value *arg){
 }
 
 
+RDKit::ROMol *molFromQueryArg(sqlite3_value *arg,bool asSmarts){
+  if(sqlite3_value_type(arg)==SQLITE_BLOB){
+    return molFromBlobArg(arg);
+  } else if(sqlite3_value_type(arg)==SQLITE_NULL){
+    return 0;
+  }
+  std::string text=stringFromTextArg(arg);
+  RDKit::ROMol *m;
+  try{
+    if(asSmarts){
+      m = RDKit::SmartsToMol(text);
+    } else {
+      m = RDKit::SmilesToMol(text);
+    }
+  } catch (...){
+    m=0;
+  }
+  return m;
+}
+
+ExplicitBitVect *similarityFingerprint(const RDKit::ROMol &mol){
+  return RDKit::RDKFingerprintMol(mol,1,7,2048,4,true);
+}
+
+// table from Andrew Dalke:
+const unsigned int byteBitCounts[] = {
+  0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,
+  1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
+  1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
+  2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
+  1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
+  2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
+  2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
+  3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,4,5,5,6,5,6,6,7,5,6,6,7,6,7,7,8,
+};
+
+// Query molecules are parsed once per statement: SQLite keeps them (as
+// "auxiliary data") for as long as the query argument is a constant.
+static void deleteQueryMol(void *patt){
+  delete static_cast<RDKit::ROMol *>(patt);
+}
+
+static RDKit::ROMol *getQueryMol(sqlite3_context *context,sqlite3_value **argv,
+                                 int argIdx,bool &cached){
+  RDKit::ROMol *patt=static_cast<RDKit::ROMol *>(sqlite3_get_auxdata(context,argIdx));
+  cached=(patt!=0);
+  if(!patt){
+    patt=molFromQueryArg(argv[argIdx],true);
+  }
+  return patt;
+}
+
+static void releaseQueryMol(sqlite3_context *context,int argIdx,
+                            RDKit::ROMol *patt,bool cached){
+  if(!patt || cached) return;
+  // SQLite now owns the molecule (and is free to delete it right away),
+  // so it cannot be used after this:
+  sqlite3_set_auxdata(context,argIdx,static_cast<void *>(patt),deleteQueryMol);
+}
+
 ExplicitBitVect *ebvFromBlobArg(sqlite3_value *arg){
   std::string pkl=stringFromBlobArg(arg);
   ExplicitBitVect *ebv;
@@ -99,6 +160,15 @@ RDKit::SparseIntVect<T> *sivFromBlobArg(sqlite3_value *arg){
     mw           : select count(*) from molecules where rdk_molAMW(molpkl)<200;
                    9.7s
 
+    2014: 4991 molecules from Data/NCI/first_5K.smi, see rdk_index.cpp
+    substruct    : select count(*) from molecules where 
+                   rdk_molHasSubstruct(molpkl,'C(=O)[OH]');
+                   0.10s
+    screened     : select count(*) from molecules,mols_ss where 
+                   mols_ss.query='C(=O)[OH]' and molecules.rowid=mols_ss.id
+                   and rdk_molHasSubstruct(molpkl,'C(=O)[OH]');
+                   0.026s  (S(=O)(=O)N: 0.11s -> 0.003s)
+
 
 		   
  --------------------------------- */
@@ -127,7 +197,7 @@ static void molWtFunc(
 ){
   RDKit::ROMol *m=molFromBlobArg(argv[0]);
   if(m){
-    double res=RDKit::Descriptors::CalcAMW(*m);
+    double res=RDKit::Descriptors::calcAMW(*m);
     delete m;
     sqlite3_result_double(context, res);
   } else {
@@ -144,7 +214,7 @@ static void molLogPFunc(
   RDKit::ROMol *m=molFromBlobArg(argv[0]);
   if(m){
     double res,tmp;
-    RDKit::Descriptors::CalcCrippenDescriptors(*m,res,tmp);
+    RDKit::Descriptors::calcCrippenDescriptors(*m,res,tmp);
     delete m;
     sqlite3_result_double(context, res);
   } else {
@@ -181,32 +251,25 @@ static void molHasSubstruct(
   int argc,
   sqlite3_value **argv
 ){
+  bool cached;
+  RDKit::ROMol *patt=getQueryMol(context,argv,1,cached);
+  if(!patt){
+    std::string errorMsg="SMARTS (argument 2) could not be converted into a molecule";
+    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
+    return;
+  }
   RDKit::ROMol *m=molFromBlobArg(argv[0]);
   if(!m){
+    releaseQueryMol(context,1,patt,cached);
     std::string errorMsg="BLOB (argument 1) could not be converted into a molecule";
     sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
     return;
   }
 
-  std::string smarts=stringFromTextArg(argv[1]);
-
-  std::map<std::string,boost::any> &molMap=
-    *static_cast<std::map<std::string,boost::any> *>(sqlite3_user_data(context));
-  RDKit::ROMol *patt=0;
-  if(molMap.find(smarts)!=molMap.end()){
-    patt=boost::any_cast<RDKit::ROMOL_SPTR>(molMap[smarts]).get();
-  } else {
-    patt=static_cast<RDKit::ROMol *>(RDKit::SmartsToMol(smarts));
-    molMap[smarts]=boost::any(RDKit::ROMOL_SPTR(patt));
-  }
-  if(!patt){
-    std::string errorMsg="SMARTS (argument 2) could not be converted into a molecule";
-    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
-    return;
-  }
   RDKit::MatchVectType match;
   int res=RDKit::SubstructMatch(*m,*patt,match,true,false,true);
   delete m;
+  releaseQueryMol(context,1,patt,cached);
   sqlite3_result_int(context, res);
 }
 
@@ -215,32 +278,25 @@ static void molSubstructCount(
   int argc,
   sqlite3_value **argv
 ){
+  bool cached;
+  RDKit::ROMol *patt=getQueryMol(context,argv,1,cached);
+  if(!patt){
+    std::string errorMsg="SMARTS (argument 2) could not be converted into a molecule";
+    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
+    return;
+  }
   RDKit::ROMol *m=molFromBlobArg(argv[0]);
   if(!m){
+    releaseQueryMol(context,1,patt,cached);
     std::string errorMsg="BLOB (argument 1) could not be converted into a molecule";
     sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
     return;
   }
 
-  std::string smarts=stringFromTextArg(argv[1]);
-
-  std::map<std::string,boost::any> &molMap=
-    *static_cast<std::map<std::string,boost::any> *>(sqlite3_user_data(context));
-  RDKit::ROMol *patt=0;
-  if(molMap.find(smarts)!=molMap.end()){
-    patt=boost::any_cast<RDKit::ROMOL_SPTR>(molMap[smarts]).get();
-  } else {
-    patt=static_cast<RDKit::ROMol *>(RDKit::SmartsToMol(smarts));
-    molMap[smarts]=boost::any(RDKit::ROMOL_SPTR(patt));
-  }
-  if(!patt){
-    std::string errorMsg="SMARTS (argument 2) could not be converted into a molecule";
-    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
-    return;
-  }
   std::vector<RDKit::MatchVectType> matches;
   int res=RDKit::SubstructMatch(*m,*patt,matches,true,true,false);
   delete m;
+  releaseQueryMol(context,1,patt,cached);
   sqlite3_result_int(context, res);
 }
 
@@ -255,7 +311,7 @@ static void blobToRDKitFingerprint(
     sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
     return;
   }
-  ExplicitBitVect *fp=RDKit::DaylightFingerprintMol(*m,1,7,2048,4,true,0.3,128);
+  ExplicitBitVect *fp=RDKit::RDKFingerprintMol(*m,1,7,2048,4,true,0.3,128);
   std::string text=fp->toString();
   delete fp;
   delete m;
@@ -273,7 +329,7 @@ static void blobToAtomPairFingerprint(
     sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
     return;
   }
-  RDKit::SparseIntVect<int> *fp=RDKit::Descriptors::AtomPairs::getAtomPairFingerprint(*m);
+  RDKit::SparseIntVect<boost::int32_t> *fp=RDKit::AtomPairs::getAtomPairFingerprint(*m);
   std::string text=fp->toString();
   delete fp;
   delete m;
@@ -308,17 +364,6 @@ static void ucvTanimotoSim(
   int argc,
   sqlite3_value **argv
 ){
-  // table from Andrew Dalke:
-  static const unsigned int popCounts[] = {
-    0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,
-    1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
-    1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
-    2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
-    1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
-    2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
-    2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
-    3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,4,5,5,6,5,6,6,7,5,6,6,7,6,7,7,8,
-  };
   const unsigned char *t1=(const unsigned char *)sqlite3_value_blob(argv[0]);
   int nB1=sqlite3_value_bytes(argv[0]);
   const unsigned char *t2=(const unsigned char *)sqlite3_value_blob(argv[1]);
@@ -330,9 +375,9 @@ static void ucvTanimotoSim(
   }
   unsigned int x=0,y=0,z=0;
   for(unsigned int i=0;i<(unsigned int)nB1;++i){
-    y+= popCounts[*t1];
-    z+= popCounts[*t2];
-    x+= popCounts[(*t1)&(*t2)];
+    y+= byteBitCounts[*t1];
+    z+= byteBitCounts[*t2];
+    x+= byteBitCounts[(*t1)&(*t2)];
     ++t1;
     ++t2;
   }
@@ -380,6 +425,20 @@ static void sivDiceSim(
   const unsigned char *t2=(const unsigned char *)sqlite3_value_blob(argv[1]);
   int nB2=sqlite3_value_bytes(argv[1]);
 
+  // the header is the version, the element size, the length and the
+  // number of elements:
+  const size_t headerBytes=4*sizeof(boost::uint32_t);
+  if(!t1 || static_cast<size_t>(nB1)<headerBytes){
+    std::string errorMsg="BLOB (argument 1) could not be converted into an int vector";
+    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
+    return;
+  }
+  if(!t2 || static_cast<size_t>(nB2)<headerBytes){
+    std::string errorMsg="BLOB (argument 2) could not be converted into an int vector";
+    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
+    return;
+  }
+
   // check the version flags:
   boost::uint32_t tmp;
   tmp = *(reinterpret_cast<const boost::uint32_t *>(t1));
@@ -432,9 +491,23 @@ static void sivDiceSim(
   nElem2 = *(reinterpret_cast<const boost::uint32_t *>(t2));
   t2+=sizeof(boost::uint32_t);
 
+  // each element is an index and a value:
+  const size_t elemBytes=sizeof(boost::uint32_t)+sizeof(boost::int32_t);
+  if(static_cast<size_t>(nB1)!=headerBytes+nElem1*elemBytes){
+    std::string errorMsg="BLOB (argument 1) has the wrong size";
+    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
+    return;
+  }
+  if(static_cast<size_t>(nB2)!=headerBytes+nElem2*elemBytes){
+    std::string errorMsg="BLOB (argument 2) has the wrong size";
+    sqlite3_result_error(context,errorMsg.c_str(),errorMsg.length());
+    return;
+  }
+
   if(!nElem1 || !nElem2){
     res=0.0;
     sqlite3_result_double(context, res);
+    return;
   }
 
   double v1Sum=0,v2Sum=0,numer=0;
@@ -510,7 +583,6 @@ extern "C" int sqlite3_extension_init(
   const sqlite3_api_routines *pApi
 ){
   SQLITE_EXTENSION_INIT2(pApi);
-  std::map<std::string,boost::any> *molMap=new std::map<std::string,boost::any>();
   sqlite3_create_function(db, "rdk_molNumAtoms", 1, SQLITE_ANY, 0, numAtomsFunc, 0, 0);
   sqlite3_create_function(db, "rdk_molAMW", 1, SQLITE_ANY, 0, molWtFunc, 0, 0);
   sqlite3_create_function(db, "rdk_smilesToBlob", 1, SQLITE_ANY, 0, smilesToBlob, 0, 0);
@@ -524,14 +596,10 @@ extern "C" int sqlite3_extension_init(
 			  blobToAtomPairFingerprint, 0, 0);
   sqlite3_create_function(db, "rdk_sivDiceSim", 2, SQLITE_ANY, 0,
 			  sivDiceSim, 0, 0);
-  sqlite3_create_function(db, "rdk_sivDiceSim2", 2, SQLITE_ANY, 0,
-			  sivDiceSim2, 0, 0);
-  sqlite3_create_function(db, "rdk_molHasSubstruct", 2, SQLITE_ANY,
-			  static_cast<void *>(molMap),
+  sqlite3_create_function(db, "rdk_molHasSubstruct", 2, SQLITE_ANY, 0,
                           molHasSubstruct, 0, 0);
-  sqlite3_create_function(db, "rdk_molSubstructCount", 2, SQLITE_ANY,
-			  static_cast<void *>(molMap),
+  sqlite3_create_function(db, "rdk_molSubstructCount", 2, SQLITE_ANY, 0,
                           molSubstructCount, 0, 0);
   sqlite3_create_function(db, "rdk_molLogP", 1, SQLITE_ANY, 0, molLogPFunc, 0, 0);
-  return 0;
+  return registerIndexModules(db);
 }
@@ -0,0 +1,554 @@
+//
+// Copyright (C) 2014 Greg Landrum
+//
+// @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+
+/* ---------------------------------
+
+  Fingerprint indices, implemented as virtual tables.
+
+  The fingerprints are stored in a shadow table (<name>_fps) that is
+  scanned without constructing any molecules, so the index can be used
+  to restrict the expensive work (depickling and matching) to a small
+  number of candidates.
+
+  Substructure screening:
+    create virtual table mols_ss using rdk_substruct_index;
+    insert into mols_ss(id,mol) select rowid,molpkl from molecules;
+
+    select count(*) from molecules,mols_ss
+       where mols_ss.query='c1ncncn1' and molecules.rowid=mols_ss.id
+       and rdk_molHasSubstruct(molpkl,'c1ncncn1');
+
+    A query on the index returns the ids of the molecules whose pattern
+    fingerprints contain all the bits of the query's fingerprint. The
+    query is SMARTS (TEXT) or a molecule pickle (BLOB).
+
+  Similarity searching:
+    create virtual table mols_sim using rdk_similarity_index;
+    insert into mols_sim(id,mol) select rowid,molpkl from molecules;
+
+    select id,similarity from mols_sim
+       where query='c1ccccc1C(=O)O' and k=10 and similarity>=0.5;
+
+    The rows come back in order of decreasing Tanimoto similarity
+    (using a 2048 bit RDKit fingerprint); k (optional)
+    limits the number of results. Lower bounds on similarity (> or >=)
+    are applied before the results are cut to k; any other conditions
+    are checked by SQLite afterwards, so they can leave fewer than k
+    rows. The query is SMILES (TEXT) or a
+    molecule pickle (BLOB).
+
+  The mol column accepts a molecule pickle or SMILES, it is not stored.
+
+ --------------------------------- */
+
+#include "rdk_sqlite.h"
+SQLITE_EXTENSION_INIT3
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/Fingerprints/Fingerprints.h>
+#include <DataStructs/ExplicitBitVect.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+  const int SUBSTRUCT_INDEX=0;
+  const int SIMILARITY_INDEX=1;
+
+  const unsigned int fpSize=2048;
+  const unsigned int fpBytes=fpSize/8;
+
+  // the columns of the two kinds of index (-1 if not present):
+  struct IndexType {
+    int kind;
+    const char *schema;
+    int simCol,molCol,queryCol,kCol;
+  };
+  IndexType substructIndexType={
+    SUBSTRUCT_INDEX,
+    "CREATE TABLE x(id INTEGER, mol HIDDEN, query HIDDEN)",
+    -1,1,2,-1
+  };
+  IndexType similarityIndexType={
+    SIMILARITY_INDEX,
+    "CREATE TABLE x(id INTEGER, similarity REAL, mol HIDDEN, query HIDDEN, k HIDDEN)",
+    1,2,3,4
+  };
+
+  // bits in idxNum:
+  const int HAVE_QUERY=0x1;
+  const int HAVE_K=0x2;
+  const int HAVE_THRESHOLD=0x4;
+
+  struct FPIndexTable {
+    sqlite3_vtab base; // must come first
+    sqlite3 *db;
+    const IndexType *type;
+    std::string dbName,name;
+  };
+
+  struct FPIndexCursor {
+    sqlite3_vtab_cursor base; // must come first
+    // (similarity, id) for each of the results:
+    std::vector< std::pair<double,sqlite3_int64> > rows;
+    bool haveSimilarities;
+    unsigned int pos;
+  };
+
+  // sorts by decreasing similarity, ties by increasing id
+  struct moreSimilar {
+    bool operator()(const std::pair<double,sqlite3_int64> &a,
+                    const std::pair<double,sqlite3_int64> &b) const {
+      if(a.first!=b.first) return a.first>b.first;
+      return a.second<b.second;
+    }
+  };
+
+  void setError(sqlite3_vtab *vtab,const char *msg){
+    sqlite3_free(vtab->zErrMsg);
+    vtab->zErrMsg=sqlite3_mprintf("%s",msg);
+  }
+
+  int runSQL(sqlite3 *db,char *sql){
+    if(!sql) return SQLITE_NOMEM;
+    int rc=sqlite3_exec(db,sql,0,0,0);
+    sqlite3_free(sql);
+    return rc;
+  }
+
+  // the fingerprint as it is stored in the index: fpBytes bytes, bit i
+  // is bit (i%8) of byte i/8. Returns an empty string on failure.
+  std::string indexFingerprint(const IndexType *type,const RDKit::ROMol &mol){
+    ExplicitBitVect *fp;
+    try{
+      if(type->kind==SUBSTRUCT_INDEX){
+        fp=RDKit::PatternFingerprintMol(mol,fpSize);
+      } else {
+        fp=similarityFingerprint(mol);
+      }
+    } catch (...){
+      return "";
+    }
+    std::string res(fpBytes,'\0');
+    IntVect onBits;
+    fp->getOnBits(onBits);
+    for(IntVect::const_iterator bit=onBits.begin();bit!=onBits.end();++bit){
+      res[*bit/8] |= static_cast<char>(1<<(*bit%8));
+    }
+    delete fp;
+    return res;
+  }
+
+  bool isSubset(const unsigned char *query,const unsigned char *fp){
+    for(unsigned int i=0;i<fpBytes;++i){
+      if((query[i]&fp[i])!=query[i]) return false;
+    }
+    return true;
+  }
+
+  double tanimoto(const unsigned char *query,unsigned int queryCount,
+                  const unsigned char *fp){
+    unsigned int fpCount=0,common=0;
+    for(unsigned int i=0;i<fpBytes;++i){
+      fpCount+=byteBitCounts[fp[i]];
+      common+=byteBitCounts[query[i]&fp[i]];
+    }
+    unsigned int denom=queryCount+fpCount-common;
+    return denom ? static_cast<double>(common)/denom : 0.0;
+  }
+
+  int indexInit(sqlite3 *db,void *pAux,int argc,const char *const *argv,
+                sqlite3_vtab **ppVtab,char **pzErr,bool create){
+    // argv[0] is the module name, argv[1] the database, argv[2] the table
+    if(argc>3){
+      *pzErr=sqlite3_mprintf("%s takes no arguments",argv[0]);
+      return SQLITE_ERROR;
+    }
+    const IndexType *type=static_cast<const IndexType *>(pAux);
+    int rc=sqlite3_declare_vtab(db,type->schema);
+    if(rc!=SQLITE_OK) return rc;
+    if(create){
+      rc=runSQL(db,sqlite3_mprintf("CREATE TABLE \"%w\".\"%w_fps\"(id INTEGER PRIMARY KEY, fp BLOB)",
+                                   argv[1],argv[2]));
+      if(rc!=SQLITE_OK){
+        *pzErr=sqlite3_mprintf("%s",sqlite3_errmsg(db));
+        return rc;
+      }
+    }
+    FPIndexTable *tbl=new FPIndexTable;
+    memset(&tbl->base,0,sizeof(tbl->base));
+    tbl->db=db;
+    tbl->type=type;
+    tbl->dbName=argv[1];
+    tbl->name=argv[2];
+    *ppVtab=&tbl->base;
+    return SQLITE_OK;
+  }
+
+  int indexCreate(sqlite3 *db,void *pAux,int argc,const char *const *argv,
+                  sqlite3_vtab **ppVtab,char **pzErr){
+    return indexInit(db,pAux,argc,argv,ppVtab,pzErr,true);
+  }
+
+  int indexConnect(sqlite3 *db,void *pAux,int argc,const char *const *argv,
+                   sqlite3_vtab **ppVtab,char **pzErr){
+    return indexInit(db,pAux,argc,argv,ppVtab,pzErr,false);
+  }
+
+  int indexDisconnect(sqlite3_vtab *vtab){
+    FPIndexTable *tbl=reinterpret_cast<FPIndexTable *>(vtab);
+    sqlite3_free(tbl->base.zErrMsg);
+    delete tbl;
+    return SQLITE_OK;
+  }
+
+  int indexDestroy(sqlite3_vtab *vtab){
+    FPIndexTable *tbl=reinterpret_cast<FPIndexTable *>(vtab);
+    int rc=runSQL(tbl->db,sqlite3_mprintf("DROP TABLE \"%w\".\"%w_fps\"",
+                                          tbl->dbName.c_str(),tbl->name.c_str()));
+    if(rc!=SQLITE_OK) return rc;
+    return indexDisconnect(vtab);
+  }
+
+  int indexRename(sqlite3_vtab *vtab,const char *newName){
+    FPIndexTable *tbl=reinterpret_cast<FPIndexTable *>(vtab);
+    int rc=runSQL(tbl->db,sqlite3_mprintf("ALTER TABLE \"%w\".\"%w_fps\" RENAME TO \"%w_fps\"",
+                                          tbl->dbName.c_str(),tbl->name.c_str(),newName));
+    if(rc==SQLITE_OK) tbl->name=newName;
+    return rc;
+  }
+
+  int indexBestIndex(sqlite3_vtab *vtab,sqlite3_index_info *info){
+    const IndexType *type=reinterpret_cast<FPIndexTable *>(vtab)->type;
+    int queryIdx=-1,kIdx=-1;
+    std::vector<int> thresholdIdx;
+    bool unusable=false;
+    for(int i=0;i<info->nConstraint;++i){
+      const struct sqlite3_index_info::sqlite3_index_constraint &constraint=info->aConstraint[i];
+      if(constraint.iColumn==type->queryCol || constraint.iColumn==type->kCol){
+        // the hidden columns can only be used as arguments:
+        if(!constraint.usable || constraint.op!=SQLITE_INDEX_CONSTRAINT_EQ){
+          unusable=true;
+        } else if(constraint.iColumn==type->queryCol){
+          queryIdx=i;
+        } else {
+          kIdx=i;
+        }
+      } else if(constraint.usable && constraint.iColumn==type->simCol &&
+                (constraint.op==SQLITE_INDEX_CONSTRAINT_GE ||
+                 constraint.op==SQLITE_INDEX_CONSTRAINT_GT)){
+        thresholdIdx.push_back(i);
+      }
+    }
+    if(unusable){
+      // make sure SQLite picks a plan that provides the arguments
+      return SQLITE_CONSTRAINT;
+    }
+
+    info->idxNum=0;
+    if(queryIdx<0){
+      if(kIdx>=0){
+        setError(vtab,"k requires a query");
+        return SQLITE_ERROR;
+      }
+      // a scan of all the ids in the index
+      info->estimatedCost=1e6;
+      return SQLITE_OK;
+    }
+    int argvIdx=1;
+    info->idxNum|=HAVE_QUERY;
+    info->aConstraintUsage[queryIdx].argvIndex=argvIdx++;
+    info->aConstraintUsage[queryIdx].omit=1;
+    if(kIdx>=0){
+      info->idxNum|=HAVE_K;
+      info->aConstraintUsage[kIdx].argvIndex=argvIdx++;
+      info->aConstraintUsage[kIdx].omit=1;
+    }
+    if(!thresholdIdx.empty()){
+      // the thresholds have to be applied before the results are cut to
+      // k, so all of them are passed on. idxStr holds their operators:
+      // 'g' for >= and 'G' for >.
+      std::string ops;
+      for(unsigned int i=0;i<thresholdIdx.size();++i){
+        bool strict=info->aConstraint[thresholdIdx[i]].op==SQLITE_INDEX_CONSTRAINT_GT;
+        ops+=strict ? 'G' : 'g';
+        info->aConstraintUsage[thresholdIdx[i]].argvIndex=argvIdx++;
+        info->aConstraintUsage[thresholdIdx[i]].omit=1;
+      }
+      info->idxNum|=HAVE_THRESHOLD;
+      info->idxStr=sqlite3_mprintf("%s",ops.c_str());
+      if(!info->idxStr) return SQLITE_NOMEM;
+      info->needToFreeIdxStr=1;
+    }
+    if(type->simCol>=0 && info->nOrderBy==1 &&
+       info->aOrderBy[0].iColumn==type->simCol && info->aOrderBy[0].desc){
+      info->orderByConsumed=1;
+    }
+    info->estimatedCost=1e3;
+    return SQLITE_OK;
+  }
+
+  int indexOpen(sqlite3_vtab *,sqlite3_vtab_cursor **ppCursor){
+    FPIndexCursor *csr=new FPIndexCursor;
+    memset(&csr->base,0,sizeof(csr->base));
+    csr->haveSimilarities=false;
+    csr->pos=0;
+    *ppCursor=&csr->base;
+    return SQLITE_OK;
+  }
+
+  int indexClose(sqlite3_vtab_cursor *cur){
+    delete reinterpret_cast<FPIndexCursor *>(cur);
+    return SQLITE_OK;
+  }
+
+  int indexFilter(sqlite3_vtab_cursor *cur,int idxNum,const char *idxStr,
+                  int,sqlite3_value **argv){
+    FPIndexCursor *csr=reinterpret_cast<FPIndexCursor *>(cur);
+    FPIndexTable *tbl=reinterpret_cast<FPIndexTable *>(cur->pVtab);
+    const IndexType *type=tbl->type;
+    csr->rows.clear();
+    csr->pos=0;
+    csr->haveSimilarities=false;
+
+    int argIdx=0;
+    std::string queryFP;
+    unsigned int queryCount=0;
+    if(idxNum&HAVE_QUERY){
+      RDKit::ROMol *query=molFromQueryArg(argv[argIdx++],type->kind==SUBSTRUCT_INDEX);
+      if(!query){
+        setError(cur->pVtab,"query could not be converted into a molecule");
+        return SQLITE_ERROR;
+      }
+      queryFP=indexFingerprint(type,*query);
+      delete query;
+      if(queryFP.empty()){
+        setError(cur->pVtab,"could not generate a fingerprint for the query");
+        return SQLITE_ERROR;
+      }
+      for(unsigned int i=0;i<fpBytes;++i){
+        queryCount+=byteBitCounts[static_cast<unsigned char>(queryFP[i])];
+      }
+    }
+    sqlite3_int64 k=-1;
+    if(idxNum&HAVE_K){
+      k=sqlite3_value_int64(argv[argIdx++]);
+    }
+    // the tightest of the similarity>= and similarity> constraints:
+    double threshold=-1.0;
+    bool strictThreshold=false;
+    if((idxNum&HAVE_THRESHOLD) && idxStr){
+      for(const char *op=idxStr;*op;++op){
+        double val=sqlite3_value_double(argv[argIdx++]);
+        bool strict=*op=='G';
+        if(val>threshold || (val==threshold && strict)){
+          threshold=val;
+          strictThreshold=strict;
+        }
+      }
+    }
+
+    char *sql=sqlite3_mprintf("SELECT id,fp FROM \"%w\".\"%w_fps\"",
+                              tbl->dbName.c_str(),tbl->name.c_str());
+    if(!sql) return SQLITE_NOMEM;
+    sqlite3_stmt *stmt;
+    int rc=sqlite3_prepare_v2(tbl->db,sql,-1,&stmt,0);
+    sqlite3_free(sql);
+    if(rc!=SQLITE_OK){
+      setError(cur->pVtab,sqlite3_errmsg(tbl->db));
+      return rc;
+    }
+    const unsigned char *qfp=reinterpret_cast<const unsigned char *>(queryFP.c_str());
+    while((rc=sqlite3_step(stmt))==SQLITE_ROW){
+      sqlite3_int64 id=sqlite3_column_int64(stmt,0);
+      if(!(idxNum&HAVE_QUERY)){
+        csr->rows.push_back(std::make_pair(0.0,id));
+        continue;
+      }
+      const unsigned char *fp=static_cast<const unsigned char *>(sqlite3_column_blob(stmt,1));
+      if(sqlite3_column_bytes(stmt,1)!=static_cast<int>(fpBytes)) continue;
+      if(type->kind==SUBSTRUCT_INDEX){
+        if(isSubset(qfp,fp)) csr->rows.push_back(std::make_pair(1.0,id));
+      } else {
+        double sim=tanimoto(qfp,queryCount,fp);
+        if(strictThreshold ? sim>threshold : sim>=threshold){
+          csr->rows.push_back(std::make_pair(sim,id));
+        }
+      }
+    }
+    sqlite3_finalize(stmt);
+    if(rc!=SQLITE_DONE){
+      setError(cur->pVtab,sqlite3_errmsg(tbl->db));
+      return rc;
+    }
+
+    if(type->kind==SIMILARITY_INDEX && (idxNum&HAVE_QUERY)){
+      csr->haveSimilarities=true;
+      if(k>=0 && static_cast<size_t>(k)<csr->rows.size()){
+        std::partial_sort(csr->rows.begin(),csr->rows.begin()+k,csr->rows.end(),
+                          moreSimilar());
+        csr->rows.resize(k);
+      } else {
+        std::sort(csr->rows.begin(),csr->rows.end(),moreSimilar());
+      }
+    }
+    return SQLITE_OK;
+  }
+
+  int indexNext(sqlite3_vtab_cursor *cur){
+    ++(reinterpret_cast<FPIndexCursor *>(cur)->pos);
+    return SQLITE_OK;
+  }
+
+  int indexEof(sqlite3_vtab_cursor *cur){
+    FPIndexCursor *csr=reinterpret_cast<FPIndexCursor *>(cur);
+    return csr->pos>=csr->rows.size();
+  }
+
+  int indexColumn(sqlite3_vtab_cursor *cur,sqlite3_context *context,int col){
+    FPIndexCursor *csr=reinterpret_cast<FPIndexCursor *>(cur);
+    const IndexType *type=reinterpret_cast<FPIndexTable *>(cur->pVtab)->type;
+    if(col==0){
+      sqlite3_result_int64(context,csr->rows[csr->pos].second);
+    } else if(col==type->simCol && csr->haveSimilarities){
+      sqlite3_result_double(context,csr->rows[csr->pos].first);
+    } else {
+      sqlite3_result_null(context);
+    }
+    return SQLITE_OK;
+  }
+
+  int indexRowid(sqlite3_vtab_cursor *cur,sqlite3_int64 *pRowid){
+    FPIndexCursor *csr=reinterpret_cast<FPIndexCursor *>(cur);
+    *pRowid=csr->rows[csr->pos].second;
+    return SQLITE_OK;
+  }
+
+  int deleteRow(FPIndexTable *tbl,sqlite3_int64 id){
+    char *sql=sqlite3_mprintf("DELETE FROM \"%w\".\"%w_fps\" WHERE id=%lld",
+                              tbl->dbName.c_str(),tbl->name.c_str(),id);
+    int rc=runSQL(tbl->db,sql);
+    if(rc!=SQLITE_OK) setError(&tbl->base,sqlite3_errmsg(tbl->db));
+    return rc;
+  }
+
+  int indexUpdate(sqlite3_vtab *vtab,int argc,sqlite3_value **argv,
+                  sqlite3_int64 *pRowid){
+    FPIndexTable *tbl=reinterpret_cast<FPIndexTable *>(vtab);
+    const IndexType *type=tbl->type;
+    // argv[0] is the row to delete (or update), argv[1] the new rowid
+    // and argv[2...] the new column values
+    if(argc==1){
+      return deleteRow(tbl,sqlite3_value_int64(argv[0]));
+    }
+    bool isUpdate=sqlite3_value_type(argv[0])!=SQLITE_NULL;
+
+    // only the id and the fingerprint of the mol are stored, the
+    // similarity is computed by queries:
+    if(sqlite3_value_type(argv[2+type->queryCol])!=SQLITE_NULL ||
+       (type->kCol>=0 && sqlite3_value_type(argv[2+type->kCol])!=SQLITE_NULL)){
+      setError(vtab,"only the id and mol columns of an index can be set");
+      return SQLITE_CONSTRAINT;
+    }
+
+    sqlite3_int64 id;
+    if(sqlite3_value_type(argv[2])!=SQLITE_NULL){
+      id=sqlite3_value_int64(argv[2]);
+    } else if(sqlite3_value_type(argv[1])!=SQLITE_NULL){
+      id=sqlite3_value_int64(argv[1]);
+    } else {
+      setError(vtab,"an id is required");
+      return SQLITE_CONSTRAINT;
+    }
+
+    char *sql;
+    std::string fp;
+    if(sqlite3_value_type(argv[2+type->molCol])==SQLITE_NULL){
+      if(!isUpdate){
+        setError(vtab,"a mol is required");
+        return SQLITE_CONSTRAINT;
+      }
+      // the mol isn't stored, so an update without one keeps the
+      // fingerprint and only changes the id:
+      sql=sqlite3_mprintf("UPDATE \"%w\".\"%w_fps\" SET id=? WHERE id=%lld",
+                          tbl->dbName.c_str(),tbl->name.c_str(),
+                          sqlite3_value_int64(argv[0]));
+    } else {
+      RDKit::ROMol *mol=molFromQueryArg(argv[2+type->molCol],false);
+      if(!mol){
+        setError(vtab,"mol could not be converted into a molecule");
+        return SQLITE_ERROR;
+      }
+      fp=indexFingerprint(type,*mol);
+      delete mol;
+      if(fp.empty()){
+        setError(vtab,"could not generate a fingerprint for the molecule");
+        return SQLITE_ERROR;
+      }
+      // the old row is only removed once we know the new one can be added:
+      if(isUpdate){
+        int rc=deleteRow(tbl,sqlite3_value_int64(argv[0]));
+        if(rc!=SQLITE_OK) return rc;
+      }
+      sql=sqlite3_mprintf("INSERT INTO \"%w\".\"%w_fps\"(id,fp) VALUES(?,?)",
+                          tbl->dbName.c_str(),tbl->name.c_str());
+    }
+    if(!sql) return SQLITE_NOMEM;
+    sqlite3_stmt *stmt;
+    int rc=sqlite3_prepare_v2(tbl->db,sql,-1,&stmt,0);
+    sqlite3_free(sql);
+    if(rc==SQLITE_OK){
+      sqlite3_bind_int64(stmt,1,id);
+      if(!fp.empty()){
+        sqlite3_bind_blob(stmt,2,fp.c_str(),fp.size(),SQLITE_TRANSIENT);
+      }
+      rc=sqlite3_step(stmt);
+      if(rc==SQLITE_DONE) rc=SQLITE_OK;
+      sqlite3_finalize(stmt);
+    }
+    if(rc!=SQLITE_OK){
+      setError(vtab,sqlite3_errmsg(tbl->db));
+      return rc;
+    }
+    *pRowid=id;
+    return SQLITE_OK;
+  }
+
+  // the methods are set by name: sqlite3_module gains members
+  // in newer versions of SQLite, these are left null.
+  sqlite3_module makeIndexModule(){
+    sqlite3_module res;
+    memset(&res,0,sizeof(res));
+    res.xCreate=indexCreate;
+    res.xConnect=indexConnect;
+    res.xBestIndex=indexBestIndex;
+    res.xDisconnect=indexDisconnect;
+    res.xDestroy=indexDestroy;
+    res.xOpen=indexOpen;
+    res.xClose=indexClose;
+    res.xFilter=indexFilter;
+    res.xNext=indexNext;
+    res.xEof=indexEof;
+    res.xColumn=indexColumn;
+    res.xRowid=indexRowid;
+    res.xUpdate=indexUpdate;
+    res.xRename=indexRename;
+    return res;
+  }
+  const sqlite3_module indexModule=makeIndexModule();
+}
+
+int registerIndexModules(sqlite3 *db){
+  int rc=sqlite3_create_module(db,"rdk_substruct_index",&indexModule,
+                               static_cast<void *>(&substructIndexType));
+  if(rc!=SQLITE_OK) return rc;
+  return sqlite3_create_module(db,"rdk_similarity_index",&indexModule,
+                               static_cast<void *>(&similarityIndexType));
+}
@@ -0,0 +1,38 @@
+//
+// Copyright (C) 2014 Greg Landrum
+//
+// @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RDK_SQLITE_H_
+#define _RDK_SQLITE_H_
+
+#include <sqlite3ext.h>
+#include <string>
+
+namespace RDKit {
+  class ROMol;
+}
+class ExplicitBitVect;
+
+// argument conversions, the molecule conversions return null on failure:
+std::string stringFromTextArg(sqlite3_value *arg);
+std::string stringFromBlobArg(sqlite3_value *arg);
+RDKit::ROMol *molFromBlobArg(sqlite3_value *arg);
+// a molecule from a pickle (BLOB) or from SMILES/SMARTS (TEXT):
+RDKit::ROMol *molFromQueryArg(sqlite3_value *arg,bool asSmarts);
+
+// the fingerprint used by the similarity index (an unfolded version of
+// the rdk_molToRDKitFP() fingerprint)
+ExplicitBitVect *similarityFingerprint(const RDKit::ROMol &mol);
+
+// number of set bits in each byte value
+extern const unsigned int byteBitCounts[256];
+
+// registers the rdk_substruct_index and rdk_similarity_index modules
+int registerIndexModules(sqlite3 *db);
+
+#endif
@@ -0,0 +1,190 @@
+//
+// Copyright (C) 2014 Greg Landrum
+//
+// @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+//  Loads the extension into an in-memory database and runs queries
+//  against it.
+//
+//  Usage: testSqliteExtension <path to rdk_sqlite>
+//
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDLog.h>
+#include <sqlite3.h>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+
+namespace {
+  // runs a statement, returning the first column of each row as text
+  int runQuery(sqlite3 *db,const std::string &sql,std::vector<std::string> &res){
+    res.clear();
+    sqlite3_stmt *stmt;
+    int rc=sqlite3_prepare_v2(db,sql.c_str(),-1,&stmt,0);
+    if(rc!=SQLITE_OK) return rc;
+    while((rc=sqlite3_step(stmt))==SQLITE_ROW){
+      const unsigned char *text=sqlite3_column_text(stmt,0);
+      res.push_back(text ? reinterpret_cast<const char *>(text) : "");
+    }
+    sqlite3_finalize(stmt);
+    return rc==SQLITE_DONE ? SQLITE_OK : rc;
+  }
+
+  std::string queryValue(sqlite3 *db,const std::string &sql){
+    std::vector<std::string> res;
+    int rc=runQuery(db,sql,res);
+    if(rc!=SQLITE_OK){
+      BOOST_LOG(rdErrorLog)<<sql<<": "<<sqlite3_errmsg(db)<<std::endl;
+    }
+    TEST_ASSERT(rc==SQLITE_OK);
+    TEST_ASSERT(res.size()==1);
+    return res[0];
+  }
+
+  void exec(sqlite3 *db,const std::string &sql){
+    char *err=0;
+    int rc=sqlite3_exec(db,sql.c_str(),0,0,&err);
+    if(rc!=SQLITE_OK){
+      BOOST_LOG(rdErrorLog)<<sql<<": "<<(err ? err : "")<<std::endl;
+      sqlite3_free(err);
+    }
+    TEST_ASSERT(rc==SQLITE_OK);
+  }
+
+  const char *smis[]={"c1ccccc1C(=O)O","c1ccncc1","CCc1ncncn1","CCO","c1ccccc1CC(=O)O",
+                      "C1CCCCC1","OC(=O)CCN","c1ccc2ccccc2c1"};
+  const unsigned int nSmis=sizeof(smis)/sizeof(smis[0]);
+
+  void setupDB(sqlite3 *db){
+    exec(db,"create table molecules (smiles text, molpkl blob)");
+    for(unsigned int i=0;i<nSmis;++i){
+      exec(db,std::string("insert into molecules(smiles) values ('")+smis[i]+"')");
+    }
+    exec(db,"update molecules set molpkl=rdk_smilesToBlob(smiles)");
+  }
+}
+
+void testCachedQueries(sqlite3 *db){
+  BOOST_LOG(rdInfoLog) << "testing queries with cached patterns" << std::endl;
+  // the pattern is constant, so it is parsed once for the statement:
+  TEST_ASSERT(queryValue(db,"select count(*) from molecules where "
+                         "rdk_molHasSubstruct(molpkl,'C(=O)[OH]')")=="3");
+  TEST_ASSERT(queryValue(db,"select sum(rdk_molSubstructCount(molpkl,'c')) from molecules")=="30");
+  // a pattern that changes from row to row:
+  TEST_ASSERT(queryValue(db,"select count(*) from molecules where "
+                         "rdk_molHasSubstruct(molpkl,smiles)")==
+              queryValue(db,"select count(*) from molecules"));
+  // a bad pattern is an error:
+  std::vector<std::string> res;
+  TEST_ASSERT(runQuery(db,"select rdk_molHasSubstruct(molpkl,'c1cc') from molecules",
+                       res)!=SQLITE_OK);
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+void testSubstructIndex(sqlite3 *db){
+  BOOST_LOG(rdInfoLog) << "testing the substructure index" << std::endl;
+  exec(db,"create virtual table mols_ss using rdk_substruct_index");
+  exec(db,"insert into mols_ss(id,mol) select rowid,molpkl from molecules");
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_ss")==
+              queryValue(db,"select count(*) from molecules"));
+
+  // the screen doesn't lose any matches:
+  std::string screened=queryValue(db,"select count(*) from molecules,mols_ss "
+                                  "where mols_ss.query='c1ccccc1' and molecules.rowid=mols_ss.id "
+                                  "and rdk_molHasSubstruct(molpkl,'c1ccccc1')");
+  TEST_ASSERT(screened=="3");
+  TEST_ASSERT(atoi(queryValue(db,"select count(*) from mols_ss where query='c1ccccc1'").c_str())>=3);
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_ss where query='c[Xe]'")=="0");
+
+  // the mol column also takes SMILES:
+  exec(db,"insert into mols_ss(id,mol) values (100,'c1ccccc1[Xe]')");
+  TEST_ASSERT(queryValue(db,"select id from mols_ss where query='c[Xe]'")=="100");
+  // changing the id keeps the fingerprint:
+  exec(db,"update mols_ss set id=101 where id=100");
+  TEST_ASSERT(queryValue(db,"select id from mols_ss where query='c[Xe]'")=="101");
+  // changing the mol replaces it:
+  exec(db,"update mols_ss set mol='CC[Xe]' where id=101");
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_ss where query='c1ccccc1' and id=101")=="0");
+  TEST_ASSERT(queryValue(db,"select id from mols_ss where query='CC[Xe]'")=="101");
+  // a bad molecule leaves the row alone:
+  std::vector<std::string> res;
+  TEST_ASSERT(runQuery(db,"update mols_ss set mol='c1cc' where id=101",res)!=SQLITE_OK);
+  TEST_ASSERT(queryValue(db,"select id from mols_ss where query='CC[Xe]'")=="101");
+  // the query column can't be stored:
+  TEST_ASSERT(runQuery(db,"update mols_ss set query='C' where id=101",res)!=SQLITE_OK);
+  exec(db,"delete from mols_ss where id=101");
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_ss where query='C[Xe]'")=="0");
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_ss")==
+              queryValue(db,"select count(*) from molecules"));
+  exec(db,"drop table mols_ss");
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+void testSimilarityIndex(sqlite3 *db){
+  BOOST_LOG(rdInfoLog) << "testing the similarity index" << std::endl;
+  exec(db,"create virtual table mols_sim using rdk_similarity_index");
+  exec(db,"insert into mols_sim(id,mol) select rowid,molpkl from molecules");
+
+  // the closest neighbor of a molecule in the table is the molecule itself:
+  TEST_ASSERT(queryValue(db,"select id from mols_sim where query='c1ccccc1CC(=O)O' and k=1")==
+              queryValue(db,"select rowid from molecules where smiles='c1ccccc1CC(=O)O'"));
+  TEST_ASSERT(queryValue(db,"select similarity from mols_sim where query='c1ccccc1CC(=O)O' "
+                         "and k=1")=="1.0");
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_sim where query='c1ccccc1CC(=O)O' "
+                         "and k=3")=="3");
+  // the rows come back in order of decreasing similarity:
+  std::vector<std::string> res;
+  TEST_ASSERT(runQuery(db,"select similarity from mols_sim where query='c1ccccc1CC(=O)O' "
+                       "and similarity>=0.1",res)==SQLITE_OK);
+  TEST_ASSERT(res.size()>1);
+  for(unsigned int i=1;i<res.size();++i){
+    TEST_ASSERT(atof(res[i].c_str())<=atof(res[i-1].c_str()));
+  }
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_sim where query='c1ccccc1CC(=O)O' "
+                         "and similarity>1.0")=="0");
+  // the thresholds are applied before the results are cut to k:
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_sim where query='c1ccccc1CC(=O)O' "
+                         "and similarity>1.0 and k=3")=="0");
+  TEST_ASSERT(queryValue(db,"select count(*) from mols_sim where query='c1ccccc1CC(=O)O' "
+                         "and similarity>=1.0 and k=3")=="1");
+  int nAbove=atoi(queryValue(db,"select count(*) from mols_sim where query='c1ccccc1CC(=O)O' "
+                             "and similarity>0.2").c_str());
+  TEST_ASSERT(nAbove>1);
+  char sql[256];
+  sprintf(sql,"select count(*) from mols_sim where query='c1ccccc1CC(=O)O' "
+          "and similarity>=0.1 and similarity>0.2 and k=%d",nAbove);
+  TEST_ASSERT(atoi(queryValue(db,sql).c_str())==nAbove);
+  exec(db,"drop table mols_sim");
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+int main(int argc,char *argv[]){
+  RDLog::InitLogs();
+  if(argc!=2){
+    std::cerr<<"usage: "<<argv[0]<<" <path to rdk_sqlite>"<<std::endl;
+    return 1;
+  }
+  sqlite3 *db;
+  TEST_ASSERT(sqlite3_open(":memory:",&db)==SQLITE_OK);
+  sqlite3_enable_load_extension(db,1);
+  char *err=0;
+  if(sqlite3_load_extension(db,argv[1],"sqlite3_extension_init",&err)!=SQLITE_OK){
+    BOOST_LOG(rdErrorLog)<<"could not load "<<argv[1]<<": "<<(err ? err : "")<<std::endl;
+    sqlite3_free(err);
+    return 1;
+  }
+  setupDB(db);
+
+  testCachedQueries(db);
+  testSubstructIndex(db);
+  testSimilarityIndex(db);
+
+  sqlite3_close(db);
+  return 0;
+}
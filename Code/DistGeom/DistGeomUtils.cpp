@@ -17,7 +17,7 @@
 #include <Numerics/SymmMatrix.h>
 #include <Numerics/Vector.h>
 #include <RDGeneral/Invariant.h>
-#include <Numerics/EigenSolvers/PowerEigenSolver.h>
+#include <Numerics/EigenSolvers/SubspaceEigenSolver.h>
 #include <RDGeneral/utils.h>
 #include <ForceField/ForceField.h>
 
@@ -119,8 +119,8 @@ namespace DistGeom {
       }
     }
     unsigned int nEigs = (dim < N) ? dim : N;
-    RDNumeric::EigenSolvers::powerEigenSolver(nEigs, T, eigVals, eigVecs,
-                                              (int)(sumSqD2*N));
+    RDNumeric::EigenSolvers::subspaceEigenSolver(nEigs, T, eigVals, eigVecs,
+                                                 (int)(sumSqD2*N));
     
     double *eigData = eigVals.getData();
     bool foundNeg = false;
@@ -10,64 +10,241 @@
 //
 #include "BoundsMatrix.h"
 #include "TriangleSmooth.h"
+#include <RDGeneral/RDThreads.h>
+#include <vector>
+#include <algorithm>
 
 namespace DistGeom {
-  bool triangleSmoothBounds(BoundsMatPtr boundsMat,double tol) {
-    return triangleSmoothBounds(boundsMat.get(),tol);
-  }
-  bool triangleSmoothBounds(BoundsMatrix *boundsMat,double tol) {
-    int npt = boundsMat->numRows();
-    int i, j, k;
-    double Uik, Lik, Ukj, sumUikUkj, diffLikUjk, diffLjkUik;
+  namespace {
+    // the reference implementation, working directly on the bounds matrix
+    bool smoothBoundsSerial(BoundsMatrix *boundsMat,double tol) {
+      int npt = boundsMat->numRows();
+      int i, j, k;
+      double Uik, Lik, Ukj, sumUikUkj, diffLikUjk, diffLjkUik;
     
-    for (k = 0; k < npt; k++) {
-      for (i = 0; i < npt-1; i++) {
-        if (i == k) {
-          continue;
-        }
-        Uik = boundsMat->getUpperBound(i,k);
-        Lik = boundsMat->getLowerBound(i,k);
-        for (j = i+1; j < npt; j++) {
-          if (j == k) {
+      for (k = 0; k < npt; k++) {
+        for (i = 0; i < npt-1; i++) {
+          if (i == k) {
             continue;
           }
-          Ukj = boundsMat->getUpperBound(k,j);
-          sumUikUkj = Uik + Ukj;
-          if (boundsMat->getUpperBound(i,j) > sumUikUkj) {
-            boundsMat->setUpperBound(i,j, sumUikUkj);
-          } 
+          Uik = boundsMat->getUpperBound(i,k);
+          Lik = boundsMat->getLowerBound(i,k);
+          for (j = i+1; j < npt; j++) {
+            if (j == k) {
+              continue;
+            }
+            Ukj = boundsMat->getUpperBound(k,j);
+            sumUikUkj = Uik + Ukj;
+            if (boundsMat->getUpperBound(i,j) > sumUikUkj) {
+              boundsMat->setUpperBound(i,j, sumUikUkj);
+            } 
           
-          diffLikUjk = Lik - Ukj;
-          diffLjkUik = boundsMat->getLowerBound(j,k) - Uik;
-          if (boundsMat->getLowerBound(i,j) < diffLikUjk) {
-            boundsMat->setLowerBound(i,j, diffLikUjk);
-          } else if (boundsMat->getLowerBound(i,j) < diffLjkUik) {
-            boundsMat->setLowerBound(i,j, diffLjkUik);
+            diffLikUjk = Lik - Ukj;
+            diffLjkUik = boundsMat->getLowerBound(j,k) - Uik;
+            if (boundsMat->getLowerBound(i,j) < diffLikUjk) {
+              boundsMat->setLowerBound(i,j, diffLikUjk);
+            } else if (boundsMat->getLowerBound(i,j) < diffLjkUik) {
+              boundsMat->setLowerBound(i,j, diffLjkUik);
+            }
+            double lBound=boundsMat->getLowerBound(i,j);
+            double uBound=boundsMat->getUpperBound(i,j);
+            if( tol>0. &&
+                (lBound-uBound)/lBound>0. &&
+                (lBound-uBound)/lBound<tol ){
+              boundsMat->setUpperBound(i,j,lBound);
+              uBound=lBound;
+            }
+            if (lBound - uBound>0.) {
+              return false;
+            }
           }
-          double lBound=boundsMat->getLowerBound(i,j);
-          double uBound=boundsMat->getUpperBound(i,j);
-          if( tol>0. &&
-              (lBound-uBound)/lBound>0. &&
-              (lBound-uBound)/lBound<tol ){
-            boundsMat->setUpperBound(i,j,lBound);
-            uBound=lBound;
+        }
+      }
+      return true;
+    }
+
+    // The bounds are copied into two packed upper triangles so that
+    // both the upper and the lower bounds of a row are contiguous. Within
+    // a pass over pivot k only elements (i,j) with i,j!=k are modified and
+    // those depend only on their own values and on row/column k, so the
+    // rows of a pass can be processed in any order (and in parallel)
+    // without changing the result.
+    class SmoothingData {
+    public:
+      SmoothingData(const BoundsMatrix *boundsMat,double tol) :
+        d_n(boundsMat->numRows()), d_tol(tol), d_k(0), df_bad(false) {
+        unsigned int nElems=d_n*(d_n-1)/2;
+        d_upper.resize(nElems);
+        d_lower.resize(nElems);
+        d_rowStarts.resize(d_n);
+        d_pivUpper.resize(d_n);
+        d_pivLower.resize(d_n);
+        const double *data=boundsMat->getData();
+        for(unsigned int i=0;i<d_n;++i){
+          d_rowStarts[i]=i*d_n-i*(i+1)/2;
+          for(unsigned int j=i+1;j<d_n;++j){
+            d_upper[d_rowStarts[i]+j-i-1]=data[i*d_n+j];
+            d_lower[d_rowStarts[i]+j-i-1]=data[j*d_n+i];
           }
-          if (lBound - uBound>0.) {
-            // std::cerr<<std::endl;
-            // for(unsigned int ii=0;ii<npt;++ii){
-            //   for(unsigned int jj=0;jj<npt;++jj){
-            //     std::cerr<<"  "<<std::setprecision(3)<<boundsMat->getVal(ii,jj);
-            //   }
-            //   std::cerr<<std::endl;
-            // }
-            // std::cerr<<std::endl;
-            // std::cerr<<" Fail: "<<i<<"-"<<j<<": " << boundsMat->getLowerBound(i,j) << " " << boundsMat->getUpperBound(i,j) << "\n";
-            return false;
+        }
+      }
+
+      void copyTo(BoundsMatrix *boundsMat) const {
+        double *data=boundsMat->getData();
+        for(unsigned int i=0;i<d_n;++i){
+          for(unsigned int j=i+1;j<d_n;++j){
+            data[i*d_n+j]=d_upper[d_rowStarts[i]+j-i-1];
+            data[j*d_n+i]=d_lower[d_rowStarts[i]+j-i-1];
           }
         }
       }
+
+      unsigned int numPoints() const { return d_n; };
+
+      //! collects the bounds between pivot \c k and all other points
+      void setPivot(unsigned int k) {
+        d_k=k;
+        for(unsigned int j=0;j<d_n;++j){
+          if(j<k){
+            d_pivUpper[j]=d_upper[d_rowStarts[j]+k-j-1];
+            d_pivLower[j]=d_lower[d_rowStarts[j]+k-j-1];
+          } else if(j>k){
+            d_pivUpper[j]=d_upper[d_rowStarts[k]+j-k-1];
+            d_pivLower[j]=d_lower[d_rowStarts[k]+j-k-1];
+          }
+        }
+      }
+
+      //! smooths row \c i using the current pivot, returns false if
+      //! the reference implementation needs to take over
+      bool smoothRow(unsigned int i) {
+        if(i==d_k || i+1>=d_n) return true;
+        // offset so that element j of the row is at index j:
+        double *uRow=&d_upper[0]+d_rowStarts[i]-i-1;
+        double *lRow=&d_lower[0]+d_rowStarts[i]-i-1;
+        double Uik=d_pivUpper[i];
+        double Lik=d_pivLower[i];
+        bool ok;
+        if(d_k>i){
+          ok=smoothRange(uRow,lRow,Uik,Lik,i+1,d_k) &&
+            smoothRange(uRow,lRow,Uik,Lik,d_k+1,d_n);
+        } else {
+          ok=smoothRange(uRow,lRow,Uik,Lik,i+1,d_n);
+        }
+        return ok;
+      }
+
+      bool isBad() const { return df_bad; };
+      void setBad() { df_bad=true; };
+
+    private:
+      // this mirrors the body of the reference implementation, but
+      // without branches so that the loop can be vectorized. Instead of
+      // stopping at the first failure the function reports whether the
+      // bounds became inconsistent or a negative bound would have been
+      // set (which the BoundsMatrix setters reject).
+      bool smoothRange(double *uRow,double *lRow,double Uik,double Lik,
+                       unsigned int jBeg,unsigned int jEnd) const {
+        const double *pivU=&d_pivUpper[0];
+        const double *pivL=&d_pivLower[0];
+        const double tol=d_tol;
+        unsigned int nBad=0;
+        for(unsigned int j=jBeg;j<jEnd;++j){
+          double u=uRow[j];
+          double l=lRow[j];
+          double sumUikUkj=Uik+pivU[j];
+          bool setU=u>sumUikUkj;
+          u = setU ? sumUikUkj : u;
+          double diffLikUjk=Lik-pivU[j];
+          double diffLjkUik=pivL[j]-Uik;
+          bool setL1=l<diffLikUjk;
+          bool setL2=!setL1 && l<diffLjkUik;
+          l = setL1 ? diffLikUjk : (setL2 ? diffLjkUik : l);
+          bool setTol=tol>0. && (l-u)/l>0. && (l-u)/l<tol;
+          u = setTol ? l : u;
+          nBad += (l-u>0.) |
+            (setU && sumUikUkj<0.0) | ((setL1||setL2) && l<0.0) | (setTol && l<0.0);
+          uRow[j]=u;
+          lRow[j]=l;
+        }
+        return !nBad;
+      }
+
+      unsigned int d_n;
+      double d_tol;
+      unsigned int d_k;
+      bool df_bad;
+      std::vector<double> d_upper,d_lower;
+      std::vector<double> d_pivUpper,d_pivLower;
+      std::vector<unsigned int> d_rowStarts;
+    };
+
+#ifdef RDK_THREADSAFE_SSS
+    void smoothWorker(SmoothingData *sdata,boost::barrier *barrier,
+                      unsigned int threadId,unsigned int numThreads,
+                      std::vector<char> *threadBad){
+      unsigned int npt=sdata->numPoints();
+      for(unsigned int k=0;k<npt;++k){
+        if(threadId==0) sdata->setPivot(k);
+        barrier->wait();
+        // rows get shorter as i increases, so interleave them:
+        for(unsigned int i=threadId;i<npt-1;i+=numThreads){
+          if(!sdata->smoothRow(i)){
+            (*threadBad)[threadId]=1;
+            break;
+          }
+        }
+        barrier->wait();
+        if(std::find(threadBad->begin(),threadBad->end(),1)!=threadBad->end()){
+          if(threadId==0) sdata->setBad();
+          return;
+        }
+      }
+    }
+#endif
+  }
+
+  bool triangleSmoothBounds(BoundsMatPtr boundsMat,double tol,int numThreads) {
+    return triangleSmoothBounds(boundsMat.get(),tol,numThreads);
+  }
+  bool triangleSmoothBounds(BoundsMatrix *boundsMat,double tol,int numThreads) {
+    PRECONDITION(boundsMat,"no bounds matrix");
+    if(boundsMat->numRows()<3){
+      return smoothBoundsSerial(boundsMat,tol);
+    }
+    SmoothingData sdata(boundsMat,tol);
+    unsigned int npt=sdata.numPoints();
+    unsigned int nThreads=std::min(RDKit::getNumThreadsToUse(numThreads),npt-1);
+#ifdef RDK_THREADSAFE_SSS
+    if(nThreads>1){
+      boost::barrier barrier(nThreads);
+      std::vector<char> threadBad(nThreads,0);
+      boost::thread_group tg;
+      for(unsigned int ti=0;ti<nThreads;++ti){
+        tg.add_thread(new boost::thread(smoothWorker,&sdata,&barrier,
+                                        ti,nThreads,&threadBad));
+      }
+      tg.join_all();
+    } else
+#endif
+    {
+      for(unsigned int k=0;k<npt && !sdata.isBad();++k){
+        sdata.setPivot(k);
+        for(unsigned int i=0;i<npt-1;++i){
+          if(!sdata.smoothRow(i)){
+            sdata.setBad();
+            break;
+          }
+        }
+      }
+    }
+    if(sdata.isBad()){
+      // the bounds matrix itself is still untouched. Let the reference
+      // implementation redo the work: it leaves the matrix in exactly
+      // the state it always has on failure (and throws for negative bounds).
+      return smoothBoundsSerial(boundsMat,tol);
     }
+    sdata.copyTo(boundsMat);
     return true;
   }
 }
- 
@@ -24,11 +24,17 @@ namespace DistGeom {
 
     \param boundsMat  A pointer to the distance bounds matrix
     \param tol   a tolerance (percent) for errors in the smoothing process
+    \param numThreads  the number of threads to use. Values <=0 are
+                       interpreted relative to the number of hardware
+                       threads (see RDKit::getNumThreadsToUse())
 
+    The results do not depend on the number of threads used. If smoothing
+    fails the matrix is left in the same state as by a single-threaded
+    run that stops at the first violation.
   */
-  bool triangleSmoothBounds(BoundsMatrix *boundsMat,double tol=0.);
+  bool triangleSmoothBounds(BoundsMatrix *boundsMat,double tol=0.,int numThreads=1);
   //! \overload
-  bool triangleSmoothBounds(BoundsMatPtr boundsMat,double tol=0.);
+  bool triangleSmoothBounds(BoundsMatPtr boundsMat,double tol=0.,int numThreads=1);
 }
 
 #endif
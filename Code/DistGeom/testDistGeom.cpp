@@ -103,6 +103,42 @@ void testIssue216() {
     }
   }
 }
+void testSmoothingThreads() {
+  // a consistent set of bounds for points on a helix, with some
+  // of the bounds missing:
+  unsigned int npt = 120;
+  BoundsMatrix mmat(npt);
+  for (unsigned int i = 0; i < npt; i++) {
+    RDGeom::Point3D pi(cos(0.5*i), sin(0.5*i), 0.1*i);
+    for (unsigned int j = i+1; j < npt; j++) {
+      RDGeom::Point3D pj(cos(0.5*j), sin(0.5*j), 0.1*j);
+      double d = (pi-pj).length();
+      if ((i+j)%3) {
+        mmat.setUpperBound(i, j, 100.0); mmat.setLowerBound(i, j, 0.0);
+      } else {
+        mmat.setUpperBound(i, j, 1.05*d); mmat.setLowerBound(i, j, 0.95*d);
+      }
+    }
+  }
+  BoundsMatrix m1(mmat), m2(mmat);
+  CHECK_INVARIANT(triangleSmoothBounds(&m1), "");
+  CHECK_INVARIANT(triangleSmoothBounds(&m2, 0.0, 4), "");
+  for (unsigned int i = 0; i < npt*npt; i++) {
+    CHECK_INVARIANT(m1.getData()[i] == m2.getData()[i], "");
+  }
+  CHECK_INVARIANT(m1.checkValid(), "");
+
+  // an inconsistent one, the state of the matrix after the failure
+  // should not depend on the number of threads:
+  mmat.setLowerBound(3, 90, 90.0);
+  BoundsMatrix m3(mmat), m4(mmat);
+  CHECK_INVARIANT(!triangleSmoothBounds(&m3), "");
+  CHECK_INVARIANT(!triangleSmoothBounds(&m4, 0.0, 4), "");
+  for (unsigned int i = 0; i < npt*npt; i++) {
+    CHECK_INVARIANT(m3.getData()[i] == m4.getData()[i], "");
+  }
+}
+
 int main() {
   std::cout << "***********************************************************\n";
   std::cout << "   test1 \n";
@@ -111,6 +147,10 @@ int main() {
   std::cout << "***********************************************************\n";
   std::cout << "   testIssue216 \n";
   testIssue216();
+
+  std::cout << "***********************************************************\n";
+  std::cout << "   testSmoothingThreads \n";
+  testSmoothingThreads();
   std::cout << "***********************************************************\n\n";
   return 0;
 }
@@ -19,15 +19,16 @@
 #include <iostream>
 #include <sstream>
 #include <RDGeneral/StreamOps.h>
-#include <boost/lexical_cast.hpp>
-#include <boost/tokenizer.hpp>
+#include <RDGeneral/TabFieldIterator.h>
 #include <Geometry/point.h>
 
-typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
-
 
 namespace ForceFields {
   namespace MMFF {
+    #ifndef RDK_GENERATING_FF_PARAM_TABLES
+    // the default parameters, generated at build time by genParamTables
+    #include "MMFFParamTables.inc"
+    #endif
 
     class MMFFAromCollection * MMFFAromCollection::ds_instance = NULL;
 
@@ -78,7 +79,13 @@ namespace ForceFields {
     MMFFDefCollection::MMFFDefCollection(std::string mmffDef)
     {
       if (mmffDef == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        dp_params = mmffDefTable;
+        d_numParams = mmffDefTableSize;
+        return;
+        #else
         mmffDef = defaultMMFFDef;
+        #endif
       }
       std::istringstream inStream(mmffDef);
       std::string inLine = RDKit::getLine(inStream);
@@ -87,41 +94,33 @@ namespace ForceFields {
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFDef mmffDefObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
           // skip first token
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int atomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          atomType = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
-          #endif
+          atomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
           // Level 2 (currently = Level 1, see MMFF.I page 513)
-          mmffDefObj.eqLevel[0] = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffDefObj.eqLevel[0] = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
           // Level 3
-          mmffDefObj.eqLevel[1] = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffDefObj.eqLevel[1] = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
           // Level 4
-          mmffDefObj.eqLevel[2] = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffDefObj.eqLevel[2] = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
           // Level 5
-          mmffDefObj.eqLevel[3] = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffDefObj.eqLevel[3] = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
           if (atomType != oldAtomType) {
-            #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-            d_params[atomType] = mmffDefObj;
-            #else
-            d_params.push_back(mmffDefObj);
-            #endif
+            d_ownedParams.push_back(mmffDefObj);
             oldAtomType = atomType;
           }
         }
         inLine = RDKit::getLine(inStream);
       }
+      dp_params = (d_ownedParams.empty() ? NULL : &d_ownedParams[0]);
+      d_numParams = d_ownedParams.size();
     }
     const std::string defaultMMFFDef =
       "*\n"
@@ -336,47 +335,44 @@ namespace ForceFields {
     MMFFPropCollection::MMFFPropCollection(std::string mmffProp)
     {
       if (mmffProp == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffPropTable, mmffPropTableSize);
+        return;
+        #else
         mmffProp = defaultMMFFProp;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFProp> > params;
       std::istringstream inStream(mmffProp);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFProp mmffPropObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int atomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomType.push_back((boost::uint8_t)boost::lexical_cast<unsigned int>(*token));
-          #endif
+          unsigned int atomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.atno = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.atno = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.crd = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.crd = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.val = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.val = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.pilp = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.pilp = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.mltb = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.mltb = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.arom = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.arom = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.linh = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.linh = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffPropObj.sbmb = (boost::uint8_t)(boost::lexical_cast<unsigned int>(*token));
+          mmffPropObj.sbmb = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[atomType] = mmffPropObj;
-          #else
-          d_params.push_back(mmffPropObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(atomType), mmffPropObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
     const std::string defaultMMFFProp =
       "*\n"
@@ -502,38 +498,34 @@ namespace ForceFields {
     MMFFPBCICollection::MMFFPBCICollection(std::string mmffPBCI)
     {
       if (mmffPBCI == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        dp_params = mmffPBCITable;
+        d_numParams = mmffPBCITableSize;
+        return;
+        #else
         mmffPBCI = defaultMMFFPBCI;
+        #endif
       }
       std::istringstream inStream(mmffPBCI);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if(inLine[0] != '*') {
           MMFFPBCI mmffPBCIObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          // IMPORTANT: skip the first field
-          ++token;
-          unsigned int atomType = boost::lexical_cast<unsigned int>(*token);
-          #else
           // IMPORTANT: skip the first two fields
           ++token;
-          #endif
           ++token;
-          mmffPBCIObj.pbci = boost::lexical_cast<double>(*token);
+          mmffPBCIObj.pbci = RDKit::fieldToDouble(*token);
           ++token;
-          mmffPBCIObj.fcadj = boost::lexical_cast<double>(*token);
+          mmffPBCIObj.fcadj = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[atomType] = mmffPBCIObj;
-          #else
-          d_params.push_back(mmffPBCIObj);
-          #endif
+          d_ownedParams.push_back(mmffPBCIObj);
         }
         inLine = RDKit::getLine(inStream);
       }
+      dp_params = (d_ownedParams.empty() ? NULL : &d_ownedParams[0]);
+      d_numParams = d_ownedParams.size();
     }
     const std::string defaultMMFFPBCI =
       "*\n"
@@ -663,45 +655,34 @@ namespace ForceFields {
     MMFFChgCollection::MMFFChgCollection(std::string mmffChg)
     {
       if (mmffChg == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffChgTable, mmffChgTableSize);
+        return;
+        #else
         mmffChg = defaultMMFFChg;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFChg> > params;
       std::istringstream inStream(mmffChg);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFChg mmffChgObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int bondType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_bondType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int bondType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int iAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int iAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int jAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_jAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int jAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffChgObj.bci = boost::lexical_cast<double>(*token);
+          mmffChgObj.bci = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[bondType][iAtomType][jAtomType] = mmffChgObj;
-          #else
-          d_params.push_back(mmffChgObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(bondType, iAtomType, jAtomType), mmffChgObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
     const std::string defaultMMFFChg =
       "*\n"
@@ -1236,47 +1217,36 @@ namespace ForceFields {
     MMFFBondCollection::MMFFBondCollection(std::string mmffBond)
     {
       if (mmffBond == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffBondTable, mmffBondTableSize);
+        return;
+        #else
         mmffBond = defaultMMFFBond;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFBond> > params;
       std::istringstream inStream(mmffBond);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFBond mmffBondObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int bondType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_bondType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int bondType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int atomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int iAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int jAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_jAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int jAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffBondObj.kb = boost::lexical_cast<double>(*token);
+          mmffBondObj.kb = RDKit::fieldToDouble(*token);
           ++token;
-          mmffBondObj.r0 = boost::lexical_cast<double>(*token);
+          mmffBondObj.r0 = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[bondType][atomType][jAtomType] = mmffBondObj;
-          #else
-          d_params.push_back(mmffBondObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(bondType, iAtomType, jAtomType), mmffBondObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
     const std::string defaultMMFFBond =
@@ -1807,41 +1777,34 @@ namespace ForceFields {
     MMFFBndkCollection::MMFFBndkCollection(std::string mmffBndk)
     {
       if (mmffBndk == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffBndkTable, mmffBndkTableSize);
+        return;
+        #else
         mmffBndk = defaultMMFFBndk;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFBond> > params;
       std::istringstream inStream(mmffBndk);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFBond mmffBondObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int iAtomicNum = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomicNum.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int iAtomicNum = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int jAtomicNum = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_jAtomicNum.push_back((boost::uint8_t)boost::lexical_cast<unsigned int>(*token));
-          #endif
+          unsigned int jAtomicNum = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffBondObj.r0 = boost::lexical_cast<double>(*token);
+          mmffBondObj.r0 = RDKit::fieldToDouble(*token);
           ++token;
-          mmffBondObj.kb = boost::lexical_cast<double>(*token);
+          mmffBondObj.kb = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[iAtomicNum][jAtomicNum] = mmffBondObj;
-          #else
-          d_params.push_back(mmffBondObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(iAtomicNum, jAtomicNum), mmffBondObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
     const std::string defaultMMFFBndk =
@@ -1934,35 +1897,32 @@ namespace ForceFields {
     MMFFCovRadPauEleCollection::MMFFCovRadPauEleCollection(std::string mmffCovRadPauEle)
     {
       if (mmffCovRadPauEle == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffCovRadPauEleTable, mmffCovRadPauEleTableSize);
+        return;
+        #else
         mmffCovRadPauEle = defaultMMFFCovRadPauEle;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFCovRadPauEle> > params;
       std::istringstream inStream(mmffCovRadPauEle);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFCovRadPauEle mmffCovRadPauEleObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int atomicNum = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_atomicNum.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int atomicNum = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffCovRadPauEleObj.r0 = boost::lexical_cast<double>(*token);
+          mmffCovRadPauEleObj.r0 = RDKit::fieldToDouble(*token);
           ++token;
-          mmffCovRadPauEleObj.chi = boost::lexical_cast<double>(*token);
+          mmffCovRadPauEleObj.chi = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[atomicNum] = mmffCovRadPauEleObj;
-          #else
-          d_params.push_back(mmffCovRadPauEleObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(atomicNum), mmffCovRadPauEleObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
     const std::string defaultMMFFCovRadPauEle =
@@ -2006,58 +1966,42 @@ namespace ForceFields {
     MMFFAngleCollection::MMFFAngleCollection(std::string mmffAngle)
     {
       if (mmffAngle == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffAngleTable, mmffAngleTableSize);
+        return;
+        #else
         unsigned int i = 0;
         while (defaultMMFFAngleData[i] != "EOS") {
           mmffAngle += defaultMMFFAngleData[i];
           ++i;
         }
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFAngle> > params;
       std::istringstream inStream(mmffAngle);
-
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFAngle mmffAngleObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int angleType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_angleType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int angleType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int iAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int iAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int jAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_jAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int jAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int kAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_kAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int kAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffAngleObj.ka = boost::lexical_cast<double>(*token);
+          mmffAngleObj.ka = RDKit::fieldToDouble(*token);
           ++token;
-          mmffAngleObj.theta0 = boost::lexical_cast<double>(*token);
+          mmffAngleObj.theta0 = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[angleType][iAtomType][jAtomType][kAtomType] = mmffAngleObj;
-          #else
-          d_params.push_back(mmffAngleObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(angleType, iAtomType, jAtomType, kAtomType), mmffAngleObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
 
@@ -4439,53 +4383,38 @@ namespace ForceFields {
     MMFFStbnCollection::MMFFStbnCollection(std::string mmffStbn)
     {
       if (mmffStbn == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffStbnTable, mmffStbnTableSize);
+        return;
+        #else
         mmffStbn = defaultMMFFStbn;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFStbn> > params;
       std::istringstream inStream(mmffStbn);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFStbn mmffStbnObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int stretchBendType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_stretchBendType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int stretchBendType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int iAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int iAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int jAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_jAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int jAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int kAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_kAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int kAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffStbnObj.kbaIJK = boost::lexical_cast<double>(*token);
+          mmffStbnObj.kbaIJK = RDKit::fieldToDouble(*token);
           ++token;
-          mmffStbnObj.kbaKJI = boost::lexical_cast<double>(*token);
+          mmffStbnObj.kbaKJI = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[stretchBendType][iAtomType][jAtomType][kAtomType] = mmffStbnObj;
-          #else
-          d_params.push_back(mmffStbnObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(stretchBendType, iAtomType, jAtomType, kAtomType), mmffStbnObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
     const std::string defaultMMFFStbn =
@@ -4800,32 +4729,36 @@ namespace ForceFields {
     MMFFDfsbCollection::MMFFDfsbCollection(std::string mmffDfsb)
     {
       if (mmffDfsb == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(mmffDfsbTable, mmffDfsbTableSize);
+        return;
+        #else
         mmffDfsb = defaultMMFFDfsb;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFStbn> > params;
       std::istringstream inStream(mmffDfsb);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFStbn mmffStbnObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          unsigned int iAtomicNum = boost::lexical_cast<unsigned int>(*token);
+          unsigned int iAtomicNum = RDKit::fieldToUInt(*token);
           ++token;
-          unsigned int jAtomicNum = boost::lexical_cast<unsigned int>(*token);
+          unsigned int jAtomicNum = RDKit::fieldToUInt(*token);
           ++token;
-          unsigned int kAtomicNum = boost::lexical_cast<unsigned int>(*token);
+          unsigned int kAtomicNum = RDKit::fieldToUInt(*token);
           ++token;
-          mmffStbnObj.kbaIJK = boost::lexical_cast<double>(*token);
+          mmffStbnObj.kbaIJK = RDKit::fieldToDouble(*token);
           ++token;
-          mmffStbnObj.kbaKJI = boost::lexical_cast<double>(*token);
+          mmffStbnObj.kbaKJI = RDKit::fieldToDouble(*token);
           ++token;
-          d_params[iAtomicNum][jAtomicNum][kAtomicNum] = mmffStbnObj;
+          params.push_back(std::make_pair(packParamKey(iAtomicNum, jAtomicNum, kAtomicNum), mmffStbnObj));
         }
         inLine = RDKit::getLine(inStream);
       }
-    
+      d_params.build(params);
     }
     const std::string defaultMMFFDfsb =
       "*\n"
@@ -4889,51 +4822,41 @@ namespace ForceFields {
     MMFFOopCollection::MMFFOopCollection(const bool isMMFFs, std::string mmffOop)
     {
       if (mmffOop == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        if (isMMFFs) {
+          d_params.setStatic(mmffsOopTable, mmffsOopTableSize);
+        }
+        else {
+          d_params.setStatic(mmffOopTable, mmffOopTableSize);
+        }
+        return;
+        #else
         mmffOop = (isMMFFs ? defaultMMFFsOop : defaultMMFFOop);
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFOop> > params;
       std::istringstream inStream(mmffOop);
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFOop mmffOopObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int iAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int iAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int jAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_jAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int jAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int kAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_kAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int kAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int lAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_lAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int lAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffOopObj.koop = boost::lexical_cast<double>(*token);
+          mmffOopObj.koop = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[iAtomType][jAtomType][kAtomType][lAtomType] = mmffOopObj;
-          #else
-          d_params.push_back(mmffOopObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(iAtomType, jAtomType, kAtomType, lAtomType), mmffOopObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
     const std::string defaultMMFFOop =
@@ -5213,61 +5136,47 @@ namespace ForceFields {
     MMFFTorCollection::MMFFTorCollection(const bool isMMFFs, std::string mmffTor)
     {
       if (mmffTor == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        if (isMMFFs) {
+          d_params.setStatic(mmffsTorTable, mmffsTorTableSize);
+        }
+        else {
+          d_params.setStatic(mmffTorTable, mmffTorTableSize);
+        }
+        return;
+        #else
         mmffTor = (isMMFFs ? defaultMMFFsTor : defaultMMFFTor);
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFTor> > params;
       std::istringstream inStream(mmffTor);
-      std::string inLine=RDKit::getLine(inStream);
+      std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
           MMFFTor mmffTorObj;
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine, tabSep);
-          tokenizer::iterator token = tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
 
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int torType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_torType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int torType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int iAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_iAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int iAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int jAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_jAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int jAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int kAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_kAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int kAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          unsigned int lAtomType = boost::lexical_cast<unsigned int>(*token);
-          #else
-          d_lAtomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-          #endif
+          unsigned int lAtomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
           ++token;
-          mmffTorObj.V1 = boost::lexical_cast<double>(*token);
+          mmffTorObj.V1 = RDKit::fieldToDouble(*token);
           ++token;
-          mmffTorObj.V2 = boost::lexical_cast<double>(*token);
+          mmffTorObj.V2 = RDKit::fieldToDouble(*token);
           ++token;
-          mmffTorObj.V3 = boost::lexical_cast<double>(*token);
+          mmffTorObj.V3 = RDKit::fieldToDouble(*token);
           ++token;
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          d_params[torType][iAtomType][jAtomType][kAtomType][lAtomType] = mmffTorObj;
-          #else
-          d_params.push_back(mmffTorObj);
-          #endif
+          params.push_back(std::make_pair(packParamKey(torType, iAtomType, jAtomType, kAtomType, lAtomType), mmffTorObj));
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
     const std::string defaultMMFFTor =
@@ -7167,57 +7076,59 @@ namespace ForceFields {
     MMFFVdWCollection::MMFFVdWCollection(std::string mmffVdW)
     {
       if (mmffVdW == "") {
+        #ifndef RDK_GENERATING_FF_PARAM_TABLES
+        this->power = mmffVdWPower;
+        this->B = mmffVdWB;
+        this->Beta = mmffVdWBeta;
+        this->DARAD = mmffVdWDARAD;
+        this->DAEPS = mmffVdWDAEPS;
+        d_params.setStatic(mmffVdWTable, mmffVdWTableSize);
+        return;
+        #else
         mmffVdW = defaultMMFFVdW;
+        #endif
       }
+      std::vector<std::pair<boost::uint64_t, MMFFVdW> > params;
       std::istringstream inStream(mmffVdW);
       bool firstLine = true;
       std::string inLine = RDKit::getLine(inStream);
       while (!(inStream.eof())) {
         if (inLine[0] != '*') {
-          boost::char_separator<char> tabSep("\t");
-          tokenizer tokens(inLine,tabSep);
-          tokenizer::iterator token=tokens.begin();
+          RDKit::TabFieldIterator token(inLine);
           if (firstLine) {
             firstLine = false;
-            this->power = boost::lexical_cast<double>(*token);
+            this->power = RDKit::fieldToDouble(*token);
             ++token;
-            this->B = boost::lexical_cast<double>(*token);
+            this->B = RDKit::fieldToDouble(*token);
             ++token;
-            this->Beta = boost::lexical_cast<double>(*token);
+            this->Beta = RDKit::fieldToDouble(*token);
             ++token;
-            this->DARAD = boost::lexical_cast<double>(*token);
+            this->DARAD = RDKit::fieldToDouble(*token);
             ++token;
-            this->DAEPS = boost::lexical_cast<double>(*token);
+            this->DAEPS = RDKit::fieldToDouble(*token);
             ++token;
           }
           else {
             MMFFVdW mmffVdWObj;
-            #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-            unsigned int atomType = boost::lexical_cast<unsigned int>(*token);
-            #else
-            d_atomType.push_back((boost::uint8_t)(boost::lexical_cast<unsigned int>(*token)));
-            #endif
+            unsigned int atomType = (boost::uint8_t)(RDKit::fieldToUInt(*token));
             ++token;
-            mmffVdWObj.alpha_i = boost::lexical_cast<double>(*token);
+            mmffVdWObj.alpha_i = RDKit::fieldToDouble(*token);
             ++token;
-            mmffVdWObj.N_i = boost::lexical_cast<double>(*token);
+            mmffVdWObj.N_i = RDKit::fieldToDouble(*token);
             ++token;
-            mmffVdWObj.A_i = boost::lexical_cast<double>(*token);
+            mmffVdWObj.A_i = RDKit::fieldToDouble(*token);
             ++token;
-            mmffVdWObj.G_i = boost::lexical_cast<double>(*token);
+            mmffVdWObj.G_i = RDKit::fieldToDouble(*token);
             ++token;
-            mmffVdWObj.DA = (boost::lexical_cast<std::string>(*token)).at(0);
+            mmffVdWObj.DA = (*token)[0];
             ++token;
             mmffVdWObj.R_star = mmffVdWObj.A_i * pow(mmffVdWObj.alpha_i, this->power);
-            #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-            d_params[atomType] = mmffVdWObj;
-            #else
-            d_params.push_back(mmffVdWObj);
-            #endif
+            params.push_back(std::make_pair(packParamKey(atomType), mmffVdWObj));
           }
         }
         inLine = RDKit::getLine(inStream);
       }
+      d_params.build(params);
     }
 
     const std::string defaultMMFFVdW =
@@ -20,18 +20,12 @@
 #include <map>
 #include <iostream>
 #include <boost/cstdint.hpp>
+#include <ForceField/ParamTable.h>
 
 #ifndef M_PI
 #define M_PI           3.14159265358979323846
 #endif
 
-// binary searches are slightly faster than std::map;
-// however when I moved to binary searches I had already
-// written the code for std::map, so the two methods
-// can be toggled defining RDKIT_MMFF_PARAMS_USE_STD_MAP
-
-//#define RDKIT_MMFF_PARAMS_USE_STD_MAP 1
-
 namespace ForceFields {
   namespace MMFF {
 
@@ -188,25 +182,17 @@ namespace ForceFields {
 	\return a pointer to the MMFFDef object, NULL on failure.
       */
       const MMFFDef *operator()(const unsigned int atomType) const {
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, MMFFDef>::const_iterator res;
-        res = d_params.find(atomType);
-
-        return ((res != d_params.end()) ? &((*res).second) : NULL);
-        #else
-        return ((atomType && (atomType <= d_params.size()))
-          ? &d_params[atomType - 1] : NULL);
-        #endif
+        return ((atomType && (atomType <= d_numParams))
+          ? &dp_params[atomType - 1] : NULL);
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFDefCollection(std::string mmffDef);
       static class MMFFDefCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, MMFFDef> d_params;  //!< the parameter map
-      #else
-      std::vector<MMFFDef> d_params;  //!< the parameter vector
-      #endif
+      const MMFFDef *dp_params;  //!< the parameter array
+      unsigned int d_numParams;
+      std::vector<MMFFDef> d_ownedParams;  //!< storage for user-supplied parameters
     };
 
     class MMFFPropCollection {
@@ -234,30 +220,14 @@ namespace ForceFields {
 	\return a pointer to the MMFFProp object, NULL on failure.
       */
       const MMFFProp *operator()(const unsigned int atomType) const {
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, MMFFProp>::const_iterator res;
-        res = d_params.find(atomType);
-
-        return ((res != d_params.end()) ? &((*res).second) : NULL);
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds =
-          std::equal_range(d_iAtomType.begin(), d_iAtomType.end(), atomType);
-
-        return ((bounds.first != bounds.second)
-          ? &d_params[bounds.first - d_iAtomType.begin()] : NULL);
-        #endif
+        return d_params.find(packParamKey(atomType));
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFPropCollection(std::string mmffProp);
       static class MMFFPropCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, MMFFProp> d_params;  //!< the parameter map
-      #else
-      std::vector<MMFFProp> d_params;
-      std::vector<boost::uint8_t> d_iAtomType;  //!< the parameter vector
-      #endif
+      ParamTable<MMFFProp> d_params;  //!< the parameter table
     };
 
     class MMFFPBCICollection {
@@ -285,25 +255,17 @@ namespace ForceFields {
 	\return a pointer to the MMFFPBCI object, NULL on failure.
       */
       const MMFFPBCI *operator()(const unsigned int atomType) const {
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, MMFFPBCI>::const_iterator res;
-        res = d_params.find(atomType);
-
-        return ((res != d_params.end()) ? &((*res).second) : NULL);
-        #else
-        return ((atomType && (atomType <= d_params.size()))
-          ? &d_params[atomType - 1] : NULL);
-        #endif
+        return ((atomType && (atomType <= d_numParams))
+          ? &dp_params[atomType - 1] : NULL);
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFPBCICollection(std::string mmffPBCI);
       static class MMFFPBCICollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, MMFFPBCI> d_params;  //!< the parameter map
-      #else
-      std::vector<MMFFPBCI> d_params;  //!< the parameter vector
-      #endif
+      const MMFFPBCI *dp_params;  //!< the parameter array
+      unsigned int d_numParams;
+      std::vector<MMFFPBCI> d_ownedParams;  //!< storage for user-supplied parameters
     };
 
     class MMFFChgCollection {
@@ -342,51 +304,17 @@ namespace ForceFields {
           canJAtomType = iAtomType;
           sign = 1;
         }
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, std::map<const unsigned int, MMFFChg> >::const_iterator res1;
-        std::map<const unsigned int, MMFFChg>::const_iterator res2;
-        res1 = d_params[bondType].find(canIAtomType);
-        if (res1 != d_params[bondType].end()) {
-          res2 = ((*res1).second).find(canJAtomType);
-          if (res2 != ((*res1).second).end()) {
-            mmffChgParams = &((*res2).second);
-          }
-        }
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds;
-        
-        bounds = std::equal_range(d_iAtomType.begin(), d_iAtomType.end(), canIAtomType);
-        if (bounds.first != bounds.second) {
-          bounds = std::equal_range(d_jAtomType.begin() + (bounds.first - d_iAtomType.begin()),
-            d_jAtomType.begin() + (bounds.second - d_iAtomType.begin()), canJAtomType);
-          if (bounds.first != bounds.second) {
-            bounds = std::equal_range
-              (d_bondType.begin() + (bounds.first - d_jAtomType.begin()),
-              d_bondType.begin() + (bounds.second - d_jAtomType.begin()), bondType);
-            if (bounds.first != bounds.second) {
-              mmffChgParams = &d_params[bounds.first - d_bondType.begin()];
-            }
-          }
-        }
-        #endif
+        mmffChgParams = d_params.find
+          (packParamKey(bondType, canIAtomType, canJAtomType));
 
         return std::make_pair(sign, mmffChgParams);
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFChgCollection(std::string mmffChg);
       static class MMFFChgCollection *ds_instance;    //!< the singleton
-      //!< the parameter 3D-map
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, std::map<const unsigned int,
-        std::map<const unsigned int, MMFFChg> > > d_params;  //!< the parameter 3D-map
-      #else
-      std::vector<MMFFChg> d_params;  //! the parameter vector
-      std::vector<boost::uint8_t> d_iAtomType;  //! atom type vector for atom i
-      std::vector<boost::uint8_t> d_jAtomType;  //! atom type vector for atom j
-      std::vector<boost::uint8_t> d_bondType;  //! bond type vector for bond i-j
-      #endif
+      ParamTable<MMFFChg> d_params;  //!< the parameter table
     };
 
     class MMFFBondCollection {
@@ -423,55 +351,17 @@ namespace ForceFields {
           canAtomType = nbrAtomType;
           canNbrAtomType = atomType;
         }
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, std::map<const unsigned int,
-            std::map<const unsigned int, MMFFBond> > >::const_iterator res1;
-        std::map<const unsigned int,
-            std::map<const unsigned int, MMFFBond> >::const_iterator res2;
-        std::map<const unsigned int, MMFFBond>::const_iterator res3;
-        res1 = d_params.find(bondType);
-        if (res1 != d_params.end()) {
-          res2 = ((*res1).second).find(canAtomType);
-          if (res2 != ((*res1).second).end()) {
-            res3 = ((*res2).second).find(canNbrAtomType);
-            if (res3 != ((*res2).second).end()) {
-              mmffBondParams = &((*res3).second);
-            }
-          }
-        }
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds;
-        bounds = std::equal_range(d_iAtomType.begin(), d_iAtomType.end(), canAtomType);
-        if (bounds.first != bounds.second) {
-          bounds = std::equal_range(d_jAtomType.begin() + (bounds.first - d_iAtomType.begin()),
-            d_jAtomType.begin() + (bounds.second - d_iAtomType.begin()), canNbrAtomType);
-          if (bounds.first != bounds.second) {
-              bounds = std::equal_range
-                (d_bondType.begin() + (bounds.first - d_jAtomType.begin()),
-                d_bondType.begin() + (bounds.second - d_jAtomType.begin()), bondType);
-            if (bounds.first != bounds.second) {
-              mmffBondParams = &d_params[bounds.first - d_bondType.begin()];
-            }
-          }
-        }
-        #endif
+        mmffBondParams = d_params.find
+          (packParamKey(bondType, canAtomType, canNbrAtomType));
 
         return mmffBondParams;
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFBondCollection(std::string mmffBond);
       static class MMFFBondCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, std::map<const unsigned int,
-        std::map<const unsigned int, MMFFBond> > > d_params;  //!< the parameter 3D-map
-      #else
-      std::vector<MMFFBond> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_iAtomType;  //! atom type vector for atom i
-      std::vector<boost::uint8_t> d_jAtomType;  //! atom type vector for atom j
-      std::vector<boost::uint8_t> d_bondType;  //! bond type vector for bond i-j
-      #endif
+      ParamTable<MMFFBond> d_params;  //!< the parameter table
     };
 
     class MMFFBndkCollection {
@@ -507,46 +397,16 @@ namespace ForceFields {
           canAtomicNum = nbrAtomicNum;
           canNbrAtomicNum = atomicNum;
         }
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int,
-          std::map<const unsigned int, MMFFBond> >::const_iterator res1;
-        std::map<const unsigned int, MMFFBond>::const_iterator res2;
-        res1 = d_params.find(canAtomicNum);
-        if (res1 != d_params.end()) {
-          res2 = ((*res1).second).find(canNbrAtomicNum);
-          if (res2 != ((*res1).second).end()) {
-            mmffBndkParams = &((*res2).second);
-          }
-        }
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds;
-        bounds = std::equal_range
-          (d_iAtomicNum.begin(), d_iAtomicNum.end(), canAtomicNum);
-        if (bounds.first != bounds.second) {
-          bounds = std::equal_range
-            (d_jAtomicNum.begin() + (bounds.first - d_iAtomicNum.begin()),
-            d_jAtomicNum.begin() + (bounds.second - d_iAtomicNum.begin()),
-            canNbrAtomicNum);
-          if (bounds.first != bounds.second) {
-            mmffBndkParams = &d_params[bounds.first - d_jAtomicNum.begin()];
-          }
-        }
-        #endif
+        mmffBndkParams = d_params.find(packParamKey(canAtomicNum, canNbrAtomicNum));
 
         return mmffBndkParams;
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFBndkCollection(std::string mmffBndk);
       static class MMFFBndkCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, std::map<const unsigned int, MMFFBond> > d_params;  //!< the parameter 2D-map
-      #else
-      std::vector<MMFFBond> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_iAtomicNum;  //! atomic number vector for atom i
-      std::vector<boost::uint8_t> d_jAtomicNum;  //! atomic number vector for atom j
-      #endif
+      ParamTable<MMFFBond> d_params;  //!< the parameter table
     };
 
     class MMFFCovRadPauEleCollection {
@@ -574,30 +434,14 @@ namespace ForceFields {
 	\return a pointer to the MMFFCovRadPauEle object, NULL on failure.
       */
       const MMFFCovRadPauEle *operator()(const unsigned int atomicNum) const {
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, MMFFCovRadPauEle>::const_iterator res;
-        res = d_params.find(atomicNum);
-
-        return ((res != d_params.end()) ? &((*res).second) : NULL);
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds =
-          std::equal_range(d_atomicNum.begin(), d_atomicNum.end(), atomicNum);
-
-        return ((bounds.first != bounds.second)
-          ? &d_params[bounds.first - d_atomicNum.begin()] : NULL);
-        #endif
+        return d_params.find(packParamKey(atomicNum));
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFCovRadPauEleCollection(std::string mmffCovRadPauEle);
       static class MMFFCovRadPauEleCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, MMFFCovRadPauEle> d_params;  //!< the parameter map
-      #else
-      std::vector<MMFFCovRadPauEle> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_atomicNum;  //!< the atomic number vector
-      #endif
+      ParamTable<MMFFCovRadPauEle> d_params;  //!< the parameter table
     };
 
     class MMFFAngleCollection {
@@ -636,13 +480,6 @@ namespace ForceFields {
         // in the level combinations 1-1-1,2-2-2,3-2-3,4-2-4, and
         // 5-2-5 is used. (MMFF.I, note 68, page 519)
         // We skip 1-1-1 since Level 2 === Level 1
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, std::map<const unsigned int, std::map<const unsigned int,
-            std::map<const unsigned int, MMFFAngle> > > >::const_iterator res1;
-        std::map<const unsigned int, std::map<const unsigned int, std::map<const unsigned int,
-            MMFFAngle> > >::const_iterator res2;
-        std::map<const unsigned int, std::map<const unsigned int, MMFFAngle> >::const_iterator res3;
-        std::map<const unsigned int, MMFFAngle>::const_iterator res4;
         while ((iter < 4) && (!mmffAngleParams)) {
           unsigned int canIAtomType = (*mmffDef)(iAtomType)->eqLevel[iter];
           unsigned int canKAtomType = (*mmffDef)(kAtomType)->eqLevel[iter];
@@ -651,75 +488,19 @@ namespace ForceFields {
             canKAtomType = canIAtomType;
             canIAtomType = temp;
           }
-          res1 = d_params.find(angleType);
-          if (res1 != d_params.end()) {
-            res2 = ((*res1).second).find(canIAtomType);
-            if (res2 != ((*res1).second).end()) {
-              res3 = ((*res2).second).find(jAtomType);
-              if (res3 != ((*res2).second).end()) {
-                res4 = ((*res3).second).find(canKAtomType);
-                if (res4 != ((*res3).second).end()) {
-                  mmffAngleParams = &((*res4).second);
-                }
-              }
-            }
-          }
+          mmffAngleParams = d_params.find
+            (packParamKey(angleType, canIAtomType, jAtomType, canKAtomType));
           ++iter;
         }
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-            std::vector<boost::uint8_t>::const_iterator> jBounds =
-          std::equal_range(d_jAtomType.begin(), d_jAtomType.end(), jAtomType);
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds;
-        if (jBounds.first != jBounds.second) {
-          while ((iter < 4) && (!mmffAngleParams)) {
-            unsigned int canIAtomType = (*mmffDef)(iAtomType)->eqLevel[iter];
-            unsigned int canKAtomType = (*mmffDef)(kAtomType)->eqLevel[iter];
-            if (canIAtomType > canKAtomType) {
-              unsigned int temp = canKAtomType;
-              canKAtomType = canIAtomType;
-              canIAtomType = temp;
-            }
-            bounds = std::equal_range
-              (d_iAtomType.begin() + (jBounds.first - d_jAtomType.begin()),
-              d_iAtomType.begin() + (jBounds.second - d_jAtomType.begin()),
-              canIAtomType);
-            if (bounds.first != bounds.second) {
-              bounds = std::equal_range
-                (d_kAtomType.begin() + (bounds.first - d_iAtomType.begin()),
-                d_kAtomType.begin() + (bounds.second - d_iAtomType.begin()),
-                canKAtomType);
-              if (bounds.first != bounds.second) {
-                bounds = std::equal_range
-                  (d_angleType.begin() + (bounds.first - d_kAtomType.begin()),
-                  d_angleType.begin() + (bounds.second - d_kAtomType.begin()), angleType);
-                if (bounds.first != bounds.second) {
-                  mmffAngleParams = &d_params[bounds.first - d_angleType.begin()];
-                }
-              }
-            }
-            ++iter;
-          }
-        }
-        #endif
 
         return mmffAngleParams;
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFAngleCollection(std::string mmffAngle);
       static class MMFFAngleCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, std::map<const unsigned int,
-        std::map<const unsigned int, std::map<const unsigned int, MMFFAngle> > > > d_params;  //!< the parameter 4D-map
-      #else
-      std::vector<MMFFAngle> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_iAtomType;  //! atom type vector for atom i
-      std::vector<boost::uint8_t> d_jAtomType;  //! atom type vector for atom j
-      std::vector<boost::uint8_t> d_kAtomType;  //! atom type vector for atom k
-      std::vector<boost::uint8_t> d_angleType;  //! angle type vector for angle i-j-k
-      #endif
+      ParamTable<MMFFAngle> d_params;  //!< the parameter table
     };
 
     class MMFFStbnCollection {
@@ -764,71 +545,17 @@ namespace ForceFields {
         else if (iAtomType == kAtomType) {
           swap = (bondType1 < bondType2);
         }
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, std::map<const unsigned int, std::map<const unsigned int,
-            std::map<const unsigned int, MMFFStbn> > > >::const_iterator res1;
-        std::map<const unsigned int, std::map<const unsigned int, std::map<const unsigned int,
-            MMFFStbn> > >::const_iterator res2;
-        std::map<const unsigned int, std::map<const unsigned int, MMFFStbn> >::const_iterator res3;
-        std::map<const unsigned int, MMFFStbn>::const_iterator res4;
-        res1 = d_params.find(canStretchBendType);
-        if (res1 != d_params.end()) {
-          res2 = ((*res1).second).find(canIAtomType);
-          if (res2 != ((*res1).second).end()) {
-            res3 = ((*res2).second).find(jAtomType);
-            if (res3 != ((*res2).second).end()) {
-              res4 = ((*res3).second).find(canKAtomType);
-              if (res4 != ((*res3).second).end()) {
-                mmffStbnParams = &((*res4).second);
-              }
-            }
-          }
-        }
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-            std::vector<boost::uint8_t>::const_iterator> jBounds =
-          std::equal_range(d_jAtomType.begin(), d_jAtomType.end(), jAtomType);
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds;
-        if (jBounds.first != jBounds.second) {
-          bounds = std::equal_range
-            (d_iAtomType.begin() + (jBounds.first - d_jAtomType.begin()),
-            d_iAtomType.begin() + (jBounds.second - d_jAtomType.begin()),
-            canIAtomType);
-          if (bounds.first != bounds.second) {
-            bounds = std::equal_range
-              (d_kAtomType.begin() + (bounds.first - d_iAtomType.begin()),
-              d_kAtomType.begin() + (bounds.second - d_iAtomType.begin()),
-              canKAtomType);
-            if (bounds.first != bounds.second) {
-              bounds = std::equal_range
-                (d_stretchBendType.begin() + (bounds.first - d_kAtomType.begin()),
-                d_stretchBendType.begin() + (bounds.second - d_kAtomType.begin()),
-                canStretchBendType);
-              if (bounds.first != bounds.second) {
-                mmffStbnParams = &d_params[bounds.first - d_stretchBendType.begin()];
-              }
-            }
-          }
-        }
-        #endif
+        mmffStbnParams = d_params.find(packParamKey
+          (canStretchBendType, canIAtomType, jAtomType, canKAtomType));
         
         return std::make_pair(swap, mmffStbnParams);
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFStbnCollection(std::string mmffStbn);
       static class MMFFStbnCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, std::map<const unsigned int,
-        std::map<const unsigned int, std::map<const unsigned int, MMFFStbn> > > > d_params;  //!< the parameter 4D-map
-      #else
-      std::vector<MMFFStbn> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_iAtomType;  //! atom type vector for atom i
-      std::vector<boost::uint8_t> d_jAtomType;  //! atom type vector for atom j
-      std::vector<boost::uint8_t> d_kAtomType;  //! atom type vector for atom k
-      std::vector<boost::uint8_t> d_stretchBendType;  //! stretch-bend type vector for angle i-j-k
-      #endif
+      ParamTable<MMFFStbn> d_params;  //!< the parameter table
     };
 
     class MMFFDfsbCollection {
@@ -858,10 +585,6 @@ namespace ForceFields {
       const std::pair<bool, const MMFFStbn *> getMMFFDfsbParams(const unsigned int periodicTableRow1,
         const unsigned int periodicTableRow2, const unsigned int periodicTableRow3) {
 
-        std::map<const unsigned int, std::map<const unsigned int, std::map<const unsigned int,
-            MMFFStbn> > >::const_iterator res1;
-        std::map<const unsigned int, std::map<const unsigned int, MMFFStbn> >::const_iterator res2;
-        std::map<const unsigned int, MMFFStbn>::const_iterator res3;
         const MMFFStbn *mmffDfsbParams = NULL;
         bool swap = false;
         unsigned int canPeriodicTableRow1 = periodicTableRow1;
@@ -871,25 +594,17 @@ namespace ForceFields {
           canPeriodicTableRow3 = periodicTableRow1;
           swap = true;
         }
-        res1 = d_params.find(canPeriodicTableRow1);
-        if (res1 != d_params.end()) {
-          res2 = ((*res1).second).find(periodicTableRow2);
-          if (res2 != ((*res1).second).end()) {
-            res3 = ((*res2).second).find(canPeriodicTableRow3);
-            if (res3 != ((*res2).second).end()) {
-              mmffDfsbParams = &((*res3).second);
-            }
-          }
-        }
+        mmffDfsbParams = d_params.find(packParamKey
+          (canPeriodicTableRow1, periodicTableRow2, canPeriodicTableRow3));
         
         return std::make_pair(swap, mmffDfsbParams);
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFDfsbCollection(std::string mmffDfsb);
       static class MMFFDfsbCollection *ds_instance;    //!< the singleton
-      std::map<const unsigned int, std::map<const unsigned int,
-        std::map<const unsigned int, MMFFStbn> > > d_params;  //!< the parameter 3D-map
+      ParamTable<MMFFStbn> d_params;  //!< the parameter table
     };
 
     class MMFFOopCollection {
@@ -923,91 +638,29 @@ namespace ForceFields {
         MMFFDefCollection *mmffDef = MMFFDefCollection::getMMFFDef();
         const MMFFOop *mmffOopParams = NULL;
         unsigned int iter = 0;
-        std::vector<unsigned int> canIKLAtomType(3);
+        unsigned int canIKLAtomType[3];
         // For out-of-plane bending ijk; I , where j is the central
         // atom [cf. eq. (511, the five-stage protocol 1-1-1; 1, 2-2-2; 2,
         // 3-2-3;3, 4-2-4;4, 5-2-5;5 is used. The final stage provides
         // wild-card defaults for all except the central atom.
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, std::map<const unsigned int, std::map<const unsigned int,
-            std::map<const unsigned int, MMFFOop> > > >::const_iterator res1;
-        std::map<const unsigned int, std::map<const unsigned int, std::map<const unsigned int,
-            MMFFOop> > >::const_iterator res2;
-        std::map<const unsigned int, std::map<const unsigned int, MMFFOop> >::const_iterator res3;
-        std::map<const unsigned int, MMFFOop>::const_iterator res4;
         while ((iter < 4) && (!mmffOopParams)) {
           canIKLAtomType[0] = (*mmffDef)(iAtomType)->eqLevel[iter];
-          unsigned int canJAtomType = jAtomType;
           canIKLAtomType[1] = (*mmffDef)(kAtomType)->eqLevel[iter];
           canIKLAtomType[2] = (*mmffDef)(lAtomType)->eqLevel[iter];
-          std::sort(canIKLAtomType.begin(), canIKLAtomType.end());
-          res1 = d_params.find(canIKLAtomType[0]);
-          if (res1 != d_params.end()) {
-            res2 = ((*res1).second).find(canJAtomType);
-            if (res2 != ((*res1).second).end()) {
-              res3 = ((*res2).second).find(canIKLAtomType[1]);
-              if (res3 != ((*res2).second).end()) {
-                res4 = ((*res3).second).find(canIKLAtomType[2]);
-                if (res4 != ((*res3).second).end()) {
-                  mmffOopParams = &((*res4).second);
-                }
-              }
-            }
-          }
+          std::sort(canIKLAtomType, canIKLAtomType + 3);
+          mmffOopParams = d_params.find(packParamKey
+            (canIKLAtomType[0], jAtomType, canIKLAtomType[1], canIKLAtomType[2]));
           ++iter;
         }
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> jBounds =
-          std::equal_range(d_jAtomType.begin(), d_jAtomType.end(), jAtomType);
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds;
-        if (jBounds.first != jBounds.second) {
-          while ((iter < 4) && (!mmffOopParams)) {
-            canIKLAtomType[0] = (*mmffDef)(iAtomType)->eqLevel[iter];
-            canIKLAtomType[1] = (*mmffDef)(kAtomType)->eqLevel[iter];
-            canIKLAtomType[2] = (*mmffDef)(lAtomType)->eqLevel[iter];
-            std::sort(canIKLAtomType.begin(), canIKLAtomType.end());
-            bounds = std::equal_range
-              (d_iAtomType.begin() + (jBounds.first - d_jAtomType.begin()),
-              d_iAtomType.begin() + (jBounds.second - d_jAtomType.begin()),
-              canIKLAtomType[0]);
-            if (bounds.first != bounds.second) {
-              bounds = std::equal_range
-                (d_kAtomType.begin() + (bounds.first - d_iAtomType.begin()),
-                d_kAtomType.begin() + (bounds.second - d_iAtomType.begin()),
-                canIKLAtomType[1]);
-              if (bounds.first != bounds.second) {
-                bounds = std::equal_range
-                  (d_lAtomType.begin() + (bounds.first - d_kAtomType.begin()),
-                  d_lAtomType.begin() + (bounds.second - d_kAtomType.begin()),
-                  canIKLAtomType[2]);
-                if (bounds.first != bounds.second) {
-                  mmffOopParams = &d_params[bounds.first - d_lAtomType.begin()];
-                }
-              }
-            }
-            ++iter;
-          }
-        }
-        #endif
         
         return mmffOopParams;
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFOopCollection(const bool isMMFFs, std::string mmffOop);
       static class MMFFOopCollection *ds_instance[2];    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, std::map<const unsigned int,
-        std::map<const unsigned int, std::map<const unsigned int, MMFFOop> > > > d_params;  //!< the parameter 4D-map
-      #else
-      std::vector<MMFFOop> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_iAtomType;  //! atom type vector for atom i
-      std::vector<boost::uint8_t> d_jAtomType;  //! atom type vector for atom j
-      std::vector<boost::uint8_t> d_kAtomType;  //! atom type vector for atom k
-      std::vector<boost::uint8_t> d_lAtomType;  //! atom type vector for atom l
-      #endif
+      ParamTable<MMFFOop> d_params;  //!< the parameter table
     };
 
     class MMFFTorCollection {
@@ -1050,26 +703,6 @@ namespace ForceFields {
         // process based on level combinations 1-1-1-1, 2-2-2-2,
         // 3-2-2-5, 5-2-2-3, and 5-2-2-5 is used, where stages 3
         // and 4 correspond to "half-default" or "half-wild-card" entries.
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int,
-          std::map<const unsigned int, std::map<const unsigned int,
-          std::map<const unsigned int, std::map<const unsigned int,
-          MMFFTor> > > > >::const_iterator res1;
-        std::map<const unsigned int,
-          std::map<const unsigned int, std::map<const unsigned int,
-          std::map<const unsigned int, MMFFTor> > > >::const_iterator res2;
-        std::map<const unsigned int,
-          std::map<const unsigned int, std::map<const unsigned int,
-          MMFFTor> > >::const_iterator res3;
-        std::map<const unsigned int,
-          std::map<const unsigned int, MMFFTor> >::const_iterator res4;
-        std::map<const unsigned int, MMFFTor>::const_iterator res5;
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-            std::vector<boost::uint8_t>::const_iterator> jBounds;
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds;
-        #endif
         
         while (((iter < maxIter) && ((!mmffTorParams) || (maxIter == 4)))
           || ((iter == 4) && (torType.first == 5) && torType.second)) {
@@ -1111,81 +744,25 @@ namespace ForceFields {
             canLAtomType = canIAtomType;
             canIAtomType = temp;
           }
-          #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-          res1 = d_params.find(canTorType);
-          if (res1 != d_params.end()) {
-            res2 = ((*res1).second).find(canIAtomType);
-            if (res2 != ((*res1).second).end()) {
-              res3 = ((*res2).second).find(canJAtomType);
-              if (res3 != ((*res2).second).end()) {
-                res4 = ((*res3).second).find(canKAtomType);
-                if (res4 != ((*res3).second).end()) {
-                  res5 = ((*res4).second).find(canLAtomType);
-                  if (res5 != ((*res4).second).end()) {
-                    mmffTorParams = &((*res5).second);
-                    if (maxIter == 4) {
-                      break;
-                    }
-                  }
-                }
-              }
-            }
-          }
-          #else
-          jBounds = std::equal_range(d_jAtomType.begin(), d_jAtomType.end(), canJAtomType);
-          if (jBounds.first != jBounds.second) {
-            bounds = std::equal_range
-              (d_kAtomType.begin() + (jBounds.first - d_jAtomType.begin()),
-              d_kAtomType.begin() + (jBounds.second - d_jAtomType.begin()),
-              canKAtomType);
-            if (bounds.first != bounds.second) {
-              bounds = std::equal_range
-                (d_iAtomType.begin() + (bounds.first - d_kAtomType.begin()),
-                d_iAtomType.begin() + (bounds.second - d_kAtomType.begin()),
-                canIAtomType);
-              if (bounds.first != bounds.second) {
-                bounds = std::equal_range
-                  (d_lAtomType.begin() + (bounds.first - d_iAtomType.begin()),
-                  d_lAtomType.begin() + (bounds.second - d_iAtomType.begin()),
-                  canLAtomType);
-                if (bounds.first != bounds.second) {
-                  bounds = std::equal_range
-                    (d_torType.begin() + (bounds.first - d_lAtomType.begin()),
-                    d_torType.begin() + (bounds.second - d_lAtomType.begin()),
-                    canTorType);
-                  if (bounds.first != bounds.second) {
-                    mmffTorParams = &d_params[bounds.first - d_torType.begin()];
-                    if (maxIter == 4) {
-                      break;
-                    }
-                  }
-                }
-              }
+          const MMFFTor *params = d_params.find(packParamKey
+            (canTorType, canIAtomType, canJAtomType, canKAtomType, canLAtomType));
+          if (params) {
+            mmffTorParams = params;
+            if (maxIter == 4) {
+              break;
             }
           }
-          #endif
           ++iter;
         }
         
         return std::make_pair(canTorType, mmffTorParams);
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFTorCollection(const bool isMMFFs, std::string mmffTor);
       static class MMFFTorCollection *ds_instance[2];    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int,
-        std::map<const unsigned int, std::map<const unsigned int,
-        std::map<const unsigned int, std::map<const unsigned int,
-        MMFFTor> > > > > d_params;  //!< the parameter 5D-map
-      #else
-      std::vector<MMFFTor> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_iAtomType;  //! atom type vector for atom i
-      std::vector<boost::uint8_t> d_jAtomType;  //! atom type vector for atom j
-      std::vector<boost::uint8_t> d_kAtomType;  //! atom type vector for atom k
-      std::vector<boost::uint8_t> d_lAtomType;  //! atom type vector for atom l
-      std::vector<boost::uint8_t> d_torType;  //! torsion type vector for angle i-j-k-l
-      #endif
+      ParamTable<MMFFTor> d_params;  //!< the parameter table
     };
 
     class MMFFVdWCollection {
@@ -1218,30 +795,14 @@ namespace ForceFields {
 	\return a pointer to the MMFFVdW object, NULL on failure.
       */
       const MMFFVdW *operator()(const unsigned int atomType) const {
-        #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-        std::map<const unsigned int, MMFFVdW>::const_iterator res;
-        res = d_params.find(atomType);
-
-        return (res != d_params.end() ? &((*res).second) : NULL);
-        #else
-        std::pair<std::vector<boost::uint8_t>::const_iterator,
-          std::vector<boost::uint8_t>::const_iterator> bounds =
-          std::equal_range(d_atomType.begin(), d_atomType.end(), atomType);
-
-        return ((bounds.first != bounds.second)
-          ? &d_params[bounds.first - d_atomType.begin()] : NULL);
-        #endif
+        return d_params.find(packParamKey(atomType));
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       MMFFVdWCollection(std::string mmffVdW);
       static class MMFFVdWCollection *ds_instance;    //!< the singleton
-      #ifdef RDKIT_MMFF_PARAMS_USE_STD_MAP
-      std::map<const unsigned int, MMFFVdW> d_params;  //!< the parameter map
-      #else
-      std::vector<MMFFVdW> d_params;  //!< the parameter vector
-      std::vector<boost::uint8_t> d_atomType;  //! atom type vector
-      #endif
+      ParamTable<MMFFVdW> d_params;  //!< the parameter table
     };
   }
 }
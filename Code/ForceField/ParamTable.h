@@ -0,0 +1,121 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef __RD_FFPARAMTABLE_H__
+#define __RD_FFPARAMTABLE_H__
+
+#include <vector>
+#include <utility>
+#include <boost/cstdint.hpp>
+
+namespace ForceFields {
+  //! writes the built-in parameter tables, see genParamTables.cpp
+  class ParamTableWriter;
+
+  //! the key of the empty ParamTable slots
+  const boost::uint64_t emptyParamKey=~static_cast<boost::uint64_t>(0);
+
+  //! packs up to five 8 bit parameter keys (atom types, bond types...)
+  //! into a single ParamTable key
+  /*!
+    \return emptyParamKey (which is never found) if one of the
+      keys does not fit in 8 bits
+  */
+  inline boost::uint64_t packParamKey(unsigned int k0,unsigned int k1=0,
+                                      unsigned int k2=0,unsigned int k3=0,
+                                      unsigned int k4=0){
+    if((k0|k1|k2|k3|k4)>0xFF) return emptyParamKey;
+    return (static_cast<boost::uint64_t>(k0)<<32) | (static_cast<boost::uint64_t>(k1)<<24) |
+      (k2<<16) | (k3<<8) | k4;
+  }
+
+  //! an open-addressing hash table mapping 64 bit keys to parameter objects
+  /*!
+    The table either points to a static array of entries, generated at
+    build time from the default parameters (see genParamTables.cpp), or
+    to entries it owns, built from user-supplied parameter data.
+
+    Lookups are O(1): the key is hashed to a slot and the following slots
+    are probed until either the key or an empty slot is found.
+  */
+  template <class T>
+  class ParamTable {
+  public:
+    //! a slot of the table
+    struct Entry {
+      boost::uint64_t key;
+      T value;
+    };
+
+    ParamTable() : dp_entries(NULL), d_mask(0) {};
+
+    //! uses a static table, \c size must be a power of two
+    void setStatic(const Entry *entries,unsigned int size){
+      d_ownedEntries.clear();
+      dp_entries=entries;
+      d_mask=size-1;
+    }
+
+    //! builds the table from a list of (key,value) pairs
+    /*!
+      the first value is kept if a key appears more than once
+    */
+    void build(const std::vector< std::pair<boost::uint64_t,T> > &params){
+      unsigned int size=2;
+      while(size<2*params.size()) size*=2;
+      Entry empty;
+      empty.key=emptyParamKey;
+      empty.value=T();
+      d_ownedEntries.assign(size,empty);
+      d_mask=size-1;
+      for(unsigned int i=0;i<params.size();++i){
+        if(params[i].first==emptyParamKey) continue;
+        unsigned int slot=hashKey(params[i].first);
+        while(d_ownedEntries[slot].key!=emptyParamKey &&
+              d_ownedEntries[slot].key!=params[i].first){
+          slot=(slot+1)&d_mask;
+        }
+        if(d_ownedEntries[slot].key==emptyParamKey){
+          d_ownedEntries[slot].key=params[i].first;
+          d_ownedEntries[slot].value=params[i].second;
+        }
+      }
+      dp_entries=&d_ownedEntries[0];
+    }
+
+    //! \return a pointer to the value for \c key, NULL if there is none
+    const T *find(boost::uint64_t key) const {
+      if(!dp_entries || key==emptyParamKey) return NULL;
+      for(unsigned int slot=hashKey(key);;slot=(slot+1)&d_mask){
+        if(dp_entries[slot].key==key) return &dp_entries[slot].value;
+        if(dp_entries[slot].key==emptyParamKey) return NULL;
+      }
+    }
+
+    //! the number of slots in the table
+    unsigned int size() const { return dp_entries ? d_mask+1 : 0; };
+    //! \return slot \c i of the table
+    const Entry &operator[](unsigned int i) const { return dp_entries[i]; };
+
+  private:
+    // not copyable: dp_entries may point into d_ownedEntries
+    ParamTable(const ParamTable &);
+    ParamTable &operator=(const ParamTable &);
+
+    unsigned int hashKey(boost::uint64_t key) const {
+      return static_cast<unsigned int>((key*UINT64_C(0x9E3779B97F4A7C15))>>32)&d_mask;
+    }
+
+    const Entry *dp_entries;
+    unsigned int d_mask;
+    std::vector<Entry> d_ownedEntries;
+  };
+}
+
+#endif
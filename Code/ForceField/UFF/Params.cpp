@@ -16,16 +16,19 @@
 
 #include <iostream>
 #include <sstream>
+#include <algorithm>
+#include <RDGeneral/Invariant.h>
 #include <RDGeneral/StreamOps.h>
-#include <boost/lexical_cast.hpp>
-#include <boost/tokenizer.hpp>
+#include <RDGeneral/TabFieldIterator.h>
 #include <Geometry/point.h>
 
-typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
-
 
 namespace ForceFields {
   namespace UFF {
+#ifndef RDK_GENERATING_FF_PARAM_TABLES
+    // the default parameters, generated at build time by genParamTables
+#include "UFFParamTables.inc"
+#endif
     class ParamCollection * ParamCollection::ds_instance = 0;
 
     extern const std::string defaultParamData;
@@ -42,49 +45,58 @@ namespace ForceFields {
     }
 
     ParamCollection::ParamCollection(std::string paramData){
-      if(paramData=="") paramData=defaultParamData;
+      if(paramData==""){
+#ifndef RDK_GENERATING_FF_PARAM_TABLES
+        d_params.setStatic(uffParamTable,uffParamTableSize);
+        return;
+#else
+        paramData=defaultParamData;
+#endif
+      }
+      std::vector<std::pair<boost::uint64_t,AtomicParams> > params;
       std::istringstream inStream(paramData);
 
       std::string inLine=RDKit::getLine(inStream);
       while(!inStream.eof()){
 	if(inLine[0] != '#'){
 	  AtomicParams paramObj;
-	  boost::char_separator<char> tabSep("\t");
-	  tokenizer tokens(inLine,tabSep);
-	  tokenizer::iterator token=tokens.begin();
+	  RDKit::TabFieldIterator token(inLine);
 
-	  std::string label = *token;
+	  std::string label = RDKit::fieldToString(*token);
+	  PRECONDITION(label.size()<=8,"UFF atom labels have at most eight characters");
 	  ++token;
 	
-	  paramObj.r1=boost::lexical_cast<double>(*token);
+	  paramObj.r1=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.theta0=boost::lexical_cast<double>(*token);
+	  paramObj.theta0=RDKit::fieldToDouble(*token);
 	  ++token;
 	  paramObj.theta0 = paramObj.theta0 * M_PI/180.;
 	
-	  paramObj.x1=boost::lexical_cast<double>(*token);
+	  paramObj.x1=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.D1=boost::lexical_cast<double>(*token);
+	  paramObj.D1=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.zeta=boost::lexical_cast<double>(*token);
+	  paramObj.zeta=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.Z1=boost::lexical_cast<double>(*token);
+	  paramObj.Z1=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.V1=boost::lexical_cast<double>(*token);
+	  paramObj.V1=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.U1=boost::lexical_cast<double>(*token);
+	  paramObj.U1=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.GMP_Xi=boost::lexical_cast<double>(*token);
+	  paramObj.GMP_Xi=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.GMP_Hardness=boost::lexical_cast<double>(*token);
+	  paramObj.GMP_Hardness=RDKit::fieldToDouble(*token);
 	  ++token;
-	  paramObj.GMP_Radius=boost::lexical_cast<double>(*token);
+	  paramObj.GMP_Radius=RDKit::fieldToDouble(*token);
 	  ++token;
-	  d_params[label]=paramObj;
+	  params.push_back(std::make_pair(packLabelKey(label),paramObj));
 	}
 	inLine = RDKit::getLine(inStream);
       }
-    
+      // later definitions of a label replace earlier ones:
+      std::reverse(params.begin(),params.end());
+      d_params.build(params);
     }
     const std::string defaultParamData=
 "#Atom	r1	theta0	x1	D1	zeta	Z1	Vi	Uj	Xi	Hard	Radius\n"
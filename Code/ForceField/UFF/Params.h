@@ -12,7 +12,7 @@
 
 #include <string>
 #include <cmath>
-#include <map>
+#include <ForceField/ParamTable.h>
 
 #ifndef M_PI
 #define M_PI           3.14159265358979323846
@@ -49,6 +49,20 @@ namespace ForceFields {
       const double amideBondOrder=1.41; //!< special case bond order for amide C-N bonds.
     };
 
+    //! packs an atom label into a ParamTable key
+    /*!
+      \return emptyParamKey (which is never found) for labels longer
+        than eight characters
+    */
+    inline boost::uint64_t packLabelKey(const std::string &label){
+      if(label.size()>8) return emptyParamKey;
+      boost::uint64_t res=0;
+      for(unsigned int i=0;i<label.size();++i){
+        res=(res<<8) | static_cast<unsigned char>(label[i]);
+      }
+      return res;
+    }
+
     //! singleton class for retrieving UFF AtomParams
     /*!
       Use the singleton like this:
@@ -92,18 +106,14 @@ namespace ForceFields {
 	\return a pointer to the AtomicParams object, NULL on failure.
       */
       const AtomicParams *operator()(const std::string &symbol) const {
-	std::map<std::string,AtomicParams>::const_iterator res;
-	res=d_params.find(symbol);
-	if(res!=d_params.end()){
-	  return &((*res).second);
-	}
-	return 0;
+	return d_params.find(packLabelKey(symbol));
       }
     private:
+      friend class ForceFields::ParamTableWriter;
       //! to force this to be a singleton, the constructor must be private
       ParamCollection(std::string paramData);
       static class ParamCollection *ds_instance;    //!< the singleton
-      std::map<std::string,AtomicParams> d_params;  //!< the parameter map
+      ParamTable<AtomicParams> d_params;  //!< the parameter table
     };
 
   }
@@ -13,6 +13,7 @@
 #include <math.h>
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/utils.h>
+#include <boost/lexical_cast.hpp>
 #include <Geometry/point.h>
 
 #include <ForceField/ForceField.h>
@@ -1417,6 +1418,50 @@ void testUFFAllConstraints(){
 
   std::cerr << "  done" << std::endl;
 }
+void testUFFCustomParams(){
+  std::cerr << "-------------------------------------" << std::endl;
+  std::cerr << " Test UFF custom parameters" << std::endl;
+
+  // repeated tabs and DOS line endings are tolerated:
+  std::string paramData=
+    "#Atom\tr1\ttheta0\tx1\tD1\tzeta\tZ1\tVi\tUj\tXi\tHard\tRadius\n"
+    "C_3\t0.757\t109.47\t3.851\t0.105\t12.73\t1.912\t2.119\t2\t5.343\t5.063\t0.759\r\n"
+    "N_3\t\t0.7\t106.7\t3.66\t0.069\t13.407\t2.544\t0.45\t2\t6.899\t5.88\t0.715\n";
+  ForceFields::UFF::ParamCollection *params=
+    ForceFields::UFF::ParamCollection::getParams(paramData);
+  TEST_ASSERT(params);
+
+  const ForceFields::UFF::AtomicParams *ptr;
+  ptr=(*params)("C_3");
+  TEST_ASSERT(ptr);
+  TEST_ASSERT(RDKit::feq(ptr->r1,0.757));
+  TEST_ASSERT(RDKit::feq(ptr->theta0,109.47*M_PI/180.));
+  TEST_ASSERT(RDKit::feq(ptr->GMP_Radius,0.759));
+  ptr=(*params)("N_3");
+  TEST_ASSERT(ptr);
+  TEST_ASSERT(RDKit::feq(ptr->r1,0.7));
+  TEST_ASSERT(RDKit::feq(ptr->GMP_Radius,0.715));
+  ptr=(*params)("O_3");
+  TEST_ASSERT(!ptr);
+
+  // malformed fields are rejected, as they were by boost::lexical_cast:
+  const char *badFields[]={"0.757x"," 0.757","0x1p1","inf","1.2.3","1e",0};
+  for(unsigned int i=0;badFields[i];++i){
+    std::string badData="C_3\t0.757\t109.47\t3.851\t0.105\t12.73\t1.912\t2.119\t2\t5.343\t5.063\t";
+    badData+=badFields[i];
+    badData+="\n";
+    bool ok=false;
+    try{
+      ForceFields::UFF::ParamCollection::getParams(badData);
+    } catch (boost::bad_lexical_cast &){
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  // after a failed parse the default parameters are used again:
+  ptr=(*ForceFields::UFF::ParamCollection::getParams())("O_3");
+  TEST_ASSERT(ptr);
+}
 
 int main(){
 #if 1
@@ -1435,4 +1480,6 @@ int main(){
 #endif
   testUFFDistanceConstraints();
   testUFFAllConstraints();
+  // this replaces the default parameters, so it needs to be last:
+  testUFFCustomParams();
 }
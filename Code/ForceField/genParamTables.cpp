@@ -0,0 +1,165 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+//  Writes the default MMFF and UFF parameters as static ParamTables.
+//  This is run at build time. The parameter collections are compiled
+//  in here with RDK_GENERATING_FF_PARAM_TABLES defined, so that they
+//  parse the default parameter text instead of using the generated
+//  tables.
+//
+//  Usage: genParamTables <MMFFParamTables.inc> <UFFParamTables.inc>
+//
+#define RDK_GENERATING_FF_PARAM_TABLES
+#include "MMFF/Params.cpp"
+#include "UFF/Params.cpp"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+
+namespace ForceFields {
+  class ParamTableWriter {
+  public:
+    explicit ParamTableWriter(std::ostream &out) : d_out(out) {
+      // enough digits for the doubles to be read back exactly:
+      d_out << std::setprecision(17);
+      d_out << "// generated by genParamTables from the default parameters, do not edit\n\n";
+    }
+
+    void writeMMFF() {
+      using namespace MMFF;
+      MMFFDefCollection *def = MMFFDefCollection::getMMFFDef();
+      writeArray("MMFFDef", "mmffDefTable", def->dp_params, def->d_numParams);
+      MMFFPBCICollection *pbci = MMFFPBCICollection::getMMFFPBCI();
+      writeArray("MMFFPBCI", "mmffPBCITable", pbci->dp_params, pbci->d_numParams);
+      writeTable("MMFFProp", "mmffPropTable", MMFFPropCollection::getMMFFProp()->d_params);
+      writeTable("MMFFChg", "mmffChgTable", MMFFChgCollection::getMMFFChg()->d_params);
+      writeTable("MMFFBond", "mmffBondTable", MMFFBondCollection::getMMFFBond()->d_params);
+      writeTable("MMFFBond", "mmffBndkTable", MMFFBndkCollection::getMMFFBndk()->d_params);
+      writeTable("MMFFCovRadPauEle", "mmffCovRadPauEleTable",
+                 MMFFCovRadPauEleCollection::getMMFFCovRadPauEle()->d_params);
+      writeTable("MMFFAngle", "mmffAngleTable", MMFFAngleCollection::getMMFFAngle()->d_params);
+      writeTable("MMFFStbn", "mmffStbnTable", MMFFStbnCollection::getMMFFStbn()->d_params);
+      writeTable("MMFFStbn", "mmffDfsbTable", MMFFDfsbCollection::getMMFFDfsb()->d_params);
+      writeTable("MMFFOop", "mmffOopTable", MMFFOopCollection::getMMFFOop(false)->d_params);
+      writeTable("MMFFOop", "mmffsOopTable", MMFFOopCollection::getMMFFOop(true)->d_params);
+      writeTable("MMFFTor", "mmffTorTable", MMFFTorCollection::getMMFFTor(false)->d_params);
+      writeTable("MMFFTor", "mmffsTorTable", MMFFTorCollection::getMMFFTor(true)->d_params);
+      MMFFVdWCollection *vdw = MMFFVdWCollection::getMMFFVdW();
+      d_out << "const double mmffVdWPower = " << vdw->power << ";\n";
+      d_out << "const double mmffVdWB = " << vdw->B << ";\n";
+      d_out << "const double mmffVdWBeta = " << vdw->Beta << ";\n";
+      d_out << "const double mmffVdWDARAD = " << vdw->DARAD << ";\n";
+      d_out << "const double mmffVdWDAEPS = " << vdw->DAEPS << ";\n";
+      writeTable("MMFFVdW", "mmffVdWTable", vdw->d_params);
+    }
+
+    void writeUFF() {
+      writeTable("AtomicParams", "uffParamTable", UFF::ParamCollection::getParams()->d_params);
+    }
+
+  private:
+    std::ostream &d_out;
+
+    template <class T>
+    void writeArray(const std::string &type, const std::string &name,
+                    const T *params, unsigned int numParams) {
+      d_out << "const unsigned int " << name << "Size = " << numParams << ";\n";
+      d_out << "const " << type << " " << name << "[] = {\n";
+      for (unsigned int i = 0; i < numParams; ++i) {
+        d_out << "  ";
+        writeValue(params[i]);
+        d_out << (i + 1 < numParams ? ",\n" : "\n");
+      }
+      d_out << "};\n\n";
+    }
+
+    template <class T>
+    void writeTable(const std::string &type, const std::string &name,
+                    const ParamTable<T> &table) {
+      d_out << "const unsigned int " << name << "Size = " << table.size() << ";\n";
+      d_out << "const ParamTable<" << type << ">::Entry " << name << "[] = {\n";
+      for (unsigned int i = 0; i < table.size(); ++i) {
+        d_out << "  { UINT64_C(0x" << std::hex << table[i].key << std::dec << "), ";
+        writeValue(table[i].value);
+        d_out << (i + 1 < table.size() ? " },\n" : " }\n");
+      }
+      d_out << "};\n\n";
+    }
+
+    void writeValue(const MMFF::MMFFDef &p) {
+      d_out << "{ { " << static_cast<unsigned int>(p.eqLevel[0]) << ", "
+        << static_cast<unsigned int>(p.eqLevel[1]) << ", "
+        << static_cast<unsigned int>(p.eqLevel[2]) << ", "
+        << static_cast<unsigned int>(p.eqLevel[3]) << " } }";
+    }
+    void writeValue(const MMFF::MMFFProp &p) {
+      d_out << "{ " << static_cast<unsigned int>(p.atno) << ", "
+        << static_cast<unsigned int>(p.crd) << ", "
+        << static_cast<unsigned int>(p.val) << ", "
+        << static_cast<unsigned int>(p.pilp) << ", "
+        << static_cast<unsigned int>(p.mltb) << ", "
+        << static_cast<unsigned int>(p.arom) << ", "
+        << static_cast<unsigned int>(p.linh) << ", "
+        << static_cast<unsigned int>(p.sbmb) << " }";
+    }
+    void writeValue(const MMFF::MMFFPBCI &p) {
+      d_out << "{ " << p.pbci << ", " << p.fcadj << " }";
+    }
+    void writeValue(const MMFF::MMFFChg &p) {
+      d_out << "{ " << p.bci << " }";
+    }
+    void writeValue(const MMFF::MMFFBond &p) {
+      d_out << "{ " << p.kb << ", " << p.r0 << " }";
+    }
+    void writeValue(const MMFF::MMFFCovRadPauEle &p) {
+      d_out << "{ " << p.r0 << ", " << p.chi << " }";
+    }
+    void writeValue(const MMFF::MMFFAngle &p) {
+      d_out << "{ " << p.ka << ", " << p.theta0 << " }";
+    }
+    void writeValue(const MMFF::MMFFStbn &p) {
+      d_out << "{ " << p.kbaIJK << ", " << p.kbaKJI << " }";
+    }
+    void writeValue(const MMFF::MMFFOop &p) {
+      d_out << "{ " << p.koop << " }";
+    }
+    void writeValue(const MMFF::MMFFTor &p) {
+      d_out << "{ " << p.V1 << ", " << p.V2 << ", " << p.V3 << " }";
+    }
+    void writeValue(const MMFF::MMFFVdW &p) {
+      d_out << "{ " << p.alpha_i << ", " << p.N_i << ", " << p.A_i << ", "
+        << p.G_i << ", " << p.R_star << ", " << static_cast<unsigned int>(p.DA) << " }";
+    }
+    void writeValue(const UFF::AtomicParams &p) {
+      d_out << "{ " << p.r1 << ", " << p.theta0 << ", " << p.x1 << ", "
+        << p.D1 << ", " << p.zeta << ", " << p.Z1 << ", " << p.V1 << ", "
+        << p.U1 << ", " << p.GMP_Xi << ", " << p.GMP_Hardness << ", "
+        << p.GMP_Radius << " }";
+    }
+  };
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "usage: " << argv[0]
+      << " <MMFFParamTables.inc> <UFFParamTables.inc>" << std::endl;
+    return 1;
+  }
+  std::ofstream mmffOut(argv[1]);
+  ForceFields::ParamTableWriter(mmffOut).writeMMFF();
+  std::ofstream uffOut(argv[2]);
+  ForceFields::ParamTableWriter(uffOut).writeUFF();
+  if (!mmffOut || !uffOut) {
+    std::cerr << "could not write the parameter tables" << std::endl;
+    return 1;
+  }
+  return 0;
+}
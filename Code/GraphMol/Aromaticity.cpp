@@ -10,6 +10,7 @@
 //
 #include <GraphMol/RDKitBase.h>
 #include <GraphMol/Rings.h>
+#include <GraphMol/SanitException.h>
 #include <RDGeneral/types.h>
 #include <boost/dynamic_bitset.hpp>
 #include <set>
@@ -90,25 +91,40 @@ namespace RingUtils {
                            INT_INT_VECT_MAP &neighMap,
                            unsigned int maxSize) {
     int nrings = brings.size();
-    int i, j;
-    INT_VECT ring1;
+    int i;
     for (i = 0; i < nrings; i++) {
       INT_VECT neighs;
       neighMap[i] = neighs;
     }
 
+    // rings are neighbors if they share an element, so instead of
+    // intersecting every pair of rings we collect the rings each
+    // element is in:
+    int maxElem=-1;
+    for (i = 0; i < nrings; i++) {
+      for (INT_VECT_CI ei = brings[i].begin(); ei != brings[i].end(); ++ei) {
+        maxElem=std::max(maxElem,*ei);
+      }
+    }
+    VECT_INT_VECT elemRings(maxElem+1);
+    for (i = 0; i < nrings; i++) {
+      if(maxSize && brings[i].size()>maxSize) continue;
+      for (INT_VECT_CI ei = brings[i].begin(); ei != brings[i].end(); ++ei) {
+        if(elemRings[*ei].empty() || elemRings[*ei].back()!=i){
+          elemRings[*ei].push_back(i);
+        }
+      }
+    }
     for (i = 0; i < nrings; i++) {
       if(maxSize && brings[i].size()>maxSize) continue;
-      ring1 = brings[i];
-      for (j = i + 1; j < nrings; j++) {
-        if(maxSize && brings[j].size()>maxSize) continue;
-        INT_VECT inter;
-        Intersect(ring1, brings[j], inter);
-        if (inter.size() > 0) {
-          neighMap[i].push_back(j);
-          neighMap[j].push_back(i);
+      INT_VECT &neighs=neighMap[i];
+      for (INT_VECT_CI ei = brings[i].begin(); ei != brings[i].end(); ++ei) {
+        for (INT_VECT_CI ri = elemRings[*ei].begin(); ri != elemRings[*ei].end(); ++ri) {
+          if(*ri!=i) neighs.push_back(*ri);
         }
       }
+      std::sort(neighs.begin(),neighs.end());
+      neighs.erase(std::unique(neighs.begin(),neighs.end()),neighs.end());
     }
 #if 0
     for (i = 0; i < nrings; i++) {
@@ -166,14 +182,19 @@ namespace {
                                  const VECT_INT_VECT &brings, // list of all rings as bond ids
                                  const INT_VECT &fused, // list of ring ids in the current fused system
                                  const VECT_EDON_TYPE &edon, // eletron donar state for each atom
+                                 const std::vector<Bond *> &bonds, // the bonds, by index
                                  INT_INT_VECT_MAP &ringNeighs,
                                  int &narom, // number of aromatic ring so far
-                                 unsigned int maxNumFusedRings
+                                 unsigned int maxNumFusedRings,
+                                 unsigned int nAtms, // number of atoms in all the rings
+                                 unsigned int &nEvaluated, // number of subsystems evaluated so far
+                                 unsigned int maxEvaluated
                                  );
 
   void markAtomsBondsArom(ROMol &mol, const VECT_INT_VECT &srings, 
                           const VECT_INT_VECT &brings,
                           const INT_VECT &ringIds,
+                          const std::vector<Bond *> &bonds,
                           std::set<unsigned int> &doneAtms) {
     INT_VECT aring, bring;
     INT_VECT_CI ri, ai, bi;
@@ -213,7 +234,7 @@ namespace {
     // now mark bonds that have a count of 1 to be aromatic;
     for (bci = bndCntr.begin(); bci != bndCntr.end(); bci++) {
       if ((*bci).second == 1) {
-        Bond *bond=mol.getBondWithIdx(bci->first);
+        Bond *bond=bonds[bci->first];
         bond->setIsAromatic(true);
         switch(bond->getBondType()){
         case Bond::SINGLE:
@@ -321,14 +342,167 @@ namespace {
     
 
   
+  // enumerates the connected subsystems with a given number of rings of a
+  // fused system and applies the Huckel rule to them. This is the ESU
+  // algorithm (S. Wernicke, IEEE/ACM TCBB 3:347-359 (2006)): each subsystem
+  // is generated exactly once, starting from its ring with the lowest index
+  // and only adding rings with higher indices that are not neighbors of
+  // rings picked earlier.
+  class FusedSubsystemEvaluator {
+  public:
+    FusedSubsystemEvaluator(ROMol &mol,const VECT_INT_VECT &srings,
+                            const VECT_INT_VECT &brings,const INT_VECT &fused,
+                            const VECT_EDON_TYPE &edon,const std::vector<Bond *> &bonds,
+                            INT_INT_VECT_MAP &ringNeighs,
+                            unsigned int &nEvaluated,unsigned int maxEvaluated) :
+      d_mol(mol), d_srings(srings), d_brings(brings), d_fused(fused), d_edon(edon),
+      d_bonds(bonds), d_nEvaluated(nEvaluated), d_maxEvaluated(maxEvaluated),
+      d_blocked(fused.size(),0), d_stamp(0), d_aromRings(fused.size()) {
+      std::map<int,unsigned int> localIdx;
+      for(unsigned int i=0;i<fused.size();++i) localIdx[fused[i]]=i;
+      d_neighs.resize(fused.size());
+      for(unsigned int i=0;i<fused.size();++i){
+        const INT_VECT &neighs=ringNeighs[fused[i]];
+        for(INT_VECT_CI ni=neighs.begin();ni!=neighs.end();++ni){
+          d_neighs[i].push_back(localIdx[*ni]);
+        }
+      }
+      // the atoms also get local indices, so that the work done for a
+      // system doesn't depend on the size of the molecule:
+      std::map<int,unsigned int> atomIdx;
+      d_ringAtoms.resize(fused.size());
+      for(unsigned int i=0;i<fused.size();++i){
+        const INT_VECT &ring=srings[fused[i]];
+        for(INT_VECT_CI ai=ring.begin();ai!=ring.end();++ai){
+          std::map<int,unsigned int>::const_iterator pos=atomIdx.find(*ai);
+          if(pos==atomIdx.end()){
+            pos=atomIdx.insert(std::make_pair(*ai,d_atoms.size())).first;
+            d_atoms.push_back(*ai);
+          }
+          d_ringAtoms[i].push_back(pos->second);
+        }
+      }
+      d_atomMarks.resize(d_atoms.size(),0);
+    };
+
+    //! evaluates all the connected subsystems with \c size rings
+    void evaluate(unsigned int size){
+      d_size=size;
+      for(unsigned int v=0;v<d_fused.size();++v){
+        std::vector<unsigned int> ext;
+        for(unsigned int i=0;i<d_neighs[v].size();++i){
+          if(d_neighs[v][i]>v) ext.push_back(d_neighs[v][i]);
+        }
+        addRing(v);
+        extend(ext,v);
+        removeRing(v);
+      }
+    };
+
+    unsigned int numAromaticRings() const { return d_aromRings.count(); };
+
+    //! returns whether or not evaluating more subsystems can change anything
+    bool done() const {
+      if(d_aromRings.count()!=d_fused.size()) return false;
+      for(INT_VECT_CI ri=d_fused.begin();ri!=d_fused.end();++ri){
+        for(INT_VECT_CI bi=d_brings[*ri].begin();bi!=d_brings[*ri].end();++bi){
+          if(!d_bonds[*bi]->getIsAromatic()) return false;
+        }
+      }
+      return true;
+    };
+
+    std::set<unsigned int> doneAtoms;
+
+  private:
+    ROMol &d_mol;
+    const VECT_INT_VECT &d_srings;
+    const VECT_INT_VECT &d_brings;
+    const INT_VECT &d_fused;
+    const VECT_EDON_TYPE &d_edon;
+    const std::vector<Bond *> &d_bonds;
+    unsigned int &d_nEvaluated;
+    unsigned int d_maxEvaluated;
+    std::vector< std::vector<unsigned int> > d_neighs;
+    // number of rings in the current subsystem that are this ring or its neighbors:
+    std::vector<unsigned int> d_blocked;
+    INT_VECT d_atoms;
+    std::vector< std::vector<unsigned int> > d_ringAtoms;
+    std::vector<unsigned int> d_atomMarks;
+    unsigned int d_stamp;
+    boost::dynamic_bitset<> d_aromRings;
+    std::vector<unsigned int> d_sub;
+    unsigned int d_size;
+
+    void addRing(unsigned int r){
+      d_sub.push_back(r);
+      ++d_blocked[r];
+      for(unsigned int i=0;i<d_neighs[r].size();++i) ++d_blocked[d_neighs[r][i]];
+    };
+    void removeRing(unsigned int r){
+      d_sub.pop_back();
+      --d_blocked[r];
+      for(unsigned int i=0;i<d_neighs[r].size();++i) --d_blocked[d_neighs[r][i]];
+    };
+
+    void extend(std::vector<unsigned int> ext,unsigned int v){
+      if(d_sub.size()==d_size){
+        check();
+        return;
+      }
+      while(!ext.empty()){
+        unsigned int w=ext.back();
+        ext.pop_back();
+        std::vector<unsigned int> nExt=ext;
+        for(unsigned int i=0;i<d_neighs[w].size();++i){
+          unsigned int u=d_neighs[w][i];
+          if(u>v && !d_blocked[u]) nExt.push_back(u);
+        }
+        addRing(w);
+        extend(nExt,v);
+        removeRing(w);
+      }
+    };
+
+    void check(){
+      ++d_nEvaluated;
+      if(d_maxEvaluated && d_nEvaluated>d_maxEvaluated){
+        throw MolSanitizeException("too many fused ring systems to evaluate for aromaticity");
+      }
+      INT_VECT curRs,unon;
+      ++d_stamp;
+      for(unsigned int i=0;i<d_sub.size();++i){
+        curRs.push_back(d_fused[d_sub[i]]);
+        const std::vector<unsigned int> &ring=d_ringAtoms[d_sub[i]];
+        for(unsigned int j=0;j<ring.size();++j){
+          if(d_atomMarks[ring[j]]!=d_stamp){
+            d_atomMarks[ring[j]]=d_stamp;
+            unon.push_back(d_atoms[ring[j]]);
+          }
+        }
+      }
+      if (applyHuckel(d_mol, unon, d_edon)) {
+        // mark the atoms and bonds in these rings to be aromatic
+        markAtomsBondsArom(d_mol, d_srings, d_brings, curRs, d_bonds, doneAtoms);
+        for(unsigned int i=0;i<d_sub.size();++i){
+          d_aromRings.set(d_sub[i]);
+        }
+      }
+    };
+  };
+
   void applyHuckelToFused(ROMol &mol, // molecule of interets
                           const VECT_INT_VECT &srings, // list of all ring as atom IDS
                           const VECT_INT_VECT &brings, // list of all rings as bond ids
                           const INT_VECT &fused, // list of ring ids in the current fused system
                           const VECT_EDON_TYPE &edon, // eletron donor state for each atom
+                          const std::vector<Bond *> &bonds, // the bonds, by index
                           INT_INT_VECT_MAP &ringNeighs, // list of neighbors for eac candidate ring
                           int &narom, // number of aromatic ring so far
-                          unsigned int maxNumFusedRings
+                          unsigned int maxNumFusedRings,
+                          unsigned int nAtms, // number of atoms in all the rings
+                          unsigned int &nEvaluated, // number of subsystems evaluated so far
+                          unsigned int maxEvaluated
                           ) {
 
     // this function check huckel rule on a fused system it starts
@@ -336,85 +510,31 @@ namespace {
     // check for larger system i.e. if we have a 3 ring fused system,
     // huckel rule checked first on all teh 1 ring subsystems then 2
     // rung subsystems etc.
-
-    INT_VECT aromRings;
-    aromRings.resize(0);
+    //
+    // Only connected subsystems are considered, these are enumerated
+    // directly instead of filtering all combinations of rings.
     unsigned int nrings = fused.size();
-    INT_VECT curRs;
-    INT_VECT_CI mri;
-    curRs.push_back(fused.front());
-    int pos;
-    unsigned int i, curSize = 0;
-    INT_VECT comb;
-    pos = -1;
-    INT_VECT unionAtms;
-    Union(srings, unionAtms);
-    unsigned int nAtms = unionAtms.size();
-    std::set<unsigned int> doneAtoms;
-    while (1) {
-      if (pos == -1 ) {
-        
-        curSize++;
-        // check is we are done with all the atoms in the fused
-        // system, if so quit. This is a fix for Issue252 REVIEW: is
-        // this check sufficient or should we add an additional
-        // contraint on the the number of combinations of rings in a
-        // fused system that we will try. The number of combinations
-        // can obviously be quite large when the number of rings in
-        // the fused system is large
-        if ((doneAtoms.size() == nAtms) || (curSize > std::min(nrings,maxNumFusedRings)) ){
-          break;
-        }
-        comb.resize(curSize);
-        pos = 0;
-        for (i =0; i < curSize; i++) {
-          comb[i]=i;
-        }
-      }
-      else {
-        pos = nextCombination(comb, nrings);
+    FusedSubsystemEvaluator evaluator(mol,srings,brings,fused,edon,bonds,ringNeighs,
+                                      nEvaluated,maxEvaluated);
+    for (unsigned int curSize = 1; ; ++curSize) {
+      // check is we are done with all the atoms in the fused
+      // system, if so quit. This is a fix for Issue252 REVIEW: is
+      // this check sufficient or should we add an additional
+      // contraint on the the number of combinations of rings in a
+      // fused system that we will try. The number of combinations
+      // can obviously be quite large when the number of rings in
+      // the fused system is large
+      if ((evaluator.doneAtoms.size() == nAtms) || (curSize > std::min(nrings,maxNumFusedRings)) ){
+        break;
       }
-
-      if (pos == -1) {
-        continue;
-      }
-
-      curRs.resize(0);
-      for (i = 0; i < comb.size(); i++) {
-        curRs.push_back(fused[comb[i]]);
+      // once every ring has been found to be aromatic and all the
+      // bonds are marked, larger subsystems can't change anything:
+      if (curSize > 1 && evaluator.done()) {
+        break;
       }
-
-      // check if the picked subsystem is fused
-      if (!RingUtils::checkFused(curRs, ringNeighs)) {
-        continue;
-      }
-
-      // check aromaticity on the current fused system
-      INT_VECT exclude;
-      for (i = 0; i < srings.size(); i++) {
-        if (std::find(curRs.begin(), curRs.end(),
-                      static_cast<int>(i)) == curRs.end() ) {
-          exclude.push_back(i);
-        }
-      }
-      INT_VECT unon;
-      Union(srings, unon, &exclude);
-      
-      if (applyHuckel(mol, unon, edon)) {
-        // mark the atoms and bonds in these rings to be aromatic
-        markAtomsBondsArom(mol, srings, brings, curRs, doneAtoms);
-
-        // add the ring IDs to the aromatic rings found so far
-        // avoid duplicates
-        for (mri = curRs.begin(); mri != curRs.end(); mri++) {
-          if (std::find(aromRings.begin(), aromRings.end(),
-                        (*mri) ) == aromRings.end()) {
-            aromRings.push_back(*mri);
-          }
-        }
-      }// end check huckel rule
-    } // end while(1)
-    narom += aromRings.size();
+      evaluator.evaluate(curSize);
+    }
+    narom += evaluator.numAromaticRings();
   }
 
   bool isAtomCandForArom(const Atom *at, const ElectronDonorType edon) {
@@ -604,7 +724,7 @@ namespace RDKit {
     }
 
 
-    int setAromaticity(RWMol &mol) {
+    int setAromaticity(RWMol &mol,PerceptionCost *cost,unsigned int maxFusedSubsystems) {
       // FIX: we will assume for now that if the input molecule came
       // with aromaticity information it is correct and we will not
       // touch it. Loop through the atoms and check if any atom has
@@ -681,10 +801,25 @@ namespace RDKit {
       int cnrs = cRings.size();
       boost::dynamic_bitset<> fusDone(cnrs);
       INT_VECT fused;
+      boost::dynamic_bitset<> ringAtoms(natoms);
+      for (VECT_INT_VECT_CI vivi = cRings.begin(); vivi != cRings.end(); ++vivi) {
+        for (INT_VECT_CI ivi = vivi->begin(); ivi != vivi->end(); ++ivi) {
+          ringAtoms.set(*ivi);
+        }
+      }
+      unsigned int nRingAtoms=ringAtoms.count();
+      // getBondWithIdx() has to walk the bond list, so look the bonds up once:
+      std::vector<Bond *> bonds(mol.getNumBonds());
+      for(ROMol::BondIterator bi=mol.beginBonds();bi!=mol.endBonds();++bi){
+        bonds[(*bi)->getIdx()]=*bi;
+      }
+      unsigned int nEvaluated=0;
       while (curr < cnrs) {
         fused.resize(0);
         RingUtils::pickFusedRings(curr, neighMap, fused, fusDone);
-        applyHuckelToFused(mol, cRings, brings, fused, edon, neighMap, narom,6);
+        applyHuckelToFused(mol, cRings, brings, fused, edon, bonds, neighMap, narom,6,
+                           nRingAtoms, nEvaluated, maxFusedSubsystems);
+        if(cost) cost->numRingSystems+=1;
 
         int rix;
         for (rix = 0; rix < cnrs; rix++) {
@@ -698,6 +833,10 @@ namespace RDKit {
         }
       }
     
+      if(cost){
+        cost->numCandidates+=nEvaluated;
+        cost->numResults+=narom;
+      }
       mol.setProp("numArom", narom, true);
 
       return narom;
@@ -16,9 +16,12 @@
 #include <RDGeneral/utils.h>
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/RDLog.h>
+#include <RDGeneral/RDThreads.h>
 
 #include <boost/dynamic_bitset.hpp>
+#include <boost/shared_ptr.hpp>
 #include <Geometry/point.h>
+#include <stdexcept>
 
 // #define VERBOSE_CANON 1
 
@@ -110,162 +113,238 @@ namespace RDKit{
       }
     }
 
-    void iterateCIPRanks(const ROMol &mol, DOUBLE_VECT &invars, INT_VECT &ranks,bool seedWithInvars){
+    // compares the neighbor keys used while refining the CIP ranks
+    class CIPKeyLess {
+    public:
+      CIPKeyLess(const INT_VECT &vals,const UINT_VECT &starts) : d_vals(vals), d_starts(starts) {};
+      bool operator() (unsigned int k1,unsigned int k2) const {
+        return std::lexicographical_compare(d_vals.begin()+d_starts[k1],d_vals.begin()+d_starts[k1+1],
+                                            d_vals.begin()+d_starts[k2],d_vals.begin()+d_starts[k2+1]);
+      }
+    private:
+      const INT_VECT &d_vals;
+      const UINT_VECT &d_starts;
+    };
+
+    // Refines the ranks of the atoms until either:
+    //   1) all classes are uniquified
+    //   2) the number of ranks doesn't change from one iteration to
+    //      the next
+    //   3) we've gone through maxIts times
+    //      maxIts is calculated by dividing the number of atoms
+    //      by 2. That's a pessimal version of the
+    //      maximum number of steps required for two atoms to 
+    //      "feel" each other (each influences one additional 
+    //      neighbor shell per iteration). 
+    //
+    // In each iteration the atoms of a class are ordered by the ranks of
+    // their neighbors (sorted, highest first). The atoms are kept in an
+    // array ordered by rank and, while iterating, the rank of an atom is
+    // the position of the first member of its class in that array, so
+    // splitting one class doesn't renumber the others. A class can only
+    // split if one of its members has a neighbor whose class split in the
+    // previous iteration, so only those classes are looked at. The ranks
+    // are converted back to consecutive integers at the end.
+    void iterateCIPRanks(const ROMol &mol, const DOUBLE_VECT &invars, INT_VECT &ranks){
       PRECONDITION(invars.size()==mol.getNumAtoms(),"bad invars size");
       PRECONDITION(ranks.size()>=mol.getNumAtoms(),"bad ranks size");
 
-      int numAtoms = mol.getNumAtoms();
-      CIP_ENTRY_VECT cipEntries(numAtoms);
-      INT_LIST allIndices;
-      for(int i=0;i<numAtoms;++i){
-        allIndices.push_back(i);
-      }
-#ifdef VERBOSE_CANON
-      BOOST_LOG(rdDebugLog) << "invariants:" << std::endl;
-      for(int i=0;i<numAtoms;i++){
-        BOOST_LOG(rdDebugLog) << i << ": " << invars[i] << std::endl;
-      }
-#endif  
+      unsigned int numAtoms = mol.getNumAtoms();
+      if(!numAtoms) return;
 
-      // rank those:
+      // rank the invariants and use those to set up the initial classes:
       RankAtoms::rankVect(invars,ranks);
+      UINT_VECT order(numAtoms);
+      for(unsigned int i=0;i<numAtoms;++i) order[i]=i;
+      std::sort(order.begin(),order.end(),RankAtoms::argless<INT_VECT>(ranks));
+      // classStart[atomIdx] is the position in order of the first member
+      // of the atom's class, classSize[pos] is the size of the class
+      // starting at pos:
+      UINT_VECT classStart(numAtoms),classSize(numAtoms,0);
+      unsigned int numClasses=0;
+      for(unsigned int pos=0;pos<numAtoms;++pos){
+        unsigned int start=pos;
+        if(pos && ranks[order[pos]]==ranks[order[pos-1]]){
+          start=classStart[order[pos-1]];
+        } else {
+          ++numClasses;
+        }
+        classStart[order[pos]]=start;
+        ++classSize[start];
+      }
 #ifdef VERBOSE_CANON
       BOOST_LOG(rdDebugLog) << "initial ranks:" << std::endl;
-      for(int i=0;i<numAtoms;++i){
+      for(unsigned int i=0;i<numAtoms;++i){
         BOOST_LOG(rdDebugLog) << i << ": " << ranks[i] << std::endl;
       }
 #endif  
-      // Start each atom's rank vector with its atomic number:
-      //  Note: in general one should avoid the temptation to
-      //  use invariants here, those lead to incorrect answers
-      for(int i=0;i<numAtoms;i++){
-        if(!seedWithInvars){
-          cipEntries[i].push_back(mol[i]->getAtomicNum());
-          cipEntries[i].push_back(static_cast<int>(ranks[i]));
-        } else {
-          cipEntries[i].push_back(static_cast<int>(invars[i]));
+
+      if(numClasses==numAtoms){
+        return;
+      }
+
+      // collect the neighbor information once (this is only needed if
+      // the invariants leave ties):
+      UINT_VECT nbrStarts(numAtoms+1,0);
+      UINT_VECT nbrIndices,nbrCounts;
+      nbrIndices.reserve(2*mol.getNumBonds());
+      nbrCounts.reserve(2*mol.getNumBonds());
+      UINT_VECT numHs(numAtoms,0);
+      for(unsigned int i=0;i<numAtoms;++i){
+        nbrStarts[i]=nbrIndices.size();
+        const Atom *atom=mol[i].get();
+        ROMol::OEDGE_ITER beg,end;
+        boost::tie(beg,end) = mol.getAtomBonds(atom);
+        while(beg!=end){
+          const Bond *bond=mol[*beg].get();
+          ++beg;
+          unsigned int nbrIdx=bond->getOtherAtomIdx(i);
+          const Atom *nbr=mol[nbrIdx].get();
+
+          // put the neighbor in 2N times where N is the bond order as a double.
+          // this is to treat aromatic linkages on fair footing. i.e. at least in the
+          // first iteration --c(:c):c and --C(=C)-C should look the same.
+          // this was part of issue 3009911
+
+          unsigned int count;
+          if(bond->getBondType()==Bond::DOUBLE &&
+             nbr->getAtomicNum()==15 &&
+             (nbr->getDegree()==4 ||
+              nbr->getDegree()==3) ) {
+            // a special case for chiral phophorous compounds
+            // (this was leading to incorrect assignment of
+            // R/S labels ):
+            count=1;
+
+            // general justification of this is:
+            // Paragraph 2.2. in the 1966 article is "Valence-Bond Conventions:
+            // Multiple-Bond Unsaturation and Aromaticity". It contains several
+            // conventions of which convention (b) is the one applying here:
+            // "(b) Contibutions by d orbitals to bonds of quadriligant atoms are
+            // neglected."
+            // FIX: this applies to more than just P
+          } else {
+            count=static_cast<unsigned int>(floor(2.*bond->getBondTypeAsDouble()+.1));
+          }
+          nbrIndices.push_back(nbrIdx);
+          nbrCounts.push_back(count);
+        }
+        // add a zero for each coordinated H:
+        // (as long as we're not a query atom)
+        if(!atom->hasQuery()){
+          numHs[i]=atom->getTotalNumHs();
         }
       }
+      nbrStarts[numAtoms]=nbrIndices.size();
 
-      // Loop until either:
-      //   1) all classes are uniquified
-      //   2) the number of ranks doesn't change from one iteration to
-      //      the next
-      //   3) we've gone through maxIts times
-      //      maxIts is calculated by dividing the number of atoms
-      //      by 2. That's a pessimal version of the
-      //      maximum number of steps required for two atoms to 
-      //      "feel" each other (each influences one additional 
-      //      neighbor shell per iteration). 
-      int maxIts=numAtoms/2+1;
-      int numIts=0;
-      int lastNumRanks=-1;
-      int numRanks=*std::max_element(ranks.begin(),ranks.end())+1;
-      while( numRanks<numAtoms && numIts<maxIts && (lastNumRanks==-1 || lastNumRanks<numRanks) ){
-        unsigned int longestEntry=0;
+      // to start with every class with more than one member is in play:
+      UINT_VECT activeClasses;
+      for(unsigned int pos=0;pos<numAtoms;pos+=classSize[pos]){
+        if(classSize[pos]>1) activeClasses.push_back(pos);
+      }
+      boost::dynamic_bitset<> classSeen(numAtoms);
+      UINT_VECT splitAtoms;
+      INT_VECT keyVals;
+      UINT_VECT keyStarts;
+      INT_PAIR_VECT localEntry;
+      UINT_VECT keys,members;
+
+      unsigned int maxIts=numAtoms/2+1;
+      unsigned int numIts=0;
+      while( numClasses<numAtoms && numIts<maxIts && activeClasses.size() ){
         // ----------------------------------------------------
         //
-        // for each atom, get a sorted list of its neighbors' ranks:
+        // for each atom in play, get a sorted list of its neighbors' ranks.
+        // These all need to be done before any class is split.
         //
-        for(INT_LIST_I it=allIndices.begin();
-            it!=allIndices.end();
-            ++it){
-          CIP_ENTRY localEntry;
-          localEntry.reserve(16);
-
-          // start by pushing on our neighbors' ranks:
-          ROMol::OEDGE_ITER beg,end;
-          boost::tie(beg,end) = mol.getAtomBonds(mol[*it].get());
-          while(beg!=end){
-            const Bond *bond=mol[*beg].get();
-            ++beg;
-            unsigned int nbrIdx=bond->getOtherAtomIdx(*it);
-            const Atom *nbr=mol[nbrIdx].get();
-            
-            int rank=ranks[nbrIdx]+1;
-            // put the neighbor in 2N times where N is the bond order as a double.
-            // this is to treat aromatic linkages on fair footing. i.e. at least in the
-            // first iteration --c(:c):c and --C(=C)-C should look the same.
-            // this was part of issue 3009911
-
-            unsigned int count;
-            if(bond->getBondType()==Bond::DOUBLE &&
-               nbr->getAtomicNum()==15 &&
-               (nbr->getDegree()==4 ||
-                nbr->getDegree()==3) ) {
-              // a special case for chiral phophorous compounds
-              // (this was leading to incorrect assignment of
-              // R/S labels ):
-              count=1;
-
-              // general justification of this is:
-              // Paragraph 2.2. in the 1966 article is "Valence-Bond Conventions:
-              // Multiple-Bond Unsaturation and Aromaticity". It contains several
-              // conventions of which convention (b) is the one applying here:
-              // "(b) Contibutions by d orbitals to bonds of quadriligant atoms are
-              // neglected."
-              // FIX: this applies to more than just P
-            } else {
-              count=static_cast<unsigned int>(floor(2.*bond->getBondTypeAsDouble()+.1));
+        keyVals.clear();
+        keyStarts.clear();
+        keyStarts.push_back(0);
+        for(UINT_VECT::const_iterator clIt=activeClasses.begin();
+            clIt!=activeClasses.end();++clIt){
+          for(unsigned int pos=*clIt;pos<*clIt+classSize[*clIt];++pos){
+            unsigned int atomIdx=order[pos];
+            localEntry.clear();
+            for(unsigned int j=nbrStarts[atomIdx];j<nbrStarts[atomIdx+1];++j){
+              localEntry.push_back(std::make_pair(classStart[nbrIndices[j]]+1,
+                                                  nbrCounts[j]));
             }
-            CIP_ENTRY::iterator ePos=std::lower_bound(localEntry.begin(),localEntry.end(),rank);
-            localEntry.insert(ePos,count,rank);
-            ++nbr;
-          }
-          // add a zero for each coordinated H:
-          // (as long as we're not a query atom)
-          if(!mol[*it]->hasQuery()){
-            localEntry.insert(localEntry.begin(),
-                              mol[*it]->getTotalNumHs(),
-                              0);
-          }
-
-          // we now have a sorted list of our neighbors' ranks,
-          // copy it on in reversed order:
-          cipEntries[*it].insert(cipEntries[*it].end(),
-                                 localEntry.rbegin(),
-                                 localEntry.rend());
-          if(cipEntries[*it].size() > longestEntry){
-            longestEntry = cipEntries[*it].size();
+            std::sort(localEntry.begin(),localEntry.end(),
+                      RankAtoms::pairGreater<int,int>());
+            for(INT_PAIR_VECT_CI eIt=localEntry.begin();eIt!=localEntry.end();++eIt){
+              keyVals.insert(keyVals.end(),eIt->second,eIt->first);
+            }
+            keyVals.insert(keyVals.end(),numHs[atomIdx],0);
+            keyStarts.push_back(keyVals.size());
           }
         }
+
         // ----------------------------------------------------
         //
-        // pad the entries so that we compare rounds to themselves:
-        // 
-        for(INT_LIST_I it=allIndices.begin();it!=allIndices.end();
-            ++it){
-          unsigned int sz=cipEntries[*it].size();
-          if(sz<longestEntry){
-            cipEntries[*it].insert(cipEntries[*it].end(),
-                                   longestEntry-sz,
-                                   -1);
+        // sort the members of each class and split it where the keys differ
+        //
+        CIPKeyLess keyLess(keyVals,keyStarts);
+        splitAtoms.clear();
+        unsigned int keyOffset=0;
+        for(UINT_VECT::const_iterator clIt=activeClasses.begin();
+            clIt!=activeClasses.end();++clIt){
+          unsigned int start=*clIt;
+          unsigned int size=classSize[start];
+          members.assign(order.begin()+start,order.begin()+start+size);
+          keys.resize(size);
+          for(unsigned int j=0;j<size;++j) keys[j]=keyOffset+j;
+          std::sort(keys.begin(),keys.end(),keyLess);
+
+          unsigned int subStart=start;
+          for(unsigned int j=0;j<size;++j){
+            if(j && keyLess(keys[j-1],keys[j])){
+              classSize[subStart]=start+j-subStart;
+              subStart=start+j;
+              ++numClasses;
+            }
+            unsigned int atomIdx=members[keys[j]-keyOffset];
+            order[start+j]=atomIdx;
+            classStart[atomIdx]=subStart;
           }
+          classSize[subStart]=start+size-subStart;
+          if(subStart!=start){
+            splitAtoms.insert(splitAtoms.end(),members.begin(),members.end());
+          }
+          keyOffset+=size;
         }
+        ++numIts;
+
         // ----------------------------------------------------
         //
-        // sort the new ranks and update the list of active indices:
-        // 
-        lastNumRanks=numRanks;
-
-        RankAtoms::rankVect(cipEntries,ranks);
-        numRanks = *std::max_element(ranks.begin(),ranks.end())+1;
-
-        // now truncate each vector and stick the rank at the end
-        for(unsigned int i=0;i<numAtoms;++i){
-          cipEntries[i][numIts+1]=ranks[i];
-          cipEntries[i].erase(cipEntries[i].begin()+numIts+2,cipEntries[i].end());
+        // the classes in play next time are the ones with a
+        // neighbor in a class that was just split:
+        //
+        activeClasses.clear();
+        classSeen.reset();
+        for(UINT_VECT::const_iterator atIt=splitAtoms.begin();
+            atIt!=splitAtoms.end();++atIt){
+          for(unsigned int j=nbrStarts[*atIt];j<nbrStarts[*atIt+1];++j){
+            unsigned int start=classStart[nbrIndices[j]];
+            if(classSize[start]>1 && !classSeen[start]){
+              classSeen.set(start);
+              activeClasses.push_back(start);
+            }
+          }
         }
-        
-        ++numIts;
+      }
+
+      // convert the class positions to ranks:
+      int rank=-1;
+      for(unsigned int pos=0;pos<numAtoms;++pos){
+        if(classStart[order[pos]]==pos) ++rank;
+        ranks[order[pos]]=rank;
+      }
 #ifdef VERBOSE_CANON
-        BOOST_LOG(rdDebugLog) << "strings and ranks:" << std::endl;
-        for(int i=0;i<numAtoms;i++){
-          BOOST_LOG(rdDebugLog) << i << ": " << ranks[i] << " > ";
-          debugVect(cipEntries[i]);
-        }
-#endif
+      BOOST_LOG(rdDebugLog) << "final ranks (" << numIts << " iterations):" << std::endl;
+      for(unsigned int i=0;i<numAtoms;++i){
+        BOOST_LOG(rdDebugLog) << i << ": " << ranks[i] << std::endl;
       }
+#endif
     }
     // Figure out the CIP ranks for the atoms of a molecule
     void assignAtomCIPRanks(const ROMol &mol, INT_VECT &ranks){
@@ -276,7 +355,7 @@ namespace RDKit{
       // get the initial invariants:
       DOUBLE_VECT invars(numAtoms,0);
       buildCIPInvariants(mol,invars);
-      iterateCIPRanks(mol,invars,ranks,false);
+      iterateCIPRanks(mol,invars,ranks);
 
       // copy the ranks onto the atoms:
       for(unsigned int i=0;i<numAtoms;++i){
@@ -376,7 +455,10 @@ namespace RDKit{
       }
     }
 
-    bool atomIsCandidateForRingStereochem(const ROMol &mol,const Atom *atom){
+    // the ranks of the neighbors are taken from \c ranks if it's
+    // been filled, otherwise from the atoms' _CIPRank properties
+    bool atomIsCandidateForRingStereochem(const ROMol &mol,const Atom *atom,
+                                          const INT_VECT &ranks){
       PRECONDITION(atom,"bad atom");
       bool res=false;
       if(atom->hasProp("_ringStereochemCand")){
@@ -409,7 +491,9 @@ namespace RDKit{
             if(ringNbrs.size()==2) res=true;
             break;
           case 2:
-            if( nonRingNbrs[0]->hasProp("_CIPRank") &&
+            if(ranks.size()){
+              res = ranks[nonRingNbrs[0]->getIdx()]!=ranks[nonRingNbrs[1]->getIdx()];
+            } else if( nonRingNbrs[0]->hasProp("_CIPRank") &&
                 nonRingNbrs[1]->hasProp("_CIPRank") ){
               nonRingNbrs[0]->getProp("_CIPRank",rank1);
               nonRingNbrs[1]->getProp("_CIPRank",rank2);
@@ -430,7 +514,7 @@ namespace RDKit{
     }
 
     // returns true if the atom is allowed to have stereochemistry specified
-    bool checkChiralAtomSpecialCases(ROMol &mol,const Atom *atom){
+    bool checkChiralAtomSpecialCases(ROMol &mol,const Atom *atom,const INT_VECT &ranks){
       PRECONDITION(atom,"bad atom");
 
       if(!mol.getRingInfo()->isInitialized()){
@@ -440,7 +524,7 @@ namespace RDKit{
 
       const RingInfo *ringInfo=mol.getRingInfo();
       if(ringInfo->numAtomRings(atom->getIdx()) &&
-         atomIsCandidateForRingStereochem(mol,atom) ){
+         atomIsCandidateForRingStereochem(mol,atom,ranks) ){
         // the atom is in a ring, so the "chirality" specification may actually
         // be handling ring stereochemistry.
 
@@ -450,7 +534,7 @@ namespace RDKit{
         if(atom->hasProp("_ringStereoAtoms")){
           ringStereoAtoms=atom->getProp<INT_VECT>("_ringStereoAtoms");
         }
-        const VECT_INT_VECT atomRings=ringInfo->atomRings();
+        const VECT_INT_VECT &atomRings=ringInfo->atomRings();
         for(VECT_INT_VECT::const_iterator ringIt=atomRings.begin();
             ringIt!=atomRings.end();++ringIt){
           if(std::find(ringIt->begin(),ringIt->end(),
@@ -461,7 +545,7 @@ namespace RDKit{
               if(*idxIt!=static_cast<int>(atom->getIdx()) &&
                  mol.getAtomWithIdx(*idxIt)->getChiralTag()!=Atom::CHI_UNSPECIFIED &&
                  !mol.getAtomWithIdx(*idxIt)->hasProp("_CIPCode") &&
-                 atomIsCandidateForRingStereochem(mol,mol.getAtomWithIdx(*idxIt)) ){
+                 atomIsCandidateForRingStereochem(mol,mol.getAtomWithIdx(*idxIt),ranks) ){
                 // we get to keep the stereochem specification on this atom:
                 if(mol.getAtomWithIdx(*idxIt)->getChiralTag()!=atom->getChiralTag()){
                   same=-1;
@@ -496,7 +580,6 @@ namespace RDKit{
         // we only know tetrahedral chirality
         legalCenter=false;
       } else {
-        boost::dynamic_bitset<> codesSeen(mol.getNumAtoms());
         ROMol::OEDGE_ITER beg,end;
         boost::tie(beg,end) = mol.getAtomBonds(atom);
         while(beg!=end){
@@ -504,13 +587,17 @@ namespace RDKit{
           CHECK_INVARIANT(ranks[otherIdx]<static_cast<int>(mol.getNumAtoms()),
                           "CIP rank higher than the number of atoms.");
           // watch for neighbors with duplicate ranks, which would mean
-          // that we cannot be chiral:
-          if(codesSeen[ranks[otherIdx]]){
-            // we've already seen this code, it's a dupe
-            hasDupes = true;
-            break;
+          // that we cannot be chiral (there are at most four neighbors
+          // here, so a linear search is fine):
+          for(Chirality::INT_PAIR_VECT_CI nbrIt=nbrs.begin();
+              nbrIt!=nbrs.end();++nbrIt){
+            if(nbrIt->first==ranks[otherIdx]){
+              // we've already seen this code, it's a dupe
+              hasDupes = true;
+              break;
+            }
           }
-          codesSeen[ranks[otherIdx]]=1;
+          if(hasDupes) break;
           nbrs.push_back(std::make_pair(ranks[otherIdx],
                                         mol[*beg]->getIdx()));
           ++beg;
@@ -767,7 +854,7 @@ namespace RDKit{
           ++beg;
         }
       }
-      iterateCIPRanks(mol,invars,ranks,true);
+      iterateCIPRanks(mol,invars,ranks);
       // copy the ranks onto the atoms:
       for(unsigned int i=0;i<mol.getNumAtoms();i++){
         mol.getAtomWithIdx(i)->setProp("_CIPRank",ranks[i],1);
@@ -868,7 +955,7 @@ namespace RDKit{
           Atom *atom=*atIt;
           if(atom->getChiralTag()!=Atom::CHI_UNSPECIFIED
              && !atom->hasProp("_CIPCode") &&
-             !Chirality::checkChiralAtomSpecialCases(mol,atom) ){
+             !Chirality::checkChiralAtomSpecialCases(mol,atom,atomRanks) ){
             atom->setChiralTag(Atom::CHI_UNSPECIFIED);
             
             // If the atom has an explicit hydrogen and no charge, that H
@@ -907,6 +994,81 @@ namespace RDKit{
 
     }
 
+#ifdef RDK_THREADSAFE_SSS
+    namespace {
+      // the exception that stopped a thread; it's rethrown in the
+      // calling thread once all the threads are done.
+      struct StereoThreadError {
+        StereoThreadError() : molIdx(-1) {};
+        int molIdx;
+        boost::shared_ptr<Invar::Invariant> invariant;
+        std::string message;
+        void rethrow() const {
+          if(invariant) throw *invariant;
+          throw std::runtime_error(message);
+        }
+      };
+
+      void assignStereochemistryHelper(const std::vector<ROMol *> *mols,
+                                       bool cleanIt,bool force,
+                                       bool flagPossibleStereoCenters,
+                                       unsigned int start,unsigned int stride,
+                                       StereoThreadError *error){
+        for(unsigned int i=start;i<mols->size();i+=stride){
+          if(!(*mols)[i]) continue;
+          try{
+            assignStereochemistry(*(*mols)[i],cleanIt,force,flagPossibleStereoCenters);
+          } catch (Invar::Invariant &e) {
+            error->invariant.reset(new Invar::Invariant(e));
+            error->molIdx=i;
+            return;
+          } catch (std::exception &e) {
+            error->message=e.what();
+            error->molIdx=i;
+            return;
+          } catch (...) {
+            error->message="unknown error assigning stereochemistry";
+            error->molIdx=i;
+            return;
+          }
+        }
+      }
+    }
+#endif
+
+    void assignStereochemistry(const std::vector<ROMol *> &mols,bool cleanIt,bool force,
+                               bool flagPossibleStereoCenters,int numThreads){
+      numThreads=getNumThreadsToUse(numThreads);
+      if(numThreads==1 || mols.size()<2){
+        for(unsigned int i=0;i<mols.size();++i){
+          if(!mols[i]) continue;
+          assignStereochemistry(*mols[i],cleanIt,force,flagPossibleStereoCenters);
+        }
+      }
+#ifdef RDK_THREADSAFE_SSS
+      else {
+        // make sure the singletons are initialized before the threads start:
+        PeriodicTable::getTable();
+        std::vector<StereoThreadError> errors(numThreads);
+        boost::thread_group tg;
+        for(int ti=0;ti<numThreads;++ti){
+          tg.add_thread(new boost::thread(assignStereochemistryHelper,&mols,cleanIt,force,
+                                          flagPossibleStereoCenters,ti,numThreads,
+                                          &errors[ti]));
+        }
+        tg.join_all();
+        // pass on the error from the first molecule that failed:
+        const StereoThreadError *first=0;
+        for(int ti=0;ti<numThreads;++ti){
+          if(errors[ti].molIdx>=0 && (!first || errors[ti].molIdx<first->molIdx)){
+            first=&errors[ti];
+          }
+        }
+        if(first) first->rethrow();
+      }
+#endif
+    }
+
     // Find bonds than can be cis/trans in a molecule and mark them as "any"
     // - this function finds any double bonds that can potentially be part 
     //   of a cis/trans system. No attempt is made here to mark them cis or trans
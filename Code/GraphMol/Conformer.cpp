@@ -25,6 +25,15 @@ namespace RDKit {
     df_is3D = conf.is3D();
   }
 
+  void Conformer::setId(unsigned int id) {
+    if (id == d_id) return;
+    d_id = id;
+    // keep the owning molecule's id lookup up to date:
+    if (dp_mol) {
+      dp_mol->rebuildConformerIndex();
+    }
+  }
+
   void Conformer::setOwningMol(ROMol *mol) {
     PRECONDITION(mol, "");
     dp_mol = mol;
@@ -103,9 +103,7 @@ namespace RDKit {
     inline unsigned int getId() const {return d_id;}
     
     //! set the ID of this conformer
-    inline void setId(unsigned int id) {
-      d_id = id;
-    }
+    void setId(unsigned int id);
 
     //! Get the number of atoms
     inline unsigned int getNumAtoms() const {
@@ -0,0 +1,228 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "ConformerEnsemble.h"
+#include "ROMol.h"
+#include <RDGeneral/StreamOps.h>
+#include <boost/cstdint.hpp>
+#include <sstream>
+#include <limits>
+
+namespace RDKit {
+  namespace {
+    // the first value in a pickle:
+    const boost::int32_t ensemblePickleVersion=1;
+
+    template <typename T,typename U>
+    void readCoords(std::istream &ss,std::vector<T> &coords){
+      for(size_t i=0;i<coords.size();++i){
+        U tmp;
+        streamRead(ss,tmp);
+        coords[i]=static_cast<T>(tmp);
+      }
+    }
+  }
+
+  template <typename T>
+  ConformerEnsemble<T>::ConformerEnsemble(const ROMol &mol) :
+    d_numAtoms(mol.getNumAtoms())
+  {
+    d_coords.reserve(mol.getNumConformers()*3*d_numAtoms);
+    d_ids.reserve(mol.getNumConformers());
+    d_is3D.reserve(mol.getNumConformers());
+    for(ROMol::ConstConformerIterator ci=mol.beginConformers();
+        ci!=mol.endConformers();++ci){
+      // the molecule may have more than one conformer with the same
+      // id, the first one wins (as in ROMol::getConformer()):
+      if(!hasConformer((*ci)->getId())) addConformer(**ci);
+    }
+  }
+
+  template <typename T>
+  ConformerEnsemble<T>::ConformerEnsemble(const std::string &pickle) :
+    d_numAtoms(0)
+  {
+    initFromBinary(pickle);
+  }
+
+  template <typename T>
+  unsigned int ConformerEnsemble<T>::addConformer(const Conformer &conf){
+    PRECONDITION(conf.getNumAtoms()==d_numAtoms,"Number of atom mismatch");
+    if(hasConformer(conf.getId())){
+      std::ostringstream errout;
+      errout<<"Duplicate conformation ID: "<<conf.getId();
+      throw ConformerException(errout.str());
+    }
+    unsigned int slot=d_ids.size();
+    d_coords.reserve(d_coords.size()+3*d_numAtoms);
+    const RDGeom::POINT3D_VECT &pts=conf.getPositions();
+    for(unsigned int i=0;i<d_numAtoms;++i){
+      d_coords.push_back(static_cast<T>(pts[i].x));
+      d_coords.push_back(static_cast<T>(pts[i].y));
+      d_coords.push_back(static_cast<T>(pts[i].z));
+    }
+    d_ids.push_back(conf.getId());
+    d_is3D.push_back(conf.is3D());
+    d_slots[conf.getId()]=slot;
+    return slot;
+  }
+
+  template <typename T>
+  unsigned int ConformerEnsemble<T>::addConformer(const T *coords,unsigned int id,bool is3D){
+    PRECONDITION(coords || !d_numAtoms,"no coordinates");
+    if(hasConformer(id)){
+      std::ostringstream errout;
+      errout<<"Duplicate conformation ID: "<<id;
+      throw ConformerException(errout.str());
+    }
+    unsigned int slot=d_ids.size();
+    d_coords.insert(d_coords.end(),coords,coords+3*d_numAtoms);
+    d_ids.push_back(id);
+    d_is3D.push_back(is3D);
+    d_slots[id]=slot;
+    return slot;
+  }
+
+  template <typename T>
+  unsigned int ConformerEnsemble<T>::getSlot(unsigned int id) const {
+    std::map<unsigned int,unsigned int>::const_iterator loc=d_slots.find(id);
+    if(loc==d_slots.end()){
+      std::ostringstream errout;
+      errout<<"Can't find conformation with ID: "<<id;
+      throw ConformerException(errout.str());
+    }
+    return loc->second;
+  }
+
+  template <typename T>
+  void ConformerEnsemble<T>::copyToConformer(unsigned int slot,Conformer &conf) const {
+    const T *coords=getCoords(slot);
+    conf.resize(d_numAtoms);
+    RDGeom::POINT3D_VECT &pts=conf.getPositions();
+    for(unsigned int i=0;i<d_numAtoms;++i){
+      pts[i].x=static_cast<double>(coords[3*i]);
+      pts[i].y=static_cast<double>(coords[3*i+1]);
+      pts[i].z=static_cast<double>(coords[3*i+2]);
+    }
+    conf.set3D(d_is3D[slot]);
+  }
+
+  template <typename T>
+  void ConformerEnsemble<T>::updateMol(ROMol &mol) const {
+    PRECONDITION(mol.getNumAtoms()==d_numAtoms,"Number of atom mismatch");
+    for(unsigned int slot=0;slot<d_ids.size();++slot){
+      Conformer *conf;
+      bool isNew=false;
+      try {
+        conf=&mol.getConformer(d_ids[slot]);
+      } catch (ConformerException &) {
+        conf=new Conformer(d_numAtoms);
+        conf->setId(d_ids[slot]);
+        isNew=true;
+      }
+      copyToConformer(slot,*conf);
+      if(isNew) mol.addConformer(conf,false);
+    }
+  }
+
+  template <typename T>
+  std::string ConformerEnsemble<T>::toBinary() const {
+    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+    streamWrite(ss,ensemblePickleVersion);
+    streamWrite(ss,static_cast<boost::int32_t>(sizeof(T)));
+    streamWrite(ss,static_cast<boost::uint32_t>(d_numAtoms));
+    streamWrite(ss,static_cast<boost::uint32_t>(d_ids.size()));
+    for(unsigned int i=0;i<d_ids.size();++i){
+      streamWrite(ss,static_cast<boost::uint32_t>(d_ids[i]));
+      streamWrite(ss,static_cast<char>(d_is3D[i]));
+    }
+    for(unsigned int i=0;i<d_coords.size();++i){
+      streamWrite(ss,d_coords[i]);
+    }
+    return ss.str();
+  }
+
+  template <typename T>
+  void ConformerEnsemble<T>::initFromBinary(const std::string &pickle){
+    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+    ss.write(pickle.c_str(),pickle.length());
+
+    boost::int32_t version,precision;
+    streamRead(ss,version);
+    if(!ss || version!=ensemblePickleVersion){
+      throw ConformerException("bad ConformerEnsemble pickle");
+    }
+    streamRead(ss,precision);
+    if(precision!=sizeof(float) && precision!=sizeof(double)){
+      throw ConformerException("bad ConformerEnsemble pickle");
+    }
+    boost::uint32_t numAtoms,numConfs;
+    streamRead(ss,numAtoms);
+    streamRead(ss,numConfs);
+    if(!ss){
+      throw ConformerException("bad ConformerEnsemble pickle");
+    }
+
+    // check the sizes against what is left of the pickle before
+    // allocating anything:
+    const size_t headerSize=2*sizeof(boost::int32_t)+2*sizeof(boost::uint32_t);
+    const size_t confSize=sizeof(boost::uint32_t)+sizeof(char);
+    size_t remaining=pickle.size()-headerSize;
+    if(numConfs>remaining/confSize){
+      throw ConformerException("bad ConformerEnsemble pickle");
+    }
+    remaining-=numConfs*confSize;
+    const size_t maxSize=std::numeric_limits<size_t>::max();
+    if(numAtoms>maxSize/3 || (numConfs && 3*size_t(numAtoms)>maxSize/numConfs)){
+      throw ConformerException("bad ConformerEnsemble pickle");
+    }
+    size_t numCoords=3*size_t(numAtoms)*numConfs;
+    if(numCoords>remaining/precision || numCoords*precision!=remaining){
+      throw ConformerException("bad ConformerEnsemble pickle");
+    }
+
+    // read into temporaries, so that we are unchanged if the
+    // pickle is bad:
+    std::vector<unsigned int> ids;
+    std::vector<bool> is3Ds;
+    std::map<unsigned int,unsigned int> slots;
+    ids.reserve(numConfs);
+    is3Ds.reserve(numConfs);
+    for(unsigned int i=0;i<numConfs;++i){
+      boost::uint32_t id;
+      char is3D;
+      streamRead(ss,id);
+      streamRead(ss,is3D);
+      if(!ss || slots.find(id)!=slots.end()){
+        throw ConformerException("bad ConformerEnsemble pickle");
+      }
+      slots[id]=i;
+      ids.push_back(id);
+      is3Ds.push_back(is3D);
+    }
+    std::vector<T> coords(numCoords);
+    if(precision==sizeof(float)){
+      readCoords<T,float>(ss,coords);
+    } else {
+      readCoords<T,double>(ss,coords);
+    }
+    if(!ss){
+      throw ConformerException("bad ConformerEnsemble pickle");
+    }
+
+    d_numAtoms=numAtoms;
+    d_coords.swap(coords);
+    d_ids.swap(ids);
+    d_is3D.swap(is3Ds);
+    d_slots.swap(slots);
+  }
+
+  template class ConformerEnsemble<float>;
+  template class ConformerEnsemble<double>;
+}
@@ -0,0 +1,145 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_CONFORMERENSEMBLE_H
+#define _RD_CONFORMERENSEMBLE_H
+
+#include <RDGeneral/Invariant.h>
+#include <GraphMol/Conformer.h>
+#include <vector>
+#include <map>
+#include <string>
+
+namespace RDKit {
+  class ROMol;
+
+  //! Contiguous storage for the coordinates of many conformations of a molecule
+  /*!
+    The coordinates of all conformations are kept in a single buffer laid
+    out as <tt>[nConformers][nAtoms][3]</tt>, so the coordinates of a
+    conformation are <tt>3*nAtoms</tt> consecutive values (x,y,z for the
+    first atom, then the second atom, etc.). Conformations are addressed
+    either by their slot (position in the buffer) or by their id, which
+    is looked up in a table.
+
+    \c T should be \c float or \c double.
+
+    This is meant for code that works on large numbers of conformations
+    at once (alignment, RMS calculations, shape comparisons): it uses
+    3*sizeof(T) bytes per atom instead of the 32 bytes of a Point3D, and
+    the pointers returned by getCoords() can be used directly without
+    copying.
+
+    <b>Notes:</b>
+      - pointers returned by getCoords() and getData() are invalidated
+        by addConformer()
+  */
+  template <typename T>
+  class ConformerEnsemble {
+  public:
+    //! construct an empty ensemble for molecules with \c numAtoms atoms
+    explicit ConformerEnsemble(unsigned int numAtoms=0) : d_numAtoms(numAtoms) {};
+
+    //! construct an ensemble holding copies of all of \c mol's conformations
+    explicit ConformerEnsemble(const ROMol &mol);
+
+    //! construct from a pickle (see toBinary())
+    explicit ConformerEnsemble(const std::string &pickle);
+
+    //! returns the number of atoms in each conformation
+    unsigned int getNumAtoms() const { return d_numAtoms; };
+    //! returns the number of conformations
+    unsigned int getNumConformers() const { return d_ids.size(); };
+
+    //! adds a copy of a conformation and returns its slot
+    /*!
+      \param conf - the conformation to add; its id is used.
+
+      An exception is thrown if a conformation with the same id
+      is already present.
+    */
+    unsigned int addConformer(const Conformer &conf);
+    //! adds a conformation and returns its slot
+    /*!
+      \param coords - 3*getNumAtoms() coordinates
+      \param id     - the id of the conformation
+      \param is3D   - whether or not the conformation is 3D
+
+      An exception is thrown if a conformation with the same id
+      is already present.
+    */
+    unsigned int addConformer(const T *coords,unsigned int id,bool is3D=true);
+
+    //! returns whether or not a conformation with this id is present
+    bool hasConformer(unsigned int id) const { return d_slots.find(id)!=d_slots.end(); };
+    //! returns the slot of the conformation with id \c id
+    /*!
+      A ConformerException is thrown if there is no such conformation.
+    */
+    unsigned int getSlot(unsigned int id) const;
+    //! returns the id of the conformation in slot \c slot
+    unsigned int getId(unsigned int slot) const {
+      RANGE_CHECK(0,slot,d_ids.size()-1);
+      return d_ids[slot];
+    };
+    //! returns whether or not the conformation in slot \c slot is 3D
+    bool is3D(unsigned int slot) const {
+      RANGE_CHECK(0,slot,d_is3D.size()-1);
+      return d_is3D[slot];
+    };
+
+    //! returns a pointer to the 3*getNumAtoms() coordinates in slot \c slot
+    const T *getCoords(unsigned int slot) const {
+      RANGE_CHECK(0,slot,d_ids.size()-1);
+      return &d_coords[slot*3*d_numAtoms];
+    };
+    //! \overload
+    T *getCoords(unsigned int slot) {
+      RANGE_CHECK(0,slot,d_ids.size()-1);
+      return &d_coords[slot*3*d_numAtoms];
+    };
+    //! returns the whole coordinate buffer
+    const std::vector<T> &getData() const { return d_coords; };
+
+    //! copies the coordinates in slot \c slot to a Conformer
+    /*!
+      \c conf is resized if needed; its id is not changed.
+    */
+    void copyToConformer(unsigned int slot,Conformer &conf) const;
+
+    //! copies the coordinates back to a molecule
+    /*!
+      Conformations of \c mol with the same ids as those in the
+      ensemble are updated, others are added.
+    */
+    void updateMol(ROMol &mol) const;
+
+    //! returns a binary string representation of the ensemble
+    /*!
+      The coordinates are stored with the precision of \c T.
+    */
+    std::string toBinary() const;
+    //! initializes from a binary string generated by toBinary()
+    /*!
+      Pickles of ConformerEnsemble<float> and ConformerEnsemble<double>
+      can be read by either class. A ConformerException is thrown if
+      the pickle can't be read.
+    */
+    void initFromBinary(const std::string &pickle);
+
+  private:
+    unsigned int d_numAtoms;
+    std::vector<T> d_coords;
+    std::vector<unsigned int> d_ids;
+    std::vector<bool> d_is3D;
+    std::map<unsigned int,unsigned int> d_slots;
+  };
+}
+
+#endif
@@ -10,6 +10,7 @@
 //
 #include <RDGeneral/types.h>
 #include <RDGeneral/utils.h>
+#include <RDGeneral/RDThreads.h>
 #include <GraphMol/RWMol.h>
 #include <math.h>
 #include <GraphMol/MolOps.h>
@@ -1216,26 +1217,38 @@ namespace RDDepict {
     } else {
       ddata = 0;
     }
-    unsigned int na = dp_mol->getNumAtoms(); 
-    unsigned int dsize = na*(na-1)/2;
-    double *ddata2D = new double[dsize];
-    DOUBLE_SMART_PTR dmat2D(ddata2D);
-    this->computeDistMat(dmat2D);
+    // the distances are computed on the fly (in the same order as
+    // computeDistMat() stores them) instead of filling a temporary matrix
+    std::vector<unsigned int> aids;
+    std::vector<RDGeom::Point2D> locs;
+    aids.reserve(d_eatoms.size());
+    locs.reserve(d_eatoms.size());
+    for (INT_EATOM_MAP_CI efi = d_eatoms.begin(); efi != d_eatoms.end(); ++efi) {
+      aids.push_back(efi->first);
+      locs.push_back(efi->second.loc);
+    }
     double res1 = 0.0;
     double res2 = 0.0;
     double d, d2, dd;
+    RDGeom::Point2D pti, ptj;
 
-    for (unsigned int i = 0; i < dsize; ++i) {
-      d = ddata2D[i];
-      d2 = d*d;
-      if (d2 > 1.e-3){
-        res1 += 1.0/d2;
-      } else {
-        res1 += 1000.0;
-      }
-      if ((ddata) && (ddata[i] >= 0.0)) {
-        dd = d - ddata[i];
-        res2 += dd*dd;
+    for (unsigned int i = 1; i < aids.size(); ++i) {
+      pti = locs[i];
+      unsigned int offset = aids[i]*(aids[i]-1)/2;
+      for (unsigned int j = 0; j < i; ++j) {
+        ptj = locs[j];
+        ptj -= pti;
+        d = ptj.length();
+        d2 = d*d;
+        if (d2 > 1.e-3){
+          res1 += 1.0/d2;
+        } else {
+          res1 += 1000.0;
+        }
+        if ((ddata) && (ddata[offset + aids[j]] >= 0.0)) {
+          dd = d - ddata[offset + aids[j]];
+          res2 += dd*dd;
+        }
       }
     }
     
@@ -1291,10 +1304,68 @@ namespace RDDepict {
     }
   }
 
+  namespace {
+    // the moves available to randomSampleFlipsAndPermutations() and the
+    // (pre-drawn) random choices for each of the samples
+    struct SampleMoves {
+      RDKit::INT_VECT rotBonds;
+      RDKit::INT_VECT deg4nodes;
+      RDKit::VECT_INT_VECT deg4NbrBids, deg4NbrAids;
+      unsigned int nPerSample;
+      RDKit::INT_VECT moves;    // nPerSample entries per sample
+      RDKit::INT_VECT permutes; // which bond pair to use for deg 4 permutations
+    };
+
+    void applySampleMoves(EmbeddedFrag &frag, const RDKit::ROMol *mol,
+                          const SampleMoves &sm, unsigned int si) {
+      unsigned int nb = sm.rotBonds.size();
+      for (unsigned int fi = si*sm.nPerSample; fi < (si+1)*sm.nPerSample; ++fi) {
+        unsigned int ri = sm.moves[fi];
+        // if ri is less than the number of rotatable bonds (nb), we will flip a rot bond
+        if (ri < nb) {
+          frag.flipAboutBond(sm.rotBonds[ri]);
+        } else { // ri is >= nb we permute the bonds at a deg 4 node
+          unsigned int d4i = ri - nb; // so we will permute at the 'di'th degree 4 node
+          unsigned int ai = sm.deg4nodes[d4i];
+          // collect the locations for the neighbors
+          const INT_EATOM_MAP &eatoms = frag.GetEmbeddedAtoms();
+          VECT_C_POINT nbrLocs;
+          for (RDKit::INT_VECT_CI aci = sm.deg4NbrAids[d4i].begin();
+               aci != sm.deg4NbrAids[d4i].end(); aci++) {
+            nbrLocs.push_back(&(eatoms.find(*aci)->second.loc));
+          }
+          INT_PAIR_VECT bndPairs = findBondsPairsToPermuteDeg4(eatoms.find(ai)->second.loc,
+                                                               sm.deg4NbrBids[d4i], nbrLocs);
+          unsigned int fbi = sm.permutes[fi];
+          unsigned int aid1, aid2;
+          aid1 = mol->getBondWithIdx(bndPairs[fbi].first)->getOtherAtomIdx(ai);
+          aid2 = mol->getBondWithIdx(bndPairs[fbi].second)->getOtherAtomIdx(ai);
+          frag.permuteBonds(ai, aid1, aid2);
+        }
+      }
+    }
+
+    // the moves are applied cumulatively, so each worker replays all of
+    // them on its own copy of the fragment but only scores every
+    // stride'th sample
+    void scoreSamples(EmbeddedFrag frag, const RDKit::ROMol *mol,
+                      const SampleMoves *sm, const DOUBLE_SMART_PTR *dmat,
+                      double mimicDmatWt, unsigned int start, unsigned int stride,
+                      std::vector<double> *densities) {
+      for (unsigned int si = 0; si < densities->size(); ++si) {
+        applySampleMoves(frag, mol, *sm, si);
+        if (si % stride == start) {
+          (*densities)[si] = frag.mimicDistMatAndDensityCostFunc(dmat, mimicDmatWt);
+        }
+      }
+    }
+  }
+
   void EmbeddedFrag::randomSampleFlipsAndPermutations(unsigned int nBondsPerSample,
                                                       unsigned int nSamples, int seed, 
                                                       const DOUBLE_SMART_PTR *dmat, 
-                                                      double mimicDmatWt, bool permuteDeg4Nodes) {
+                                                      double mimicDmatWt, bool permuteDeg4Nodes,
+                                                      int numThreads) {
     PRECONDITION(dp_mol, "");
 
     RDKit::rng_type &generator = RDKit::getRandomGenerator();
@@ -1302,16 +1373,15 @@ namespace RDDepict {
       generator.seed(seed);
     }
 
-    RDKit::INT_VECT rotBonds = getAllRotatableBonds(*dp_mol);
+    SampleMoves sm;
+    sm.rotBonds = getAllRotatableBonds(*dp_mol);
 
-    unsigned int nb = rotBonds.size(); // number of rotatable bonds that can be flipped
+    unsigned int nb = sm.rotBonds.size(); // number of rotatable bonds that can be flipped
 
     // if we also want to permute deg 4 nodes, find out how many of these are 
     // around and can be permuted
     unsigned int nt, nd4;
     nd4 = 0;
-    RDKit::INT_VECT deg4nodes;
-    RDKit::VECT_INT_VECT deg4NbrBids, deg4NbrAids;
     
     if (permuteDeg4Nodes) {
       for (RDKit::ROMol::ConstAtomIterator ai = dp_mol->beginAtoms(); ai != dp_mol->endAtoms(); ai++) {
@@ -1327,168 +1397,201 @@ namespace RDDepict {
             }
           }
           if (allin) {
-            deg4nodes.push_back(caid);
-            deg4NbrBids.push_back(bids);
-            deg4NbrAids.push_back(aids);
+            sm.deg4nodes.push_back(caid);
+            sm.deg4NbrBids.push_back(bids);
+            sm.deg4NbrAids.push_back(aids);
           }
         }
       }
-      nd4 = deg4nodes.size();
+      nd4 = sm.deg4nodes.size();
     }
 
     nt = nb + nd4;
 
-    unsigned int nPerSample = std::min(nt, nBondsPerSample);
+    sm.nPerSample = std::min(nt, nBondsPerSample);
 
     RDKit::uniform_int dist(0, nt-1);
     RDKit::int_source_type intRandomSrc(generator, dist);
 
-    unsigned int si, fi, bi, ai;
-    RDGeom::INT_POINT2D_MAP bestCrdMap;
-    double bestDens = this->mimicDistMatAndDensityCostFunc(dmat, mimicDmatWt); 
-    INT_EATOM_MAP_I efi;
-    for (efi = d_eatoms.begin(); efi != d_eatoms.end(); efi++) {
-      bestCrdMap[efi->first] = efi->second.loc;
+    // draw the random numbers for all samples up front (and in the
+    // same order as they are used), so the result does not depend on
+    // the number of threads
+    sm.moves.resize(nSamples*sm.nPerSample);
+    sm.permutes.resize(nSamples*sm.nPerSample, 0);
+    for (unsigned int fi = 0; fi < sm.moves.size(); ++fi) {
+      sm.moves[fi] = intRandomSrc();
+      if (static_cast<unsigned int>(sm.moves[fi]) >= nb) {
+        double rval = RDKit::getRandomVal();
+        if (rval > 0.5) {
+          sm.permutes[fi] = 1;
+        }
+      }
     }
-    for (si = 0; si < nSamples; ++si) {
-      // randomly pick nPerSample bonds and flip them 
-      for (fi = 0; fi < nPerSample; ++fi) {
-        unsigned int ri = intRandomSrc();
-        // if ri is less than the number of rotatable bonds (nb), we will flip a rot bond
-        if (ri < nb) {
-          bi = rotBonds[ri];
-          this->flipAboutBond(bi);
 
-        } else { // ri is >= nb we permute the bonds at a deg 4 node
-          unsigned int d4i = ri - nb; // so we will permute at the 'di'th degree 4 node
-          ai = deg4nodes[d4i];
-          // collect the locations for the neighbors
-          VECT_C_POINT nbrLocs;
-          for (RDKit::INT_VECT_CI aci = deg4NbrAids[d4i].begin();
-               aci != deg4NbrAids[d4i].end(); aci++) {
-            nbrLocs.push_back(&(d_eatoms[*aci].loc));
-          }
-          INT_PAIR_VECT bndPairs = findBondsPairsToPermuteDeg4(d_eatoms[ai].loc, deg4NbrBids[d4i], nbrLocs);
-          
-          double rval = RDKit::getRandomVal();
-          unsigned int fbi = 0;
-          if (rval > 0.5) {
-            fbi = 1;
-          }
-          unsigned int aid1, aid2;
-          aid1 = dp_mol->getBondWithIdx(bndPairs[fbi].first)->getOtherAtomIdx(ai);
-          aid2 = dp_mol->getBondWithIdx(bndPairs[fbi].second)->getOtherAtomIdx(ai);
-          this->permuteBonds(ai, aid1, aid2);
-        }
+    // score the samples:
+    std::vector<double> densities(nSamples, 0.0);
+    unsigned int nThreads = std::min(nSamples, RDKit::getNumThreadsToUse(numThreads));
+#ifdef RDK_THREADSAFE_SSS
+    if (nThreads > 1) {
+      boost::thread_group tg;
+      for (unsigned int ti = 0; ti < nThreads; ++ti) {
+        tg.add_thread(new boost::thread(scoreSamples, *this, dp_mol, &sm, dmat,
+                                        mimicDmatWt, ti, nThreads, &densities));
       }
-      
-      // compute the density of the stucture and check if it improved
-      double density = this->mimicDistMatAndDensityCostFunc(dmat, mimicDmatWt);
+      tg.join_all();
+    } else
+#endif
+    if (nSamples) {
+      scoreSamples(*this, dp_mol, &sm, dmat, mimicDmatWt, 0, 1, &densities);
+    }
+
+    // and pick the best one
+    double bestDens = this->mimicDistMatAndDensityCostFunc(dmat, mimicDmatWt); 
+    unsigned int nBestSamples = 0;
+    for (unsigned int si = 0; si < nSamples; ++si) {
+      double density = densities[si];
       //if (density < bestDens) {
       if (bestDens-density>1e-4){
         bestDens = density;
-        for (efi = d_eatoms.begin(); efi != d_eatoms.end(); efi++) {
-          bestCrdMap[efi->first] = efi->second.loc;
-        }
+        nBestSamples = si + 1;
       }
     }
-    // now copy the best coordinates to the fragment
-    for (efi = d_eatoms.begin(); efi != d_eatoms.end(); efi++) {
-      efi->second.loc = bestCrdMap[efi->first];
+    // now move the fragment to the best coordinates
+    for (unsigned int si = 0; si < nBestSamples; ++si) {
+      applySampleMoves(*this, dp_mol, sm, si);
     }
   }
 
   std::vector<PAIR_I_I> EmbeddedFrag::findCollisions(const double *dmat,
                                                      bool includeBonds) {
     // find a pair of atoms that are too close to each other
-    INT_EATOM_MAP_I efi, efj, tempi;
-    RDGeom::Point2D pti, ptj;
-    double d2;
+    INT_EATOM_MAP_I efi;
     std::vector<PAIR_I_I> res;
-    for (efi = d_eatoms.begin(); efi != d_eatoms.end(); ++efi) {
-      efi->second.d_density = 0.0;
-    }
 
-    tempi = d_eatoms.begin();
-    ++tempi;
-    double colThres2 = COLLISION_THRES*COLLISION_THRES;
+    // work on flat copies of the atom data, the map lookups in the
+    // inner loop get expensive for large molecules
+    unsigned int nAts = d_eatoms.size();
+    std::vector<unsigned int> aids;
+    std::vector<RDGeom::Point2D> locs;
+    std::vector<double> typeFactors;
+    aids.reserve(nAts);
+    locs.reserve(nAts);
+    typeFactors.reserve(nAts);
     // if we a re dealing with non carbon atoms we will increase the collision threshold.
     // This is because only hetero atoms are typically drawn in a depiction.
-    double atomTypeFactor1, atomTypeFactor2;
-    for (efi = tempi; efi != d_eatoms.end(); efi++) {
-      pti = efi->second.loc;
-      atomTypeFactor1 = 1.0;
+    for (efi = d_eatoms.begin(); efi != d_eatoms.end(); ++efi) {
+      aids.push_back(efi->first);
+      locs.push_back(efi->second.loc);
       if (dp_mol->getAtomWithIdx(efi->first)->getAtomicNum() != 6) {
-        atomTypeFactor1 = HETEROATOM_COLL_SCALE;
+        typeFactors.push_back(HETEROATOM_COLL_SCALE);
+      } else {
+        typeFactors.push_back(1.0);
       }
-      for (efj = d_eatoms.begin(); efj != efi; efj++) {
-        if (efj == efi) {
-          continue;
-        }
-        atomTypeFactor2 = 1.0;
-        if (dp_mol->getAtomWithIdx(efj->first)->getAtomicNum() != 6) {
-          atomTypeFactor2 = HETEROATOM_COLL_SCALE;
-        }
-        ptj = efj->second.loc;
+    }
+    std::vector<double> densities(nAts, 0.0);
+
+    double colThres2 = COLLISION_THRES*COLLISION_THRES;
+    RDGeom::Point2D pti, ptj;
+    double d2;
+    for (unsigned int i = 1; i < nAts; ++i) {
+      pti = locs[i];
+      for (unsigned int j = 0; j < i; ++j) {
+        ptj = locs[j];
         ptj -= pti;
         d2 = ptj.lengthSq();
         if (d2 > 1.0e-3) {
-          efi->second.d_density += (1/d2);
-          efj->second.d_density += (1/d2);
+          densities[i] += (1/d2);
+          densities[j] += (1/d2);
         } else {
-          efi->second.d_density += 1000.0;
-          efj->second.d_density += 1000.0;
+          densities[i] += 1000.0;
+          densities[j] += 1000.0;
         }
-        d2 /= (atomTypeFactor1*atomTypeFactor2);
-        //std::cerr<<" "<<efi->first<<"-"<<efj->first<<": "<<d2<<" "<<colThres2<<std::endl;
+        d2 /= (typeFactors[i]*typeFactors[j]);
+        //std::cerr<<" "<<aids[i]<<"-"<<aids[j]<<": "<<d2<<" "<<colThres2<<std::endl;
         if (d2 < colThres2) {
-          PAIR_I_I cAids(efi->first, efj->first);
+          PAIR_I_I cAids(aids[i], aids[j]);
           res.push_back(cAids);
         }
       }
     }
+    unsigned int i = 0;
+    for (efi = d_eatoms.begin(); efi != d_eatoms.end(); ++efi, ++i) {
+      efi->second.d_density = densities[i];
+    }
+
     if (includeBonds) {
-      // now find bond collisions
-      RDKit::ROMol::ConstBondIterator bi1, bi2;
-      unsigned int bid1, bid2;
-      unsigned int beg1, end1, beg2, end2;
-      RDGeom::Point2D avg1, avg2, v1, v2, v3;
+      // now find bond collisions. Two bonds can only collide if their
+      // centers are closer than sqrt(0.5), so the bonds are binned on
+      // a grid of their centers and only neighboring cells are checked.
       double BOND_THRES2 = BOND_THRES*BOND_THRES;
+      const double cellSize = 1.0;
+      std::vector<const RDKit::Bond *> bonds;
+      std::vector<RDGeom::Point2D> centers;
+      std::vector<std::pair<PAIR_I_I, unsigned int> > grid;
+      RDKit::ROMol::ConstBondIterator bi;
+      for (bi = dp_mol->beginBonds(); bi != dp_mol->endBonds(); bi++) {
+        unsigned int beg = (*bi)->getBeginAtomIdx();
+        unsigned int end = (*bi)->getEndAtomIdx();
+        if ((d_eatoms.find(beg) != d_eatoms.end()) &&
+            (d_eatoms.find(end) != d_eatoms.end())) {
+          RDGeom::Point2D avg = d_eatoms[end].loc + d_eatoms[beg].loc;
+          avg *= 0.5;
+          PAIR_I_I cell(static_cast<int>(floor(avg.x/cellSize)),
+                        static_cast<int>(floor(avg.y/cellSize)));
+          grid.push_back(std::make_pair(cell, static_cast<unsigned int>(bonds.size())));
+          bonds.push_back(*bi);
+          centers.push_back(avg);
+        }
+      }
+      std::sort(grid.begin(), grid.end());
+
+      unsigned int beg1, end1, beg2, end2;
+      RDGeom::Point2D avg2, v1, v2, v3;
       double valProd;
-      for (bi1 = dp_mol->beginBonds(); bi1 != dp_mol->endBonds(); bi1++) {
-        bid1 = (*bi1)->getIdx();
-        beg1 = (*bi1)->getBeginAtomIdx();
-        end1 = (*bi1)->getEndAtomIdx();
-        if ((d_eatoms.find(beg1) != d_eatoms.end()) &&
-            (d_eatoms.find(end1) != d_eatoms.end())) {
-          v1 = d_eatoms[end1].loc - d_eatoms[beg1].loc;
-          avg1 = d_eatoms[end1].loc + d_eatoms[beg1].loc;
-          avg1 *= 0.5;
-          for (bi2 = dp_mol->beginBonds(); bi2 != dp_mol->endBonds(); bi2++) {
-            bid2 = (*bi2)->getIdx();
-            if (bid2 <= bid1) {
-              continue;
-            }
-            
-            beg2 = (*bi2)->getBeginAtomIdx();
-            end2 = (*bi2)->getEndAtomIdx();
-            if ((d_eatoms.find(beg2) != d_eatoms.end()) && 
-                (d_eatoms.find(end2) != d_eatoms.end())) {
-              avg2 = d_eatoms[end2].loc + d_eatoms[beg2].loc;
-              avg2 *= 0.5;
-              avg2 -= avg1;
-              if(avg2.lengthSq()<0.5 &&
-                 avg2.lengthSq() < BOND_THRES2) {
-                v2 = d_eatoms[beg2].loc - d_eatoms[beg1].loc;
-                v3 = d_eatoms[end2].loc - d_eatoms[beg1].loc;
-                valProd = _crossVal(v1, v2)*_crossVal(v1,v3);
-                if (valProd < -1e-6) {
-                  // we have a collision, find the closest two atoms
-                  PAIR_I_I cAids = _findClosestPair(beg1, end1, beg2, end2,
-                                                    *dp_mol, dmat);
-                  res.push_back(cAids);
-                }
+      std::vector<unsigned int> nbrs;
+      for (unsigned int b1 = 0; b1 < bonds.size(); ++b1) {
+        unsigned int bid1 = bonds[b1]->getIdx();
+        beg1 = bonds[b1]->getBeginAtomIdx();
+        end1 = bonds[b1]->getEndAtomIdx();
+        v1 = d_eatoms[end1].loc - d_eatoms[beg1].loc;
+        const RDGeom::Point2D &avg1 = centers[b1];
+
+        // collect the candidates in the neighboring cells, in the order
+        // the bonds are visited:
+        nbrs.clear();
+        int cx = static_cast<int>(floor(avg1.x/cellSize));
+        int cy = static_cast<int>(floor(avg1.y/cellSize));
+        for (int dx = -1; dx <= 1; ++dx) {
+          for (int dy = -1; dy <= 1; ++dy) {
+            std::pair<PAIR_I_I, unsigned int> key(PAIR_I_I(cx+dx, cy+dy), 0);
+            std::vector<std::pair<PAIR_I_I, unsigned int> >::const_iterator gi =
+              std::lower_bound(grid.begin(), grid.end(), key);
+            while (gi != grid.end() && gi->first == key.first) {
+              if (bonds[gi->second]->getIdx() > bid1) {
+                nbrs.push_back(gi->second);
               }
+              ++gi;
+            }
+          }
+        }
+        std::sort(nbrs.begin(), nbrs.end());
+
+        for (std::vector<unsigned int>::const_iterator b2 = nbrs.begin();
+             b2 != nbrs.end(); ++b2) {
+          beg2 = bonds[*b2]->getBeginAtomIdx();
+          end2 = bonds[*b2]->getEndAtomIdx();
+          avg2 = centers[*b2];
+          avg2 -= avg1;
+          if(avg2.lengthSq()<0.5 &&
+             avg2.lengthSq() < BOND_THRES2) {
+            v2 = d_eatoms[beg2].loc - d_eatoms[beg1].loc;
+            v3 = d_eatoms[end2].loc - d_eatoms[beg1].loc;
+            valProd = _crossVal(v1, v2)*_crossVal(v1,v3);
+            if (valProd < -1e-6) {
+              // we have a collision, find the closest two atoms
+              PAIR_I_I cAids = _findClosestPair(beg1, end1, beg2, end2,
+                                                *dp_mol, dmat);
+              res.push_back(cAids);
             }
           }
         }
@@ -1593,10 +1696,12 @@ namespace RDDepict {
       endSideFlip = false;
     }
 
+    std::vector<bool> onEndSide(dp_mol->getNumAtoms(), false);
+    for (RDKit::INT_VECT_CI fii = endSideAids.begin(); fii != endSideAids.end(); ++fii) {
+      onEndSide[*fii] = true;
+    }
     for (INT_EATOM_MAP_I efi = d_eatoms.begin(); efi != d_eatoms.end(); efi++) {
-      RDKit::INT_VECT_CI fii = std::find(endSideAids.begin(), endSideAids.end(),
-                                         static_cast<int>(efi->first));
-      if (endSideFlip ^ (fii == endSideAids.end()) ) {
+      if (endSideFlip ^ (!onEndSide[efi->first])) {
         efi->second.Reflect(begLoc, endLoc);
       }
     }
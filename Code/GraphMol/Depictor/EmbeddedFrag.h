@@ -315,11 +315,19 @@ namespace RDDepict {
 
     void permuteBonds(unsigned int aid, unsigned int aid1, unsigned int aid2);
 
+    //! \brief randomly flip rotatable bonds (and permute degree 4 nodes) to
+    //!  find a layout with a lower density
+    /*!
+      The samples are scored on \c numThreads threads (values <= 0 are
+      relative to the number of available hardware threads). The result
+      does not depend on the number of threads.
+    */
     void randomSampleFlipsAndPermutations(unsigned int nBondsPerSample=3,
                                           unsigned int nSamples=100, int seed=100,
                                           const DOUBLE_SMART_PTR *dmat=0, 
                                           double mimicDmatWt=0.0,
-                                          bool permuteDeg4Nodes=false);
+                                          bool permuteDeg4Nodes=false,
+                                          int numThreads=1);
 
     //! Remove collisions in a structure by flipping rotable bonds 
     //! along the shortest path between two colliding atoms
@@ -290,7 +290,8 @@ namespace RDDepict {
                                bool canonOrient, bool clearConfs,
                                unsigned int nFlipsPerSample,
                                unsigned int nSamples,
-                               int sampleSeed, bool permuteDeg4Nodes) {
+                               int sampleSeed, bool permuteDeg4Nodes,
+                               int numThreads) {
     
     // storage for pieces of a molecule/s that are embedded in 2D
     std::list<EmbeddedFrag> efrags;
@@ -305,7 +306,7 @@ namespace RDDepict {
       if ((nSamples > 0) && (nFlipsPerSample > 0)) {
         eri->randomSampleFlipsAndPermutations(nFlipsPerSample, nSamples,
                                               sampleSeed, 0, 0.0,
-                                              permuteDeg4Nodes);
+                                              permuteDeg4Nodes, numThreads);
       } else {
         eri->removeCollisionsBondFlip();
       }
@@ -398,7 +399,8 @@ namespace RDDepict {
                                            unsigned int nFlipsPerSample,
                                            unsigned int nSamples,
                                            int sampleSeed,
-                                           bool permuteDeg4Nodes){
+                                           bool permuteDeg4Nodes,
+                                           int numThreads){
     // storage for pieces of a molecule/s that are embedded in 2D
     std::list<EmbeddedFrag> efrags;
     computeInitialCoords(mol, 0, efrags);
@@ -408,7 +410,8 @@ namespace RDDepict {
     std::list<EmbeddedFrag>::iterator eri;
     for (eri = efrags.begin(); eri != efrags.end(); eri++) {
       eri->randomSampleFlipsAndPermutations(nFlipsPerSample, nSamples, sampleSeed, dmat, 
-                                            weightDistMat, permuteDeg4Nodes);
+                                            weightDistMat, permuteDeg4Nodes,
+                                            numThreads);
     }
     if (canonOrient && efrags.size()) {
       // canonicalize the orientation of the fragment so that the
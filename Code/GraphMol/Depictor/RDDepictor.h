@@ -49,6 +49,10 @@ namespace RDDepict {
     \param permuteDeg4Nodes - try permuting the drawing order of bonds around
           atoms with four neighbors in order to improve the depiction
 
+    \param numThreads - the number of threads used to score the samples;
+          values <= 0 are relative to the number of available hardware
+          threads. The coordinates do not depend on this.
+
     \return ID of the conformation added to the molecule cotaining the
     2D coordinates
 
@@ -60,7 +64,8 @@ namespace RDDepict {
                                unsigned int nFlipsPerSample=0,
                                unsigned int nSamples=0,
                                int sampleSeed=0,
-                               bool permuteDeg4Nodes=false);
+                               bool permuteDeg4Nodes=false,
+                               int numThreads=1);
 
   //! \brief Compute the 2D coordinates such the interatom distances
   //   mimic those in a distance matrix
@@ -106,6 +111,10 @@ namespace RDDepict {
     \param permuteDeg4Nodes - try permuting the drawing order of bonds around
           atoms with four neighbors in order to improve the depiction
 
+    \param numThreads - the number of threads used to score the samples;
+          values <= 0 are relative to the number of available hardware
+          threads. The coordinates do not depend on this.
+
     \return ID of the conformation added to the molecule cotaining the
     2D coordinates
 
@@ -119,7 +128,8 @@ namespace RDDepict {
                                            unsigned int nFlipsPerSample=3,
                                            unsigned int nSamples=100,
                                            int sampleSeed=25,
-                                           bool permuteDeg4Nodes=true);
+                                           bool permuteDeg4Nodes=true,
+                                           int numThreads=1);
 };
 
 #endif
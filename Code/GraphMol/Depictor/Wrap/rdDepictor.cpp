@@ -30,7 +30,8 @@ namespace RDDepict {
 			       unsigned int nSamples=100,
                                int sampleSeed=100,
 			       bool permuteDeg4Nodes=false,
-			       double bondLength=-1.0){
+			       double bondLength=-1.0,
+                               int numThreads=1){
     RDGeom::INT_POINT2D_MAP cMap;
     cMap.clear();
     python::list ks = coordMap.keys();
@@ -50,7 +51,7 @@ namespace RDDepict {
     unsigned int res;
     res=RDDepict::compute2DCoords(mol,&cMap,canonOrient, clearConfs,
 				     nFlipsPerSample,nSamples,
-				     sampleSeed, permuteDeg4Nodes);
+				     sampleSeed, permuteDeg4Nodes, numThreads);
     if(bondLength>0){
       RDDepict::BOND_LEN=oBondLen;
     }
@@ -66,7 +67,8 @@ namespace RDDepict {
 					   unsigned int nSamples,
                                            int sampleSeed,
 					   bool permuteDeg4Nodes,
-					   double bondLength=-1.0) {
+					   double bondLength=-1.0,
+                                           int numThreads=1) {
     PyObject *distMatPtr = distMat.ptr();
     if(!PyArray_Check(distMatPtr)){
       throw_value_error("Argument isn't an array");
@@ -96,7 +98,7 @@ namespace RDDepict {
 					      canonOrient, clearConfs,
 					      weightDistMat,
 					      nFlipsPerSample, nSamples,
-					      sampleSeed, permuteDeg4Nodes);
+					      sampleSeed, permuteDeg4Nodes, numThreads);
     if(bondLength>0){
       RDDepict::BOND_LEN=oBondLen;
     }
@@ -133,7 +135,10 @@ BOOST_PYTHON_MODULE(rdDepictor)
      sampleSeed - seed for the random sampling process.\n\
      permuteDeg4Nodes - allow permutation of bonds at a degree 4\n\
                  node during the sampling process \n\
-     bondLength - change the default bond length for depiction \n\n\
+     bondLength - change the default bond length for depiction \n\
+     numThreads - the number of threads used to score the random\n\
+                 samples; values <= 0 are relative to the number of\n\
+                 available hardware threads. \n\n\
   RETURNS: \n\n\
      ID of the conformation added to the molecule\n";
   python::def("Compute2DCoords", RDDepict::Compute2DCoords,
@@ -145,7 +150,8 @@ BOOST_PYTHON_MODULE(rdDepictor)
                python::arg("nSample")=0,
                python::arg("sampleSeed")=0,
                python::arg("permuteDeg4Nodes")=false,
-               python::arg("bondLength")=-1.0),
+               python::arg("bondLength")=-1.0,
+               python::arg("numThreads")=1),
 	      docString.c_str());
 
   docString = "Compute 2D coordinates for a molecule such \n\
@@ -170,7 +176,10 @@ BOOST_PYTHON_MODULE(rdDepictor)
      sampleSeed - seed for the random sampling process.\n\
      permuteDeg4Nodes - allow permutation of bonds at a degree 4\n\
                  node during the sampling process \n\
-     bondLength - change the default bond length for depiction \n\n\
+     bondLength - change the default bond length for depiction \n\
+     numThreads - the number of threads used to score the random\n\
+                 samples; values <= 0 are relative to the number of\n\
+                 available hardware threads. \n\n\
   RETURNS: \n\n\
      ID of the conformation added to the molecule\n";
   python::def("Compute2DCoordsMimicDistmat", RDDepict::Compute2DCoordsMimicDistmat,
@@ -183,6 +192,7 @@ BOOST_PYTHON_MODULE(rdDepictor)
                python::arg("nSample")=100,
                python::arg("sampleSeed")=100,
                python::arg("permuteDeg4Nodes")=true,
-               python::arg("bondLength")=-1.0),
+               python::arg("bondLength")=-1.0,
+               python::arg("numThreads")=1),
 	      docString.c_str());
 }
@@ -741,6 +741,41 @@ void testGitHubIssue78() {
   }
 }
 
+void testSamplingThreads() {
+  // the coordinates from the random sampling should not depend on the
+  // number of threads used to score the samples
+  std::string smi = "CC(C)C[C@H](NC(=O)[C@H](Cc1ccccc1)NC(=O)[C@H](CCCNC(N)=N)NC(=O)CN)C(=O)N[C@@H](CCSC)C(=O)N[C@@H](C(C)C)C(O)=O";
+  RWMol *m = SmilesToMol(smi);
+  TEST_ASSERT(m);
+  unsigned int nat = m->getNumAtoms();
+  RDDepict::DOUBLE_SMART_PTR dmat(new double[nat*(nat-1)/2]);
+  for (unsigned int i = 0; i < nat*(nat-1)/2; ++i) {
+    dmat[i] = 1.5 + (i % 5);
+  }
+  unsigned int cid1 = RDDepict::compute2DCoords(*m, 0, true, false, 3, 100, 23, true, 1);
+  unsigned int cid2 = RDDepict::compute2DCoordsMimicDistMat(*m, &dmat, true, false, 0.5,
+                                                            3, 100, 25, true, 1);
+#ifdef RDK_TEST_MULTITHREADED
+  int numThreads = 4;
+#else
+  int numThreads = 1;
+#endif
+  unsigned int cid3 = RDDepict::compute2DCoords(*m, 0, true, false, 3, 100, 23, true, numThreads);
+  unsigned int cid4 = RDDepict::compute2DCoordsMimicDistMat(*m, &dmat, true, false, 0.5,
+                                                            3, 100, 25, true, numThreads);
+  const Conformer &conf1 = m->getConformer(cid1);
+  const Conformer &conf2 = m->getConformer(cid2);
+  const Conformer &conf3 = m->getConformer(cid3);
+  const Conformer &conf4 = m->getConformer(cid4);
+  for (unsigned int i = 0; i < nat; ++i) {
+    TEST_ASSERT(conf1.getAtomPos(i).x == conf3.getAtomPos(i).x);
+    TEST_ASSERT(conf1.getAtomPos(i).y == conf3.getAtomPos(i).y);
+    TEST_ASSERT(conf2.getAtomPos(i).x == conf4.getAtomPos(i).x);
+    TEST_ASSERT(conf2.getAtomPos(i).y == conf4.getAtomPos(i).y);
+  }
+  delete m;
+}
+
 int main() { 
   RDLog::InitLogs();
 #if 1
@@ -855,6 +890,11 @@ int main() {
   testGitHubIssue78();
   BOOST_LOG(rdInfoLog)<< "***********************************************************\n";
 
+  BOOST_LOG(rdInfoLog)<< "***********************************************************\n";
+  BOOST_LOG(rdInfoLog)<< "   Test threaded random sampling\n";
+  testSamplingThreads();
+  BOOST_LOG(rdInfoLog)<< "***********************************************************\n";
+
 
   return(0);
 }
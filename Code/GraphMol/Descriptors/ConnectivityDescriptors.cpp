@@ -66,6 +66,59 @@ namespace RDKit{
         mol.setProp("_connectivityNVals",nVs,true);
       }
 
+      double chiN(const PATH_LIST &ps,const std::vector<double> &vals){
+        double res=0.0;
+        BOOST_FOREACH(const PATH_TYPE &p,ps){
+          double accum=1.0;
+          BOOST_FOREACH(int aidx,p){
+            accum*=vals[aidx];
+          }
+          res+=accum;
+        }
+        return res;
+      }
+
+      double chi1(const ROMol &mol,const std::vector<double> &vals){
+        double res=0.0;
+        ROMol::EDGE_ITER firstB,lastB;
+        boost::tie(firstB,lastB) = mol.getEdges();
+        while(firstB!=lastB){
+          BOND_SPTR bond = mol[*firstB];
+          res += vals[bond->getBeginAtomIdx()]*vals[bond->getEndAtomIdx()];
+          ++firstB;
+        }
+        return res;
+      }
+
+      double kappa1Helper(double P1,double A,double alpha){
+        double denom=P1+alpha;
+        double kappa=0.0;
+        if(denom){
+          kappa = (A+alpha)*(A+alpha-1)*(A+alpha-1)/(denom*denom);
+        }
+        return kappa;
+      }
+      double kappa2Helper(double P2,double A,double alpha){
+        double denom=(P2+alpha)*(P2+alpha);
+        double kappa=0.0;
+        if(denom){
+          kappa = (A+alpha-1)*(A+alpha-2)*(A+alpha-2)/denom;
+        }
+        return kappa;
+      }
+      double kappa3Helper(double P3,int A,double alpha){
+        double denom=(P3+alpha)*(P3+alpha);
+        double kappa=0.0;
+        if(denom){
+          if(A%2){
+            kappa = (A+alpha-1)*(A+alpha-3)*(A+alpha-3)/denom;
+          } else {
+            kappa = (A+alpha-2)*(A+alpha-3)*(A+alpha-3)/denom;
+          }
+        }
+        return kappa;
+      }
+
       double getAlpha(const Atom &atom,bool &found){
         double res=0.0;
         found=false;
@@ -168,30 +221,12 @@ namespace RDKit{
     double calcChiNv(const ROMol &mol,unsigned int n,bool force){
       std::vector<double> hkDs(mol.getNumAtoms());
       detail::hkDeltas(mol,hkDs,force);
-      PATH_LIST ps=findAllPathsOfLengthN(mol,n+1,false);
-      double res=0.0;
-      BOOST_FOREACH(PATH_TYPE p,ps){
-        double accum=1.0;
-        BOOST_FOREACH(int aidx,p){
-          accum*=hkDs[aidx];
-        }
-        res+=accum;
-      }
-      return res;
+      return detail::chiN(findAllPathsOfLengthN(mol,n+1,false),hkDs);
     }
     double calcChiNn(const ROMol &mol,unsigned int n,bool force){
       std::vector<double> nVs(mol.getNumAtoms());
       detail::nVals(mol,nVs,force);
-      PATH_LIST ps=findAllPathsOfLengthN(mol,n+1,false);
-      double res=0.0;
-      BOOST_FOREACH(PATH_TYPE p,ps){
-        double accum=1.0;
-        BOOST_FOREACH(int aidx,p){
-          accum*=nVs[aidx];
-        }
-        res+=accum;
-      }
-      return res;
+      return detail::chiN(findAllPathsOfLengthN(mol,n+1,false),nVs);
     }
     
     double calcChi0v(const ROMol &mol,bool force){
@@ -202,16 +237,7 @@ namespace RDKit{
     double calcChi1v(const ROMol &mol,bool force){
       std::vector<double> hkDs(mol.getNumAtoms());
       detail::hkDeltas(mol,hkDs,force);
-      
-      double res=0.0;
-      ROMol::EDGE_ITER firstB,lastB;
-      boost::tie(firstB,lastB) = mol.getEdges();
-      while(firstB!=lastB){
-        BOND_SPTR bond = mol[*firstB];
-        res += hkDs[bond->getBeginAtomIdx()]*hkDs[bond->getEndAtomIdx()];
-        ++firstB;
-      }
-      return res;
+      return detail::chi1(mol,hkDs);
     };
     double calcChi2v(const ROMol &mol,bool force){
       return calcChiNv(mol,2,force);
@@ -231,16 +257,7 @@ namespace RDKit{
     double calcChi1n(const ROMol &mol,bool force){
       std::vector<double> nVs(mol.getNumAtoms());
       detail::nVals(mol,nVs,force);
-      
-      double res=0.0;
-      ROMol::EDGE_ITER firstB,lastB;
-      boost::tie(firstB,lastB) = mol.getEdges();
-      while(firstB!=lastB){
-        BOND_SPTR bond = mol[*firstB];
-        res += nVs[bond->getBeginAtomIdx()]*nVs[bond->getEndAtomIdx()];
-        ++firstB;
-      }
-      return res;
+      return detail::chi1(mol,nVs);
     };
     double calcChi2n(const ROMol &mol,bool force){
       return calcChiNn(mol,2,force);
@@ -276,42 +293,11 @@ namespace RDKit{
       return alphaSum;
     };
 
-    namespace {
-      double kappa1Helper(double P1,double A,double alpha){
-        double denom=P1+alpha;
-        double kappa=0.0;
-        if(denom){
-          kappa = (A+alpha)*(A+alpha-1)*(A+alpha-1)/(denom*denom);
-        }
-        return kappa;
-      }
-      double kappa2Helper(double P2,double A,double alpha){
-        double denom=(P2+alpha)*(P2+alpha);
-        double kappa=0.0;
-        if(denom){
-          kappa = (A+alpha-1)*(A+alpha-2)*(A+alpha-2)/denom;
-        }
-        return kappa;
-      }
-      double kappa3Helper(double P3,int A,double alpha){
-        double denom=(P3+alpha)*(P3+alpha);
-        double kappa=0.0;
-        if(denom){
-          if(A%2){
-            kappa = (A+alpha-1)*(A+alpha-3)*(A+alpha-3)/denom;
-          } else {
-            kappa = (A+alpha-2)*(A+alpha-3)*(A+alpha-3)/denom;
-          }
-        }
-        return kappa;
-      }
-    } // end of anonymous namespace
-
     double calcKappa1(const ROMol &mol){
       double P1 = mol.getNumBonds();
       double A = mol.getNumHeavyAtoms();
       double alpha = calcHallKierAlpha(mol);
-      double kappa = kappa1Helper(P1,A,alpha);
+      double kappa = detail::kappa1Helper(P1,A,alpha);
       return kappa;
     }
     double calcKappa2(const ROMol &mol){
@@ -319,14 +305,14 @@ namespace RDKit{
       double P2 = ps.size();
       double A = mol.getNumHeavyAtoms();
       double alpha = calcHallKierAlpha(mol);
-      double kappa=kappa2Helper(P2,A,alpha);
+      double kappa=detail::kappa2Helper(P2,A,alpha);
       return kappa;
     }
     double calcKappa3(const ROMol &mol){
       double P3 = findAllPathsOfLengthN(mol,3).size();
       int A = mol.getNumHeavyAtoms();
       double alpha = calcHallKierAlpha(mol);
-      double kappa=kappa3Helper(P3,A,alpha);
+      double kappa=detail::kappa3Helper(P3,A,alpha);
       return kappa;
     }
   } // end of namespace Descriptors
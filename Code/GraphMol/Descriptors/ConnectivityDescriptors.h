@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include <boost/smart_ptr.hpp>
+#include <GraphMol/Subgraphs/Subgraphs.h>
 
 namespace RDKit {
   class ROMol;
@@ -166,6 +167,26 @@ namespace RDKit {
     double calcKappa3(const ROMol &mol);
     const std::string kappa3Version="1.1.0";
 
+    // the pieces the descriptors above are built from, these are also
+    // used by the DescriptorCalculator
+    namespace detail {
+      //! the Hall-Kier valence deltas (1/sqrt(delta)) of the atoms,
+      //! cached on the molecule
+      void hkDeltas(const ROMol &mol,std::vector<double> &deltas,bool force);
+      //! the simple deltas (1/sqrt(delta)) of the atoms, cached on the molecule
+      void nVals(const ROMol &mol,std::vector<double> &nVs,bool force);
+      //! sum over the paths of the product of the atomic values along each path
+      double chiN(const PATH_LIST &ps,const std::vector<double> &vals);
+      //! sum over the bonds of the product of the atomic values of the two ends
+      double chi1(const ROMol &mol,const std::vector<double> &vals);
+      //! kappa1 from the number of bonds, heavy atoms and the Hall-Kier alpha
+      double kappa1Helper(double P1,double A,double alpha);
+      //! kappa2 from the number of two-bond paths, heavy atoms and the Hall-Kier alpha
+      double kappa2Helper(double P2,double A,double alpha);
+      //! kappa3 from the number of three-bond paths, heavy atoms and the Hall-Kier alpha
+      double kappa3Helper(double P3,int A,double alpha);
+    }
+
   } // end of namespace Descriptors
 }
 
@@ -0,0 +1,452 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDThreads.h>
+#include <RDBoost/Exceptions.h>
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/Subgraphs/Subgraphs.h>
+#include "MolDescriptors.h"
+#include "DescriptorCalculator.h"
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <limits>
+#include <algorithm>
+#include <numeric>
+#include <map>
+#include <cstring>
+
+namespace RDKit{
+  namespace Descriptors {
+    namespace {
+      enum DescriptorId {
+        AMW=0,ExactMW,NumAtoms,NumHeavyAtoms,
+        LipinskiHBA,LipinskiHBD,NumHBA,NumHBD,
+        NumRotatableBonds,NumStrictRotatableBonds,NumHeteroatoms,NumAmideBonds,
+        FractionCSP3,
+        NumRings,NumAromaticRings,NumAliphaticRings,NumSaturatedRings,
+        NumAromaticHeterocycles,NumAromaticCarbocycles,
+        NumAliphaticHeterocycles,NumAliphaticCarbocycles,
+        NumSaturatedHeterocycles,NumSaturatedCarbocycles,
+        LabuteASA,TPSA,CrippenClogP,CrippenMR,
+        Chi0v,Chi1v,Chi2v,Chi3v,Chi4v,
+        Chi0n,Chi1n,Chi2n,Chi3n,Chi4n,
+        HallKierAlpha,Kappa1,Kappa2,Kappa3,
+        SlogP_VSA,SMR_VSA,PEOE_VSA,MQN
+      };
+      struct DescriptorDef {
+        const char *name;
+        unsigned int nComponents; // >1 for the vector-valued descriptors
+      };
+      // this has to be in the same order as DescriptorId:
+      const DescriptorDef descriptorDefs[]={
+        {"AMW",1},{"ExactMW",1},{"NumAtoms",1},{"NumHeavyAtoms",1},
+        {"LipinskiHBA",1},{"LipinskiHBD",1},{"NumHBA",1},{"NumHBD",1},
+        {"NumRotatableBonds",1},{"NumStrictRotatableBonds",1},
+        {"NumHeteroatoms",1},{"NumAmideBonds",1},
+        {"FractionCSP3",1},
+        {"NumRings",1},{"NumAromaticRings",1},{"NumAliphaticRings",1},
+        {"NumSaturatedRings",1},
+        {"NumAromaticHeterocycles",1},{"NumAromaticCarbocycles",1},
+        {"NumAliphaticHeterocycles",1},{"NumAliphaticCarbocycles",1},
+        {"NumSaturatedHeterocycles",1},{"NumSaturatedCarbocycles",1},
+        {"LabuteASA",1},{"TPSA",1},{"CrippenClogP",1},{"CrippenMR",1},
+        {"Chi0v",1},{"Chi1v",1},{"Chi2v",1},{"Chi3v",1},{"Chi4v",1},
+        {"Chi0n",1},{"Chi1n",1},{"Chi2n",1},{"Chi3n",1},{"Chi4n",1},
+        {"HallKierAlpha",1},{"Kappa1",1},{"Kappa2",1},{"Kappa3",1},
+        {"SlogP_VSA",12},{"SMR_VSA",10},{"PEOE_VSA",14},{"MQN",42}
+      };
+      const unsigned int nDescriptorDefs=sizeof(descriptorDefs)/sizeof(DescriptorDef);
+
+      std::string componentName(unsigned int which,unsigned int component){
+        const DescriptorDef &def=descriptorDefs[which];
+        if(def.nComponents==1) return def.name;
+        return def.name+boost::lexical_cast<std::string>(component+1);
+      }
+
+      struct AtomCounts {
+        unsigned int nHeavy,nHetero,nCarbon,nCSP3;
+        double amw,exactMW;
+        AtomCounts() : nHeavy(0),nHetero(0),nCarbon(0),nCSP3(0),
+                       amw(0.0),exactMW(0.0) {};
+      };
+      // the heterocycle counts are enough to get the carbocycles:
+      struct RingCounts {
+        unsigned int nRings,nAromatic,nAliphatic,nSaturated;
+        unsigned int nAromaticHetero,nAliphaticHetero,nSaturatedHetero;
+        RingCounts() : nRings(0),nAromatic(0),nAliphatic(0),nSaturated(0),
+                       nAromaticHetero(0),nAliphaticHetero(0),nSaturatedHetero(0) {};
+      };
+
+      // the intermediate results for one molecule that are shared
+      // between descriptors. Everything is computed on first use.
+      class MolData {
+      public:
+        explicit MolData(const ROMol &mol) : d_mol(mol),
+                                              df_atoms(false),
+                                              df_rings(false),
+                                              df_labute(false),
+                                              df_tpsa(false),
+                                              df_hkDeltas(false),
+                                              df_nVals(false),
+                                              df_alpha(false),
+                                              df_crippen(false) {};
+
+        // the per-atom counts and masses, collected in a single pass
+        // over the atoms:
+        const AtomCounts &atomCounts() {
+          if(!df_atoms){
+            const PeriodicTable *table=PeriodicTable::getTable();
+            AtomCounts &ac=d_atomCounts;
+            unsigned int nHs=0;
+            for(ROMol::ConstAtomIterator atomIt=d_mol.beginAtoms();
+                atomIt!=d_mol.endAtoms();++atomIt){
+              const Atom *atom=*atomIt;
+              int atNum=atom->getAtomicNum();
+              if(atNum>1) ++ac.nHeavy;
+              if(atNum!=6 && atNum!=1) ++ac.nHetero;
+              if(atNum==6){
+                ++ac.nCarbon;
+                if(atom->getTotalDegree()==4) ++ac.nCSP3;
+              }
+              // these have to be summed in the same order as in
+              // calcAMW() and calcExactMW():
+              ac.amw+=atom->getMass();
+              ac.amw+=atom->getTotalNumHs()*table->getAtomicWeight(1);
+              if(!atom->getIsotope()){
+                ac.exactMW+=table->getMostCommonIsotopeMass(atNum);
+              } else {
+                ac.exactMW+=atom->getMass();
+              }
+              nHs+=atom->getTotalNumHs(false);
+            }
+            ac.exactMW+=nHs*table->getMostCommonIsotopeMass(1);
+            df_atoms=true;
+          }
+          return d_atomCounts;
+        }
+
+        // the ring counts, from a single pass over the SSSR bond rings:
+        const RingCounts &ringCounts() {
+          if(!df_rings){
+            RingCounts &rc=d_ringCounts;
+            BOOST_FOREACH(const INT_VECT &iv,d_mol.getRingInfo()->bondRings()){
+              bool aromatic=true,saturated=true,hetero=false;
+              BOOST_FOREACH(int i,iv){
+                const Bond *bond=d_mol.getBondWithIdx(i);
+                if(!bond->getIsAromatic()) aromatic=false;
+                if(bond->getBondType()!=Bond::SINGLE || bond->getIsAromatic()) saturated=false;
+                if(bond->getBeginAtom()->getAtomicNum()!=6 ||
+                   bond->getEndAtom()->getAtomicNum()!=6) hetero=true;
+              }
+              ++rc.nRings;
+              if(aromatic){
+                ++rc.nAromatic;
+                if(hetero) ++rc.nAromaticHetero;
+              } else {
+                ++rc.nAliphatic;
+                if(hetero) ++rc.nAliphaticHetero;
+              }
+              if(saturated){
+                ++rc.nSaturated;
+                if(hetero) ++rc.nSaturatedHetero;
+              }
+            }
+            df_rings=true;
+          }
+          return d_ringCounts;
+        }
+
+        // the atomic contributions to the surface area and the TPSA.
+        // These return the sum of the contributions:
+        double labuteASA() {
+          if(!df_labute){
+            double hContrib;
+            d_labuteContribs.resize(d_mol.getNumAtoms());
+            d_labuteASA=getLabuteAtomContribs(d_mol,d_labuteContribs,hContrib);
+            df_labute=true;
+          }
+          return d_labuteASA;
+        }
+        double tpsa() {
+          if(!df_tpsa){
+            d_tpsaContribs.resize(d_mol.getNumAtoms());
+            d_tpsa=getTPSAAtomContribs(d_mol,d_tpsaContribs);
+            df_tpsa=true;
+          }
+          return d_tpsa;
+        }
+
+        // the atomic values used by the chi descriptors
+        const std::vector<double> &hkDeltas() {
+          if(!df_hkDeltas){
+            d_hkDeltas.resize(d_mol.getNumAtoms());
+            detail::hkDeltas(d_mol,d_hkDeltas,false);
+            df_hkDeltas=true;
+          }
+          return d_hkDeltas;
+        }
+        const std::vector<double> &nVals() {
+          if(!df_nVals){
+            d_nVals.resize(d_mol.getNumAtoms());
+            detail::nVals(d_mol,d_nVals,false);
+            df_nVals=true;
+          }
+          return d_nVals;
+        }
+
+        double hallKierAlpha() {
+          if(!df_alpha){
+            d_alpha=calcHallKierAlpha(d_mol);
+            df_alpha=true;
+          }
+          return d_alpha;
+        }
+
+        void crippen(double &logp,double &mr) {
+          if(!df_crippen){
+            calcCrippenDescriptors(d_mol,d_logp,d_mr);
+            df_crippen=true;
+          }
+          logp=d_logp;
+          mr=d_mr;
+        }
+
+        // atom paths are used by the chi descriptors, bond paths by kappa
+        const PATH_LIST &paths(unsigned int length,bool useBonds) {
+          std::map<unsigned int,PATH_LIST> &pathMap=useBonds?d_bondPaths:d_atomPaths;
+          std::map<unsigned int,PATH_LIST>::iterator it=pathMap.find(length);
+          if(it==pathMap.end()){
+            it=pathMap.insert(std::make_pair(length,
+                                             findAllPathsOfLengthN(d_mol,length,useBonds))).first;
+          }
+          return it->second;
+        }
+
+        // the vector-valued descriptors:
+        const std::vector<double> &component(unsigned int which) {
+          std::map<unsigned int,std::vector<double> >::iterator it=d_components.find(which);
+          if(it!=d_components.end()) return it->second;
+
+          std::vector<double> &res=d_components[which];
+          switch(which){
+          case SlogP_VSA:
+            res=calcSlogP_VSA(d_mol);break;
+          case SMR_VSA:
+            res=calcSMR_VSA(d_mol);break;
+          case PEOE_VSA:
+            res=calcPEOE_VSA(d_mol);break;
+          case MQN:
+            {
+              std::vector<unsigned int> mqns=calcMQNs(d_mol);
+              res.assign(mqns.begin(),mqns.end());
+            }
+            break;
+          default:
+            PRECONDITION(0,"not a vector-valued descriptor");
+          }
+          return res;
+        }
+
+      private:
+        const ROMol &d_mol;
+        bool df_atoms,df_rings,df_labute,df_tpsa;
+        bool df_hkDeltas,df_nVals,df_alpha,df_crippen;
+        AtomCounts d_atomCounts;
+        RingCounts d_ringCounts;
+        std::vector<double> d_labuteContribs,d_tpsaContribs;
+        std::vector<double> d_hkDeltas,d_nVals;
+        double d_labuteASA,d_tpsa,d_alpha,d_logp,d_mr;
+        std::map<unsigned int,PATH_LIST> d_atomPaths,d_bondPaths;
+        std::map<unsigned int,std::vector<double> > d_components;
+      };
+
+      double calcValue(const ROMol &mol,MolData &data,
+                       unsigned int which,unsigned int component){
+        double logp,mr;
+        switch(which){
+        case AMW: return data.atomCounts().amw;
+        case ExactMW: return data.atomCounts().exactMW;
+        case NumAtoms: return mol.getNumAtoms(false);
+        case NumHeavyAtoms: return data.atomCounts().nHeavy;
+        case LipinskiHBA: return calcLipinskiHBA(mol);
+        case LipinskiHBD: return calcLipinskiHBD(mol);
+        case NumHBA: return calcNumHBA(mol);
+        case NumHBD: return calcNumHBD(mol);
+        case NumRotatableBonds: return calcNumRotatableBonds(mol);
+        case NumStrictRotatableBonds: return calcNumStrictRotatableBonds(mol);
+        case NumHeteroatoms: return data.atomCounts().nHetero;
+        case NumAmideBonds: return calcNumAmideBonds(mol);
+        case FractionCSP3: {
+          const AtomCounts &ac=data.atomCounts();
+          if(!ac.nCarbon) return 0.0;
+          return static_cast<double>(ac.nCSP3)/ac.nCarbon;
+        }
+        case NumRings: return data.ringCounts().nRings;
+        case NumAromaticRings: return data.ringCounts().nAromatic;
+        case NumAliphaticRings: return data.ringCounts().nAliphatic;
+        case NumSaturatedRings: return data.ringCounts().nSaturated;
+        case NumAromaticHeterocycles: return data.ringCounts().nAromaticHetero;
+        case NumAromaticCarbocycles: {
+          const RingCounts &rc=data.ringCounts();
+          return rc.nAromatic-rc.nAromaticHetero;
+        }
+        case NumAliphaticHeterocycles: return data.ringCounts().nAliphaticHetero;
+        case NumAliphaticCarbocycles: {
+          const RingCounts &rc=data.ringCounts();
+          return rc.nAliphatic-rc.nAliphaticHetero;
+        }
+        case NumSaturatedHeterocycles: return data.ringCounts().nSaturatedHetero;
+        case NumSaturatedCarbocycles: {
+          const RingCounts &rc=data.ringCounts();
+          return rc.nSaturated-rc.nSaturatedHetero;
+        }
+        case LabuteASA: return data.labuteASA();
+        case TPSA: return data.tpsa();
+        case CrippenClogP: data.crippen(logp,mr); return logp;
+        case CrippenMR: data.crippen(logp,mr); return mr;
+        case Chi0v: {
+          const std::vector<double> &hkDs=data.hkDeltas();
+          return std::accumulate(hkDs.begin(),hkDs.end(),0.0);
+        }
+        case Chi1v: return detail::chi1(mol,data.hkDeltas());
+        case Chi2v: return detail::chiN(data.paths(3,false),data.hkDeltas());
+        case Chi3v: return detail::chiN(data.paths(4,false),data.hkDeltas());
+        case Chi4v: return detail::chiN(data.paths(5,false),data.hkDeltas());
+        case Chi0n: {
+          const std::vector<double> &nVs=data.nVals();
+          return std::accumulate(nVs.begin(),nVs.end(),0.0);
+        }
+        case Chi1n: return detail::chi1(mol,data.nVals());
+        case Chi2n: return detail::chiN(data.paths(3,false),data.nVals());
+        case Chi3n: return detail::chiN(data.paths(4,false),data.nVals());
+        case Chi4n: return detail::chiN(data.paths(5,false),data.nVals());
+        case HallKierAlpha: return data.hallKierAlpha();
+        case Kappa1:
+          return detail::kappa1Helper(mol.getNumBonds(),data.atomCounts().nHeavy,
+                                      data.hallKierAlpha());
+        case Kappa2:
+          return detail::kappa2Helper(data.paths(2,true).size(),data.atomCounts().nHeavy,
+                                      data.hallKierAlpha());
+        case Kappa3:
+          return detail::kappa3Helper(data.paths(3,true).size(),data.atomCounts().nHeavy,
+                                      data.hallKierAlpha());
+        case SlogP_VSA:
+        case SMR_VSA:
+        case PEOE_VSA:
+        case MQN:
+          return data.component(which)[component];
+        default:
+          PRECONDITION(0,"bad descriptor id");
+        }
+        return 0.0;
+      }
+
+#ifdef RDK_THREADSAFE_SSS
+      void calcDescriptorsHelper(const DescriptorCalculator *calc,
+                                 const std::vector<const ROMol *> *mols,
+                                 std::vector<double> *res,
+                                 unsigned int start,unsigned int stride){
+        unsigned int nDescrs=calc->getNumDescriptors();
+        std::vector<double> vals;
+        for(unsigned int i=start;i<mols->size();i+=stride){
+          if(!(*mols)[i]) continue;
+          calc->calcDescriptors(*(*mols)[i],vals);
+          std::copy(vals.begin(),vals.end(),res->begin()+i*nDescrs);
+        }
+      }
+#endif
+    } // end of anonymous namespace
+
+    DescriptorCalculator::DescriptorCalculator(){
+      for(unsigned int i=0;i<nDescriptorDefs;++i){
+        addDescriptor(descriptorDefs[i].name);
+      }
+    }
+
+    DescriptorCalculator::DescriptorCalculator(const std::vector<std::string> &names){
+      BOOST_FOREACH(const std::string &name,names){
+        addDescriptor(name);
+      }
+    }
+
+    std::vector<std::string> DescriptorCalculator::getAvailableDescriptors(){
+      std::vector<std::string> res;
+      for(unsigned int i=0;i<nDescriptorDefs;++i){
+        for(unsigned int j=0;j<descriptorDefs[i].nComponents;++j){
+          res.push_back(componentName(i,j));
+        }
+      }
+      return res;
+    }
+
+    void DescriptorCalculator::addDescriptor(const std::string &name){
+      for(unsigned int i=0;i<nDescriptorDefs;++i){
+        const DescriptorDef &def=descriptorDefs[i];
+        if(name==def.name){
+          for(unsigned int j=0;j<def.nComponents;++j){
+            d_columns.push_back(std::make_pair(i,j));
+            d_names.push_back(componentName(i,j));
+          }
+          return;
+        }
+        // a single component of a vector-valued descriptor:
+        unsigned int len=strlen(def.name);
+        if(def.nComponents>1 && name.size()>len && name.compare(0,len,def.name)==0){
+          for(unsigned int j=0;j<def.nComponents;++j){
+            if(name==componentName(i,j)){
+              d_columns.push_back(std::make_pair(i,j));
+              d_names.push_back(name);
+              return;
+            }
+          }
+        }
+      }
+      throw KeyErrorException(name);
+    }
+
+    void DescriptorCalculator::calcDescriptors(const ROMol &mol,
+                                               std::vector<double> &res) const {
+      res.resize(d_columns.size());
+      MolData data(mol);
+      for(unsigned int i=0;i<d_columns.size();++i){
+        res[i]=calcValue(mol,data,d_columns[i].first,d_columns[i].second);
+      }
+    }
+
+    void DescriptorCalculator::calcDescriptors(const std::vector<const ROMol *> &mols,
+                                               std::vector<double> &res,
+                                               int numThreads) const {
+      unsigned int nDescrs=d_columns.size();
+      res.resize(mols.size()*nDescrs);
+      std::fill(res.begin(),res.end(),std::numeric_limits<double>::quiet_NaN());
+      numThreads=getNumThreadsToUse(numThreads);
+      if(numThreads==1 || mols.size()<2){
+        std::vector<double> vals;
+        for(unsigned int i=0;i<mols.size();++i){
+          if(!mols[i]) continue;
+          calcDescriptors(*mols[i],vals);
+          std::copy(vals.begin(),vals.end(),res.begin()+i*nDescrs);
+        }
+      }
+#ifdef RDK_THREADSAFE_SSS
+      else {
+        // make sure the singletons are initialized before the threads start:
+        PeriodicTable::getTable();
+        boost::thread_group tg;
+        for(int ti=0;ti<numThreads;++ti){
+          tg.add_thread(new boost::thread(calcDescriptorsHelper,this,&mols,&res,
+                                          ti,numThreads));
+        }
+        tg.join_all();
+      }
+#endif
+    }
+  } // end of namespace Descriptors
+} // end of namespace RDKit
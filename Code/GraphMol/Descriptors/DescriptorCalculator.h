@@ -0,0 +1,103 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_DESCRIPTORCALCULATOR_H_
+#define _RD_DESCRIPTORCALCULATOR_H_
+
+#include <vector>
+#include <string>
+#include <utility>
+
+namespace RDKit{
+  class ROMol;
+  namespace Descriptors {
+    //! calculates a set of descriptors for molecules in a single pass
+    /*!
+      The calculator is constructed from a list of descriptor names and
+      returns the values of those descriptors as a dense vector. The
+      intermediate results shared by several descriptors (the atom and
+      H counts and masses, the ring counts, the surface area and TPSA
+      atom contributions, the valence deltas, the Hall-Kier alpha,
+      subgraph paths, the Crippen contributions) are computed at most
+      once per molecule, and only if one of the requested descriptors
+      needs them. The atom counts come from a single pass over the atoms
+      and the ring counts from a single pass over the rings. The
+      SMARTS-based counts (HBA/HBD, rotatable and amide bonds) are still
+      calculated individually.
+
+      The values are the same as those returned by the individual
+      descriptor functions (calcTPSA(), calcChi2v(), etc.).
+
+      Names of the vector-valued descriptors are expanded into their
+      components: "SlogP_VSA" becomes "SlogP_VSA1" ... "SlogP_VSA12",
+      "MQN" becomes "MQN1" ... "MQN42", etc. The components can also be
+      requested individually.
+
+      <b>Notes:</b>
+        - as with the individual functions, the atomic contributions to
+          the surface area, TPSA, Crippen, and connectivity descriptors
+          are cached on the molecule as computed properties.
+        - the calculator itself is not modified by calculating
+          descriptors, so a single calculator can be used by multiple
+          threads.
+    */
+    class DescriptorCalculator {
+    public:
+      //! construct a calculator for all available descriptors
+      DescriptorCalculator();
+      //! construct a calculator for the descriptors in \c names
+      /*!
+        throws a KeyErrorException if a name is not recognized
+      */
+      explicit DescriptorCalculator(const std::vector<std::string> &names);
+
+      //! returns the names of all available descriptors
+      static std::vector<std::string> getAvailableDescriptors();
+
+      //! returns the names of the values the calculator returns, in order
+      const std::vector<std::string> &getDescriptorNames() const { return d_names; };
+      //! returns the number of values the calculator returns
+      unsigned int getNumDescriptors() const { return d_names.size(); };
+
+      //! calculates the descriptors for a molecule
+      /*!
+        \param mol   the molecule of interest
+        \param res   used to return the values, this is resized to
+                     getNumDescriptors()
+      */
+      void calcDescriptors(const ROMol &mol,std::vector<double> &res) const;
+
+      //! calculates the descriptors for a set of molecules
+      /*!
+        \param mols        the molecules of interest
+        \param res         used to return the values in row-major order:
+                           the values for molecule \c i start at
+                           <tt>res[i*getNumDescriptors()]</tt>.
+                           Values for null molecules are set to NaN.
+        \param numThreads  the number of threads to use. If this is <= 0 the
+                           number of threads is taken relative to the number
+                           of hardware threads (see getNumThreadsToUse()).
+                           Has no effect if the RDKit was built without
+                           thread support.
+      */
+      void calcDescriptors(const std::vector<const ROMol *> &mols,
+                           std::vector<double> &res,
+                           int numThreads=1) const;
+
+    private:
+      // the descriptor (index into the descriptor table) and
+      // the component of each of the values:
+      std::vector< std::pair<unsigned int,unsigned int> > d_columns;
+      std::vector<std::string> d_names;
+      void addDescriptor(const std::string &name);
+    };
+  } // end of namespace Descriptors
+} //end of namespace RDKit
+
+#endif
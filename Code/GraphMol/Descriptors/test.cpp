@@ -29,6 +29,8 @@
 
 #include <GraphMol/Descriptors/MolDescriptors.h>
 #include <GraphMol/Descriptors/Crippen.h>
+#include <GraphMol/Descriptors/DescriptorCalculator.h>
+#include <RDBoost/Exceptions.h>
 
 #include <DataStructs/BitVects.h>
 #include <DataStructs/BitOps.h>
@@ -1673,6 +1675,145 @@ void testGitHubIssue92(){
   BOOST_LOG(rdErrorLog) << "  done" << std::endl;
 }
 
+void testDescriptorCalculator(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test the descriptor calculator." << std::endl;
+
+  {
+    std::vector<std::string> names;
+    names.push_back("TPSA");
+    names.push_back("SlogP_VSA");
+    names.push_back("MQN12");
+    DescriptorCalculator calc(names);
+    TEST_ASSERT(calc.getNumDescriptors()==14);
+    TEST_ASSERT(calc.getDescriptorNames()[0]=="TPSA");
+    TEST_ASSERT(calc.getDescriptorNames()[1]=="SlogP_VSA1");
+    TEST_ASSERT(calc.getDescriptorNames()[12]=="SlogP_VSA12");
+    TEST_ASSERT(calc.getDescriptorNames()[13]=="MQN12");
+
+    bool ok=false;
+    names.push_back("MQN43");
+    try{
+      DescriptorCalculator calc2(names);
+    } catch (KeyErrorException &e){
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+
+  DescriptorCalculator calc;
+  TEST_ASSERT(calc.getDescriptorNames()==DescriptorCalculator::getAvailableDescriptors());
+  std::string fName = getenv("RDBASE");
+  fName += "/Code/GraphMol/Descriptors/test_data/aid466.trunc.sdf";
+  SDMolSupplier suppl(fName);
+  std::vector<const ROMol *> mols;
+  std::vector<double> vals;
+  while(!suppl.atEnd()){
+    ROMol *mol=suppl.next();
+    TEST_ASSERT(mol);
+    mols.push_back(mol);
+  }
+  // isotopes, dummies, charges, explicit Hs, and the different ring types:
+  std::string smis[]={"[2H]C1CC1c1ccncc1","O=C1CCC2CCOC2C1","*c1ccc[nH]1",
+                      "[13CH3]C(=O)[O-].[Na+]","[H]C([H])([H])C1=CCNCC1",
+                      "C1CC2CCC1CC2c1ccccc1"};
+  for(unsigned int i=0;i<sizeof(smis)/sizeof(smis[0]);++i){
+    // don't lose the explicit Hs:
+    RWMol *mol=SmilesToMol(smis[i],0,false);
+    TEST_ASSERT(mol);
+    MolOps::sanitizeMol(*mol);
+    mols.push_back(mol);
+  }
+  for(unsigned int mi=0;mi<mols.size();++mi){
+    const ROMol *mol=mols[mi];
+    calc.calcDescriptors(*mol,vals);
+    TEST_ASSERT(vals.size()==calc.getNumDescriptors());
+
+    // compare to the individual functions, using a copy so that
+    // nothing cached by the calculator is reused:
+    ROMol cp(*mol);
+    std::vector<double> ref;
+    ref.push_back(calcAMW(cp));
+    ref.push_back(calcExactMW(cp));
+    ref.push_back(cp.getNumAtoms(false));
+    ref.push_back(cp.getNumHeavyAtoms());
+    ref.push_back(calcLipinskiHBA(cp));
+    ref.push_back(calcLipinskiHBD(cp));
+    ref.push_back(calcNumHBA(cp));
+    ref.push_back(calcNumHBD(cp));
+    ref.push_back(calcNumRotatableBonds(cp));
+    ref.push_back(calcNumStrictRotatableBonds(cp));
+    ref.push_back(calcNumHeteroatoms(cp));
+    ref.push_back(calcNumAmideBonds(cp));
+    ref.push_back(calcFractionCSP3(cp));
+    ref.push_back(calcNumRings(cp));
+    ref.push_back(calcNumAromaticRings(cp));
+    ref.push_back(calcNumAliphaticRings(cp));
+    ref.push_back(calcNumSaturatedRings(cp));
+    ref.push_back(calcNumAromaticHeterocycles(cp));
+    ref.push_back(calcNumAromaticCarbocycles(cp));
+    ref.push_back(calcNumAliphaticHeterocycles(cp));
+    ref.push_back(calcNumAliphaticCarbocycles(cp));
+    ref.push_back(calcNumSaturatedHeterocycles(cp));
+    ref.push_back(calcNumSaturatedCarbocycles(cp));
+    ref.push_back(calcLabuteASA(cp));
+    ref.push_back(calcTPSA(cp));
+    double logp,mr;
+    calcCrippenDescriptors(cp,logp,mr);
+    ref.push_back(logp);
+    ref.push_back(mr);
+    ref.push_back(calcChi0v(cp));
+    ref.push_back(calcChi1v(cp));
+    ref.push_back(calcChi2v(cp));
+    ref.push_back(calcChi3v(cp));
+    ref.push_back(calcChi4v(cp));
+    ref.push_back(calcChi0n(cp));
+    ref.push_back(calcChi1n(cp));
+    ref.push_back(calcChi2n(cp));
+    ref.push_back(calcChi3n(cp));
+    ref.push_back(calcChi4n(cp));
+    ref.push_back(calcHallKierAlpha(cp));
+    ref.push_back(calcKappa1(cp));
+    ref.push_back(calcKappa2(cp));
+    ref.push_back(calcKappa3(cp));
+    std::vector<double> tv=calcSlogP_VSA(cp);
+    ref.insert(ref.end(),tv.begin(),tv.end());
+    tv=calcSMR_VSA(cp);
+    ref.insert(ref.end(),tv.begin(),tv.end());
+    tv=calcPEOE_VSA(cp);
+    ref.insert(ref.end(),tv.begin(),tv.end());
+    std::vector<unsigned int> mqns=calcMQNs(cp);
+    ref.insert(ref.end(),mqns.begin(),mqns.end());
+
+    TEST_ASSERT(ref.size()==vals.size());
+    for(unsigned int i=0;i<ref.size();++i){
+      if(ref[i]!=vals[i]){
+        BOOST_LOG(rdErrorLog)<<"  mismatch: "<<calc.getDescriptorNames()[i]<<" "<<ref[i]<<" "<<vals[i]<<std::endl;
+      }
+      TEST_ASSERT(ref[i]==vals[i]);
+    }
+  }
+
+  // batch mode:
+  mols.push_back(0);
+  std::vector<double> res1,res4;
+  calc.calcDescriptors(mols,res1);
+  TEST_ASSERT(res1.size()==mols.size()*calc.getNumDescriptors());
+  calc.calcDescriptors(*mols[3],vals);
+  TEST_ASSERT(std::equal(vals.begin(),vals.end(),res1.begin()+3*calc.getNumDescriptors()));
+  TEST_ASSERT(res1.back()!=res1.back());
+#ifdef RDK_TEST_MULTITHREADED
+  calc.calcDescriptors(mols,res4,4);
+  TEST_ASSERT(res4.size()==res1.size());
+  for(unsigned int i=0;i<(mols.size()-1)*calc.getNumDescriptors();++i){
+    TEST_ASSERT(res1[i]==res4[i]);
+  }
+#endif
+  for(unsigned int i=0;i<mols.size();++i) delete mols[i];
+
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
 //-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
 //
 //-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*-*
@@ -1706,5 +1847,6 @@ int main(){
 #endif
   testGitHubIssue56();
   testGitHubIssue92();
+  testDescriptorCalculator();
 
 }
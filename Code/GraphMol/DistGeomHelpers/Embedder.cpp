@@ -20,6 +20,7 @@
 #include <GraphMol/AtomIterators.h>
 
 #include <GraphMol/Conformer.h>
+#include <GraphMol/ConformerEnsemble.h>
 #include <RDGeneral/types.h>
 #include <RDGeneral/RDLog.h>
 
@@ -199,43 +200,40 @@ namespace RDKit {
       } // for loop over atoms
     } // end of _findChiralSets
 
-    void _fillAtomPositions(RDGeom::Point3DConstPtrVect &pts, const Conformer &conf) {
+    // copies the coordinates of a conformation to a buffer, centers them
+    // and returns their sum of squares
+    double _getCenteredCoords(const Conformer &conf, std::vector<double> &coords) {
       unsigned int na = conf.getNumAtoms();
-      pts.clear();
-      unsigned int ai;
-      pts.reserve(na);
-      for (ai = 0; ai < na; ++ai) {
-        pts.push_back(&conf.getAtomPos(ai));
+      coords.resize(3*na);
+      const RDGeom::POINT3D_VECT &pos = conf.getPositions();
+      for (unsigned int ai = 0; ai < na; ++ai) {
+        coords[3*ai] = pos[ai].x;
+        coords[3*ai+1] = pos[ai].y;
+        coords[3*ai+2] = pos[ai].z;
       }
+      return RDNumeric::Alignments::CenterPoints(na ? &coords[0] : 0, na);
     }
-        
-    bool _isConfFarFromRest(const ROMol &mol, const Conformer &conf,
+
+    bool _isConfFarFromRest(const ConformerEnsemble<double> &accepted,
+                            const std::vector<double> &acceptedSumSqs,
+                            const std::vector<double> &coords, double sumSq,
                             double threshold) {
       // NOTE: it is tempting to use some triangle inequality to prune
       // conformations here but some basic testing has shown very
       // little advantage and given that the time for pruning fades in
       // comparison to embedding - we will use a simple for loop below
       // over all conformation until we find a match
-      ROMol::ConstConformerIterator confi;
-
-      RDGeom::Point3DConstPtrVect refPoints, prbPoints;
-      _fillAtomPositions(refPoints, conf);
-
-      bool res = true;
-      unsigned int na = conf.getNumAtoms();
+      unsigned int na = accepted.getNumAtoms();
       double ssrThres = na*threshold*threshold;
-
-      RDGeom::Transform3D trans;
-      double ssr;
-      for (confi = mol.beginConformers(); confi != mol.endConformers(); confi++) {
-        _fillAtomPositions(prbPoints, *(*confi));
-        ssr = RDNumeric::Alignments::AlignPoints(refPoints, prbPoints, trans);
+      for (unsigned int i = 0; i < accepted.getNumConformers(); ++i) {
+        double ssr = RDNumeric::Alignments::AlignedSSR(na ? &coords[0] : 0, sumSq,
+                                                       accepted.getCoords(i),
+                                                       acceptedSumSqs[i], na);
         if (ssr < ssrThres) {
-          res = false;
-          break;
+          return false;
         }
       }
-      return res;
+      return true;
     }
 
     int EmbedMolecule(ROMol &mol, unsigned int maxIterations, int seed,
@@ -423,15 +421,37 @@ namespace RDKit {
           delete positions[i];
         }
       }
+      // the centered coordinates of the conformations already on the
+      // molecule, used for the RMS pruning:
+      ConformerEnsemble<double> accepted(mol.getNumAtoms());
+      std::vector<double> acceptedSumSqs;
+      std::vector<double> coords;
+      if (pruneRmsThresh > 0.0) {
+        for (ROMol::ConstConformerIterator cfi = mol.beginConformers();
+             cfi != mol.endConformers(); ++cfi) {
+          acceptedSumSqs.push_back(_getCenteredCoords(**cfi, coords));
+          accepted.addConformer(coords.size() ? &coords[0] : 0,
+                                accepted.getNumConformers());
+        }
+      }
       for(unsigned int ci=0;ci<confs.size();++ci){
         Conformer *conf = confs[ci];
         if(confsOk[ci]){
           // check if we are pruning away conformations and 
           // a closeby conformation has already been chosen :
+          double sumSq = 0.0;
+          if (pruneRmsThresh > 0.0) {
+            sumSq = _getCenteredCoords(*conf, coords);
+          }
           if (pruneRmsThresh > 0.0 && 
-              !_isConfFarFromRest(mol, *conf, pruneRmsThresh)) { 
+              !_isConfFarFromRest(accepted, acceptedSumSqs, coords, sumSq, pruneRmsThresh)) { 
             delete conf;
           } else {
+            if (pruneRmsThresh > 0.0) {
+              acceptedSumSqs.push_back(sumSq);
+              accepted.addConformer(coords.size() ? &coords[0] : 0,
+                                    accepted.getNumConformers());
+            }
             int confId = (int)mol.addConformer(conf, true);
             res.push_back(confId);
           }
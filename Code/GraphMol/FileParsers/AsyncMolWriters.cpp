@@ -0,0 +1,315 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/BadFileException.h>
+#include <RDGeneral/FileParseException.h>
+#include <RDGeneral/RDLog.h>
+#include <RDGeneral/RDThreads.h>
+
+#include "AsyncMolWriters.h"
+
+#include <fstream>
+#include <sstream>
+#include <exception>
+
+namespace RDKit {
+  AsyncMolWriter::AsyncMolWriter(std::ostream *outStream,bool takeOwnership,
+                                 int numThreads,unsigned int queueSize,
+                                 unsigned int bufferSize) {
+    PRECONDITION(outStream,"null stream");
+    if (outStream->bad()){
+      throw FileParseException("Bad output stream");
+    }
+    dp_ostream = outStream;
+    df_owner = takeOwnership;
+    init(numThreads,queueSize,bufferSize);
+  }
+
+  AsyncMolWriter::AsyncMolWriter(const std::string &fileName,int numThreads,
+                                 unsigned int queueSize,unsigned int bufferSize) {
+    if(fileName!= "-"){
+      std::ofstream *tmpStream = new std::ofstream(fileName.c_str());
+      if ( !(*tmpStream) || (tmpStream->bad()) ) {
+        delete tmpStream;
+        std::ostringstream errout;
+        errout << "Bad output file " << fileName;
+        throw BadFileException(errout.str());
+      }
+      dp_ostream = static_cast<std::ostream *>(tmpStream);
+      df_owner=true;
+    } else {
+      dp_ostream = static_cast<std::ostream *>(&std::cout);
+      df_owner=false;
+    }
+    init(numThreads,queueSize,bufferSize);
+  }
+
+  void AsyncMolWriter::init(int numThreads,unsigned int queueSize,
+                            unsigned int bufferSize) {
+    d_numThreads=getNumThreadsToUse(numThreads);
+    d_queueSize=queueSize>0 ? queueSize : 1;
+    d_bufferSize=bufferSize;
+    d_numSubmitted=0;
+    d_nextToWrite=0;
+#ifdef RDK_THREADSAFE_SSS
+    df_done=false;
+    dp_threads=NULL;
+#endif
+  }
+
+  AsyncMolWriter::~AsyncMolWriter() {
+    // close the writer if it's still open (derived classes close
+    // it in their destructors, while formatMol() can still be called):
+    if(dp_ostream!=NULL) close();
+  }
+
+  std::string AsyncMolWriter::formatJob(const Job &job) const {
+    try {
+      return formatMol(*job.mol,job.confId,job.molid);
+    } catch (const std::exception &e) {
+      BOOST_LOG(rdErrorLog) << "ERROR: could not write molecule " << job.molid
+                            << ": " << e.what() << std::endl;
+    } catch (...) {
+      BOOST_LOG(rdErrorLog) << "ERROR: could not write molecule " << job.molid
+                            << std::endl;
+    }
+    return "";
+  }
+
+  // moves the text for a molecule (and any that were waiting on it)
+  // to the output buffer. Once the buffer is full its contents are
+  // moved to ready, to be written by the caller. With threads this is
+  // called with the mutex held.
+  void AsyncMolWriter::addResult(unsigned int molid,std::string &text,
+                                 std::string &ready) {
+    if(molid!=d_nextToWrite){
+      d_results[molid].swap(text);
+      return;
+    }
+    d_buffer += text;
+    ++d_nextToWrite;
+    std::map<unsigned int,std::string>::iterator it=d_results.begin();
+    while(it!=d_results.end() && it->first==d_nextToWrite){
+      d_buffer += it->second;
+      d_results.erase(it++);
+      ++d_nextToWrite;
+    }
+    if(d_buffer.size()>=d_bufferSize){
+      ready.swap(d_buffer);
+    }
+  }
+
+  void AsyncMolWriter::writeBuffer() {
+    if(!d_buffer.empty()){
+      dp_ostream->write(d_buffer.c_str(),d_buffer.size());
+      d_buffer.clear();
+    }
+  }
+
+#ifdef RDK_THREADSAFE_SSS
+  void AsyncMolWriter::workerLoop() {
+    while(true){
+      Job job;
+      {
+        boost::mutex::scoped_lock lock(d_mutex);
+        while(d_jobs.empty() && !df_done){
+          d_jobAvailable.wait(lock);
+        }
+        if(d_jobs.empty()) return;
+        job=d_jobs.front();
+        d_jobs.pop_front();
+      }
+      std::string text=formatJob(job);
+      delete job.mol;
+      std::string ready;
+      boost::mutex::scoped_lock writeLock(d_writeMutex,boost::defer_lock);
+      {
+        boost::mutex::scoped_lock lock(d_mutex);
+        addResult(job.molid,text,ready);
+        // a later buffer can't be written before we have the write lock:
+        if(!ready.empty()) writeLock.lock();
+      }
+      d_spaceAvailable.notify_all();
+      // the other threads keep working while we write:
+      if(!ready.empty()){
+        dp_ostream->write(ready.c_str(),ready.size());
+      }
+    }
+  }
+
+  void AsyncMolWriter::stopThreads() {
+    if(!dp_threads) return;
+    {
+      boost::mutex::scoped_lock lock(d_mutex);
+      df_done=true;
+    }
+    d_jobAvailable.notify_all();
+    dp_threads->join_all();
+    delete dp_threads;
+    dp_threads=NULL;
+  }
+
+  void AsyncMolWriter::write(const ROMol &mol,int confId) {
+    PRECONDITION(dp_ostream,"no output stream");
+    if(!dp_threads){
+      dp_threads=new boost::thread_group();
+      for(unsigned int i=0;i<d_numThreads;++i){
+        dp_threads->add_thread(new boost::thread(&AsyncMolWriter::workerLoop,this));
+      }
+    }
+    std::string header;
+    if(!d_numSubmitted) header=headerText();
+
+    // the caller is free to modify the molecule once we return, so the
+    // workers get a copy:
+    Job job;
+    job.mol=new ROMol(mol);
+    job.confId=confId;
+
+    boost::mutex::scoped_lock lock(d_mutex);
+    d_buffer += header;
+    while(d_numSubmitted-d_nextToWrite>=d_queueSize){
+      d_spaceAvailable.wait(lock);
+    }
+    job.molid=d_numSubmitted++;
+    d_jobs.push_back(job);
+    d_jobAvailable.notify_one();
+  }
+
+  void AsyncMolWriter::flush() {
+    PRECONDITION(dp_ostream,"no output stream");
+    boost::mutex::scoped_lock lock(d_mutex);
+    while(d_nextToWrite<d_numSubmitted){
+      d_spaceAvailable.wait(lock);
+    }
+    // wait for any buffer that is still being written:
+    boost::mutex::scoped_lock writeLock(d_writeMutex);
+    writeBuffer();
+    dp_ostream->flush();
+  }
+#else
+  void AsyncMolWriter::stopThreads() {
+  }
+
+  void AsyncMolWriter::write(const ROMol &mol,int confId) {
+    PRECONDITION(dp_ostream,"no output stream");
+    if(!d_numSubmitted) d_buffer += headerText();
+    Job job;
+    job.mol=&mol;
+    job.confId=confId;
+    job.molid=d_numSubmitted++;
+    std::string text=formatJob(job),ready;
+    addResult(job.molid,text,ready);
+    if(!ready.empty()){
+      dp_ostream->write(ready.c_str(),ready.size());
+    }
+  }
+
+  void AsyncMolWriter::flush() {
+    PRECONDITION(dp_ostream,"no output stream");
+    writeBuffer();
+    dp_ostream->flush();
+  }
+#endif
+
+  void AsyncMolWriter::close() {
+    PRECONDITION(dp_ostream,"no output stream");
+    flush();
+    stopThreads();
+    if(df_owner) {
+      delete dp_ostream;
+      df_owner=false;
+    }
+    dp_ostream=NULL;
+  }
+
+  // ---------------------------------------------------------------
+  AsyncSDWriter::AsyncSDWriter(const std::string &fileName,int numThreads,
+                               unsigned int queueSize,unsigned int bufferSize) :
+    AsyncMolWriter(fileName,numThreads,queueSize,bufferSize),
+    df_forceV3000(false),df_kekulize(true) {
+  }
+
+  AsyncSDWriter::AsyncSDWriter(std::ostream *outStream,bool takeOwnership,
+                               int numThreads,unsigned int queueSize,
+                               unsigned int bufferSize) :
+    AsyncMolWriter(outStream,takeOwnership,numThreads,queueSize,bufferSize),
+    df_forceV3000(false),df_kekulize(true) {
+  }
+
+  AsyncSDWriter::~AsyncSDWriter() {
+    if(isOpen()) close();
+  }
+
+  void AsyncSDWriter::setProps(const STR_VECT &propNames) {
+    if (hasStarted()) {
+      BOOST_LOG(rdErrorLog) << "ERROR: Atleast one molecule has already been written\n";
+      BOOST_LOG(rdErrorLog) << "ERROR: Cannot set properties now - ignoring setProps\n";
+      return;
+    }
+    d_props = propNames;
+  }
+
+  std::string AsyncSDWriter::formatMol(const ROMol &mol,int confId,
+                                       unsigned int molid) const {
+    return SDWriter::getText(mol,confId,df_kekulize,df_forceV3000,molid,d_props);
+  }
+
+  // ---------------------------------------------------------------
+  AsyncSmilesWriter::AsyncSmilesWriter(const std::string &fileName,
+                                       const std::string &delimiter,
+                                       const std::string &nameHeader,
+                                       bool includeHeader,
+                                       bool isomericSmiles,
+                                       bool kekuleSmiles,
+                                       int numThreads,unsigned int queueSize,
+                                       unsigned int bufferSize) :
+    AsyncMolWriter(fileName,numThreads,queueSize,bufferSize),
+    d_delim(delimiter),d_nameHeader(nameHeader),df_includeHeader(includeHeader),
+    df_isomericSmiles(isomericSmiles),df_kekuleSmiles(kekuleSmiles) {
+  }
+
+  AsyncSmilesWriter::AsyncSmilesWriter(std::ostream *outStream,
+                                       const std::string &delimiter,
+                                       const std::string &nameHeader,
+                                       bool includeHeader,
+                                       bool takeOwnership,
+                                       bool isomericSmiles,
+                                       bool kekuleSmiles,
+                                       int numThreads,unsigned int queueSize,
+                                       unsigned int bufferSize) :
+    AsyncMolWriter(outStream,takeOwnership,numThreads,queueSize,bufferSize),
+    d_delim(delimiter),d_nameHeader(nameHeader),df_includeHeader(includeHeader),
+    df_isomericSmiles(isomericSmiles),df_kekuleSmiles(kekuleSmiles) {
+  }
+
+  AsyncSmilesWriter::~AsyncSmilesWriter() {
+    if(isOpen()) close();
+  }
+
+  void AsyncSmilesWriter::setProps(const STR_VECT &propNames) {
+    if (hasStarted()) {
+      BOOST_LOG(rdErrorLog) << "ERROR: Atleast one molecule has already been written\n";
+      BOOST_LOG(rdErrorLog) << "ERROR: Cannot set properties now - ignoring setProps\n";
+      return;
+    }
+    d_props = propNames;
+  }
+
+  std::string AsyncSmilesWriter::headerText() const {
+    if(!df_includeHeader) return "";
+    return SmilesWriter::getHeaderText(d_delim,d_nameHeader,d_props);
+  }
+
+  std::string AsyncSmilesWriter::formatMol(const ROMol &mol,int,
+                                           unsigned int molid) const {
+    return SmilesWriter::getText(mol,d_delim,d_nameHeader!="",d_props,
+                                 df_isomericSmiles,df_kekuleSmiles,molid);
+  }
+}
@@ -0,0 +1,230 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_ASYNCMOLWRITERS_H_
+#define _RD_ASYNCMOLWRITERS_H_
+
+#include <RDGeneral/types.h>
+#include <GraphMol/FileParsers/MolWriters.h>
+
+#include <string>
+#include <iostream>
+#include <deque>
+#include <map>
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
+
+namespace RDKit {
+  //! base class for writers that format molecules on worker threads
+  /*!
+    write() copies the molecule into a queue and returns, the text for
+    the molecules is generated by up to \c numThreads worker threads.
+    The results are written to the stream in the order the molecules
+    were submitted, through an output buffer that is written when it
+    reaches \c bufferSize bytes.
+
+    At most \c queueSize molecules are held by the writer at a time;
+    write() blocks while this many molecules are waiting to be
+    formatted or written.
+
+    <b>Notes:</b>
+      - molecules that cannot be formatted are reported to the error
+        log and skipped.
+      - the writers are not thread safe: write() should only be called
+        from a single thread.
+      - without thread support (RDK_THREADSAFE_SSS not defined) the
+        molecules are formatted in write().
+  */
+  class AsyncMolWriter : public MolWriter {
+  public:
+    virtual ~AsyncMolWriter();
+
+    //! \brief queue a molecule for writing
+    void write(const ROMol &mol,int confId=defaultConfId);
+
+    //! \brief waits until all queued molecules are written and flushes the ostream
+    void flush();
+
+    //! \brief close our stream (the writer cannot be used again)
+    void close();
+
+    //! \brief get the number of molecules written (or queued) so far
+    unsigned int numMols() const { return d_numSubmitted; };
+
+  protected:
+    /*!
+      \param outStream     : the stream to write to
+      \param takeOwnership : if true the stream is deleted when the writer is closed
+      \param numThreads    : the number of formatting threads. If this is <= 0 the
+                             number of threads is taken relative to the number of
+                             hardware threads (see getNumThreadsToUse()).
+      \param queueSize     : the maximum number of molecules held by the writer
+      \param bufferSize    : the size of the output buffer
+    */
+    AsyncMolWriter(std::ostream *outStream,bool takeOwnership,int numThreads,
+                   unsigned int queueSize,unsigned int bufferSize);
+
+    //! \overload
+    /*!
+      \param fileName : filename to write to ("-" to write to stdout)
+    */
+    AsyncMolWriter(const std::string &fileName,int numThreads,
+                   unsigned int queueSize,unsigned int bufferSize);
+
+    //! returns the text for the molecule with (0-based) index \c molid
+    /*!
+      This is called concurrently from the worker threads, so it must not
+      modify the writer.
+    */
+    virtual std::string formatMol(const ROMol &mol,int confId,
+                                  unsigned int molid) const = 0;
+    //! returns text that is written before the first molecule
+    virtual std::string headerText() const { return ""; };
+
+    //! returns whether or not write() has been called
+    bool hasStarted() const { return d_numSubmitted>0; };
+    //! returns whether or not the writer is still open
+    bool isOpen() const { return dp_ostream!=NULL; };
+
+  private:
+    struct Job {
+      unsigned int molid;
+      const ROMol *mol;
+      int confId;
+    };
+
+    std::ostream *dp_ostream;
+    bool df_owner;
+    unsigned int d_numThreads;
+    unsigned int d_queueSize;
+    unsigned int d_bufferSize;
+    unsigned int d_numSubmitted;
+    // the molecule whose text will be appended to the buffer next:
+    unsigned int d_nextToWrite;
+    std::deque<Job> d_jobs;
+    std::map<unsigned int,std::string> d_results;
+    std::string d_buffer;
+#ifdef RDK_THREADSAFE_SSS
+    bool df_done;
+    boost::thread_group *dp_threads;
+    boost::mutex d_mutex;
+    // held while a full buffer is written to the stream, this is always
+    // taken with d_mutex held so that the buffers are written in order:
+    boost::mutex d_writeMutex;
+    boost::condition_variable d_jobAvailable;
+    boost::condition_variable d_spaceAvailable;
+#endif
+
+    std::string formatJob(const Job &job) const;
+    void addResult(unsigned int molid,std::string &text,std::string &ready);
+    void writeBuffer();
+    void init(int numThreads,unsigned int queueSize,unsigned int bufferSize);
+    void workerLoop();
+    void stopThreads();
+  };
+
+  //! an SDWriter that formats the molecules on worker threads
+  /*!
+    The output is the same as that of an SDWriter with the same settings.
+    The settings should not be changed after the first molecule is written.
+  */
+  class AsyncSDWriter : public AsyncMolWriter {
+  public:
+    /*!
+      \param fileName    : filename to write to ("-" to write to stdout)
+      \param numThreads  : the number of formatting threads
+      \param queueSize   : the maximum number of molecules held by the writer
+      \param bufferSize  : the size of the output buffer
+    */
+    AsyncSDWriter(const std::string &fileName,int numThreads=1,
+                  unsigned int queueSize=1000,unsigned int bufferSize=1<<20);
+    //! \overload
+    AsyncSDWriter(std::ostream *outStream,bool takeOwnership=false,
+                  int numThreads=1,unsigned int queueSize=1000,
+                  unsigned int bufferSize=1<<20);
+    ~AsyncSDWriter();
+
+    //! \brief set a vector of property names that are need to be
+    //! written out for each molecule
+    void setProps(const STR_VECT &propNames);
+
+    void setForceV3000(bool val) { df_forceV3000=val; };
+    bool getForceV3000() const { return df_forceV3000; };
+
+    void setKekulize(bool val) { df_kekulize=val; };
+    bool getKekulize() const { return df_kekulize; };
+
+  protected:
+    std::string formatMol(const ROMol &mol,int confId,unsigned int molid) const;
+
+  private:
+    STR_VECT d_props; // list of property name that need to be written out
+    bool df_forceV3000; // force writing the mol blocks as V3000
+    bool df_kekulize; // toggle kekulization of molecules on writing
+  };
+
+  //! a SmilesWriter that formats the molecules on worker threads
+  /*!
+    The output is the same as that of a SmilesWriter with the same settings.
+  */
+  class AsyncSmilesWriter : public AsyncMolWriter {
+  public:
+    /*!
+      \param fileName       : filename to write to ("-" to write to stdout)
+      \param delimiter      : delimiter to use in the text file
+      \param nameHeader     : used to label the name column in the output. If this
+                              is provided as the empty string, no names will be written.
+      \param includeHeader  : toggles inclusion of a header line in the output
+      \param isomericSmiles : toggles generation of isomeric SMILES
+      \param kekuleSmiles   : toggles the generation of kekule SMILES.
+      \param numThreads     : the number of formatting threads
+      \param queueSize      : the maximum number of molecules held by the writer
+      \param bufferSize     : the size of the output buffer
+    */
+    AsyncSmilesWriter(const std::string &fileName,
+                      const std::string &delimiter=" ",
+                      const std::string &nameHeader="Name",
+                      bool includeHeader=true,
+                      bool isomericSmiles=false,
+                      bool kekuleSmiles=false,
+                      int numThreads=1,unsigned int queueSize=1000,
+                      unsigned int bufferSize=1<<20);
+    //! \overload
+    AsyncSmilesWriter(std::ostream *outStream,
+                      const std::string &delimiter=" ",
+                      const std::string &nameHeader="Name",
+                      bool includeHeader=true,
+                      bool takeOwnership=false,
+                      bool isomericSmiles=false,
+                      bool kekuleSmiles=false,
+                      int numThreads=1,unsigned int queueSize=1000,
+                      unsigned int bufferSize=1<<20);
+    ~AsyncSmilesWriter();
+
+    //! \brief set a vector of property names that are need to be
+    //! written out for each molecule
+    void setProps(const STR_VECT &propNames);
+
+  protected:
+    std::string formatMol(const ROMol &mol,int confId,unsigned int molid) const;
+    std::string headerText() const;
+
+  private:
+    std::string d_delim; // delimiter string between various records
+    std::string d_nameHeader; // header for the name column in the output file
+    bool df_includeHeader; // whether or not to include a title line
+    bool df_isomericSmiles; // whether or not to do isomeric smiles
+    bool df_kekuleSmiles; // whether or not to do kekule smiles
+    STR_VECT d_props; // list of property name that need to be written out
+  };
+}
+
+#endif
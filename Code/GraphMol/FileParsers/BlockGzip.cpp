@@ -0,0 +1,477 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/BadFileException.h>
+#include <RDGeneral/FileParseException.h>
+#include <RDGeneral/RDThreads.h>
+#include "BlockGzip.h"
+
+#include <zlib.h>
+#include <algorithm>
+#include <cstring>
+
+namespace RDKit {
+  namespace {
+    // the fixed part of the gzip header, the length of the extra field,
+    // and our "RB" subfield (block size and number of records):
+    const unsigned int gzipFixedHeaderSize=12;
+    const unsigned int rbExtraSize=12;
+    const unsigned int headerSize=gzipFixedHeaderSize+rbExtraSize;
+    // CRC32 and uncompressed size:
+    const unsigned int trailerSize=8;
+    // the largest compression ratio deflate can reach:
+    const unsigned int maxDeflateRatio=1032;
+
+    void packUInt16(unsigned char *p,boost::uint32_t v){
+      p[0]=v&0xFF;
+      p[1]=(v>>8)&0xFF;
+    }
+    void packUInt32(unsigned char *p,boost::uint32_t v){
+      p[0]=v&0xFF;
+      p[1]=(v>>8)&0xFF;
+      p[2]=(v>>16)&0xFF;
+      p[3]=(v>>24)&0xFF;
+    }
+    boost::uint32_t unpackUInt16(const unsigned char *p){
+      return p[0] | (p[1]<<8);
+    }
+    boost::uint32_t unpackUInt32(const unsigned char *p){
+      return p[0] | (p[1]<<8) | (p[2]<<16) | (static_cast<boost::uint32_t>(p[3])<<24);
+    }
+
+    void inflateHelper(const std::string *block,std::string *text,std::string *error){
+      try{
+        BlockGzipReader::inflateBlock(*block,*text);
+      } catch (FileParseException &e) {
+        *error=e.message();
+      } catch (std::exception &e) {
+        // anything else (e.g. bad_alloc) must not escape the thread either
+        *error=std::string("could not decompress block: ")+e.what();
+      }
+    }
+  }
+
+  // ------------------------------------------------------------------
+  //
+  //  BlockGzipWriter
+  //
+  // ------------------------------------------------------------------
+  BlockGzipWriter::BlockGzipWriter(std::ostream *outStream,unsigned int blockSize,
+                                   int level,bool takeOwnership) :
+    dp_ostream(outStream),df_owner(takeOwnership),d_blockSize(blockSize),d_level(level),
+    d_nBufferRecords(0),d_nRecords(0) {
+    PRECONDITION(outStream,"null stream");
+    if(outStream->bad()){
+      throw FileParseException("Bad output stream");
+    }
+  }
+
+  BlockGzipWriter::BlockGzipWriter(const std::string &fileName,unsigned int blockSize,
+                                   int level) :
+    df_owner(true),d_blockSize(blockSize),d_level(level),
+    d_nBufferRecords(0),d_nRecords(0) {
+    std::ofstream *tmpStream=new std::ofstream(fileName.c_str(),
+                                               std::ios_base::out|std::ios_base::binary);
+    if(!(*tmpStream) || tmpStream->bad()){
+      delete tmpStream;
+      std::ostringstream errout;
+      errout << "Bad output file " << fileName;
+      throw BadFileException(errout.str());
+    }
+    dp_ostream=static_cast<std::ostream *>(tmpStream);
+  }
+
+  BlockGzipWriter::~BlockGzipWriter(){
+    // close the writer if it's still open:
+    if(dp_ostream) close();
+  }
+
+  void BlockGzipWriter::writeRecord(const std::string &text){
+    PRECONDITION(dp_ostream,"no output stream");
+    d_buffer+=text;
+    ++d_nBufferRecords;
+    ++d_nRecords;
+    if(d_buffer.size()>=d_blockSize) writeBlock();
+  }
+
+  void BlockGzipWriter::flush(){
+    PRECONDITION(dp_ostream,"no output stream");
+    writeBlock();
+    dp_ostream->flush();
+  }
+
+  void BlockGzipWriter::close(){
+    PRECONDITION(dp_ostream,"no output stream");
+    flush();
+    if(df_owner){
+      delete dp_ostream;
+      df_owner=false;
+    }
+    dp_ostream=NULL;
+  }
+
+  void BlockGzipWriter::writeBlock(){
+    if(!d_nBufferRecords) return;
+
+    z_stream strm;
+    memset(&strm,0,sizeof(strm));
+    // negative window bits: raw deflate data, we write the gzip header ourselves
+    int ret=deflateInit2(&strm,d_level,Z_DEFLATED,-15,8,Z_DEFAULT_STRATEGY);
+    CHECK_INVARIANT(ret==Z_OK,"could not initialize zlib");
+    uLong bound=deflateBound(&strm,d_buffer.size());
+    std::vector<unsigned char> block(headerSize+bound+trailerSize);
+    strm.next_in=reinterpret_cast<Bytef *>(const_cast<char *>(d_buffer.c_str()));
+    strm.avail_in=d_buffer.size();
+    strm.next_out=&block[headerSize];
+    strm.avail_out=bound;
+    ret=deflate(&strm,Z_FINISH);
+    unsigned int compressedSize=strm.total_out;
+    deflateEnd(&strm);
+    CHECK_INVARIANT(ret==Z_STREAM_END,"deflate failed");
+
+    unsigned int blockSize=headerSize+compressedSize+trailerSize;
+    unsigned char *p=&block[0];
+    p[0]=0x1f; p[1]=0x8b; // magic
+    p[2]=8;               // deflate
+    p[3]=4;               // FEXTRA
+    packUInt32(p+4,0);    // mtime
+    p[8]=0;               // extra flags
+    p[9]=0xff;            // OS: unknown
+    packUInt16(p+10,rbExtraSize);
+    p[12]='R'; p[13]='B';
+    packUInt16(p+14,8);
+    packUInt32(p+16,blockSize);
+    packUInt32(p+20,d_nBufferRecords);
+
+    p=&block[headerSize+compressedSize];
+    packUInt32(p,crc32(0,reinterpret_cast<const Bytef *>(d_buffer.c_str()),d_buffer.size()));
+    packUInt32(p+4,d_buffer.size());
+
+    dp_ostream->write(reinterpret_cast<const char *>(&block[0]),blockSize);
+    d_buffer.clear();
+    d_nBufferRecords=0;
+  }
+
+  // ------------------------------------------------------------------
+  //
+  //  BlockGzipReader
+  //
+  // ------------------------------------------------------------------
+  BlockGzipReader::BlockGzipReader(const std::string &fileName) :
+    d_inStream(fileName.c_str(),std::ios_base::in|std::ios_base::binary),d_nRecords(0) {
+    if(!d_inStream || d_inStream.bad()){
+      std::ostringstream errout;
+      errout << "Bad input file " << fileName;
+      throw BadFileException(errout.str());
+    }
+    d_inStream.seekg(0,std::ios_base::end);
+    boost::uint64_t fileSize=d_inStream.tellg();
+    d_inStream.seekg(0,std::ios_base::beg);
+
+    // build the index from the block headers:
+    boost::uint64_t offset=0;
+    unsigned char header[gzipFixedHeaderSize];
+    std::vector<unsigned char> extra;
+    while(offset<fileSize){
+      d_inStream.seekg(offset);
+      d_inStream.read(reinterpret_cast<char *>(header),gzipFixedHeaderSize);
+      if(d_inStream.gcount()!=gzipFixedHeaderSize ||
+         header[0]!=0x1f || header[1]!=0x8b || header[2]!=8 || !(header[3]&4)){
+        throw BadFileException(fileName+" is not a block-compressed file");
+      }
+      unsigned int xlen=unpackUInt16(header+10);
+      extra.resize(xlen);
+      if(xlen){
+        d_inStream.read(reinterpret_cast<char *>(&extra[0]),xlen);
+        if(static_cast<unsigned int>(d_inStream.gcount())!=xlen){
+          throw BadFileException(fileName+" is truncated");
+        }
+      }
+      bool found=false;
+      BlockGzipBlockInfo info;
+      for(unsigned int pos=0;pos+4<=xlen;){
+        unsigned int slen=unpackUInt16(&extra[pos+2]);
+        if(extra[pos]=='R' && extra[pos+1]=='B' && slen==8 && pos+4+slen<=xlen){
+          info.size=unpackUInt32(&extra[pos+4]);
+          info.nRecords=unpackUInt32(&extra[pos+8]);
+          found=true;
+          break;
+        }
+        pos+=4+slen;
+      }
+      if(!found){
+        throw BadFileException(fileName+" is not a block-compressed file");
+      }
+      if(info.size<gzipFixedHeaderSize+xlen+trailerSize || offset+info.size>fileSize){
+        throw BadFileException(fileName+" is truncated or corrupt");
+      }
+      info.offset=offset;
+      info.firstRecord=d_nRecords;
+      d_blocks.push_back(info);
+      d_nRecords+=info.nRecords;
+      offset+=info.size;
+    }
+  }
+
+  unsigned int BlockGzipReader::findBlock(boost::uint64_t recordIdx) const {
+    PRECONDITION(recordIdx<d_nRecords,"bad record index");
+    // the last block whose first record is <= recordIdx:
+    unsigned int lo=0,hi=d_blocks.size();
+    while(hi-lo>1){
+      unsigned int mid=(lo+hi)/2;
+      if(d_blocks[mid].firstRecord<=recordIdx){
+        lo=mid;
+      } else {
+        hi=mid;
+      }
+    }
+    // skip blocks without records:
+    while(d_blocks[lo].firstRecord+d_blocks[lo].nRecords<=recordIdx) ++lo;
+    return lo;
+  }
+
+  void BlockGzipReader::readBlock(unsigned int idx,std::string &block){
+    PRECONDITION(idx<d_blocks.size(),"bad block index");
+    const BlockGzipBlockInfo &info=d_blocks[idx];
+    block.resize(info.size);
+    d_inStream.clear();
+    d_inStream.seekg(info.offset);
+    d_inStream.read(&block[0],info.size);
+    if(static_cast<unsigned int>(d_inStream.gcount())!=info.size){
+      throw FileParseException("could not read compressed block");
+    }
+  }
+
+  void BlockGzipReader::inflateBlock(const std::string &block,std::string &text){
+    PRECONDITION(block.size()>=gzipFixedHeaderSize+trailerSize,"bad block");
+    const unsigned char *p=reinterpret_cast<const unsigned char *>(block.c_str());
+    unsigned int dataStart=gzipFixedHeaderSize+unpackUInt16(p+10);
+    if(dataStart+trailerSize>block.size()){
+      throw FileParseException("corrupt compressed block");
+    }
+    unsigned int dataSize=block.size()-dataStart-trailerSize;
+    boost::uint32_t crc=unpackUInt32(p+block.size()-trailerSize);
+    boost::uint32_t textSize=unpackUInt32(p+block.size()-trailerSize+4);
+    // deflate can't compress by more than a factor of 1032, so a larger
+    // size means the trailer is corrupt:
+    if(textSize>static_cast<boost::uint64_t>(dataSize)*maxDeflateRatio){
+      throw FileParseException("corrupt compressed block");
+    }
+
+    text.resize(textSize);
+    char dummy;
+    z_stream strm;
+    memset(&strm,0,sizeof(strm));
+    int ret=inflateInit2(&strm,-15);
+    CHECK_INVARIANT(ret==Z_OK,"could not initialize zlib");
+    strm.next_in=const_cast<Bytef *>(p+dataStart);
+    strm.avail_in=dataSize;
+    strm.next_out=reinterpret_cast<Bytef *>(textSize ? &text[0] : &dummy);
+    strm.avail_out=textSize;
+    ret=inflate(&strm,Z_FINISH);
+    bool ok=(ret==Z_STREAM_END && strm.total_out==textSize);
+    inflateEnd(&strm);
+    if(!ok || crc32(0,reinterpret_cast<const Bytef *>(text.c_str()),textSize)!=crc){
+      throw FileParseException("corrupt compressed block");
+    }
+  }
+
+  void BlockGzipReader::getBlockText(unsigned int idx,std::string &text){
+    std::string block;
+    readBlock(idx,block);
+    inflateBlock(block,text);
+  }
+
+  // ------------------------------------------------------------------
+  //
+  //  BlockGzipSDMolSupplier
+  //
+  // ------------------------------------------------------------------
+  BlockGzipSDMolSupplier::BlockGzipSDMolSupplier(const std::string &fileName,bool sanitize,
+                                                 bool removeHs,bool strictParsing,
+                                                 int numThreads) :
+    d_reader(fileName),df_sanitize(sanitize),df_removeHs(removeHs),
+    df_strictParsing(strictParsing) {
+    d_numThreads=getNumThreadsToUse(numThreads);
+#ifdef RDK_THREADSAFE_SSS
+    dp_pendingThreads=0;
+#endif
+    init();
+  }
+
+  BlockGzipSDMolSupplier::~BlockGzipSDMolSupplier(){
+#ifdef RDK_THREADSAFE_SSS
+    if(dp_pendingThreads){
+      dp_pendingThreads->join_all();
+      delete dp_pendingThreads;
+    }
+#endif
+  }
+
+  void BlockGzipSDMolSupplier::init(){
+    dp_inStream=0;
+    df_owner=false;
+    d_next=0;
+    d_curBlock=-1;
+    dp_curSuppl.reset();
+    d_readyStart=0;
+    d_readyText.clear();
+    d_readyErrors.clear();
+  }
+
+  void BlockGzipSDMolSupplier::reset(){
+    d_next=0;
+  }
+
+  bool BlockGzipSDMolSupplier::atEnd(){
+    return d_next>=length();
+  }
+
+  void BlockGzipSDMolSupplier::moveTo(unsigned int idx){
+    if(idx>=length()){
+      d_next=length();
+      std::ostringstream errout;
+      errout << "ERROR: Index error (idx = " << idx  << ") : " << " we do no have enough mol blocks";
+      throw FileParseException(errout.str());
+    }
+    d_next=idx;
+  }
+
+  ROMol *BlockGzipSDMolSupplier::next(){
+    if(atEnd()){
+      throw FileParseException("EOF hit.");
+    }
+    unsigned int idx=d_next++;
+    SDMolSupplier *suppl=supplierForRecord(idx);
+    suppl->moveTo(idx-d_reader.getBlockInfo(d_curBlock).firstRecord);
+    return suppl->next();
+  }
+
+  ROMol *BlockGzipSDMolSupplier::operator[](unsigned int idx){
+    moveTo(idx);
+    return next();
+  }
+
+  std::string BlockGzipSDMolSupplier::getItemText(unsigned int idx){
+    if(idx>=length()){
+      std::ostringstream errout;
+      errout << "ERROR: Index error (idx = " << idx  << ") : " << " we do no have enough mol blocks";
+      throw FileParseException(errout.str());
+    }
+    SDMolSupplier *suppl=supplierForRecord(idx);
+    return suppl->getItemText(idx-d_reader.getBlockInfo(d_curBlock).firstRecord);
+  }
+
+  SDMolSupplier *BlockGzipSDMolSupplier::supplierForRecord(unsigned int idx){
+    unsigned int blockIdx=d_reader.findBlock(idx);
+    if(static_cast<int>(blockIdx)!=d_curBlock){
+      loadBlock(blockIdx);
+    }
+    return dp_curSuppl.get();
+  }
+
+  void BlockGzipSDMolSupplier::loadBlock(unsigned int idx){
+    bool sequential=(static_cast<int>(idx)==d_curBlock+1);
+    std::string text;
+    if(!d_pendingBlocks.empty() &&
+       idx>=d_pendingStart && idx<d_pendingStart+d_pendingBlocks.size()){
+      finishDecompression();
+    }
+    if(idx>=d_readyStart && idx<d_readyStart+d_readyText.size()){
+      // a block that failed to decompress ahead of the parser is only
+      // an error once it is needed:
+      if(d_readyErrors[idx-d_readyStart]!=""){
+        throw FileParseException(d_readyErrors[idx-d_readyStart]);
+      }
+      text=d_readyText[idx-d_readyStart];
+    } else {
+      // not something we've read ahead, discard what we have:
+      finishDecompression();
+      d_readyText.clear();
+      d_readyErrors.clear();
+      d_reader.getBlockText(idx,text);
+    }
+    // if we're reading through the file, start decompressing the next
+    // blocks while this one is parsed:
+    if(sequential && d_numThreads>1 && d_pendingBlocks.empty()){
+      unsigned int start=std::max(idx+1,
+                                  static_cast<unsigned int>(d_readyStart+d_readyText.size()));
+      if(start<d_reader.getNumBlocks()) startDecompression(start);
+    }
+
+    d_curBlock=idx;
+    dp_curSuppl.reset(new SDMolSupplier(new std::istringstream(text),true,
+                                        df_sanitize,df_removeHs,df_strictParsing));
+  }
+
+  void BlockGzipSDMolSupplier::startDecompression(unsigned int start){
+    PRECONDITION(d_pendingBlocks.empty(),"decompression already running");
+    unsigned int n=std::min(d_numThreads,d_reader.getNumBlocks()-start);
+    d_pendingStart=start;
+    d_pendingBlocks.resize(n);
+    d_pendingText.resize(n);
+    d_pendingErrors.resize(n);
+    for(unsigned int i=0;i<n;++i){
+      d_reader.readBlock(start+i,d_pendingBlocks[i]);
+      d_pendingErrors[i]="";
+    }
+#ifdef RDK_THREADSAFE_SSS
+    dp_pendingThreads=new boost::thread_group();
+    for(unsigned int i=0;i<n;++i){
+      dp_pendingThreads->add_thread(new boost::thread(inflateHelper,&d_pendingBlocks[i],
+                                                      &d_pendingText[i],&d_pendingErrors[i]));
+    }
+#else
+    for(unsigned int i=0;i<n;++i){
+      inflateHelper(&d_pendingBlocks[i],&d_pendingText[i],&d_pendingErrors[i]);
+    }
+#endif
+  }
+
+  void BlockGzipSDMolSupplier::finishDecompression(){
+    if(d_pendingBlocks.empty()) return;
+#ifdef RDK_THREADSAFE_SSS
+    dp_pendingThreads->join_all();
+    delete dp_pendingThreads;
+    dp_pendingThreads=0;
+#endif
+    d_pendingBlocks.clear();
+    // errors are kept with their blocks, see loadBlock():
+    d_readyStart=d_pendingStart;
+    d_readyText.swap(d_pendingText);
+    d_readyErrors.swap(d_pendingErrors);
+    d_pendingText.clear();
+    d_pendingErrors.clear();
+  }
+
+  // ------------------------------------------------------------------
+  //
+  //  BlockGzipSDWriter
+  //
+  // ------------------------------------------------------------------
+  BlockGzipSDWriter::BlockGzipSDWriter(const std::string &fileName,unsigned int blockSize,
+                                       int level) :
+    d_writer(fileName,blockSize,level),d_text(),d_sdWriter(&d_text,false) {
+  }
+
+  BlockGzipSDWriter::BlockGzipSDWriter(std::ostream *outStream,unsigned int blockSize,
+                                       int level,bool takeOwnership) :
+    d_writer(outStream,blockSize,level,takeOwnership),d_text(),d_sdWriter(&d_text,false) {
+  }
+
+  BlockGzipSDWriter::~BlockGzipSDWriter(){
+  }
+
+  void BlockGzipSDWriter::write(const ROMol &mol,int confId){
+    d_sdWriter.write(mol,confId);
+    d_sdWriter.flush();
+    d_writer.writeRecord(d_text.str());
+    d_text.str("");
+  }
+}
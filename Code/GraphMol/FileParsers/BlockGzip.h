@@ -0,0 +1,220 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_BLOCKGZIP_H_
+#define _RD_BLOCKGZIP_H_
+
+#include <RDGeneral/types.h>
+#include <GraphMol/FileParsers/MolSupplier.h>
+#include <GraphMol/FileParsers/MolWriters.h>
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
+
+namespace RDKit {
+  /*! \file BlockGzip.h
+
+    \brief block-compressed files of text records
+
+    A block-compressed file is a series of independent gzip members
+    ("blocks"), so it can be read by any gzip tool. Each block holds a
+    whole number of records (mol blocks of an SD file, lines of a SMILES
+    file, ...) and carries an "RB" extra field with the size of the
+    compressed block and the number of records it contains. This allows
+    the block index of a file to be built by reading just the block
+    headers, and the blocks to be decompressed independently of each
+    other.
+
+    This is the same idea as the BGZF format used for sequence data,
+    but because blocks always end at a record boundary (and may be
+    larger than 64K) the files are not BGZF files.
+  */
+
+  //! information about one block of a block-compressed file
+  struct BlockGzipBlockInfo {
+    boost::uint64_t offset;        //!< position of the block in the file
+    boost::uint32_t size;          //!< size of the compressed block
+    boost::uint64_t firstRecord;   //!< index of the first record in the block
+    boost::uint32_t nRecords;      //!< number of records in the block
+  };
+
+  //! writes text records to a block-compressed stream
+  class BlockGzipWriter {
+  public:
+    /*!
+      \param outStream   : the stream to write to (should be opened in binary mode)
+      \param blockSize   : the (uncompressed) size at which blocks are written
+      \param level       : the zlib compression level
+      \param takeOwnership : if true the stream is deleted when the writer is closed
+    */
+    BlockGzipWriter(std::ostream *outStream,unsigned int blockSize=256*1024,
+                    int level=6,bool takeOwnership=false);
+    //! \overload
+    BlockGzipWriter(const std::string &fileName,unsigned int blockSize=256*1024,
+                    int level=6);
+    ~BlockGzipWriter();
+
+    //! adds a record, the record is never split across blocks
+    void writeRecord(const std::string &text);
+    //! writes the current block to the stream and flushes it
+    void flush();
+    //! flushes and closes the stream (the writer cannot be used again)
+    void close();
+    //! returns the number of records written so far
+    boost::uint64_t numRecords() const { return d_nRecords; };
+
+  private:
+    std::ostream *dp_ostream;
+    bool df_owner;
+    unsigned int d_blockSize;
+    int d_level;
+    std::string d_buffer;
+    unsigned int d_nBufferRecords;
+    boost::uint64_t d_nRecords;
+    void writeBlock();
+  };
+
+  //! provides access to the blocks of a block-compressed file
+  class BlockGzipReader {
+  public:
+    //! opens the file and builds its block index
+    /*!
+      throws a BadFileException if the file cannot be opened or is not
+      block-compressed
+    */
+    explicit BlockGzipReader(const std::string &fileName);
+
+    unsigned int getNumBlocks() const { return d_blocks.size(); };
+    boost::uint64_t getNumRecords() const { return d_nRecords; };
+    const BlockGzipBlockInfo &getBlockInfo(unsigned int idx) const {
+      PRECONDITION(idx<d_blocks.size(),"bad block index");
+      return d_blocks[idx];
+    };
+    //! returns the index of the block containing record \c recordIdx
+    unsigned int findBlock(boost::uint64_t recordIdx) const;
+
+    //! reads the compressed data for block \c idx
+    void readBlock(unsigned int idx,std::string &block);
+    //! decompresses a block returned by readBlock()
+    /*!
+      This does not use the reader, so multiple blocks can be
+      decompressed concurrently. Throws a FileParseException if the
+      block is corrupt.
+    */
+    static void inflateBlock(const std::string &block,std::string &text);
+    //! convenience function: reads and decompresses block \c idx
+    void getBlockText(unsigned int idx,std::string &text);
+
+  private:
+    std::ifstream d_inStream;
+    std::vector<BlockGzipBlockInfo> d_blocks;
+    boost::uint64_t d_nRecords;
+  };
+
+  //! a supplier for block-compressed SD files
+  /*!
+    Blocks are decompressed ahead of the parser on up to \c numThreads
+    threads. Random access (operator[]) only needs to decompress the
+    block containing the requested molecule.
+
+    Writing such a file is done with a BlockGzipSDWriter.
+  */
+  class BlockGzipSDMolSupplier : public MolSupplier {
+  public:
+    /*!
+     *   \param fileName - the name of the compressed SD file
+     *   \param sanitize - if true sanitize the molecule before returning it
+     *   \param removeHs - if true remove Hs from the molecule before returning it
+     *                     (triggers sanitization)
+     *   \param strictParsing - if not set, the parser is more lax about correctness
+     *                          of the contents.
+     *   \param numThreads - the number of threads used to decompress blocks.
+     *                       If this is <= 0 the number of threads is taken
+     *                       relative to the number of hardware threads.
+     */
+    explicit BlockGzipSDMolSupplier(const std::string &fileName,bool sanitize=true,
+                                    bool removeHs=true,bool strictParsing=true,
+                                    int numThreads=1);
+    ~BlockGzipSDMolSupplier();
+
+    void init();
+    void reset();
+    ROMol *next();
+    bool atEnd();
+    //! sets the position of the supplier, next() will return molecule \c idx
+    void moveTo(unsigned int idx);
+    ROMol *operator[](unsigned int idx);
+    //! returns the text block for a particular item
+    std::string getItemText(unsigned int idx);
+    unsigned int length() const { return d_reader.getNumRecords(); };
+
+  private:
+    BlockGzipReader d_reader;
+    bool df_sanitize,df_removeHs,df_strictParsing;
+    unsigned int d_numThreads;
+    unsigned int d_next; // the molecule next() returns
+    // the block currently being parsed:
+    int d_curBlock;
+    boost::shared_ptr<SDMolSupplier> dp_curSuppl;
+    // blocks that have been decompressed ahead of the parser:
+    unsigned int d_readyStart;
+    std::vector<std::string> d_readyText,d_readyErrors;
+    unsigned int d_pendingStart;
+    std::vector<std::string> d_pendingBlocks,d_pendingText,d_pendingErrors;
+#ifdef RDK_THREADSAFE_SSS
+    boost::thread_group *dp_pendingThreads;
+#endif
+    void loadBlock(unsigned int idx);
+    void startDecompression(unsigned int start);
+    void finishDecompression();
+    SDMolSupplier *supplierForRecord(unsigned int idx);
+  };
+
+  //! writes block-compressed SD files
+  class BlockGzipSDWriter : public MolWriter {
+  public:
+    /*!
+      \param fileName    : the file to write to
+      \param blockSize   : the (uncompressed) size at which blocks are written
+      \param level       : the zlib compression level
+    */
+    BlockGzipSDWriter(const std::string &fileName,unsigned int blockSize=256*1024,
+                      int level=6);
+    //! \overload
+    BlockGzipSDWriter(std::ostream *outStream,unsigned int blockSize=256*1024,
+                      int level=6,bool takeOwnership=false);
+    ~BlockGzipSDWriter();
+
+    void setProps(const STR_VECT &propNames) { d_sdWriter.setProps(propNames); };
+    void write(const ROMol &mol,int confId=defaultConfId);
+    void flush() { d_writer.flush(); };
+    void close() { d_writer.close(); };
+    unsigned int numMols() const { return d_sdWriter.numMols(); };
+
+    void setForceV3000(bool val) { d_sdWriter.setForceV3000(val); };
+    bool getForceV3000() const { return d_sdWriter.getForceV3000(); };
+    void setKekulize(bool val) { d_sdWriter.setKekulize(val); };
+    bool getKekulize() const { return d_sdWriter.getKekulize(); };
+
+  private:
+    BlockGzipWriter d_writer;
+    std::ostringstream d_text;
+    SDWriter d_sdWriter;
+  };
+}
+
+#endif
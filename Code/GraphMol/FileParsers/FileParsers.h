@@ -191,6 +191,23 @@ namespace RDKit{
   RWMol *Mol2BlockToMol(const std::string &molBlock,bool sanitize=true,bool removeHs=true,
                         Mol2Type variant=CORINA);
 
+  // \brief construct a molecule from a PDB block
+  /*! 
+   *   \param str      - string containing the PDB block
+   *   \param sanitize - toggles sanitization of the molecule
+   *   \param removeHs - toggles removal of Hs from the molecule. H removal
+   *                     is only done if the molecule is sanitized
+   *   \param flavor   - controls how the block is read:
+   *         flavor & 1 : Keep alternate locations, pseudo atoms and dummy residues
+   *         flavor & 2 : Bond the heavy atoms of standard amino acid residues
+   *                      using templates instead of interatomic distances
+   *
+   *   If the block has more than one MODEL, the later ones are read as
+   *   additional conformers of the molecule. This needs all MODELs to
+   *   have the same atoms (serial numbers and names) in the same order;
+   *   if they don't, the atoms of all the MODELs are added to the
+   *   molecule instead, as in earlier versions.
+   */
   RWMol *PDBBlockToMol(const char *str, bool sanitize=true,
                        bool removeHs=true, unsigned int flavor=0);
 
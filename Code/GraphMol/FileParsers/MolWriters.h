@@ -95,6 +95,26 @@ namespace RDKit {
     //! \brief get the number of molecules written so far
     unsigned int numMols() const { return d_molid;} ;
 
+    //! \brief returns the line that is written for a molecule
+    /*!
+      \param mol        : the molecule
+      \param delimiter  : the delimiter between fields
+      \param includeName : toggles inclusion of the molecule name
+      \param propNames  : the properties to write
+      \param isomericSmiles : toggles output of isomeric smiles
+      \param kekuleSmiles : toggles output of kekule smiles
+      \param molid      : the (0-based) index of the molecule in the file,
+                          this is used as the name if the molecule has none
+    */
+    static std::string getText(const ROMol &mol,const std::string &delimiter,
+                               bool includeName,const STR_VECT &propNames,
+                               bool isomericSmiles,bool kekuleSmiles,
+                               unsigned int molid);
+    //! \brief returns the header line
+    static std::string getHeaderText(const std::string &delimiter,
+                                     const std::string &nameHeader,
+                                     const STR_VECT &propNames);
+
   private:
     // local initialization
     void init(std::string delimiter,std::string nameHeader,
@@ -169,10 +189,23 @@ namespace RDKit {
     
     void setKekulize(bool val) { df_kekulize=val; };
     bool getKekulize() const { return df_kekulize; };    
+
+    //! \brief returns the text that is written for a molecule
+    /*!
+      \param mol        : the molecule
+      \param confId     : the conformer to use
+      \param kekulize   : toggles kekulization of the molecule
+      \param forceV3000 : toggles writing a V3000 mol block
+      \param molid      : the (0-based) index of the molecule in the file,
+                          this is used in the property header lines
+      \param propNames  : the properties to write, if this is empty
+                          all non-computed properties are written
+    */
+    static std::string getText(const ROMol &mol,int confId,bool kekulize,
+                               bool forceV3000,unsigned int molid,
+                               const STR_VECT &propNames);
     
   private:
-    void writeProperty(const ROMol &mol, std::string name);
-
     std::ostream *dp_ostream;
     bool df_owner;
     unsigned int d_molid; // the number of the molecules we wrote so far
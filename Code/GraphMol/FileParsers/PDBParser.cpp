@@ -13,6 +13,7 @@
 #include <iostream>
 #include <fstream>
 #include <boost/lexical_cast.hpp>
+#include <boost/cstdint.hpp>
 #include <RDGeneral/BadFileException.h>
 #include <RDGeneral/FileParseException.h>
 #include <GraphMol/FileParsers/FileParsers.h>
@@ -40,40 +41,191 @@ namespace RDKit {
     return elemno > 0 ? new Atom(elemno) : (Atom*)0;
   }
 
-  static void PDBAtomLine(RWMol *mol, const char *ptr, unsigned int len,
-                          unsigned int flavor, std::map<int,Atom*> &amap)
+  // Parses a fixed width integer field, leading and trailing blanks
+  // are ignored. Returns false if the field is not an integer.
+  static bool PDBParseInt(const char *ptr, unsigned int len, int &res)
   {
-    PRECONDITION(mol,"bad mol");
-    PRECONDITION(ptr,"bad char ptr");
-    std::string tmp;
+    while (len && *ptr==' ') {
+      ptr++;
+      len--;
+    }
+    while (len && ptr[len-1]==' ')
+      len--;
+    bool neg = false;
+    if (len && (*ptr=='-' || *ptr=='+')) {
+      neg = *ptr=='-';
+      ptr++;
+      len--;
+    }
+    if (!len)
+      return false;
+    int val = 0;
+    for (unsigned int i=0; i<len; i++) {
+      if (ptr[i]<'0' || ptr[i]>'9')
+        return false;
+      val = 10*val + (ptr[i]-'0');
+    }
+    res = neg ? -val : val;
+    return true;
+  }
 
+  // Parses a fixed width serial or residue number field. Numbers that
+  // do not fit in the field's decimal digits are written in hybrid-36:
+  // base 36 with upper case letters from A0000 (100000 for the five
+  // digit serial numbers), then with lower case letters.
+  static bool PDBParseHybrid36(const char *ptr, unsigned int len, int &res)
+  {
+    if (PDBParseInt(ptr,len,res))
+      return true;
+    if (!len || len > 5)
+      return false;
+    bool upper;
+    if (ptr[0]>='A' && ptr[0]<='Z')
+      upper = true;
+    else if (ptr[0]>='a' && ptr[0]<='z')
+      upper = false;
+    else return false;
+    int val = 0;
+    for (unsigned int i=0; i<len; i++) {
+      int digit;
+      if (ptr[i]>='0' && ptr[i]<='9')
+        digit = ptr[i]-'0';
+      else if (upper && ptr[i]>='A' && ptr[i]<='Z')
+        digit = ptr[i]-'A'+10;
+      else if (!upper && ptr[i]>='a' && ptr[i]<='z')
+        digit = ptr[i]-'a'+10;
+      else return false;
+      val = 36*val + digit;
+    }
+    int pow36 = 1, pow10 = 10;
+    for (unsigned int i=1; i<len; i++) {
+      pow36 *= 36;
+      pow10 *= 10;
+    }
+    res = val - 10*pow36 + pow10;
+    if (!upper)
+      res += 26*pow36;
+    return true;
+  }
+
+  // Parses a fixed width real field such as the coordinates, without
+  // the temporary strings FileParserUtils::toDouble() needs. Anything
+  // other than plain decimal notation is passed on to toDouble().
+  static double PDBParseDouble(const char *ptr, unsigned int len)
+  {
+    static const double scales[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,
+                                    1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15};
+    const char *p = ptr;
+    const char *end = ptr+len;
+    while (p<end && *p==' ')
+      p++;
+    while (end>p && end[-1]==' ')
+      end--;
+    if (p == end)
+      return 0.0;
+    bool neg = false;
+    if (*p=='-' || *p=='+') {
+      neg = *p=='-';
+      p++;
+    }
+    boost::uint64_t mant = 0;
+    unsigned int ndigits = 0;
+    unsigned int scale = 0;
+    bool point = false;
+    for (; p<end; p++) {
+      if (*p>='0' && *p<='9') {
+        mant = 10*mant + (*p-'0');
+        ndigits++;
+        if (point)
+          scale++;
+      } else if (*p=='.' && !point) {
+        point = true;
+      } else break;
+    }
+    if (p!=end || !ndigits || ndigits>15)
+      return FileParserUtils::toDouble(std::string(ptr,len));
+    // both values are exact, so this is correctly rounded:
+    double res = (double)mant/scales[scale];
+    return neg ? -res : res;
+  }
+
+  // returns whether or not an ATOM/HETATM record should be skipped
+  static bool PDBIgnoreAtomLine(const char *ptr, unsigned int len,
+                                unsigned int flavor)
+  {
     if (len < 16)
-      return;
+      return true;
 
     if ((flavor & 1) == 0) {
       // Ignore alternate locations of atoms.
       if (len >= 17 && ptr[16]!=' ' && ptr[16]!='A' && ptr[16]!='1')
-        return;
+        return true;
       // Ignore XPLOR pseudo atoms
       if (len >= 54 && !memcmp(ptr+30,"9999.0009999.0009999.000",24))
-        return;
+        return true;
       // Ignore NMR pseudo atoms
       if (ptr[12]==' ' && ptr[13]=='Q')
-        return;
+        return true;
       // Ignore PDB dummy residues
       if (len >= 20 && !memcmp(ptr+18,"DUM",3))
-        return;
+        return true;
     }
+    return false;
+  }
 
+  static int PDBSerialNumber(const char *ptr)
+  {
     int serialno;
-    tmp = std::string(ptr+6,5);
+    if (!PDBParseHybrid36(ptr+6,5,serialno)) {
+      std::ostringstream errout;
+      errout << "Non-integer PDB serial number " << std::string(ptr+6,5);
+      throw FileParseException(errout.str()) ;
+    }
+    return serialno;
+  }
+
+  static RDGeom::Point3D PDBAtomPosition(const char *ptr, unsigned int len,
+                                         int serialno)
+  {
+    RDGeom::Point3D pos;
     try {
-      serialno = FileParserUtils::toInt(tmp);
-    } catch (boost::bad_lexical_cast &) {
+      pos.x = PDBParseDouble(ptr+30,8);
+      if (len >= 46)
+        pos.y = PDBParseDouble(ptr+38,8);
+      if (len >= 54)
+        pos.z = PDBParseDouble(ptr+46,8);
+    }
+    catch (boost::bad_lexical_cast &) {
       std::ostringstream errout;
-      errout << "Non-integer PDB serial number " << tmp;
+      errout << "Problem with coordinates for PDB atom #" << serialno;
       throw FileParseException(errout.str()) ;
     }
+    return pos;
+  }
+
+  static void PDBResidueFields(AtomPDBResidueInfo *info, const char *ptr,
+                               unsigned int len, int serialno);
+
+  // The residue of the last atom read. The residue fields (columns
+  // 18-27) of atoms in the same residue are copied from its info
+  // rather than parsed again.
+  struct PDBResidueState {
+    const char *line;
+    AtomPDBResidueInfo *info;
+    PDBResidueState() : line(0), info(0) {};
+  };
+
+  static void PDBAtomLine(RWMol *mol, const char *ptr, unsigned int len,
+                          unsigned int flavor, std::map<int,Atom*> &amap,
+                          PDBResidueState &residue)
+  {
+    PRECONDITION(mol,"bad mol");
+    PRECONDITION(ptr,"bad char ptr");
+
+    if (PDBIgnoreAtomLine(ptr,len,flavor))
+      return;
+
+    int serialno = PDBSerialNumber(ptr);
 
     Atom *atom = (Atom*)0;
     char symb[3];
@@ -141,19 +293,7 @@ namespace RDKit {
     amap[serialno] = atom;
 
     if (len >= 38) {
-      RDGeom::Point3D pos;
-      try {
-        pos.x = FileParserUtils::toDouble(std::string(ptr+30,8));
-        if (len >= 46)
-          pos.y = FileParserUtils::toDouble(std::string(ptr+38,8));
-        if (len >= 54)
-          pos.z = FileParserUtils::toDouble(std::string(ptr+46,8));
-      }
-      catch (boost::bad_lexical_cast &) {
-        std::ostringstream errout;
-        errout << "Problem with coordinates for PDB atom #" << serialno;
-        throw FileParseException(errout.str()) ;
-      }
+      RDGeom::Point3D pos = PDBAtomPosition(ptr,len,serialno);
 
       Conformer *conf;
       if (!mol->getNumConformers()) {
@@ -202,10 +342,51 @@ namespace RDKit {
         atom->setFormalCharge(charge);
     }
 
-    tmp = std::string(ptr+12,4);
-    AtomPDBResidueInfo *info = new AtomPDBResidueInfo(tmp,serialno);
+    AtomPDBResidueInfo *info;
+    if (residue.info && len >= 27 && ptr[0]==residue.line[0] &&
+        !memcmp(ptr+17,residue.line+17,10)) {
+      info = new AtomPDBResidueInfo(*residue.info);
+      info->setName(std::string(ptr+12,4));
+      info->setSerialNumber(serialno);
+      info->setAltLoc(std::string(ptr+16,1));
+    } else {
+      info = new AtomPDBResidueInfo(std::string(ptr+12,4),serialno);
+      PDBResidueFields(info,ptr,len,serialno);
+      residue.line = len >= 27 ? ptr : 0;
+      residue.info = len >= 27 ? info : 0;
+    }
     atom->setMonomerInfo(info);
 
+    double occup = 1.0;
+    if (len >= 60) {
+      try {
+        occup = PDBParseDouble(ptr+54,6);
+      } catch (boost::bad_lexical_cast &) {
+        std::ostringstream errout;
+        errout << "Problem with occupancy for PDB atom #" << serialno;
+        throw FileParseException(errout.str()) ;
+      }
+    }
+    info->setOccupancy(occup);
+
+    double bfactor = 0.0;
+    if (len >= 66) {
+      try {
+        bfactor = PDBParseDouble(ptr+60,6);
+      } catch (boost::bad_lexical_cast &) {
+        std::ostringstream errout;
+        errout << "Problem with temperature factor for PDB atom #" << serialno;
+        throw FileParseException(errout.str()) ;
+      }
+    }
+    info->setTempFactor(bfactor);
+  }
+
+  // sets the residue fields and the altLoc of an atom's info
+  static void PDBResidueFields(AtomPDBResidueInfo *info, const char *ptr,
+                               unsigned int len, int serialno)
+  {
+    std::string tmp;
     if (len >= 20)
       tmp = std::string(ptr+17,3);
     else tmp = "UNL";
@@ -226,40 +407,73 @@ namespace RDKit {
     info->setInsertionCode(tmp);
 
     int resno = 1;
-    if (len >= 26) {
-      try {
-        resno = FileParserUtils::toInt(std::string(ptr+22,4));
-      } catch (boost::bad_lexical_cast &) {
-        std::ostringstream errout;
-        errout << "Problem with residue number for PDB atom #" << serialno;
-        throw FileParseException(errout.str()) ;
-      }
+    if (len >= 26 && !PDBParseHybrid36(ptr+22,4,resno)) {
+      std::ostringstream errout;
+      errout << "Problem with residue number for PDB atom #" << serialno;
+      throw FileParseException(errout.str()) ;
     }
     info->setResidueNumber(resno);
+  }
 
-    double occup = 1.0;
-    if (len >= 60) {
-      try {
-        occup = FileParserUtils::toDouble(std::string(ptr+54,6));
-      } catch (boost::bad_lexical_cast &) {
-        std::ostringstream errout;
-        errout << "Problem with occupancy for PDB atom #" << serialno;
-        throw FileParseException(errout.str()) ;
-      }
-    }
-    info->setOccupancy(occup);
+  // reads the position of an atom from an ATOM/HETATM record in the
+  // second or later MODEL of a block into that model's conformer.
+  // modelAtoms is the number of atoms in the first MODEL. Returns false
+  // if the atom doesn't match the one in the first MODEL.
+  static bool PDBModelAtomLine(RWMol *mol, const char *ptr, unsigned int len,
+                               unsigned int flavor, Conformer *&conf,
+                               unsigned int &atomIdx, unsigned int model,
+                               unsigned int modelAtoms)
+  {
+    PRECONDITION(mol,"bad mol");
+    PRECONDITION(ptr,"bad char ptr");
 
-    double bfactor = 0.0;
-    if (len >= 66) {
-      try {
-        bfactor = FileParserUtils::toDouble(std::string(ptr+60,6));
-      } catch (boost::bad_lexical_cast &) {
-        std::ostringstream errout;
-        errout << "Problem with temperature factor for PDB atom #" << serialno;
-        throw FileParseException(errout.str()) ;
-      }
+    if (PDBIgnoreAtomLine(ptr,len,flavor))
+      return true;
+
+    int serialno = PDBSerialNumber(ptr);
+    if (!conf) {
+      conf = new RDKit::Conformer(mol->getNumAtoms());
+      conf->set3D(false);
+      conf->setId(model);
+      // atoms outside of the MODELs are shared by all of them:
+      for (unsigned int i=modelAtoms; i<mol->getNumAtoms(); i++)
+        conf->setAtomPos(i,mol->getConformer(0).getAtomPos(i));
+      mol->addConformer(conf,false);
     }
-    info->setTempFactor(bfactor);
+    if (atomIdx >= modelAtoms)
+      return false;
+    // the atoms are matched by position, so they have to be the same
+    // atoms in the same order:
+    const AtomPDBResidueInfo *info = static_cast<const AtomPDBResidueInfo *>(
+        mol->getAtomWithIdx(atomIdx)->getMonomerInfo());
+    if (!info || info->getSerialNumber() != serialno ||
+        info->getName().size() != 4 ||
+        memcmp(info->getName().c_str(),ptr+12,4))
+      return false;
+    if (len >= 38) {
+      RDGeom::Point3D pos = PDBAtomPosition(ptr,len,serialno);
+      if (pos.z != 0.0)
+        conf->set3D(true);
+      conf->setAtomPos(atomIdx,pos);
+    }
+    atomIdx++;
+    return true;
+  }
+
+  // called at the end of each MODEL, returns false if the MODEL has
+  // fewer atoms than the first one
+  static bool PDBEndModel(RWMol *mol, Conformer *&conf,
+                          unsigned int &atomIdx, unsigned int &nModels,
+                          unsigned int &modelAtoms)
+  {
+    if (!nModels)
+      modelAtoms = mol->getNumAtoms();
+    else if (atomIdx != modelAtoms)
+      return false;
+    nModels++;
+    conf = 0;
+    atomIdx = 0;
+    return true;
   }
 
   static void PDBBondLine(RWMol *mol, const char *ptr, unsigned int len,
@@ -276,7 +490,8 @@ namespace RDKit {
     int src, dst;
 
     try {
-      src = FileParserUtils::toInt(tmp);
+      if (!PDBParseHybrid36(ptr+6,5,src))
+        src = FileParserUtils::toInt(tmp);
       if (amap.find(src) == amap.end())
         return;
     } catch (boost::bad_lexical_cast &) {
@@ -289,7 +504,8 @@ namespace RDKit {
         if (!memcmp(ptr+pos,"     ",5))
           break;
         try {
-          dst = FileParserUtils::toInt(std::string(ptr+pos,5));
+          if (!PDBParseHybrid36(ptr+pos,5,dst))
+            dst = FileParserUtils::toInt(std::string(ptr+pos,5));
           if (dst==src || amap.find(dst) == amap.end())
             continue;
         } catch (boost::bad_lexical_cast &) {
@@ -427,14 +643,26 @@ namespace RDKit {
     }
   }
 
-  RWMol *PDBBlockToMol(const char *str, bool sanitize,
-                     bool removeHs, unsigned int flavor)
+  // reads the records of a block. With readModels, the MODELs after
+  // the first one are read as conformers and atoms outside of the
+  // MODELs (e.g. HETATMs after the last ENDMDL) are added to the first
+  // one and shared by all of them. If a MODEL doesn't have the same
+  // atoms as the first one, modelsMatch is set to false and nothing is
+  // returned. Without readModels, the atoms of all MODELs are added to
+  // the molecule.
+  static RWMol *PDBReadRecords(const char *str, unsigned int flavor,
+                               bool readModels, std::map<int,Atom*> &amap,
+                               std::map<Bond*,int> &bmap, bool &modelsMatch)
   {
-    PRECONDITION(str,"bad char ptr");
-    std::map<int,Atom*> amap;
-    std::map<Bond*,int> bmap;
     RWMol *mol = 0;
-    Utils::LocaleSwitcher ls;
+    PDBResidueState residue;
+    modelsMatch = true;
+    unsigned int nModels = 0;
+    unsigned int modelAtoms = 0;
+    bool inModel = false;
+    bool modelHasAtoms = false;
+    Conformer *conf = 0;
+    unsigned int confAtomIdx = 0;
 
     while (*str) {
       unsigned int len;
@@ -457,17 +685,44 @@ namespace RDKit {
         next++;
       }
 
-      // ATOM records
-      if (str[0]=='A' && str[1]=='T' && str[2]=='O' &&
-          str[3]=='M' && str[4]==' ' && str[5]==' ') {
-        if (!mol) mol = new RWMol();
-        PDBAtomLine(mol,str,len,flavor,amap);
-
-      // HETATM records
-      } else if (str[0]=='H' && str[1]=='E' && str[2]=='T' &&
-                 str[3]=='A' && str[4]=='T' && str[5]=='M') {
+      // ATOM and HETATM records
+      if ((str[0]=='A' && str[1]=='T' && str[2]=='O' &&
+           str[3]=='M' && str[4]==' ' && str[5]==' ') ||
+          (str[0]=='H' && str[1]=='E' && str[2]=='T' &&
+           str[3]=='A' && str[4]=='T' && str[5]=='M')) {
         if (!mol) mol = new RWMol();
-        PDBAtomLine(mol,str,len,flavor,amap);
+        if (!nModels) {
+          PDBAtomLine(mol,str,len,flavor,amap,residue);
+          modelHasAtoms = true;
+        } else if (inModel) {
+          if (!PDBModelAtomLine(mol,str,len,flavor,conf,confAtomIdx,nModels,
+                                modelAtoms)) {
+            modelsMatch = false;
+            break;
+          }
+          modelHasAtoms = true;
+        } else {
+          unsigned int idx = mol->getNumAtoms();
+          PDBAtomLine(mol,str,len,flavor,amap,residue);
+          if (mol->getNumAtoms() > idx && mol->getNumConformers() > 1) {
+            RDGeom::Point3D pos = mol->getConformer(0).getAtomPos(idx);
+            for (ROMol::ConformerIterator ci=mol->beginConformers();
+                 ci!=mol->endConformers(); ++ci)
+              (*ci)->setAtomPos(idx,pos);
+          }
+        }
+      // MODEL and ENDMDL records
+      } else if ((str[0]=='M' && str[1]=='O' && str[2]=='D' &&
+                  str[3]=='E' && str[4]=='L' && str[5]==' ') ||
+                 (str[0]=='E' && str[1]=='N' && str[2]=='D' &&
+                  str[3]=='M' && str[4]=='D' && str[5]=='L')) {
+        if (readModels && modelHasAtoms && mol->getNumAtoms() &&
+            !PDBEndModel(mol,conf,confAtomIdx,nModels,modelAtoms)) {
+          modelsMatch = false;
+          break;
+        }
+        modelHasAtoms = false;
+        inModel = str[0]=='M';
       // CONECT records
       } else if (str[0]=='C' && str[1]=='O' && str[2]=='N' &&
                  str[3]=='E' && str[4]=='C' && str[5]=='T') {
@@ -488,10 +743,34 @@ namespace RDKit {
       str = next;
     }
 
+    if (modelsMatch && nModels && modelHasAtoms)
+      modelsMatch = PDBEndModel(mol,conf,confAtomIdx,nModels,modelAtoms);
+    if (!modelsMatch) {
+      delete mol;
+      amap.clear();
+      bmap.clear();
+      return (RWMol*)0;
+    }
+    return mol;
+  }
+
+  RWMol *PDBBlockToMol(const char *str, bool sanitize,
+                     bool removeHs, unsigned int flavor)
+  {
+    PRECONDITION(str,"bad char ptr");
+    std::map<int,Atom*> amap;
+    std::map<Bond*,int> bmap;
+    Utils::LocaleSwitcher ls;
+    bool modelsMatch;
+    RWMol *mol = PDBReadRecords(str,flavor,true,amap,bmap,modelsMatch);
+    // if the MODELs can't be read as conformers (e.g. docked poses of
+    // different ligands), all of their atoms are kept instead:
+    if (!modelsMatch)
+      mol = PDBReadRecords(str,flavor,false,amap,bmap,modelsMatch);
     if (!mol)
       return (RWMol*)0;
 
-    ConnectTheDots(mol);
+    ConnectTheDots(mol,(flavor & 2) != 0);
     StandardPDBResidueBondOrders(mol);
 
     for (std::map<int,Atom*>::iterator mi=amap.begin(); mi!=amap.end(); ++mi)
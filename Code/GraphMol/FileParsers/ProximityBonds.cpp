@@ -9,6 +9,8 @@
 //
 #include "ProximityBonds.h"
 #include <algorithm>
+#include <map>
+#include <vector>
 #include <GraphMol/RDKitBase.h>
 #include <GraphMol/RWMol.h>
 #include <GraphMol/MonomerInfo.h>
@@ -116,18 +118,20 @@ static void ConnectTheDots_Medium(RWMol *mol)
 }
 
 
-#define HASHSIZE 1024
-#define HASHMASK 1023
 #define HASHX     571
 #define HASHY     127
 #define HASHZ       3
 
-static void ConnectTheDots_Large(RWMol *mol)
+static void ConnectTheDots_Large(RWMol *mol,const std::vector<int> *skip)
 {
-  int HashTable[HASHSIZE];
-  memset(HashTable,-1,sizeof(HashTable));
-
   unsigned int count = mol->getNumAtoms();
+  // the table grows with the molecule so that the chains stay short
+  unsigned int hashSize = 1024;
+  while (hashSize < count)
+    hashSize <<= 1;
+  unsigned int hashMask = hashSize-1;
+  std::vector<int> HashTable(hashSize,-1);
+
   ProximityEntry *tmp = (ProximityEntry*)malloc(count*sizeof(ProximityEntry));
   PeriodicTable *table = PeriodicTable::getTable();
   Conformer *conf = &mol->getConformer();
@@ -151,10 +155,11 @@ static void ConnectTheDots_Large(RWMol *mol)
       for (int dy = -HASHY; dy <= HASHY; dy += HASHY)
         for (int dz = -HASHZ; dz <= HASHZ; dz += HASHZ) {
           int probe = hash + dx + dy + dz;
-          int list = HashTable[probe & HASHMASK];
+          int list = HashTable[probe & hashMask];
           while (list != -1) {
             ProximityEntry *tmpj = &tmp[list];
             if (tmpj->hash == probe &&
+                (!skip || (*skip)[i]<0 || (*skip)[i]!=(*skip)[list]) &&
                 IsBonded(tmpi,tmpj) &&
                 !mol->getBondBetweenAtoms(tmpi->atm,tmpj->atm))
               mol->addBond(tmpi->atm,tmpj->atm,Bond::SINGLE);
@@ -162,7 +167,7 @@ static void ConnectTheDots_Large(RWMol *mol)
           }
         }
 
-    int list = hash & HASHMASK;
+    int list = hash & hashMask;
     tmpi->next =HashTable[list];
     HashTable[list] = i;
     tmpi->hash = hash;
@@ -171,15 +176,6 @@ static void ConnectTheDots_Large(RWMol *mol)
 }
 
 
-void ConnectTheDots(RWMol *mol)
-{
-  if (!mol || !mol->getNumConformers())
-    return;
-  // Determine optimal algorithm to use by getNumAtoms()?
-  ConnectTheDots_Large(mol);
-}
-
-
 bool SamePDBResidue(AtomPDBResidueInfo *p, AtomPDBResidueInfo *q)
 {
   return p->getResidueNumber() == q->getResidueNumber() &&
@@ -192,6 +188,202 @@ bool SamePDBResidue(AtomPDBResidueInfo *p, AtomPDBResidueInfo *q)
 #define BCNAM(A,B,C)    (((A)<<16) | ((B)<<8) | (C))
 #define BCATM(A,B,C,D)  (((A)<<24) | ((B)<<16) | ((C)<<8) | (D))
 
+
+// The bonds between the heavy atoms of the standard amino acids,
+// as pairs of PDB atom names. The backbone bonds are common to all
+// of them and are not repeated.
+static const char *BackboneBonds[] = {
+  " N  "," CA ",  " CA "," C  ",  " C  "," O  ",  " C  "," OXT",
+  0 };
+static const char *ARGBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD ",  " CD "," NE ",
+  " NE "," CZ ",  " CZ "," NH1",  " CZ "," NH2",  0 };
+static const char *ASNBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," OD1",  " CG "," ND2",  0 };
+static const char *ASPBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," OD1",  " CG "," OD2",  0 };
+static const char *CYSBonds[] = {
+  " CA "," CB ",  " CB "," SG ",  0 };
+static const char *GLNBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD ",  " CD "," OE1",
+  " CD "," NE2",  0 };
+static const char *GLUBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD ",  " CD "," OE1",
+  " CD "," OE2",  0 };
+static const char *GLYBonds[] = {
+  0 };
+static const char *HISBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," ND1",  " CG "," CD2",
+  " ND1"," CE1",  " CE1"," NE2",  " NE2"," CD2",  0 };
+static const char *ILEBonds[] = {
+  " CA "," CB ",  " CB "," CG1",  " CB "," CG2",  " CG1"," CD1",  0 };
+static const char *LEUBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD1",  " CG "," CD2",  0 };
+static const char *LYSBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD ",  " CD "," CE ",
+  " CE "," NZ ",  0 };
+static const char *METBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," SD ",  " SD "," CE ",  0 };
+static const char *PHEBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD1",  " CG "," CD2",
+  " CD1"," CE1",  " CD2"," CE2",  " CE1"," CZ ",  " CE2"," CZ ",  0 };
+static const char *PROBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD ",  " CD "," N  ",  0 };
+static const char *SERBonds[] = {
+  " CA "," CB ",  " CB "," OG ",  0 };
+static const char *THRBonds[] = {
+  " CA "," CB ",  " CB "," OG1",  " CB "," CG2",  0 };
+static const char *TRPBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD1",  " CG "," CD2",
+  " CD1"," NE1",  " NE1"," CE2",  " CD2"," CE2",  " CD2"," CE3",
+  " CE2"," CZ2",  " CE3"," CZ3",  " CZ2"," CH2",  " CZ3"," CH2",  0 };
+static const char *TYRBonds[] = {
+  " CA "," CB ",  " CB "," CG ",  " CG "," CD1",  " CG "," CD2",
+  " CD1"," CE1",  " CD2"," CE2",  " CE1"," CZ ",  " CE2"," CZ ",
+  " CZ "," OH ",  0 };
+static const char *VALBonds[] = {
+  " CA "," CB ",  " CB "," CG1",  " CB "," CG2",  0 };
+static const char *ALABonds[] = {
+  " CA "," CB ",  0 };
+
+
+static const char **StandardPDBResidueTemplate(const std::string &resnam)
+{
+  if (resnam.size() != 3)
+    return 0;
+  switch(BCNAM(resnam[0],resnam[1],resnam[2])) {
+  case BCNAM('A','L','A'):  return ALABonds;
+  case BCNAM('A','R','G'):  return ARGBonds;
+  case BCNAM('A','S','N'):  return ASNBonds;
+  case BCNAM('A','S','P'):  return ASPBonds;
+  case BCNAM('C','Y','S'):  return CYSBonds;
+  case BCNAM('G','L','N'):  return GLNBonds;
+  case BCNAM('G','L','U'):  return GLUBonds;
+  case BCNAM('G','L','Y'):  return GLYBonds;
+  case BCNAM('H','I','S'):  return HISBonds;
+  case BCNAM('I','L','E'):  return ILEBonds;
+  case BCNAM('L','E','U'):  return LEUBonds;
+  case BCNAM('L','Y','S'):  return LYSBonds;
+  case BCNAM('M','E','T'):  return METBonds;
+  case BCNAM('P','H','E'):  return PHEBonds;
+  case BCNAM('P','R','O'):  return PROBonds;
+  case BCNAM('S','E','R'):  return SERBonds;
+  case BCNAM('T','H','R'):  return THRBonds;
+  case BCNAM('T','R','P'):  return TRPBonds;
+  case BCNAM('T','Y','R'):  return TYRBonds;
+  case BCNAM('V','A','L'):  return VALBonds;
+  }
+  return 0;
+}
+
+
+static unsigned int PDBAtomNameCode(const char *name)
+{
+  return BCATM(name[0],name[1],name[2],name[3]);
+}
+
+
+static bool InPDBResidueTemplate(const char **bonds, unsigned int code)
+{
+  for (unsigned int i=0; bonds[i]; i++)
+    if (PDBAtomNameCode(bonds[i]) == code)
+      return true;
+  return false;
+}
+
+
+static void AddTemplateBonds(RWMol *mol, const char **bonds,
+                             const std::map<unsigned int,int> &names)
+{
+  for (unsigned int i=0; bonds[i]; i+=2) {
+    std::map<unsigned int,int>::const_iterator p,q;
+    p = names.find(PDBAtomNameCode(bonds[i]));
+    if (p == names.end() || p->second < 0)
+      continue;
+    q = names.find(PDBAtomNameCode(bonds[i+1]));
+    if (q == names.end() || q->second < 0)
+      continue;
+    if (!mol->getBondBetweenAtoms(p->second,q->second))
+      mol->addBond(p->second,q->second,Bond::SINGLE);
+  }
+}
+
+
+static void AddResidueBonds(RWMol *mol, const char **bonds,
+                            const std::map<unsigned int,int> &names)
+{
+  AddTemplateBonds(mol,BackboneBonds,names);
+  AddTemplateBonds(mol,bonds,names);
+}
+
+
+// Adds the bonds within standard amino acid residues from templates.
+// On return resIdx[i] is the index of the residue atom i belongs to if
+// the template covers the atom, -1 otherwise.  Hydrogens, unusual
+// atom names, HETATMs and repeated atom names (e.g. alternate
+// locations) are not covered and are left to the distance search.
+static void StandardPDBResidueBonds(RWMol *mol, std::vector<int> &resIdx)
+{
+  unsigned int count = mol->getNumAtoms();
+  resIdx.resize(count);
+  std::fill(resIdx.begin(),resIdx.end(),-1);
+
+  std::map<unsigned int,int> names;
+  const char **bonds = 0;
+  AtomPDBResidueInfo *prev = 0;
+  int curr = -1;
+  for (unsigned int i=0; i<count; i++) {
+    Atom *atom = mol->getAtomWithIdx(i);
+    AtomPDBResidueInfo *info = (AtomPDBResidueInfo*)atom->getMonomerInfo();
+    if (!info || info->getMonomerType() != AtomMonomerInfo::PDBRESIDUE ||
+        info->getIsHeteroAtom()) {
+      prev = 0;
+      continue;
+    }
+    if (!prev || !SamePDBResidue(prev,info)) {
+      if (bonds)
+        AddResidueBonds(mol,bonds,names);
+      names.clear();
+      bonds = StandardPDBResidueTemplate(info->getResidueName());
+      curr++;
+    }
+    prev = info;
+    if (!bonds || atom->getAtomicNum() == 1 || info->getName().size() != 4)
+      continue;
+
+    unsigned int code = PDBAtomNameCode(info->getName().c_str());
+    if (!InPDBResidueTemplate(BackboneBonds,code) &&
+        !InPDBResidueTemplate(bonds,code))
+      continue;
+    std::map<unsigned int,int>::iterator pos = names.find(code);
+    if (pos == names.end()) {
+      names[code] = i;
+      resIdx[i] = curr;
+    } else if (pos->second >= 0) {
+      // a repeated name, leave all copies to the distance search
+      resIdx[pos->second] = -1;
+      pos->second = -1;
+    }
+  }
+  if (bonds)
+    AddResidueBonds(mol,bonds,names);
+}
+
+
+void ConnectTheDots(RWMol *mol, bool useResidueTemplates)
+{
+  if (!mol || !mol->getNumConformers())
+    return;
+  if (useResidueTemplates) {
+    std::vector<int> resIdx;
+    StandardPDBResidueBonds(mol,resIdx);
+    ConnectTheDots_Large(mol,&resIdx);
+  } else {
+    // Determine optimal algorithm to use by getNumAtoms()?
+    ConnectTheDots_Large(mol,0);
+  }
+}
+
 static bool StandardPDBDoubleBond(unsigned int rescode,
                                   unsigned int atm1,
                                   unsigned int atm2)
@@ -12,7 +12,12 @@
 #include <GraphMol/RWMol.h>
 
 namespace RDKit {
-  void ConnectTheDots(RWMol *mol);
+  //! adds single bonds between atoms that are close enough to be bonded
+  /*!
+    If \c useResidueTemplates is set, the bonds between the heavy atoms
+    of standard amino acid residues are taken from templates instead.
+  */
+  void ConnectTheDots(RWMol *mol, bool useResidueTemplates=false);
   void StandardPDBResidueBondOrders(RWMol *mol);
 }
 
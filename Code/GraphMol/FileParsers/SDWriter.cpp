@@ -66,20 +66,45 @@ namespace RDKit {
     d_props = propNames;
   }
 
-  void SDWriter::write(const ROMol &mol, int confId) {
-    PRECONDITION(dp_ostream,"no output stream");
+  namespace {
+    void writeProperty(std::ostream &ostrm,const ROMol &mol,
+                       const std::string &name,unsigned int molid) {
+      // write the property value
+      // FIX: we will assume for now that the desired property value is 
+      // catable to a string 
+      std::string pval;
+      try {
+        mol.getProp(name, pval);
+      } catch (boost::bad_any_cast &){
+        return;
+      }
+
+      // write the property header line
+      ostrm << ">  <" << name << ">  " << "(" << molid+1 << ") " << "\n";
+    
+      ostrm << pval << "\n";
+    
+      // empty line after the property
+      ostrm << "\n";
+    }
+  }
+
+  std::string SDWriter::getText(const ROMol &mol,int confId,bool kekulize,
+                                bool forceV3000,unsigned int molid,
+                                const STR_VECT &propNames) {
+    std::ostringstream ostrm;
 
     // write the molecule 
-    (*dp_ostream) << MolToMolBlock(mol, true, confId, df_kekulize, df_forceV3000);
+    ostrm << MolToMolBlock(mol, true, confId, kekulize, forceV3000);
 
     // now write the properties
     STR_VECT_CI pi;
-    if (d_props.size() > 0) {
+    if (propNames.size() > 0) {
       // check if we have any properties the user specified to write out
       // in which loop over them and write them out
-      for (pi = d_props.begin(); pi != d_props.end(); pi++) {
+      for (pi = propNames.begin(); pi != propNames.end(); pi++) {
 	if (mol.hasProp(*pi)) {
-	  writeProperty(mol, (*pi));
+	  writeProperty(ostrm, mol, (*pi), molid);
 	}
       }
     }
@@ -105,36 +130,21 @@ namespace RDKit {
 
 	// check if this property is not computed
 	if (std::find(compLst.begin(), compLst.end(), (*pi)) == compLst.end()) {
-	  writeProperty(mol, (*pi));
+	  writeProperty(ostrm, mol, (*pi), molid);
 	}
       }
     }
     // add the $$$$ that marks the end of a molecule
-    (*dp_ostream) << "$$$$\n";
-
-    ++d_molid;
+    ostrm << "$$$$\n";
+    return ostrm.str();
   }
 
-  void SDWriter::writeProperty(const ROMol &mol, std::string name) {
+  void SDWriter::write(const ROMol &mol, int confId) {
     PRECONDITION(dp_ostream,"no output stream");
 
-    // write the property value
-    // FIX: we will assume for now that the desired property value is 
-    // catable to a string 
-    std::string pval;
-    try {
-      mol.getProp(name, pval);
-    } catch (boost::bad_any_cast &){
-      return;
-    }
+    (*dp_ostream) << getText(mol, confId, df_kekulize, df_forceV3000, d_molid, d_props);
 
-    // write the property header line
-    (*dp_ostream) << ">  <" << name << ">  " << "(" << d_molid+1 << ") " << "\n";
-    
-    (*dp_ostream) << pval << "\n";
-    
-    // empty line after the property
-    (*dp_ostream) << "\n";
+    ++d_molid;
   }
     
 }
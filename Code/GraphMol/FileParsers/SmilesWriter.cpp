@@ -85,22 +85,29 @@ namespace RDKit {
     d_props = propNames;
   }
 
-  void SmilesWriter::dumpHeader() const {
-    CHECK_INVARIANT(dp_ostream,"no output stream");
-    if(df_includeHeader){
-      (*dp_ostream) << "SMILES" << d_delim;
-      if(d_nameHeader!="") (*dp_ostream) << d_nameHeader << d_delim;
+  std::string SmilesWriter::getHeaderText(const std::string &delimiter,
+                                          const std::string &nameHeader,
+                                          const STR_VECT &propNames) {
+    std::string res="SMILES"+delimiter;
+    if(nameHeader!="") res += nameHeader+delimiter;
 
-      if (d_props.size() > 0) {
-	STR_VECT_CI pi = d_props.begin();
-	(*dp_ostream) << (*pi);
+    if (propNames.size() > 0) {
+      STR_VECT_CI pi = propNames.begin();
+      res += (*pi);
+      pi++;
+      while (pi != propNames.end()) {
+	res += delimiter + (*pi);
 	pi++;
-	while (pi != d_props.end()) {
-	  (*dp_ostream) << d_delim << (*pi);
-	  pi++;
-	}
       }
-      (*dp_ostream) << "\n";
+    }
+    res += "\n";
+    return res;
+  }
+
+  void SmilesWriter::dumpHeader() const {
+    CHECK_INVARIANT(dp_ostream,"no output stream");
+    if(df_includeHeader){
+      (*dp_ostream) << getHeaderText(d_delim,d_nameHeader,d_props);
     }
   }
 
@@ -115,28 +122,25 @@ namespace RDKit {
     }
   }
 
-  void SmilesWriter::write(const ROMol &mol,int confId) {
-    CHECK_INVARIANT(dp_ostream,"no output stream");
-    if(d_molid<=0 && df_includeHeader){
-      dumpHeader();
-    }
-    
-    std::string name, smi = MolToSmiles(mol,df_isomericSmiles,df_kekuleSmiles);
-    (*dp_ostream) << smi;
-    if(d_nameHeader!=""){
+  std::string SmilesWriter::getText(const ROMol &mol,const std::string &delimiter,
+                                    bool includeName,const STR_VECT &propNames,
+                                    bool isomericSmiles,bool kekuleSmiles,
+                                    unsigned int molid) {
+    std::string name, res = MolToSmiles(mol,isomericSmiles,kekuleSmiles);
+    if(includeName){
       if (mol.hasProp("_Name") ) {
         mol.getProp("_Name", name);
       } else {
         std::stringstream tstream;
-        tstream << d_molid;
+        tstream << molid;
         name = tstream.str();
       }
     
-      (*dp_ostream) << d_delim << name;
+      res += delimiter + name;
     }
 
     STR_VECT_CI pi;
-    for (pi = d_props.begin(); pi != d_props.end(); pi++) {
+    for (pi = propNames.begin(); pi != propNames.end(); pi++) {
       std::string pval;
       if (mol.hasProp(*pi)) {
 	// FIX: we will assume that any property that the user requests is castable to
@@ -146,9 +150,20 @@ namespace RDKit {
       else {
 	pval = "";
       }
-      (*dp_ostream) << d_delim << pval;
+      res += delimiter + pval;
     }
-    (*dp_ostream) << "\n";
+    res += "\n";
+    return res;
+  }
+
+  void SmilesWriter::write(const ROMol &mol,int confId) {
+    CHECK_INVARIANT(dp_ostream,"no output stream");
+    if(d_molid<=0 && df_includeHeader){
+      dumpHeader();
+    }
+    
+    (*dp_ostream) << getText(mol,d_delim,d_nameHeader!="",d_props,
+                             df_isomericSmiles,df_kekuleSmiles,d_molid);
     d_molid++;
   }
 
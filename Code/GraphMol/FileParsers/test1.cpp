@@ -24,6 +24,7 @@
 
 #include <string>
 #include <fstream>
+#include <sstream>
 #include <boost/lexical_cast.hpp>
 
 using namespace RDKit;
@@ -3523,6 +3524,227 @@ void testPDBFile(){
 }
 
 
+void testPDBModelsAndTemplates(){
+  BOOST_LOG(rdInfoLog) << "testing multi-model PDB files and residue templates" << std::endl;
+  std::string rdbase = getenv("RDBASE");
+  rdbase += "/Code/GraphMol/FileParsers/test_data/";
+
+  std::vector<std::string> atomLines;
+  {
+    std::ifstream inStream((rdbase+"1CRN.pdb").c_str());
+    std::string line;
+    while(std::getline(inStream,line)){
+      if(line.substr(0,6)=="ATOM  ") atomLines.push_back(line);
+    }
+  }
+  TEST_ASSERT(atomLines.size()==327);
+
+  {
+    // two models, the second one shifted along x:
+    std::string block="MODEL        1\n";
+    for(unsigned int i=0;i<atomLines.size();++i) block += atomLines[i]+"\n";
+    block += "ENDMDL\nMODEL        2\n";
+    for(unsigned int i=0;i<atomLines.size();++i){
+      std::string line=atomLines[i];
+      double x=atof(line.substr(30,8).c_str());
+      char buf[16];
+      sprintf(buf,"%8.3f",x+10.0);
+      line.replace(30,8,buf);
+      block += line+"\n";
+    }
+    block += "ENDMDL\nEND\n";
+    RWMol *m=PDBBlockToMol(block);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==327);
+    TEST_ASSERT(m->getNumBonds()==337);
+    TEST_ASSERT(m->getNumConformers()==2);
+    const Conformer &c1=m->getConformer(0);
+    const Conformer &c2=m->getConformer(1);
+    for(unsigned int i=0;i<m->getNumAtoms();++i){
+      TEST_ASSERT(feq(c2.getAtomPos(i).x-c1.getAtomPos(i).x,10.0));
+      TEST_ASSERT(feq(c2.getAtomPos(i).y,c1.getAtomPos(i).y));
+    }
+    delete m;
+
+    // HETATMs after the last ENDMDL are shared by all the models:
+    std::string hetBlock=block.substr(0,block.rfind("END\n"));
+    hetBlock += "HETATM  328  O   HOH A 100      30.000  20.000  10.000  1.00  0.00           O\n";
+    hetBlock += "END\n";
+    m=PDBBlockToMol(hetBlock);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==328);
+    TEST_ASSERT(m->getNumConformers()==2);
+    TEST_ASSERT(m->getAtomWithIdx(327)->getAtomicNum()==8);
+    TEST_ASSERT(feq(m->getConformer(0).getAtomPos(327).x,30.0));
+    TEST_ASSERT(feq(m->getConformer(1).getAtomPos(327).x,30.0));
+    TEST_ASSERT(feq(m->getConformer(1).getAtomPos(327).z,10.0));
+    delete m;
+
+    // if the models don't have the same atoms, all of them are kept
+    // (one conformer with the atoms of both models). The second model is
+    // moved far enough away that the two aren't bonded to each other:
+    std::string::size_type pos=block.find("MODEL        2\n");
+    std::vector<std::string> model2Lines;
+    for(unsigned int i=0;i<atomLines.size();++i){
+      std::string line=atomLines[i];
+      double x=atof(line.substr(30,8).c_str());
+      char buf[16];
+      sprintf(buf,"%8.3f",x+100.0);
+      line.replace(30,8,buf);
+      model2Lines.push_back(line);
+    }
+    // a model missing an atom:
+    std::string shortBlock=block.substr(0,pos)+"MODEL        2\n";
+    for(unsigned int i=0;i<model2Lines.size()-1;++i) shortBlock += model2Lines[i]+"\n";
+    shortBlock += "ENDMDL\nEND\n";
+    m=PDBBlockToMol(shortBlock);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==2*327-1);
+    TEST_ASSERT(m->getNumConformers()==1);
+    TEST_ASSERT(feq(m->getConformer().getAtomPos(327).x-m->getConformer().getAtomPos(0).x,
+                    100.0));
+    delete m;
+
+    // a model with its atoms in a different order:
+    std::string swapBlock=block.substr(0,pos)+"MODEL        2\n"+model2Lines[1]+"\n"+
+      model2Lines[0]+"\n";
+    for(unsigned int i=2;i<model2Lines.size();++i) swapBlock += model2Lines[i]+"\n";
+    swapBlock += "ENDMDL\nEND\n";
+    m=PDBBlockToMol(swapBlock);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==2*327);
+    TEST_ASSERT(m->getNumConformers()==1);
+    delete m;
+
+    // or a different atom name:
+    std::string renamedBlock=block.substr(0,pos)+"MODEL        2\n";
+    for(unsigned int i=0;i<model2Lines.size();++i){
+      std::string line=model2Lines[i];
+      if(i==5) line.replace(12,4," CX ");
+      renamedBlock += line+"\n";
+    }
+    renamedBlock += "ENDMDL\nEND\n";
+    m=PDBBlockToMol(renamedBlock);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==2*327);
+    TEST_ASSERT(m->getNumConformers()==1);
+    delete m;
+
+    // a model with more atoms than the first, e.g. the poses of two
+    // different ligands:
+    std::string ligBlock="MODEL        1\n";
+    ligBlock += "HETATM    1  C1  LIG A   1       0.000   0.000   0.000  1.00  0.00           C\n";
+    ligBlock += "HETATM    2  O1  LIG A   1       1.400   0.000   0.000  1.00  0.00           O\n";
+    ligBlock += "ENDMDL\nMODEL        2\n";
+    ligBlock += "HETATM    1  C1  LIG A   1      10.000   0.000   0.000  1.00  0.00           C\n";
+    ligBlock += "HETATM    2  C2  LIG A   1      11.500   0.000   0.000  1.00  0.00           C\n";
+    ligBlock += "HETATM    3  O1  LIG A   1      12.900   0.000   0.000  1.00  0.00           O\n";
+    ligBlock += "ENDMDL\nEND\n";
+    m=PDBBlockToMol(ligBlock);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==5);
+    TEST_ASSERT(m->getNumConformers()==1);
+    TEST_ASSERT(m->getNumBonds()==3);
+    delete m;
+  }
+
+  {
+    // stretch the CA-CB bond of the first residue beyond the proximity
+    // cutoff; only the residue templates recover it:
+    std::string block;
+    for(unsigned int i=0;i<atomLines.size();++i){
+      std::string line=atomLines[i];
+      if(i==4){
+        line.replace(30,24,"  18.657  12.670   5.742");
+      }
+      block += line+"\n";
+    }
+    block += "END\n";
+    RWMol *m=PDBBlockToMol(block,true,true,0);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==327);
+    TEST_ASSERT(!m->getBondBetweenAtoms(1,4));
+    delete m;
+    m=PDBBlockToMol(block,true,true,2);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==327);
+    TEST_ASSERT(m->getNumBonds()==337);
+    TEST_ASSERT(m->getBondBetweenAtoms(1,4));
+    delete m;
+
+    // on an intact structure the templates agree with the proximity bonds:
+    m=PDBFileToMol(rdbase+"1CRN.pdb",true,true,2);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==327);
+    TEST_ASSERT(m->getNumBonds()==337);
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
+
+namespace {
+  // formats a PDB serial or residue number, using hybrid-36 for
+  // numbers that do not fit in the field
+  std::string hybrid36(unsigned int width,int value){
+    int pow10=1,pow36=1;
+    for(unsigned int i=0;i<width;++i) pow10*=10;
+    for(unsigned int i=1;i<width;++i) pow36*=36;
+    char buf[16];
+    if(value<pow10){
+      sprintf(buf,"%*d",width,value);
+      return buf;
+    }
+    value=value-pow10+10*pow36;
+    const char *digits="0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    std::string res(width,'0');
+    for(unsigned int i=width;i>0;--i){
+      res[i-1]=digits[value%36];
+      value/=36;
+    }
+    return res;
+  }
+}
+
+void testPDBHybrid36(){
+  BOOST_LOG(rdInfoLog) << "testing hybrid-36 serial and residue numbers in PDB files" << std::endl;
+  {
+    // one water oxygen per residue, on a 4A grid:
+    const unsigned int nAtoms=100005;
+    std::string block;
+    block.reserve(82*(nAtoms+3));
+    for(unsigned int i=0;i<nAtoms;++i){
+      char buf[96];
+      sprintf(buf,"HETATM%5s  O   HOH A%4s    %8.3f%8.3f%8.3f  1.00  0.00           O\n",
+              hybrid36(5,i+1).c_str(),hybrid36(4,i+1).c_str(),
+              4.0*(i%47),4.0*((i/47)%47),4.0*(i/(47*47)));
+      block += buf;
+    }
+    TEST_ASSERT(hybrid36(5,100000)=="A0000");
+    TEST_ASSERT(hybrid36(4,10000)=="A000");
+    // serial numbers with lower case digits come after ZZZZZ:
+    block += "HETATM"+std::string("a0000")+"  O   HOH B   1     -20.000 -20.000 -20.000  1.00  0.00           O\n";
+    block += "CONECT"+hybrid36(5,100004)+hybrid36(5,100005)+"\n";
+    block += "CONECT"+hybrid36(5,100005)+hybrid36(5,100004)+"\n";
+    block += "END\n";
+    RWMol *m=PDBBlockToMol(block,false,false);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==nAtoms+1);
+    TEST_ASSERT(m->getNumBonds()==1);
+    TEST_ASSERT(m->getBondBetweenAtoms(nAtoms-2,nAtoms-1));
+    AtomPDBResidueInfo *info=static_cast<AtomPDBResidueInfo *>(m->getAtomWithIdx(99999)->getMonomerInfo());
+    TEST_ASSERT(info->getSerialNumber()==100000);
+    TEST_ASSERT(info->getResidueNumber()==100000);
+    info=static_cast<AtomPDBResidueInfo *>(m->getAtomWithIdx(nAtoms-1)->getMonomerInfo());
+    TEST_ASSERT(info->getSerialNumber()==100005);
+    TEST_ASSERT(info->getResidueNumber()==100005);
+    info=static_cast<AtomPDBResidueInfo *>(m->getAtomWithIdx(nAtoms)->getMonomerInfo());
+    TEST_ASSERT(info->getSerialNumber()==43770016);
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
 void testGithub166(){
   BOOST_LOG(rdInfoLog) << "testing Github 166: skipping sanitization on reading pdb files" << std::endl;
   std::string rdbase = getenv("RDBASE");
@@ -3698,6 +3920,8 @@ int main(int argc,char *argv[]){
   testGithub166();
   testGithub164();
   testPDBFile();
+  testPDBModelsAndTemplates();
+  testPDBHybrid36();
   testGithub194();
   testGithub196();
   testIssue3557675();
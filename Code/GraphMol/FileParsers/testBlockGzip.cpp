@@ -0,0 +1,298 @@
+//
+//   Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <GraphMol/RDKitBase.h>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+
+#include "MolSupplier.h"
+#include "MolWriters.h"
+#include "BlockGzip.h"
+#include <RDGeneral/BadFileException.h>
+#include <RDGeneral/FileParseException.h>
+#include <RDGeneral/RDLog.h>
+#include <GraphMol/SmilesParse/SmilesWrite.h>
+
+#include <zlib.h>
+
+using namespace RDKit;
+
+namespace {
+  void readReference(const std::string &fname,std::vector<std::string> &smis,
+                     std::vector<std::string> &names){
+    SDMolSupplier suppl(fname);
+    while(!suppl.atEnd()){
+      ROMol *mol=suppl.next();
+      if(mol){
+        smis.push_back(MolToSmiles(*mol,true));
+        std::string name;
+        mol->getProp("_Name",name);
+        names.push_back(name);
+        delete mol;
+      } else {
+        smis.push_back("");
+        names.push_back("");
+      }
+    }
+  }
+}
+
+void testWriteRead(){
+  std::string rdbase = getenv("RDBASE");
+  std::string fname = rdbase + "/Code/GraphMol/FileParsers/test_data/NCI_aids_few.sdf";
+  std::string oname = rdbase + "/Code/GraphMol/FileParsers/test_data/outNCI_few.sdf.gz";
+
+  std::vector<std::string> smis,names;
+  readReference(fname,smis,names);
+  TEST_ASSERT(smis.size()==16);
+
+  std::ostringstream plainText;
+  {
+    SDMolSupplier suppl(fname);
+    // small blocks, so that we get several of them:
+    BlockGzipSDWriter writer(oname,4096);
+    SDWriter plainWriter(&plainText);
+    STR_VECT props;
+    props.push_back("NSC");
+    writer.setProps(props);
+    plainWriter.setProps(props);
+    while(!suppl.atEnd()){
+      ROMol *mol=suppl.next();
+      TEST_ASSERT(mol);
+      writer.write(*mol);
+      plainWriter.write(*mol);
+      delete mol;
+    }
+    TEST_ASSERT(writer.numMols()==16);
+    writer.close();
+    plainWriter.flush();
+  }
+
+  {
+    // the file can be read by regular gzip tools:
+    gzFile gzf=gzopen(oname.c_str(),"rb");
+    TEST_ASSERT(gzf);
+    std::string text;
+    char buf[4096];
+    int nRead;
+    while((nRead=gzread(gzf,buf,sizeof(buf)))>0){
+      text.append(buf,nRead);
+    }
+    gzclose(gzf);
+    TEST_ASSERT(text==plainText.str());
+  }
+
+  {
+    BlockGzipReader reader(oname);
+    TEST_ASSERT(reader.getNumRecords()==16);
+    TEST_ASSERT(reader.getNumBlocks()>2);
+    TEST_ASSERT(reader.getBlockInfo(0).firstRecord==0);
+    unsigned int blockIdx=reader.findBlock(15);
+    TEST_ASSERT(blockIdx==reader.getNumBlocks()-1);
+    TEST_ASSERT(reader.getBlockInfo(blockIdx).firstRecord+
+                reader.getBlockInfo(blockIdx).nRecords==16);
+  }
+
+  for(int numThreads=1;numThreads<5;numThreads+=3){
+    BlockGzipSDMolSupplier suppl(oname,true,true,true,numThreads);
+    TEST_ASSERT(suppl.length()==16);
+    unsigned int i=0;
+    while(!suppl.atEnd()){
+      ROMol *mol=suppl.next();
+      TEST_ASSERT(mol);
+      TEST_ASSERT(MolToSmiles(*mol,true)==smis[i]);
+      TEST_ASSERT(mol->hasProp("NSC"));
+      ++i;
+      delete mol;
+    }
+    TEST_ASSERT(i==16);
+
+    // random access:
+    ROMol *mol=suppl[12];
+    TEST_ASSERT(mol);
+    TEST_ASSERT(MolToSmiles(*mol,true)==smis[12]);
+    delete mol;
+    mol=suppl[3];
+    TEST_ASSERT(mol);
+    TEST_ASSERT(MolToSmiles(*mol,true)==smis[3]);
+    delete mol;
+    // next() continues after the molecule we just read:
+    mol=suppl.next();
+    TEST_ASSERT(mol);
+    TEST_ASSERT(MolToSmiles(*mol,true)==smis[4]);
+    delete mol;
+
+    std::string text=suppl.getItemText(5);
+    TEST_ASSERT(text.find(names[5])==0);
+    TEST_ASSERT(text.find("$$$$")!=std::string::npos);
+
+    bool ok=false;
+    try{
+      suppl[16];
+    } catch (FileParseException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    TEST_ASSERT(suppl.atEnd());
+
+    suppl.reset();
+    TEST_ASSERT(!suppl.atEnd());
+    mol=suppl.next();
+    TEST_ASSERT(mol);
+    TEST_ASSERT(MolToSmiles(*mol,true)==smis[0]);
+    delete mol;
+  }
+}
+
+void testCorruptBlock(){
+  std::string rdbase = getenv("RDBASE");
+  std::string fname = rdbase + "/Code/GraphMol/FileParsers/test_data/outNCI_few.sdf.gz";
+  std::string oname = rdbase + "/Code/GraphMol/FileParsers/test_data/outNCI_few_corrupt.sdf.gz";
+
+  // damage the CRC of the third block:
+  unsigned int badBlock=2;
+  BlockGzipBlockInfo badInfo;
+  unsigned int lastRecord;
+  {
+    BlockGzipReader reader(fname);
+    TEST_ASSERT(reader.getNumBlocks()>badBlock+1);
+    badInfo=reader.getBlockInfo(badBlock);
+    lastRecord=reader.getNumRecords()-1;
+    std::ifstream inf(fname.c_str(),std::ios_base::binary);
+    std::string data((std::istreambuf_iterator<char>(inf)),std::istreambuf_iterator<char>());
+    data[badInfo.offset+badInfo.size-8]^=0xFF;
+    std::ofstream outf(oname.c_str(),std::ios_base::out|std::ios_base::binary);
+    outf.write(data.c_str(),data.size());
+  }
+
+  for(int numThreads=1;numThreads<5;numThreads+=3){
+    BlockGzipSDMolSupplier suppl(oname,true,true,true,numThreads);
+    // the blocks before the damaged one can be read, even if it has
+    // been decompressed ahead of them:
+    for(unsigned int i=0;i<badInfo.firstRecord;++i){
+      ROMol *mol=suppl.next();
+      TEST_ASSERT(mol);
+      delete mol;
+    }
+    bool ok=false;
+    try{
+      suppl.next();
+    } catch (FileParseException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    // as can the ones after it:
+    ROMol *mol=suppl[lastRecord];
+    TEST_ASSERT(mol);
+    delete mol;
+  }
+
+  // an impossible uncompressed size is caught before it's allocated:
+  {
+    std::ifstream inf(fname.c_str(),std::ios_base::binary);
+    std::string data((std::istreambuf_iterator<char>(inf)),std::istreambuf_iterator<char>());
+    for(unsigned int i=4;i>0;--i) data[badInfo.offset+badInfo.size-i]=static_cast<char>(0xFF);
+    std::ofstream outf(oname.c_str(),std::ios_base::out|std::ios_base::binary);
+    outf.write(data.c_str(),data.size());
+  }
+  {
+    BlockGzipReader reader(oname);
+    std::string text;
+    bool ok=false;
+    try{
+      reader.getBlockText(badBlock,text);
+    } catch (FileParseException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    TEST_ASSERT(text.size()<100000000);
+  }
+}
+
+void testNotBlockCompressed(){
+  std::string rdbase = getenv("RDBASE");
+  std::string oname = rdbase + "/Code/GraphMol/FileParsers/test_data/outNotBlock.sdf.gz";
+  {
+    gzFile gzf=gzopen(oname.c_str(),"wb");
+    TEST_ASSERT(gzf);
+    std::string text="\n     RDKit          \n\n  0  0  0  0  0  0  0  0  0  0999 V2000\nM  END\n$$$$\n";
+    gzwrite(gzf,text.c_str(),text.size());
+    gzclose(gzf);
+  }
+  bool ok=false;
+  try{
+    BlockGzipSDMolSupplier suppl(oname);
+  } catch (BadFileException &) {
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+}
+
+void testRecords(){
+  // the low-level writer and reader work with any kind of records,
+  // here lines of SMILES:
+  std::ostringstream *ostrm=new std::ostringstream();
+  BlockGzipWriter writer(ostrm,16,6,false);
+  writer.writeRecord("c1ccccc1 benzene\n");
+  writer.writeRecord("CCO ethanol\n");
+  writer.writeRecord("CC(=O)O acetic acid\n");
+  writer.flush();
+  TEST_ASSERT(writer.numRecords()==3);
+  std::string data=ostrm->str();
+  writer.close();
+  delete ostrm;
+
+  std::string oname = getenv("RDBASE");
+  oname += "/Code/GraphMol/FileParsers/test_data/outRecords.smi.gz";
+  {
+    std::ofstream outf(oname.c_str(),std::ios_base::out|std::ios_base::binary);
+    outf.write(data.c_str(),data.size());
+  }
+  BlockGzipReader reader(oname);
+  TEST_ASSERT(reader.getNumRecords()==3);
+  // the first record is larger than the block size, so it gets a block of its own:
+  TEST_ASSERT(reader.getNumBlocks()==2);
+  TEST_ASSERT(reader.getBlockInfo(0).nRecords==1);
+  TEST_ASSERT(reader.getBlockInfo(1).nRecords==2);
+  std::string text;
+  reader.getBlockText(1,text);
+  TEST_ASSERT(text=="CCO ethanol\nCC(=O)O acetic acid\n");
+}
+
+int main() {
+  RDLog::InitLogs();
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n";
+  BOOST_LOG(rdInfoLog) << "Running testWriteRead()\n";
+  testWriteRead();
+  BOOST_LOG(rdInfoLog) << "Finished\n";
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n\n";
+
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n";
+  BOOST_LOG(rdInfoLog) << "Running testCorruptBlock()\n";
+  testCorruptBlock();
+  BOOST_LOG(rdInfoLog) << "Finished\n";
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n\n";
+
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n";
+  BOOST_LOG(rdInfoLog) << "Running testNotBlockCompressed()\n";
+  testNotBlockCompressed();
+  BOOST_LOG(rdInfoLog) << "Finished\n";
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n\n";
+
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n";
+  BOOST_LOG(rdInfoLog) << "Running testRecords()\n";
+  testRecords();
+  BOOST_LOG(rdInfoLog) << "Finished\n";
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n\n";
+
+  return 0;
+}
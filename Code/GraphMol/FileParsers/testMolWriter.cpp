@@ -16,6 +16,7 @@
 
 #include "MolSupplier.h"
 #include "MolWriters.h"
+#include "AsyncMolWriters.h"
 #include "FileParsers.h"
 #include <RDGeneral/FileParseException.h>
 #include <RDGeneral/StreamOps.h>
@@ -1043,6 +1044,78 @@ void testGithub186(){
   
 }
 
+void testAsyncWriters() {
+  BOOST_LOG(rdInfoLog) << "testing the asynchronous writers" << std::endl;
+  std::string rdbase = getenv("RDBASE");
+  std::string fname = rdbase + "/Code/GraphMol/FileParsers/test_data/NCI_aids_few.sdf";
+
+  std::vector<ROMol *> mols;
+  SDMolSupplier suppl(fname);
+  while(!suppl.atEnd()){
+    ROMol *mol=suppl.next();
+    TEST_ASSERT(mol);
+    mols.push_back(mol);
+  }
+  TEST_ASSERT(mols.size()==16);
+  // the SMILES writer uses the index of the molecule if there's no name:
+  mols[3]->clearProp("_Name");
+  STR_VECT props;
+  props.push_back("NSC");
+  props.push_back("CAS_RN");
+
+  std::ostringstream sdRef,smiRef,sdPropsRef;
+  {
+    SDWriter writer(&sdRef);
+    SDWriter propsWriter(&sdPropsRef);
+    propsWriter.setProps(props);
+    SmilesWriter smiWriter(&smiRef,"\t","Name",true,false,true);
+    smiWriter.setProps(props);
+    for(unsigned int i=0;i<mols.size();++i){
+      writer.write(*mols[i]);
+      propsWriter.write(*mols[i]);
+      smiWriter.write(*mols[i]);
+    }
+    writer.flush();
+    propsWriter.flush();
+    smiWriter.flush();
+  }
+
+  for(int numThreads=1;numThreads<5;numThreads+=3){
+    // a short queue and a small buffer so that the writers have to wait
+    // on the workers and the buffer is written several times:
+    std::ostringstream sdOut,smiOut,sdPropsOut;
+    AsyncSDWriter writer(&sdOut,false,numThreads,3,1000);
+    AsyncSDWriter propsWriter(&sdPropsOut,false,numThreads);
+    propsWriter.setProps(props);
+    AsyncSmilesWriter smiWriter(&smiOut,"\t","Name",true,false,true,false,numThreads,3,100);
+    smiWriter.setProps(props);
+    for(unsigned int i=0;i<mols.size();++i){
+      writer.write(*mols[i]);
+      propsWriter.write(*mols[i]);
+      smiWriter.write(*mols[i]);
+    }
+    TEST_ASSERT(writer.numMols()==mols.size());
+    TEST_ASSERT(smiWriter.numMols()==mols.size());
+    writer.flush();
+    TEST_ASSERT(sdOut.str()==sdRef.str());
+    propsWriter.close();
+    TEST_ASSERT(sdPropsOut.str()==sdPropsRef.str());
+    smiWriter.close();
+    TEST_ASSERT(smiOut.str()==smiRef.str());
+
+    // we can keep writing after a flush:
+    writer.write(*mols[0]);
+    writer.close();
+    TEST_ASSERT(sdOut.str().size()>sdRef.str().size());
+    TEST_ASSERT(sdOut.str().find(sdRef.str())==0);
+  }
+
+  for(unsigned int i=0;i<mols.size();++i){
+    delete mols[i];
+  }
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
 int main() {
   RDLog::InitLogs();
 #if 1
@@ -1148,5 +1221,9 @@ int main() {
   BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n";
   testGithub186();
   BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n\n";
+
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n";
+  testAsyncWriters();
+  BOOST_LOG(rdInfoLog) <<  "-----------------------------------------\n\n";
   
 }
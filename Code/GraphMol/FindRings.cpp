@@ -10,6 +10,7 @@
 //
 #include "RDKitBase.h"
 #include <GraphMol/Rings.h>
+#include <GraphMol/RelevantCycles.h>
 #include <RDGeneral/RDLog.h>
 #include <RDBoost/Exceptions.h>
 
@@ -18,6 +19,7 @@
 #include <set>
 #include <algorithm>
 #include <boost/dynamic_bitset.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/cstdint.hpp>
 #include <RDGeneral/hash/hash.hpp>
 
@@ -56,9 +58,25 @@ namespace RingUtils {
 
 namespace FindRings {
   using namespace RDKit;
+  // per-atom scratch space for smallestRingsBfs(). It is only reset for
+  // the atoms a search touched, so one of these can be reused for all the
+  // searches in a large molecule.
+  struct BfsWorkspace {
+    INT_VECT done;
+    VECT_INT_VECT atPaths;
+    INT_VECT touched;
+    explicit BfsWorkspace(unsigned int nAtoms) : done(nAtoms,0), atPaths(nAtoms) {};
+    void reset() {
+      for(INT_VECT_CI ti=touched.begin();ti!=touched.end();++ti){
+        done[*ti]=0;
+        atPaths[*ti].clear();
+      }
+      touched.clear();
+    }
+  };
   int smallestRingsBfs(const ROMol &mol, int root, VECT_INT_VECT &rings,
                        boost::dynamic_bitset<> &activeBonds,
-                       INT_VECT *forbidden=0);
+                       INT_VECT *forbidden=0,BfsWorkspace *ws=0);
   void trimBonds(unsigned int cand, const ROMol &tMol, INT_SET &changed,
                  INT_VECT &atomDegrees,boost::dynamic_bitset<> &activeBonds);
   void storeRingInfo(const ROMol &mol, const INT_VECT &ring) {
@@ -142,7 +160,8 @@ namespace FindRings {
   void findSSSRforDupCands(const ROMol &mol, VECT_INT_VECT &res, 
                            RINGINVAR_SET &invars, const INT_INT_VECT_MAP dupMap, 
                            const RINGINVAR_INT_VECT_MAP &dupD2Cands,
-                           INT_VECT &atomDegrees, boost::dynamic_bitset<> activeBonds){
+                           INT_VECT &atomDegrees, boost::dynamic_bitset<> activeBonds,
+                           BfsWorkspace *ws){
     for (RINGINVAR_INT_VECT_MAP_CI dvmi = dupD2Cands.begin();
          dvmi != dupD2Cands.end(); ++dvmi) {
       const INT_VECT &dupCands = dvmi->second;
@@ -163,7 +182,7 @@ namespace FindRings {
 
           // now find the smallest ring/s around (*dupi)
           VECT_INT_VECT srings;
-          smallestRingsBfs(mol, (*dupi), srings, activeBondsCopy);
+          smallestRingsBfs(mol, (*dupi), srings, activeBondsCopy, 0, ws);
           for (VECT_INT_VECT_CI sri = srings.begin(); sri != srings.end(); ++sri) {
             if (sri->size() < minSiz) {
               minSiz = sri->size();
@@ -248,8 +267,8 @@ namespace FindRings {
                         RINGINVAR_SET &invars, const INT_VECT &d2nodes,
                         INT_VECT &atomDegrees, boost::dynamic_bitset<> &activeBonds,
                         boost::dynamic_bitset<> &ringBonds,
-                        boost::dynamic_bitset<> &ringAtoms
-                        ) {
+                        boost::dynamic_bitset<> &ringAtoms,
+                        BfsWorkspace *ws) {
     // place to record any duplicate rings discovered from the current d2 nodes
     RINGINVAR_INT_VECT_MAP dupD2Cands;
     int cand, nsmall;
@@ -275,7 +294,7 @@ namespace FindRings {
       //std::cerr<<"    smallest rings bfs: "<<cand<<std::endl;
       VECT_INT_VECT srings;
       // we have to find all non duplicate possible smallest rings for each node
-      nsmall = smallestRingsBfs(tMol, cand, srings, activeBonds);
+      nsmall = smallestRingsBfs(tMol, cand, srings, activeBonds, 0, ws);
       for (VECT_INT_VECT_CI sri = srings.begin(); sri != srings.end(); ++sri) {
         const INT_VECT &nring = (*sri);
         boost::uint32_t invr = RingUtils::computeRingInvariant(nring,tMol.getNumAtoms());
@@ -322,11 +341,12 @@ namespace FindRings {
     // it is possible that one of these nodes is involved a different small ring, that is not found 
     // because the first nodes has not be trimmed. Here is an example molecule: 
     // CC1=CC=C(C=C1)S(=O)(=O)O[CH]2[CH]3CO[CH](O3)[CH]4OC(C)(C)O[CH]24
-    findSSSRforDupCands(tMol, res, invars, dupMap, dupD2Cands, atomDegrees, activeBonds);
+    findSSSRforDupCands(tMol, res, invars, dupMap, dupD2Cands, atomDegrees, activeBonds, ws);
   }
 
   void findRingsD3Node(const ROMol &tMol, VECT_INT_VECT &res, RINGINVAR_SET &invars, int cand,
-                       INT_VECT &atomDegrees, boost::dynamic_bitset<> activeBonds ) {
+                       INT_VECT &atomDegrees, boost::dynamic_bitset<> activeBonds,
+                       BfsWorkspace *ws) {
     // this is brutal - we have no degree 2 nodes - find the first possible degree 3 node
     int nsmall;
 
@@ -349,7 +369,7 @@ namespace FindRings {
   
     // first find all smallest possible rings
     VECT_INT_VECT srings;
-    nsmall = smallestRingsBfs(tMol, cand, srings, activeBonds);
+    nsmall = smallestRingsBfs(tMol, cand, srings, activeBonds, 0, ws);
   
     for (VECT_INT_VECT_CI sri = srings.begin(); sri != srings.end(); ++sri) {
       const INT_VECT &nring = (*sri);
@@ -403,7 +423,7 @@ namespace FindRings {
         VECT_INT_VECT trings;
         INT_VECT forb;
         forb.push_back(f);
-        smallestRingsBfs(tMol, cand, trings, activeBonds,&forb);
+        smallestRingsBfs(tMol, cand, trings, activeBonds, &forb, ws);
         for (VECT_INT_VECT_CI sri = trings.begin(); sri != trings.end(); ++sri) {
           const INT_VECT &nring = (*sri);
           boost::uint32_t invr = RingUtils::computeRingInvariant(nring,tMol.getNumAtoms());
@@ -436,7 +456,7 @@ namespace FindRings {
         VECT_INT_VECT trings;
         INT_VECT forb;
         forb.push_back(f2);
-        int nrngs = smallestRingsBfs(tMol, cand, trings, activeBonds,&forb);
+        int nrngs = smallestRingsBfs(tMol, cand, trings, activeBonds, &forb, ws);
         for (VECT_INT_VECT_CI sri = trings.begin(); sri != trings.end(); ++sri) {
           const INT_VECT &nring = (*sri);
           boost::uint32_t invr = RingUtils::computeRingInvariant(nring,tMol.getNumAtoms());
@@ -450,7 +470,7 @@ namespace FindRings {
         trings.clear();
         forb.clear();
         forb.push_back(f1);
-        nrngs = smallestRingsBfs(tMol, cand, trings, activeBonds,&forb);
+        nrngs = smallestRingsBfs(tMol, cand, trings, activeBonds, &forb, ws);
         for (VECT_INT_VECT_CI sri = trings.begin(); sri != trings.end(); ++sri) {
           const INT_VECT &nring = (*sri);
           boost::uint32_t invr = RingUtils::computeRingInvariant(nring,tMol.getNumAtoms());
@@ -538,25 +558,33 @@ namespace FindRings {
    ***********************************************************************************/
   int smallestRingsBfs(const ROMol &mol, int root, VECT_INT_VECT &rings,
                        boost::dynamic_bitset<> &activeBonds,
-                       INT_VECT *forbidden) {
+                       INT_VECT *forbidden,BfsWorkspace *ws) {
     // this function finds the smallest ring with the given root atom. 
     // if multiple smallest rings are found all of them are return
     // if any atoms are specified in the forbidden list, those atoms are avoided.
 
-    // FIX: this should be number of atoms in the fragment (if it's required at all, see below)
     const int WHITE=0,GRAY=1,BLACK=2;
-    INT_VECT done(mol.getNumAtoms(),WHITE);
+    boost::scoped_ptr<BfsWorkspace> lws;
+    if(!ws){
+      lws.reset(new BfsWorkspace(mol.getNumAtoms()));
+      ws = lws.get();
+    } else {
+      ws->reset();
+    }
+    INT_VECT &done=ws->done;
+    INT_VECT &touched=ws->touched;
 
     if (forbidden) {
       for (INT_VECT_CI dci = forbidden->begin(); dci != forbidden->end(); dci++) {
         done[*dci]=BLACK;
+        touched.push_back(*dci);
       }
     }
 
     // it would be "nicer" to use a map for this, but that ends up being too slow:
-    VECT_INT_VECT atPaths(mol.getNumAtoms());
-    INT_VECT rpath(1,root);
-    atPaths[root] = rpath;
+    VECT_INT_VECT &atPaths=ws->atPaths;
+    atPaths[root].push_back(root);
+    touched.push_back(root);
 
     std::deque<int> bfsq;
     bfsq.push_back(root);
@@ -569,6 +597,12 @@ namespace FindRings {
       done[curr]=BLACK;
 
       INT_VECT &cpath = atPaths[curr];
+      // every ring closed from here on has at least 2*cpath.size()-1
+      // atoms, so if that's too big we're done. Without this the search
+      // covers the whole fragment (e.g. a protein chain) for each ring.
+      if (2*cpath.size()-1 > curSize) {
+        break;
+      }
 
       ROMol::OEDGE_ITER beg,end;
       boost::tie(beg,end) = mol.getAtomBonds(mol.getAtomWithIdx(curr));
@@ -590,6 +624,7 @@ namespace FindRings {
             atPaths[nbrIdx] = cpath;
             atPaths[nbrIdx].push_back(nbrIdx);
             done[nbrIdx]=GRAY;
+            touched.push_back(nbrIdx);
             bfsq.push_back(nbrIdx);
           } // end of found a untouched node
           else {
@@ -641,6 +676,27 @@ namespace FindRings {
     return rings.size(); // if we are here we should have found everything around the node
   }
 
+  // finds the SSSR of a fragment using the relevant cycles code. The
+  // prototypes of the relevant cycle families which are not in the SSSR
+  // are added to extras. (The families themselves can be huge for
+  // macrocycles.)
+  void findSSSRFromRelevantCycles(const ROMol &mol,const INT_VECT &frag,
+                                  VECT_INT_VECT &res,VECT_INT_VECT &extras){
+    VECT_INT_VECT relevant;
+    RelevantCycles::findCycles(mol,frag,res,&relevant,0,0,true);
+    std::set<INT_VECT> basis;
+    for(VECT_INT_VECT_CI ri=res.begin();ri!=res.end();++ri){
+      INT_VECT sorted=*ri;
+      std::sort(sorted.begin(),sorted.end());
+      basis.insert(sorted);
+    }
+    for(VECT_INT_VECT_CI ri=relevant.begin();ri!=relevant.end();++ri){
+      INT_VECT sorted=*ri;
+      std::sort(sorted.begin(),sorted.end());
+      if(basis.find(sorted)==basis.end()) extras.push_back(*ri);
+    }
+  }
+
   bool _atomSearchBFS(const ROMol &tMol,
                       unsigned int startAtomIdx,
                       unsigned int endAtomIdx,
@@ -769,10 +825,28 @@ namespace RDKit {
       // find the number of fragments in the molecule - we will loop over them
       VECT_INT_VECT frags;
       INT_VECT curFrag;
-      int nfrags = getMolFrags(mol, frags);
+      VECT_INT_VECT relevantExtras;
+      INT_VECT fragMapping;
+      int nfrags = getMolFrags(mol, fragMapping);
+      frags.resize(nfrags);
+      INT_VECT fragBondCounts(nfrags,0);
+      for(unsigned int i=0;i<nats;++i){
+        frags[fragMapping[i]].push_back(i);
+      }
+      for(ROMol::ConstBondIterator bndIt=mol.beginBonds();
+          bndIt!=mol.endBonds();++bndIt){
+        ++fragBondCounts[fragMapping[(*bndIt)->getBeginAtomIdx()]];
+      }
+      // atoms of each fragment are only touched while that fragment is
+      // processed, so this can be shared:
+      boost::dynamic_bitset<> doneAts(nats);
+      FindRings::BfsWorkspace bfsWorkspace(nats);
       for (unsigned int fi = 0; fi < nfrags; fi++) { // loop over the fragments in a molecule
         VECT_INT_VECT fragRes;
         curFrag = frags[fi];
+
+        // calculate the cyclomatic number for the fragment:
+        int nexpt = (fragBondCounts[fi] - curFrag.size()+1);
     
         // the following is the list of atoms that are useful in the next round of trimming
         // basically atoms that become degree 0 or 1 because of bond removals
@@ -785,7 +859,6 @@ namespace RDKit {
           }
         }
     
-        boost::dynamic_bitset<> doneAts(nats);
         unsigned int nAtomsDone=0;
         while (nAtomsDone < curFrag.size()) {
           //std::cerr<<" ndone: "<<nAtomsDone<<std::endl;
@@ -817,7 +890,7 @@ namespace RDKit {
           if (d2nodes.size() > 0) { // deal with the current degree two nodes
             // place to record any duplicate rings discovered from the current d2 nodes
             FindRings::findRingsD2nodes(mol, fragRes, invars, d2nodes, atomDegrees, activeBonds,
-                                        ringBonds,ringAtoms);
+                                        ringBonds,ringAtoms,&bfsWorkspace);
 #if 0
             std::cerr<<"  d2nodes post: ";
             std::copy(d2nodes.begin(),d2nodes.end(),std::ostream_iterator<int>(std::cerr," "));
@@ -848,22 +921,14 @@ namespace RDKit {
             if (cand == -1) {
               break;
             }
-            FindRings::findRingsD3Node(mol, fragRes, invars, cand, atomDegrees, activeBonds);
+            FindRings::findRingsD3Node(mol, fragRes, invars, cand, atomDegrees, activeBonds,
+                                     &bfsWorkspace);
             doneAts.set(cand);
             ++nAtomsDone;
             FindRings::trimBonds(cand, mol, changed, atomDegrees, activeBonds); 
           } // done with degree 3 node
         } // done finding rings in this fragement
 
-        // calculate the cyclomatic number for the fragment:
-        int nbnds=0;
-        for(ROMol::ConstBondIterator bndIt=mol.beginBonds();
-            bndIt!=mol.endBonds();++bndIt){
-          if(std::find(curFrag.begin(),curFrag.end(),(*bndIt)->getBeginAtomIdx())!=curFrag.end() &&
-             std::find(curFrag.begin(),curFrag.end(),(*bndIt)->getEndAtomIdx())!=curFrag.end()) {
-            ++nbnds;
-          }
-        }
 
 #if 0
         std::cerr<<"\n\nFOUND:\n";
@@ -873,7 +938,6 @@ namespace RDKit {
           std::cerr<<std::endl;          
         }
 #endif
-        int nexpt = (nbnds - curFrag.size()+1);
         int ssiz = fragRes.size();
 
         // first check that we got at least the number of expected rings
@@ -915,7 +979,10 @@ namespace RDKit {
           }
           ssiz = fragRes.size();
           if(ssiz<nexpt){
-            throw ValueErrorException("could not find number of expected rings.");
+            // still not enough, fall back to the relevant cycles code:
+            fragRes.clear();
+            FindRings::findSSSRFromRelevantCycles(mol,curFrag,fragRes,relevantExtras);
+            ssiz = fragRes.size();
           }
         }
         // if we have more than expected we need to do some cleanup
@@ -930,6 +997,14 @@ namespace RDKit {
           res.push_back(*iter);
         }
       } // done with all fragments
+
+      if(!relevantExtras.empty()){
+        if(mol.hasProp("extraRings")){
+          const VECT_INT_VECT &extras=mol.getProp<VECT_INT_VECT>("extraRings");
+          relevantExtras.insert(relevantExtras.end(),extras.begin(),extras.end());
+        }
+        mol.setProp("extraRings", relevantExtras, true);
+      }
   
       FindRings::storeRingsInfo(mol,res);
 
@@ -939,6 +1014,19 @@ namespace RDKit {
       return res.size();
     }
   
+    int findRelevantCycles(const ROMol &mol,VECT_INT_VECT &res,
+                           unsigned int maxCycles,PerceptionCost *cost){
+      res.clear();
+      VECT_INT_VECT frags;
+      getMolFrags(mol,frags);
+      for(VECT_INT_VECT_CI fragIt=frags.begin();fragIt!=frags.end();++fragIt){
+        VECT_INT_VECT basis,relevant;
+        RelevantCycles::findCycles(mol,*fragIt,basis,&relevant,maxCycles,cost);
+        res.insert(res.end(),relevant.begin(),relevant.end());
+      }
+      return res.size();
+    }
+
     int symmetrizeSSSR(ROMol &mol) {
       VECT_INT_VECT tmp;
       return symmetrizeSSSR(mol,tmp);
@@ -977,45 +1065,63 @@ namespace RDKit {
       VECT_INT_VECT bsrs, bextra;
       RingUtils::convertToBonds(sssrs, bsrs, mol);
       RingUtils::convertToBonds(extras, bextra, mol);
-      INT_VECT munion, nunion, symids;
-      Union(bsrs, munion);
-      INT_VECT sr, exr;
-      INT_VECT_CI eri;
+      INT_VECT symids;
       unsigned int eid, srid, ssiz;
       unsigned int next = bextra.size();
       // now the trick is the following
       // we will replace each ring of size ssiz from the SSSR with 
       // one of the same size rings in the extras. Compute the union of of the new set
       // if all the union elements of the new set if same as munion we found a  symmetric ring
+      //
+      // The unions are not constructed explicitly: we count the number of
+      // SSSR rings each bond is in. The union of the SSSR without ring srid
+      // is then missing exactly the bonds that are only in srid.
+      INT_VECT bondCounts(mol.getNumBonds(),0);
+      unsigned int munionSize=0;
+      for (srid = 0; srid < nsssr; srid++) {
+        for (INT_VECT_CI bi = bsrs[srid].begin(); bi != bsrs[srid].end(); ++bi) {
+          if (!bondCounts[*bi]++) ++munionSize;
+        }
+      }
+      boost::dynamic_bitset<> inSR(mol.getNumBonds());
+      boost::dynamic_bitset<> isSym(next);
       for (srid = 0; srid < nsssr; srid++) {
-        sr = bsrs[srid];
+        const INT_VECT &sr = bsrs[srid];
         ssiz = sr.size();
-        INT_VECT exrid;
-        exrid.push_back(srid);
-        Union(bsrs, nunion, &exrid);
+        unsigned int nunionSize=munionSize;
+        for (INT_VECT_CI bi = sr.begin(); bi != sr.end(); ++bi) {
+          inSR.set(*bi);
+          if (bondCounts[*bi]==1) --nunionSize;
+        }
         for (eid = 0; eid < next; eid++) {
           // if we already added this ring continue
           // FIX: if the ring has already been added,it probably shouldn't be
           // in the list at all?  Is this perhaps the most efficient way?
-          if (std::find(symids.begin(), symids.end(), static_cast<int>(eid)) != symids.end()){
+          if (isSym[eid]){
             continue;
           }
-          exr = bextra[eid];
+          const INT_VECT &exr = bextra[eid];
           if (ssiz == exr.size()) {
-            INT_VECT eunion;
-            Union(nunion, exr, eunion);
+            unsigned int eunionSize=nunionSize;
+            for (INT_VECT_CI bi = exr.begin(); bi != exr.end(); ++bi) {
+              if (!bondCounts[*bi] || (bondCounts[*bi]==1 && inSR[*bi])) ++eunionSize;
+            }
             // now check if the eunion is same as the original union from the SSSRs
-            if (eunion.size() == munion.size()) {
+            if (eunionSize == munionSize) {
               //we found a symmetric ring
               symids.push_back(eid);
+              isSym.set(eid);
             }
           }
         }
+        for (INT_VECT_CI bi = sr.begin(); bi != sr.end(); ++bi) {
+          inSR.reset(*bi);
+        }
       }
 
       // add the symmertic rings
-      for (eri = symids.begin(); eri != symids.end(); eri++) {
-        exr = extras[*eri];
+      for (INT_VECT_CI eri = symids.begin(); eri != symids.end(); eri++) {
+        const INT_VECT &exr = extras[*eri];
         res.push_back(exr);
         FindRings::storeRingInfo(mol, exr);
       }
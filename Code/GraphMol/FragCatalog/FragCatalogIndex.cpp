@@ -0,0 +1,69 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "FragCatalogIndex.h"
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/hash/hash.hpp>
+#include <algorithm>
+
+namespace RDKit {
+
+  FragCatalogIndex::FragCatalogIndex(const FragCatalog &fcat) : d_fcat(fcat) {
+    const FragCatParams *fparams = fcat.getCatalogParams();
+    PRECONDITION(fparams,"catalog has no parameters");
+    // the discriminators are integers, so for tolerances below 1
+    // match() requires them to be identical:
+    df_exactKeys = fparams->getTolerance() < 1.0;
+
+    d_index.reserve(fcat.getNumEntries());
+    for (unsigned int i = 0; i < fcat.getNumEntries(); ++i) {
+      const FragCatalogEntry *entry = fcat.getEntryWithIdx(i);
+      // getDiscrims() caches the discriminators on the entry; do it
+      // now, so that match() only reads the shared entries when the
+      // index is used from several threads:
+      entry->getDiscrims();
+      d_index.push_back(std::make_pair(hashFrag(*entry), static_cast<int>(i)));
+    }
+    std::sort(d_index.begin(), d_index.end());
+  }
+
+  boost::uint32_t FragCatalogIndex::hashFrag(const FragCatalogEntry &frag) const {
+    boost::uint32_t res = 0;
+    gboost::hash_combine(res, frag.getOrder());
+    if (df_exactKeys) {
+      Subgraphs::DiscrimTuple discrims = frag.getDiscrims();
+      gboost::hash_combine(res, boost::tuples::get<0>(discrims));
+      gboost::hash_combine(res, boost::tuples::get<1>(discrims));
+      gboost::hash_combine(res, boost::tuples::get<2>(discrims));
+    }
+    return res;
+  }
+
+  void FragCatalogIndex::getCandidates(const FragCatalogEntry &frag, INT_VECT &res) const {
+    res.clear();
+    boost::uint32_t hash = hashFrag(frag);
+    std::vector<HASH_ID_PAIR>::const_iterator it =
+      std::lower_bound(d_index.begin(), d_index.end(), HASH_ID_PAIR(hash, -1));
+    while (it != d_index.end() && it->first == hash) {
+      res.push_back(it->second);
+      ++it;
+    }
+  }
+
+  int FragCatalogIndex::findMatch(const FragCatalogEntry &frag,
+                                  const INT_VECT &candidates) const {
+    double tol = d_fcat.getCatalogParams()->getTolerance();
+    for (INT_VECT_CI ci = candidates.begin(); ci != candidates.end(); ++ci) {
+      if (frag.match(d_fcat.getEntryWithIdx(*ci), tol)) {
+        return *ci;
+      }
+    }
+    return -1;
+  }
+}
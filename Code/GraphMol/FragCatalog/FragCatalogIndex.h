@@ -0,0 +1,67 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_FRAG_CATALOG_INDEX_H_
+#define _RD_FRAG_CATALOG_INDEX_H_
+
+#include <vector>
+#include <utility>
+#include <boost/cstdint.hpp>
+#include <Catalogs/Catalog.h>
+#include "FragCatalogEntry.h"
+#include "FragCatParams.h"
+
+namespace RDKit {
+  typedef RDCatalog::HierarchCatalog<FragCatalogEntry, FragCatParams, int> FragCatalog;
+
+  //! a hashed index from fragment invariants to the entries of a FragCatalog
+  /*!
+    The index maps a hash of (order, path discriminators) to the ids
+    of the catalog entries with those invariants. It is built once for
+    a catalog and can then be used to quickly find the entries a
+    molecular fragment may match.
+
+    <b>Notes:</b>
+      - constructing the index computes (and caches) the discriminators of
+        every catalog entry. After that the catalog and the index are only
+        read, so a single index can be shared by multiple threads.
+      - the index is not updated when entries are added to the catalog; it
+        needs to be rebuilt in that case.
+      - if the catalog tolerance is >= 1 the discriminators cannot be used
+        as exact keys and the candidates are all entries of the
+        fragment's order.
+  */
+  class FragCatalogIndex {
+  public:
+    explicit FragCatalogIndex(const FragCatalog &fcat);
+
+    //! returns the catalog the index was built for
+    const FragCatalog &getCatalog() const { return d_fcat; }
+
+    //! fills \c res with the (sorted) ids of the entries that may match \c frag
+    /*!
+      Any catalog entry that FragCatalogEntry::match() considers equal to
+      \c frag is in the result. Candidates still need to be verified with
+      FragCatalogEntry::match().
+    */
+    void getCandidates(const FragCatalogEntry &frag, INT_VECT &res) const;
+
+    //! returns the id of the first entry in \c candidates matching \c frag, -1 if none match
+    int findMatch(const FragCatalogEntry &frag, const INT_VECT &candidates) const;
+
+  private:
+    typedef std::pair<boost::uint32_t, int> HASH_ID_PAIR;
+    const FragCatalog &d_fcat;
+    bool df_exactKeys;
+    std::vector<HASH_ID_PAIR> d_index; // sorted by hash, then entry id
+    boost::uint32_t hashFrag(const FragCatalogEntry &frag) const;
+  };
+}
+
+#endif
@@ -19,8 +19,143 @@
 #include <GraphMol/RDKitBase.h>
 #include <GraphMol/Subgraphs/SubgraphUtils.h>
 #include <GraphMol/Subgraphs/Subgraphs.h>
+#include <RDGeneral/RDThreads.h>
+#include <algorithm>
 
 namespace RDKit {
+  namespace {
+    void fpBlock(const FragFPGenerator *fpGen, const std::vector<const ROMol *> *mols,
+                 const FragCatalogIndex *index, std::vector<ExplicitBitVect *> *res,
+                 unsigned int count, unsigned int idx) {
+      for (unsigned int i = idx; i < mols->size(); i += count) {
+        (*res)[i] = fpGen->getFPForMol(*(*mols)[i], *index);
+      }
+    }
+  }
+
+  ExplicitBitVect *FragFPGenerator::getFPForMol(const ROMol &mol,
+						const FragCatalogIndex &index) const {
+    const FragCatalog &fcat = index.getCatalog();
+    ExplicitBitVect *fp = new ExplicitBitVect(fcat.getFPLength());
+    MatchVectType newAidToFid;
+    ROMol *coreMol = prepareMol(mol, fcat.getCatalogParams(), newAidToFid);
+    computeFP(*coreMol, index, newAidToFid, fp);
+    delete coreMol;
+    return fp;
+  }
+
+  std::vector<ExplicitBitVect *> FragFPGenerator::getFPsForMols(const std::vector<const ROMol *> &mols,
+                                                                const FragCatalogIndex &index,
+                                                                int numThreads) const {
+    std::vector<ExplicitBitVect *> res(mols.size(), static_cast<ExplicitBitVect *>(0));
+    unsigned int nThreads = getNumThreadsToUse(numThreads);
+    if (nThreads == 1) {
+      fpBlock(this, &mols, &index, &res, 1, 0);
+    }
+#ifdef RDK_THREADSAFE_SSS
+    else {
+      boost::thread_group tg;
+      for (unsigned int ti = 0; ti < nThreads; ++ti) {
+        tg.add_thread(new boost::thread(fpBlock, this, &mols, &index, &res, nThreads, ti));
+      }
+      tg.join_all();
+    }
+#endif
+    return res;
+  }
+
+  void FragFPGenerator::computeFP(const ROMol &mol, const FragCatalogIndex &index,
+				  const MatchVectType &aidToFid, ExplicitBitVect *fp) const {
+    PRECONDITION(fp, "Bad ExplicitBitVect - FingerPrint");
+
+    // This follows the same approach as the other computeFP() below, but
+    // the catalog is searched via the index: 
+    //  - order 1 paths are only compared to entries with the same invariants
+    //    instead of to all order 1 entries
+    //  - higher order paths are only built and compared when the catalog
+    //    contains entries for all of their subpaths, and then only to entries
+    //    that have the right invariants
+    const FragCatalog &fcat = index.getCatalog();
+    const FragCatParams *fparams = fcat.getCatalogParams();
+    double tol = fparams->getTolerance();
+
+    INT_PATH_LIST_MAP allPathsMap = findAllSubgraphsOfLengthsMtoN(mol, 1, 
+                                                                  fparams->getUpperFragLength());
+    DOUBLE_INT_MAP mapkm1, mapk;
+    INT_VECT candidates;
+    int entId;
+
+    for (PATH_LIST_CI pi = allPathsMap[1].begin(); pi != allPathsMap[1].end(); ++pi) {
+      FragCatalogEntry nent(&mol, (*pi), aidToFid);
+      index.getCandidates(nent, candidates);
+      entId = index.findMatch(nent, candidates);
+      mapkm1[computeIntVectPrimesProduct(*pi)] = entId;
+      if (entId >= 0) {
+        int bitId = fcat.getEntryWithIdx(entId)->getBitId();
+        if (bitId >= 0) {
+          fp->setBit(bitId);
+        }
+      }
+    }
+
+    INT_VECT intersect, tmpVect;
+    for (INT_PATH_LIST_MAP_CI ordi = allPathsMap.begin(); ordi != allPathsMap.end(); ++ordi) {
+      if (ordi->first < 2) {
+	continue;
+      }
+      mapk.clear();
+      for (PATH_LIST_CI pi = ordi->second.begin(); pi != ordi->second.end(); ++pi) {
+	double invar = computeIntVectPrimesProduct(*pi);
+	mapk[invar] = -1;
+
+        // intersect the down entries of the order k-1 subpaths:
+        intersect.clear();
+        bool first = true;
+	for (PATH_TYPE::const_iterator pii = pi->begin(); pii != pi->end(); ++pii) {
+          DOUBLE_INT_MAP::const_iterator sub = mapkm1.find(invar/firstThousandPrimes[*pii]);
+	  if (sub == mapkm1.end()) {
+	    continue;
+	  }
+	  if (sub->second == -1) {
+            // no match for the subpath, so none for this path either
+	    intersect.clear();
+	    break;
+	  }
+	  if (first) {
+	    intersect = fcat.getDownEntryList(sub->second);
+            first = false;
+	  } else {
+	    tmpVect = intersect;
+	    Intersect(fcat.getDownEntryList(sub->second), tmpVect, intersect);
+	  }
+          if (intersect.empty()) {
+            break;
+          }
+	}
+        if (intersect.empty()) {
+          continue;
+        }
+
+	FragCatalogEntry nent(&mol, (*pi), aidToFid);
+        index.getCandidates(nent, candidates);
+	for (INT_VECT_CI iti = intersect.begin(); iti != intersect.end(); ++iti) {
+          if (!std::binary_search(candidates.begin(), candidates.end(), *iti)) {
+            continue;
+          }
+	  const FragCatalogEntry *entry = fcat.getEntryWithIdx(*iti);
+	  if (nent.match(entry, tol)) {
+	    mapk[invar] = (*iti);
+	    int bitId = entry->getBitId();
+	    if (bitId >= 0) {
+	      fp->setBit(bitId);
+	    }
+	    break;
+	  }
+	}
+      }
+      mapkm1.swap(mapk);
+    }
+  }
   
   ExplicitBitVect *FragFPGenerator::getFPForMol(const ROMol &mol,
 						const FragCatalog &fcat) {
@@ -86,6 +221,9 @@ namespace RDKit {
 	  break;
 	}
       }
+      if (!found) {
+        delete nent;
+      }
     }
 
     // now deal with the higher order stuff. 
@@ -170,6 +308,9 @@ namespace RDKit {
 	    break;
 	  }
 	}
+        if (!found) {
+          delete nent;
+        }
       }
       
       // overwrite mapkm1 with mapk before we move on to order k+1
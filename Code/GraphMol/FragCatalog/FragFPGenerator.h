@@ -14,6 +14,7 @@
 #include <Catalogs/Catalog.h>
 #include "FragCatalogEntry.h"
 #include "FragCatParams.h"
+#include "FragCatalogIndex.h"
 
 class ExplicitBitVect;
 namespace RDKit {
@@ -28,9 +29,32 @@ namespace RDKit {
 
     ExplicitBitVect *getFPForMol(const ROMol &mol, const FragCatalog &fcat);
 
+    //! returns the fingerprint for a molecule, using an index of the catalog
+    /*!
+      This gives the same fingerprint as the getFPForMol() overload above
+      but is considerably faster for large catalogs. The index should be
+      built once and reused.
+    */
+    ExplicitBitVect *getFPForMol(const ROMol &mol, const FragCatalogIndex &index) const;
+
+    //! returns the fingerprints for a set of molecules
+    /*!
+      \param mols       the molecules to fingerprint
+      \param index      an index of the catalog to use
+      \param numThreads the number of threads to use (see getNumThreadsToUse())
+
+      \return a vector with one fingerprint per molecule, the caller is
+        responsible for deleting them
+    */
+    std::vector<ExplicitBitVect *> getFPsForMols(const std::vector<const ROMol *> &mols,
+                                                 const FragCatalogIndex &index,
+                                                 int numThreads=1) const;
+
   private:
     void computeFP(const ROMol &mol, const FragCatalog &fcat,
 		   const MatchVectType &aidToFid, ExplicitBitVect *fp);
+    void computeFP(const ROMol &mol, const FragCatalogIndex &index,
+		   const MatchVectType &aidToFid, ExplicitBitVect *fp) const;
   };
 }
 
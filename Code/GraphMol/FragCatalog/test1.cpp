@@ -20,6 +20,7 @@
 #include "FragCatParams.h"
 #include "FragCatalogUtils.h"
 #include "FragFPGenerator.h"
+#include "FragCatalogIndex.h"
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
@@ -122,6 +123,30 @@ void test1(){
   testMols(mols,fpGen,fcat);
   BOOST_LOG(rdInfoLog) << "---- Done" << std::endl;
 
+  BOOST_LOG(rdInfoLog) << "----- Test catalog index" << std::endl;
+  {
+    FragCatalogIndex fcatIndex(fcat);
+    // the entries are not modified once the index exists:
+    for(unsigned int i=0;i<fcat.getNumEntries();++i){
+      TEST_ASSERT(fcat.getEntryWithIdx(i)->hasProp("Discrims"));
+    }
+    std::vector<const ROMol *> cmols(mols.begin(),mols.end());
+    for(unsigned int nThreads=1;nThreads<4;++nThreads){
+      std::vector<ExplicitBitVect *> fps=fpGen.getFPsForMols(cmols,fcatIndex,nThreads);
+      TEST_ASSERT(fps.size()==mols.size());
+      for(unsigned int i=0;i<mols.size();++i){
+        ExplicitBitVect *ref=fpGen.getFPForMol(*mols[i],fcat);
+        ExplicitBitVect *fp=fpGen.getFPForMol(*mols[i],fcatIndex);
+        TEST_ASSERT(*fp==*ref);
+        TEST_ASSERT(*fps[i]==*ref);
+        delete ref;
+        delete fp;
+        delete fps[i];
+      }
+    }
+  }
+  BOOST_LOG(rdInfoLog) << "---- Done" << std::endl;
+
   //----------------------------------------------------------
   //  SERIALIZATION TESTS
   //----------------------------------------------------------
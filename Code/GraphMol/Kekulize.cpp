@@ -371,6 +371,194 @@ namespace RDKit {
       return true;
     }
 
+    // Edmonds' blossom algorithm, used to find a perfect (or maximum)
+    // matching on the graph formed by the atoms that can take a double bond
+    // and the bonds between them.
+    class KekuleMatcher {
+    public:
+      KekuleMatcher(const std::vector<INT_VECT> &nbrs) :
+        d_nbrs(nbrs), d_match(nbrs.size(),-1), d_parent(nbrs.size()),
+        d_base(nbrs.size()), d_used(nbrs.size()), d_blossom(nbrs.size()),
+        d_path(nbrs.size()) {};
+
+      //! the vertex matched to \c v (-1 if it's unmatched)
+      int getMatch(int v) const { return d_match[v]; };
+
+      //! matches \c v to a free neighbor, if there is one
+      bool matchGreedily(int v){
+        for(INT_VECT_CI ni=d_nbrs[v].begin();ni!=d_nbrs[v].end();++ni){
+          if(d_match[*ni]<0){
+            d_match[v]=*ni;
+            d_match[*ni]=v;
+            return true;
+          }
+        }
+        return false;
+      };
+
+      //! looks for an augmenting path starting at the unmatched vertex \c root
+      //! and flips it. Vertices that are already matched stay matched.
+      bool augment(int root){
+        int v=findPath(root);
+        if(v<0) return false;
+        while(v>=0){
+          int pv=d_parent[v];
+          int ppv=d_match[pv];
+          d_match[v]=pv;
+          d_match[pv]=v;
+          v=ppv;
+        }
+        return true;
+      };
+
+    private:
+      const std::vector<INT_VECT> &d_nbrs;
+      INT_VECT d_match,d_parent,d_base;
+      boost::dynamic_bitset<> d_used,d_blossom,d_path;
+
+      int lowestCommonAncestor(int a,int b){
+        d_path.reset();
+        while(true){
+          a=d_base[a];
+          d_path[a]=1;
+          if(d_match[a]<0) break;
+          a=d_parent[d_match[a]];
+        }
+        while(true){
+          b=d_base[b];
+          if(d_path[b]) return b;
+          b=d_parent[d_match[b]];
+        }
+      };
+
+      void markPath(int v,int b,int child){
+        while(d_base[v]!=b){
+          d_blossom[d_base[v]]=1;
+          d_blossom[d_base[d_match[v]]]=1;
+          d_parent[v]=child;
+          child=d_match[v];
+          v=d_parent[d_match[v]];
+        }
+      };
+
+      int findPath(int root){
+        unsigned int n=d_nbrs.size();
+        d_used.reset();
+        std::fill(d_parent.begin(),d_parent.end(),-1);
+        for(unsigned int i=0;i<n;++i) d_base[i]=i;
+        d_used[root]=1;
+        INT_DEQUE q;
+        q.push_back(root);
+        while(!q.empty()){
+          int v=q.front();
+          q.pop_front();
+          for(INT_VECT_CI ni=d_nbrs[v].begin();ni!=d_nbrs[v].end();++ni){
+            int to=*ni;
+            if(d_base[v]==d_base[to] || d_match[v]==to) continue;
+            if(to==root || (d_match[to]>=0 && d_parent[d_match[to]]>=0)){
+              // found an odd cycle, contract the blossom:
+              int curBase=lowestCommonAncestor(v,to);
+              d_blossom.reset();
+              markPath(v,curBase,to);
+              markPath(to,curBase,v);
+              for(unsigned int i=0;i<n;++i){
+                if(d_blossom[d_base[i]]){
+                  d_base[i]=curBase;
+                  if(!d_used[i]){
+                    d_used[i]=1;
+                    q.push_back(i);
+                  }
+                }
+              }
+            } else if(d_parent[to]<0){
+              d_parent[to]=v;
+              if(d_match[to]<0) return to;
+              d_used[d_match[to]]=1;
+              q.push_back(d_match[to]);
+            }
+          }
+        }
+        return -1;
+      };
+    };
+
+    // kekulizes a fused system by finding a matching on the candidate atoms
+    // that covers all of them except (possibly) the dummies.
+    // This is the same problem that kekulizeWorker() solves by
+    // backtracking, but the time needed is polynomial in the size of
+    // the system.
+    bool kekulizeMatching(RWMol &mol,const INT_VECT &allAtms,
+                          const boost::dynamic_bitset<> &dBndCands){
+      // the candidates get consecutive indices:
+      INT_VECT atomIdx(mol.getNumAtoms(),-1);
+      INT_VECT cands;
+      for(INT_VECT_CI ai=allAtms.begin();ai!=allAtms.end();++ai){
+        if(dBndCands[*ai] && atomIdx[*ai]<0){
+          atomIdx[*ai]=cands.size();
+          cands.push_back(*ai);
+        }
+      }
+      if(cands.empty()) return true;
+
+      // the bonds that can be made double, these are the same ones
+      // kekulizeWorker() considers:
+      std::vector<INT_VECT> nbrs(cands.size());
+      for(unsigned int i=0;i<cands.size();++i){
+        const Atom *atom=mol.getAtomWithIdx(cands[i]);
+        RWMol::OEDGE_ITER beg,end;
+        boost::tie(beg,end) = mol.getAtomBonds(atom);
+        while(beg!=end){
+          const Bond *bond=mol[*beg].get();
+          ++beg;
+          int other=atomIdx[bond->getOtherAtomIdx(cands[i])];
+          if(other<0) continue;
+          if(bond->getIsAromatic() || !atom->getAtomicNum() ||
+             !mol.getAtomWithIdx(cands[other])->getAtomicNum()){
+            nbrs[i].push_back(other);
+          }
+        }
+      }
+
+      // every candidate other than the dummies needs a double bond. Since
+      // augmenting a matching never unmatches a vertex, it's enough to
+      // look for an augmenting path once from each of them.
+      KekuleMatcher matcher(nbrs);
+      for(unsigned int i=0;i<cands.size();++i){
+        if(mol.getAtomWithIdx(cands[i])->getAtomicNum() && matcher.getMatch(i)<0){
+          matcher.matchGreedily(i);
+        }
+      }
+      for(unsigned int i=0;i<cands.size();++i){
+        if(mol.getAtomWithIdx(cands[i])->getAtomicNum() && matcher.getMatch(i)<0){
+          if(!matcher.augment(i)) return false;
+        }
+      }
+
+      for(unsigned int i=0;i<cands.size();++i){
+        int j=matcher.getMatch(i);
+        if(j>static_cast<int>(i)){
+          mol.getBondBetweenAtoms(cands[i],cands[j])->setBondType(Bond::DOUBLE);
+        }
+      }
+      return true;
+    }
+
+    // sets the aromatic bonds in a fused system back to single, this is
+    // the state markDbondCands() leaves them in:
+    void resetFusedSystem(RWMol &mol,const INT_VECT &allAtms){
+      boost::dynamic_bitset<> atomsInPlay(mol.getNumAtoms());
+      for(INT_VECT_CI ai=allAtms.begin();ai!=allAtms.end();++ai){
+        atomsInPlay[*ai]=1;
+      }
+      for(RWMol::BondIterator bi=mol.beginBonds();bi!=mol.endBonds();++bi){
+        if((*bi)->getIsAromatic() && (*bi)->getBondType()!=Bond::SINGLE &&
+           atomsInPlay[(*bi)->getBeginAtomIdx()] &&
+           atomsInPlay[(*bi)->getEndAtomIdx()] ){
+          (*bi)->setBondType(Bond::SINGLE);
+        }
+      }
+    }
+
     class QuestionEnumerator{
     public:
       QuestionEnumerator(const INT_VECT &questions) : d_questions(questions) , d_pos(1) {};
@@ -396,25 +584,13 @@ namespace RDKit {
                                    boost::dynamic_bitset<> dBndCands,
                                    INT_VECT &questions,
                                    unsigned int maxBackTracks){
-      boost::dynamic_bitset<> atomsInPlay(mol.getNumAtoms());
-      for(INT_VECT_CI ai=allAtms.begin();ai!=allAtms.end();++ai){
-        atomsInPlay[*ai]=1;
-      }
       bool kekulized=false;
       QuestionEnumerator qEnum(questions);
       while(!kekulized && questions.size()){
         boost::dynamic_bitset<> dBndAdds(mol.getNumBonds());
         INT_VECT done;
-#if 1
         // reset the state: all aromatic bonds are remarked to single:
-        for(RWMol::BondIterator bi=mol.beginBonds();bi!=mol.endBonds();++bi){
-          if((*bi)->getIsAromatic() && (*bi)->getBondType()!=Bond::SINGLE &&
-             atomsInPlay[(*bi)->getBeginAtomIdx()] &&
-             atomsInPlay[(*bi)->getEndAtomIdx()] ){
-            (*bi)->setBondType(Bond::SINGLE);
-          }
-        }
-#endif
+        resetFusedSystem(mol,allAtms);
         // pick a new permutation of the questionable atoms:
         const INT_VECT &switchOff=qEnum.next();
         if(!switchOff.size()) break;
@@ -437,7 +613,8 @@ namespace RDKit {
 
     void kekulizeFused(RWMol &mol,
                        const VECT_INT_VECT &arings,
-                       unsigned int maxBackTracks) { 
+                       unsigned int maxBackTracks,
+                       bool useMatching) { 
       // get all the atoms in the ring system
       INT_VECT allAtms;
       Union(arings, allAtms);
@@ -461,10 +638,21 @@ namespace RDKit {
 #endif
 
       bool kekulized;
-      kekulized=kekulizeWorker(mol,allAtms,dBndCands,dBndAdds,done,maxBackTracks);
-      if(!kekulized && questions.size()){
-        // we failed, but there are some dummy atoms we can try permuting.
-        kekulized=permuteDummiesAndKekulize(mol,allAtms,dBndCands,questions,maxBackTracks);
+      if(useMatching){
+        kekulized=kekulizeMatching(mol,allAtms,dBndCands);
+      } else {
+        kekulized=kekulizeWorker(mol,allAtms,dBndCands,dBndAdds,done,maxBackTracks);
+        if(!kekulized && questions.size()){
+          // we failed, but there are some dummy atoms we can try permuting.
+          kekulized=permuteDummiesAndKekulize(mol,allAtms,dBndCands,questions,maxBackTracks);
+        }
+        if(!kekulized){
+          // the backtracking may just have given up too early (this
+          // happens with large fused systems), the matching will find
+          // a solution if there is one:
+          resetFusedSystem(mol,allAtms);
+          kekulized=kekulizeMatching(mol,allAtms,dBndCands);
+        }
       }
       if(!kekulized){
         // we exhausted all option (or crossed the allowed
@@ -481,7 +669,7 @@ namespace RDKit {
 
   namespace MolOps {
     void Kekulize(RWMol &mol, bool markAtomsBonds,
-                  unsigned int maxBackTracks) {
+                  unsigned int maxBackTracks, bool useMatching) {
 
       // before everything do implicit valence calculation and store them
       // we will repeat after kekulization and compare for the sake of error
@@ -535,7 +723,7 @@ namespace RDKit {
              ci != fused.end();++ci) {
           frings.push_back(arings[*ci]);
         }
-        kekulizeFused(mol, frings, maxBackTracks);
+        kekulizeFused(mol, frings, maxBackTracks, useMatching);
         int rix;
         for (rix = 0; rix < cnrs; rix++) {
           if (!fusDone[rix]) {
@@ -14,8 +14,14 @@
 #include <GraphMol/Substruct/SubstructMatch.h>
 #include <GraphMol/Conformer.h>
 #include <GraphMol/ROMol.h>
+#include <GraphMol/RWMol.h>
+#include <GraphMol/BondIterators.h>
 #include <Numerics/Alignment/AlignPoints.h>
 #include <GraphMol/MolTransforms/MolTransforms.h>
+#include <GraphMol/ConformerEnsemble.h>
+#include <RDGeneral/RDThreads.h>
+#include <cmath>
+#include <algorithm>
 
 namespace RDKit {
   namespace MolAlign {
@@ -136,5 +142,188 @@ namespace RDKit {
         }
       }
     }   
+
+    namespace {
+      // finds the atom orders that map the atoms onto themselves. Only
+      // the subgraph of the atoms is matched, so that permutations of the
+      // other atoms (usually the Hs) don't use up maxMatches. Two atoms
+      // are only swapped if their neighbours outside the subgraph are the
+      // same elements.
+      void _getSymmetryPerms(const ROMol &mol, const std::vector<unsigned int> &atoms,
+                             unsigned int maxMatches,
+                             std::vector< std::vector<unsigned int> > &perms) {
+        unsigned int nPts = atoms.size();
+        std::vector<unsigned int> identity(nPts);
+        for (unsigned int i = 0; i < nPts; ++i) {
+          identity[i] = i;
+        }
+        perms.push_back(identity);
+        if (!nPts) return;
+
+        // atom index -> position in atoms:
+        std::vector<int> atomPos(mol.getNumAtoms(), -1);
+        for (unsigned int i = 0; i < nPts; ++i) {
+          atomPos[atoms[i]] = i;
+        }
+        RWMol sub;
+        std::vector< std::vector<int> > outside(nPts);
+        for (unsigned int i = 0; i < nPts; ++i) {
+          const Atom *atom = mol.getAtomWithIdx(atoms[i]);
+          sub.addAtom(atom->copy(), true, true);
+          ROMol::ADJ_ITER nbrIdx, endNbrs;
+          boost::tie(nbrIdx, endNbrs) = mol.getAtomNeighbors(atom);
+          while (nbrIdx != endNbrs) {
+            if (atomPos[*nbrIdx] < 0) {
+              outside[i].push_back(mol.getAtomWithIdx(*nbrIdx)->getAtomicNum());
+            }
+            ++nbrIdx;
+          }
+          std::sort(outside[i].begin(), outside[i].end());
+        }
+        for (ROMol::ConstBondIterator bondIt = mol.beginBonds();
+             bondIt != mol.endBonds(); ++bondIt) {
+          int begPos = atomPos[(*bondIt)->getBeginAtomIdx()];
+          int endPos = atomPos[(*bondIt)->getEndAtomIdx()];
+          if (begPos >= 0 && endPos >= 0) {
+            sub.addBond(begPos, endPos, (*bondIt)->getBondType());
+          }
+        }
+
+        std::vector<MatchVectType> matches;
+        SubstructMatch(sub, sub, matches, false, true, false, false, maxMatches);
+        for (unsigned int mi = 0; mi < matches.size(); ++mi) {
+          std::vector<unsigned int> perm(nPts);
+          bool keep = true;
+          for (unsigned int i = 0; i < matches[mi].size() && keep; ++i) {
+            perm[matches[mi][i].first] = matches[mi][i].second;
+            keep = outside[matches[mi][i].first] == outside[matches[mi][i].second];
+          }
+          // the identity was added above, whether or not maxMatches
+          // cut it out of the matches:
+          if (keep && perm != identity) {
+            perms.push_back(perm);
+          }
+        }
+      }
+
+      // computes rows ti, ti+nThreads, ... of the RMSD matrix.
+      // perms holds the symmetry-equivalent atom orders (an empty
+      // vector means only the identity is used)
+      void _calcRMSRows(const ConformerEnsemble<double> *ens,
+                        const std::vector<double> *sumSqs,
+                        const std::vector< std::vector<unsigned int> > *perms,
+                        std::vector<double> *rmsMat,
+                        unsigned int ti, unsigned int nThreads) {
+        unsigned int nPts = ens->getNumAtoms();
+        unsigned int nConfs = ens->getNumConformers();
+        for (unsigned int i = 1+ti; i < nConfs; i += nThreads) {
+          const double *ref = ens->getCoords(i);
+          unsigned int offset = i*(i-1)/2;
+          for (unsigned int j = 0; j < i; ++j) {
+            const double *prb = ens->getCoords(j);
+            double ssr;
+            if (perms->empty()) {
+              ssr = RDNumeric::Alignments::AlignedSSR(ref, (*sumSqs)[i], prb, (*sumSqs)[j], nPts);
+            } else {
+              ssr = -1.0;
+              for (unsigned int pi = 0; pi < perms->size(); ++pi) {
+                const std::vector<unsigned int> &perm = (*perms)[pi];
+                double innerProd[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+                for (unsigned int k = 0; k < nPts; ++k) {
+                  const double *r = ref+3*k;
+                  const double *p = prb+3*perm[k];
+                  for (unsigned int m = 0; m < 3; ++m) {
+                    innerProd[3*m] += r[m]*p[0];
+                    innerProd[3*m+1] += r[m]*p[1];
+                    innerProd[3*m+2] += r[m]*p[2];
+                  }
+                }
+                double tssr = RDNumeric::Alignments::SSRFromInnerProducts(innerProd, (*sumSqs)[i],
+                                                                          (*sumSqs)[j]);
+                if (ssr < 0.0 || tssr < ssr) {
+                  ssr = tssr;
+                }
+              }
+            }
+            (*rmsMat)[offset+j] = nPts ? sqrt(ssr/nPts) : 0.0;
+          }
+        }
+      }
+    }
+
+    void getConformerRMSMatrix(const ROMol &mol, std::vector<double> &rmsMat,
+                               const std::vector<unsigned int> *atomIds,
+                               const std::vector<unsigned int> *confIds,
+                               bool useSymmetry, int numThreads,
+                               unsigned int maxMatches) {
+      std::vector<unsigned int> atoms;
+      if (atomIds) {
+        atoms = *atomIds;
+        for (unsigned int i = 0; i < atoms.size(); ++i) {
+          if (atoms[i] >= mol.getNumAtoms()) {
+            throw MolAlignException("atom index out of range");
+          }
+        }
+      } else {
+        for (unsigned int i = 0; i < mol.getNumAtoms(); ++i) {
+          atoms.push_back(i);
+        }
+      }
+      unsigned int nPts = atoms.size();
+
+      // copy the coordinates to a contiguous buffer (the slots are used as ids
+      // there, so that repeated conformation ids are not a problem):
+      std::vector<const Conformer *> confs;
+      if (confIds) {
+        for (unsigned int i = 0; i < confIds->size(); ++i) {
+          confs.push_back(&mol.getConformer((*confIds)[i]));
+        }
+      } else {
+        for (ROMol::ConstConformerIterator ci = mol.beginConformers();
+             ci != mol.endConformers(); ++ci) {
+          confs.push_back(ci->get());
+        }
+      }
+      ConformerEnsemble<double> ens(nPts);
+      std::vector<double> coords(3*nPts);
+      std::vector<double> sumSqs(confs.size());
+      for (unsigned int ci = 0; ci < confs.size(); ++ci) {
+        const RDGeom::POINT3D_VECT &pos = confs[ci]->getPositions();
+        for (unsigned int i = 0; i < nPts; ++i) {
+          const RDGeom::Point3D &pt = pos[atoms[i]];
+          coords[3*i] = pt.x;
+          coords[3*i+1] = pt.y;
+          coords[3*i+2] = pt.z;
+        }
+        unsigned int slot = ens.addConformer(nPts ? &coords[0] : 0, ci);
+        sumSqs[ci] = RDNumeric::Alignments::CenterPoints(ens.getCoords(slot), nPts);
+      }
+
+      std::vector< std::vector<unsigned int> > perms;
+      if (useSymmetry) {
+        _getSymmetryPerms(mol, atoms, maxMatches, perms);
+      }
+
+      unsigned int nConfs = confs.size();
+      if (nConfs < 2) {
+        rmsMat.clear();
+        return;
+      }
+      rmsMat.resize(nConfs*(nConfs-1)/2);
+      unsigned int nThreads = std::min(getNumThreadsToUse(numThreads), nConfs-1);
+      if (nThreads == 1) {
+        _calcRMSRows(&ens, &sumSqs, &perms, &rmsMat, 0, 1);
+      }
+#ifdef RDK_THREADSAFE_SSS
+      else {
+        boost::thread_group tg;
+        for (unsigned int ti = 0; ti < nThreads; ++ti) {
+          tg.add_thread(new boost::thread(_calcRMSRows, &ens, &sumSqs, &perms, &rmsMat,
+                                          ti, nThreads));
+        }
+        tg.join_all();
+      }
+#endif
+    }
   }
 }
@@ -113,6 +113,46 @@ namespace RDKit {
                             const std::vector<unsigned int> *confIds=0,
                             const RDNumeric::DoubleVector *weights=0, 
                             bool reflect=false, unsigned int maxIters=50);
+
+    //! Compute the RMSD between all pairs of conformations of a molecule
+    /*! 
+      The conformations are not modified: the RMSD of each pair is the
+      one after optimal superposition. The coordinates of all the
+      conformations are copied to a single (centered) buffer first, and
+      the RMSDs are computed with the QCP method (see
+      RDNumeric::Alignments::AlignedSSR()).
+
+      \param mol         The molecule of interest
+      \param rmsMat      used to return the lower triangle of the RMSD matrix:
+                         the value for conformations i and j (i>j) is at
+                         position i*(i-1)/2+j. The conformations are numbered
+                         in the order of \c confIds (or of the molecule's
+                         conformations)
+      \param atomIds     vector of atoms to be used, all atoms will be used
+                         if not specified
+      \param confIds     vector of conformations to use - defaults to all
+      \param useSymmetry if true, the atoms in \c atomIds are matched against
+                         themselves and the RMSD of each pair is the smallest
+                         one over all the symmetry-equivalent atom mappings.
+                         Atoms are only swapped if their neighbours outside
+                         \c atomIds are the same elements. The cost is
+                         proportional to the number of mappings, so it is
+                         usually a good idea to leave the Hs out of \c atomIds
+      \param numThreads  the number of threads to use (see getNumThreadsToUse())
+      \param maxMatches  (with \c useSymmetry) the largest number of atom
+                         mappings to consider; very symmetric molecules can
+                         have a huge number of them. 0 means no limit. The
+                         identity mapping is always considered, so the
+                         result is never larger than without \c useSymmetry.
+
+      A MolAlignException is thrown if \c atomIds contains an index that
+      is not in the molecule.
+    */
+    void getConformerRMSMatrix(const ROMol &mol, std::vector<double> &rmsMat,
+                               const std::vector<unsigned int> *atomIds=0,
+                               const std::vector<unsigned int> *confIds=0,
+                               bool useSymmetry=false, int numThreads=1,
+                               unsigned int maxMatches=1000);
   }
 }
 #endif
@@ -94,6 +94,28 @@ namespace RDKit {
     }
   }
     
+  python::list getConfRMSMatrix(const ROMol &mol, python::object atomIds=python::list(),
+                                python::object confIds=python::list(),
+                                bool useSymmetry=false, int numThreads=1,
+                                unsigned int maxMatches=1000) {
+    std::vector<unsigned int> *aIds = _translateIds(atomIds);
+    std::vector<unsigned int> *cIds = _translateIds(confIds);
+    std::vector<double> rmsMat;
+    MolAlign::getConformerRMSMatrix(mol, rmsMat, aIds, cIds, useSymmetry, numThreads,
+                                    maxMatches);
+    if (aIds) {
+      delete aIds;
+    }
+    if (cIds) {
+      delete cIds;
+    }
+    python::list res;
+    for (unsigned int i = 0; i < rmsMat.size(); ++i) {
+      res.append(rmsMat[i]);
+    }
+    return res;
+  }
+
   PyObject *generateRmsdTransPyTuple(double rmsd, RDGeom::Transform3D &trans) {
     npy_intp dims[2];
     dims[0] = 4;
@@ -405,6 +427,34 @@ BOOST_PYTHON_MODULE(rdMolAlign) {
                python::arg("reflect")=false, python::arg("maxIters")=50),
               docString.c_str());
 
+  docString = "Compute the RMSD between all pairs of conformations of a molecule\n\
+     \n\
+      The conformations are not modified, the RMSD of each pair is the one\n\
+      after optimal superposition.\n\
+     \n\
+     ARGUMENTS\n\
+      - mol          molecule of interest\n\
+      - atomIds      List of atom ids to use - defaults to all atoms\n\
+      - confIds      Ids of conformations to use - defaults to all conformers \n\
+      - useSymmetry  if true the smallest RMSD over all symmetry-equivalent\n\
+                     atom mappings is used\n\
+      - numThreads   number of threads to use, values <= 0 are relative to\n\
+                     the number of hardware threads\n\
+      - maxMatches   (with useSymmetry) the largest number of symmetry-equivalent\n\
+                     atom mappings to consider, 0 means no limit\n\
+       \n\
+      RETURNS\n\
+      the lower triangle of the RMSD matrix as a list, the value for\n\
+      conformations i and j (i>j) is at position i*(i-1)/2+j. This can be\n\
+      passed to the clustering code.\n\
+    \n";
+  python::def("GetConformerRMSMatrix", RDKit::getConfRMSMatrix,
+              (python::arg("mol"), python::arg("atomIds")=python::list(), 
+               python::arg("confIds")=python::list(),
+               python::arg("useSymmetry")=false, python::arg("numThreads")=1,
+               python::arg("maxMatches")=1000),
+              docString.c_str());
+
   docString = "Perform a random transformation on a molecule\n\
      \n\
      ARGUMENTS\n\
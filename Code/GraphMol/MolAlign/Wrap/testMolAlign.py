@@ -183,6 +183,24 @@ class TestCase(unittest.TestCase):
       self.failUnlessAlmostEqual(cumScore,4918,0)
       self.failUnlessAlmostEqual(math.sqrt(cumMsd),.304,3)
 
+    def test10ConformerRMSMatrix(self):
+      mol = Chem.AddHs(Chem.MolFromSmiles('OCCc1ccc(F)cc1'))
+      cids = rdDistGeom.EmbedMultipleConfs(mol,5,randomSeed=42)
+      self.failUnlessEqual(len(cids),5)
+      rmsMat = rdMolAlign.GetConformerRMSMatrix(mol)
+      self.failUnlessEqual(len(rmsMat),10)
+      atomMap = [(i,i) for i in range(mol.GetNumAtoms())]
+      for i in range(1,5):
+        for j in range(i):
+          rms = rdMolAlign.AlignMol(Chem.Mol(mol),mol,prbCid=cids[j],refCid=cids[i],
+                                    atomMap=atomMap)
+          self.failUnless(feq(rms,rmsMat[i*(i-1)//2+j]))
+      rmsMat2 = rdMolAlign.GetConformerRMSMatrix(mol,numThreads=2)
+      self.failUnless(lstFeq(rmsMat,rmsMat2))
+      rmsMat2 = rdMolAlign.GetConformerRMSMatrix(mol,useSymmetry=True)
+      for i in range(10):
+        self.failUnless(rmsMat2[i]<=rmsMat[i]+1e-4)
+
     def test9CrippenO3A(self):
       " now test where the Crippen parameters are generated on call "
       sdf = os.path.join(RDConfig.RDBaseDir,'Code','GraphMol',
@@ -201,6 +219,24 @@ class TestCase(unittest.TestCase):
       self.failUnlessAlmostEqual(cumScore,4918,0)
       self.failUnlessAlmostEqual(math.sqrt(cumMsd),.304,3)
 
+    def test10ConformerRMSMatrix(self):
+      mol = Chem.AddHs(Chem.MolFromSmiles('OCCc1ccc(F)cc1'))
+      cids = rdDistGeom.EmbedMultipleConfs(mol,5,randomSeed=42)
+      self.failUnlessEqual(len(cids),5)
+      rmsMat = rdMolAlign.GetConformerRMSMatrix(mol)
+      self.failUnlessEqual(len(rmsMat),10)
+      atomMap = [(i,i) for i in range(mol.GetNumAtoms())]
+      for i in range(1,5):
+        for j in range(i):
+          rms = rdMolAlign.AlignMol(Chem.Mol(mol),mol,prbCid=cids[j],refCid=cids[i],
+                                    atomMap=atomMap)
+          self.failUnless(feq(rms,rmsMat[i*(i-1)//2+j]))
+      rmsMat2 = rdMolAlign.GetConformerRMSMatrix(mol,numThreads=2)
+      self.failUnless(lstFeq(rmsMat,rmsMat2))
+      rmsMat2 = rdMolAlign.GetConformerRMSMatrix(mol,useSymmetry=True)
+      for i in range(10):
+        self.failUnless(rmsMat2[i]<=rmsMat[i]+1e-4)
+
 
 
       
@@ -22,6 +22,8 @@
 #include <GraphMol/ForceFieldHelpers/UFF/Builder.h>
 #include <GraphMol/MolPickler.h>
 #include <GraphMol/DistGeomHelpers/Embedder.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/MolOps.h>
 
 using namespace RDKit;
 
@@ -520,6 +522,129 @@ void testCrippenO3AMultiThread() {
 #endif
 
 
+void testConformerRMSMatrix() {
+  ROMol *m = SmilesToMol("OCCc1ccc(F)cc1CN");
+  TEST_ASSERT(m);
+  ROMol *mh = MolOps::addHs(*m);
+  delete m;
+  INT_VECT cids = DGeomHelpers::EmbedMultipleConfs(*mh, 10, 30, 42);
+  TEST_ASSERT(cids.size() == 10);
+
+  std::vector<double> rmsMat;
+  MolAlign::getConformerRMSMatrix(*mh, rmsMat);
+  TEST_ASSERT(rmsMat.size() == 45);
+  RDGeom::Transform3D trans;
+  MatchVectType identity;
+  for (unsigned int i = 0; i < mh->getNumAtoms(); ++i) {
+    identity.push_back(std::make_pair(i, i));
+  }
+  for (unsigned int i = 1; i < cids.size(); ++i) {
+    for (unsigned int j = 0; j < i; ++j) {
+      double rms = MolAlign::getAlignmentTransform(*mh, *mh, trans, cids[j], cids[i],
+                                                   &identity);
+      TEST_ASSERT(feq(rms, rmsMat[i*(i-1)/2+j], 1e-4));
+    }
+  }
+
+#ifdef RDK_THREADSAFE_SSS
+  std::vector<double> rmsMat2;
+  MolAlign::getConformerRMSMatrix(*mh, rmsMat2, 0, 0, false, 3);
+  TEST_ASSERT(rmsMat2 == rmsMat);
+#endif
+
+  // subsets of atoms and conformations:
+  std::vector<unsigned int> atomIds, confIds;
+  for (unsigned int i = 0; i < 8; ++i) {
+    atomIds.push_back(i);
+  }
+  confIds.push_back(cids[5]);
+  confIds.push_back(cids[2]);
+  confIds.push_back(cids[7]);
+  MolAlign::getConformerRMSMatrix(*mh, rmsMat, &atomIds, &confIds);
+  TEST_ASSERT(rmsMat.size() == 3);
+  MatchVectType atomMap;
+  for (unsigned int i = 0; i < atomIds.size(); ++i) {
+    atomMap.push_back(std::make_pair(atomIds[i], atomIds[i]));
+  }
+  double rms = MolAlign::getAlignmentTransform(*mh, *mh, trans, cids[7], cids[2], &atomMap);
+  TEST_ASSERT(feq(rms, rmsMat[2], 1e-4));
+  delete mh;
+
+  // symmetry: swap the coordinates of two of the equivalent methyls
+  m = SmilesToMol("CC(C)(C)O");
+  TEST_ASSERT(m);
+  cids = DGeomHelpers::EmbedMultipleConfs(*m, 1, 30, 42);
+  TEST_ASSERT(cids.size() == 1);
+  Conformer *conf = new Conformer(m->getConformer(cids[0]));
+  RDGeom::Point3D tmp = conf->getAtomPos(0);
+  conf->setAtomPos(0, conf->getAtomPos(2));
+  conf->setAtomPos(2, tmp);
+  m->addConformer(conf, true);
+  MolAlign::getConformerRMSMatrix(*m, rmsMat);
+  TEST_ASSERT(rmsMat.size() == 1);
+  TEST_ASSERT(rmsMat[0] > 0.1);
+  MolAlign::getConformerRMSMatrix(*m, rmsMat, 0, 0, true);
+  TEST_ASSERT(rmsMat.size() == 1);
+  TEST_ASSERT(feq(rmsMat[0], 0.0, 1e-4));
+  // only the identity mapping is used:
+  MolAlign::getConformerRMSMatrix(*m, rmsMat, 0, 0, true, 1, 1);
+  TEST_ASSERT(rmsMat.size() == 1);
+  TEST_ASSERT(rmsMat[0] > 0.1);
+  delete m;
+
+  // the symmetric RMSD is never larger than the plain one, even if the
+  // identity isn't among the first matches:
+  m = SmilesToMol("OC1CCCCC1");
+  TEST_ASSERT(m);
+  cids = DGeomHelpers::EmbedMultipleConfs(*m, 5, 30, 42);
+  TEST_ASSERT(cids.size() == 5);
+  MolAlign::getConformerRMSMatrix(*m, rmsMat);
+  for (unsigned int maxMatches = 1; maxMatches < 4; ++maxMatches) {
+    MolAlign::getConformerRMSMatrix(*m, rmsMat2, 0, 0, true, 1, maxMatches);
+    TEST_ASSERT(rmsMat2.size() == rmsMat.size());
+    for (unsigned int i = 0; i < rmsMat.size(); ++i) {
+      TEST_ASSERT(rmsMat2[i] <= rmsMat[i] + 1e-6);
+    }
+  }
+
+  // atom indices are checked:
+  atomIds.clear();
+  atomIds.push_back(0);
+  atomIds.push_back(m->getNumAtoms());
+  bool ok = false;
+  try {
+    MolAlign::getConformerRMSMatrix(*m, rmsMat, &atomIds);
+  } catch (MolAlign::MolAlignException &) {
+    ok = true;
+  }
+  TEST_ASSERT(ok);
+  delete m;
+
+  // permutations of the Hs don't use up maxMatches when they aren't in
+  // atomIds (neopentane has 24 heavy atom mappings, but 31104 with the Hs):
+  m = SmilesToMol("CC(C)(C)C");
+  TEST_ASSERT(m);
+  ROMol *m2 = MolOps::addHs(*m);
+  delete m;
+  m = m2;
+  cids = DGeomHelpers::EmbedMultipleConfs(*m, 1, 30, 42);
+  TEST_ASSERT(cids.size() == 1);
+  conf = new Conformer(m->getConformer());
+  tmp = conf->getAtomPos(0);
+  conf->setAtomPos(0, conf->getAtomPos(2));
+  conf->setAtomPos(2, tmp);
+  m->addConformer(conf, true);
+  atomIds.clear();
+  for (unsigned int i = 0; i < 5; ++i) {
+    atomIds.push_back(i);
+  }
+  MolAlign::getConformerRMSMatrix(*m, rmsMat, &atomIds);
+  TEST_ASSERT(rmsMat[0] > 0.1);
+  MolAlign::getConformerRMSMatrix(*m, rmsMat, &atomIds, 0, true, 1, 24);
+  TEST_ASSERT(feq(rmsMat[0], 0.0, 1e-4));
+  delete m;
+}
+
 int main() {
   std::cout << "***********************************************************\n";
   std::cout << "Testing MolAlign\n";
@@ -556,6 +681,10 @@ int main() {
   std::cout << "\t testCrippenO3A with pre-computed dmat and MolHistogram\n\n";
   testCrippenO3AMolHist();
 
+  std::cout << "\t---------------------------------\n";
+  std::cout << "\t testConformerRMSMatrix \n\n";
+  testConformerRMSMatrix();
+
 #ifdef RDK_TEST_MULTITHREADED
   std::cout << "\t---------------------------------\n";
   std::cout << "\t testMMFFO3A multithreading\n\n";
@@ -17,6 +17,7 @@
 
 #include <vector>
 #include <algorithm> 
+#include <ctime>
 
 #include <boost/graph/connected_components.hpp>
 #include <boost/graph/kruskal_min_spanning_tree.hpp>
@@ -219,86 +220,150 @@ namespace RDKit{
       }
     }
                 
-    void sanitizeMol(RWMol &mol){
-      unsigned int failedOp=0;
-      sanitizeMol(mol,failedOp,SANITIZE_ALL);
-    }
-    void sanitizeMol(RWMol &mol,
-                     unsigned int &operationThatFailed,
-                     unsigned int sanitizeOps){
-      // clear out any cached properties
-      mol.clearComputedProps();
+    namespace {
+      const std::string sanitizeOpsDoneName="_SanitizeOpsDone";
 
-      operationThatFailed=SANITIZE_CLEANUP;
-      if(sanitizeOps & operationThatFailed){
-        // clean up things like nitro groups
-        cleanUp(mol);
-      }
+      // accumulates the CPU time between construction and destruction
+      class StepTimer {
+      public:
+        StepTimer(MolOps::SanitizeTimings *timings,unsigned int op) :
+          dp_timings(timings), d_op(op) {
+          if(dp_timings) d_start=std::clock();
+        };
+        ~StepTimer() {
+          if(dp_timings){
+            (*dp_timings)[d_op]+=static_cast<double>(std::clock()-d_start)/CLOCKS_PER_SEC;
+          }
+        };
+      private:
+        MolOps::SanitizeTimings *dp_timings;
+        unsigned int d_op;
+        std::clock_t d_start;
+      };
 
-      // update computed properties on atoms and bonds:
-      operationThatFailed = SANITIZE_PROPERTIES;
-      if(sanitizeOps & operationThatFailed){
-        mol.updatePropertyCache(true);
-      } else {
-        mol.updatePropertyCache(false);
-      }
+      void runSanitizeOps(RWMol &mol,
+                          unsigned int &operationThatFailed,
+                          unsigned int sanitizeOps,
+                          MolOps::SanitizeTimings *timings){
+        operationThatFailed=SANITIZE_CLEANUP;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          // clean up things like nitro groups
+          cleanUp(mol);
+        }
+
+        // update computed properties on atoms and bonds:
+        operationThatFailed = SANITIZE_PROPERTIES;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          mol.updatePropertyCache(true);
+        } else {
+          mol.updatePropertyCache(false);
+        }
                
-      operationThatFailed = SANITIZE_SYMMRINGS;
-      if(sanitizeOps & operationThatFailed){
-        VECT_INT_VECT arings;
-        MolOps::symmetrizeSSSR(mol, arings);
-      }
+        operationThatFailed = SANITIZE_SYMMRINGS;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          VECT_INT_VECT arings;
+          MolOps::symmetrizeSSSR(mol, arings);
+        }
 
-      // kekulizations
-      operationThatFailed = SANITIZE_KEKULIZE;
-      if(sanitizeOps & operationThatFailed){
-        Kekulize(mol);
-      }
+        // kekulizations
+        operationThatFailed = SANITIZE_KEKULIZE;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          Kekulize(mol,true,100,(sanitizeOps & SANITIZE_KEKULIZE_MATCHING)!=0);
+        }
 
-      // look for radicals:
-      // We do this now because we need to know
-      // that the N in [N]1C=CC=C1 has a radical
-      // before we move into setAromaticity().
-      // It's important that this happen post-Kekulization
-      // because there's no way of telling what to do 
-      // with the same molecule if it's in the form
-      // [n]1cccc1
-      operationThatFailed = SANITIZE_FINDRADICALS;
-      if(sanitizeOps & operationThatFailed){
-        assignRadicals(mol);
-      }
+        // look for radicals:
+        // We do this now because we need to know
+        // that the N in [N]1C=CC=C1 has a radical
+        // before we move into setAromaticity().
+        // It's important that this happen post-Kekulization
+        // because there's no way of telling what to do 
+        // with the same molecule if it's in the form
+        // [n]1cccc1
+        operationThatFailed = SANITIZE_FINDRADICALS;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          assignRadicals(mol);
+        }
       
-      // then do aromaticity perception
-      operationThatFailed = SANITIZE_SETAROMATICITY;
-      if(sanitizeOps & operationThatFailed){
-        setAromaticity(mol);
-      }
+        // then do aromaticity perception
+        operationThatFailed = SANITIZE_SETAROMATICITY;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          setAromaticity(mol);
+        }
     
-      // set conjugation
-      operationThatFailed = SANITIZE_SETCONJUGATION;
-      if(sanitizeOps & operationThatFailed){
-        setConjugation(mol);
-      }
+        // set conjugation
+        operationThatFailed = SANITIZE_SETCONJUGATION;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          setConjugation(mol);
+        }
     
-      // set hybridization
-      operationThatFailed = SANITIZE_SETHYBRIDIZATION;
-      if(sanitizeOps & operationThatFailed){
-        setHybridization(mol);
-      }
+        // set hybridization
+        operationThatFailed = SANITIZE_SETHYBRIDIZATION;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          setHybridization(mol);
+        }
+
+        // remove bogus chirality specs:
+        operationThatFailed = SANITIZE_CLEANUPCHIRALITY;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          cleanupChirality(mol);
+        }
+
+        // adjust Hydrogen counts:
+        operationThatFailed = SANITIZE_ADJUSTHS;
+        if(sanitizeOps & operationThatFailed){
+          StepTimer timer(timings,operationThatFailed);
+          adjustHs(mol);
+        }
 
-      // remove bogus chirality specs:
-      operationThatFailed = SANITIZE_CLEANUPCHIRALITY;
-      if(sanitizeOps & operationThatFailed){
-        cleanupChirality(mol);
+        operationThatFailed = 0;
       }
+    } // end of anonymous namespace
+
+    void sanitizeMol(RWMol &mol){
+      unsigned int failedOp=0;
+      sanitizeMol(mol,failedOp,SANITIZE_ALL);
+    }
+    void sanitizeMol(RWMol &mol,
+                     unsigned int &operationThatFailed,
+                     unsigned int sanitizeOps){
+      sanitizeMol(mol,operationThatFailed,sanitizeOps,0);
+    }
+    void sanitizeMol(RWMol &mol,
+                     unsigned int &operationThatFailed,
+                     unsigned int sanitizeOps,
+                     SanitizeTimings *timings){
+      // clear out any cached properties
+      mol.clearComputedProps();
+
+      runSanitizeOps(mol,operationThatFailed,sanitizeOps,timings);
+      mol.setProp(sanitizeOpsDoneName,sanitizeOps,true);
+    }
 
-      // adjust Hydrogen counts:
-      operationThatFailed = SANITIZE_ADJUSTHS;
-      if(sanitizeOps & operationThatFailed){
-        adjustHs(mol);
+    void completeSanitization(RWMol &mol,
+                              unsigned int &operationThatFailed,
+                              unsigned int sanitizeOps,
+                              SanitizeTimings *timings){
+      unsigned int opsDone=0;
+      if(mol.hasProp(sanitizeOpsDoneName)){
+        mol.getProp(sanitizeOpsDoneName,opsDone);
       }
+      operationThatFailed=0;
+      // the valences are only right once groups like uncharged nitros
+      // have been cleaned up:
+      if(sanitizeOps & SANITIZE_PROPERTIES) sanitizeOps |= SANITIZE_CLEANUP;
+      if((sanitizeOps & ~opsDone) == 0) return;
 
-      operationThatFailed = 0;
+      runSanitizeOps(mol,operationThatFailed,sanitizeOps & ~opsDone,timings);
+      mol.setProp(sanitizeOpsDoneName,opsDone|sanitizeOps,true);
     }
 
     std::vector<ROMOL_SPTR> getMolFrags(const ROMol &mol,bool sanitizeFrags,
@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <list>
+#include <map>
 #include <boost/smart_ptr.hpp>
 #include <boost/dynamic_bitset.hpp>
 
@@ -229,7 +230,8 @@ namespace RDKit{
       SANITIZE_SETHYBRIDIZATION=0x80,
       SANITIZE_CLEANUPCHIRALITY=0x100,
       SANITIZE_ADJUSTHS=0x200,
-      SANITIZE_ALL=0xFFFFFFF
+      SANITIZE_ALL=0xFFFFFFF,
+      SANITIZE_KEKULIZE_MATCHING=0x10000000
     } SanitizeFlags;
 
     //! \brief carries out a collection of tasks for cleaning up a molecule and ensuring
@@ -255,6 +257,9 @@ namespace RDKit{
 
        \param sanitizeOps : the bits here are used to set which sanitization operations are carried
                             out. The elements of the \c SanitizeFlags enum define the operations.
+                            \c SANITIZE_KEKULIZE_MATCHING is not an operation and is not part of
+                            \c SANITIZE_ALL: adding it selects the matching-based kekulization
+                            (see Kekulize()).
        
        <b>Notes:</b>
         - If there is a failure in the sanitization, a \c SanitException
@@ -268,6 +273,63 @@ namespace RDKit{
     //! \overload
     void sanitizeMol(RWMol &mol);
 
+    //! CPU time (in seconds) spent in sanitization operations, keyed by \c SanitizeFlags
+    typedef std::map<unsigned int,double> SanitizeTimings;
+
+    //! \overload
+    /*!
+      \param timings : if provided, the time spent in each of the operations
+                       is added to the corresponding entry. Since the times
+                       are accumulated, a single \c SanitizeTimings can be
+                       used to profile the sanitization of a set of molecules.
+    */
+    void sanitizeMol(RWMol &mol,unsigned int &operationThatFailed,
+                     unsigned int sanitizeOps,SanitizeTimings *timings);
+
+    //! \brief carries out the sanitization operations in \c sanitizeOps
+    //! that have not already been done on the molecule
+    /*!
+       This allows sanitization to be done lazily: molecules can be
+       constructed without sanitization (or with a reduced set of
+       operations) and this is called before using something which requires
+       additional operations. For example, pattern screening may only need
+       \c SANITIZE_PROPERTIES while generating canonical SMILES needs the full set.
+
+       \param mol : the RWMol to be cleaned
+       \param operationThatFailed : as for sanitizeMol()
+       \param sanitizeOps : the operations which are required
+       \param timings : as for sanitizeMol()
+
+       <b>Notes:</b>
+        - the operations done are recorded in a computed property on the
+          molecule, so repeated calls are cheap. This record is removed by
+          \c ROMol::clearComputedProps(), which should be called if the
+          molecule is modified.
+        - \c SANITIZE_PROPERTIES implies \c SANITIZE_CLEANUP, without which
+          groups like uncharged nitros fail the valence checks.
+        - the operations are carried out in the order used by sanitizeMol().
+          Operations done in an earlier call are not repeated, so the set
+          of operations must make sense on its own: \c SANITIZE_SETAROMATICITY,
+          for example, expects the molecule to have been kekulized.
+        - If there is a failure in the sanitization, a \c SanitException
+	  will be thrown.
+    */
+    void completeSanitization(RWMol &mol,unsigned int &operationThatFailed,
+                              unsigned int sanitizeOps=SANITIZE_ALL,
+                              SanitizeTimings *timings=0);
+
+    //! the work done by findRelevantCycles() and setAromaticity()
+    /*!
+      The counts are added to, so a single \c PerceptionCost can be
+      used to accumulate the cost over a set of molecules.
+    */
+    struct PerceptionCost {
+      PerceptionCost() : numRingSystems(0), numCandidates(0), numResults(0) {};
+      unsigned int numRingSystems; //!< ring systems (or fused ring systems) processed
+      unsigned int numCandidates;  //!< candidate cycles (or fused ring subsystems) examined
+      unsigned int numResults;     //!< relevant cycles (or aromatic rings) found
+    };
+
     //! Sets up the aromaticity for a molecule
     /*!
 
@@ -280,8 +342,17 @@ namespace RDKit{
             or non-candidates. A ring is a candidate only if all its atoms are candidates
          -# apply Hueckel rule to each of the candidate rings to check if the ring can be
 	    aromatic
+         -# apply Hueckel rule to each connected group of up to six candidate rings
+            in each fused ring system. The groups are enumerated directly from the
+            ring adjacency, so the work grows with the number of groups rather than
+            with the number of combinations of rings, and a fused system is left
+            as soon as evaluating further groups cannot change anything.
 
       \param mol the RWMol of interest
+      \param cost if provided, the work done is added to this
+      \param maxFusedSubsystems the maximum number of groups of fused rings
+             that will be evaluated. If this is exceeded a MolSanitizeException
+             is thrown. Zero means no limit.
       
       \return 1 on succes, 0 otherwise
       
@@ -290,7 +361,8 @@ namespace RDKit{
 	  been called)
        
     */
-    int setAromaticity(RWMol &mol);
+    int setAromaticity(RWMol &mol,PerceptionCost *cost=0,
+                       unsigned int maxFusedSubsystems=1000000);
 
 
     //! Designed to be called by the sanitizer to handle special cases before anything is done.
@@ -341,14 +413,24 @@ namespace RDKit{
        \param maxBackTracks   the maximum number of attempts at back-tracking. The algorithm 
                               uses a back-tracking procedure to revist a previous setting of 
                               double bond if we hit a wall in the kekulization process
+       \param useMatching     if this is set to true, the double bonds are assigned by finding
+                              a maximum matching (Edmonds' blossom algorithm) on the atoms that
+                              can take one instead of by back-tracking. This takes polynomial
+                              time, which makes a difference for large fused systems
+                              (fullerenes, graphene fragments, porphyrin arrays, ...).
+                              \c maxBackTracks is ignored.
                               
        <b>Notes:</b>
          - even if \c markAtomsBonds is \c false the \c BondType for all aromatic
 	   bonds will be changed from \c RDKit::Bond::AROMATIC to \c RDKit::Bond::SINGLE
 	   or RDKit::Bond::DOUBLE during Kekulization.
+         - if the back-tracking fails on a fused system, the matching is tried
+           before giving up.
+         - the two methods can produce different (equally valid) Kekule structures.
 
     */
-    void Kekulize(RWMol &mol, bool markAtomsBonds=true, unsigned int maxBackTracks=100);
+    void Kekulize(RWMol &mol, bool markAtomsBonds=true, unsigned int maxBackTracks=100,
+                  bool useMatching=false);
 
     //! flags the molecule's conjugated bonds
     void setConjugation(ROMol &mol);
@@ -401,11 +483,43 @@ namespace RDKit{
           (finds the correct number of them but the wrong ones) on some sample mols
         - Since SSSR may not be unique, a post-SSSR step to symmetrize may be done.
           The extra rings this process adds can be quite useful.
+
+      Ring systems this algorithm fails on are handled with the algorithm
+      used by findRelevantCycles() instead. The extra rings available for
+      symmetrization are then the relevant cycles (one from each family of
+      relevant cycles) that are not in the SSSR.
     */
     int findSSSR(const ROMol &mol, std::vector<std::vector<int> > &res);
     //! \overload
     int findSSSR(const ROMol &mol, std::vector<std::vector<int> > *res=0);
 
+    //! finds the relevant cycles of a molecule
+    /*!
+      A cycle is relevant if it is not the sum (over the bonds, in GF(2)) of
+      shorter cycles. The relevant cycles are the union of all the minimum
+      cycle bases (SSSRs) of the molecule, so they don't depend on the atom
+      ordering. Their number can grow exponentially with the size of highly
+      symmetric ring systems, hence \c maxCycles.
+
+      The candidates are generated with Vismara's variant of Horton's
+      algorithm, which takes polynomial time.
+
+      \param mol the molecule of interest
+      \param res used to return the rings. Each entry is a vector with atom
+             indices in ring order; the rings are sorted by size within each
+             fragment.
+      \param maxCycles if a fragment has more than this many relevant cycles a
+             ValueErrorException is thrown. Zero means no limit.
+      \param cost if provided, the work done is added to this
+
+      \return the number of relevant cycles
+
+      <b>Notes:</b>
+       - the molecule's RingInfo is not modified
+    */
+    int findRelevantCycles(const ROMol &mol,std::vector<std::vector<int> > &res,
+                           unsigned int maxCycles=100000,PerceptionCost *cost=0);
+
     //! use a DFS algorithm to identify ring bonds and atoms in a molecule
     /*!
       \b NOTE: though the RingInfo structure is populated by this function,
@@ -668,6 +782,23 @@ namespace RDKit{
     */
     void assignStereochemistry(ROMol &mol,bool cleanIt=false,bool force=false,
                                bool flagPossibleStereoCenters=false);
+    //! Assign stereochemistry tags to a set of molecules
+    /*!
+      This is equivalent to calling assignStereochemistry() on each
+      molecule, with the molecules divided among \c numThreads threads.
+
+      \param mols    the molecules of interest. Null entries are skipped.
+      \param cleanIt, force, flagPossibleStereoCenters  as for assignStereochemistry()
+      \param numThreads  the number of threads to use (see getNumThreadsToUse())
+
+      If assigning the stereochemistry of a molecule throws an exception,
+      its thread stops and, once all the threads are done, the exception
+      from the first such molecule is rethrown (an Invar::Invariant as
+      itself, anything else as a std::runtime_error).
+    */
+    void assignStereochemistry(const std::vector<ROMol *> &mols,bool cleanIt=false,
+                               bool force=false,bool flagPossibleStereoCenters=false,
+                               int numThreads=1);
     //! Removes all stereochemistry information from atoms (i.e. R/S) and bonds (i.e. Z/E)
     /*!
 
@@ -18,15 +18,21 @@
 #include <RDGeneral/types.h>
 #include <Query/QueryObjects.h>
 #include <map>
+#include <cstring>
 #include <boost/cstdint.hpp>
 using boost::int32_t;
 using boost::uint32_t;
+using boost::int8_t;
+using boost::uint8_t;
+using boost::uint16_t;
 namespace RDKit{
 
   const int32_t MolPickler::versionMajor=7;
   const int32_t MolPickler::versionMinor=2;
   const int32_t MolPickler::versionPatch=0;
   const int32_t MolPickler::endianId=0xDEADBEEF;
+  const int32_t MolPickler::compactVersionMajor=8;
+  const int32_t MolPickler::compactVersionMinor=0;
 
   void streamWrite(std::ostream &ss,const std::string &what){
     unsigned int l=what.length();
@@ -596,6 +602,70 @@ namespace RDKit{
     }
 
 
+    // a minimal reader for pickles held in memory. Values are stored
+    // little-endian.
+    class PickleBuffer {
+    public:
+      PickleBuffer(const char *data,size_t len) : dp_pos(data), dp_end(data+len) {};
+      template <typename T>
+      T read() {
+        T res;
+        std::memcpy(&res,take(sizeof(T)),sizeof(T));
+        return EndianSwapBytes<LITTLE_ENDIAN_ORDER,HOST_ENDIAN_ORDER>(res);
+      }
+      //! returns a pointer to the next \c n bytes and moves past them
+      const char *take(size_t n) {
+        if(static_cast<size_t>(dp_end-dp_pos)<n){
+          throw MolPicklerException("Bad pickle format: unexpected end of pickle");
+        }
+        const char *res=dp_pos;
+        dp_pos+=n;
+        return res;
+      }
+      //! reads a count of items that are each at least \c itemSize bytes
+      //! long, so it can't be negative or larger than what is left
+      int32_t readCount(size_t itemSize) {
+        int32_t res=read<int32_t>();
+        if(res<0){
+          throw MolPicklerException("Bad pickle format: negative count");
+        }
+        if(itemSize && static_cast<size_t>(res)>static_cast<size_t>(dp_end-dp_pos)/itemSize){
+          throw MolPicklerException("Bad pickle format: unexpected end of pickle");
+        }
+        return res;
+      }
+      //! reads an index that must be less than \c n
+      int32_t readIndex(int32_t n) {
+        int32_t res=read<int32_t>();
+        if(res<0 || res>=n){
+          throw MolPicklerException("Bad pickle format: index out of range");
+        }
+        return res;
+      }
+      //! reads a one byte enum value that must not be larger than \c maxVal
+      template <typename E>
+      E readEnum(E maxVal) {
+        uint8_t res=read<uint8_t>();
+        if(res>static_cast<uint8_t>(maxVal)){
+          throw MolPicklerException("Bad pickle format: enum value out of range");
+        }
+        return static_cast<E>(res);
+      }
+      bool atEnd() const { return dp_pos==dp_end; };
+    private:
+      const char *dp_pos,*dp_end;
+    };
+
+    template <typename T>
+    void appendValue(std::string &buf,T val){
+      val=EndianSwapBytes<HOST_ENDIAN_ORDER,LITTLE_ENDIAN_ORDER>(val);
+      buf.append(reinterpret_cast<const char *>(&val),sizeof(T));
+    }
+    void appendSection(std::string &buf,const std::string &section){
+      appendValue(buf,static_cast<uint32_t>(section.size()));
+      buf.append(section);
+    }
+
   } // end of anonymous namespace
 
 
@@ -623,10 +693,33 @@ namespace RDKit{
     res = ss.str();
   }
 
+  void MolPickler::pickleMolCompact(const ROMol *mol,std::ostream &ss){
+    PRECONDITION(mol,"empty molecule");
+    if(!_canPickleCompact(mol)){
+      MolPickler::pickleMol(mol,ss);
+      return;
+    }
+    std::string body;
+    _pickleCompact(mol,body);
+    streamWrite(ss,endianId);
+    streamWrite(ss,static_cast<int>(VERSION));
+    streamWrite(ss,compactVersionMajor);
+    streamWrite(ss,compactVersionMinor);
+    streamWrite(ss,static_cast<int32_t>(0));
+    streamWrite(ss,static_cast<uint32_t>(body.size()));
+    ss.write(body.c_str(),body.size());
+  }
+  void MolPickler::pickleMolCompact(const ROMol *mol,std::string &res){
+    PRECONDITION(mol,"empty molecule");
+    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+    MolPickler::pickleMolCompact(mol,ss);
+    res = ss.str();
+  }
+
   // NOTE: if the mol passed in here already has atoms and bonds, they will
   // be left intact.  The side effect is that ALL atom and bond bookmarks
   // will be blown out by the end of this process.
-  void MolPickler::molFromPickle(std::istream &ss,ROMol *mol){
+  void MolPickler::molFromPickle(std::istream &ss,ROMol *mol,unsigned int readFlags){
     PRECONDITION(mol,"empty molecule");
     int32_t tmpInt;
 
@@ -646,6 +739,22 @@ namespace RDKit{
     streamRead(ss,majorVersion);
     streamRead(ss,minorVersion);
     streamRead(ss,patchVersion);
+    if(majorVersion==compactVersionMajor){
+      if(minorVersion>compactVersionMinor){
+        BOOST_LOG(rdWarningLog)<<"Depickling from a compact version number ("<<majorVersion<<"." << minorVersion<<")" << "that is higher than our version ("<<compactVersionMajor<<"."<<compactVersionMinor<<").\nThis probably won't work."<<std::endl;
+      }
+      // the body is length-prefixed so that we read exactly the
+      // pickle's bytes from the stream:
+      uint32_t len;
+      streamRead(ss,len);
+      std::string body(len,0);
+      ss.read(&body[0],len);
+      if(static_cast<uint32_t>(ss.gcount())!=len){
+        throw MolPicklerException("Bad pickle format: truncated compact pickle");
+      }
+      _depickleCompact(body.c_str(),len,mol,readFlags);
+      return;
+    }
     if(majorVersion>versionMajor||(majorVersion==versionMajor&&minorVersion>versionMinor)){
       BOOST_LOG(rdWarningLog)<<"Depickling from a version number ("<<majorVersion<<"." << minorVersion<<")" << "that is higher than our version ("<<versionMajor<<"."<<versionMinor<<").\nThis probably won't work."<<std::endl;
     }
@@ -667,14 +776,54 @@ namespace RDKit{
       // FIX for issue 220 - probably better to change the pickle format later
       MolOps::assignStereochemistry(*mol,true);
     }
+    _applyReadFlags(mol,readFlags);
   }
-  void MolPickler::molFromPickle(const std::string &pickle,ROMol *mol){
+  void MolPickler::molFromPickle(const std::string &pickle,ROMol *mol,unsigned int readFlags){
     PRECONDITION(mol,"empty molecule");
-    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
-    ss.write(pickle.c_str(),pickle.length());
-    MolPickler::molFromPickle(ss,mol);
+    MolPickler::molFromPickle(pickle.c_str(),pickle.length(),mol,readFlags);
+  }
+  void MolPickler::molFromPickle(const char *pickle,size_t len,ROMol *mol,unsigned int readFlags){
+    PRECONDITION(mol,"empty molecule");
+    PRECONDITION(pickle||!len,"no pickle data");
+    PickleBuffer buf(pickle,len);
+    if(len>=6*sizeof(int32_t) &&
+       buf.read<int32_t>()==endianId &&
+       buf.read<int32_t>()==static_cast<int32_t>(VERSION) &&
+       buf.read<int32_t>()==compactVersionMajor){
+      // compact pickles are read straight from the buffer:
+      int32_t minorVersion=buf.read<int32_t>();
+      buf.read<int32_t>();
+      if(minorVersion>compactVersionMinor){
+        BOOST_LOG(rdWarningLog)<<"Depickling from a compact version number ("<<compactVersionMajor<<"." << minorVersion<<")" << "that is higher than our version ("<<compactVersionMajor<<"."<<compactVersionMinor<<").\nThis probably won't work."<<std::endl;
+      }
+      uint32_t bodyLen=buf.read<uint32_t>();
+      const char *body=buf.take(bodyLen);
+      mol->clearAllAtomBookmarks();
+      mol->clearAllBondBookmarks();
+      _depickleCompact(body,bodyLen,mol,readFlags);
+    } else {
+      std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+      ss.write(pickle,len);
+      MolPickler::molFromPickle(ss,mol,readFlags);
+    }
   }
 
+  void MolPickler::_applyReadFlags(ROMol *mol,unsigned int readFlags){
+    PRECONDITION(mol,"empty molecule");
+    if(readFlags&SKIP_RINGINFO){
+      mol->getRingInfo()->reset();
+    }
+    if(readFlags&SKIP_CONFORMERS){
+      mol->clearConformers();
+    }
+    if(readFlags&SKIP_ATOMPROPS){
+      for(ROMol::AtomIterator atIt=mol->beginAtoms();
+          atIt!=mol->endAtoms();++atIt){
+        if((*atIt)->hasProp("molAtomMapNumber")) (*atIt)->clearProp("molAtomMapNumber");
+        if((*atIt)->hasProp("dummyLabel")) (*atIt)->clearProp("dummyLabel");
+      }
+    }
+  }
 
   //--------------------------------------
   //
@@ -1483,6 +1632,378 @@ namespace RDKit{
   }
 
 
+  //--------------------------------------
+  //
+  //            Compact format
+  //
+  //  Layout of the body (all values little-endian):
+  //    int32 numAtoms, int32 numBonds, uint32 section flags
+  //    numAtoms 12 byte atom records
+  //    numBonds 12 byte bond records
+  //    the optional sections given by the section flags, each preceded
+  //    by its uint32 length so that it can be skipped:
+  //      bond stereo atoms, atom properties, rings, conformers
+  //
+  //--------------------------------------
+  namespace {
+    const unsigned int COMPACT_ATOM_SIZE=12;
+    const unsigned int COMPACT_BOND_SIZE=12;
+
+    const uint32_t SECTION_STEREO=0x1;
+    const uint32_t SECTION_ATOMPROPS=0x2;
+    const uint32_t SECTION_RINGS=0x4;
+    const uint32_t SECTION_CONFS=0x8;
+
+    const uint8_t ATOMFLAG_AROMATIC=0x1;
+    const uint8_t ATOMFLAG_NOIMPLICIT=0x2;
+
+    const uint8_t BONDFLAG_AROMATIC=0x1;
+    const uint8_t BONDFLAG_CONJUGATED=0x2;
+
+    const uint8_t ATOMPROP_MAPNUMBER=1;
+    const uint8_t ATOMPROP_DUMMYLABEL=2;
+  }
+
+  bool MolPickler::_canPickleCompact(const ROMol *mol){
+    PRECONDITION(mol,"empty molecule");
+    for(ROMol::ConstAtomIterator atIt=mol->beginAtoms();
+        atIt!=mol->endAtoms();++atIt){
+      const Atom *atom=*atIt;
+      if(atom->hasQuery() || atom->getMonomerInfo() ||
+         atom->getAtomicNum()>255 || atom->getIsotope()>0xFFFF ||
+         atom->getNumExplicitHs()>255 || atom->getNumRadicalElectrons()>255 ||
+         atom->getFormalCharge()<-128 || atom->getFormalCharge()>127){
+        return false;
+      }
+    }
+    for(ROMol::ConstBondIterator bondIt=mol->beginBonds();
+        bondIt!=mol->endBonds();++bondIt){
+      if((*bondIt)->hasQuery()) return false;
+    }
+    return true;
+  }
+
+  void MolPickler::_pickleCompact(const ROMol *mol,std::string &res){
+    PRECONDITION(mol,"empty molecule");
+    unsigned int nAtoms=mol->getNumAtoms();
+    unsigned int nBonds=mol->getNumBonds();
+
+    std::string stereo,atomProps,rings,confs;
+    int32_t nStereo=0,nAtomProps=0;
+
+    res.clear();
+    res.reserve(3*sizeof(int32_t)+COMPACT_ATOM_SIZE*nAtoms+COMPACT_BOND_SIZE*nBonds+
+                mol->getNumConformers()*(sizeof(int32_t)+1+3*sizeof(float)*nAtoms));
+    appendValue(res,static_cast<int32_t>(nAtoms));
+    appendValue(res,static_cast<int32_t>(nBonds));
+    // the section flags are filled in once we know what's there:
+    std::string::size_type sectionPos=res.size();
+    appendValue(res,static_cast<uint32_t>(0));
+
+    for(unsigned int i=0;i<nAtoms;++i){
+      const Atom *atom=mol->getAtomWithIdx(i);
+      uint8_t flags=0;
+      if(atom->getIsAromatic()) flags |= ATOMFLAG_AROMATIC;
+      if(atom->getNoImplicit()) flags |= ATOMFLAG_NOIMPLICIT;
+      appendValue(res,static_cast<uint8_t>(atom->getAtomicNum()));
+      appendValue(res,static_cast<int8_t>(atom->getFormalCharge()));
+      appendValue(res,static_cast<uint8_t>(atom->getChiralTag()));
+      appendValue(res,static_cast<uint8_t>(atom->getHybridization()));
+      appendValue(res,static_cast<uint8_t>(atom->getNumExplicitHs()));
+      appendValue(res,static_cast<int8_t>(atom->d_explicitValence));
+      appendValue(res,static_cast<int8_t>(atom->d_implicitValence));
+      appendValue(res,static_cast<uint8_t>(atom->getNumRadicalElectrons()));
+      appendValue(res,flags);
+      appendValue(res,static_cast<uint8_t>(0));
+      appendValue(res,static_cast<uint16_t>(atom->getIsotope()));
+
+      int mapNum;
+      if(getAtomMapNumber(atom,mapNum)){
+        appendValue(atomProps,static_cast<int32_t>(i));
+        appendValue(atomProps,ATOMPROP_MAPNUMBER);
+        appendValue(atomProps,static_cast<int32_t>(mapNum));
+        ++nAtomProps;
+      }
+      if(atom->hasProp("dummyLabel")){
+        const std::string &label=atom->getProp<std::string>("dummyLabel");
+        appendValue(atomProps,static_cast<int32_t>(i));
+        appendValue(atomProps,ATOMPROP_DUMMYLABEL);
+        appendValue(atomProps,static_cast<uint32_t>(label.size()));
+        atomProps.append(label);
+        ++nAtomProps;
+      }
+    }
+
+    for(unsigned int i=0;i<nBonds;++i){
+      const Bond *bond=mol->getBondWithIdx(i);
+      uint8_t flags=0;
+      if(bond->getIsAromatic()) flags |= BONDFLAG_AROMATIC;
+      if(bond->getIsConjugated()) flags |= BONDFLAG_CONJUGATED;
+      appendValue(res,static_cast<int32_t>(bond->getBeginAtomIdx()));
+      appendValue(res,static_cast<int32_t>(bond->getEndAtomIdx()));
+      appendValue(res,static_cast<uint8_t>(bond->getBondType()));
+      appendValue(res,static_cast<uint8_t>(bond->getBondDir()));
+      appendValue(res,static_cast<uint8_t>(bond->getStereo()));
+      appendValue(res,flags);
+
+      const INT_VECT &stereoAts=bond->getStereoAtoms();
+      if(!stereoAts.empty()){
+        appendValue(stereo,static_cast<int32_t>(i));
+        appendValue(stereo,static_cast<int32_t>(stereoAts.size()));
+        for(INT_VECT_CI idxIt=stereoAts.begin();idxIt!=stereoAts.end();++idxIt){
+          appendValue(stereo,static_cast<int32_t>(*idxIt));
+        }
+        ++nStereo;
+      }
+    }
+
+    uint32_t sections=0;
+    if(nStereo){
+      sections |= SECTION_STEREO;
+      std::string tmp;
+      appendValue(tmp,nStereo);
+      tmp.append(stereo);
+      appendSection(res,tmp);
+    }
+    if(nAtomProps){
+      sections |= SECTION_ATOMPROPS;
+      std::string tmp;
+      appendValue(tmp,nAtomProps);
+      tmp.append(atomProps);
+      appendSection(res,tmp);
+    }
+    const RingInfo *ringInfo=mol->getRingInfo();
+    if(ringInfo && ringInfo->isInitialized()){
+      sections |= SECTION_RINGS;
+      appendValue(rings,static_cast<int32_t>(ringInfo->numRings()));
+      for(unsigned int i=0;i<ringInfo->numRings();++i){
+        const INT_VECT &atomRing=ringInfo->atomRings()[i];
+        const INT_VECT &bondRing=ringInfo->bondRings()[i];
+        appendValue(rings,static_cast<int32_t>(atomRing.size()));
+        for(unsigned int j=0;j<atomRing.size();++j){
+          appendValue(rings,static_cast<int32_t>(atomRing[j]));
+        }
+        for(unsigned int j=0;j<bondRing.size();++j){
+          appendValue(rings,static_cast<int32_t>(bondRing[j]));
+        }
+      }
+      appendSection(res,rings);
+    }
+    if(mol->getNumConformers()){
+      sections |= SECTION_CONFS;
+      appendValue(confs,static_cast<int32_t>(mol->getNumConformers()));
+      for(ROMol::ConstConformerIterator ci=mol->beginConformers();
+          ci!=mol->endConformers();++ci){
+        const Conformer *conf=ci->get();
+        appendValue(confs,static_cast<int32_t>(conf->getId()));
+        appendValue(confs,static_cast<uint8_t>(conf->is3D()));
+        const RDGeom::POINT3D_VECT &pts=conf->getPositions();
+        for(RDGeom::POINT3D_VECT_CI pti=pts.begin();pti!=pts.end();++pti){
+          appendValue(confs,static_cast<float>(pti->x));
+          appendValue(confs,static_cast<float>(pti->y));
+          appendValue(confs,static_cast<float>(pti->z));
+        }
+      }
+      appendSection(res,confs);
+    }
+    sections=EndianSwapBytes<HOST_ENDIAN_ORDER,LITTLE_ENDIAN_ORDER>(sections);
+    res.replace(sectionPos,sizeof(sections),
+                reinterpret_cast<const char *>(&sections),sizeof(sections));
+  }
+
+  // NOTE: as with the other formats, atoms and bonds are appended to
+  // whatever the molecule already contains. If the molecule is empty the
+  // graph is allocated in one step and bonds are added to it directly
+  // instead of through ROMol::addBond(), so this is considerably faster.
+  void MolPickler::_depickleCompact(const char *data,size_t len,ROMol *mol,
+                                    unsigned int readFlags){
+    PRECONDITION(mol,"empty molecule");
+    PickleBuffer buf(data,len);
+    int32_t numAtoms=buf.read<int32_t>();
+    int32_t numBonds=buf.read<int32_t>();
+    uint32_t sections=buf.read<uint32_t>();
+    if(numAtoms<0 || numBonds<0){
+      throw MolPicklerException("Bad pickle format: negative atom or bond count");
+    }
+    const unsigned int atomOffset=mol->getNumAtoms();
+    const unsigned int bondOffset=mol->getNumBonds();
+    const bool directMap=!atomOffset && !mol->getNumConformers();
+
+    // -------------------
+    //
+    // Read Atoms
+    //
+    // -------------------
+    const char *atomData=buf.take(static_cast<size_t>(numAtoms)*COMPACT_ATOM_SIZE);
+    if(directMap){
+      MolGraph tmp(numAtoms);
+      mol->d_graph.swap(tmp);
+    }
+    for(int32_t i=0;i<numAtoms;++i){
+      PickleBuffer rec(atomData+i*COMPACT_ATOM_SIZE,COMPACT_ATOM_SIZE);
+      unsigned int atomicNum=rec.read<uint8_t>();
+      if(atomicNum>PeriodicTable::getTable()->getMaxAtomicNumber()){
+        throw MolPicklerException("Bad pickle format: bad atomic number");
+      }
+      int formalCharge=rec.read<int8_t>();
+      Atom::ChiralType chiralTag=rec.readEnum(Atom::CHI_OTHER);
+      Atom::HybridizationType hybridization=rec.readEnum(Atom::OTHER);
+      Atom *atom=new Atom(atomicNum);
+      atom->setFormalCharge(formalCharge);
+      atom->setChiralTag(chiralTag);
+      atom->setHybridization(hybridization);
+      atom->setNumExplicitHs(rec.read<uint8_t>());
+      atom->d_explicitValence=rec.read<int8_t>();
+      atom->d_implicitValence=rec.read<int8_t>();
+      atom->d_numRadicalElectrons=rec.read<uint8_t>();
+      uint8_t flags=rec.read<uint8_t>();
+      atom->setIsAromatic(flags&ATOMFLAG_AROMATIC);
+      atom->setNoImplicit(flags&ATOMFLAG_NOIMPLICIT);
+      rec.read<uint8_t>();
+      unsigned int isotope=rec.read<uint16_t>();
+      if(isotope) atom->setIsotope(isotope);
+      if(directMap){
+        atom->setOwningMol(mol);
+        atom->setIdx(i);
+        mol->d_graph[i].reset(atom);
+      } else {
+        mol->addAtom(atom,false,true);
+      }
+    }
+
+    // -------------------
+    //
+    // Read Bonds
+    //
+    // -------------------
+    const char *bondData=buf.take(static_cast<size_t>(numBonds)*COMPACT_BOND_SIZE);
+    for(int32_t i=0;i<numBonds;++i){
+      PickleBuffer rec(bondData+i*COMPACT_BOND_SIZE,COMPACT_BOND_SIZE);
+      int32_t begIdx=rec.read<int32_t>();
+      int32_t endIdx=rec.read<int32_t>();
+      if(begIdx<0 || begIdx>=numAtoms || endIdx<0 || endIdx>=numAtoms || begIdx==endIdx){
+        throw MolPicklerException("Bad pickle format: bad bond atom indices");
+      }
+      if(mol->getBondBetweenAtoms(begIdx+atomOffset,endIdx+atomOffset)){
+        throw MolPicklerException("Bad pickle format: duplicate bond");
+      }
+      Bond::BondType bondType=rec.readEnum(Bond::OTHER);
+      Bond::BondDir bondDir=rec.readEnum(Bond::UNKNOWN);
+      Bond::BondStereo stereo=rec.readEnum(Bond::STEREOE);
+      Bond *bond=new Bond(bondType);
+      bond->setBondDir(bondDir);
+      bond->setStereo(stereo);
+      uint8_t flags=rec.read<uint8_t>();
+      bond->setIsAromatic(flags&BONDFLAG_AROMATIC);
+      bond->setIsConjugated(flags&BONDFLAG_CONJUGATED);
+      bond->setBeginAtomIdx(begIdx+atomOffset);
+      bond->setEndAtomIdx(endIdx+atomOffset);
+      if(directMap){
+        bond->setOwningMol(mol);
+        bool ok;
+        MolGraph::edge_descriptor which;
+        boost::tie(which,ok)=boost::add_edge(begIdx,endIdx,mol->d_graph);
+        CHECK_INVARIANT(ok,"bond could not be added");
+        mol->d_graph[which].reset(bond);
+        bond->setIdx(i);
+      } else {
+        mol->addBond(bond,true);
+      }
+    }
+
+    // -------------------
+    //
+    // Optional sections
+    //
+    // -------------------
+    const uint32_t knownSections[4]={SECTION_STEREO,SECTION_ATOMPROPS,SECTION_RINGS,SECTION_CONFS};
+    for(unsigned int s=0;s<4;++s){
+      if(!(sections&knownSections[s])) continue;
+      uint32_t secLen=buf.read<uint32_t>();
+      const char *secData=buf.take(secLen);
+      PickleBuffer sec(secData,secLen);
+      switch(knownSections[s]){
+      case SECTION_STEREO:
+        {
+          int32_t nStereo=sec.readCount(2*sizeof(int32_t));
+          for(int32_t i=0;i<nStereo;++i){
+            int32_t bondIdx=sec.readIndex(numBonds);
+            int32_t nAts=sec.readCount(sizeof(int32_t));
+            INT_VECT &stereoAts=mol->getBondWithIdx(bondIdx+bondOffset)->getStereoAtoms();
+            stereoAts.reserve(nAts);
+            for(int32_t j=0;j<nAts;++j){
+              stereoAts.push_back(sec.readIndex(numAtoms)+atomOffset);
+            }
+          }
+        }
+        break;
+      case SECTION_ATOMPROPS:
+        if(!(readFlags&SKIP_ATOMPROPS)){
+          int32_t nProps=sec.readCount(sizeof(int32_t)+sizeof(uint8_t));
+          for(int32_t i=0;i<nProps;++i){
+            int32_t atomIdx=sec.readIndex(numAtoms);
+            Atom *atom=mol->getAtomWithIdx(atomIdx+atomOffset);
+            uint8_t which=sec.read<uint8_t>();
+            if(which==ATOMPROP_MAPNUMBER){
+              int mapNum=sec.read<int32_t>();
+              atom->setProp("molAtomMapNumber",mapNum);
+            } else if(which==ATOMPROP_DUMMYLABEL){
+              uint32_t l=sec.read<uint32_t>();
+              const char *label=sec.take(l);
+              atom->setProp("dummyLabel",std::string(label,l));
+            } else {
+              throw MolPicklerException("Bad pickle format: unknown atom property");
+            }
+          }
+        }
+        break;
+      case SECTION_RINGS:
+        if(!(readFlags&SKIP_RINGINFO)){
+          RingInfo *ringInfo=mol->getRingInfo();
+          if(!ringInfo->isInitialized()) ringInfo->initialize();
+          int32_t numRings=sec.readCount(sizeof(int32_t));
+          if(numRings>0){
+            ringInfo->preallocate(mol->getNumAtoms(),mol->getNumBonds());
+          }
+          INT_VECT atoms,bonds;
+          for(int32_t i=0;i<numRings;++i){
+            int32_t ringSize=sec.readCount(2*sizeof(int32_t));
+            atoms.resize(ringSize);
+            bonds.resize(ringSize);
+            for(int32_t j=0;j<ringSize;++j){
+              atoms[j]=sec.readIndex(numAtoms)+atomOffset;
+            }
+            for(int32_t j=0;j<ringSize;++j){
+              bonds[j]=sec.readIndex(numBonds)+bondOffset;
+            }
+            ringInfo->addRing(atoms,bonds);
+          }
+        }
+        break;
+      case SECTION_CONFS:
+        if(!(readFlags&SKIP_CONFORMERS)){
+          int32_t numConfs=sec.readCount(sizeof(int32_t)+sizeof(uint8_t)+
+                                         static_cast<size_t>(numAtoms)*3*sizeof(float));
+          for(int32_t i=0;i<numConfs;++i){
+            int32_t cid=sec.read<int32_t>();
+            bool is3D=sec.read<uint8_t>();
+            Conformer *conf=new Conformer(numAtoms);
+            conf->setId(static_cast<unsigned int>(cid));
+            conf->set3D(is3D);
+            RDGeom::POINT3D_VECT &pts=conf->getPositions();
+            for(RDGeom::POINT3D_VECT_I pti=pts.begin();pti!=pts.end();++pti){
+              pti->x=static_cast<double>(sec.read<float>());
+              pti->y=static_cast<double>(sec.read<float>());
+              pti->z=static_cast<double>(sec.read<float>());
+            }
+            mol->addConformer(conf);
+          }
+        }
+        break;
+      }
+    }
+  }
+
   //--------------------------------------
   //
   //            Version 1 Pickler:
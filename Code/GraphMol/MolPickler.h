@@ -47,6 +47,7 @@ namespace RDKit{
   public:
     static const boost::int32_t versionMajor,versionMinor,versionPatch; //!< mark the pickle version
     static const boost::int32_t endianId;  //! mark the endian-ness of the pickle
+    static const boost::int32_t compactVersionMajor,compactVersionMinor; //!< mark the compact pickle version
 
     //! the pickle format is tagged using these tags:
     //! NOTE: if you add to this list, be sure to put new entries AT THE BOTTOM, otherwise
@@ -112,6 +113,14 @@ namespace RDKit{
       END_ATOM_MONOMER,
     } Tags;
 
+    //! flags controlling which parts of a pickle are read
+    typedef enum {
+      READ_ALL=0,
+      SKIP_RINGINFO=0x1,   //!< do not read ring information
+      SKIP_CONFORMERS=0x2, //!< do not read conformers
+      SKIP_ATOMPROPS=0x4   //!< do not read atom map numbers and dummy labels
+    } ReadFlags;
+
     //! pickles a molecule and sends the results to stream \c ss
     static void pickleMol(const ROMol *mol,std::ostream &ss);
     static void pickleMol(const ROMol &mol,std::ostream &ss) {MolPickler::pickleMol(&mol,ss);};
@@ -119,14 +128,51 @@ namespace RDKit{
     static void pickleMol(const ROMol *mol,std::string &res);
     static void pickleMol(const ROMol &mol,std::string &res) {MolPickler::pickleMol(&mol,res);};
 
+    //! pickles a molecule using the compact format and sends the results to stream \c ss
+    /*!
+      The compact format stores atoms and bonds in fixed-size records
+      and is considerably faster to read than the default format.
+      Molecules containing query atoms or bonds, or atoms with monomer
+      information, cannot be stored in the compact format; for those
+      the default format is written.
+    */
+    static void pickleMolCompact(const ROMol *mol,std::ostream &ss);
+    static void pickleMolCompact(const ROMol &mol,std::ostream &ss) {MolPickler::pickleMolCompact(&mol,ss);};
+    //! pickles a molecule using the compact format and adds the results to string \c res
+    static void pickleMolCompact(const ROMol *mol,std::string &res);
+    static void pickleMolCompact(const ROMol &mol,std::string &res) {MolPickler::pickleMolCompact(&mol,res);};
+
     //! constructs a molecule from a pickle stored in a string
-    static void molFromPickle(const std::string &pickle,ROMol *mol);
-    static void molFromPickle(const std::string &pickle,ROMol &mol) {MolPickler::molFromPickle(pickle,&mol);};
+    /*!
+      \param pickle    : the pickle
+      \param mol       : the molecule to be filled
+      \param readFlags : a combination of ReadFlags. Compact pickles skip
+                         the corresponding sections while reading; for
+                         other pickles the data is discarded after reading.
+    */
+    static void molFromPickle(const std::string &pickle,ROMol *mol,unsigned int readFlags=READ_ALL);
+    static void molFromPickle(const std::string &pickle,ROMol &mol,unsigned int readFlags=READ_ALL) {MolPickler::molFromPickle(pickle,&mol,readFlags);};
+
+    //! constructs a molecule from a pickle stored in a buffer of \c len bytes
+    static void molFromPickle(const char *pickle,size_t len,ROMol *mol,unsigned int readFlags=READ_ALL);
+    static void molFromPickle(const char *pickle,size_t len,ROMol &mol,unsigned int readFlags=READ_ALL) {MolPickler::molFromPickle(pickle,len,&mol,readFlags);};
 
     //! constructs a molecule from a pickle stored in a stream
-    static void molFromPickle(std::istream &ss,ROMol *mol);
-    static void molFromPickle(std::istream &ss,ROMol &mol) { MolPickler::molFromPickle(ss,&mol); };
+    static void molFromPickle(std::istream &ss,ROMol *mol,unsigned int readFlags=READ_ALL);
+    static void molFromPickle(std::istream &ss,ROMol &mol,unsigned int readFlags=READ_ALL) { MolPickler::molFromPickle(ss,&mol,readFlags); };
   private:
+    //! returns whether or not a molecule can be stored in the compact format
+    static bool _canPickleCompact(const ROMol *mol);
+
+    //! do the actual work of pickling a molecule in the compact format
+    static void _pickleCompact(const ROMol *mol,std::string &res);
+
+    //! do the actual work of de-pickling a compact pickle body
+    static void _depickleCompact(const char *data,size_t len,ROMol *mol,unsigned int readFlags);
+
+    //! discards the parts of a molecule excluded by \c readFlags
+    static void _applyReadFlags(ROMol *mol,unsigned int readFlags);
+
     //! do the actual work of pickling a molecule
     template <typename T>
     static void _pickle(const ROMol *mol,std::ostream &ss);
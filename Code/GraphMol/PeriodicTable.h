@@ -50,6 +50,10 @@ namespace RDKit {
       byname.clear();
     };
 
+    //! returns the largest atomic number in the table
+    UINT getMaxAtomicNumber() const {
+      return byanum.size()-1;
+    }
     
     //! returns the atomic weight
     double getAtomicWeight( UINT atomicNumber ) const {
@@ -35,6 +35,7 @@ namespace RDKit{
     d_atomBookmarks.clear();
     d_bondBookmarks.clear();
     d_graph.clear();
+    clearConformers();
     if (dp_props) {
       delete dp_props;
       dp_props=0;
@@ -534,12 +535,9 @@ namespace RDKit{
     if (id < 0) {
       return *(d_confs.front());
     }
-    unsigned int cid = (unsigned int)id;
-    for (ConstConformerIterator ci = this->beginConformers();
-	 ci != this->endConformers(); ++ci) {
-      if ((*ci)->getId() == cid) {
-        return *(*ci);
-      }
+    std::map<unsigned int,Conformer *>::const_iterator loc=d_confIndex.find((unsigned int)id);
+    if (loc != d_confIndex.end()) {
+      return *(loc->second);
     }
     // we did not find a coformation with the specified ID
     std::string mesg = "Can't find conformation with ID: ";
@@ -556,12 +554,9 @@ namespace RDKit{
     if (id < 0) {
       return *(d_confs.front());
     }
-    unsigned int cid = (unsigned int)id;
-    for (ConformerIterator ci = this->beginConformers();
-	 ci != this->endConformers(); ++ci) {
-      if ((*ci)->getId() == cid) {
-        return *(*ci);
-      }
+    std::map<unsigned int,Conformer *>::const_iterator loc=d_confIndex.find((unsigned int)id);
+    if (loc != d_confIndex.end()) {
+      return *(loc->second);
     }
     // we did not find a coformation with the specified ID
     std::string mesg = "Can't find conformation with ID: ";
@@ -570,27 +565,54 @@ namespace RDKit{
   }
 
   void ROMol::removeConformer(unsigned int id) {
+    std::map<unsigned int,Conformer *>::iterator loc=d_confIndex.find(id);
+    if (loc == d_confIndex.end()) return;
     for (CONF_SPTR_LIST_I ci = d_confs.begin(); ci != d_confs.end(); ++ci) {
-      if ((*ci)->getId() == id) {
+      if (ci->get() == loc->second) {
+        // someone else may still hold on to the conformer:
+        (*ci)->dp_mol = 0;
         d_confs.erase(ci);
-        return;
+        break;
       }
     }
+    d_confIndex.erase(loc);
+    // there may be another conformer with the same id:
+    if (d_confIndex.size() != d_confs.size()) {
+      rebuildConformerIndex();
+    }
+  }
+
+  void ROMol::clearConformers() {
+    // someone else may still hold on to the conformers:
+    for (CONF_SPTR_LIST_I ci = d_confs.begin(); ci != d_confs.end(); ++ci) {
+      (*ci)->dp_mol = 0;
+    }
+    d_confs.clear();
+    d_confIndex.clear();
   }
 
   unsigned int ROMol::addConformer(Conformer * conf, bool assignId) {
     PRECONDITION(conf->getNumAtoms() == this->getNumAtoms(), "Number of atom mismatch");
     if (assignId) {
-      int maxId = -1;
-      BOOST_FOREACH(CONFORMER_SPTR cptr,d_confs){
-	maxId=std::max((int)(cptr->getId()),maxId);
+      unsigned int maxId = 0;
+      if (!d_confIndex.empty()) {
+        maxId = d_confIndex.rbegin()->first+1;
       }
-      maxId++;
-      conf->setId((unsigned int)maxId);
+      conf->setId(maxId);
     }
     conf->setOwningMol(this);
     CONFORMER_SPTR nConf(conf);
     d_confs.push_back(nConf);
+    // if the id is already in use, the earlier conformer keeps it:
+    d_confIndex.insert(std::make_pair(conf->getId(),conf));
     return conf->getId();
   }
+
+  void ROMol::rebuildConformerIndex() {
+    d_confIndex.clear();
+    for (ConstConformerIterator ci = this->beginConformers();
+	 ci != this->endConformers(); ++ci) {
+      d_confIndex.insert(std::make_pair((*ci)->getId(),ci->get()));
+    }
+  }
 } // end o' namespace
@@ -106,6 +106,7 @@ namespace RDKit{
   public:
     friend class MolPickler;
     friend class RWMol;
+    friend class Conformer;
     
     //! \cond TYPEDEFS
 
@@ -285,7 +286,7 @@ namespace RDKit{
     void removeConformer(unsigned int id);
     
     //! Clear all the conformations on the molecule
-    void clearConformers() {d_confs.clear();}
+    void clearConformers();
 
     //! Add a new conformation to the molecule
     /*!
@@ -649,6 +650,9 @@ namespace RDKit{
     Dict *dp_props;
     RingInfo *dp_ringInfo;
     CONF_SPTR_LIST d_confs;
+    // conformer id -> conformer, used for lookups. If more than one
+    // conformer has the same id, this points to the first one in d_confs.
+    std::map<unsigned int,Conformer *> d_confIndex;
     ROMol &operator=(const ROMol &); // disable assignment, RWMol's support assignment 
 
 #ifdef WIN32
@@ -656,6 +660,8 @@ namespace RDKit{
 #endif
     void initMol();
     virtual void destroy();
+    //! rebuilds the conformer id lookup table from the conformer list
+    void rebuildConformerIndex();
     //! adds an Atom to our collection
     /*!
       \param atom          pointer to the Atom to add
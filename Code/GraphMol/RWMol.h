@@ -209,7 +209,7 @@ namespace RDKit{
       d_atomBookmarks.clear();
       d_bondBookmarks.clear();
       d_graph.clear();
-      d_confs.clear();
+      clearConformers();
       if(dp_props){
         dp_props->reset();
         STR_VECT computed;
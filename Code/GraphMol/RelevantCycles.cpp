@@ -0,0 +1,448 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+// References:
+//  - J.D. Horton, "A Polynomial-Time Algorithm to Find the Shortest Cycle
+//    Basis of a Graph", SIAM J. Comput. 16:358-366 (1987)
+//  - P. Vismara, "Union of all the minimum cycle bases of a graph",
+//    Electr. J. Comb. 4:73-87 (1997)
+//
+#include "RelevantCycles.h"
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/MolOps.h>
+#include <RDGeneral/Invariant.h>
+#include <boost/dynamic_bitset.hpp>
+#include <algorithm>
+#include <deque>
+
+namespace RDKit {
+  namespace RelevantCycles {
+    namespace {
+      typedef std::vector< std::pair<unsigned int,unsigned int> > NBR_VECT;
+
+      // the 2-core of a fragment, with local atom and bond indices.
+      // Local atom indices follow the molecule's atom indices.
+      struct CoreGraph {
+        std::vector<unsigned int> atoms;  // local index -> molecule index
+        std::vector<NBR_VECT> nbrs;       // (local atom, local bond) pairs
+        unsigned int nBonds;
+      };
+
+      void buildCore(const ROMol &mol,const INT_VECT &fragAtoms,CoreGraph &core){
+        unsigned int nAtoms=mol.getNumAtoms();
+        INT_VECT degree(nAtoms,0);
+        boost::dynamic_bitset<> inCore(nAtoms);
+        std::vector<unsigned int> toRemove;
+        for(INT_VECT_CI ai=fragAtoms.begin();ai!=fragAtoms.end();++ai){
+          inCore.set(*ai);
+          degree[*ai]=mol.getAtomWithIdx(*ai)->getDegree();
+          if(degree[*ai]<2) toRemove.push_back(*ai);
+        }
+        // repeatedly strip atoms with fewer than two neighbors:
+        while(!toRemove.empty()){
+          unsigned int aidx=toRemove.back();
+          toRemove.pop_back();
+          if(!inCore[aidx]) continue;
+          inCore.reset(aidx);
+          ROMol::ADJ_ITER nbrIdx,endNbrs;
+          boost::tie(nbrIdx,endNbrs) = mol.getAtomNeighbors(mol.getAtomWithIdx(aidx));
+          while(nbrIdx!=endNbrs){
+            if(inCore[*nbrIdx] && --degree[*nbrIdx]<2) toRemove.push_back(*nbrIdx);
+            ++nbrIdx;
+          }
+        }
+
+        INT_VECT localIdx(nAtoms,-1);
+        for(unsigned int i=inCore.find_first();i<nAtoms;i=inCore.find_next(i)){
+          localIdx[i]=core.atoms.size();
+          core.atoms.push_back(i);
+        }
+        core.nbrs.resize(core.atoms.size());
+        core.nBonds=0;
+        for(unsigned int i=0;i<core.atoms.size();++i){
+          ROMol::ADJ_ITER nbrIdx,endNbrs;
+          boost::tie(nbrIdx,endNbrs) = mol.getAtomNeighbors(mol.getAtomWithIdx(core.atoms[i]));
+          while(nbrIdx!=endNbrs){
+            int j=localIdx[*nbrIdx];
+            if(j>static_cast<int>(i)){
+              core.nbrs[i].push_back(std::make_pair(j,core.nBonds));
+              core.nbrs[j].push_back(std::make_pair(i,core.nBonds));
+              ++core.nBonds;
+            }
+            ++nbrIdx;
+          }
+        }
+      }
+
+      // shortest paths from a root atom. Only atoms in V_r (those with a
+      // lower index than the root that can be reached by a shortest path
+      // through such atoms) have a predecessor.
+      struct RootPaths {
+        unsigned int root;
+        INT_VECT dist;
+        INT_VECT pred;
+        boost::dynamic_bitset<> inV;
+        std::vector<unsigned int> order;  // the atoms of V_r in BFS order
+      };
+
+      void findRootPaths(const CoreGraph &core,unsigned int root,RootPaths &paths){
+        unsigned int nAtoms=core.atoms.size();
+        paths.root=root;
+        paths.dist.assign(nAtoms,-1);
+        paths.pred.assign(nAtoms,-1);
+        paths.inV.resize(nAtoms);
+        paths.inV.reset();
+        paths.order.clear();
+
+        std::deque<unsigned int> queue;
+        paths.dist[root]=0;
+        queue.push_back(root);
+        while(!queue.empty()){
+          unsigned int u=queue.front();
+          queue.pop_front();
+          for(NBR_VECT::const_iterator nbr=core.nbrs[u].begin();nbr!=core.nbrs[u].end();++nbr){
+            if(paths.dist[nbr->first]<0){
+              paths.dist[nbr->first]=paths.dist[u]+1;
+              queue.push_back(nbr->first);
+            }
+          }
+        }
+
+        // now the BFS restricted to atoms with smaller indices than the root:
+        INT_VECT restrictedDist(nAtoms,-1);
+        restrictedDist[root]=0;
+        paths.inV.set(root);
+        queue.push_back(root);
+        while(!queue.empty()){
+          unsigned int u=queue.front();
+          queue.pop_front();
+          for(NBR_VECT::const_iterator nbr=core.nbrs[u].begin();nbr!=core.nbrs[u].end();++nbr){
+            unsigned int v=nbr->first;
+            if(v<root && restrictedDist[v]<0){
+              restrictedDist[v]=restrictedDist[u]+1;
+              queue.push_back(v);
+              if(restrictedDist[v]==paths.dist[v]){
+                paths.inV.set(v);
+                paths.pred[v]=u;
+                paths.order.push_back(v);
+              }
+            }
+          }
+        }
+      }
+
+      // returns whether or not the paths from the root to a and b only
+      // have the root in common
+      bool pathsDisjoint(const RootPaths &paths,int a,int b,
+                         std::vector<unsigned int> &marks,unsigned int &stamp){
+        ++stamp;
+        while(a!=static_cast<int>(paths.root)){
+          marks[a]=stamp;
+          a=paths.pred[a];
+        }
+        while(b!=static_cast<int>(paths.root)){
+          if(marks[b]==stamp) return false;
+          b=paths.pred[b];
+        }
+        return true;
+      }
+
+      unsigned int bondBetween(const CoreGraph &core,unsigned int a,unsigned int b){
+        for(NBR_VECT::const_iterator nbr=core.nbrs[a].begin();nbr!=core.nbrs[a].end();++nbr){
+          if(nbr->first==b) return nbr->second;
+        }
+        CHECK_INVARIANT(0,"atoms not bonded");
+        return 0;
+      }
+
+      // a candidate cycle: root..a [mid] b..root, where the paths to a and
+      // b are shortest paths from the root. mid is -1 for odd cycles.
+      struct Prototype {
+        unsigned int root;
+        unsigned int a,b;
+        int mid;
+        unsigned int size;
+        std::vector<unsigned int> atoms;
+        boost::dynamic_bitset<> bonds;
+      };
+
+      void makeCycle(const CoreGraph &core,const std::vector<unsigned int> &pathA,
+                     int mid,const std::vector<unsigned int> &pathB,
+                     std::vector<unsigned int> &atoms,boost::dynamic_bitset<> *bonds){
+        // the paths run from the end atom back to the root:
+        atoms.clear();
+        atoms.insert(atoms.end(),pathA.rbegin(),pathA.rend());
+        if(mid>=0) atoms.push_back(mid);
+        atoms.insert(atoms.end(),pathB.begin(),pathB.end()-1);
+        if(bonds){
+          bonds->resize(core.nBonds);
+          bonds->reset();
+          for(unsigned int i=0;i<atoms.size();++i){
+            bonds->set(bondBetween(core,atoms[i],atoms[(i+1)%atoms.size()]));
+          }
+        }
+      }
+
+      void getPath(const RootPaths &paths,unsigned int a,std::vector<unsigned int> &path){
+        path.clear();
+        path.push_back(a);
+        while(a!=paths.root){
+          a=paths.pred[a];
+          path.push_back(a);
+        }
+      }
+
+      void addPrototypes(const CoreGraph &core,const RootPaths &paths,
+                         std::vector<Prototype> &res,
+                         std::vector<unsigned int> &marks,unsigned int &stamp){
+        std::vector<unsigned int> pathA,pathB,preds;
+        for(std::vector<unsigned int>::const_iterator yi=paths.order.begin();
+            yi!=paths.order.end();++yi){
+          unsigned int y=*yi;
+          int dy=paths.dist[y];
+          preds.clear();
+          for(NBR_VECT::const_iterator nbr=core.nbrs[y].begin();nbr!=core.nbrs[y].end();++nbr){
+            unsigned int z=nbr->first;
+            if(!paths.inV[z]) continue;
+            if(paths.dist[z]+1==dy){
+              preds.push_back(z);
+            } else if(paths.dist[z]==dy && z<y && pathsDisjoint(paths,y,z,marks,stamp)){
+              Prototype proto;
+              proto.root=paths.root;
+              proto.a=y;
+              proto.b=z;
+              proto.mid=-1;
+              proto.size=2*dy+1;
+              getPath(paths,y,pathA);
+              getPath(paths,z,pathB);
+              makeCycle(core,pathA,-1,pathB,proto.atoms,&proto.bonds);
+              res.push_back(proto);
+            }
+          }
+          for(unsigned int i=0;i<preds.size();++i){
+            for(unsigned int j=i+1;j<preds.size();++j){
+              if(pathsDisjoint(paths,preds[i],preds[j],marks,stamp)){
+                Prototype proto;
+                proto.root=paths.root;
+                proto.a=preds[i];
+                proto.b=preds[j];
+                proto.mid=y;
+                proto.size=2*dy;
+                getPath(paths,preds[i],pathA);
+                getPath(paths,preds[j],pathB);
+                makeCycle(core,pathA,y,pathB,proto.atoms,&proto.bonds);
+                res.push_back(proto);
+              }
+            }
+          }
+        }
+      }
+
+      // all shortest paths from the root to an atom, using only atoms in V_r
+      void getAllPaths(const CoreGraph &core,const RootPaths &paths,unsigned int a,
+                       std::vector< std::vector<unsigned int> > &res,
+                       unsigned int maxPaths){
+        res.clear();
+        std::vector<unsigned int> path(1,a);
+        // depth first, each entry of the stack holds the position in the
+        // neighbor list of the corresponding atom of the path:
+        std::vector<unsigned int> stack(1,0);
+        while(!stack.empty()){
+          unsigned int curr=path.back();
+          if(curr==paths.root){
+            res.push_back(path);
+            if(maxPaths && res.size()>maxPaths){
+              throw ValueErrorException("relevant cycle limit exceeded");
+            }
+            path.pop_back();
+            stack.pop_back();
+            continue;
+          }
+          unsigned int &pos=stack.back();
+          bool extended=false;
+          while(pos<core.nbrs[curr].size()){
+            unsigned int nbr=core.nbrs[curr][pos++].first;
+            if(paths.inV[nbr] && paths.dist[nbr]+1==paths.dist[curr]){
+              path.push_back(nbr);
+              stack.push_back(0);
+              extended=true;
+              break;
+            }
+          }
+          if(!extended){
+            path.pop_back();
+            stack.pop_back();
+          }
+        }
+      }
+
+      bool pathsDisjoint(const std::vector<unsigned int> &pathA,
+                         const std::vector<unsigned int> &pathB,
+                         std::vector<unsigned int> &marks,unsigned int &stamp){
+        // the last element of each path is the root
+        ++stamp;
+        for(unsigned int i=0;i<pathA.size()-1;++i) marks[pathA[i]]=stamp;
+        for(unsigned int i=0;i<pathB.size()-1;++i){
+          if(marks[pathB[i]]==stamp) return false;
+        }
+        return true;
+      }
+
+      // the members of the family of a prototype
+      void expandFamily(const CoreGraph &core,const RootPaths &paths,
+                        const Prototype &proto,VECT_INT_VECT &res,
+                        unsigned int maxCycles,
+                        std::vector<unsigned int> &marks,unsigned int &stamp){
+        std::vector< std::vector<unsigned int> > pathsA,pathsB;
+        getAllPaths(core,paths,proto.a,pathsA,maxCycles);
+        getAllPaths(core,paths,proto.b,pathsB,maxCycles);
+        std::vector<unsigned int> atoms;
+        for(unsigned int i=0;i<pathsA.size();++i){
+          for(unsigned int j=0;j<pathsB.size();++j){
+            if(!pathsDisjoint(pathsA[i],pathsB[j],marks,stamp)) continue;
+            makeCycle(core,pathsA[i],proto.mid,pathsB[j],atoms,0);
+            INT_VECT ring(atoms.size());
+            for(unsigned int k=0;k<atoms.size();++k) ring[k]=core.atoms[atoms[k]];
+            res.push_back(ring);
+            if(maxCycles && res.size()>maxCycles){
+              throw ValueErrorException("relevant cycle limit exceeded");
+            }
+          }
+        }
+      }
+
+      struct compPrototypeSize {
+        const std::vector<Prototype> &protos;
+        compPrototypeSize(const std::vector<Prototype> &p) : protos(p) {};
+        bool operator()(unsigned int i,unsigned int j) const {
+          return protos[i].size<protos[j].size;
+        }
+      };
+
+      struct compRingSize {
+        bool operator()(const INT_VECT &v1,const INT_VECT &v2) const {
+          return v1.size()<v2.size();
+        }
+      };
+
+      // reduces v by the basis vectors with index < limit. Returns whether
+      // or not anything is left.
+      bool reduce(boost::dynamic_bitset<> &v,
+                  const std::vector< boost::dynamic_bitset<> > &basis,
+                  const INT_VECT &pivotOwner,unsigned int limit){
+        for(boost::dynamic_bitset<>::size_type p=v.find_first();
+            p!=boost::dynamic_bitset<>::npos;p=v.find_next(p)){
+          int owner=pivotOwner[p];
+          // the pivot is the lowest bit of a basis vector, so this does
+          // not change any bits before p:
+          if(owner>=0 && static_cast<unsigned int>(owner)<limit) v^=basis[owner];
+        }
+        return v.any();
+      }
+    } // end of anonymous namespace
+
+    unsigned int findCycles(const ROMol &mol,const INT_VECT &fragAtoms,
+                            VECT_INT_VECT &basis,VECT_INT_VECT *relevant,
+                            unsigned int maxCycles,MolOps::PerceptionCost *cost,
+                            bool onlyPrototypes){
+      basis.clear();
+      if(relevant) relevant->clear();
+
+      CoreGraph core;
+      buildCore(mol,fragAtoms,core);
+      unsigned int nAtoms=core.atoms.size();
+      if(!nAtoms) return 0;
+      unsigned int nexpt=core.nBonds-nAtoms+1;
+
+      // generate the candidates:
+      std::vector<Prototype> protos;
+      std::vector<unsigned int> marks(nAtoms,0);
+      unsigned int stamp=0;
+      RootPaths paths;
+      for(unsigned int root=0;root<nAtoms;++root){
+        findRootPaths(core,root,paths);
+        addPrototypes(core,paths,protos,marks,stamp);
+      }
+      if(cost){
+        cost->numRingSystems+=1;
+        cost->numCandidates+=protos.size();
+      }
+      std::vector<unsigned int> order(protos.size());
+      for(unsigned int i=0;i<order.size();++i) order[i]=i;
+      std::stable_sort(order.begin(),order.end(),compPrototypeSize(protos));
+
+      // pick the basis, going through the candidates size by size. A
+      // candidate is relevant if it is independent of all the candidates
+      // smaller than it:
+      std::vector< boost::dynamic_bitset<> > basisVects;
+      INT_VECT pivotOwner(core.nBonds,-1);
+      std::vector<unsigned int> relevantProtos;
+      unsigned int pos=0;
+      while(pos<order.size() && basisVects.size()<nexpt){
+        unsigned int size=protos[order[pos]].size;
+        unsigned int limit=basisVects.size();
+        for(;pos<order.size() && protos[order[pos]].size==size;++pos){
+          const Prototype &proto=protos[order[pos]];
+          if(relevant){
+            boost::dynamic_bitset<> v=proto.bonds;
+            if(reduce(v,basisVects,pivotOwner,limit)){
+              relevantProtos.push_back(order[pos]);
+            } else {
+              // dependent on smaller cycles, so it can't be in the basis either
+              continue;
+            }
+          }
+          if(basisVects.size()==nexpt) continue;
+          boost::dynamic_bitset<> v=proto.bonds;
+          if(reduce(v,basisVects,pivotOwner,basisVects.size())){
+            pivotOwner[v.find_first()]=basisVects.size();
+            basisVects.push_back(v);
+            INT_VECT ring(proto.atoms.size());
+            for(unsigned int k=0;k<proto.atoms.size();++k) ring[k]=core.atoms[proto.atoms[k]];
+            basis.push_back(ring);
+          }
+          // without the relevant cycles we can stop as soon as the basis is complete:
+          if(!relevant && basisVects.size()==nexpt) break;
+        }
+      }
+      if(basis.size()!=nexpt){
+        throw ValueErrorException("could not find number of expected rings.");
+      }
+
+      if(relevant && onlyPrototypes){
+        for(std::vector<unsigned int>::const_iterator pi=relevantProtos.begin();
+            pi!=relevantProtos.end();++pi){
+          const Prototype &proto=protos[*pi];
+          INT_VECT ring(proto.atoms.size());
+          for(unsigned int k=0;k<proto.atoms.size();++k) ring[k]=core.atoms[proto.atoms[k]];
+          relevant->push_back(ring);
+        }
+        if(cost) cost->numResults+=relevant->size();
+      } else if(relevant){
+        // expand the families of the relevant prototypes, root by root:
+        std::vector<unsigned int> byRoot=relevantProtos;
+        std::sort(byRoot.begin(),byRoot.end());
+        int lastRoot=-1;
+        for(std::vector<unsigned int>::const_iterator pi=byRoot.begin();pi!=byRoot.end();++pi){
+          const Prototype &proto=protos[*pi];
+          if(static_cast<int>(proto.root)!=lastRoot){
+            findRootPaths(core,proto.root,paths);
+            lastRoot=proto.root;
+          }
+          expandFamily(core,paths,proto,*relevant,maxCycles,marks,stamp);
+        }
+        std::stable_sort(relevant->begin(),relevant->end(),compRingSize());
+        if(cost) cost->numResults+=relevant->size();
+      } else if(cost){
+        cost->numResults+=basis.size();
+      }
+      return basis.size();
+    }
+  } // end of namespace RelevantCycles
+} // end of namespace RDKit
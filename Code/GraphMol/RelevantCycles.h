@@ -0,0 +1,65 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_RELEVANTCYCLES_H
+#define _RD_RELEVANTCYCLES_H
+
+#include <RDGeneral/types.h>
+
+namespace RDKit {
+  class ROMol;
+  namespace MolOps {
+    struct PerceptionCost;
+  }
+
+  namespace RelevantCycles {
+    //! finds a minimum cycle basis and, optionally, the relevant cycles of
+    //! a connected fragment of a molecule
+    /*!
+      Candidate cycles are generated with Vismara's variant of Horton's
+      algorithm: for each atom \c r, cycles are formed from pairs of
+      disjoint shortest paths from \c r that only pass through atoms with
+      smaller indices than \c r. These candidates (the "prototypes" of the
+      relevant cycle families) are sorted by size and a minimum cycle basis
+      is picked from them by Gaussian elimination over GF(2) on their bond
+      sets. A prototype is relevant if it is independent of all shorter
+      candidates; the relevant cycles are the members of the families of
+      the relevant prototypes.
+
+      Only the atoms and bonds of the fragment that are in its 2-core
+      (i.e. remain after repeatedly removing atoms with fewer than two
+      neighbors) are considered.
+
+      \param mol       the molecule
+      \param fragAtoms the atoms of the fragment (see MolOps::getMolFrags())
+      \param basis     used to return the rings of the minimum cycle basis,
+                       sorted by size. Each ring is a list of atom indices in
+                       ring order.
+      \param relevant  if provided, used to return all the relevant cycles
+                       (this includes the rings in \c basis).
+      \param maxCycles if \c relevant is provided and the fragment has more
+                       than this many relevant cycles, a ValueErrorException
+                       is thrown. Zero means no limit.
+      \param cost      if provided, the work done is added to this.
+      \param onlyPrototypes if set, only one cycle (the prototype) of each
+                       family of relevant cycles is returned in \c relevant.
+                       The number of these is polynomial in the size of the
+                       fragment, so \c maxCycles is not used.
+
+      \return the number of rings in \c basis
+    */
+    unsigned int findCycles(const ROMol &mol,const INT_VECT &fragAtoms,
+                            VECT_INT_VECT &basis,VECT_INT_VECT *relevant=0,
+                            unsigned int maxCycles=0,
+                            MolOps::PerceptionCost *cost=0,
+                            bool onlyPrototypes=false);
+  }
+}
+
+#endif
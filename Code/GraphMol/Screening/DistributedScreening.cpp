@@ -0,0 +1,101 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "DistributedScreening.h"
+#include <boost/mpi/collectives.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/lexical_cast.hpp>
+#include <algorithm>
+
+namespace RDKit {
+  namespace Screening {
+    namespace {
+      // the reduction operators, both combine sorted lists of hits.
+      // The lists are reduced as single (serialized) values, which is
+      // why the reduce() calls below use the pointer forms.
+      struct mergeTopK {
+        unsigned int k;
+        explicit mergeTopK(unsigned int k) : k(k) {};
+        std::vector<SimilarityHit> operator()(const std::vector<SimilarityHit> &h1,
+                                              const std::vector<SimilarityHit> &h2) const {
+          std::vector<SimilarityHit> res;
+          mergeSimilarityHits(h1,h2,k,res);
+          return res;
+        }
+      };
+      struct mergeIds {
+        unsigned int maxHits;
+        explicit mergeIds(unsigned int maxHits) : maxHits(maxHits) {};
+        std::vector<boost::uint64_t> operator()(const std::vector<boost::uint64_t> &h1,
+                                                const std::vector<boost::uint64_t> &h2) const {
+          std::vector<boost::uint64_t> res;
+          res.reserve(h1.size()+h2.size());
+          std::merge(h1.begin(),h1.end(),h2.begin(),h2.end(),std::back_inserter(res));
+          if(maxHits && res.size()>maxHits) res.resize(maxHits);
+          return res;
+        }
+      };
+    }
+
+    std::string shardName(const std::string &prefix,unsigned int idx){
+      return prefix+"."+boost::lexical_cast<std::string>(idx)+".rdsdb";
+    }
+
+    void openLocalShards(const boost::mpi::communicator &comm,
+                         const std::vector<std::string> &shardNames,
+                         std::vector<ScreeningDB_SPTR> &res){
+      res.clear();
+      for(unsigned int i=comm.rank();i<shardNames.size();i+=comm.size()){
+        res.push_back(ScreeningDB_SPTR(new ScreeningDB(shardNames[i])));
+      }
+    }
+
+    void distributedSimilaritySearch(const boost::mpi::communicator &comm,
+                                     const std::vector<ScreeningDB_SPTR> &shards,
+                                     const ExplicitBitVect &query,
+                                     unsigned int k,double threshold,
+                                     std::vector<SimilarityHit> &res,
+                                     int root){
+      std::vector<SimilarityHit> local,shardHits;
+      for(std::vector<ScreeningDB_SPTR>::const_iterator shard=shards.begin();
+          shard!=shards.end();++shard){
+        (*shard)->similaritySearch(query,k,threshold,shardHits);
+        mergeSimilarityHits(local,shardHits,k,local);
+      }
+      res.clear();
+      if(comm.rank()==root){
+        boost::mpi::reduce(comm,&local,1,&res,mergeTopK(k),root);
+      } else {
+        boost::mpi::reduce(comm,&local,1,mergeTopK(k),root);
+      }
+    }
+
+    void distributedSubstructureSearch(const boost::mpi::communicator &comm,
+                                       const std::vector<ScreeningDB_SPTR> &shards,
+                                       const ROMol &query,unsigned int maxHits,
+                                       std::vector<boost::uint64_t> &res,
+                                       int root){
+      std::vector<boost::uint64_t> local,shardHits;
+      for(std::vector<ScreeningDB_SPTR>::const_iterator shard=shards.begin();
+          shard!=shards.end();++shard){
+        (*shard)->substructureSearch(query,shardHits,maxHits);
+        local.insert(local.end(),shardHits.begin(),shardHits.end());
+      }
+      std::sort(local.begin(),local.end());
+      if(maxHits && local.size()>maxHits) local.resize(maxHits);
+      res.clear();
+      if(comm.rank()==root){
+        boost::mpi::reduce(comm,&local,1,&res,mergeIds(maxHits),root);
+      } else {
+        boost::mpi::reduce(comm,&local,1,mergeIds(maxHits),root);
+      }
+    }
+  }
+}
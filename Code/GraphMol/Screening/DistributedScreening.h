@@ -0,0 +1,88 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_DISTRIBUTEDSCREENING_H_
+#define _RD_DISTRIBUTEDSCREENING_H_
+
+#include "ScreeningDB.h"
+#include <boost/mpi/communicator.hpp>
+
+namespace RDKit {
+  namespace Screening {
+    /*! \file DistributedScreening.h
+
+      \brief searching sharded screening databases with MPI
+
+      The shards of a database are divided between the ranks of a
+      communicator, each rank searches its shards and the partial
+      results are combined on the root rank with a reduction.
+
+      The functions here are collective: every rank in the communicator
+      must call them, with the same query and arguments.
+    */
+
+    //! returns the name of shard \c idx of the database \c prefix
+    std::string shardName(const std::string &prefix,unsigned int idx);
+
+    //! opens the shards that belong to this rank
+    /*!
+      \param comm        the communicator
+      \param shardNames  the names of all the shards, shard \c i is
+                         opened by rank <tt>i % comm.size()</tt>
+      \param res         used to return the shards
+
+      Ranks may end up with no shards at all.
+    */
+    void openLocalShards(const boost::mpi::communicator &comm,
+                         const std::vector<std::string> &shardNames,
+                         std::vector<ScreeningDB_SPTR> &res);
+
+    //! finds the molecules most similar to a query across all shards
+    /*!
+      \param comm       the communicator
+      \param shards     this rank's shards, from openLocalShards()
+      \param query      the query fingerprint, from similarityFingerprint()
+      \param k          the number of hits to return (0 for all)
+      \param threshold  the minimum Tanimoto similarity of the hits
+      \param res        used to return the hits on the root rank, sorted by
+                        decreasing similarity (ties are sorted by increasing id).
+                        On the other ranks this is left empty.
+      \param root       the rank that collects the results
+    */
+    void distributedSimilaritySearch(const boost::mpi::communicator &comm,
+                                     const std::vector<ScreeningDB_SPTR> &shards,
+                                     const ExplicitBitVect &query,
+                                     unsigned int k,double threshold,
+                                     std::vector<SimilarityHit> &res,
+                                     int root=0);
+
+    //! finds the molecules that contain a query across all shards
+    /*!
+      \param comm     the communicator
+      \param shards   this rank's shards, from openLocalShards()
+      \param query    the query molecule
+      \param maxHits  the maximum number of hits to return (0 for all)
+      \param res      used to return the ids of the matching molecules on the
+                      root rank, in increasing order. On the other ranks
+                      this is left empty.
+      \param root     the rank that collects the results
+
+      If \c maxHits is set each shard contributes at most \c maxHits hits
+      and the smallest \c maxHits of those are returned. For shards that
+      store their molecules in increasing id order (as rdkit_mpiscreen
+      writes them) these are the \c maxHits smallest matching ids.
+    */
+    void distributedSubstructureSearch(const boost::mpi::communicator &comm,
+                                       const std::vector<ScreeningDB_SPTR> &shards,
+                                       const ROMol &query,unsigned int maxHits,
+                                       std::vector<boost::uint64_t> &res,
+                                       int root=0);
+  }
+}
+#endif
@@ -0,0 +1,369 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "ScreeningDB.h"
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/MolPickler.h>
+#include <GraphMol/Substruct/SubstructMatch.h>
+#include <GraphMol/Fingerprints/Fingerprints.h>
+#include <GraphMol/Fingerprints/MorganFingerprints.h>
+#include <DataStructs/ExplicitBitVect.h>
+#include <RDGeneral/BadFileException.h>
+#include <RDGeneral/Invariant.h>
+#include <boost/interprocess/exceptions.hpp>
+
+#include <cstring>
+#include <cstdio>
+#include <queue>
+#include <algorithm>
+
+namespace RDKit {
+  namespace Screening {
+    namespace {
+      const char magic[8]={'R','D','K','S','C','R','D','B'};
+      const boost::uint32_t formatVersion=1;
+      // the sections of the file start at multiples of this:
+      const boost::uint64_t alignment=64;
+      const boost::uint64_t headerSize=2*alignment;
+
+      struct FileHeader {
+        char magic[8];
+        boost::uint32_t version;
+        boost::uint32_t fpWords;
+        boost::uint64_t numRecords;
+        // offsets of the sections, pickleIndex and pickleData are
+        // zero if there are no pickles:
+        boost::uint64_t pickleData;
+        boost::uint64_t pickleIndex;
+        boost::uint64_t ids;
+        boost::uint64_t simCounts;
+        boost::uint64_t simFPs;
+        boost::uint64_t patternFPs;
+      };
+
+      inline unsigned int popCount(boost::uint64_t v){
+#ifdef USE_BUILTIN_POPCOUNT
+        return __builtin_popcountll(v);
+#else
+        v = v - ((v >> 1) & 0x5555555555555555ULL);
+        v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+        v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<unsigned int>((v * 0x0101010101010101ULL) >> 56);
+#endif
+      }
+
+      void fpToWords(const ExplicitBitVect &fp,unsigned int fpWords,
+                     std::vector<boost::uint64_t> &words){
+        PRECONDITION(fp.getNumBits()==fpWords*64,"bad fingerprint size");
+        words.resize(fpWords);
+        std::fill(words.begin(),words.end(),0);
+        IntVect onBits;
+        fp.getOnBits(onBits);
+        for(IntVect::const_iterator bit=onBits.begin();bit!=onBits.end();++bit){
+          words[*bit/64] |= (static_cast<boost::uint64_t>(1) << (*bit%64));
+        }
+      }
+
+      void pad(std::ostream &ostrm,boost::uint64_t &pos){
+        while(pos%alignment){
+          ostrm.put('\0');
+          ++pos;
+        }
+      }
+
+      // orders hits by decreasing similarity, then increasing id
+      struct betterHit {
+        bool operator()(const SimilarityHit &a,const SimilarityHit &b) const {
+          if(a.first!=b.first) return a.first>b.first;
+          return a.second<b.second;
+        }
+      };
+    }
+
+    ExplicitBitVect *similarityFingerprint(const ROMol &mol,unsigned int fpSize){
+      return MorganFingerprints::getFingerprintAsBitVect(mol,2,fpSize);
+    }
+    ExplicitBitVect *screeningFingerprint(const ROMol &mol,unsigned int fpSize){
+      return PatternFingerprintMol(mol,fpSize);
+    }
+
+    void mergeSimilarityHits(const std::vector<SimilarityHit> &hits1,
+                             const std::vector<SimilarityHit> &hits2,
+                             unsigned int k,std::vector<SimilarityHit> &res){
+      std::vector<SimilarityHit> merged;
+      merged.reserve(hits1.size()+hits2.size());
+      std::merge(hits1.begin(),hits1.end(),hits2.begin(),hits2.end(),
+                 std::back_inserter(merged),betterHit());
+      if(k && merged.size()>k) merged.resize(k);
+      res.swap(merged);
+    }
+
+    // ------------------------------------------------------------
+    //
+    //   ScreeningDBWriter
+    //
+    // ------------------------------------------------------------
+    ScreeningDBWriter::ScreeningDBWriter(const std::string &fileName,
+                                         unsigned int fpSize,
+                                         bool storePickles) :
+      d_fileName(fileName),d_fpSize(fpSize),df_storePickles(storePickles),
+      df_closed(false) {
+      PRECONDITION(fpSize>0 && !(fpSize%64),"fpSize must be a multiple of 64");
+      d_outStream.open(fileName.c_str(),std::ios_base::out|std::ios_base::binary);
+      d_simStream.open((fileName+".sim.tmp").c_str(),
+                       std::ios_base::out|std::ios_base::binary);
+      d_patternStream.open((fileName+".pattern.tmp").c_str(),
+                           std::ios_base::out|std::ios_base::binary);
+      if(!d_outStream || !d_simStream || !d_patternStream){
+        throw BadFileException("could not open "+fileName+" for writing");
+      }
+      // the header is written when the file is closed:
+      std::string blank(headerSize,'\0');
+      d_outStream.write(blank.c_str(),blank.size());
+      d_pickleOffsets.push_back(0);
+    }
+
+    ScreeningDBWriter::~ScreeningDBWriter(){
+      if(!df_closed) close();
+    }
+
+    void ScreeningDBWriter::addMol(const ROMol &mol,boost::uint64_t id){
+      ExplicitBitVect *simFP=similarityFingerprint(mol,d_fpSize);
+      ExplicitBitVect *patternFP=screeningFingerprint(mol,d_fpSize);
+      std::string pickle;
+      if(df_storePickles) MolPickler::pickleMol(mol,pickle);
+      addRecord(id,*simFP,*patternFP,pickle);
+      delete simFP;
+      delete patternFP;
+    }
+
+    void ScreeningDBWriter::addRecord(boost::uint64_t id,const ExplicitBitVect &simFP,
+                                      const ExplicitBitVect &patternFP,
+                                      const std::string &pickle){
+      PRECONDITION(!df_closed,"writer is closed");
+      unsigned int fpWords=d_fpSize/64;
+      std::vector<boost::uint64_t> words;
+      fpToWords(simFP,fpWords,words);
+      d_simStream.write(reinterpret_cast<const char *>(&words[0]),
+                        fpWords*sizeof(boost::uint64_t));
+      boost::uint32_t count=0;
+      for(unsigned int i=0;i<fpWords;++i) count+=popCount(words[i]);
+      d_simCounts.push_back(count);
+      fpToWords(patternFP,fpWords,words);
+      d_patternStream.write(reinterpret_cast<const char *>(&words[0]),
+                            fpWords*sizeof(boost::uint64_t));
+      if(df_storePickles){
+        d_outStream.write(pickle.c_str(),pickle.size());
+        d_pickleOffsets.push_back(d_pickleOffsets.back()+pickle.size());
+      }
+      d_ids.push_back(id);
+    }
+
+    void ScreeningDBWriter::close(){
+      PRECONDITION(!df_closed,"writer is closed");
+      df_closed=true;
+      d_simStream.close();
+      d_patternStream.close();
+
+      FileHeader header;
+      memset(&header,0,sizeof(header));
+      memcpy(header.magic,magic,sizeof(magic));
+      header.version=formatVersion;
+      header.fpWords=d_fpSize/64;
+      header.numRecords=d_ids.size();
+
+      boost::uint64_t pos=headerSize;
+      if(df_storePickles){
+        header.pickleData=pos;
+        pos+=d_pickleOffsets.back();
+        pad(d_outStream,pos);
+        header.pickleIndex=pos;
+        d_outStream.write(reinterpret_cast<const char *>(&d_pickleOffsets[0]),
+                          d_pickleOffsets.size()*sizeof(boost::uint64_t));
+        pos+=d_pickleOffsets.size()*sizeof(boost::uint64_t);
+        pad(d_outStream,pos);
+      }
+      header.ids=pos;
+      if(!d_ids.empty()){
+        d_outStream.write(reinterpret_cast<const char *>(&d_ids[0]),
+                          d_ids.size()*sizeof(boost::uint64_t));
+        pos+=d_ids.size()*sizeof(boost::uint64_t);
+      }
+      pad(d_outStream,pos);
+      header.simCounts=pos;
+      if(!d_simCounts.empty()){
+        d_outStream.write(reinterpret_cast<const char *>(&d_simCounts[0]),
+                          d_simCounts.size()*sizeof(boost::uint32_t));
+        pos+=d_simCounts.size()*sizeof(boost::uint32_t);
+      }
+      pad(d_outStream,pos);
+
+      boost::uint64_t fpBytes=d_ids.size()*header.fpWords*sizeof(boost::uint64_t);
+      std::string tmpNames[2]={d_fileName+".sim.tmp",d_fileName+".pattern.tmp"};
+      boost::uint64_t *offsets[2]={&header.simFPs,&header.patternFPs};
+      for(unsigned int i=0;i<2;++i){
+        *offsets[i]=pos;
+        if(fpBytes){
+          std::ifstream tmpStream(tmpNames[i].c_str(),std::ios_base::in|std::ios_base::binary);
+          d_outStream<<tmpStream.rdbuf();
+        }
+        std::remove(tmpNames[i].c_str());
+        pos+=fpBytes;
+      }
+
+      d_outStream.seekp(0);
+      d_outStream.write(reinterpret_cast<const char *>(&header),sizeof(header));
+      d_outStream.close();
+      if(!d_outStream){
+        throw BadFileException("error writing "+d_fileName);
+      }
+    }
+
+    // ------------------------------------------------------------
+    //
+    //   ScreeningDB
+    //
+    // ------------------------------------------------------------
+    ScreeningDB::ScreeningDB(const std::string &fileName){
+      try {
+        boost::interprocess::file_mapping file(fileName.c_str(),boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(file,boost::interprocess::read_only);
+        d_file.swap(file);
+        d_region.swap(region);
+      } catch (boost::interprocess::interprocess_exception &e) {
+        throw BadFileException("could not map "+fileName+": "+e.what());
+      }
+      const char *data=static_cast<const char *>(d_region.get_address());
+      boost::uint64_t size=d_region.get_size();
+      FileHeader header;
+      if(size<headerSize){
+        throw BadFileException(fileName+" is not a screening database");
+      }
+      memcpy(&header,data,sizeof(header));
+      if(memcmp(header.magic,magic,sizeof(magic)) || header.version!=formatVersion){
+        throw BadFileException(fileName+" is not a screening database");
+      }
+      d_numRecords=header.numRecords;
+      d_fpWords=header.fpWords;
+      boost::uint64_t fpBytes=d_numRecords*d_fpWords*sizeof(boost::uint64_t);
+      if(header.patternFPs+fpBytes>size ||
+         header.simFPs+fpBytes>size ||
+         header.ids+d_numRecords*sizeof(boost::uint64_t)>size ||
+         header.simCounts+d_numRecords*sizeof(boost::uint32_t)>size){
+        throw BadFileException(fileName+" is truncated");
+      }
+      dp_ids=reinterpret_cast<const boost::uint64_t *>(data+header.ids);
+      dp_simCounts=reinterpret_cast<const boost::uint32_t *>(data+header.simCounts);
+      dp_simFPs=reinterpret_cast<const boost::uint64_t *>(data+header.simFPs);
+      dp_patternFPs=reinterpret_cast<const boost::uint64_t *>(data+header.patternFPs);
+      if(header.pickleIndex){
+        if(header.pickleIndex+(d_numRecords+1)*sizeof(boost::uint64_t)>size){
+          throw BadFileException(fileName+" is truncated");
+        }
+        dp_pickleData=data+header.pickleData;
+        dp_pickleIndex=reinterpret_cast<const boost::uint64_t *>(data+header.pickleIndex);
+        if(header.pickleData+dp_pickleIndex[d_numRecords]>header.pickleIndex){
+          throw BadFileException(fileName+" is truncated");
+        }
+      } else {
+        dp_pickleData=0;
+        dp_pickleIndex=0;
+      }
+    }
+
+    boost::uint64_t ScreeningDB::getId(boost::uint64_t idx) const {
+      PRECONDITION(idx<d_numRecords,"bad record index");
+      return dp_ids[idx];
+    }
+
+    ROMol *ScreeningDB::getMol(boost::uint64_t idx) const {
+      PRECONDITION(idx<d_numRecords,"bad record index");
+      PRECONDITION(dp_pickleIndex,"database has no pickles");
+      ROMol *res=new ROMol();
+      MolPickler::molFromPickle(dp_pickleData+dp_pickleIndex[idx],
+                                dp_pickleIndex[idx+1]-dp_pickleIndex[idx],res);
+      return res;
+    }
+
+    void ScreeningDB::similaritySearch(const ExplicitBitVect &query,unsigned int k,
+                                       double threshold,
+                                       std::vector<SimilarityHit> &res) const {
+      std::vector<boost::uint64_t> qwords;
+      fpToWords(query,d_fpWords,qwords);
+      unsigned int qcount=0;
+      for(unsigned int i=0;i<d_fpWords;++i) qcount+=popCount(qwords[i]);
+
+      // the best hits so far, the worst of them on top:
+      std::priority_queue<SimilarityHit,std::vector<SimilarityHit>,betterHit> best;
+      const boost::uint64_t *fp=dp_simFPs;
+      for(boost::uint64_t idx=0;idx<d_numRecords;++idx,fp+=d_fpWords){
+        // the similarity a molecule with this many bits can reach:
+        unsigned int count=dp_simCounts[idx];
+        double bound=(qcount||count) ?
+          static_cast<double>(std::min(qcount,count))/std::max(qcount,count) : 0.0;
+        if(bound<threshold) continue;
+        if(k && best.size()==k && bound<best.top().first) continue;
+
+        unsigned int common=0;
+        for(unsigned int i=0;i<d_fpWords;++i) common+=popCount(qwords[i]&fp[i]);
+        unsigned int denom=qcount+count-common;
+        double sim=denom ? static_cast<double>(common)/denom : 0.0;
+        if(sim<threshold) continue;
+        SimilarityHit hit(sim,dp_ids[idx]);
+        if(!k || best.size()<k){
+          best.push(hit);
+        } else if(betterHit()(hit,best.top())){
+          best.pop();
+          best.push(hit);
+        }
+      }
+      res.resize(best.size());
+      for(unsigned int i=res.size();i>0;--i){
+        res[i-1]=best.top();
+        best.pop();
+      }
+    }
+
+    void ScreeningDB::screen(const ExplicitBitVect &patternFP,
+                             std::vector<boost::uint64_t> &res) const {
+      std::vector<boost::uint64_t> qwords;
+      fpToWords(patternFP,d_fpWords,qwords);
+      res.clear();
+      const boost::uint64_t *fp=dp_patternFPs;
+      for(boost::uint64_t idx=0;idx<d_numRecords;++idx,fp+=d_fpWords){
+        unsigned int i=0;
+        while(i<d_fpWords && (qwords[i]&fp[i])==qwords[i]) ++i;
+        if(i==d_fpWords) res.push_back(idx);
+      }
+    }
+
+    void ScreeningDB::substructureSearch(const ROMol &query,
+                                         std::vector<boost::uint64_t> &res,
+                                         unsigned int maxHits) const {
+      ExplicitBitVect *patternFP=screeningFingerprint(query,getFPSize());
+      std::vector<boost::uint64_t> candidates;
+      screen(*patternFP,candidates);
+      delete patternFP;
+
+      res.clear();
+      for(std::vector<boost::uint64_t>::const_iterator idx=candidates.begin();
+          idx!=candidates.end();++idx){
+        if(maxHits && res.size()>=maxHits) break;
+        if(dp_pickleIndex){
+          ROMol *mol=getMol(*idx);
+          MatchVectType match;
+          bool matched=SubstructMatch(*mol,query,match);
+          delete mol;
+          if(!matched) continue;
+        }
+        res.push_back(dp_ids[*idx]);
+      }
+    }
+  }
+}
@@ -0,0 +1,174 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_SCREENINGDB_H_
+#define _RD_SCREENINGDB_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+class ExplicitBitVect;
+namespace RDKit {
+  class ROMol;
+  namespace Screening {
+    /*! \file ScreeningDB.h
+
+      \brief fingerprint databases for similarity and substructure screening
+
+      A screening database is a single file (a "shard") holding, for each
+      molecule, an id, a fingerprint for similarity searching (a Morgan
+      fingerprint with radius 2), a pattern fingerprint for substructure
+      screening, and (optionally) the molecule's pickle. The fingerprints
+      are stored in contiguous arrays so that the file can be memory
+      mapped and searched without constructing any molecules; the pickles
+      are only used to confirm substructure matches.
+
+      Large collections are split into several shards, which can be
+      searched independently (by different processes) and the results
+      merged, see DistributedScreening.h.
+
+      The files are written in the native byte order.
+    */
+
+    //! (similarity, id) pair for a similarity search result
+    typedef std::pair<double,boost::uint64_t> SimilarityHit;
+
+    //! the fingerprint used for similarity searching
+    ExplicitBitVect *similarityFingerprint(const ROMol &mol,unsigned int fpSize=2048);
+    //! the fingerprint used for substructure screening
+    ExplicitBitVect *screeningFingerprint(const ROMol &mol,unsigned int fpSize=2048);
+
+    //! merges two lists of hits (sorted by decreasing similarity)
+    /*!
+      \param hits1  the first list of hits
+      \param hits2  the second list of hits
+      \param k      the maximum number of hits to keep (0 for no limit)
+      \param res    used to return the merged hits, sorted by decreasing
+                    similarity (ties are sorted by increasing id)
+    */
+    void mergeSimilarityHits(const std::vector<SimilarityHit> &hits1,
+                             const std::vector<SimilarityHit> &hits2,
+                             unsigned int k,std::vector<SimilarityHit> &res);
+
+    //! writes a screening database
+    class ScreeningDBWriter {
+    public:
+      /*!
+        \param fileName      the file to write
+        \param fpSize        the size of the fingerprints (a multiple of 64)
+        \param storePickles  toggles storing molecule pickles, without them
+                             substructure searches only do the screening step.
+      */
+      explicit ScreeningDBWriter(const std::string &fileName,
+                                 unsigned int fpSize=2048,
+                                 bool storePickles=true);
+      ~ScreeningDBWriter();
+
+      //! adds a molecule to the database
+      void addMol(const ROMol &mol,boost::uint64_t id);
+      //! adds a record with precomputed fingerprints
+      /*!
+        the fingerprints should have been generated with
+        similarityFingerprint() and screeningFingerprint()
+      */
+      void addRecord(boost::uint64_t id,const ExplicitBitVect &simFP,
+                     const ExplicitBitVect &patternFP,
+                     const std::string &pickle="");
+      //! finishes the file, the writer cannot be used again
+      void close();
+      boost::uint64_t numRecords() const { return d_ids.size(); };
+
+    private:
+      // not copyable
+      ScreeningDBWriter(const ScreeningDBWriter &);
+      ScreeningDBWriter &operator=(const ScreeningDBWriter &);
+
+      std::string d_fileName;
+      unsigned int d_fpSize;
+      bool df_storePickles;
+      bool df_closed;
+      // the pickles go directly to the output file, the fingerprints
+      // are collected in temporary files:
+      std::ofstream d_outStream,d_simStream,d_patternStream;
+      std::vector<boost::uint64_t> d_ids,d_pickleOffsets;
+      std::vector<boost::uint32_t> d_simCounts;
+    };
+
+    //! a (memory mapped) screening database
+    class ScreeningDB {
+    public:
+      //! opens a database, throws a BadFileException on failure
+      explicit ScreeningDB(const std::string &fileName);
+
+      boost::uint64_t getNumRecords() const { return d_numRecords; };
+      unsigned int getFPSize() const { return d_fpWords*64; };
+      bool hasPickles() const { return dp_pickleIndex!=0; };
+      //! returns the id of record \c idx
+      boost::uint64_t getId(boost::uint64_t idx) const;
+      //! returns the molecule for record \c idx, the caller is
+      //! responsible for deleting it
+      ROMol *getMol(boost::uint64_t idx) const;
+
+      //! finds the molecules most similar to a query
+      /*!
+        \param query      the query fingerprint, from similarityFingerprint()
+        \param k          the number of hits to return (0 for all)
+        \param threshold  the minimum Tanimoto similarity of the hits
+        \param res        used to return the hits, sorted by decreasing
+                          similarity (ties are sorted by increasing id)
+
+        Records that cannot beat the current k'th hit (or the threshold)
+        because of their bit counts are skipped without being compared.
+      */
+      void similaritySearch(const ExplicitBitVect &query,unsigned int k,
+                            double threshold,std::vector<SimilarityHit> &res) const;
+
+      //! returns the indices of the records that pass the screen for a query
+      /*!
+        \param patternFP  the query fingerprint, from screeningFingerprint()
+        \param res        used to return the record indices
+      */
+      void screen(const ExplicitBitVect &patternFP,
+                  std::vector<boost::uint64_t> &res) const;
+
+      //! finds the molecules that contain a query
+      /*!
+        \param query    the query molecule
+        \param res      used to return the ids of the matching molecules,
+                        in the order they are stored
+        \param maxHits  the maximum number of hits to return (0 for all)
+
+        If the database does not have pickles, the ids of the molecules
+        that pass the screen are returned.
+      */
+      void substructureSearch(const ROMol &query,std::vector<boost::uint64_t> &res,
+                              unsigned int maxHits=0) const;
+
+    private:
+      boost::interprocess::file_mapping d_file;
+      boost::interprocess::mapped_region d_region;
+      boost::uint64_t d_numRecords;
+      unsigned int d_fpWords;
+      const char *dp_pickleData;
+      const boost::uint64_t *dp_pickleIndex;
+      const boost::uint64_t *dp_ids;
+      const boost::uint32_t *dp_simCounts;
+      const boost::uint64_t *dp_simFPs;
+      const boost::uint64_t *dp_patternFPs;
+    };
+    typedef boost::shared_ptr<ScreeningDB> ScreeningDB_SPTR;
+  }
+}
+#endif
@@ -0,0 +1,193 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "SubstructLibrary.h"
+#include "ScreeningDB.h"
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/MolPickler.h>
+#include <GraphMol/Substruct/SubstructMatch.h>
+#include <GraphMol/Substruct/CompiledQuery.h>
+#include <DataStructs/ExplicitBitVect.h>
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDThreads.h>
+
+#include <algorithm>
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+
+namespace RDKit {
+  namespace Screening {
+    namespace {
+      void fpToWords(const ExplicitBitVect &fp,unsigned int fpWords,
+                     boost::uint64_t *words){
+        PRECONDITION(fp.getNumBits()==fpWords*64,"bad fingerprint size");
+        std::fill(words,words+fpWords,0);
+        IntVect onBits;
+        fp.getOnBits(onBits);
+        for(IntVect::const_iterator bit=onBits.begin();bit!=onBits.end();++bit){
+          words[*bit/64] |= (static_cast<boost::uint64_t>(1) << (*bit%64));
+        }
+      }
+
+#ifdef RDK_THREADSAFE_SSS
+      // an exception thrown by a search thread; it's rethrown in the
+      // calling thread once all the threads are done.
+      struct ThreadError {
+        ThreadError() : failed(false) {};
+        bool failed;
+        boost::shared_ptr<MolPicklerException> pickleError;
+        boost::shared_ptr<Invar::Invariant> invariant;
+        std::string message;
+        void rethrow() const {
+          if(pickleError) throw *pickleError;
+          if(invariant) throw *invariant;
+          throw std::runtime_error(message);
+        }
+      };
+
+      void runCatching(boost::function<void ()> fn,ThreadError *error){
+        try{
+          fn();
+        } catch (MolPicklerException &e) {
+          error->pickleError.reset(new MolPicklerException(e));
+          error->failed=true;
+        } catch (Invar::Invariant &e) {
+          error->invariant.reset(new Invar::Invariant(e));
+          error->failed=true;
+        } catch (std::exception &e) {
+          error->message=e.what();
+          error->failed=true;
+        } catch (...) {
+          error->message="unknown error in substructure search";
+          error->failed=true;
+        }
+      }
+#endif
+    }
+
+    SubstructLibrary::SubstructLibrary(unsigned int fpSize,bool storePickles) :
+      d_fpWords(fpSize/64),df_storePickles(storePickles),d_numMols(0) {
+      PRECONDITION(fpSize>0 && !(fpSize%64),"fpSize must be a multiple of 64");
+      if(df_storePickles) d_pickleOffsets.push_back(0);
+    }
+
+    unsigned int SubstructLibrary::addMol(const ROMol &mol){
+      ExplicitBitVect *patternFP=screeningFingerprint(mol,getFPSize());
+      unsigned int res=addMol(mol,*patternFP);
+      delete patternFP;
+      return res;
+    }
+
+    unsigned int SubstructLibrary::addMol(const ROMol &mol,const ExplicitBitVect &patternFP){
+      PRECONDITION(patternFP.getNumBits()==getFPSize(),"bad fingerprint size");
+      d_patternFPs.resize(d_patternFPs.size()+d_fpWords);
+      fpToWords(patternFP,d_fpWords,&d_patternFPs[d_patternFPs.size()-d_fpWords]);
+      if(df_storePickles){
+        std::string pickle;
+        MolPickler::pickleMol(mol,pickle);
+        d_pickleData+=pickle;
+        d_pickleOffsets.push_back(d_pickleData.size());
+      } else {
+        d_mols.push_back(ROMOL_SPTR(new ROMol(mol)));
+      }
+      return d_numMols++;
+    }
+
+    boost::shared_ptr<const ROMol> SubstructLibrary::getMol(unsigned int idx) const {
+      PRECONDITION(idx<d_numMols,"bad molecule index");
+      if(!df_storePickles) return d_mols[idx];
+      boost::shared_ptr<ROMol> res(new ROMol());
+      MolPickler::molFromPickle(d_pickleData.c_str()+d_pickleOffsets[idx],
+                                d_pickleOffsets[idx+1]-d_pickleOffsets[idx],res.get());
+      return res;
+    }
+
+    void SubstructLibrary::screen(const ExplicitBitVect &patternFP,
+                                  std::vector<unsigned int> &res) const {
+      std::vector<boost::uint64_t> qwords(d_fpWords);
+      fpToWords(patternFP,d_fpWords,&qwords[0]);
+      res.clear();
+      for(unsigned int idx=0;idx<d_numMols;++idx){
+        if(passesScreen(&qwords[0],idx)) res.push_back(idx);
+      }
+    }
+
+    void SubstructLibrary::searchMols(const std::vector<boost::uint64_t> *qwords,
+                                      const CompiledQueryMol *query,
+                                      bool recursionPossible,bool useChirality,
+                                      unsigned int start,unsigned int stride,
+                                      unsigned int maxHits,
+                                      std::vector<unsigned int> *res) const {
+      // each caller only needs its own first maxHits hits: any of the
+      // overall first maxHits hits is among them.
+      for(unsigned int idx=start;idx<d_numMols;idx+=stride){
+        if(maxHits && res->size()>=maxHits) break;
+        if(!passesScreen(&(*qwords)[0],idx)) continue;
+        boost::shared_ptr<const ROMol> mol=getMol(idx);
+        MatchVectType match;
+        if(SubstructMatch(*mol,*query,match,recursionPossible,useChirality)){
+          res->push_back(idx);
+        }
+      }
+    }
+
+    void SubstructLibrary::getMatches(const ROMol &query,std::vector<unsigned int> &res,
+                                      bool recursionPossible,bool useChirality,
+                                      int numThreads,unsigned int maxHits) const {
+      res.clear();
+      if(!d_numMols) return;
+      std::vector<boost::uint64_t> qwords(d_fpWords);
+      ExplicitBitVect *patternFP=screeningFingerprint(query,getFPSize());
+      fpToWords(*patternFP,d_fpWords,&qwords[0]);
+      delete patternFP;
+      // the query is compiled once for all the molecules:
+      CompiledQueryMol compiled(query);
+
+      numThreads=getNumThreadsToUse(numThreads);
+      if(numThreads==1 || d_numMols<2){
+        searchMols(&qwords,&compiled,recursionPossible,useChirality,0,1,maxHits,&res);
+      }
+#ifdef RDK_THREADSAFE_SSS
+      else {
+        std::vector< std::vector<unsigned int> > threadRes(numThreads);
+        std::vector<ThreadError> errors(numThreads);
+        // make sure the singletons are initialized before the threads start:
+        PeriodicTable::getTable();
+        boost::thread_group tg;
+        for(int ti=0;ti<numThreads;++ti){
+          boost::function<void ()> fn=boost::bind(&SubstructLibrary::searchMols,this,&qwords,
+                                                  &compiled,recursionPossible,useChirality,
+                                                  ti,numThreads,maxHits,&threadRes[ti]);
+          tg.add_thread(new boost::thread(runCatching,fn,&errors[ti]));
+        }
+        tg.join_all();
+        for(int ti=0;ti<numThreads;++ti){
+          if(errors[ti].failed) errors[ti].rethrow();
+        }
+        for(int ti=0;ti<numThreads;++ti){
+          res.insert(res.end(),threadRes[ti].begin(),threadRes[ti].end());
+        }
+        std::sort(res.begin(),res.end());
+        if(maxHits && res.size()>maxHits) res.resize(maxHits);
+      }
+#endif
+    }
+
+    bool SubstructLibrary::hasMatch(const ROMol &query,bool recursionPossible,
+                                    bool useChirality,int numThreads) const {
+      std::vector<unsigned int> matches;
+      getMatches(query,matches,recursionPossible,useChirality,numThreads,1);
+      return !matches.empty();
+    }
+  }
+}
@@ -0,0 +1,133 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_SUBSTRUCTLIBRARY_H_
+#define _RD_SUBSTRUCTLIBRARY_H_
+
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <GraphMol/ROMol.h>
+
+class ExplicitBitVect;
+namespace RDKit {
+  class CompiledQueryMol;
+  namespace Screening {
+    /*! \file SubstructLibrary.h
+
+      \brief an in-memory library of molecules for substructure searching
+
+      The library holds, for each molecule, a pattern fingerprint (see
+      screeningFingerprint() in ScreeningDB.h) and either the molecule
+      itself or its pickle. The fingerprints are packed into a single
+      array of 64 bit words, so a query is screened with word-wise
+      subset tests without touching the molecules; only the molecules
+      that pass the screen are matched against the query (materializing
+      them from their pickles, if necessary).
+
+      Storing pickles uses a lot less memory than storing molecules, at
+      the expense of having to unpickle each molecule that passes the
+      screen.
+
+      Searches can be run by several threads at the same time, but
+      molecules must not be added while a search is running.
+    */
+    class SubstructLibrary {
+    public:
+      /*!
+        \param fpSize        the size of the pattern fingerprints (a multiple of 64)
+        \param storePickles  toggles storing the molecules' pickles instead of
+                             the molecules
+      */
+      explicit SubstructLibrary(unsigned int fpSize=2048,bool storePickles=true);
+
+      //! adds a molecule to the library and returns its index
+      unsigned int addMol(const ROMol &mol);
+      //! adds a molecule with a precomputed pattern fingerprint and returns
+      //! its index
+      /*!
+        the fingerprint should have been generated with
+        screeningFingerprint()
+      */
+      unsigned int addMol(const ROMol &mol,const ExplicitBitVect &patternFP);
+
+      unsigned int size() const { return d_numMols; };
+      unsigned int getFPSize() const { return d_fpWords*64; };
+      bool storesPickles() const { return df_storePickles; };
+      //! returns molecule \c idx (a new molecule if pickles are stored)
+      /*!
+        If the molecules are stored this is the library's own molecule,
+        which may be in use by a search in another thread, so it's const.
+      */
+      boost::shared_ptr<const ROMol> getMol(unsigned int idx) const;
+
+      //! returns the indices of the molecules that pass the screen for a query
+      /*!
+        \param patternFP  the query fingerprint, from screeningFingerprint()
+        \param res        used to return the indices, in increasing order
+      */
+      void screen(const ExplicitBitVect &patternFP,std::vector<unsigned int> &res) const;
+
+      //! finds the molecules that contain a query
+      /*!
+        \param query              the query molecule
+        \param res                used to return the indices of the matching
+                                  molecules, in increasing order
+        \param recursionPossible  allow the use of recursive queries
+        \param useChirality       use atomic CIP codes as part of the comparison
+        \param numThreads         the number of threads to use. If this is <= 0,
+                                  the number of hardware threads is added to it.
+        \param maxHits            the maximum number of hits to return (0 for all).
+                                  The hits returned are always the ones with the
+                                  lowest indices.
+
+        An exception thrown while a molecule is searched (for example if
+        its pickle can't be read) is passed on to the caller, also when
+        several threads are used.
+      */
+      void getMatches(const ROMol &query,std::vector<unsigned int> &res,
+                      bool recursionPossible=true,bool useChirality=false,
+                      int numThreads=1,unsigned int maxHits=0) const;
+      //! returns whether or not any molecule in the library contains a query
+      /*!
+        the arguments are as for getMatches()
+      */
+      bool hasMatch(const ROMol &query,bool recursionPossible=true,
+                    bool useChirality=false,int numThreads=1) const;
+
+    private:
+      // not copyable
+      SubstructLibrary(const SubstructLibrary &);
+      SubstructLibrary &operator=(const SubstructLibrary &);
+
+      // searches the molecules start, start+stride, ...
+      void searchMols(const std::vector<boost::uint64_t> *qwords,
+                      const CompiledQueryMol *query,
+                      bool recursionPossible,bool useChirality,
+                      unsigned int start,unsigned int stride,
+                      unsigned int maxHits,std::vector<unsigned int> *res) const;
+      bool passesScreen(const boost::uint64_t *qwords,unsigned int idx) const {
+        const boost::uint64_t *fp=&d_patternFPs[static_cast<size_t>(idx)*d_fpWords];
+        for(unsigned int i=0;i<d_fpWords;++i){
+          if((qwords[i]&fp[i])!=qwords[i]) return false;
+        }
+        return true;
+      };
+
+      unsigned int d_fpWords;
+      bool df_storePickles;
+      unsigned int d_numMols;
+      std::vector<boost::uint64_t> d_patternFPs;
+      std::vector<ROMOL_SPTR> d_mols;
+      std::string d_pickleData;
+      std::vector<boost::uint64_t> d_pickleOffsets;
+    };
+  }
+}
+#endif
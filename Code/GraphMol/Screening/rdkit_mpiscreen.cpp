@@ -0,0 +1,150 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+//  Builds and searches sharded screening databases with MPI.
+//
+//  Usage (run with mpirun, any number of ranks):
+//    rdkit_mpiscreen build input.smi prefix nShards
+//    rdkit_mpiscreen similarity prefix nShards SMILES k [threshold]
+//    rdkit_mpiscreen substructure prefix nShards SMARTS [maxHits]
+//
+//  The input file has one SMILES per line (anything after the first
+//  whitespace is ignored), the molecule on line i (counting from zero)
+//  gets id i and goes to shard i % nShards. The shards are written
+//  to prefix.<n>.rdsdb, shard n is written and searched by rank
+//  n % (number of ranks).
+//
+#include "DistributedScreening.h"
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <DataStructs/ExplicitBitVect.h>
+#include <RDGeneral/RDLog.h>
+#include <RDGeneral/BadFileException.h>
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace RDKit;
+namespace mpi=boost::mpi;
+
+namespace {
+  void usage(){
+    std::cerr<<"Usage:\n"
+             <<"  rdkit_mpiscreen build input.smi prefix nShards\n"
+             <<"  rdkit_mpiscreen similarity prefix nShards SMILES k [threshold]\n"
+             <<"  rdkit_mpiscreen substructure prefix nShards SMARTS [maxHits]\n"
+             <<"nShards must be at least 1\n";
+  }
+
+  void buildShards(const mpi::communicator &comm,const std::string &inputName,
+                   const std::string &prefix,unsigned int nShards){
+    std::vector<boost::shared_ptr<Screening::ScreeningDBWriter> > writers(nShards);
+    for(unsigned int i=comm.rank();i<nShards;i+=comm.size()){
+      writers[i].reset(new Screening::ScreeningDBWriter(Screening::shardName(prefix,i)));
+    }
+    std::ifstream inStream(inputName.c_str());
+    if(!inStream){
+      throw BadFileException("could not open "+inputName);
+    }
+    std::string line;
+    for(boost::uint64_t lineNo=0;std::getline(inStream,line);++lineNo){
+      unsigned int shard=lineNo%nShards;
+      if(!writers[shard]) continue;
+      std::istringstream ls(line);
+      std::string smiles;
+      ls>>smiles;
+      if(smiles.empty()) continue;
+      ROMol *mol=0;
+      try {
+        mol=SmilesToMol(smiles);
+      } catch (const std::exception &e) {
+        mol=0;
+      }
+      if(!mol){
+        BOOST_LOG(rdWarningLog)<<"skipping line "<<lineNo<<std::endl;
+        continue;
+      }
+      writers[shard]->addMol(*mol,lineNo);
+      delete mol;
+    }
+    for(unsigned int i=comm.rank();i<nShards;i+=comm.size()){
+      writers[i]->close();
+    }
+  }
+
+  void openShards(const mpi::communicator &comm,const std::string &prefix,
+                  unsigned int nShards,std::vector<Screening::ScreeningDB_SPTR> &shards){
+    std::vector<std::string> names;
+    for(unsigned int i=0;i<nShards;++i){
+      names.push_back(Screening::shardName(prefix,i));
+    }
+    Screening::openLocalShards(comm,names,shards);
+  }
+}
+
+int main(int argc,char *argv[]){
+  mpi::environment env(argc,argv);
+  mpi::communicator world;
+  RDLog::InitLogs();
+
+  if(argc<5){
+    if(!world.rank()) usage();
+    return 1;
+  }
+  std::string mode=argv[1];
+  try {
+    unsigned int nShards=boost::lexical_cast<unsigned int>(argv[mode=="build" ? 4 : 3]);
+    if(!nShards){
+      if(!world.rank()) usage();
+      return 1;
+    }
+    if(mode=="build"){
+      buildShards(world,argv[2],argv[3],nShards);
+    } else if(mode=="similarity" && argc>=6){
+      std::vector<Screening::ScreeningDB_SPTR> shards;
+      openShards(world,argv[2],nShards,shards);
+      ROMol *query=SmilesToMol(argv[4]);
+      if(!query) throw std::invalid_argument("could not parse query");
+      unsigned int k=boost::lexical_cast<unsigned int>(argv[5]);
+      double threshold=argc>6 ? boost::lexical_cast<double>(argv[6]) : 0.0;
+      ExplicitBitVect *fp=Screening::similarityFingerprint(*query);
+      std::vector<Screening::SimilarityHit> hits;
+      Screening::distributedSimilaritySearch(world,shards,*fp,k,threshold,hits);
+      delete fp;
+      delete query;
+      for(unsigned int i=0;i<hits.size();++i){
+        std::cout<<hits[i].second<<"\t"<<hits[i].first<<"\n";
+      }
+    } else if(mode=="substructure"){
+      std::vector<Screening::ScreeningDB_SPTR> shards;
+      openShards(world,argv[2],nShards,shards);
+      ROMol *query=SmartsToMol(argv[4]);
+      if(!query) throw std::invalid_argument("could not parse query");
+      unsigned int maxHits=argc>5 ? boost::lexical_cast<unsigned int>(argv[5]) : 0;
+      std::vector<boost::uint64_t> hits;
+      Screening::distributedSubstructureSearch(world,shards,*query,maxHits,hits);
+      delete query;
+      for(unsigned int i=0;i<hits.size();++i){
+        std::cout<<hits[i]<<"\n";
+      }
+    } else {
+      if(!world.rank()) usage();
+      return 1;
+    }
+  } catch (const std::exception &e) {
+    std::cerr<<"rank "<<world.rank()<<": "<<e.what()<<std::endl;
+    world.abort(1);
+  }
+  return 0;
+}
@@ -0,0 +1,135 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+//  run this with several ranks, e.g.: mpirun -np 3 testMPIScreening
+//
+
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/Substruct/SubstructMatch.h>
+#include <GraphMol/Screening/DistributedScreening.h>
+#include <DataStructs/ExplicitBitVect.h>
+#include <DataStructs/BitOps.h>
+#include <RDGeneral/RDLog.h>
+#include <RDGeneral/Invariant.h>
+#include <boost/mpi/environment.hpp>
+#include <boost/mpi/communicator.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+using namespace RDKit;
+namespace mpi=boost::mpi;
+
+namespace {
+  void readMols(unsigned int nMols,std::vector<ROMOL_SPTR> &mols){
+    std::string rdbase = getenv("RDBASE");
+    std::string fname = rdbase + "/Data/NCI/first_5K.smi";
+    std::ifstream inStream(fname.c_str());
+    TEST_ASSERT(inStream);
+    std::string line;
+    while(mols.size()<nMols && std::getline(inStream,line)){
+      std::istringstream ls(line);
+      std::string smiles;
+      ls>>smiles;
+      ROMol *mol=SmilesToMol(smiles);
+      TEST_ASSERT(mol);
+      mols.push_back(ROMOL_SPTR(mol));
+    }
+  }
+}
+
+void testDistributedSearches(const mpi::communicator &world){
+  if(!world.rank()){
+    BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+    BOOST_LOG(rdErrorLog) << "    Testing distributed searches on " << world.size()
+                          << " ranks." << std::endl;
+  }
+  std::vector<ROMOL_SPTR> mols;
+  readMols(500,mols);
+
+  // more shards than ranks, so that some ranks have several:
+  const unsigned int nShards=world.size()+2;
+  std::vector<std::string> names;
+  for(unsigned int i=0;i<nShards;++i){
+    names.push_back(Screening::shardName("testMPIScreening",i));
+  }
+  for(unsigned int i=world.rank();i<nShards;i+=world.size()){
+    Screening::ScreeningDBWriter writer(names[i]);
+    for(unsigned int j=i;j<mols.size();j+=nShards){
+      writer.addMol(*mols[j],j);
+    }
+    writer.close();
+  }
+  world.barrier();
+
+  std::vector<Screening::ScreeningDB_SPTR> shards;
+  Screening::openLocalShards(world,names,shards);
+  TEST_ASSERT(shards.size()==(nShards-world.rank()+world.size()-1)/world.size());
+
+  // similarity:
+  unsigned int queries[]={0,42,499};
+  for(unsigned int qi=0;qi<3;++qi){
+    ExplicitBitVect *qfp=Screening::similarityFingerprint(*mols[queries[qi]]);
+    std::vector<Screening::SimilarityHit> hits;
+    Screening::distributedSimilaritySearch(world,shards,*qfp,10,0.0,hits);
+    if(!world.rank()){
+      std::vector<Screening::SimilarityHit> ref;
+      for(unsigned int i=0;i<mols.size();++i){
+        ExplicitBitVect *fp=Screening::similarityFingerprint(*mols[i]);
+        ref.push_back(std::make_pair(-TanimotoSimilarity(*qfp,*fp),static_cast<boost::uint64_t>(i)));
+        delete fp;
+      }
+      std::sort(ref.begin(),ref.end());
+      ref.resize(10);
+      TEST_ASSERT(hits.size()==10);
+      for(unsigned int i=0;i<hits.size();++i){
+        TEST_ASSERT(hits[i].second==ref[i].second);
+        TEST_ASSERT(feq(hits[i].first,-ref[i].first));
+      }
+    } else {
+      TEST_ASSERT(hits.empty());
+    }
+    delete qfp;
+  }
+
+  // substructure:
+  std::string smarts[]={"c1ccccc1","C(=O)O","[Cl,Br]"};
+  for(unsigned int qi=0;qi<3;++qi){
+    ROMol *query=SmartsToMol(smarts[qi]);
+    std::vector<boost::uint64_t> hits,limited;
+    Screening::distributedSubstructureSearch(world,shards,*query,0,hits);
+    Screening::distributedSubstructureSearch(world,shards,*query,5,limited);
+    if(!world.rank()){
+      std::vector<boost::uint64_t> ref;
+      for(unsigned int i=0;i<mols.size();++i){
+        MatchVectType match;
+        if(SubstructMatch(*mols[i],*query,match)) ref.push_back(i);
+      }
+      TEST_ASSERT(hits==ref);
+      TEST_ASSERT(limited.size()==std::min(static_cast<size_t>(5),ref.size()));
+      TEST_ASSERT(std::equal(limited.begin(),limited.end(),ref.begin()));
+    } else {
+      TEST_ASSERT(hits.empty());
+    }
+    delete query;
+  }
+  if(!world.rank()){
+    BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+  }
+}
+
+int main(int argc,char *argv[]){
+  mpi::environment env(argc,argv);
+  mpi::communicator world;
+  RDLog::InitLogs();
+  testDistributedSearches(world);
+  return 0;
+}
@@ -0,0 +1,305 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/Substruct/SubstructMatch.h>
+#include <GraphMol/Screening/ScreeningDB.h>
+#include <GraphMol/Screening/SubstructLibrary.h>
+#include <DataStructs/ExplicitBitVect.h>
+#include <DataStructs/BitOps.h>
+#include <RDGeneral/RDLog.h>
+#include <RDGeneral/BadFileException.h>
+#include <RDGeneral/Invariant.h>
+#include <boost/lexical_cast.hpp>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+using namespace RDKit;
+
+namespace {
+  // the first nMols molecules from the NCI file:
+  void readMols(unsigned int nMols,std::vector<ROMOL_SPTR> &mols){
+    std::string rdbase = getenv("RDBASE");
+    std::string fname = rdbase + "/Data/NCI/first_5K.smi";
+    std::ifstream inStream(fname.c_str());
+    TEST_ASSERT(inStream);
+    std::string line;
+    while(mols.size()<nMols && std::getline(inStream,line)){
+      std::istringstream ls(line);
+      std::string smiles;
+      ls>>smiles;
+      ROMol *mol=SmilesToMol(smiles);
+      TEST_ASSERT(mol);
+      mols.push_back(ROMOL_SPTR(mol));
+    }
+  }
+
+  std::string buildShard(const std::vector<ROMOL_SPTR> &mols,unsigned int shard,
+                         unsigned int nShards,bool storePickles){
+    std::string fname="testScreeningDB."+boost::lexical_cast<std::string>(shard)+".rdsdb";
+    Screening::ScreeningDBWriter writer(fname,2048,storePickles);
+    for(unsigned int i=shard;i<mols.size();i+=nShards){
+      writer.addMol(*mols[i],i);
+    }
+    TEST_ASSERT(writer.numRecords()==(mols.size()-shard+nShards-1)/nShards);
+    writer.close();
+    return fname;
+  }
+}
+
+void testBasics(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Testing screening database basics." << std::endl;
+
+  std::vector<ROMOL_SPTR> mols;
+  readMols(100,mols);
+  std::string fname=buildShard(mols,0,1,true);
+
+  Screening::ScreeningDB db(fname);
+  TEST_ASSERT(db.getNumRecords()==100);
+  TEST_ASSERT(db.getFPSize()==2048);
+  TEST_ASSERT(db.hasPickles());
+  for(unsigned int i=0;i<db.getNumRecords();++i){
+    TEST_ASSERT(db.getId(i)==i);
+    ROMol *mol=db.getMol(i);
+    TEST_ASSERT(mol->getNumAtoms()==mols[i]->getNumAtoms());
+    TEST_ASSERT(mol->getNumBonds()==mols[i]->getNumBonds());
+    delete mol;
+  }
+
+  {
+    // an empty database
+    Screening::ScreeningDBWriter writer("testScreeningDB.empty.rdsdb");
+    writer.close();
+    Screening::ScreeningDB empty("testScreeningDB.empty.rdsdb");
+    TEST_ASSERT(empty.getNumRecords()==0);
+    std::vector<Screening::SimilarityHit> hits;
+    ExplicitBitVect *fp=Screening::similarityFingerprint(*mols[0]);
+    empty.similaritySearch(*fp,10,0.0,hits);
+    delete fp;
+    TEST_ASSERT(hits.empty());
+  }
+
+  {
+    // files that aren't databases
+    bool ok=false;
+    try {
+      Screening::ScreeningDB bad("testScreeningDB.nonexistent.rdsdb");
+    } catch (BadFileException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    std::string rdbase = getenv("RDBASE");
+    ok=false;
+    try {
+      Screening::ScreeningDB bad(rdbase + "/Data/NCI/first_5K.smi");
+    } catch (BadFileException &) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+  }
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
+void testSimilaritySearch(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Testing sharded similarity searches." << std::endl;
+
+  std::vector<ROMOL_SPTR> mols;
+  readMols(1000,mols);
+  const unsigned int nShards=3;
+  std::vector<Screening::ScreeningDB_SPTR> shards;
+  for(unsigned int i=0;i<nShards;++i){
+    shards.push_back(Screening::ScreeningDB_SPTR(new Screening::ScreeningDB(buildShard(mols,i,nShards,false))));
+  }
+  std::vector<ExplicitBitVect *> fps;
+  for(unsigned int i=0;i<mols.size();++i){
+    fps.push_back(Screening::similarityFingerprint(*mols[i]));
+  }
+
+  unsigned int queries[]={0,17,250,999};
+  unsigned int ks[]={1,10,50,0};
+  double thresholds[]={0.0,0.3};
+  for(unsigned int qi=0;qi<4;++qi){
+    for(unsigned int ki=0;ki<4;++ki){
+      for(unsigned int ti=0;ti<2;++ti){
+        unsigned int k=ks[ki];
+        double threshold=thresholds[ti];
+        // the reference answer from a brute force search:
+        std::vector<Screening::SimilarityHit> ref;
+        for(unsigned int i=0;i<mols.size();++i){
+          double sim=TanimotoSimilarity(*fps[queries[qi]],*fps[i]);
+          if(sim>=threshold) ref.push_back(std::make_pair(-sim,static_cast<boost::uint64_t>(i)));
+        }
+        std::sort(ref.begin(),ref.end());
+        if(k && ref.size()>k) ref.resize(k);
+
+        std::vector<Screening::SimilarityHit> hits,shardHits;
+        for(unsigned int i=0;i<nShards;++i){
+          shards[i]->similaritySearch(*fps[queries[qi]],k,threshold,shardHits);
+          TEST_ASSERT(!k || shardHits.size()<=k);
+          Screening::mergeSimilarityHits(hits,shardHits,k,hits);
+        }
+        TEST_ASSERT(hits.size()==ref.size());
+        for(unsigned int i=0;i<hits.size();++i){
+          TEST_ASSERT(hits[i].second==ref[i].second);
+          TEST_ASSERT(feq(hits[i].first,-ref[i].first));
+        }
+        if(k) TEST_ASSERT(hits[0].second==queries[qi]);
+      }
+    }
+  }
+  for(unsigned int i=0;i<fps.size();++i) delete fps[i];
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
+void testSubstructureSearch(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Testing sharded substructure searches." << std::endl;
+
+  std::vector<ROMOL_SPTR> mols;
+  readMols(1000,mols);
+  const unsigned int nShards=3;
+  std::vector<Screening::ScreeningDB_SPTR> shards;
+  for(unsigned int i=0;i<nShards;++i){
+    shards.push_back(Screening::ScreeningDB_SPTR(new Screening::ScreeningDB(buildShard(mols,i,nShards,true))));
+  }
+
+  std::string queries[]={"c1ccccc1","C(=O)O","[#7]~[#6]~[#8]","c1ccc2ccccc2c1","S(=O)(=O)N",
+                         "[Cl,Br]","C1CCCCC1"};
+  for(unsigned int qi=0;qi<7;++qi){
+    ROMol *query=SmartsToMol(queries[qi]);
+    TEST_ASSERT(query);
+    std::vector<boost::uint64_t> ref;
+    for(unsigned int i=0;i<mols.size();++i){
+      MatchVectType match;
+      if(SubstructMatch(*mols[i],*query,match)) ref.push_back(i);
+    }
+
+    std::vector<boost::uint64_t> hits,shardHits,screened;
+    for(unsigned int i=0;i<nShards;++i){
+      shards[i]->substructureSearch(*query,shardHits);
+      hits.insert(hits.end(),shardHits.begin(),shardHits.end());
+      // every match has to pass the screen:
+      ExplicitBitVect *fp=Screening::screeningFingerprint(*query);
+      shards[i]->screen(*fp,screened);
+      delete fp;
+      TEST_ASSERT(screened.size()>=shardHits.size());
+      // limiting the number of hits gives the first ones:
+      std::vector<boost::uint64_t> limited;
+      shards[i]->substructureSearch(*query,limited,3);
+      TEST_ASSERT(limited.size()==std::min(static_cast<size_t>(3),shardHits.size()));
+      TEST_ASSERT(std::equal(limited.begin(),limited.end(),shardHits.begin()));
+    }
+    std::sort(hits.begin(),hits.end());
+    TEST_ASSERT(hits==ref);
+    delete query;
+  }
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
+void testSubstructLibrary(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Testing substructure libraries." << std::endl;
+
+  std::vector<ROMOL_SPTR> mols;
+  readMols(1000,mols);
+  Screening::SubstructLibrary pickled,unpickled(1024,false);
+  for(unsigned int i=0;i<mols.size();++i){
+    TEST_ASSERT(pickled.addMol(*mols[i])==i);
+    TEST_ASSERT(unpickled.addMol(*mols[i])==i);
+  }
+  TEST_ASSERT(pickled.size()==mols.size());
+  TEST_ASSERT(pickled.getFPSize()==2048);
+  TEST_ASSERT(pickled.storesPickles());
+  TEST_ASSERT(unpickled.getFPSize()==1024);
+  TEST_ASSERT(!unpickled.storesPickles());
+  for(unsigned int i=0;i<mols.size();i+=100){
+    boost::shared_ptr<const ROMol> mol=pickled.getMol(i);
+    TEST_ASSERT(mol->getNumAtoms()==mols[i]->getNumAtoms());
+    TEST_ASSERT(mol->getNumBonds()==mols[i]->getNumBonds());
+  }
+
+  std::string queries[]={"c1ccccc1","C(=O)O","[#7]~[#6]~[#8]","c1ccc2ccccc2c1","S(=O)(=O)N",
+                         "[Cl,Br]","C1CCCCC1","[$(C=O)]N","[Xe]"};
+  Screening::SubstructLibrary *libs[]={&pickled,&unpickled};
+  for(unsigned int qi=0;qi<9;++qi){
+    ROMol *query=SmartsToMol(queries[qi]);
+    TEST_ASSERT(query);
+    std::vector<unsigned int> ref;
+    for(unsigned int i=0;i<mols.size();++i){
+      MatchVectType match;
+      if(SubstructMatch(*mols[i],*query,match)) ref.push_back(i);
+    }
+    for(unsigned int li=0;li<2;++li){
+      // every match has to pass the screen:
+      std::vector<unsigned int> screened;
+      ExplicitBitVect *fp=Screening::screeningFingerprint(*query,libs[li]->getFPSize());
+      libs[li]->screen(*fp,screened);
+      delete fp;
+      TEST_ASSERT(std::includes(screened.begin(),screened.end(),ref.begin(),ref.end()));
+
+      for(int numThreads=1;numThreads<4;++numThreads){
+        std::vector<unsigned int> hits;
+        libs[li]->getMatches(*query,hits,true,false,numThreads);
+        TEST_ASSERT(hits==ref);
+        // limiting the number of hits gives the first ones:
+        libs[li]->getMatches(*query,hits,true,false,numThreads,3);
+        TEST_ASSERT(hits.size()==std::min(static_cast<size_t>(3),ref.size()));
+        TEST_ASSERT(std::equal(hits.begin(),hits.end(),ref.begin()));
+        TEST_ASSERT(libs[li]->hasMatch(*query,true,false,numThreads)==!ref.empty());
+      }
+    }
+    delete query;
+  }
+
+  {
+    // chirality
+    Screening::SubstructLibrary lib;
+    std::string smis[]={"C[C@H](F)Cl","C[C@@H](F)Cl","CC(F)Cl"};
+    for(unsigned int i=0;i<3;++i){
+      ROMol *mol=SmilesToMol(smis[i]);
+      TEST_ASSERT(mol);
+      lib.addMol(*mol);
+      delete mol;
+    }
+    ROMol *query=SmilesToMol("C[C@H](F)Cl");
+    std::vector<unsigned int> hits;
+    lib.getMatches(*query,hits);
+    TEST_ASSERT(hits.size()==3);
+    lib.getMatches(*query,hits,true,true);
+    TEST_ASSERT(hits.size()==1);
+    TEST_ASSERT(hits[0]==0);
+    delete query;
+  }
+
+  {
+    // an empty library
+    Screening::SubstructLibrary empty;
+    TEST_ASSERT(empty.size()==0);
+    std::vector<unsigned int> hits;
+    empty.getMatches(*mols[0],hits);
+    TEST_ASSERT(hits.empty());
+    TEST_ASSERT(!empty.hasMatch(*mols[0]));
+  }
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
+int main(){
+  RDLog::InitLogs();
+  testBasics();
+  testSimilaritySearch();
+  testSubstructureSearch();
+  testSubstructLibrary();
+  return 0;
+}
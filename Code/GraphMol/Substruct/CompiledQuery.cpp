@@ -0,0 +1,283 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "CompiledQuery.h"
+#include <RDGeneral/Invariant.h>
+#include <typeinfo>
+#include <algorithm>
+
+namespace RDKit{
+
+  template <class T>
+  unsigned int QueryProgram<T>::addQuery(QUERY_TYPE *query){
+    PRECONDITION(query,"bad query");
+    d_starts.push_back(d_code.size());
+    compileNode(query);
+    emit(OP_END);
+    return d_starts.size()-1;
+  }
+
+  template <class T>
+  void QueryProgram<T>::emit(boost::uint8_t op,boost::uint8_t flags,int val,int val2,
+                             int tol,unsigned int column){
+    Instruction ins;
+    ins.op=op;
+    ins.flags=flags;
+    ins.column=static_cast<boost::uint16_t>(column);
+    ins.val=val;
+    ins.val2=val2;
+    ins.tol=tol;
+    d_code.push_back(ins);
+  }
+
+  template <class T>
+  unsigned int QueryProgram<T>::getColumn(DATA_FUNC func){
+    typename std::vector<DATA_FUNC>::const_iterator loc=std::find(d_dataFuncs.begin(),
+                                                                  d_dataFuncs.end(),func);
+    if(loc!=d_dataFuncs.end()) return loc-d_dataFuncs.begin();
+    d_dataFuncs.push_back(func);
+    return d_dataFuncs.size()-1;
+  }
+
+  template <class T>
+  void QueryProgram<T>::compileNode(QUERY_TYPE *query){
+    PRECONDITION(query,"bad query");
+    typedef Queries::AndQuery<int,T const *,true> AND_TYPE;
+    typedef Queries::OrQuery<int,T const *,true> OR_TYPE;
+    typedef Queries::EqualityQuery<int,T const *,true> EQUALS_TYPE;
+    typedef Queries::GreaterQuery<int,T const *,true> GREATER_TYPE;
+    typedef Queries::GreaterEqualQuery<int,T const *,true> GREATEREQUAL_TYPE;
+    typedef Queries::LessQuery<int,T const *,true> LESS_TYPE;
+    typedef Queries::LessEqualQuery<int,T const *,true> LESSEQUAL_TYPE;
+    typedef Queries::RangeQuery<int,T const *,true> RANGE_TYPE;
+    typedef Queries::SetQuery<int,T const *,true> SET_TYPE;
+
+    const std::type_info &type=typeid(*query);
+    boost::uint8_t negate=query->getNegation() ? NEGATE : 0;
+
+    if(type==typeid(AND_TYPE) || type==typeid(OR_TYPE)){
+      bool isAnd=(type==typeid(AND_TYPE));
+      if(query->beginChildren()==query->endChildren()){
+        emit(OP_CONST,negate,isAnd);
+        return;
+      }
+      // each child but the last is followed by a jump to the end
+      // that is taken as soon as the result is known:
+      std::vector<unsigned int> jumps;
+      for(typename QUERY_TYPE::CHILD_VECT_CI childIt=query->beginChildren();
+          childIt!=query->endChildren();++childIt){
+        if(childIt!=query->beginChildren()){
+          jumps.push_back(d_code.size());
+          emit(isAnd ? OP_JUMP_IF_FALSE : OP_JUMP_IF_TRUE);
+        }
+        compileNode(childIt->get());
+      }
+      for(unsigned int i=0;i<jumps.size();++i){
+        d_code[jumps[i]].val=d_code.size();
+      }
+      if(negate) emit(OP_NOT);
+      return;
+    }
+
+    if(type==typeid(RecursiveStructureQuery)){
+      emit(OP_RECURSIVE,negate,addRecursive(query));
+      return;
+    }
+
+    DATA_FUNC func=query->getDataFunc();
+    if(func && d_dataFuncs.size()<0xFFFF){
+      if(type==typeid(EQUALS_TYPE) || type==typeid(GREATER_TYPE) ||
+         type==typeid(GREATEREQUAL_TYPE) || type==typeid(LESS_TYPE) ||
+         type==typeid(LESSEQUAL_TYPE) || type==typeid(AtomRingQuery)){
+        const EQUALS_TYPE *eq=static_cast<const EQUALS_TYPE *>(query);
+        boost::uint8_t accept;
+        if(type==typeid(EQUALS_TYPE)) accept=CMP_EQUAL;
+        else if(type==typeid(GREATER_TYPE)) accept=CMP_GREATER;
+        else if(type==typeid(GREATEREQUAL_TYPE)) accept=CMP_GREATER|CMP_EQUAL;
+        else if(type==typeid(LESS_TYPE)) accept=CMP_LESS;
+        else if(type==typeid(LESSEQUAL_TYPE)) accept=CMP_LESS|CMP_EQUAL;
+        else {
+          // AtomRingQuery: a negative value means "in any ring"
+          if(eq->getVal()<0){
+            emit(OP_NONZERO,negate,0,0,0,getColumn(func));
+            return;
+          }
+          accept=CMP_EQUAL;
+        }
+        emit(OP_COMPARE,negate|accept,eq->getVal(),0,eq->getTol(),getColumn(func));
+        return;
+      }
+      if(type==typeid(RANGE_TYPE)){
+        const RANGE_TYPE *range=static_cast<const RANGE_TYPE *>(query);
+        std::pair<bool,bool> open=range->getEndsOpen();
+        emit(OP_RANGE,negate|(open.first?LOWER_OPEN:0)|(open.second?UPPER_OPEN:0),
+             range->getLower(),range->getUpper(),range->getTol(),getColumn(func));
+        return;
+      }
+      if(type==typeid(SET_TYPE)){
+        const SET_TYPE *set=static_cast<const SET_TYPE *>(query);
+        // std::set iterates in order, so the values are sorted:
+        unsigned int start=d_setVals.size();
+        d_setVals.insert(d_setVals.end(),set->beginSet(),set->endSet());
+        emit(OP_SET,negate,start,set->size(),0,getColumn(func));
+        return;
+      }
+      if(type==typeid(QUERY_TYPE)){
+        bool (*matchFunc)(int)=query->getMatchFunc();
+        if(matchFunc==static_cast<bool (*)(int)>(nullQueryFun<int>)){
+          emit(OP_CONST,negate,1);
+        } else if(matchFunc){
+          emit(OP_MATCHFUNC,negate,d_matchFuncs.size(),0,0,getColumn(func));
+          d_matchFuncs.push_back(matchFunc);
+        } else {
+          emit(OP_NONZERO,negate,0,0,0,getColumn(func));
+        }
+        return;
+      }
+    }
+
+    // anything else is evaluated by the query itself (this takes care
+    // of the negation too). Any recursive queries below it still have
+    // to be matched before it is called:
+    addRecursiveChildren(query);
+    emit(OP_CALL,0,d_calls.size());
+    d_calls.push_back(query);
+  }
+
+  template <class T>
+  unsigned int QueryProgram<T>::addRecursive(QUERY_TYPE *query){
+    typename std::vector<QUERY_TYPE *>::const_iterator loc=std::find(d_recursive.begin(),
+                                                                     d_recursive.end(),query);
+    if(loc!=d_recursive.end()) return loc-d_recursive.begin();
+    d_recursive.push_back(query);
+    return d_recursive.size()-1;
+  }
+
+  template <class T>
+  void QueryProgram<T>::addRecursiveChildren(QUERY_TYPE *query){
+    for(typename QUERY_TYPE::CHILD_VECT_CI childIt=query->beginChildren();
+        childIt!=query->endChildren();++childIt){
+      if(typeid(*childIt->get())==typeid(RecursiveStructureQuery)){
+        addRecursive(childIt->get());
+      }
+      addRecursiveChildren(childIt->get());
+    }
+  }
+
+  template <class T>
+  bool QueryProgram<T>::match(unsigned int which,T const *what,
+                              QueryValueCache<T> &cache) const {
+    PRECONDITION(which<d_starts.size(),"bad query index");
+    PRECONDITION(what,"bad argument");
+    unsigned int idx=what->getIdx();
+    PRECONDITION(idx<cache.d_nItems,"bad index");
+
+    bool res=false;
+    unsigned int pc=d_starts[which];
+    while(true){
+      const Instruction &ins=d_code[pc++];
+      int value=0;
+      if(ins.op>=OP_COMPARE && ins.op<=OP_MATCHFUNC){
+        unsigned int pos=ins.column*cache.d_nItems+idx;
+        if(!cache.d_known[pos]){
+          cache.d_values[pos]=d_dataFuncs[ins.column](what);
+          cache.d_known[pos]=1;
+        }
+        value=cache.d_values[pos];
+      }
+      switch(ins.op){
+      case OP_END:
+        return res;
+      case OP_JUMP_IF_FALSE:
+        if(!res) pc=ins.val;
+        continue;
+      case OP_JUMP_IF_TRUE:
+        if(res) pc=ins.val;
+        continue;
+      case OP_NOT:
+        res=!res;
+        continue;
+      case OP_CONST:
+        res=ins.val;
+        break;
+      case OP_COMPARE:
+        {
+          int cmp=Queries::queryCmp(ins.val,value,ins.tol);
+          res=ins.flags & (cmp<0 ? CMP_LESS : (cmp>0 ? CMP_GREATER : CMP_EQUAL));
+        }
+        break;
+      case OP_RANGE:
+        {
+          int lCmp=Queries::queryCmp(ins.val,value,ins.tol);
+          int uCmp=Queries::queryCmp(ins.val2,value,ins.tol);
+          bool lowerRes=(ins.flags&LOWER_OPEN) ? lCmp<0 : lCmp<=0;
+          bool upperRes=(ins.flags&UPPER_OPEN) ? uCmp>0 : uCmp>=0;
+          res=lowerRes && upperRes;
+        }
+        break;
+      case OP_SET:
+        if(ins.val2){
+          const int *vals=&d_setVals[ins.val];
+          res=std::binary_search(vals,vals+ins.val2,value);
+        } else {
+          res=false;
+        }
+        break;
+      case OP_NONZERO:
+        res=(value!=0);
+        break;
+      case OP_MATCHFUNC:
+        res=d_matchFuncs[ins.val](value);
+        break;
+      case OP_RECURSIVE:
+        res=cache.d_recursiveHits[ins.val][idx];
+        break;
+      case OP_CALL:
+        res=d_calls[ins.val]->Match(what);
+        break;
+      default:
+        CHECK_INVARIANT(0,"bad opcode");
+      }
+      if(ins.flags&NEGATE) res=!res;
+    }
+  }
+
+  template class QueryProgram<Atom>;
+  template class QueryProgram<Bond>;
+
+  CompiledQueryMol::CompiledQueryMol(const ROMol &query) :
+    dp_query(&query),
+    d_atomQueries(query.getNumAtoms(),-1),
+    d_bondQueries(query.getNumBonds(),-1)
+  {
+    for(unsigned int i=0;i<query.getNumAtoms();++i){
+      const Atom *atom=query.getAtomWithIdx(i);
+      if(atom->hasQuery()){
+        d_atomQueries[i]=d_atomProgram.addQuery(atom->getQuery());
+      }
+    }
+    for(unsigned int i=0;i<query.getNumBonds();++i){
+      const Bond *bond=query.getBondWithIdx(i);
+      if(bond->hasQuery()){
+        d_bondQueries[i]=d_bondProgram.addQuery(bond->getQuery());
+      }
+    }
+    const std::vector<QueryProgram<Atom>::QUERY_TYPE *> &subqueries=
+      d_atomProgram.getRecursiveQueries();
+    for(unsigned int i=0;i<subqueries.size();++i){
+      const RecursiveStructureQuery *rsq=
+        static_cast<const RecursiveStructureQuery *>(subqueries[i]);
+      if(rsq->getQueryMol()){
+        d_recursive.push_back(boost::shared_ptr<CompiledQueryMol>(new CompiledQueryMol(*rsq->getQueryMol())));
+      } else {
+        d_recursive.push_back(boost::shared_ptr<CompiledQueryMol>());
+      }
+    }
+  }
+}
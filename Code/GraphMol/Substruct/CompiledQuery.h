@@ -0,0 +1,208 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_COMPILEDQUERY_H_
+#define _RD_COMPILEDQUERY_H_
+
+#include <GraphMol/RDKitBase.h>
+#include <GraphMol/RDKitQueries.h>
+#include <boost/cstdint.hpp>
+#include <boost/dynamic_bitset.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace RDKit{
+  /*! \file CompiledQuery.h
+
+    \brief atom and bond query trees lowered to flat programs
+
+    A query tree is evaluated by calling the virtual \c Match() of each
+    node, each of which calls its data function. A QueryProgram instead
+    holds a linear list of instructions:
+
+      - comparisons (==, <, <=, >, >=, ranges and sets) of the value of
+        a data function against constants
+      - jumps, which implement the short-circuiting of AND and OR nodes,
+        and NOT
+      - references to recursive structure queries, by index
+      - calls to the \c Match() of nodes that can't be compiled
+        (e.g. XOR nodes or classes we don't know about)
+
+    The values of the data functions are cached in a QueryValueCache,
+    so each data function is called at most once for each atom (or
+    bond) of the molecule being searched, no matter how many of the
+    queries use it.
+
+    A query node is only compiled if its type is exactly one of the
+    classes from Query/ (or AtomRingQuery or RecursiveStructureQuery),
+    so derived classes that override \c Match() are always called.
+  */
+
+  template <class T> class QueryValueCache;
+
+  //! a set of atom or bond queries compiled to a linear program
+  template <class T>
+  class QueryProgram {
+  public:
+    typedef Queries::Query<int,T const *,true> QUERY_TYPE;
+    typedef int (*DATA_FUNC)(T const *);
+
+    QueryProgram() {};
+
+    //! compiles a query and returns its index
+    /*!
+      The query is not copied, so it needs to stay around (and
+      unchanged) while the program is in use.
+    */
+    unsigned int addQuery(QUERY_TYPE *query);
+
+    //! returns whether or not query \c which matches \c what
+    /*!
+      \param which  the index of the query (returned by addQuery())
+      \param what   the atom or bond to be matched
+      \param cache  the cache for the molecule that \c what belongs to
+    */
+    bool match(unsigned int which,T const *what,QueryValueCache<T> &cache) const;
+
+    //! returns the number of queries
+    unsigned int getNumQueries() const { return d_starts.size(); };
+    //! returns the number of data functions used
+    unsigned int getNumColumns() const { return d_dataFuncs.size(); };
+    //! returns the recursive structure queries used, in the order they are
+    //! referenced
+    const std::vector<QUERY_TYPE *> &getRecursiveQueries() const { return d_recursive; };
+
+  private:
+    // the opcodes:
+    enum {
+      OP_END=0,
+      OP_JUMP_IF_FALSE,
+      OP_JUMP_IF_TRUE,
+      OP_NOT,
+      OP_CONST,
+      OP_COMPARE,
+      OP_RANGE,
+      OP_SET,
+      OP_NONZERO,
+      OP_MATCHFUNC,
+      OP_RECURSIVE,
+      OP_CALL
+    };
+    // the flags:
+    enum {
+      NEGATE=0x1,
+      LOWER_OPEN=0x2,
+      UPPER_OPEN=0x4,
+      // OP_COMPARE: which results of queryCmp(val,value,tol) are accepted
+      CMP_LESS=0x8,
+      CMP_EQUAL=0x10,
+      CMP_GREATER=0x20
+    };
+    struct Instruction {
+      boost::uint8_t op;
+      boost::uint8_t flags;
+      boost::uint16_t column;
+      int val;   // value, range lower bound, set start, table index or jump target
+      int val2;  // range upper bound or set size
+      int tol;
+    };
+
+    std::vector<Instruction> d_code;
+    std::vector<unsigned int> d_starts;
+    std::vector<DATA_FUNC> d_dataFuncs;
+    std::vector<int> d_setVals;
+    std::vector<bool (*)(int)> d_matchFuncs;
+    std::vector<const QUERY_TYPE *> d_calls;
+    std::vector<QUERY_TYPE *> d_recursive;
+
+    void compileNode(QUERY_TYPE *query);
+    unsigned int addRecursive(QUERY_TYPE *query);
+    void addRecursiveChildren(QUERY_TYPE *query);
+    void emit(boost::uint8_t op,boost::uint8_t flags=0,int val=0,int val2=0,
+              int tol=0,unsigned int column=0);
+    unsigned int getColumn(DATA_FUNC func);
+  };
+
+  //! the data function values and recursive query results for the atoms
+  //! (or bonds) of a molecule, used to evaluate a QueryProgram
+  template <class T>
+  class QueryValueCache {
+  public:
+    QueryValueCache(const QueryProgram<T> &program,unsigned int nItems) :
+      d_nItems(nItems),
+      d_values(program.getNumColumns()*nItems,0),
+      d_known(program.getNumColumns()*nItems,0),
+      d_recursiveHits(program.getRecursiveQueries().size(),
+                      boost::dynamic_bitset<>(nItems)) {};
+
+    //! sets the items matched by recursive query \c which
+    template <class Iterator>
+    void setRecursiveMatches(unsigned int which,Iterator begin,Iterator end){
+      PRECONDITION(which<d_recursiveHits.size(),"bad recursive query index");
+      boost::dynamic_bitset<> &hits=d_recursiveHits[which];
+      hits.reset();
+      while(begin!=end){
+        if(*begin>=0 && static_cast<unsigned int>(*begin)<d_nItems) hits.set(*begin);
+        ++begin;
+      }
+    }
+
+  private:
+    friend class QueryProgram<T>;
+    unsigned int d_nItems;
+    std::vector<int> d_values;
+    std::vector<char> d_known;
+    std::vector< boost::dynamic_bitset<> > d_recursiveHits;
+  };
+
+  //! the atom and bond queries of a query molecule, compiled
+  /*!
+    This compiles the queries of the molecule's atoms and bonds, and of
+    the molecules in its recursive queries. Use it with the
+    SubstructMatch() overloads that take a CompiledQueryMol to match
+    the same query against many molecules without evaluating the query
+    trees each time.
+
+    <b>Notes:</b>
+      - the query molecule is not copied, it must not be modified or
+        destroyed while the CompiledQueryMol is in use.
+  */
+  class CompiledQueryMol {
+  public:
+    explicit CompiledQueryMol(const ROMol &query);
+
+    //! returns the query molecule
+    const ROMol &getQuery() const { return *dp_query; };
+
+    //! returns the index of atom \c idx's query, -1 if it isn't a query atom
+    int getAtomQueryIdx(unsigned int idx) const { return d_atomQueries[idx]; };
+    //! returns the index of bond \c idx's query, -1 if it isn't a query bond
+    int getBondQueryIdx(unsigned int idx) const { return d_bondQueries[idx]; };
+
+    const QueryProgram<Atom> &getAtomProgram() const { return d_atomProgram; };
+    const QueryProgram<Bond> &getBondProgram() const { return d_bondProgram; };
+
+    //! returns the compiled molecule of recursive query \c which (this is
+    //! NULL if the query has no molecule)
+    const CompiledQueryMol *getRecursiveQuery(unsigned int which) const {
+      PRECONDITION(which<d_recursive.size(),"bad recursive query index");
+      return d_recursive[which].get();
+    };
+
+  private:
+    const ROMol *dp_query;
+    QueryProgram<Atom> d_atomProgram;
+    QueryProgram<Bond> d_bondProgram;
+    std::vector<int> d_atomQueries;
+    std::vector<int> d_bondQueries;
+    std::vector< boost::shared_ptr<CompiledQueryMol> > d_recursive;
+  };
+}
+
+#endif
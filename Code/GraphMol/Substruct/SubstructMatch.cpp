@@ -14,6 +14,7 @@
 #include <GraphMol/RDKitQueries.h>
 #include "SubstructMatch.h"
 #include "SubstructUtils.h"
+#include "CompiledQuery.h"
 #include <boost/smart_ptr.hpp>
 #include <map>
 #ifdef RDK_THREADSAFE_SSS
@@ -26,12 +27,14 @@
 namespace RDKit{
   namespace detail {
     typedef std::map<unsigned int,QueryAtom::QUERYATOM_QUERY *> SUBQUERY_MAP;
+    typedef std::vector<RecursiveStructureQuery *> LOCKED_QUERIES;
     
     void MatchSubqueries(const ROMol &mol,QueryAtom::QUERYATOM_QUERY *q,bool useChirality,
-			 SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches);
-#ifdef RDK_THREADSAFE_SSS
-    void ClearSubqueryLocks(QueryAtom::QUERYATOM_QUERY *q);
-#endif
+			 SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                         LOCKED_QUERIES &locked);
+    void MatchSubqueries(const ROMol &mol,const CompiledQueryMol &query,bool useChirality,
+			 SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                         LOCKED_QUERIES &locked);
     typedef std::list<std::pair<MolGraph::vertex_descriptor,MolGraph::vertex_descriptor> > ssPairType;
 
     class MolMatchFinalCheckFunctor {
@@ -133,9 +136,11 @@ namespace RDKit{
     class AtomLabelFunctor{
     public:
       AtomLabelFunctor(const ROMol &query,const ROMol &mol, bool useChirality,
-                       bool useQueryQueryMatches) :
+                       bool useQueryQueryMatches,const CompiledQueryMol *compiled=0,
+                       QueryValueCache<Atom> *cache=0) :
         d_query(query), d_mol(mol), df_useChirality(useChirality),
-        df_useQueryQueryMatches(useQueryQueryMatches) {};
+        df_useQueryQueryMatches(useQueryQueryMatches),
+        dp_compiled(compiled), dp_cache(cache) {};
       bool operator()(unsigned int i,unsigned int j) const{
         bool res=false;
         if(df_useChirality){
@@ -147,6 +152,15 @@ namespace RDKit{
                mAt->getChiralTag()!=Atom::CHI_TETRAHEDRAL_CCW) return false;
           }
         }
+        if(dp_compiled){
+          int which=dp_compiled->getAtomQueryIdx(i);
+          if(which>=0){
+            const Atom *mAt=d_mol.getAtomWithIdx(j);
+            if(!df_useQueryQueryMatches || !mAt->hasQuery()){
+              return dp_compiled->getAtomProgram().match(which,mAt,*dp_cache);
+            }
+          }
+        }
         res=atomCompat(d_query[i],d_mol[j],df_useQueryQueryMatches);
         return res;
       }
@@ -155,13 +169,24 @@ namespace RDKit{
       const ROMol &d_mol;
       bool df_useChirality;
       bool df_useQueryQueryMatches;
+      const CompiledQueryMol *dp_compiled;
+      QueryValueCache<Atom> *dp_cache;
     };
     class BondLabelFunctor{
     public:
-      BondLabelFunctor(const ROMol &query,const ROMol &mol,bool useChirality) :
-        d_query(query), d_mol(mol),df_useChirality(useChirality) {};
+      BondLabelFunctor(const ROMol &query,const ROMol &mol,bool useChirality,
+                       const CompiledQueryMol *compiled=0,QueryValueCache<Bond> *cache=0) :
+        d_query(query), d_mol(mol),df_useChirality(useChirality),
+        dp_compiled(compiled), dp_cache(cache) {};
       bool operator()(MolGraph::edge_descriptor i,MolGraph::edge_descriptor j) const{
-        bool res=bondCompat(d_query[i],d_mol[j]);
+        bool res;
+        int which=-1;
+        if(dp_compiled) which=dp_compiled->getBondQueryIdx(d_query[i]->getIdx());
+        if(which>=0 && !d_mol[j]->hasQuery()){
+          res=dp_compiled->getBondProgram().match(which,d_mol[j].get(),*dp_cache);
+        } else {
+          res=bondCompat(d_query[i],d_mol[j]);
+        }
         if(df_useChirality){
           const BOND_SPTR qBnd=d_query[i];
           if(qBnd->getBondType()==Bond::DOUBLE &&
@@ -181,65 +206,177 @@ namespace RDKit{
       const ROMol &d_query;
       const ROMol &d_mol;
       bool df_useChirality;
+      const CompiledQueryMol *dp_compiled;
+      QueryValueCache<Bond> *dp_cache;
     };
-  }    
-  
-  // ----------------------------------------------
-  //
-  // find one match
-  //
-  bool SubstructMatch(const ROMol &mol,const ROMol &query,MatchVectType &matchVect,
-                      bool recursionPossible,bool useChirality,bool useQueryQueryMatches)
-  {
 
-    //std::cerr<<"begin match"<<std::endl;
-    if(recursionPossible){
-      ROMol::ConstAtomIterator atIt;
-      detail::SUBQUERY_MAP subqueryMap;
-      for(atIt=query.beginAtoms();atIt!=query.endAtoms();atIt++){
-        if((*atIt)->getQuery()){
-	  detail::MatchSubqueries(mol,(*atIt)->getQuery(),useChirality,subqueryMap,
-                                  useQueryQueryMatches);
+    // releases the locks on the recursive queries that were matched
+    class SubqueryLocks {
+    public:
+      ~SubqueryLocks() {
+#ifdef RDK_THREADSAFE_SSS
+        for(LOCKED_QUERIES::iterator it=locked.begin();it!=locked.end();++it){
+          //std::cerr<<"unlock: "<<*it<<std::endl;
+          (*it)->d_mutex.unlock();
+        }
+#endif
+      }
+      LOCKED_QUERIES locked;
+    };
+
+    // the caches used to evaluate a compiled query against a molecule
+    class CompiledQueryCaches {
+    public:
+      CompiledQueryCaches(const ROMol &mol,const CompiledQueryMol &compiled) :
+        atomCache(compiled.getAtomProgram(),mol.getNumAtoms()),
+        bondCache(compiled.getBondProgram(),mol.getNumBonds()) {
+        const std::vector<QueryProgram<Atom>::QUERY_TYPE *> &subqueries=
+          compiled.getAtomProgram().getRecursiveQueries();
+        for(unsigned int i=0;i<subqueries.size();++i){
+          const RecursiveStructureQuery *rsq=
+            static_cast<const RecursiveStructureQuery *>(subqueries[i]);
+          atomCache.setRecursiveMatches(i,rsq->beginSet(),rsq->endSet());
+        }
+      }
+      QueryValueCache<Atom> atomCache;
+      QueryValueCache<Bond> bondCache;
+    };
+
+    void MatchAllSubqueries(const ROMol &mol,const ROMol &query,const CompiledQueryMol *compiled,
+                            bool useChirality,SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                            LOCKED_QUERIES &locked){
+      if(compiled){
+        MatchSubqueries(mol,*compiled,useChirality,subqueryMap,useQueryQueryMatches,locked);
+      } else {
+        ROMol::ConstAtomIterator atIt;
+        for(atIt=query.beginAtoms();atIt!=query.endAtoms();atIt++){
+          if((*atIt)->getQuery()){
+            MatchSubqueries(mol,(*atIt)->getQuery(),useChirality,subqueryMap,
+                            useQueryQueryMatches,locked);
+          }
         }
       }
     }
-    //std::cerr<<"main matching"<<std::endl;
+  }    
+  
+  namespace detail {
+    unsigned int RecursiveMatcher(const ROMol &mol,const ROMol &query,
+                                  const CompiledQueryMol *compiled,
+				  std::vector< int > &matches,bool useChirality,
+				  SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                                  LOCKED_QUERIES &locked);
+
+    bool SubstructMatchOne(const ROMol &mol,const ROMol &query,const CompiledQueryMol *compiled,
+                           MatchVectType &matchVect,bool recursionPossible,bool useChirality,
+                           bool useQueryQueryMatches){
+      //std::cerr<<"begin match"<<std::endl;
+      SubqueryLocks locks;
+      if(recursionPossible){
+        SUBQUERY_MAP subqueryMap;
+        MatchAllSubqueries(mol,query,compiled,useChirality,subqueryMap,
+                           useQueryQueryMatches,locks.locked);
+      }
+      boost::scoped_ptr<CompiledQueryCaches> caches;
+      if(compiled) caches.reset(new CompiledQueryCaches(mol,*compiled));
+      //std::cerr<<"main matching"<<std::endl;
 
-    matchVect.clear();
-    matchVect.resize(0);
+      matchVect.clear();
+      matchVect.resize(0);
 
-    detail::MolMatchFinalCheckFunctor matchChecker(query,mol,useChirality);
-    detail::AtomLabelFunctor atomLabeler(query,mol,useChirality,useQueryQueryMatches);
-    detail::BondLabelFunctor bondLabeler(query,mol,useChirality);
+      MolMatchFinalCheckFunctor matchChecker(query,mol,useChirality);
+      AtomLabelFunctor atomLabeler(query,mol,useChirality,useQueryQueryMatches,compiled,
+                                   caches ? &caches->atomCache : 0);
+      BondLabelFunctor bondLabeler(query,mol,useChirality,compiled,
+                                   caches ? &caches->bondCache : 0);
 
-    detail::ssPairType match;
+      ssPairType match;
 #if 0
-    bool res=boost::ullmann(query.getTopology(),mol.getTopology(),
-                            atomLabeler,bondLabeler,match);
+      bool res=boost::ullmann(query.getTopology(),mol.getTopology(),
+                              atomLabeler,bondLabeler,match);
 #else
-    bool res=boost::vf2(query.getTopology(),mol.getTopology(),
-                        atomLabeler,bondLabeler,matchChecker,match);
+      bool res=boost::vf2(query.getTopology(),mol.getTopology(),
+                          atomLabeler,bondLabeler,matchChecker,match);
 #endif
-    if(res){
-     matchVect.resize(query.getNumAtoms());
-     for(detail::ssPairType::const_iterator iter=match.begin();iter!=match.end();++iter){
-       matchVect[iter->first]=std::pair<int,int>(iter->first,iter->second);
-     }
-    }    
-
-#ifdef RDK_THREADSAFE_SSS
-    if(recursionPossible){
-      ROMol::ConstAtomIterator atIt;
-      for(atIt=query.beginAtoms();atIt!=query.endAtoms();atIt++){
-        if((*atIt)->getQuery()){
-	  detail::ClearSubqueryLocks((*atIt)->getQuery());
+      if(res){
+        matchVect.resize(query.getNumAtoms());
+        for(ssPairType::const_iterator iter=match.begin();iter!=match.end();++iter){
+          matchVect[iter->first]=std::pair<int,int>(iter->first,iter->second);
         }
-      }
+      }    
+      return res;
     }
+
+    unsigned int SubstructMatchAll(const ROMol &mol,const ROMol &query,
+                                   const CompiledQueryMol *compiled,
+                                   std::vector< MatchVectType > &matches,
+                                   bool uniquify,bool recursionPossible,
+                                   bool useChirality,bool useQueryQueryMatches,
+                                   unsigned int maxMatches){
+      SubqueryLocks locks;
+      if(recursionPossible){
+        SUBQUERY_MAP subqueryMap;
+        MatchAllSubqueries(mol,query,compiled,useChirality,subqueryMap,
+                           useQueryQueryMatches,locks.locked);
+      }
+      boost::scoped_ptr<CompiledQueryCaches> caches;
+      if(compiled) caches.reset(new CompiledQueryCaches(mol,*compiled));
+
+      matches.clear();
+      matches.resize(0);
+
+      AtomLabelFunctor atomLabeler(query,mol,useChirality,useQueryQueryMatches,compiled,
+                                   caches ? &caches->atomCache : 0);
+      BondLabelFunctor bondLabeler(query,mol,useChirality,compiled,
+                                   caches ? &caches->bondCache : 0);
+      MolMatchFinalCheckFunctor matchChecker(query,mol,useChirality);
+    
+      std::list<ssPairType> pms;
+#if 0
+      bool found=boost::ullmann_all(query.getTopology(),mol.getTopology(),
+                                    atomLabeler,bondLabeler,pms);
+#else
+      bool found=boost::vf2_all(query.getTopology(),mol.getTopology(),
+                                atomLabeler,bondLabeler,matchChecker,pms,maxMatches,
+                                uniquify);
 #endif
-    return res;
+      unsigned int res=0;
+      if(found){
+        unsigned int nQueryAtoms=query.getNumAtoms();
+        matches.reserve(pms.size());
+        for(std::list<ssPairType>::const_iterator iter1=pms.begin();
+            iter1!=pms.end();++iter1){
+          MatchVectType matchVect;
+          matchVect.resize(nQueryAtoms);
+          for(ssPairType::const_iterator iter2=iter1->begin();
+              iter2!=iter1->end();++iter2){
+            matchVect[iter2->first]=std::pair<int,int>(iter2->first,iter2->second);
+          }
+          matches.push_back(matchVect);
+        }
+        // the matches were uniquified (and maxMatches applied to the
+        // unique matches) during the search
+        res = matches.size();
+      } 
+      return res;
+    }
   }
 
+  // ----------------------------------------------
+  //
+  // find one match
+  //
+  bool SubstructMatch(const ROMol &mol,const ROMol &query,MatchVectType &matchVect,
+                      bool recursionPossible,bool useChirality,bool useQueryQueryMatches)
+  {
+    return detail::SubstructMatchOne(mol,query,0,matchVect,recursionPossible,
+                                     useChirality,useQueryQueryMatches);
+  }
+  bool SubstructMatch(const ROMol &mol,const CompiledQueryMol &query,MatchVectType &matchVect,
+                      bool recursionPossible,bool useChirality,bool useQueryQueryMatches)
+  {
+    return detail::SubstructMatchOne(mol,query.getQuery(),&query,matchVect,recursionPossible,
+                                     useChirality,useQueryQueryMatches);
+  }
 
   // ----------------------------------------------
   //
@@ -250,83 +387,37 @@ namespace RDKit{
   unsigned int SubstructMatch(const ROMol &mol,const ROMol &query,
 			      std::vector< MatchVectType > &matches,
 			      bool uniquify,bool recursionPossible,
-			      bool useChirality,bool useQueryQueryMatches){
-
-    if(recursionPossible){
-      detail::SUBQUERY_MAP subqueryMap;
-      ROMol::ConstAtomIterator atIt;
-      for(atIt=query.beginAtoms();atIt!=query.endAtoms();atIt++){
-        if((*atIt)->getQuery()){
-          //std::cerr<<"recurse from atom "<<(*atIt)->getIdx()<<std::endl;
-	  detail::MatchSubqueries(mol,(*atIt)->getQuery(),useChirality,subqueryMap,
-                                  useQueryQueryMatches);
-        }
-      }
-    }
-
-    matches.clear();
-    matches.resize(0);
-
-    detail::AtomLabelFunctor atomLabeler(query,mol,useChirality,useQueryQueryMatches);
-    detail::BondLabelFunctor bondLabeler(query,mol,useChirality);
-    detail::MolMatchFinalCheckFunctor matchChecker(query,mol,useChirality);
-    
-    std::list<detail::ssPairType> pms;
-#if 0
-    bool found=boost::ullmann_all(query.getTopology(),mol.getTopology(),
-                                  atomLabeler,bondLabeler,pms);
-#else
-    bool found=boost::vf2_all(query.getTopology(),mol.getTopology(),
-                              atomLabeler,bondLabeler,matchChecker,pms);
-#endif
-    unsigned int res=0;
-    if(found){
-      unsigned int nQueryAtoms=query.getNumAtoms();
-      matches.reserve(pms.size());
-      for(std::list<detail::ssPairType>::const_iterator iter1=pms.begin();
-          iter1!=pms.end();++iter1){
-        MatchVectType matchVect;
-        matchVect.resize(nQueryAtoms);
-        for(detail::ssPairType::const_iterator iter2=iter1->begin();
-            iter2!=iter1->end();++iter2){
-          matchVect[iter2->first]=std::pair<int,int>(iter2->first,iter2->second);
-        }
-        matches.push_back(matchVect);
-      }
-      if(uniquify){
-        removeDuplicates(matches,mol.getNumAtoms());
-      }
-      res = matches.size();
-    } 
-
-#ifdef RDK_THREADSAFE_SSS
-    if(recursionPossible){
-      ROMol::ConstAtomIterator atIt;
-      for(atIt=query.beginAtoms();atIt!=query.endAtoms();atIt++){
-        if((*atIt)->getQuery()){
-	  detail::ClearSubqueryLocks((*atIt)->getQuery());
-        }
-      }
-    }
-#endif
-    return res;
+			      bool useChirality,bool useQueryQueryMatches,
+                              unsigned int maxMatches){
+    return detail::SubstructMatchAll(mol,query,0,matches,uniquify,recursionPossible,
+                                     useChirality,useQueryQueryMatches,maxMatches);
+  }
+  unsigned int SubstructMatch(const ROMol &mol,const CompiledQueryMol &query,
+			      std::vector< MatchVectType > &matches,
+			      bool uniquify,bool recursionPossible,
+			      bool useChirality,bool useQueryQueryMatches,
+                              unsigned int maxMatches){
+    return detail::SubstructMatchAll(mol,query.getQuery(),&query,matches,uniquify,
+                                     recursionPossible,useChirality,useQueryQueryMatches,
+                                     maxMatches);
   }
 
   namespace detail {
     unsigned int RecursiveMatcher(const ROMol &mol,const ROMol &query,
+                                  const CompiledQueryMol *compiled,
 				  std::vector< int > &matches,bool useChirality,
-				  SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches)
+				  SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                                  LOCKED_QUERIES &locked)
     {
-      ROMol::ConstAtomIterator atIt;
-      for(atIt=query.beginAtoms();atIt!=query.endAtoms();atIt++){
-	if((*atIt)->getQuery()){
-	  MatchSubqueries(mol,(*atIt)->getQuery(),useChirality,subqueryMap,
-                          useQueryQueryMatches);
-	}
-      }
+      MatchAllSubqueries(mol,query,compiled,useChirality,subqueryMap,
+                         useQueryQueryMatches,locked);
+      boost::scoped_ptr<CompiledQueryCaches> caches;
+      if(compiled) caches.reset(new CompiledQueryCaches(mol,*compiled));
  
-      detail::AtomLabelFunctor atomLabeler(query,mol,useChirality,useQueryQueryMatches);
-      detail::BondLabelFunctor bondLabeler(query,mol,useChirality);
+      detail::AtomLabelFunctor atomLabeler(query,mol,useChirality,useQueryQueryMatches,
+                                           compiled,caches ? &caches->atomCache : 0);
+      detail::BondLabelFunctor bondLabeler(query,mol,useChirality,compiled,
+                                           caches ? &caches->bondCache : 0);
       detail::MolMatchFinalCheckFunctor matchChecker(query,mol,useChirality);
 
       matches.clear();
@@ -369,89 +460,88 @@ namespace RDKit{
       return res;
     }
 
+    // matches a single recursive query, compiled is the compiled form of
+    // its molecule (if there is one)
+    void MatchSubquery(const ROMol &mol,RecursiveStructureQuery *rsq,
+                       const CompiledQueryMol *compiled,bool useChirality,
+                       SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                       LOCKED_QUERIES &locked){
+      //std::cerr<<"lock: "<<rsq<<std::endl;
+#ifdef RDK_THREADSAFE_SSS
+      rsq->d_mutex.lock();
+      locked.push_back(rsq);
+#endif
+      rsq->clear();
+      bool matchDone=false;
+      if(rsq->getSerialNumber() &&
+         subqueryMap.find(rsq->getSerialNumber()) != subqueryMap.end()){
+        // we've matched an equivalent serial number before, just
+        // copy in the matches:
+        matchDone=true;
+        const RecursiveStructureQuery *orsq=
+          (const RecursiveStructureQuery *)subqueryMap[rsq->getSerialNumber()];
+        for(RecursiveStructureQuery::CONTAINER_TYPE::const_iterator setIter=orsq->beginSet();
+            setIter!=orsq->endSet();++setIter){
+          rsq->insert(*setIter);
+        }
+        //std::cerr<<" copying results for query serial number: "<<rsq->getSerialNumber()<<std::endl;
+      }
+	
+      if(!matchDone){
+        ROMol const *queryMol = rsq->getQueryMol();
+        // in case we are reusing this query, clear its contents now.
+        if(queryMol){
+          std::vector< int > matchStarts;
+          unsigned int res = RecursiveMatcher(mol,*queryMol,compiled,matchStarts,useChirality,
+                                              subqueryMap,useQueryQueryMatches,locked);
+          if(res){
+            for(std::vector<int>::iterator i=matchStarts.begin();
+                i!=matchStarts.end();
+                i++){
+              rsq->insert(*i);
+            }
+          }
+        }
+        if(rsq->getSerialNumber()){
+          subqueryMap[rsq->getSerialNumber()]=rsq;
+          //std::cerr<<" storing results for query serial number: "<<rsq->getSerialNumber()<<std::endl;
+        }
+      }
+    }
+
     void MatchSubqueries(const ROMol &mol,QueryAtom::QUERYATOM_QUERY *query,bool useChirality,
-			 SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches){
+			 SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                         LOCKED_QUERIES &locked){
       PRECONDITION(query,"bad query");
       //std::cout << "*-*-* MS: " << (int)query << std::endl;
       //std::cout << "\t\t" << typeid(*query).name() << std::endl;
       if(query->getDescription()=="RecursiveStructure"){
-	RecursiveStructureQuery *rsq=(RecursiveStructureQuery *)query;
-        //std::cerr<<"lock: "<<rsq<<std::endl;
-#ifdef RDK_THREADSAFE_SSS
-        rsq->d_mutex.lock();
-#endif
-	rsq->clear();
-	bool matchDone=false;
-	if(rsq->getSerialNumber() &&
-	   subqueryMap.find(rsq->getSerialNumber()) != subqueryMap.end()){
-	  // we've matched an equivalent serial number before, just
-	  // copy in the matches:
-	  matchDone=true;
-	  const RecursiveStructureQuery *orsq=
-	    (const RecursiveStructureQuery *)subqueryMap[rsq->getSerialNumber()];
-	  for(RecursiveStructureQuery::CONTAINER_TYPE::const_iterator setIter=orsq->beginSet();
-	      setIter!=orsq->endSet();++setIter){
-	    rsq->insert(*setIter);
-	  }
-	  //std::cerr<<" copying results for query serial number: "<<rsq->getSerialNumber()<<std::endl;
-	}
-	
-	if(!matchDone){
-	  ROMol const *queryMol = rsq->getQueryMol();
-	  // in case we are reusing this query, clear its contents now.
-	  if(queryMol){
-	    std::vector< int > matchStarts;
-	    unsigned int res = RecursiveMatcher(mol,*queryMol,matchStarts,useChirality,
-						subqueryMap,useQueryQueryMatches);
-	    if(res){
-	      for(std::vector<int>::iterator i=matchStarts.begin();
-		  i!=matchStarts.end();
-		  i++){
-		rsq->insert(*i);
-	      }
-	    }
-	  }
-	  if(rsq->getSerialNumber()){
-	    subqueryMap[rsq->getSerialNumber()]=query;
-	    //std::cerr<<" storing results for query serial number: "<<rsq->getSerialNumber()<<std::endl;
-	  }
-
-	}
-      } else {
-	//std::cout << "\tmsq1: "; 
+	MatchSubquery(mol,(RecursiveStructureQuery *)query,0,useChirality,subqueryMap,
+                      useQueryQueryMatches,locked);
       }
   
       // now recurse over our children (these things can be nested)
       Queries::Query<int,Atom const*,true>::CHILD_VECT_CI childIt;
       //std::cout << query << " " << query->endChildren()-query->beginChildren() <<  std::endl;
       for(childIt=query->beginChildren();childIt!=query->endChildren();childIt++){
-	MatchSubqueries(mol,childIt->get(),useChirality,subqueryMap,useQueryQueryMatches);
+	MatchSubqueries(mol,childIt->get(),useChirality,subqueryMap,useQueryQueryMatches,locked);
       }
       //std::cout << "<<- back " << (int)query << std::endl;
     }
 
-#ifdef RDK_THREADSAFE_SSS
-    void ClearSubqueryLocks(QueryAtom::QUERYATOM_QUERY *query){
-      PRECONDITION(query,"bad query");
-      if(query->getDescription()=="RecursiveStructure"){
-	RecursiveStructureQuery *rsq=(RecursiveStructureQuery *)query;
-        //std::cerr<<"unlock: "<<rsq<<std::endl;
-        rsq->d_mutex.unlock();
-        for(ROMol::ConstAtomIterator atIt=rsq->getQueryMol()->beginAtoms();
-            atIt!=rsq->getQueryMol()->endAtoms();atIt++){
-          if((*atIt)->getQuery()){
-            ClearSubqueryLocks((*atIt)->getQuery());
-          }
-        }
-      }
-
-      // now recurse over our children (these things can be nested)
-      for(Queries::Query<int,Atom const*,true>::CHILD_VECT_CI childIt=query->beginChildren();
-          childIt!=query->endChildren();childIt++){
-	ClearSubqueryLocks(childIt->get());
+    // the compiled query already has a list of its recursive queries, in
+    // the order they appear in the query trees
+    void MatchSubqueries(const ROMol &mol,const CompiledQueryMol &query,bool useChirality,
+			 SUBQUERY_MAP &subqueryMap,bool useQueryQueryMatches,
+                         LOCKED_QUERIES &locked){
+      const std::vector<QueryProgram<Atom>::QUERY_TYPE *> &subqueries=
+        query.getAtomProgram().getRecursiveQueries();
+      for(unsigned int i=0;i<subqueries.size();++i){
+        MatchSubquery(mol,static_cast<RecursiveStructureQuery *>(subqueries[i]),
+                      query.getRecursiveQuery(i),useChirality,subqueryMap,
+                      useQueryQueryMatches,locked);
       }
     }
-#endif
   } // end of namespace detail
 }
 
@@ -17,6 +17,7 @@ namespace RDKit{
   class ROMol;
   class Atom;
   class Bond;
+  class CompiledQueryMol;
 
   //! \brief used to return matches from substructure searching,
   //!   The format is (queryAtomIdx, molAtomIdx)
@@ -53,6 +54,9 @@ namespace RDKit{
       \param useChirality  use atomic CIP codes as part of the comparison
       \param useQueryQueryMatches  if set, the contents of atom queries will be
                                    used as part of the matching
+      \param maxMatches  the search stops after this many matches have been
+                         found (after uniquification, if that is enabled),
+                         zero means no limit
 
       \return the number of matches found
     
@@ -61,7 +65,30 @@ namespace RDKit{
 			      std::vector< MatchVectType > &matchVect,
 			      bool uniquify=true,bool recursionPossible=true,
 			      bool useChirality=false,
-                              bool useQueryQueryMatches=false);
+                              bool useQueryQueryMatches=false,
+                              unsigned int maxMatches=0);
+
+  //! \overload
+  /*!
+    Uses a query that has already been compiled, see CompiledQuery.h.
+    This is faster when the same query is used to search many molecules.
+  */
+  bool SubstructMatch(const ROMol &mol,const CompiledQueryMol &query,
+		      MatchVectType &matchVect,
+		      bool recursionPossible=true,
+		      bool useChirality=false,
+                      bool useQueryQueryMatches=false);
+  //! \overload
+  /*!
+    Uses a query that has already been compiled, see CompiledQuery.h.
+    This is faster when the same query is used to search many molecules.
+  */
+  unsigned int SubstructMatch(const ROMol &mol,const CompiledQueryMol &query,
+			      std::vector< MatchVectType > &matchVect,
+			      bool uniquify=true,bool recursionPossible=true,
+			      bool useChirality=false,
+                              bool useQueryQueryMatches=false,
+                              unsigned int maxMatches=0);
 }
 
 #endif
@@ -18,6 +18,7 @@
 #include <GraphMol/RDKitQueries.h>
 #include "SubstructMatch.h"
 #include "SubstructUtils.h"
+#include "CompiledQuery.h"
 
 #include <GraphMol/SmilesParse/SmilesParse.h>
 #include <GraphMol/FileParsers/FileParsers.h>
@@ -1018,6 +1019,184 @@ void testGitHubIssue15(){
 
   BOOST_LOG(rdErrorLog) << "  done" << std::endl;
 }
+
+void testMaxMatches(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test maxMatches" << std::endl;
+
+  {
+    ROMol *query=SmartsToMol("c1ccccc1");
+    ROMol *mol=SmilesToMol("c1ccccc1-c1ccccc1");
+    std::vector< MatchVectType > matches;
+    unsigned int n=SubstructMatch(*mol,*query,matches,false);
+    TEST_ASSERT(n==24);
+    n=SubstructMatch(*mol,*query,matches,false,true,false,false,5);
+    TEST_ASSERT(n==5);
+    TEST_ASSERT(matches.size()==5);
+    for(unsigned int i=0;i<matches.size();++i){
+      TEST_ASSERT(matches[i].size()==6);
+    }
+    // the limit is applied to the unique matches:
+    n=SubstructMatch(*mol,*query,matches,true,true,false,false,1);
+    TEST_ASSERT(n==1);
+    n=SubstructMatch(*mol,*query,matches,true,true,false,false,2);
+    TEST_ASSERT(n==2);
+    TEST_ASSERT(matches[0][0].second!=matches[1][0].second);
+    n=SubstructMatch(*mol,*query,matches,true,true,false,false,100);
+    TEST_ASSERT(n==2);
+    delete query;
+    delete mol;
+  }
+  {
+    // a query atom that can't be matched at all:
+    ROMol *query=SmartsToMol("c1ccccc1[Br]");
+    ROMol *mol=SmilesToMol("c1ccccc1-c1ccccc1");
+    std::vector< MatchVectType > matches;
+    TEST_ASSERT(!SubstructMatch(*mol,*query,matches));
+    delete query;
+    delete mol;
+  }
+  {
+    // disconnected queries:
+    ROMol *query=SmartsToMol("O.N");
+    ROMol *mol=SmilesToMol("OCC(N)CO");
+    std::vector< MatchVectType > matches;
+    TEST_ASSERT(SubstructMatch(*mol,*query,matches)==2);
+    TEST_ASSERT(SubstructMatch(*mol,*query,matches,true,true,false,false,1)==1);
+    TEST_ASSERT(matches[0][1].second==3);
+    delete query;
+    delete mol;
+  }
+  {
+    // the order the matches are found in:
+    ROMol *query=SmilesToMol("CCO");
+    ROMol *mol=SmilesToMol("OCCO");
+    MatchVectType match;
+    TEST_ASSERT(SubstructMatch(*mol,*query,match));
+    TEST_ASSERT(match.size()==3);
+    TEST_ASSERT(match[0].second==1);
+    TEST_ASSERT(match[1].second==2);
+    TEST_ASSERT(match[2].second==3);
+    std::vector< MatchVectType > matches;
+    TEST_ASSERT(SubstructMatch(*mol,*query,matches,false)==2);
+    TEST_ASSERT(matches[0]==match);
+    TEST_ASSERT(matches[1][0].second==2);
+    TEST_ASSERT(matches[1][1].second==1);
+    TEST_ASSERT(matches[1][2].second==0);
+    TEST_ASSERT(SubstructMatch(*mol,*query,matches,false,true,false,false,1)==1);
+    TEST_ASSERT(matches[0]==match);
+    delete query;
+    delete mol;
+  }
+
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+void testCompiledQueries(){
+  BOOST_LOG(rdErrorLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdErrorLog) << "    Test compiled queries" << std::endl;
+
+  {
+    std::string smas[]={"[C,N;!R]=O","[#6;X3;H1,H2]","[!#6;!#1;+0]","[N;H2,H3;+0]C(=O)",
+                        "[$(C=O);!$(C(=O)O)]","[$([OH1][CX4][$(C~[!#6])])]","[R2]~[R1]",
+                        "[r5,r6;a]:[a;x2]","[n;H1]","c-[Cl,Br,I]","[#7;v3,v4]",
+                        "[*;D3;!R]-,=[#8]","[13C]","[C-,N-,O-]","[$(*=O)&!$(C(=O)N)]-,:*",
+                        "[^2;#6]","[#6]!@[#6]","[a;!c]","[O;X2;H0]([#6])[#6]","*"};
+    std::string smis[]={"CC(=O)Nc1ccc(O)cc1","OC(=O)C1CCCN1","c1ccc2[nH]ccc2c1",
+                        "C[N+](C)(C)CC(=O)[O-]","[13CH3]OC(=O)c1ccccc1Cl","NC(=O)CCCN",
+                        "C1CC2CCC1C2","O=C1NC(=O)c2ccccc21","CCOCC","Brc1cncc(I)c1"};
+    unsigned int nSma=sizeof(smas)/sizeof(smas[0]);
+    unsigned int nSmi=sizeof(smis)/sizeof(smis[0]);
+    for(unsigned int i=0;i<nSma;++i){
+      ROMol *query=SmartsToMol(smas[i]);
+      TEST_ASSERT(query);
+      CompiledQueryMol compiled(*query);
+      for(unsigned int j=0;j<nSmi;++j){
+        ROMol *mol=SmilesToMol(smis[j]);
+        TEST_ASSERT(mol);
+        std::vector< MatchVectType > m1,m2;
+        unsigned int n1=SubstructMatch(*mol,*query,m1,false);
+        unsigned int n2=SubstructMatch(*mol,compiled,m2,false);
+        TEST_ASSERT(n1==n2);
+        TEST_ASSERT(m1==m2);
+        MatchVectType mv1,mv2;
+        TEST_ASSERT(SubstructMatch(*mol,*query,mv1)==SubstructMatch(*mol,compiled,mv2));
+        TEST_ASSERT(mv1==mv2);
+        delete mol;
+      }
+      delete query;
+    }
+  }
+
+  {
+    // query types the SMARTS parser doesn't generate:
+    ROMol *mol=SmilesToMol("CC(C)(C)CCO");
+    TEST_ASSERT(mol);
+    RWMol query;
+    QueryAtom qa;
+    ATOM_RANGE_QUERY *range=new ATOM_RANGE_QUERY(1,4);
+    range->setDataFunc(queryAtomExplicitDegree);
+    range->setEndsOpen(false,true);
+    qa.setQuery(range);
+    query.addAtom(&qa);
+    CompiledQueryMol compiled(query);
+    std::vector< MatchVectType > matches;
+    // the upper end of the range is open, so the quaternary C doesn't match:
+    TEST_ASSERT(SubstructMatch(*mol,query,matches)==6);
+    TEST_ASSERT(SubstructMatch(*mol,compiled,matches)==6);
+
+    // the query is copied when the atom is added:
+    range=new ATOM_RANGE_QUERY(1,4);
+    range->setDataFunc(queryAtomExplicitDegree);
+    range->setEndsOpen(false,false);
+    query.getAtomWithIdx(0)->setQuery(range);
+    CompiledQueryMol compiled2(query);
+    TEST_ASSERT(SubstructMatch(*mol,query,matches)==7);
+    TEST_ASSERT(SubstructMatch(*mol,compiled2,matches)==7);
+
+    ATOM_GREATER_QUERY *greater=makeAtomSimpleQuery<ATOM_GREATER_QUERY>(2,queryAtomExplicitDegree);
+    greater->setNegation(true);
+    query.getAtomWithIdx(0)->setQuery(greater);
+    CompiledQueryMol compiled3(query);
+    // not (2 > degree), i.e. degree>=2:
+    TEST_ASSERT(SubstructMatch(*mol,query,matches)==3);
+    TEST_ASSERT(SubstructMatch(*mol,compiled3,matches)==3);
+
+    // XOR is handled by the query itself:
+    ATOM_XOR_QUERY *xorq=new ATOM_XOR_QUERY;
+    xorq->addChild(QueryAtom::QUERYATOM_QUERY::CHILD_TYPE(makeAtomNumQuery(8)));
+    xorq->addChild(QueryAtom::QUERYATOM_QUERY::CHILD_TYPE(makeAtomExplicitDegreeQuery(1)));
+    query.getAtomWithIdx(0)->setQuery(xorq);
+    CompiledQueryMol compiled4(query);
+    TEST_ASSERT(SubstructMatch(*mol,query,matches)==3);
+    TEST_ASSERT(SubstructMatch(*mol,compiled4,matches)==3);
+    delete mol;
+  }
+
+  {
+    // recursive queries below a query that is called rather than
+    // compiled still need to be matched:
+    ROMol *mol=SmilesToMol("CC(=O)OC");
+    TEST_ASSERT(mol);
+    RWMol query;
+    QueryAtom qa;
+    ATOM_XOR_QUERY *xorq=new ATOM_XOR_QUERY;
+    xorq->addChild(QueryAtom::QUERYATOM_QUERY::CHILD_TYPE(new RecursiveStructureQuery(SmartsToMol("C=O"))));
+    xorq->addChild(QueryAtom::QUERYATOM_QUERY::CHILD_TYPE(makeAtomNumQuery(6)));
+    qa.setQuery(xorq);
+    query.addAtom(&qa);
+    CompiledQueryMol compiled(query);
+    TEST_ASSERT(compiled.getAtomProgram().getRecursiveQueries().size()==1);
+    std::vector< MatchVectType > m1,m2;
+    // the two methyl carbons:
+    TEST_ASSERT(SubstructMatch(*mol,query,m1)==2);
+    TEST_ASSERT(SubstructMatch(*mol,compiled,m2)==2);
+    TEST_ASSERT(m1==m2);
+    delete mol;
+  }
+
+  BOOST_LOG(rdErrorLog) << "  done" << std::endl;
+}
+
 int main(int argc,char *argv[])
 {
 #if 1
@@ -1037,6 +1216,8 @@ int main(int argc,char *argv[])
   testCisTransMatch();
 #endif
   testGitHubIssue15();
+  testMaxMatches();
+  testCompiledQueries();
   return 0;
 }
 
@@ -0,0 +1,136 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+
+#define NO_IMPORT_ARRAY
+#include <boost/python.hpp>
+#include <string>
+
+//ours
+#include <GraphMol/FileParsers/BlockGzip.h>
+#include <GraphMol/RDKitBase.h>
+#include <RDBoost/PySequenceHolder.h>
+
+#include "MolSupplier.h"
+
+namespace python = boost::python;
+
+namespace RDKit {
+  void SetBlockGzipSDWriterProps(BlockGzipSDWriter &writer, python::object props) {
+    STR_VECT propNames;
+    PySequenceHolder<std::string> seq(props);
+    for (unsigned int i = 0; i < seq.size(); i++) {
+      propNames.push_back(seq[i]);
+    }
+    writer.setProps(propNames);
+  }
+  void WriteMolToBlockGzipSD(BlockGzipSDWriter &writer, ROMol &mol, int confId) {
+    writer.write(mol, confId);
+  }
+
+  std::string bgzSDMolSupplierClassDoc="A class which supplies molecules from a block-compressed SD file.\n \
+\n \
+  Block-compressed files are written with a BlockGzipSDWriter. They can be\n \
+  read by regular gzip tools, but consist of independently compressed blocks,\n \
+  so the supplier can decompress blocks ahead of the parser on several threads\n \
+  and only needs to decompress one block for random access.\n \
+\n \
+  Usage examples:\n \
+\n \
+    1) Lazy evaluation: the molecules are not constructed until we ask for them:\n \
+       >>> suppl = BlockGzipSDMolSupplier('in.sdf.gz',numThreads=4)\n \
+       >>> for mol in suppl:\n \
+       ...    mol.GetNumAtoms()\n \
+\n \
+    2) Random Access:\n \
+       >>> suppl = BlockGzipSDMolSupplier('in.sdf.gz')\n \
+       >>> mol = suppl[1000] \n \
+       NOTE: this will generate an IndexError if the supplier doesn't have that many\n \
+       molecules.\n \
+\n \
+  Properties in the SD file are used to set properties on each molecule.\n\
+  The properties are accessible using the mol.GetProp(propName) method.\n\
+\n";
+  struct blockgzip_wrap {
+    static void wrap() {
+      python::class_<BlockGzipSDMolSupplier,boost::noncopyable>("BlockGzipSDMolSupplier",
+                                                                bgzSDMolSupplierClassDoc.c_str(),
+                                                                python::no_init)
+	.def(python::init<std::string,bool,bool,bool,int>((python::arg("fileName"),
+                                                           python::arg("sanitize")=true,
+                                                           python::arg("removeHs")=true,
+                                                           python::arg("strictParsing")=true,
+                                                           python::arg("numThreads")=1)))
+	.def("__iter__", (BlockGzipSDMolSupplier *(*)(BlockGzipSDMolSupplier *))&MolSupplIter,
+	     python::return_internal_reference<1>() )
+	.def("next", (ROMol *(*)(BlockGzipSDMolSupplier *))&MolSupplNextAcceptNullLastMolecule,
+	     "Returns the next molecule in the file.  Raises _StopIteration_ on EOF.\n",
+	     python::return_value_policy<python::manage_new_object>())
+	.def("__getitem__", (ROMol *(*)(BlockGzipSDMolSupplier *,int))&MolSupplGetItem,
+	     python::return_value_policy<python::manage_new_object>())
+	.def("reset", &BlockGzipSDMolSupplier::reset,
+	     "Resets our position in the file to the beginning.\n")
+	.def("__len__", &BlockGzipSDMolSupplier::length)
+	.def("GetItemText", &BlockGzipSDMolSupplier::getItemText,
+	     "returns the text for an item",
+	     (python::arg("self"),python::arg("index")))
+	.def("atEnd", &BlockGzipSDMolSupplier::atEnd,
+	     "Returns whether or not we have hit EOF.\n")
+	;
+
+      std::string docStr="A class for writing molecules to block-compressed SD files.\n\
+\n\
+  Usage example:\n\
+       >>> writer = BlockGzipSDWriter('out.sdf.gz')\n\
+       >>> for mol in list_of_mols:\n\
+       ...    writer.write(mol)\n\
+       >>> writer.close()\n\
+\n\
+  By default all non-private molecular properties are written to the SD file.\n\
+  This can be changed using the SetProps method.\n\
+\n";
+      python::class_<BlockGzipSDWriter,
+		     boost::noncopyable>("BlockGzipSDWriter",
+					 docStr.c_str(),
+					 python::no_init)
+	.def(python::init<std::string,unsigned int,int>((python::arg("fileName"),
+                                                         python::arg("blockSize")=256*1024,
+                                                         python::arg("level")=6),
+                                                        "Constructor.\n\n"
+                                                        "  ARGUMENTS:\n\n"
+                                                        "    - fileName: the name of the output file\n"
+                                                        "    - blockSize: (optional) the uncompressed size at which blocks are written\n"
+                                                        "    - level: (optional) the zlib compression level\n\n"))
+	.def("SetProps", SetBlockGzipSDWriterProps,
+	     "Sets the properties to be written to the output file\n\n"
+	     "  ARGUMENTS:\n\n"
+	     "    - props: a list or tuple of property names\n\n")
+	.def("write", WriteMolToBlockGzipSD,
+             (python::arg("self"), python::arg("mol"), python::arg("confId")=-1),
+	     "Writes a molecule to the output file.\n\n"
+	     "  ARGUMENTS:\n\n"
+	     "    - mol: the Mol to be written\n"
+             "    - confId: (optional) ID of the conformation to write\n\n")
+	.def("flush", &BlockGzipSDWriter::flush,
+	     "Writes the current block to the output file.\n\n"
+	     )
+	.def("close", &BlockGzipSDWriter::close,
+	     "Flushes the output file and closes it. The Writer cannot be used after this.\n\n"
+	     )
+	.def("NumMols", &BlockGzipSDWriter::numMols,
+	     "Returns the number of molecules written so far.\n\n"
+	     )
+	;
+    };
+  };
+}
+
+void wrap_blockgzip() {
+  RDKit::blockgzip_wrap::wrap();
+}
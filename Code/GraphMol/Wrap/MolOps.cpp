@@ -13,6 +13,7 @@
 #include <boost/python.hpp>
 #include <numpy/arrayobject.h>
 #include <string>
+#include <set>
 #include <math.h>
 
 #include <DataStructs/ExplicitBitVect.h>
@@ -268,6 +269,26 @@ namespace RDKit{
     return PyArray_Return(res);
   }
 
+  void bulkAssignStereochemistry(python::object mols,bool cleanIt,bool force,
+                                 bool flagPossibleStereoCenters,int numThreads){
+    // the GIL is held for the whole call: the molecules are modified, so
+    // other python threads must not be able to use them in the meantime.
+    // A molecule that is in the sequence more than once is only done once,
+    // so that two of our threads never work on the same molecule.
+    std::vector<ROMol *> molVect;
+    std::set<ROMol *> seen;
+    unsigned int nMols=python::extract<unsigned int>(mols.attr("__len__")());
+    molVect.reserve(nMols);
+    for(unsigned int i=0;i<nMols;++i){
+      ROMol &mol=python::extract<ROMol &>(mols[i]);
+      if(seen.insert(&mol).second){
+        molVect.push_back(&mol);
+      }
+    }
+    MolOps::assignStereochemistry(molVect,cleanIt,force,flagPossibleStereoCenters,
+                                  numThreads);
+  }
+
   PyObject *getAdjacencyMatrix(ROMol &mol, bool useBO=false,
                                int emptyVal=0,bool force=false,
                                const char *prefix=0) {
@@ -495,6 +516,7 @@ namespace RDKit{
         .value("SANITIZE_CLEANUPCHIRALITY",MolOps::SANITIZE_CLEANUPCHIRALITY)
         .value("SANITIZE_ADJUSTHS",MolOps::SANITIZE_ADJUSTHS)
         .value("SANITIZE_ALL",MolOps::SANITIZE_ALL)
+        .value("SANITIZE_KEKULIZE_MATCHING",MolOps::SANITIZE_KEKULIZE_MATCHING)
         ;
 
       // ------------------------------------------------------------------------
@@ -1103,11 +1125,31 @@ namespace RDKit{
     - flagPossibleStereoCenters (optional)   set the _ChiralityPossible property on\n\
       atoms that are possible stereocenters\n\
 \n";
-      python::def("AssignStereochemistry", MolOps::assignStereochemistry,
+      python::def("AssignStereochemistry",
+                  (void (*)(ROMol &,bool,bool,bool))MolOps::assignStereochemistry,
                   (python::arg("mol"),python::arg("cleanIt")=false,python::arg("force")=false,
                    python::arg("flagPossibleStereoCenters")=false),
                   docString.c_str());
 
+      // ------------------------------------------------------------------------
+      docString="Does the CIP stereochemistry assignment for a sequence of molecules.\n\
+\n\
+  ARGUMENTS:\n\
+\n\
+    - mols: the molecules to use\n\
+    - cleanIt, force, flagPossibleStereoCenters: (optional) as for\n\
+      AssignStereochemistry()\n\
+    - numThreads: (optional) the number of threads to use. If this is <= 0,\n\
+      the number of hardware threads is added to it.\n\
+\n\
+  Molecules that are in the sequence more than once are only processed once.\n\
+\n";
+      python::def("BulkAssignStereochemistry",bulkAssignStereochemistry,
+                  (python::arg("mols"),python::arg("cleanIt")=false,python::arg("force")=false,
+                   python::arg("flagPossibleStereoCenters")=false,
+                   python::arg("numThreads")=1),
+                  docString.c_str());
+
       // ------------------------------------------------------------------------
       docString="Removes all stereochemistry info from the molecule.\n\
 \n";
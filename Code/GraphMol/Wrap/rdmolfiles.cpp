@@ -228,6 +228,7 @@ namespace RDKit{
 // MolSupplier stuff
 #ifdef SUPPORT_COMPRESSED_SUPPLIERS
 void wrap_compressedsdsupplier();
+void wrap_blockgzip();
 #endif
 void wrap_sdsupplier();
 void wrap_forwardsdsupplier();
@@ -799,6 +800,7 @@ BOOST_PYTHON_MODULE(rdmolfiles)
    *******************************************************/
 #ifdef SUPPORT_COMPRESSED_SUPPLIERS
   wrap_compressedsdsupplier();
+  wrap_blockgzip();
 #endif
   wrap_sdsupplier();
   wrap_forwardsdsupplier();
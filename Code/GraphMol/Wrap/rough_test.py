@@ -2535,7 +2535,54 @@ CAS<~>
     m = Chem.MolFromSmarts(u'c1ccccc1')
     self.failUnless(m is not None)
     self.failUnlessEqual(m.GetNumAtoms(),6)
-    
+
+  def test90BlockGzipSDFiles(self):
+    if not hasattr(Chem,'BlockGzipSDWriter'): return
+
+    fileN = os.path.join(RDConfig.RDBaseDir,'Code','GraphMol','FileParsers',
+                                            'test_data','NCI_aids_few.sdf')
+    ms = [x for x in Chem.SDMolSupplier(fileN)]
+    self.failUnlessEqual(len(ms),16)
+    fName = tempfile.mktemp('.sdf.gz')
+    w = Chem.BlockGzipSDWriter(fName,blockSize=4096)
+    w.SetProps(['NSC'])
+    for m in ms:
+      w.write(m)
+    self.failUnlessEqual(w.NumMols(),16)
+    w.close()
+    w = None
+
+    for numThreads in (1,4):
+      suppl = Chem.BlockGzipSDMolSupplier(fName,numThreads=numThreads)
+      self.failUnlessEqual(len(suppl),16)
+      ns = [m.GetProp('_Name') for m in suppl]
+      self.failUnlessEqual(ns,[m.GetProp('_Name') for m in ms])
+      m = suppl[12]
+      self.failUnlessEqual(Chem.MolToSmiles(m),Chem.MolToSmiles(ms[12]))
+      self.failUnless(m.HasProp('NSC'))
+      self.failUnless(suppl.GetItemText(5).find(ms[5].GetProp('_Name'))==0)
+      self.failUnlessRaises(IndexError,lambda : suppl[16])
+      suppl = None
+    os.unlink(fName)
+
+  def test91BulkAssignStereochemistry(self):
+    smis = ['F[C@](Cl)(Br)I','F[C@@](Cl)(Br)I','F/C=C/Cl','F/C=C\\Cl','CCO']*5
+    for numThreads in (1,4):
+      ms = [Chem.MolFromSmiles(x,sanitize=False) for x in smis]
+      for m in ms:
+        m.UpdatePropertyCache()
+      # the same molecule more than once is fine:
+      ms.append(ms[0])
+      Chem.BulkAssignStereochemistry(ms,cleanIt=True,force=True,numThreads=numThreads)
+      for i,smi in enumerate(smis):
+        ref = Chem.MolFromSmiles(smi)
+        for atom,refAtom in zip(ms[i].GetAtoms(),ref.GetAtoms()):
+          self.failUnlessEqual(atom.HasProp('_CIPCode'),refAtom.HasProp('_CIPCode'))
+          if refAtom.HasProp('_CIPCode'):
+            self.failUnlessEqual(atom.GetProp('_CIPCode'),refAtom.GetProp('_CIPCode'))
+        for bond,refBond in zip(ms[i].GetBonds(),ref.GetBonds()):
+          self.failUnlessEqual(bond.GetStereo(),refBond.GetStereo())
+    self.failUnlessRaises(TypeError,lambda : Chem.BulkAssignStereochemistry([Chem.MolFromSmiles('C'),1]))
 
 
     
@@ -2304,18 +2304,14 @@ void testSFIssue1836576()
 
   // this molecule shows a known bug related to ring
   // ring finding in a molecule where all atoms are 4 connected.
+  // The SSSR code falls back to the relevant cycles for it:
   smi = "C123C45C11C44C55C22C33C14C523";
   m = SmilesToMol(smi,false,false);
   TEST_ASSERT(m);
   
-  ok=false;
-  try {
-    MolOps::sanitizeMol(*m,opThatFailed);
-  } catch (ValueErrorException &vee){
-    ok=true;
-  }
-  TEST_ASSERT(ok);
-  TEST_ASSERT(opThatFailed==MolOps::SANITIZE_SYMMRINGS);
+  MolOps::sanitizeMol(*m,opThatFailed);
+  TEST_ASSERT(!opThatFailed);
+  TEST_ASSERT(m->getRingInfo()->numRings()>=10);
 
   delete m;
 
@@ -4415,6 +4411,340 @@ void testMolAssignment()
   BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
 }
 
+void testLazySanitization()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing lazy sanitization" << std::endl;
+  {
+    std::string smi="OC(=O)c1ccccc1C[N+](=O)[O-]";
+    RWMol *m = SmilesToMol(smi);
+    TEST_ASSERT(m);
+    std::string csmi=MolToSmiles(*m,true);
+    delete m;
+
+    m = SmilesToMol(smi,0,false);
+    TEST_ASSERT(m);
+    TEST_ASSERT(!m->getRingInfo()->isInitialized());
+    MolOps::SanitizeTimings timings;
+    unsigned int failed;
+    MolOps::completeSanitization(*m,failed,MolOps::SANITIZE_PROPERTIES,&timings);
+    TEST_ASSERT(!failed);
+    TEST_ASSERT(!m->getRingInfo()->isInitialized());
+    TEST_ASSERT(m->getAtomWithIdx(9)->getTotalNumHs()==2);
+    // the clean up is done along with the properties:
+    TEST_ASSERT(timings.size()==2);
+    TEST_ASSERT(timings.find(MolOps::SANITIZE_CLEANUP)!=timings.end());
+    TEST_ASSERT(timings.find(MolOps::SANITIZE_PROPERTIES)!=timings.end());
+
+    // already done, so nothing happens:
+    MolOps::completeSanitization(*m,failed,MolOps::SANITIZE_PROPERTIES,&timings);
+    TEST_ASSERT(timings.size()==2);
+
+    MolOps::completeSanitization(*m,failed,MolOps::SANITIZE_ALL,&timings);
+    TEST_ASSERT(!failed);
+    TEST_ASSERT(m->getRingInfo()->isInitialized());
+    TEST_ASSERT(timings.find(MolOps::SANITIZE_KEKULIZE)!=timings.end());
+    TEST_ASSERT(timings.find(MolOps::SANITIZE_SETAROMATICITY)!=timings.end());
+    TEST_ASSERT(MolToSmiles(*m,true)==csmi);
+
+    // sanitizeMol() records what it has done:
+    std::map<unsigned int,double> timings2;
+    MolOps::sanitizeMol(*m,failed,MolOps::SANITIZE_ALL,&timings2);
+    TEST_ASSERT(!failed);
+    TEST_ASSERT(timings2.find(MolOps::SANITIZE_CLEANUP)!=timings2.end());
+    timings2.clear();
+    MolOps::completeSanitization(*m,failed,MolOps::SANITIZE_ALL,&timings2);
+    TEST_ASSERT(timings2.empty());
+    // which is reset along with the other computed properties:
+    m->clearComputedProps();
+    MolOps::completeSanitization(*m,failed,MolOps::SANITIZE_ALL,&timings2);
+    TEST_ASSERT(!timings2.empty());
+    TEST_ASSERT(MolToSmiles(*m,true)==csmi);
+    delete m;
+  }
+  {
+    // an uncharged nitro group needs the clean up before its valences
+    // can be checked:
+    RWMol *m = SmilesToMol("CN(=O)=O",0,false);
+    TEST_ASSERT(m);
+    unsigned int failed;
+    MolOps::completeSanitization(*m,failed,MolOps::SANITIZE_PROPERTIES);
+    TEST_ASSERT(!failed);
+    TEST_ASSERT(m->getAtomWithIdx(1)->getFormalCharge()==1);
+    TEST_ASSERT(m->getAtomWithIdx(1)->getExplicitValence()==4);
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
+void testKekulizeMatching()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing kekulization by matching" << std::endl;
+  {
+    // both methods give valid Kekule structures:
+    std::string smis[]={"c1ccccc1","c1ccc2ccccc2c1","c1cc[nH]c1","c1ccc2c(c1)[nH]c1ccccc12",
+                        "c1cc2cccccc-2c1","O=c1cccc[nH]1","c1ccc2c(c1)ccc1ccccc12",
+                        "C1=Cc2cc3ccc(cc4ccc(cc5nc(cc1n2)C=C5)[nH]4)[nH]3",
+                        "c1cc*cc1","*1ccccc1","c1ccc2c(c1)-c1ccccc-1-2"};
+    unsigned int nSmis=sizeof(smis)/sizeof(smis[0]);
+    for(unsigned int i=0;i<nSmis;++i){
+      RWMol *m = SmilesToMol(smis[i]);
+      TEST_ASSERT(m);
+      std::string csmi=MolToSmiles(*m,true);
+      RWMol m2(*m);
+      MolOps::Kekulize(m2,true,100,true);
+      for(ROMol::BondIterator bi=m2.beginBonds();bi!=m2.endBonds();++bi){
+        TEST_ASSERT(!(*bi)->getIsAromatic());
+        TEST_ASSERT((*bi)->getBondType()!=Bond::AROMATIC);
+      }
+      std::string ksmi=MolToSmiles(m2,true);
+      RWMol *m3=SmilesToMol(ksmi);
+      TEST_ASSERT(m3);
+      TEST_ASSERT(MolToSmiles(*m3,true)==csmi);
+      delete m3;
+
+      RWMol *m4 = SmilesToMol(smis[i],0,false);
+      TEST_ASSERT(m4);
+      unsigned int failed;
+      MolOps::sanitizeMol(*m4,failed,MolOps::SANITIZE_ALL|MolOps::SANITIZE_KEKULIZE_MATCHING);
+      TEST_ASSERT(!failed);
+      TEST_ASSERT(MolToSmiles(*m4,true)==csmi);
+      delete m4;
+      delete m;
+    }
+  }
+  {
+    // C60 with all bonds aromatic: each carbon ends up with exactly one double bond
+    std::string smi="C12=C3C4=C5C6=C1C7=C8C9=C1C%10=C%11C(=C29)C3=C2C3=C4C4=C5C5=C9C6=C7C6=C7C8=C1C1=C8C%10=C%10C%11=C2C2=C3C3=C4C4=C5C5=C%11C%12=C(C6=C95)C7=C1C1=C%12C5=C%11C4=C3C3=C5C(=C81)C%10=C23";
+    RWMol *m = SmilesToMol(smi,0,false);
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getNumAtoms()==60);
+    for(ROMol::AtomIterator ai=m->beginAtoms();ai!=m->endAtoms();++ai){
+      (*ai)->setIsAromatic(true);
+    }
+    for(ROMol::BondIterator bi=m->beginBonds();bi!=m->endBonds();++bi){
+      (*bi)->setBondType(Bond::AROMATIC);
+      (*bi)->setIsAromatic(true);
+    }
+    m->updatePropertyCache(false);
+    {
+      // the default method falls back to matching if backtracking fails:
+      RWMol m2(*m);
+      MolOps::Kekulize(m2);
+      for(ROMol::BondIterator bi=m2.beginBonds();bi!=m2.endBonds();++bi){
+        TEST_ASSERT((*bi)->getBondType()!=Bond::AROMATIC);
+      }
+    }
+    MolOps::Kekulize(*m,true,100,true);
+    for(ROMol::AtomIterator ai=m->beginAtoms();ai!=m->endAtoms();++ai){
+      unsigned int nDouble=0;
+      ROMol::OEDGE_ITER beg,end;
+      boost::tie(beg,end) = m->getAtomBonds(*ai);
+      while(beg!=end){
+        if((*m)[*beg]->getBondType()==Bond::DOUBLE) ++nDouble;
+        ++beg;
+      }
+      TEST_ASSERT(nDouble==1);
+    }
+    delete m;
+  }
+  {
+    // things that can't be kekulized fail with either method:
+    std::string smis[]={"c1cccc1","c1ccccc1c1cccc1"};
+    for(unsigned int i=0;i<2;++i){
+      for(unsigned int useMatching=0;useMatching<2;++useMatching){
+        RWMol *m = SmilesToMol(smis[i],0,false);
+        TEST_ASSERT(m);
+        unsigned int failed;
+        unsigned int ops=MolOps::SANITIZE_ALL;
+        if(useMatching) ops|=MolOps::SANITIZE_KEKULIZE_MATCHING;
+        bool ok=false;
+        try{
+          MolOps::sanitizeMol(*m,failed,ops);
+        } catch (MolSanitizeException &){
+          ok=true;
+        }
+        TEST_ASSERT(ok);
+        TEST_ASSERT(failed==MolOps::SANITIZE_KEKULIZE);
+        delete m;
+      }
+    }
+  }
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
+namespace {
+  // a sheet of fused six-membered rings built from nRows+1 rows of
+  // 2*nCols+1 carbons (the "brick wall" layout of a honeycomb). nRows
+  // should be odd so there are no terminal atoms. All the bonds are aromatic.
+  RWMol *makeHoneycomb(unsigned int nRows,unsigned int nCols){
+    RWMol *res=new RWMol();
+    unsigned int width=2*nCols+1;
+    for(unsigned int i=0;i<(nRows+1)*width;++i){
+      Atom *atom=new Atom(6);
+      atom->setIsAromatic(true);
+      res->addAtom(atom,false,true);
+    }
+    for(unsigned int i=0;i<=nRows;++i){
+      for(unsigned int j=0;j<width;++j){
+        if(j+1<width){
+          res->addBond(i*width+j,i*width+j+1,Bond::AROMATIC);
+        }
+        if(i<nRows && !((i+j)%2)){
+          res->addBond(i*width+j,(i+1)*width+j,Bond::AROMATIC);
+        }
+      }
+    }
+    for(ROMol::BondIterator bi=res->beginBonds();bi!=res->endBonds();++bi){
+      (*bi)->setIsAromatic(true);
+    }
+    return res;
+  }
+
+  bool ringIsValid(const ROMol &mol,const INT_VECT &ring){
+    std::set<int> atoms(ring.begin(),ring.end());
+    if(atoms.size()!=ring.size()) return false;
+    for(unsigned int i=0;i<ring.size();++i){
+      if(!mol.getBondBetweenAtoms(ring[i],ring[(i+1)%ring.size()])) return false;
+    }
+    return true;
+  }
+}
+
+void testRelevantCycles()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing relevant cycles" << std::endl;
+  {
+    // cubane: the SSSR has five rings, there are six relevant cycles
+    RWMol *m = SmilesToMol("C12C3C4C1C5C2C3C45");
+    TEST_ASSERT(m);
+    VECT_INT_VECT rings;
+    MolOps::PerceptionCost cost;
+    TEST_ASSERT(MolOps::findRelevantCycles(*m,rings,100,&cost)==6);
+    TEST_ASSERT(rings.size()==6);
+    for(unsigned int i=0;i<rings.size();++i){
+      TEST_ASSERT(rings[i].size()==4);
+      TEST_ASSERT(ringIsValid(*m,rings[i]));
+    }
+    TEST_ASSERT(cost.numRingSystems==1);
+    TEST_ASSERT(cost.numCandidates>=6);
+    TEST_ASSERT(cost.numResults==6);
+
+    // the limit:
+    bool ok=false;
+    try{
+      MolOps::findRelevantCycles(*m,rings,5);
+    } catch (ValueErrorException &){
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    delete m;
+  }
+  {
+    // bicyclo[2.2.2]octane: three six-membered rings
+    RWMol *m = SmilesToMol("C1CC2CCC1CC2");
+    TEST_ASSERT(m);
+    VECT_INT_VECT rings;
+    TEST_ASSERT(MolOps::findRelevantCycles(*m,rings)==3);
+    for(unsigned int i=0;i<rings.size();++i){
+      TEST_ASSERT(rings[i].size()==6);
+      TEST_ASSERT(ringIsValid(*m,rings[i]));
+    }
+    delete m;
+  }
+  {
+    // more than one fragment, and a ring system with a bridge:
+    RWMol *m = SmilesToMol("c1ccc2ccccc2c1.C1CC1CCC1CC1");
+    TEST_ASSERT(m);
+    VECT_INT_VECT rings;
+    TEST_ASSERT(MolOps::findRelevantCycles(*m,rings)==4);
+    for(unsigned int i=0;i<rings.size();++i){
+      TEST_ASSERT(ringIsValid(*m,rings[i]));
+    }
+    delete m;
+  }
+  {
+    // C60: 12 five- and 20 six-membered rings
+    RWMol *m = SmilesToMol("C12=C3C4=C5C6=C1C7=C8C9=C1C%10=C%11C(=C29)C3=C2C3=C4C4=C5C5=C9C6=C7C6=C7C8=C1C1=C8C%10=C%10C%11=C2C2=C3C3=C4C4=C5C5=C%11C%12=C(C6=C95)C7=C1C1=C%12C5=C%11C4=C3C3=C5C(=C81)C%10=C23");
+    TEST_ASSERT(m);
+    VECT_INT_VECT rings;
+    TEST_ASSERT(MolOps::findRelevantCycles(*m,rings)==32);
+    unsigned int n5=0,n6=0;
+    for(unsigned int i=0;i<rings.size();++i){
+      TEST_ASSERT(ringIsValid(*m,rings[i]));
+      if(rings[i].size()==5) ++n5;
+      else if(rings[i].size()==6) ++n6;
+    }
+    TEST_ASSERT(n5==12);
+    TEST_ASSERT(n6==20);
+    // the SSSR is found by the same code, the symmetrization adds the last ring:
+    TEST_ASSERT(m->getRingInfo()->numRings()==32);
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
+void testLargeRingSystems()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n Testing large fused ring systems" << std::endl;
+  {
+    unsigned int nRows=15,nCols=10;
+    unsigned int nRings=(nRows+1)/2*nCols+(nRows-1)/2*(nCols-1);
+    RWMol *m = makeHoneycomb(nRows,nCols);
+    VECT_INT_VECT rings;
+    TEST_ASSERT(MolOps::findSSSR(*m,rings)==nRings);
+    for(unsigned int i=0;i<rings.size();++i){
+      TEST_ASSERT(rings[i].size()==6);
+      TEST_ASSERT(ringIsValid(*m,rings[i]));
+    }
+    TEST_ASSERT(MolOps::symmetrizeSSSR(*m)==nRings);
+
+    m->getRingInfo()->reset();
+    unsigned int failed;
+    MolOps::sanitizeMol(*m,failed,MolOps::SANITIZE_ALL|MolOps::SANITIZE_KEKULIZE_MATCHING);
+    TEST_ASSERT(!failed);
+    TEST_ASSERT(m->getRingInfo()->numRings()==nRings);
+    for(ROMol::AtomIterator ai=m->beginAtoms();ai!=m->endAtoms();++ai){
+      TEST_ASSERT((*ai)->getIsAromatic());
+    }
+
+    // every ring is aromatic by itself, so no groups of rings need to be
+    // looked at:
+    MolOps::Kekulize(*m,true);
+    MolOps::PerceptionCost cost;
+    MolOps::setAromaticity(*m,&cost);
+    TEST_ASSERT(cost.numRingSystems==1);
+    TEST_ASSERT(cost.numCandidates==nRings);
+    TEST_ASSERT(cost.numResults==nRings);
+    for(ROMol::BondIterator bi=m->beginBonds();bi!=m->endBonds();++bi){
+      TEST_ASSERT((*bi)->getIsAromatic());
+    }
+
+    // the limit:
+    MolOps::Kekulize(*m,true);
+    bool ok=false;
+    try{
+      MolOps::setAromaticity(*m,0,10);
+    } catch (MolSanitizeException &){
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    delete m;
+  }
+  {
+    // azulene and friends need pairs of rings:
+    RWMol *m = SmilesToMol("C1=CC2=CC=CC=CC2=C1");
+    TEST_ASSERT(m);
+    TEST_ASSERT(m->getAtomWithIdx(0)->getIsAromatic());
+    TEST_ASSERT(m->getAtomWithIdx(4)->getIsAromatic());
+    MolOps::Kekulize(*m,true);
+    MolOps::PerceptionCost cost;
+    TEST_ASSERT(MolOps::setAromaticity(*m,&cost)==2);
+    TEST_ASSERT(cost.numCandidates==3);
+    delete m;
+  }
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
 int main(){
   RDLog::InitLogs();
   //boost::logging::enable_logs("rdApp.debug");
@@ -4481,6 +4811,10 @@ int main(){
   testRenumberAtoms();
   testGithubIssue141();
   testMolAssignment();
+  testLazySanitization();
+  testKekulizeMatching();
+  testRelevantCycles();
+  testLargeRingSystems();
 #endif
   testAtomAtomMatch();
 
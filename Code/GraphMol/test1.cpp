@@ -11,6 +11,7 @@
 
 #include <GraphMol/RDKitBase.h>
 #include <GraphMol/MonomerInfo.h>
+#include <GraphMol/ConformerEnsemble.h>
 #include <GraphMol/RDKitQueries.h>
 #include <RDGeneral/types.h>
 #include <RDGeneral/RDLog.h>
@@ -1040,6 +1041,194 @@ void testAtomResidues()
 }
 
 // -------------------------------------------------------------------
+void testConformerLookup()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n";
+  BOOST_LOG(rdInfoLog) << "Testing conformer lookup by id" << std::endl;
+  RWMol m;
+  m.addAtom(new Atom(6));
+  m.addAtom(new Atom(8));
+
+  for(unsigned int i=0;i<10;++i){
+    Conformer *conf = new Conformer(m.getNumAtoms());
+    conf->setAtomPos(0,RDGeom::Point3D(i,0,0));
+    TEST_ASSERT(m.addConformer(conf,true)==i);
+  }
+  TEST_ASSERT(feq(m.getConformer(7).getAtomPos(0).x,7.0));
+
+  m.removeConformer(7);
+  TEST_ASSERT(m.getNumConformers()==9);
+  bool ok=false;
+  try{
+    m.getConformer(7);
+  } catch (ConformerException &){
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+
+  // changing the id of a conformer that's already on the molecule:
+  m.getConformer(9).setId(7);
+  TEST_ASSERT(feq(m.getConformer(7).getAtomPos(0).x,9.0));
+  // the new id is the largest one + 1:
+  TEST_ASSERT(m.addConformer(new Conformer(m.getNumAtoms()),true)==9);
+
+  // duplicate ids, the first one is found:
+  Conformer *conf = new Conformer(m.getNumAtoms());
+  conf->setId(3);
+  conf->setAtomPos(0,RDGeom::Point3D(-1,0,0));
+  m.addConformer(conf);
+  TEST_ASSERT(feq(m.getConformer(3).getAtomPos(0).x,3.0));
+  m.removeConformer(3);
+  TEST_ASSERT(feq(m.getConformer(3).getAtomPos(0).x,-1.0));
+
+  // copies:
+  RWMol m2(m);
+  TEST_ASSERT(m2.getNumConformers()==m.getNumConformers());
+  TEST_ASSERT(feq(m2.getConformer(7).getAtomPos(0).x,9.0));
+  m2.clearConformers();
+  ok=false;
+  try{
+    m2.getConformer(7);
+  } catch (ConformerException &){
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+
+  // conformers that outlive their place on the molecule (or the
+  // molecule itself) can still have their id changed:
+  CONFORMER_SPTR held=*m.beginConformers();
+  m.clearConformers();
+  held->setId(42);
+  TEST_ASSERT(held->getId()==42);
+  m.addConformer(new Conformer(m.getNumAtoms()),true);
+  held=*m.beginConformers();
+  m.clear();
+  held->setId(43);
+  TEST_ASSERT(held->getId()==43);
+  {
+    RWMol *m3=new RWMol(m2);
+    m3->addConformer(new Conformer(m3->getNumAtoms()),true);
+    held=*m3->beginConformers();
+    delete m3;
+  }
+  held->setId(44);
+  TEST_ASSERT(held->getId()==44);
+
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
+void testConformerEnsemble()
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n";
+  BOOST_LOG(rdInfoLog) << "Testing conformer ensembles" << std::endl;
+  RWMol m;
+  m.addAtom(new Atom(6));
+  m.addAtom(new Atom(6));
+  m.addAtom(new Atom(8));
+  for(unsigned int i=0;i<5;++i){
+    Conformer *conf = new Conformer(m.getNumAtoms());
+    for(unsigned int j=0;j<m.getNumAtoms();++j){
+      conf->setAtomPos(j,RDGeom::Point3D(i,j,0.5*i+j));
+    }
+    conf->setId(10*i);
+    conf->set3D(i!=2);
+    m.addConformer(conf);
+  }
+
+  ConformerEnsemble<double> ens(m);
+  TEST_ASSERT(ens.getNumAtoms()==3);
+  TEST_ASSERT(ens.getNumConformers()==5);
+  TEST_ASSERT(ens.getData().size()==5*3*3);
+  TEST_ASSERT(ens.hasConformer(30));
+  TEST_ASSERT(!ens.hasConformer(3));
+  TEST_ASSERT(ens.getSlot(30)==3);
+  TEST_ASSERT(ens.getId(4)==40);
+  TEST_ASSERT(!ens.is3D(2));
+  // the coordinates are contiguous:
+  TEST_ASSERT(ens.getCoords(3)==&ens.getData()[0]+3*3*3);
+  TEST_ASSERT(feq(ens.getCoords(ens.getSlot(30))[7],2.0));
+  TEST_ASSERT(feq(ens.getCoords(ens.getSlot(30))[8],3.5));
+
+  bool ok=false;
+  try{
+    ens.getSlot(3);
+  } catch (ConformerException &){
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+  ok=false;
+  try{
+    ens.addConformer(m.getConformer(20));
+  } catch (ConformerException &){
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+
+  double coords[9]={1,2,3,4,5,6,7,8,9};
+  TEST_ASSERT(ens.addConformer(coords,100)==5);
+  ens.getCoords(0)[0]=-1.0;
+  ens.updateMol(m);
+  TEST_ASSERT(m.getNumConformers()==6);
+  TEST_ASSERT(feq(m.getConformer(0).getAtomPos(0).x,-1.0));
+  TEST_ASSERT(feq(m.getConformer(100).getAtomPos(2).z,9.0));
+  TEST_ASSERT(!m.getConformer(20).is3D());
+
+  // pickling, in both precisions:
+  std::string pkl=ens.toBinary();
+  ConformerEnsemble<double> ens2(pkl);
+  TEST_ASSERT(ens2.getNumAtoms()==3);
+  TEST_ASSERT(ens2.getNumConformers()==6);
+  TEST_ASSERT(ens2.getSlot(100)==5);
+  TEST_ASSERT(!ens2.is3D(2));
+  TEST_ASSERT(ens2.getData()==ens.getData());
+
+  ConformerEnsemble<float> fens(pkl);
+  TEST_ASSERT(fens.getNumConformers()==6);
+  TEST_ASSERT(feq(fens.getCoords(fens.getSlot(30))[8],3.5));
+  std::string fpkl=fens.toBinary();
+  TEST_ASSERT(fpkl.size()<pkl.size());
+  ConformerEnsemble<double> ens3(fpkl);
+  TEST_ASSERT(ens3.getNumConformers()==6);
+  TEST_ASSERT(feq(ens3.getCoords(5)[8],9.0));
+
+  ok=false;
+  try{
+    ConformerEnsemble<double> bad(pkl.substr(0,pkl.size()/2));
+  } catch (ConformerException &){
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+
+  // a conformer count that doesn't fit in the pickle
+  // (the count follows the version, precision and atom count):
+  std::string badPkl=pkl;
+  badPkl.replace(12,4,4,'\xff');
+  ok=false;
+  try{
+    ens2.initFromBinary(badPkl);
+  } catch (ConformerException &){
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+  // the ensemble is unchanged after a failure:
+  TEST_ASSERT(ens2.getNumConformers()==6);
+  TEST_ASSERT(ens2.getData()==ens.getData());
+
+  // a duplicate conformer id (each id is followed by the 3D flag):
+  badPkl=pkl;
+  badPkl.replace(21,4,pkl.substr(16,4));
+  ok=false;
+  try{
+    ens2.initFromBinary(badPkl);
+  } catch (ConformerException &){
+    ok=true;
+  }
+  TEST_ASSERT(ok);
+  TEST_ASSERT(ens2.getSlot(100)==5);
+
+  BOOST_LOG(rdInfoLog) << "Finished" << std::endl;
+}
+
 int main()
 {
   RDLog::InitLogs();
@@ -1062,6 +1251,8 @@ int main()
   testIssue284();
   testClearMol();
   testAtomResidues();
+  testConformerLookup();
+  testConformerEnsemble();
 
   return 0;
 }
@@ -23,6 +23,7 @@
 #include <GraphMol/FileParsers/MolFileStereochem.h>
 
 #include <iostream>
+#include <boost/lexical_cast.hpp>
 
 using namespace RDKit;
 using namespace std;
@@ -2045,6 +2046,116 @@ void testGithub90(){
 
 
 
+void testBulkStereochemistry(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "Testing stereochemistry on long chains and sets of molecules" << std::endl;
+
+  // a linear oligosaccharide: every unit is equivalent until the
+  // ends of the chain are "felt", so the ranks need a lot of iterations
+  // to settle
+  std::string inner="O";
+  unsigned int nUnits=40;
+  for(unsigned int i=nUnits;i>0;--i){
+    std::string d="%"+boost::lexical_cast<std::string>(9+i);
+    inner="[C@@H]"+d+"O[C@H](CO)[C@@H](O"+inner+")[C@H](O)[C@H]"+d+"O";
+  }
+  std::vector<std::string> smis;
+  smis.push_back("O"+inner);
+  smis.push_back("F[C@](Cl)(Br)I");
+  smis.push_back("C\\C=C\\[C@H](O)CC");
+  smis.push_back("CC[C@@H]1[C@@]([C@@H]([C@H](C(=O)[C@@H](C[C@@]([C@@H]([C@H]([C@@H]([C@H](C(=O)O1)C)O[C@H]2C[C@@]([C@H]([C@@H](O2)C)O)(C)OC)C)O[C@H]3[C@@H]([C@H](C[C@H](O3)C)N(C)C)O)(C)O)C)C)O)(C)O");
+
+  std::vector<ROMol *> refMols,mols;
+  for(unsigned int i=0;i<smis.size();++i){
+    refMols.push_back(SmilesToMol(smis[i]));
+    TEST_ASSERT(refMols.back());
+    mols.push_back(new ROMol(*refMols.back()));
+  }
+  {
+    ROMol *m=refMols[0];
+    TEST_ASSERT(m->getNumAtoms()==11*nUnits+2);
+    unsigned int nCodes=0;
+    for(unsigned int i=0;i<m->getNumAtoms();++i){
+      if(m->getAtomWithIdx(i)->getChiralTag()!=Atom::CHI_UNSPECIFIED){
+        TEST_ASSERT(m->getAtomWithIdx(i)->hasProp("_CIPCode"));
+        ++nCodes;
+      }
+    }
+    TEST_ASSERT(nCodes==5*nUnits);
+  }
+
+  // the same molecules in bulk, with a null entry:
+  mols.push_back(0);
+  MolOps::assignStereochemistry(mols,true,true,true,2);
+  for(unsigned int i=0;i<refMols.size();++i){
+    MolOps::assignStereochemistry(*refMols[i],true,true,true);
+    TEST_ASSERT(mols[i]->getNumAtoms()==refMols[i]->getNumAtoms());
+    for(unsigned int j=0;j<refMols[i]->getNumAtoms();++j){
+      const Atom *ref=refMols[i]->getAtomWithIdx(j);
+      const Atom *atom=mols[i]->getAtomWithIdx(j);
+      TEST_ASSERT(ref->getProp<int>("_CIPRank")==atom->getProp<int>("_CIPRank"));
+      TEST_ASSERT(ref->hasProp("_CIPCode")==atom->hasProp("_CIPCode"));
+      if(ref->hasProp("_CIPCode")){
+        TEST_ASSERT(ref->getProp<std::string>("_CIPCode")==atom->getProp<std::string>("_CIPCode"));
+      }
+      TEST_ASSERT(ref->hasProp("_ChiralityPossible")==atom->hasProp("_ChiralityPossible"));
+    }
+    TEST_ASSERT(MolToSmiles(*refMols[i],true)==MolToSmiles(*mols[i],true));
+    delete refMols[i];
+    delete mols[i];
+  }
+  {
+    // spot check the simple ones:
+    ROMol *m=SmilesToMol(smis[1]);
+    TEST_ASSERT(m->getAtomWithIdx(1)->getProp<std::string>("_CIPCode")=="S");
+    delete m;
+    m=SmilesToMol(smis[2]);
+    TEST_ASSERT(m->getBondWithIdx(1)->getStereo()==Bond::STEREOE);
+    TEST_ASSERT(m->getAtomWithIdx(3)->getProp<std::string>("_CIPCode")=="R");
+    delete m;
+  }
+  {
+    // an error in one of the molecules is passed on to the caller,
+    // whichever thread it happens in. The molecule built by hand has
+    // no implicit valences:
+    ROMol *ref=SmilesToMol(smis[1]);
+    TEST_ASSERT(ref);
+    for(unsigned int badIdx=0;badIdx<4;++badIdx){
+      std::vector<ROMol *> mols;
+      for(unsigned int i=0;i<4;++i){
+        if(i!=badIdx){
+          mols.push_back(new ROMol(*ref));
+          continue;
+        }
+        RWMol *bad=new RWMol();
+        for(unsigned int j=0;j<ref->getNumAtoms();++j){
+          Atom *atom=new Atom(ref->getAtomWithIdx(j)->getAtomicNum());
+          atom->setChiralTag(ref->getAtomWithIdx(j)->getChiralTag());
+          bad->addAtom(atom,true,true);
+        }
+        for(unsigned int j=0;j<ref->getNumBonds();++j){
+          const Bond *bond=ref->getBondWithIdx(j);
+          bad->addBond(bond->getBeginAtomIdx(),bond->getEndAtomIdx(),bond->getBondType());
+        }
+        mols.push_back(bad);
+      }
+      for(int numThreads=1;numThreads<4;++numThreads){
+        bool ok=false;
+        try{
+          MolOps::assignStereochemistry(mols,true,true,false,numThreads);
+        } catch (Invar::Invariant &) {
+          ok=true;
+        }
+        TEST_ASSERT(ok);
+      }
+      for(unsigned int i=0;i<mols.size();++i) delete mols[i];
+    }
+    delete ref;
+  }
+
+  BOOST_LOG(rdInfoLog) << "done" << std::endl;
+}
+
 int main(){
   RDLog::InitLogs();
   //boost::logging::enable_logs("rdApp.debug");
@@ -2068,6 +2179,7 @@ int main(){
   testGithub87();
 #endif
   testGithub90();
+  testBulkStereochemistry();
   return 0;
 }
 
@@ -974,6 +974,176 @@ void testGithub149()
   BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
 }
 
+void testCompactPickles(bool doLong=0)
+{
+  BOOST_LOG(rdInfoLog) << "-----------------------\n";
+  BOOST_LOG(rdInfoLog) << "Testing compact pickles" << std::endl;
+  {
+    std::string fName = getenv("RDBASE");
+    fName += "/Code/GraphMol/test_data/canonSmiles.smi";
+    SmilesMolSupplier suppl(fName,"\t",0,1,false);
+    int count = 0;
+    while(!suppl.atEnd()){
+      ROMol *m = suppl.next();
+      TEST_ASSERT(m);
+
+      std::string pickle;
+      MolPickler::pickleMolCompact(*m,pickle);
+      TEST_ASSERT(pickle.size());
+      ROMol m2;
+      MolPickler::molFromPickle(pickle,m2);
+      TEST_ASSERT(m2.getNumAtoms()==m->getNumAtoms());
+      TEST_ASSERT(m2.getNumBonds()==m->getNumBonds());
+      TEST_ASSERT(m2.getRingInfo()->numRings()==m->getRingInfo()->numRings());
+      TEST_ASSERT(MolToSmiles(*m)==MolToSmiles(m2));
+      delete m;
+      count++;
+      if(!doLong && count >= 100) break;
+    }
+  }
+  {
+    ROMol *m = SmilesToMol("[13CH3:1]/C=C/[C@H](F)C1CC1");
+    TEST_ASSERT(m);
+    m->getAtomWithIdx(5)->setProp("dummyLabel",std::string("R1"));
+    Conformer *conf=new Conformer(m->getNumAtoms());
+    conf->setAtomPos(2,RDGeom::Point3D(1.0,2.0,-3.5));
+    conf->set3D(false);
+    m->addConformer(conf,true);
+
+    std::string pickle,oldPickle;
+    MolPickler::pickleMolCompact(*m,pickle);
+    MolPickler::pickleMol(*m,oldPickle);
+
+    RWMol *m2 = new RWMol(pickle);
+    TEST_ASSERT(m2);
+    TEST_ASSERT(MolToSmiles(*m,true)==MolToSmiles(*m2,true));
+    TEST_ASSERT(m2->getAtomWithIdx(0)->getIsotope()==13);
+    TEST_ASSERT(m2->getAtomWithIdx(0)->getProp<int>("molAtomMapNumber")==1);
+    TEST_ASSERT(m2->getAtomWithIdx(5)->getProp<std::string>("dummyLabel")=="R1");
+    TEST_ASSERT(m2->getAtomWithIdx(3)->getChiralTag()==m->getAtomWithIdx(3)->getChiralTag());
+    TEST_ASSERT(m2->getBondWithIdx(1)->getStereo()==m->getBondWithIdx(1)->getStereo());
+    TEST_ASSERT(m2->getBondWithIdx(1)->getStereoAtoms()==m->getBondWithIdx(1)->getStereoAtoms());
+    TEST_ASSERT(m2->getNumConformers()==1);
+    TEST_ASSERT(!m2->getConformer().is3D());
+    TEST_ASSERT(feq(m2->getConformer().getAtomPos(2).z,-3.5));
+    delete m2;
+
+    // skipping parts of the pickle:
+    ROMol m3;
+    MolPickler::molFromPickle(pickle.c_str(),pickle.size(),m3,
+                              MolPickler::SKIP_RINGINFO|MolPickler::SKIP_CONFORMERS|
+                              MolPickler::SKIP_ATOMPROPS);
+    TEST_ASSERT(m3.getNumAtoms()==m->getNumAtoms());
+    TEST_ASSERT(!m3.getRingInfo()->isInitialized());
+    TEST_ASSERT(!m3.getNumConformers());
+    TEST_ASSERT(!m3.getAtomWithIdx(0)->hasProp("molAtomMapNumber"));
+    TEST_ASSERT(!m3.getAtomWithIdx(5)->hasProp("dummyLabel"));
+
+    // the flags also apply to the default format:
+    ROMol m4;
+    MolPickler::molFromPickle(oldPickle,m4,MolPickler::SKIP_CONFORMERS);
+    TEST_ASSERT(m4.getNumAtoms()==m->getNumAtoms());
+    TEST_ASSERT(!m4.getNumConformers());
+
+    // streams contain exactly the pickle:
+    std::stringstream ss(std::ios_base::binary|std::ios_base::out|std::ios_base::in);
+    MolPickler::pickleMolCompact(*m,ss);
+    MolPickler::pickleMol(*m,ss);
+    ROMol m5,m6;
+    MolPickler::molFromPickle(ss,m5);
+    MolPickler::molFromPickle(ss,m6);
+    TEST_ASSERT(MolToSmiles(m5,true)==MolToSmiles(*m,true));
+    TEST_ASSERT(MolToSmiles(m6,true)==MolToSmiles(*m,true));
+
+    // truncated pickles are caught:
+    bool ok=false;
+    try{
+      ROMol m7;
+      MolPickler::molFromPickle(pickle.c_str(),pickle.size()-4,m7);
+    } catch (MolPicklerException &e) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+
+    // so are bad counts and indices anywhere after the header:
+    const int32_t badVals[2]={-1,0x7fffffff};
+    for(unsigned int v=0;v<2;++v){
+      for(unsigned int i=6*sizeof(int32_t);i+sizeof(int32_t)<=pickle.size();++i){
+        std::string bad=pickle;
+        bad.replace(i,sizeof(int32_t),reinterpret_cast<const char *>(&badVals[v]),
+                    sizeof(int32_t));
+        try{
+          ROMol m7;
+          MolPickler::molFromPickle(bad,m7);
+        } catch (MolPicklerException &e) {
+        }
+      }
+    }
+    delete m;
+  }
+  {
+    // bad enum values and duplicate bonds are caught:
+    ROMol *m = SmilesToMol("CCC");
+    TEST_ASSERT(m);
+    std::string pickle;
+    MolPickler::pickleMolCompact(*m,pickle);
+    // the pickle header and the atom and bond counts come before the atoms:
+    const unsigned int atomStart=9*sizeof(int32_t),recordSize=12;
+    const unsigned int bondStart=atomStart+m->getNumAtoms()*recordSize;
+    std::vector<unsigned int> badPositions;
+    badPositions.push_back(atomStart+2);            // chiral tag
+    badPositions.push_back(atomStart+recordSize+3); // hybridization
+    badPositions.push_back(bondStart+8);            // bond type
+    badPositions.push_back(bondStart+9);            // bond direction
+    badPositions.push_back(bondStart+recordSize+10);// bond stereo
+    for(unsigned int i=0;i<badPositions.size();++i){
+      std::string bad=pickle;
+      bad[badPositions[i]]=static_cast<char>(0xFF);
+      bool ok=false;
+      try{
+        ROMol m2;
+        MolPickler::molFromPickle(bad,m2);
+      } catch (MolPicklerException &e) {
+        ok=true;
+      }
+      TEST_ASSERT(ok);
+    }
+
+    // make the second bond a copy of the first one:
+    std::string bad=pickle;
+    bad.replace(bondStart+recordSize,2*sizeof(int32_t),pickle,bondStart,2*sizeof(int32_t));
+    bool ok=false;
+    try{
+      ROMol m2;
+      MolPickler::molFromPickle(bad,m2);
+    } catch (MolPicklerException &e) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    // also when the molecule isn't empty:
+    ok=false;
+    try{
+      RWMol m2(*m);
+      MolPickler::molFromPickle(bad,m2);
+    } catch (MolPicklerException &e) {
+      ok=true;
+    }
+    TEST_ASSERT(ok);
+    delete m;
+  }
+  {
+    // queries can't be stored in the compact format, the default is used:
+    ROMol *m = SmartsToMol("[C,N]~[#6;R]");
+    TEST_ASSERT(m);
+    std::string pickle,oldPickle;
+    MolPickler::pickleMolCompact(*m,pickle);
+    MolPickler::pickleMol(*m,oldPickle);
+    TEST_ASSERT(pickle==oldPickle);
+    delete m;
+  }
+  BOOST_LOG(rdErrorLog) << "\tdone" << std::endl;
+}
+
 
 int main(int argc, char *argv[]) {
   RDLog::InitLogs();
@@ -1005,6 +1175,7 @@ int main(int argc, char *argv[]) {
   testIssue285();
   testAtomResidues();
   testGithub149();
+  testCompactPickles(doLong);
 
 }
       
@@ -34,21 +34,29 @@ BOOL APIENTRY DllMain( HANDLE hModule,
 }
 #endif
 
-typedef double real;
-
+#include "HierarchicalClustering.h"
+#include <vector>
 
+typedef double real;
 
-extern "C"
-void distdriver_(boost::int64_t *n,boost::int64_t *len,
-		 real *dists,
-		 boost::int64_t *toggle,
-		 boost::int64_t *ia,boost::int64_t *ib,real *crit);
+// copies the clustering history into the (Fortran style) arrays
+// returned to Python
+void clusterWithHistory(real *dists,boost::int64_t n,boost::int64_t iopt,
+                        boost::int64_t *ia,boost::int64_t *ib,real *crit){
+  std::vector<int> tia,tib;
+  std::vector<double> tcrit;
+  RDClustering::hierarchicalCluster(dists,n,
+                                    static_cast<RDClustering::ClusterMethod>(iopt),
+                                    tia,tib,tcrit);
+  for(unsigned int i=0;i<tia.size();++i){
+    ia[i]=tia[i];
+    ib[i]=tib[i];
+    crit[i]=tcrit[i];
+  }
+}
 
 //
-// Rather than deal with any nonsense like trying to get
-// the distance matrix built properly on the f2c side of things
-// (thus drowning in the waves of f2c hate), we'll generate
-// the distance matrix on our own here and then call distdriver_
+// generate the distance matrix from the points and cluster it
 //
 void clusterit(real *dataP,boost::int64_t n,boost::int64_t m,boost::int64_t iopt,
 	       boost::int64_t *ia,boost::int64_t *ib,real *crit){
@@ -70,7 +78,7 @@ void clusterit(real *dataP,boost::int64_t n,boost::int64_t m,boost::int64_t iopt
       pos++;
     }
   }
-  distdriver_(&n,&len,dists,&iopt,ia,ib,crit);
+  clusterWithHistory(dists,n,iopt,ia,ib,crit);
   free(dists);
 };
 
@@ -120,10 +128,7 @@ Clustering_MurtaghCluster(PyObject *self,PyObject *args)
 
 void distclusterit(real *dists,boost::int64_t n,boost::int64_t iopt,
 		   boost::int64_t *ia,boost::int64_t *ib,real *crit){
-  boost::int64_t len;
-
-  len = (n*(n-1))/2;
-  distdriver_(&n,&len,dists,&iopt,ia,ib,crit);
+  clusterWithHistory(dists,n,iopt,ia,ib,crit);
 };
 
 
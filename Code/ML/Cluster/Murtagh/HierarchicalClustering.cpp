@@ -0,0 +1,434 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "HierarchicalClustering.h"
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDThreads.h>
+
+#include <algorithm>
+#include <limits>
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#include <boost/thread/barrier.hpp>
+#endif
+
+namespace RDClustering {
+  namespace {
+    const double INF=1e20;
+    // below this many items loops are not split between threads:
+    const size_t minParallelSize=4096;
+
+    inline size_t triIdx(unsigned int i,unsigned int j){
+      if(i<j) std::swap(i,j);
+      return static_cast<size_t>(i)*(i-1)/2+j;
+    }
+
+    // the dissimilarity between cluster k and the union of clusters i and j
+    // (the Lance-Williams update), written as in Murtagh's code
+    inline double lanceWilliams(ClusterMethod method,double dik,double djk,
+                                double dij,double ni,double nj,double nk){
+      switch(method){
+      case WARD:
+        return ((ni+nk)*dik+(nj+nk)*djk-nk*dij)/(ni+nj+nk);
+      case SLINK:
+        return std::min(dik,djk);
+      case CLINK:
+        return std::max(dik,djk);
+      case UPGMA:
+        return (ni*dik+nj*djk)/(ni+nj);
+      case MCQUITTY:
+        return 0.5*dik+0.5*djk;
+      case GOWER:
+        return 0.5*dik+0.5*djk-0.25*dij;
+      case CENTROID:
+        return (ni*dik+nj*djk-ni*nj*dij/(ni+nj))/(ni+nj);
+      default:
+        CHECK_INVARIANT(0,"bad clustering method");
+      }
+      return 0.0;
+    }
+
+    // ------------------------------------------------------------
+    // Runs loops over [0,size) on a fixed set of threads. The threads
+    // are kept around for the whole clustering, since a single loop
+    // is far too short to pay for starting them.
+    class LoopTask {
+    public:
+      virtual ~LoopTask() {};
+      virtual void run(size_t begin,size_t end,unsigned int threadIdx)=0;
+    };
+
+    class LoopRunner {
+    public:
+      explicit LoopRunner(unsigned int numThreads) : d_numThreads(numThreads)
+#ifdef RDK_THREADSAFE_SSS
+        ,d_start(numThreads),d_done(numThreads),df_stop(false),
+        dp_task(0),d_size(0)
+#endif
+      {
+#ifdef RDK_THREADSAFE_SSS
+        for(unsigned int i=1;i<d_numThreads;++i){
+          d_threads.add_thread(new boost::thread(&LoopRunner::workerLoop,this,i));
+        }
+#else
+        d_numThreads=1;
+#endif
+      };
+      ~LoopRunner(){
+#ifdef RDK_THREADSAFE_SSS
+        if(d_numThreads>1){
+          df_stop=true;
+          d_start.wait();
+          d_threads.join_all();
+        }
+#endif
+      };
+      unsigned int numThreads() const { return d_numThreads; };
+      void run(LoopTask &task,size_t size){
+#ifdef RDK_THREADSAFE_SSS
+        if(d_numThreads>1 && size>=minParallelSize){
+          dp_task=&task;
+          d_size=size;
+          d_start.wait();
+          runChunk(0);
+          d_done.wait();
+          return;
+        }
+#endif
+        task.run(0,size,0);
+      };
+    private:
+      unsigned int d_numThreads;
+#ifdef RDK_THREADSAFE_SSS
+      boost::barrier d_start,d_done;
+      bool df_stop;
+      LoopTask *dp_task;
+      size_t d_size;
+      boost::thread_group d_threads;
+
+      void runChunk(unsigned int threadIdx){
+        size_t chunk=(d_size+d_numThreads-1)/d_numThreads;
+        size_t begin=std::min(threadIdx*chunk,d_size);
+        size_t end=std::min(begin+chunk,d_size);
+        dp_task->run(begin,end,threadIdx);
+      }
+      void workerLoop(unsigned int threadIdx){
+        while(true){
+          d_start.wait();
+          if(df_stop) return;
+          runChunk(threadIdx);
+          d_done.wait();
+        }
+      }
+#endif
+    };
+
+    // ------------------------------------------------------------
+    template <typename T>
+    class HalveTask : public LoopTask {
+    public:
+      explicit HalveTask(T *dists) : dp_dists(dists) {};
+      void run(size_t begin,size_t end,unsigned int){
+        for(size_t i=begin;i<end;++i) dp_dists[i]/=2.;
+      }
+    private:
+      T *dp_dists;
+    };
+
+    // finds the nearest active neighbour of cluster a, ties go to the
+    // lowest index
+    template <typename T>
+    class NearestNeighborTask : public LoopTask {
+    public:
+      NearestNeighborTask(const T *dists,const std::vector<unsigned int> &active,
+                          unsigned int numThreads) :
+        dp_dists(dists),d_active(active),d_best(numThreads) {};
+      void find(LoopRunner &runner,unsigned int a,double &dmin,unsigned int &nbr){
+        d_a=a;
+        std::fill(d_best.begin(),d_best.end(),
+                  std::make_pair(std::numeric_limits<double>::max(),
+                                 std::numeric_limits<unsigned int>::max()));
+        runner.run(*this,d_active.size());
+        std::pair<double,unsigned int> best=*std::min_element(d_best.begin(),d_best.end());
+        dmin=best.first;
+        nbr=best.second;
+      }
+      void run(size_t begin,size_t end,unsigned int threadIdx){
+        std::pair<double,unsigned int> best=d_best[threadIdx];
+        for(size_t p=begin;p<end;++p){
+          unsigned int k=d_active[p];
+          if(k==d_a) continue;
+          std::pair<double,unsigned int> v(dp_dists[triIdx(d_a,k)],k);
+          if(v<best) best=v;
+        }
+        d_best[threadIdx]=best;
+      }
+    private:
+      const T *dp_dists;
+      const std::vector<unsigned int> &d_active;
+      std::vector<std::pair<double,unsigned int> > d_best;
+      unsigned int d_a;
+    };
+
+    // updates the dissimilarities of the active clusters to cluster i,
+    // which has just absorbed cluster j:
+    template <typename T>
+    class UpdateTask : public LoopTask {
+    public:
+      UpdateTask(T *dists,const std::vector<unsigned int> &active,
+                 const std::vector<double> &sizes,ClusterMethod method) :
+        dp_dists(dists),d_active(active),d_sizes(sizes),d_method(method) {};
+      void update(LoopRunner &runner,unsigned int i,unsigned int j){
+        d_i=i;
+        d_j=j;
+        runner.run(*this,d_active.size());
+      }
+      void run(size_t begin,size_t end,unsigned int){
+        double dij=dp_dists[triIdx(d_i,d_j)];
+        double ni=d_sizes[d_i],nj=d_sizes[d_j];
+        for(size_t p=begin;p<end;++p){
+          unsigned int k=d_active[p];
+          if(k==d_i || k==d_j) continue;
+          T &dik=dp_dists[triIdx(d_i,k)];
+          dik=static_cast<T>(lanceWilliams(d_method,dik,dp_dists[triIdx(d_j,k)],dij,
+                                           ni,nj,d_sizes[k]));
+        }
+      }
+    private:
+      T *dp_dists;
+      const std::vector<unsigned int> &d_active;
+      const std::vector<double> &d_sizes;
+      ClusterMethod d_method;
+      unsigned int d_i,d_j;
+    };
+
+    struct Merge {
+      unsigned int i,j;
+      double crit;
+    };
+
+    // the set of active clusters, in no particular order
+    class ActiveSet {
+    public:
+      explicit ActiveSet(unsigned int n) : d_items(n),d_pos(n) {
+        for(unsigned int i=0;i<n;++i){
+          d_items[i]=i;
+          d_pos[i]=i;
+        }
+      };
+      const std::vector<unsigned int> &items() const { return d_items; };
+      void remove(unsigned int i){
+        unsigned int last=d_items.back();
+        d_items[d_pos[i]]=last;
+        d_pos[last]=d_pos[i];
+        d_items.pop_back();
+      }
+    private:
+      std::vector<unsigned int> d_items,d_pos;
+    };
+
+    // ------------------------------------------------------------
+    // The nearest-neighbour-chain algorithm, for reducible methods.
+    // The merges are found in chain order, not by increasing
+    // dissimilarity.
+    //
+    // Ties in the neighbour search go to the previous element of the
+    // chain, so the chain can't run in a circle, and otherwise to the
+    // lowest index, so the result doesn't depend on the number of
+    // threads.
+    template <typename T>
+    void nnChainCluster(T *dists,unsigned int n,ClusterMethod method,
+                        LoopRunner &runner,std::vector<Merge> &merges){
+      std::vector<double> sizes(n,1.0);
+      ActiveSet active(n);
+      NearestNeighborTask<T> nnTask(dists,active.items(),runner.numThreads());
+      UpdateTask<T> updateTask(dists,active.items(),sizes,method);
+
+      std::vector<unsigned int> chain;
+      chain.reserve(n);
+      double dmin;
+      unsigned int b;
+      while(active.items().size()>1){
+        if(chain.empty()) chain.push_back(active.items()[0]);
+        while(true){
+          unsigned int a=chain.back();
+          nnTask.find(runner,a,dmin,b);
+          if(chain.size()>1){
+            unsigned int prev=chain[chain.size()-2];
+            if(prev==b || dists[triIdx(a,prev)]==dmin) break;
+          }
+          chain.push_back(b);
+        }
+        unsigned int a=chain.back();
+        chain.pop_back();
+        b=chain.back();
+        chain.pop_back();
+
+        Merge merge;
+        merge.i=std::min(a,b);
+        merge.j=std::max(a,b);
+        merge.crit=dists[triIdx(a,b)];
+        merges.push_back(merge);
+
+        updateTask.update(runner,merge.i,merge.j);
+        sizes[merge.i]+=sizes[merge.j];
+        active.remove(merge.j);
+      }
+    }
+
+    // ------------------------------------------------------------
+    // Murtagh's algorithm (a nearest neighbour list with a search for
+    // the closest pair at each step), for the methods that are not
+    // reducible. This follows the Fortran code exactly.
+    template <typename T>
+    void nnListCluster(T *dists,unsigned int n,ClusterMethod method,
+                       LoopRunner &runner,std::vector<Merge> &merges){
+      std::vector<double> sizes(n,1.0);
+      std::vector<bool> flag(n,true);
+      std::vector<unsigned int> nn(n,0);
+      std::vector<double> disnn(n,INF);
+      ActiveSet active(n);
+      UpdateTask<T> updateTask(dists,active.items(),sizes,method);
+
+      for(unsigned int i=0;i<n-1;++i){
+        double dmin=INF;
+        unsigned int jm=i+1;
+        for(unsigned int j=i+1;j<n;++j){
+          double d=dists[triIdx(i,j)];
+          if(d<dmin){
+            dmin=d;
+            jm=j;
+          }
+        }
+        nn[i]=jm;
+        disnn[i]=dmin;
+      }
+
+      for(unsigned int ncl=n;ncl>1;--ncl){
+        double dmin=INF;
+        unsigned int im=0,jm=1;
+        for(unsigned int i=0;i<n-1;++i){
+          if(!flag[i] || disnn[i]>=dmin) continue;
+          dmin=disnn[i];
+          im=i;
+          jm=nn[i];
+        }
+        Merge merge;
+        merge.i=std::min(im,jm);
+        merge.j=std::max(im,jm);
+        merge.crit=dmin;
+        merges.push_back(merge);
+
+        flag[merge.j]=false;
+        updateTask.update(runner,merge.i,merge.j);
+        sizes[merge.i]+=sizes[merge.j];
+        active.remove(merge.j);
+
+        // the new nearest neighbour of the merged cluster:
+        dmin=INF;
+        for(unsigned int k=merge.i+1;k<n;++k){
+          if(!flag[k]) continue;
+          double d=dists[triIdx(merge.i,k)];
+          if(d<dmin){
+            dmin=d;
+            nn[merge.i]=k;
+          }
+        }
+        disnn[merge.i]=dmin;
+
+        // and of the clusters whose neighbours were involved:
+        for(unsigned int i=0;i<n-1;++i){
+          if(!flag[i] || (nn[i]!=merge.i && nn[i]!=merge.j)) continue;
+          dmin=INF;
+          for(unsigned int j=i+1;j<n;++j){
+            if(!flag[j]) continue;
+            double d=dists[triIdx(i,j)];
+            if(d<dmin){
+              dmin=d;
+              nn[i]=j;
+            }
+          }
+          disnn[i]=dmin;
+        }
+      }
+    }
+
+    template <typename T>
+    void clusterIt(T *dists,unsigned int n,ClusterMethod method,
+                   std::vector<int> &ia,std::vector<int> &ib,
+                   std::vector<double> &crit,int numThreads,bool murtaghTies){
+      PRECONDITION(dists || n<2,"bad distance matrix");
+      PRECONDITION(method>=WARD && method<=CENTROID,"bad clustering method");
+      ia.clear();
+      ib.clear();
+      crit.clear();
+      if(n<2) return;
+
+      LoopRunner runner(RDKit::getNumThreadsToUse(numThreads));
+      // Murtagh's code defines Ward's criterion in terms of variances
+      // rather than distances:
+      if(method==WARD){
+        HalveTask<T> halveTask(dists);
+        runner.run(halveTask,static_cast<size_t>(n)*(n-1)/2);
+      }
+
+      std::vector<Merge> merges;
+      merges.reserve(n-1);
+      std::vector<std::pair<double,unsigned int> > order(n-1);
+      if(method!=GOWER && method!=CENTROID && !murtaghTies){
+        nnChainCluster(dists,n,method,runner,merges);
+        // put the merges in order of increasing dissimilarity. Rounding
+        // can leave a merge slightly below one of the merges that formed
+        // its clusters, so each merge is sorted using the largest
+        // dissimilarity in its subtree. Equal keys stay in chain order,
+        // which puts every merge after the ones it depends on.
+        std::vector<double> clusterKeys(n,-INF);
+        for(unsigned int m=0;m<merges.size();++m){
+          double key=std::max(merges[m].crit,
+                              std::max(clusterKeys[merges[m].i],clusterKeys[merges[m].j]));
+          clusterKeys[merges[m].i]=key;
+          order[m]=std::make_pair(key,m);
+        }
+        std::sort(order.begin(),order.end());
+      } else {
+        // these are already in Murtagh's order (which need not be
+        // increasing, the median and centroid methods can produce
+        // inversions):
+        nnListCluster(dists,n,method,runner,merges);
+        for(unsigned int m=0;m<merges.size();++m){
+          order[m]=std::make_pair(0.0,m);
+        }
+      }
+
+      ia.resize(merges.size());
+      ib.resize(merges.size());
+      crit.resize(merges.size());
+      for(unsigned int m=0;m<order.size();++m){
+        const Merge &merge=merges[order[m].second];
+        ia[m]=merge.i+1;
+        ib[m]=merge.j+1;
+        crit[m]=merge.crit;
+      }
+    }
+  }
+
+  void hierarchicalCluster(double *dists,unsigned int n,ClusterMethod method,
+                           std::vector<int> &ia,std::vector<int> &ib,
+                           std::vector<double> &crit,int numThreads,
+                           bool murtaghTies){
+    clusterIt(dists,n,method,ia,ib,crit,numThreads,murtaghTies);
+  }
+  void hierarchicalCluster(float *dists,unsigned int n,ClusterMethod method,
+                           std::vector<int> &ia,std::vector<int> &ib,
+                           std::vector<double> &crit,int numThreads,
+                           bool murtaghTies){
+    clusterIt(dists,n,method,ia,ib,crit,numThreads,murtaghTies);
+  }
+}
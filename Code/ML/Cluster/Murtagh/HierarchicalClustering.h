@@ -0,0 +1,91 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#ifndef _RD_HIERARCHICALCLUSTERING_H_
+#define _RD_HIERARCHICALCLUSTERING_H_
+
+#include <vector>
+#include <cstddef>
+
+namespace RDClustering {
+  /*! \file HierarchicalClustering.h
+
+    \brief agglomerative hierarchical clustering of a distance matrix
+
+    This replaces F. Murtagh's Fortran HC routine and produces the same
+    kind of clustering history (the IA, IB and CRIT arrays):
+
+      - the items are numbered from 1
+      - merge \c i joins the clusters labelled <tt>ia[i]<ib[i]</tt>, the
+        result is labelled \c ia[i] (so a cluster's label is always its
+        smallest member)
+      - \c crit[i] is the dissimilarity between the two clusters when
+        they were merged. For Ward's method these are half the usual
+        values, since the dissimilarities are halved before clustering.
+      - the merges are ordered by increasing \c crit
+
+    For Ward's method, single, complete and average linkage and
+    McQuitty's method the nearest-neighbour-chain algorithm is used; it
+    needs O(N^2) time. The median and centroid methods are not reducible,
+    so they use Murtagh's original nearest-neighbour-list algorithm.
+
+    If several pairs of clusters are equally close, which one is merged
+    first can change the result. The chain breaks these ties in its own,
+    deterministic, way, so the history can differ from the Fortran code's
+    when there are ties (as there often are with similarity values from
+    fingerprints). Without ties the histories are the same. Pass
+    \c murtaghTies to get exactly the Fortran history; all methods then
+    use Murtagh's algorithm, which can need O(N^3) time.
+
+    The dissimilarities are provided in lower triangle order:
+    <tt>d(1,0), d(2,0), d(2,1), d(3,0), ...</tt>, i.e. the distance
+    between items \c i>j is at position <tt>i*(i-1)/2+j</tt>. The matrix
+    is updated in place as clusters are merged, so its contents are
+    meaningless afterwards. Storing the matrix as floats halves the
+    memory needed (the arithmetic is always done in double precision).
+  */
+
+  //! the clustering criteria, the values match Murtagh's IOPT
+  typedef enum {
+    WARD=1,
+    SLINK=2,
+    CLINK=3,
+    UPGMA=4,
+    MCQUITTY=5,
+    GOWER=6,
+    CENTROID=7
+  } ClusterMethod;
+
+  //! clusters \c n items using a lower-triangle dissimilarity matrix
+  /*!
+    \param dists      the dissimilarity matrix, this is modified
+    \param n          the number of items
+    \param method     the clustering criterion
+    \param ia         used to return the first clusters of the merges
+    \param ib         used to return the second clusters of the merges
+    \param crit       used to return the merge dissimilarities
+    \param numThreads the number of threads to use for the dissimilarity
+                      updates and nearest neighbour searches, see
+                      getNumThreadsToUse()
+    \param murtaghTies if set, ties are broken the way Murtagh's code
+                      does it, which is slower
+
+    On return \c ia, \c ib and \c crit have <tt>n-1</tt> entries.
+  */
+  void hierarchicalCluster(double *dists,unsigned int n,ClusterMethod method,
+                           std::vector<int> &ia,std::vector<int> &ib,
+                           std::vector<double> &crit,int numThreads=1,
+                           bool murtaghTies=false);
+  //! \overload
+  void hierarchicalCluster(float *dists,unsigned int n,ClusterMethod method,
+                           std::vector<int> &ia,std::vector<int> &ib,
+                           std::vector<double> &crit,int numThreads=1,
+                           bool murtaghTies=false);
+}
+#endif
@@ -0,0 +1,316 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDLog.h>
+#include <RDGeneral/utils.h>
+#include "HierarchicalClustering.h"
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+using namespace RDClustering;
+using RDKit::feq;
+
+namespace {
+  // euclidean distances between random points, these have no ties:
+  void randomDists(unsigned int n,std::vector<double> &dists){
+    RDKit::rng_type generator(42u);
+    RDKit::uniform_double dist(0,1.0);
+    RDKit::double_source_type randomSource(generator,dist);
+    std::vector<double> pts(3*n);
+    for(unsigned int i=0;i<pts.size();++i) pts[i]=randomSource();
+    dists.clear();
+    for(unsigned int i=1;i<n;++i){
+      for(unsigned int j=0;j<i;++j){
+        double d2=0.0;
+        for(unsigned int k=0;k<3;++k){
+          double d=pts[3*i+k]-pts[3*j+k];
+          d2+=d*d;
+        }
+        dists.push_back(sqrt(d2));
+      }
+    }
+  }
+
+  inline double &elem(std::vector<double> &dists,unsigned int i,unsigned int j){
+    if(i<j) std::swap(i,j);
+    return dists[i*(i-1)/2+j];
+  }
+
+  // the straightforward algorithm: merge the closest pair at every step
+  void referenceCluster(std::vector<double> dists,unsigned int n,ClusterMethod method,
+                        std::vector<int> &ia,std::vector<int> &ib,
+                        std::vector<double> &crit){
+    if(method==WARD){
+      for(unsigned int i=0;i<dists.size();++i) dists[i]/=2.;
+    }
+    std::vector<bool> active(n,true);
+    std::vector<double> sizes(n,1.0);
+    ia.clear();
+    ib.clear();
+    crit.clear();
+    for(unsigned int step=1;step<n;++step){
+      double dmin=1e20;
+      unsigned int im=0,jm=0;
+      for(unsigned int i=0;i<n;++i){
+        if(!active[i]) continue;
+        for(unsigned int j=i+1;j<n;++j){
+          if(!active[j]) continue;
+          if(elem(dists,i,j)<dmin){
+            dmin=elem(dists,i,j);
+            im=i;
+            jm=j;
+          }
+        }
+      }
+      ia.push_back(im+1);
+      ib.push_back(jm+1);
+      crit.push_back(dmin);
+      double ni=sizes[im],nj=sizes[jm];
+      for(unsigned int k=0;k<n;++k){
+        if(!active[k] || k==im || k==jm) continue;
+        double dik=elem(dists,im,k),djk=elem(dists,jm,k),nk=sizes[k];
+        double &d=elem(dists,im,k);
+        switch(method){
+        case WARD: d=((ni+nk)*dik+(nj+nk)*djk-nk*dmin)/(ni+nj+nk); break;
+        case SLINK: d=std::min(dik,djk); break;
+        case CLINK: d=std::max(dik,djk); break;
+        case UPGMA: d=(ni*dik+nj*djk)/(ni+nj); break;
+        case MCQUITTY: d=0.5*dik+0.5*djk; break;
+        default: TEST_ASSERT(0);
+        }
+      }
+      sizes[im]+=sizes[jm];
+      active[jm]=false;
+    }
+  }
+
+  // checks that a history is a valid sequence of merges
+  void checkHistory(unsigned int n,const std::vector<int> &ia,const std::vector<int> &ib,
+                    const std::vector<double> &crit){
+    TEST_ASSERT(ia.size()==n-1);
+    TEST_ASSERT(ib.size()==n-1);
+    TEST_ASSERT(crit.size()==n-1);
+    std::vector<bool> active(n+1,true);
+    for(unsigned int i=0;i<n-1;++i){
+      TEST_ASSERT(ia[i]>=1 && ia[i]<ib[i] && ib[i]<=static_cast<int>(n));
+      TEST_ASSERT(active[ia[i]] && active[ib[i]]);
+      active[ib[i]]=false;
+    }
+  }
+}
+
+void testReference(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "    Testing against the reference algorithm." << std::endl;
+  unsigned int n=150;
+  std::vector<double> dists;
+  randomDists(n,dists);
+  for(int method=WARD;method<=MCQUITTY;++method){
+    std::vector<int> refA,refB;
+    std::vector<double> refCrit;
+    referenceCluster(dists,n,static_cast<ClusterMethod>(method),refA,refB,refCrit);
+
+    std::vector<double> tdists(dists);
+    std::vector<int> ia,ib;
+    std::vector<double> crit;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia,ib,crit);
+    checkHistory(n,ia,ib,crit);
+    TEST_ASSERT(ia==refA);
+    TEST_ASSERT(ib==refB);
+    for(unsigned int i=0;i<crit.size();++i){
+      TEST_ASSERT(feq(crit[i],refCrit[i],1e-8));
+      if(i) TEST_ASSERT(crit[i]>=crit[i-1]);
+    }
+
+    // float storage:
+    std::vector<float> fdists(dists.begin(),dists.end());
+    hierarchicalCluster(&fdists[0],n,static_cast<ClusterMethod>(method),ia,ib,crit);
+    TEST_ASSERT(ia==refA);
+    TEST_ASSERT(ib==refB);
+    for(unsigned int i=0;i<crit.size();++i){
+      TEST_ASSERT(feq(crit[i],refCrit[i],1e-5));
+    }
+  }
+  BOOST_LOG(rdInfoLog) << "  done" << std::endl;
+}
+
+void testNonReducible(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "    Testing the median and centroid methods." << std::endl;
+  unsigned int n=150;
+  std::vector<double> dists;
+  randomDists(n,dists);
+  for(int method=GOWER;method<=CENTROID;++method){
+    std::vector<double> tdists(dists);
+    std::vector<int> ia,ib;
+    std::vector<double> crit;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia,ib,crit);
+    checkHistory(n,ia,ib,crit);
+    // the first merge is always the closest pair:
+    TEST_ASSERT(feq(crit[0],*std::min_element(dists.begin(),dists.end())));
+  }
+  BOOST_LOG(rdInfoLog) << "  done" << std::endl;
+}
+
+void testSmall(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "    Testing small inputs." << std::endl;
+  std::vector<int> ia,ib;
+  std::vector<double> crit;
+  hierarchicalCluster(static_cast<double *>(0),0,WARD,ia,ib,crit);
+  TEST_ASSERT(ia.empty());
+  double d1=1.0;
+  hierarchicalCluster(&d1,1,WARD,ia,ib,crit);
+  TEST_ASSERT(ia.empty());
+  hierarchicalCluster(&d1,2,UPGMA,ia,ib,crit);
+  TEST_ASSERT(ia.size()==1 && ia[0]==1 && ib[0]==2 && feq(crit[0],1.0));
+
+  // three points on a line at 0, 1 and 3:
+  double d3[]={1.0,3.0,2.0};
+  hierarchicalCluster(d3,3,SLINK,ia,ib,crit);
+  TEST_ASSERT(ia.size()==2);
+  TEST_ASSERT(ia[0]==1 && ib[0]==2 && feq(crit[0],1.0));
+  TEST_ASSERT(ia[1]==1 && ib[1]==3 && feq(crit[1],2.0));
+  double d3b[]={1.0,3.0,2.0};
+  hierarchicalCluster(d3b,3,CLINK,ia,ib,crit);
+  TEST_ASSERT(ia[1]==1 && ib[1]==3 && feq(crit[1],3.0));
+  BOOST_LOG(rdInfoLog) << "  done" << std::endl;
+}
+
+void testTies(){
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "    Testing tied dissimilarities." << std::endl;
+  // with ties the result depends on the order of the merges. The
+  // reference values are from Murtagh's Fortran code, they are
+  // reproduced when murtaghTies is set.
+  const unsigned int n=30;
+  std::vector<double> dists(n*(n-1)/2);
+  unsigned int x=1234;
+  for(unsigned int i=0;i<dists.size();++i){
+    x=x*1103515245u+12345u;
+    dists[i]=((x>>16)%10+1)/10.0;
+  }
+  const int refA[5][n-1]={
+    {1,2,5,6,7,10,11,12,13,16,17,23,24,14,5,11,1,7,11,6,2,6,7,6,2,5,1,1,1},
+    {1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1},
+    {1,1,2,5,6,6,7,10,11,12,13,16,24,5,14,22,7,11,10,6,7,2,11,6,1,1,1,1,1},
+    {1,1,2,5,6,6,7,10,11,12,13,16,24,5,14,11,1,6,11,7,7,2,5,5,2,7,1,2,1},
+    {1,1,2,5,6,6,7,10,11,12,13,16,24,5,14,1,11,6,11,7,7,2,5,5,2,1,1,1,1}
+  };
+  const int refB[5][n-1]={
+    {3,4,8,18,9,30,25,15,21,28,20,26,27,19,29,22,16,12,13,24,14,17,23,10,
+     11,6,7,2,5},
+    {3,7,2,4,9,13,8,5,18,6,16,12,15,20,17,21,19,22,23,24,25,11,26,27,28,29,
+     30,10,14},
+    {3,23,4,8,18,20,9,30,25,15,21,28,27,29,19,26,12,13,22,16,17,24,14,7,2,
+     5,6,10,11},
+    {3,23,4,8,18,20,9,30,25,15,21,28,27,29,19,22,12,24,13,26,10,14,6,16,11,
+     17,7,5,2},
+    {3,23,4,8,18,20,9,30,25,15,21,28,27,29,19,12,22,24,13,26,10,14,6,16,11,
+     17,7,2,5}
+  };
+  const double refCrit[5][n-1]={
+    {0.05,0.05,0.05,0.05,0.05,0.05,0.05,0.05,0.05,0.05,0.05,0.05,0.05,0.1,
+     0.1166666667,0.1833333333,0.225,0.3,0.3166666667,0.325,0.375,
+     0.3916666667,0.45,0.4708333333,0.5305555556,0.6731060606,0.765,
+     0.9649707602,1.038867624},
+    {0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,
+     0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.2},
+    {0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.2,0.2,0.3,0.4,
+     0.4,0.5,0.6,0.6,0.7,0.7,0.9,1,1,1,1,1},
+    {0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.2,0.2,0.3,
+     0.3166666667,0.35,0.3666666667,0.4,0.4166666667,0.45,0.46,0.4875,0.49,
+     0.54,0.5633333333,0.5888888889,0.5990430622},
+    {0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.1,0.2,0.2,0.3,0.3,
+     0.3375,0.3875,0.4,0.4125,0.45,0.45625,0.475,0.50625,0.5375,0.5609375,
+     0.606640625,0.6157714844}
+  };
+  for(int method=WARD;method<=MCQUITTY;++method){
+    std::vector<double> tdists(dists);
+    std::vector<int> ia,ib;
+    std::vector<double> crit;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia,ib,crit,1,true);
+    checkHistory(n,ia,ib,crit);
+    for(unsigned int i=0;i<n-1;++i){
+      TEST_ASSERT(ia[i]==refA[method-WARD][i]);
+      TEST_ASSERT(ib[i]==refB[method-WARD][i]);
+      TEST_ASSERT(feq(crit[i],refCrit[method-WARD][i],1e-8));
+    }
+
+    // the chain breaks the ties its own way, but still produces a valid
+    // history in order of increasing dissimilarity:
+    tdists=dists;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia,ib,crit);
+    checkHistory(n,ia,ib,crit);
+    for(unsigned int i=1;i<n-1;++i){
+      TEST_ASSERT(crit[i]>=crit[i-1]);
+    }
+    // single linkage heights don't depend on the order of the merges:
+    if(method==SLINK){
+      for(unsigned int i=0;i<n-1;++i){
+        TEST_ASSERT(feq(crit[i],refCrit[method-WARD][i],1e-8));
+      }
+    }
+  }
+  BOOST_LOG(rdInfoLog) << "  done" << std::endl;
+}
+
+void testThreads(){
+#ifdef RDK_THREADSAFE_SSS
+  BOOST_LOG(rdInfoLog) << "-------------------------------------" << std::endl;
+  BOOST_LOG(rdInfoLog) << "    Testing multithreaded clustering." << std::endl;
+  // large enough that the loops are split between threads:
+  unsigned int n=6000;
+  std::vector<double> dists;
+  randomDists(n,dists);
+  for(int method=WARD;method<=CENTROID;++method){
+    if(method==GOWER) continue;
+    std::vector<double> tdists(dists);
+    std::vector<int> ia1,ib1,ia4,ib4;
+    std::vector<double> crit1,crit4;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia1,ib1,crit1,1);
+    tdists=dists;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia4,ib4,crit4,4);
+    checkHistory(n,ia4,ib4,crit4);
+    TEST_ASSERT(ia1==ia4);
+    TEST_ASSERT(ib1==ib4);
+    TEST_ASSERT(crit1==crit4);
+  }
+  // ties are broken the same way however many threads are used:
+  for(unsigned int i=0;i<dists.size();++i){
+    dists[i]=floor(dists[i]*20.0)/20.0;
+  }
+  for(int method=WARD;method<=MCQUITTY;++method){
+    std::vector<double> tdists(dists);
+    std::vector<int> ia1,ib1,ia4,ib4;
+    std::vector<double> crit1,crit4;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia1,ib1,crit1,1);
+    tdists=dists;
+    hierarchicalCluster(&tdists[0],n,static_cast<ClusterMethod>(method),ia4,ib4,crit4,4);
+    checkHistory(n,ia4,ib4,crit4);
+    TEST_ASSERT(ia1==ia4);
+    TEST_ASSERT(ib1==ib4);
+    TEST_ASSERT(crit1==crit4);
+  }
+  BOOST_LOG(rdInfoLog) << "  done" << std::endl;
+#endif
+}
+
+int main(){
+  RDLog::InitLogs();
+  testSmall();
+  testReference();
+  testNonReducible();
+  testTies();
+  testThreads();
+  return 0;
+}
@@ -11,6 +11,7 @@
 #include "InfoBitRanker.h"
 #include "InfoGainFuncs.h"
 #include <RDGeneral/Invariant.h>
+#include <RDGeneral/RDThreads.h>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -18,6 +19,8 @@
 #include <RDBoost/Exceptions.h>
 #include <algorithm>
 #include <queue>
+#include <iterator>
+#include <boost/dynamic_bitset.hpp>
 
 namespace RDInfoTheory {
   typedef std::pair<double, int> PAIR_D_I;
@@ -130,6 +133,127 @@ namespace RDInfoTheory {
     }
   }
   
+  namespace {
+    typedef boost::dynamic_bitset<>::block_type BLOCK_TYPE;
+    typedef std::vector<BLOCK_TYPE> BLOCK_VECT;
+    const unsigned int bitsPerBlock=boost::dynamic_bitset<>::bits_per_block;
+    // the number of bit slices used for the vertical counters, this allows
+    // (1<<nSlices)-1 vectors to be added before the counters must be flushed
+    const unsigned int nSlices=4;
+    const unsigned int maxSliceCount=(1<<nSlices)-1;
+
+    // adds the set bits in the slice counters to counts and resets the counters
+    void flushSliceCounters(BLOCK_VECT &slices,unsigned int nBlocks,
+                            unsigned int *counts){
+      for(unsigned int bi=0;bi<nBlocks;++bi){
+        BLOCK_TYPE *blockSlices=&slices[bi*nSlices];
+        for(unsigned int si=0;si<nSlices;++si){
+          BLOCK_TYPE bits=blockSlices[si];
+          unsigned int *blockCounts=counts+bi*bitsPerBlock;
+          for(unsigned int i=0;bits;++i,bits>>=1){
+            if(bits&1) blockCounts[i] += 1<<si;
+          }
+          blockSlices[si]=0;
+        }
+      }
+    }
+
+    // counts the bits set in the vectors in the range [start,end)
+    // counts is a nClasses x (nBlocks*bitsPerBlock) matrix
+    void countBits(const std::vector<const ExplicitBitVect *> *bvs,
+                   const std::vector<unsigned int> *labels,
+                   const BLOCK_VECT *maskBlocks,
+                   unsigned int start,unsigned int end,
+                   unsigned int nClasses,unsigned int nBlocks,
+                   std::vector<unsigned int> *counts){
+      unsigned int nCols=nBlocks*bitsPerBlock;
+      std::vector<BLOCK_VECT> slices(nClasses,BLOCK_VECT(nBlocks*nSlices,0));
+      std::vector<unsigned int> nPending(nClasses,0);
+      BLOCK_VECT blocks;
+      blocks.reserve(nBlocks);
+      for(unsigned int idx=start;idx<end;++idx){
+        unsigned int label=(*labels)[idx];
+        blocks.clear();
+        boost::to_block_range(*((*bvs)[idx]->dp_bits),std::back_inserter(blocks));
+        BLOCK_TYPE *clsSlices=&slices[label][0];
+        for(unsigned int bi=0;bi<nBlocks;++bi){
+          BLOCK_TYPE carry=blocks[bi];
+          if(maskBlocks) carry &= (*maskBlocks)[bi];
+          BLOCK_TYPE *blockSlices=clsSlices+bi*nSlices;
+          for(unsigned int si=0;carry && si<nSlices;++si){
+            BLOCK_TYPE tmp=blockSlices[si]&carry;
+            blockSlices[si] ^= carry;
+            carry=tmp;
+          }
+        }
+        if(++nPending[label]==maxSliceCount){
+          flushSliceCounters(slices[label],nBlocks,&(*counts)[label*nCols]);
+          nPending[label]=0;
+        }
+      }
+      for(unsigned int label=0;label<nClasses;++label){
+        if(nPending[label]){
+          flushSliceCounters(slices[label],nBlocks,&(*counts)[label*nCols]);
+        }
+      }
+    }
+  }
+
+  void InfoBitRanker::accumulateVotes(const std::vector<const ExplicitBitVect *> &bvs,
+                                      const std::vector<unsigned int> &labels,
+                                      int numThreads) {
+    PRECONDITION(bvs.size()==labels.size(),"bit vector and label counts do not match");
+    for (unsigned int i=0;i<bvs.size();++i){
+      PRECONDITION(bvs[i],"bad bit vector");
+      RANGE_CHECK(0, labels[i], d_classes-1);
+      CHECK_INVARIANT(bvs[i]->getNumBits() == d_dims, "Incorrect bit vector size");
+    }
+    if(bvs.empty()) return;
+
+    unsigned int nBlocks=bvs[0]->dp_bits->num_blocks();
+    unsigned int nCols=nBlocks*bitsPerBlock;
+    BLOCK_VECT maskBlocks;
+    if(dp_maskBits){
+      boost::to_block_range(*dp_maskBits->dp_bits,std::back_inserter(maskBlocks));
+    }
+    const BLOCK_VECT *maskPtr= dp_maskBits ? &maskBlocks : 0;
+
+    unsigned int nThreads=RDKit::getNumThreadsToUse(numThreads);
+    nThreads=std::min(nThreads,static_cast<unsigned int>(bvs.size()));
+    std::vector< std::vector<unsigned int> > counts(nThreads,
+                                                    std::vector<unsigned int>(d_classes*nCols,0));
+    if(nThreads==1){
+      countBits(&bvs,&labels,maskPtr,0,bvs.size(),d_classes,nBlocks,&counts[0]);
+    }
+#ifdef RDK_THREADSAFE_SSS
+    else {
+      boost::thread_group tg;
+      unsigned int chunkSize=bvs.size()/nThreads;
+      for(unsigned int ti=0;ti<nThreads;++ti){
+        unsigned int start=ti*chunkSize;
+        unsigned int end=(ti==nThreads-1) ? bvs.size() : start+chunkSize;
+        tg.add_thread(new boost::thread(countBits,&bvs,&labels,maskPtr,start,end,
+                                        d_classes,nBlocks,&counts[ti]));
+      }
+      tg.join_all();
+    }
+#endif
+
+    // merge the results:
+    for(unsigned int label=0;label<d_classes;++label){
+      for(unsigned int ti=0;ti<nThreads;++ti){
+        const unsigned int *tCounts=&counts[ti][label*nCols];
+        for(unsigned int i=0;i<d_dims;++i){
+          d_counts[label][i] += tCounts[i];
+        }
+      }
+    }
+    for(unsigned int i=0;i<labels.size();++i){
+      d_clsCount[labels[i]] += 1;
+    }
+    d_nInst += bvs.size();
+  }
+  
   void InfoBitRanker::accumulateVotes(const SparseBitVect &bv, unsigned int label) {
     RANGE_CHECK(0, label, d_classes-1);
     CHECK_INVARIANT(bv.getNumBits() == d_dims, "Incorrect bit vector size");
@@ -50,6 +50,24 @@ namespace RDInfoTheory {
     }
   }
   
+  void BulkAccumulateVotes(InfoBitRanker *ranker, python::object bitVects,
+                           python::object labels, int numThreads) {
+    PySequenceHolder<int> labelSeq(labels);
+    unsigned int nVects=python::len(bitVects);
+    if(nVects!=labelSeq.size()){
+      throw_value_error("the number of bit vectors and labels must match");
+    }
+    std::vector<const ExplicitBitVect *> bvs;
+    std::vector<unsigned int> cLabels;
+    bvs.reserve(nVects);
+    cLabels.reserve(nVects);
+    for (unsigned int i = 0; i < nVects; i++) {
+      bvs.push_back(python::extract<const ExplicitBitVect *>(bitVects[i]));
+      cLabels.push_back(labelSeq[i]);
+    }
+    ranker->accumulateVotes(bvs, cLabels, numThreads);
+  }
+
   void SetBiasList(InfoBitRanker *ranker, python::object classList) {
     RDKit::INT_VECT cList;
     PySequenceHolder<int> bList(classList);
@@ -142,6 +160,16 @@ namespace RDInfoTheory {
              "ARGUMENTS:\n\n"
              "  - bv : bit vector either ExplicitBitVect or SparseBitVect operator\n"
              "  - label : the class label for the bit vector. It is assumed that 0 <= class < nClasses \n")
+        .def("BulkAccumulateVotes", BulkAccumulateVotes,
+             (python::arg("self"), python::arg("bvs"), python::arg("labels"),
+              python::arg("numThreads")=1),
+             "Accumulate the votes for a sequence of bit vectors\n\n"
+             "This is equivalent to calling AccumulateVotes() for each vector, but is faster.\n\n"
+             "ARGUMENTS:\n\n"
+             "  - bvs : sequence of ExplicitBitVects\n"
+             "  - labels : the class label for each bit vector. It is assumed that 0 <= class < nClasses \n"
+             "  - numThreads : (optional) the number of threads to use. Values <= 0 are interpreted\n"
+             "                 relative to the number of hardware threads\n")
         .def ("SetBiasList", SetBiasList,
               "Set the classes to which the entropy calculation should be biased\n\n"
               "This list contains a set of class ids used when in the BIASENTROPY mode of ranking bits. \n"
@@ -158,6 +158,40 @@ class TestCase(unittest.TestCase):
         v=ranker.GetTopN(1)
         self.failUnless(int(v[0][0])==12)
                           
+    def test5BulkAccumulate(self) :
+        nbits = 200
+        nc = 3
+        fps = []
+        acts = []
+        for i in range(500):
+            bv = DataStructs.ExplicitBitVect(nbits)
+            for j in range(nbits):
+                if RDRandom.random() < 0.3:
+                    bv.SetBit(j)
+            fps.append(bv)
+            acts.append(i%nc)
+        for infoType in (rdit.InfoType.ENTROPY,rdit.InfoType.CHISQUARE):
+            rn1 = rdit.InfoBitRanker(nbits, nc, infoType)
+            for fp,act in zip(fps,acts):
+                rn1.AccumulateVotes(fp,act)
+            res1 = rn1.GetTopN(20)
+            for nThreads in (1,2,4):
+                rn2 = rdit.InfoBitRanker(nbits, nc, infoType)
+                rn2.BulkAccumulateVotes(fps,acts,nThreads)
+                res2 = rn2.GetTopN(20)
+                self.failUnless((res1==res2).all())
+
+        rn1 = rdit.InfoBitRanker(nbits, nc)
+        rn1.SetMaskBits(range(0,nbits,3))
+        rn2 = rdit.InfoBitRanker(nbits, nc)
+        rn2.SetMaskBits(range(0,nbits,3))
+        for fp,act in zip(fps,acts):
+            rn1.AccumulateVotes(fp,act)
+        rn2.BulkAccumulateVotes(fps,acts)
+        self.failUnless((rn1.GetTopN(20)==rn2.GetTopN(20)).all())
+
+        self.failUnlessRaises(ValueError,lambda : rn2.BulkAccumulateVotes(fps,acts[:-1]))
+                          
 if __name__ == '__main__':
     unittest.main()
                        
@@ -349,6 +349,123 @@ namespace RDNumeric {
       trans.SetTranslation(move);
       return ssr;
     }
+
+    template <typename T>
+    double CenterPoints(T *points, unsigned int nPoints, const double *weights) {
+      PRECONDITION(points || !nPoints, "no points");
+      double cx=0.0, cy=0.0, cz=0.0, wtsSum=0.0;
+      for (unsigned int i = 0; i < nPoints; ++i) {
+        double w = weights ? weights[i] : 1.0;
+        cx += w*points[3*i];
+        cy += w*points[3*i+1];
+        cz += w*points[3*i+2];
+        wtsSum += w;
+      }
+      if (wtsSum <= 0.0) {
+        return 0.0;
+      }
+      cx /= wtsSum;
+      cy /= wtsSum;
+      cz /= wtsSum;
+      double res = 0.0;
+      for (unsigned int i = 0; i < nPoints; ++i) {
+        double w = weights ? weights[i] : 1.0;
+        double x = points[3*i]-cx, y = points[3*i+1]-cy, z = points[3*i+2]-cz;
+        points[3*i] = static_cast<T>(x);
+        points[3*i+1] = static_cast<T>(y);
+        points[3*i+2] = static_cast<T>(z);
+        res += w*(x*x+y*y+z*z);
+      }
+      return res;
+    }
+
+    double SSRFromInnerProducts(const double innerProd[9], double refSumSq,
+                                double probeSumSq, bool reflect) {
+      double sign = reflect ? -1.0 : 1.0;
+      double Sxx = sign*innerProd[0], Sxy = sign*innerProd[1], Sxz = sign*innerProd[2];
+      double Syx = sign*innerProd[3], Syy = sign*innerProd[4], Syz = sign*innerProd[5];
+      double Szx = sign*innerProd[6], Szy = sign*innerProd[7], Szz = sign*innerProd[8];
+
+      double Sxx2 = Sxx*Sxx, Syy2 = Syy*Syy, Szz2 = Szz*Szz;
+      double Sxy2 = Sxy*Sxy, Syz2 = Syz*Syz, Sxz2 = Sxz*Sxz;
+      double Syx2 = Syx*Syx, Szy2 = Szy*Szy, Szx2 = Szx*Szx;
+
+      double SyzSzymSyySzz2 = 2.0*(Syz*Szy - Syy*Szz);
+      double Sxx2Syy2Szz2Syz2Szy2 = Syy2 + Szz2 - Sxx2 + Syz2 + Szy2;
+
+      // the coefficients of the characteristic polynomial
+      // x^4 + c2*x^2 + c1*x + c0 of the quaternion matrix:
+      double c2 = -2.0*(Sxx2 + Syy2 + Szz2 + Sxy2 + Syx2 + Sxz2 + Szx2 + Syz2 + Szy2);
+      double c1 = 8.0*(Sxx*Syz*Szy + Syy*Szx*Sxz + Szz*Sxy*Syx -
+                       Sxx*Syy*Szz - Syz*Szx*Sxy - Szy*Syx*Sxz);
+
+      double SxzpSzx = Sxz + Szx, SyzpSzy = Syz + Szy, SxypSyx = Sxy + Syx;
+      double SyzmSzy = Syz - Szy, SxzmSzx = Sxz - Szx, SxymSyx = Sxy - Syx;
+      double SxxpSyy = Sxx + Syy, SxxmSyy = Sxx - Syy;
+      double Sxy2Sxz2Syx2Szx2 = Sxy2 + Sxz2 - Syx2 - Szx2;
+
+      double c0 = Sxy2Sxz2Syx2Szx2*Sxy2Sxz2Syx2Szx2
+        + (Sxx2Syy2Szz2Syz2Szy2 + SyzSzymSyySzz2)*(Sxx2Syy2Szz2Syz2Szy2 - SyzSzymSyySzz2)
+        + (-SxzpSzx*SyzmSzy + SxymSyx*(SxxmSyy - Szz))*(-SxzmSzx*SyzpSzy + SxymSyx*(SxxmSyy + Szz))
+        + (-SxzpSzx*SyzpSzy - SxypSyx*(SxxpSyy - Szz))*(-SxzmSzx*SyzmSzy - SxypSyx*(SxxpSyy + Szz))
+        + (SxypSyx*SyzpSzy + SxzpSzx*(SxxmSyy + Szz))*(-SxymSyx*SyzmSzy + SxzpSzx*(SxxpSyy + Szz))
+        + (SxypSyx*SyzmSzy + SxzmSzx*(SxxmSyy - Szz))*(-SxymSyx*SyzpSzy + SxzmSzx*(SxxpSyy - Szz));
+
+      // Newton iteration for the largest root, starting from its upper bound:
+      double e0 = 0.5*(refSumSq + probeSumSq);
+      double lambda = e0;
+      for (unsigned int i = 0; i < 50; ++i) {
+        double old = lambda;
+        double x2 = lambda*lambda;
+        double b = (x2 + c2)*lambda;
+        double a = b + c1;
+        double denom = 2.0*x2*lambda + b + a;
+        if (denom == 0.0) {
+          break;
+        }
+        lambda -= (a*lambda + c0)/denom;
+        if (fabs(lambda - old) < fabs(1.e-11*lambda)) {
+          break;
+        }
+      }
+      double ssr = 2.0*(e0 - lambda);
+      if (ssr < 0.0) {
+        ssr = 0.0;
+      }
+      return ssr;
+    }
+
+    template <typename T>
+    double AlignedSSR(const T *refPoints, double refSumSq,
+                      const T *probePoints, double probeSumSq,
+                      unsigned int nPoints, const double *weights,
+                      bool reflect) {
+      PRECONDITION((refPoints && probePoints) || !nPoints, "no points");
+      double innerProd[9] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+      for (unsigned int i = 0; i < nPoints; ++i) {
+        const T *r = refPoints + 3*i;
+        const T *p = probePoints + 3*i;
+        double w = weights ? weights[i] : 1.0;
+        double rx = w*r[0], ry = w*r[1], rz = w*r[2];
+        innerProd[0] += rx*p[0];
+        innerProd[1] += rx*p[1];
+        innerProd[2] += rx*p[2];
+        innerProd[3] += ry*p[0];
+        innerProd[4] += ry*p[1];
+        innerProd[5] += ry*p[2];
+        innerProd[6] += rz*p[0];
+        innerProd[7] += rz*p[1];
+        innerProd[8] += rz*p[2];
+      }
+      return SSRFromInnerProducts(innerProd, refSumSq, probeSumSq, reflect);
+    }
+
+    template double CenterPoints(float *, unsigned int, const double *);
+    template double CenterPoints(double *, unsigned int, const double *);
+    template double AlignedSSR(const float *, double, const float *, double,
+                               unsigned int, const double *, bool);
+    template double AlignedSSR(const double *, double, const double *, double,
+                               unsigned int, const double *, bool);
   }
 }
 
@@ -39,6 +39,62 @@ namespace RDNumeric {
                        RDGeom::Transform3D &trans,
                        const DoubleVector *weights=0, bool reflect=false, 
                        unsigned int maxIterations=50);
+
+    //! \brief Moves a set of points so that their (weighted) centroid is at
+    //! the origin
+    /*!
+      \param points    3*nPoints coordinates (x,y,z for each point)
+      \param nPoints   the number of points
+      \param weights   (optional) nPoints weights
+
+      \return The (weighted) sum of squared lengths of the centered points,
+              this is needed by AlignedSSR()
+    */
+    template <typename T>
+    double CenterPoints(T *points, unsigned int nPoints, const double *weights=0);
+
+    //! \brief Computes the minimum sum of squared distances between two sets
+    //! of points after optimal superposition
+    /*!
+      This uses the quaternion characteristic polynomial (QCP) method
+      (D.L. Theobald, Acta Cryst. A61:478-480 (2005)): the largest
+      eigenvalue of the quaternion matrix is found by Newton iteration on
+      its characteristic polynomial instead of diagonalizing the matrix.
+      No transform is computed, use AlignPoints() if one is needed.
+
+      \param refPoints    3*nPoints centered coordinates of the reference points
+      \param refSumSq     the value returned by CenterPoints() for \c refPoints
+      \param probePoints  3*nPoints centered coordinates of the probe points
+      \param probeSumSq   the value returned by CenterPoints() for \c probePoints
+      \param nPoints      the number of points
+      \param weights      (optional) nPoints weights, these must be the same
+                          ones used to center the points
+      \param reflect      reflect the probe points (through the origin)
+
+      \return The sum of squared distances between the points,
+              RMSD = sqrt(SSR/numPoints) (or sqrt(SSR/sumOfWeights))
+    */
+    template <typename T>
+    double AlignedSSR(const T *refPoints, double refSumSq,
+                      const T *probePoints, double probeSumSq,
+                      unsigned int nPoints, const double *weights=0,
+                      bool reflect=false);
+
+    //! \brief The QCP step of AlignedSSR(), for callers that compute the
+    //! inner product matrix themselves
+    /*!
+      \param innerProd    the 3x3 matrix of (weighted) sums of products of the
+                          centered coordinates, innerProd[3*i+j] = sum(ref_i*probe_j)
+      \param refSumSq     the (weighted) sum of squared lengths of the
+                          centered reference points
+      \param probeSumSq   the (weighted) sum of squared lengths of the
+                          centered probe points
+      \param reflect      reflect the probe points (through the origin)
+
+      \return The sum of squared distances between the points
+    */
+    double SSRFromInnerProducts(const double innerProd[9], double refSumSq,
+                                double probeSumSq, bool reflect=false);
   }
 }
 
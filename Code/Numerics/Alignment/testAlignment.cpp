@@ -13,6 +13,7 @@
 #include <RDGeneral/Invariant.h>
 #include <Geometry/Transform3D.h>
 #include <Geometry/point.h>
+#include <vector>
 
 #include <math.h>
 
@@ -158,6 +159,80 @@ void testReflection() {
   
 }
 
+void testQCP() {
+  // compare the QCP results with those from AlignPoints:
+  RDKit::rng_type generator(42u);
+  RDKit::uniform_double dist(-2.0, 2.0);
+  RDKit::double_source_type randomSource(generator, dist);
+
+  const unsigned int nPts = 17;
+  for (unsigned int iter = 0; iter < 20; ++iter) {
+    std::vector<RDGeom::Point3D> rpts(nPts), qpts(nPts);
+    std::vector<double> rcoords(3*nPts), qcoords(3*nPts), wts(nPts);
+    DoubleVector weights(nPts);
+    for (unsigned int i = 0; i < nPts; ++i) {
+      rpts[i] = RDGeom::Point3D(randomSource(), randomSource(), randomSource());
+      if (iter%2) {
+        // a noisy copy:
+        qpts[i] = rpts[i] + RDGeom::Point3D(0.1*randomSource(), 0.1*randomSource(),
+                                             0.1*randomSource());
+      } else {
+        qpts[i] = RDGeom::Point3D(randomSource(), randomSource(), randomSource());
+      }
+      wts[i] = 1.0 + 0.25*randomSource();
+      weights.setVal(i, wts[i]);
+    }
+    if (iter%2) {
+      // rotate and translate the copy:
+      RDGeom::Transform3D rot;
+      rot.SetRotation(0.3*iter, RDGeom::Point3D(1.0, 0.5, -0.2));
+      rot.SetTranslation(RDGeom::Point3D(1.0, -2.0, 3.0));
+      for (unsigned int i = 0; i < nPts; ++i) {
+        rot.TransformPoint(qpts[i]);
+      }
+    }
+    RDGeom::Point3DConstPtrVect rptrs, qptrs;
+    for (unsigned int i = 0; i < nPts; ++i) {
+      rptrs.push_back(&rpts[i]);
+      qptrs.push_back(&qpts[i]);
+      rcoords[3*i] = rpts[i].x; rcoords[3*i+1] = rpts[i].y; rcoords[3*i+2] = rpts[i].z;
+      qcoords[3*i] = qpts[i].x; qcoords[3*i+1] = qpts[i].y; qcoords[3*i+2] = qpts[i].z;
+    }
+
+    RDGeom::Transform3D trans;
+    std::vector<double> rc(rcoords), qc(qcoords);
+    double rSumSq = CenterPoints(&rc[0], nPts);
+    double qSumSq = CenterPoints(&qc[0], nPts);
+    for (unsigned int reflect = 0; reflect < 2; ++reflect) {
+      double ssr = AlignPoints(rptrs, qptrs, trans, 0, reflect);
+      double qcp = AlignedSSR(&rc[0], rSumSq, &qc[0], qSumSq, nPts, 0, reflect);
+      TEST_ASSERT(RDKit::feq(ssr, qcp, 1e-4));
+    }
+
+    // weighted:
+    rc = rcoords;
+    qc = qcoords;
+    rSumSq = CenterPoints(&rc[0], nPts, &wts[0]);
+    qSumSq = CenterPoints(&qc[0], nPts, &wts[0]);
+    double ssr = AlignPoints(rptrs, qptrs, trans, &weights);
+    double qcp = AlignedSSR(&rc[0], rSumSq, &qc[0], qSumSq, nPts, &wts[0]);
+    TEST_ASSERT(RDKit::feq(ssr, qcp, 1e-4));
+
+    // single precision:
+    std::vector<float> rf(rcoords.begin(), rcoords.end()), qf(qcoords.begin(), qcoords.end());
+    rSumSq = CenterPoints(&rf[0], nPts);
+    qSumSq = CenterPoints(&qf[0], nPts);
+    ssr = AlignPoints(rptrs, qptrs, trans);
+    qcp = AlignedSSR(&rf[0], rSumSq, &qf[0], qSumSq, nPts);
+    TEST_ASSERT(RDKit::feq(ssr, qcp, 1e-3));
+  }
+
+  // identical points:
+  double pts[9] = {0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0, 0.0};
+  double sumSq = CenterPoints(pts, 3);
+  TEST_ASSERT(RDKit::feq(AlignedSSR(pts, sumSq, pts, sumSq, 3), 0.0));
+}
+
 int main() {
   std::cout << "-----------------------------------------\n";
   std::cout << "Testing Alignment Code\n";
@@ -178,6 +253,10 @@ int main() {
   std::cout << "\t testReflection\n";
   testReflection();
   std::cout << "---------------------------------------\n";
+  std::cout << "\t testQCP\n";
+  testQCP();
+  std::cout << "---------------------------------------\n";
+
   return (0);
 }
 
@@ -0,0 +1,263 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+#include "SubspaceEigenSolver.h"
+#include <RDGeneral/Invariant.h>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <time.h>
+
+#define MAX_ITERATIONS 1000
+#define TOLERANCE 1.0e-6
+#define EXTRA_VECTORS 5
+#define MAX_JACOBI_SWEEPS 50
+
+namespace RDNumeric {
+  namespace EigenSolvers {
+    namespace {
+      // The blocks of vectors are stored row-major as N*bSize arrays, so
+      // that the components of all vectors for a given point are
+      // contiguous.
+
+      // res = mat * vects, where mat is stored as a lower triangle
+      void blockMultiply(const DoubleSymmMatrix &mat,const std::vector<double> &vects,
+                         unsigned int bSize,std::vector<double> &res){
+        unsigned int N=mat.numRows();
+        const double *matData=mat.getData();
+        std::fill(res.begin(),res.end(),0.0);
+        const double *x=&vects[0];
+        double *y=&res[0];
+        for(unsigned int i=0;i<N;++i){
+          const double *row=matData+i*(i+1)/2;
+          double *yi=y+i*bSize;
+          const double *xi=x+i*bSize;
+          for(unsigned int j=0;j<i;++j){
+            double aij=row[j];
+            double *yj=y+j*bSize;
+            const double *xj=x+j*bSize;
+            for(unsigned int c=0;c<bSize;++c){
+              yi[c]+=aij*xj[c];
+              yj[c]+=aij*xi[c];
+            }
+          }
+          double aii=row[i];
+          for(unsigned int c=0;c<bSize;++c){
+            yi[c]+=aii*xi[c];
+          }
+        }
+      }
+
+      double columnDot(const std::vector<double> &a,unsigned int ca,
+                       const std::vector<double> &b,unsigned int cb,
+                       unsigned int N,unsigned int bSize){
+        double res=0.0;
+        for(unsigned int i=0;i<N;++i){
+          res+=a[i*bSize+ca]*b[i*bSize+cb];
+        }
+        return res;
+      }
+
+      // orthonormalizes the columns of vects using two passes of modified
+      // Gram-Schmidt. Columns which are (numerically) linearly dependent on
+      // the preceding ones are replaced with random vectors.
+      void orthonormalize(std::vector<double> &vects,unsigned int N,unsigned int bSize,
+                          unsigned int &seed){
+        for(unsigned int c=0;c<bSize;++c){
+          double origNorm=sqrt(columnDot(vects,c,vects,c,N,bSize));
+          for(unsigned int attempt=0;;++attempt){
+            for(unsigned int pass=0;pass<2;++pass){
+              for(unsigned int p=0;p<c;++p){
+                double d=columnDot(vects,c,vects,p,N,bSize);
+                for(unsigned int i=0;i<N;++i){
+                  vects[i*bSize+c]-=d*vects[i*bSize+p];
+                }
+              }
+            }
+            double norm=sqrt(columnDot(vects,c,vects,c,N,bSize));
+            if(norm>1e-10*origNorm && norm>0.0){
+              for(unsigned int i=0;i<N;++i){
+                vects[i*bSize+c]/=norm;
+              }
+              break;
+            }
+            CHECK_INVARIANT(attempt<10,"could not construct an orthonormal basis");
+            DoubleVector rv(N);
+            rv.setToRandom(++seed);
+            for(unsigned int i=0;i<N;++i){
+              vects[i*bSize+c]=rv[i];
+            }
+            origNorm=1.0;
+          }
+        }
+      }
+
+      // eigenvalues and eigenvectors of a small symmetric matrix (stored
+      // as a full n*n array) using the cyclic Jacobi method. On return the
+      // diagonal of mat holds the eigenvalues and the columns of vecs the
+      // eigenvectors.
+      void jacobiEigen(std::vector<double> &mat,std::vector<double> &vecs,unsigned int n){
+        vecs.assign(n*n,0.0);
+        for(unsigned int i=0;i<n;++i) vecs[i*n+i]=1.0;
+        for(unsigned int sweep=0;sweep<MAX_JACOBI_SWEEPS;++sweep){
+          double off=0.0,diag=0.0;
+          for(unsigned int p=0;p<n;++p){
+            diag+=mat[p*n+p]*mat[p*n+p];
+            for(unsigned int q=p+1;q<n;++q){
+              off+=mat[p*n+q]*mat[p*n+q];
+            }
+          }
+          if(off<=1e-30*diag || off==0.0) break;
+          for(unsigned int p=0;p<n;++p){
+            for(unsigned int q=p+1;q<n;++q){
+              double apq=mat[p*n+q];
+              if(apq==0.0) continue;
+              double theta=(mat[q*n+q]-mat[p*n+p])/(2.0*apq);
+              double t=(theta>=0.0?1.0:-1.0)/(fabs(theta)+sqrt(theta*theta+1.0));
+              double c=1.0/sqrt(t*t+1.0);
+              double s=t*c;
+              for(unsigned int k=0;k<n;++k){
+                double akp=mat[k*n+p],akq=mat[k*n+q];
+                mat[k*n+p]=c*akp-s*akq;
+                mat[k*n+q]=s*akp+c*akq;
+              }
+              for(unsigned int k=0;k<n;++k){
+                double apk=mat[p*n+k],aqk=mat[q*n+k];
+                mat[p*n+k]=c*apk-s*aqk;
+                mat[q*n+k]=s*apk+c*aqk;
+              }
+              for(unsigned int k=0;k<n;++k){
+                double vkp=vecs[k*n+p],vkq=vecs[k*n+q];
+                vecs[k*n+p]=c*vkp-s*vkq;
+                vecs[k*n+q]=s*vkp+c*vkq;
+              }
+            }
+          }
+        }
+      }
+
+      // vects = vects * rot, where rot is bSize*bSize
+      void rotateBlock(std::vector<double> &vects,const std::vector<double> &rot,
+                       const std::vector<unsigned int> &order,
+                       unsigned int N,unsigned int bSize,std::vector<double> &tmp){
+        for(unsigned int i=0;i<N;++i){
+          double *vi=&vects[i*bSize];
+          std::copy(vi,vi+bSize,tmp.begin());
+          for(unsigned int c=0;c<bSize;++c){
+            unsigned int col=order[c];
+            double accum=0.0;
+            for(unsigned int r=0;r<bSize;++r){
+              accum+=tmp[r]*rot[r*bSize+col];
+            }
+            vi[c]=accum;
+          }
+        }
+      }
+
+      class MagnitudeGreater {
+      public:
+        explicit MagnitudeGreater(const std::vector<double> &vals) : d_vals(vals) {};
+        bool operator()(unsigned int a,unsigned int b) const {
+          return fabs(d_vals[a])>fabs(d_vals[b]);
+        }
+      private:
+        const std::vector<double> &d_vals;
+      };
+    }
+
+    bool subspaceEigenSolver(unsigned int numEig, const DoubleSymmMatrix &mat,
+                             DoubleVector &eigenValues, DoubleMatrix *eigenVectors,
+                             int seed) {
+      unsigned int N = mat.numRows();
+      CHECK_INVARIANT(eigenValues.size() >= numEig, "");
+      CHECK_INVARIANT(numEig <= N, "");
+      if(eigenVectors){
+        CHECK_INVARIANT(eigenVectors->numCols() >= N, "");
+        CHECK_INVARIANT(eigenVectors->numRows() >= numEig, "");
+      }
+      if(!numEig) return true;
+
+      unsigned int bSize=std::min(N,numEig+EXTRA_VECTORS);
+      if(seed<=0) seed = clock();
+      unsigned int useed=static_cast<unsigned int>(seed);
+
+      std::vector<double> X(N*bSize),Y(N*bSize),tmp(bSize);
+      std::vector<double> H(bSize*bSize),W;
+      std::vector<double> ritzVals(bSize);
+      std::vector<unsigned int> order(bSize);
+
+      for(unsigned int c=0;c<bSize;++c){
+        DoubleVector rv(N);
+        rv.setToRandom(useed+c);
+        for(unsigned int i=0;i<N;++i){
+          X[i*bSize+c]=rv[i];
+        }
+      }
+      useed+=bSize;
+      orthonormalize(X,N,bSize,useed);
+
+      bool converged=false;
+      for(unsigned int iter=0;iter<MAX_ITERATIONS && !converged;++iter){
+        blockMultiply(mat,X,bSize,Y);
+
+        // Rayleigh-Ritz: solve the problem projected onto the block
+        for(unsigned int p=0;p<bSize;++p){
+          for(unsigned int q=p;q<bSize;++q){
+            double v=0.5*(columnDot(X,p,Y,q,N,bSize)+columnDot(X,q,Y,p,N,bSize));
+            H[p*bSize+q]=v;
+            H[q*bSize+p]=v;
+          }
+        }
+        jacobiEigen(H,W,bSize);
+        for(unsigned int c=0;c<bSize;++c){
+          ritzVals[c]=H[c*bSize+c];
+          order[c]=c;
+        }
+        std::stable_sort(order.begin(),order.end(),MagnitudeGreater(ritzVals));
+        // X and Y now hold the Ritz vectors and mat times them:
+        rotateBlock(X,W,order,N,bSize,tmp);
+        rotateBlock(Y,W,order,N,bSize,tmp);
+
+        double scale=std::max(1.0,fabs(ritzVals[order[0]]));
+        converged=true;
+        for(unsigned int c=0;c<numEig && converged;++c){
+          double theta=ritzVals[order[c]];
+          double resid=0.0;
+          for(unsigned int i=0;i<N;++i){
+            double d=Y[i*bSize+c]-theta*X[i*bSize+c];
+            resid+=d*d;
+          }
+          if(sqrt(resid)>TOLERANCE*scale) converged=false;
+        }
+        if(!converged){
+          X.swap(Y);
+          orthonormalize(X,N,bSize,useed);
+        }
+      }
+
+      for(unsigned int c=0;c<numEig;++c){
+        eigenValues[c]=ritzVals[order[c]];
+        if(eigenVectors){
+          // use the sign convention of the power solver: the largest
+          // component is positive
+          double maxV=0.0;
+          for(unsigned int i=0;i<N;++i){
+            if(fabs(X[i*bSize+c])>fabs(maxV)) maxV=X[i*bSize+c];
+          }
+          double sign=maxV<0.0?-1.0:1.0;
+          double *eigVecData=eigenVectors->getData()+c*eigenVectors->numCols();
+          for(unsigned int i=0;i<N;++i){
+            eigVecData[i]=sign*X[i*bSize+c];
+          }
+        }
+      }
+      return converged;
+    }
+  }
+}
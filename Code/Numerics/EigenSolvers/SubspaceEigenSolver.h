@@ -0,0 +1,64 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//   @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+
+#ifndef _RD_SUBSPACE_EIGENSOLVER_H
+#define _RD_SUBSPACE_EIGENSOLVER_H
+
+#include <Numerics/Vector.h>
+#include <Numerics/Matrix.h>
+#include <Numerics/SymmMatrix.h>
+
+namespace RDNumeric {
+  namespace EigenSolvers {
+    //! Compute the \c numEig eigenvalues of largest magnitude and, optionally,
+    //! the corresponding eigenvectors.
+    /*!
+      
+    \param numEig       the number of eigenvalues we are interested in
+    \param mat          symmetric input matrix of dimension N*N
+    \param eigenValues  Vector used to return the eigenvalues (size = numEig)
+    \param eigenVectors Optional matrix used to return the eigenvectors (size = N*numEig)
+    \param seed         Optional values to seed the random value generator used to 
+                        initialize the eigen vectors
+    \return a boolean indicating whether or not the calculation converged.
+    
+    <b>Notes:</b>
+    - unlike powerEigenSolver(), the matrix is not changed
+    - the results are ordered by decreasing magnitude of the eigenvalues,
+      as they are for powerEigenSolver(). Each eigenvector is scaled so that
+      its component with the largest absolute value is positive.
+    
+    <b>Algorithm:</b>
+    
+    Subspace (block power) iteration with Rayleigh-Ritz projection: a
+    block of a few more vectors than requested is repeatedly multiplied
+    by the matrix and orthonormalized. After each multiplication the
+    eigenproblem projected onto the block is solved with the Jacobi
+    method. Each iteration needs a single pass over the matrix for the
+    whole block and all eigenvectors converge together at a rate given
+    by the ratio of the first eigenvalue outside the block to the
+    requested ones, which is much faster than the power method with
+    deflation when eigenvalues are close.
+    */
+    bool subspaceEigenSolver(unsigned int numEig, const DoubleSymmMatrix &mat,
+                             DoubleVector &eigenValues,
+                             DoubleMatrix *eigenVectors=0, 
+                             int seed=-1);
+    //! \overload
+    inline bool subspaceEigenSolver(unsigned int numEig, const DoubleSymmMatrix &mat,
+                                    DoubleVector &eigenValues,
+                                    DoubleMatrix &eigenVectors, 
+                                    int seed=-1) {
+      return subspaceEigenSolver(numEig,mat,eigenValues,&eigenVectors,seed);
+    }
+  };
+};
+
+#endif
@@ -9,6 +9,7 @@
 //  of the RDKit source tree.
 //
 #include "PowerEigenSolver.h"
+#include "SubspaceEigenSolver.h"
 #include <Numerics/Matrix.h>
 #include <Numerics/SquareMatrix.h>
 #include <Numerics/SymmMatrix.h>
@@ -78,6 +79,82 @@ void test2PowerSolver() {
   TEST_ASSERT(RDKit::feq(eigVecs.getVal(4,0),0.193,0.001));
 }
 
+void testSubspaceSolver() {
+  unsigned int N = 5;
+  DoubleSymmMatrix mat(N, 0.0);
+  double x = 1.732; 
+  double y = 2.268;
+  double z = 3.268;
+  mat.setVal(1,0,1.0);
+  mat.setVal(2,0,x); mat.setVal(2,1,1.0);
+  mat.setVal(3,0,y); mat.setVal(3,1,x); mat.setVal(3,2,1.0);
+  mat.setVal(4,0,z); mat.setVal(4,1,y); mat.setVal(4,2,x); mat.setVal(4,3,1.0);
+
+  DoubleSymmMatrix nmat(mat);
+  DoubleMatrix eigVecs(N, N);
+  DoubleVector eigVals(N);
+  bool converge = subspaceEigenSolver(N, mat, eigVals, eigVecs,23);
+  TEST_ASSERT(converge);
+  // the matrix is not modified:
+  for(unsigned int i=0;i<mat.getDataSize();++i){
+    TEST_ASSERT(mat.getData()[i]==nmat.getData()[i]);
+  }
+  DoubleVector ev1(N), ev2(N);
+  eigVecs.getRow(0, ev1);
+  eigVecs.getRow(1, ev2);
+  TEST_ASSERT(RDKit::feq(ev1.dotProduct(ev2), 0.0, 0.001));
+  TEST_ASSERT(RDKit::feq(ev1.normL2(), 1.0, 0.001));
+  
+  TEST_ASSERT(RDKit::feq(eigVals[0],6.982,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[1],-3.982,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[2],-1.396,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[3],-1.018,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[4],-0.586,0.001));
+  TEST_ASSERT(RDKit::feq(eigVecs.getVal(0,0),0.523,0.001));
+  TEST_ASSERT(RDKit::feq(eigVecs.getVal(2,1),0.194,0.001));
+  TEST_ASSERT(RDKit::feq(eigVecs.getVal(4,0),-.229,0.001));
+
+  // only the largest ones:
+  DoubleMatrix eigVecs2(2, N);
+  DoubleVector eigVals2(2);
+  converge = subspaceEigenSolver(2, mat, eigVals2, eigVecs2,23);
+  TEST_ASSERT(converge);
+  TEST_ASSERT(RDKit::feq(eigVals2[0],6.982,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals2[1],-3.982,0.001));
+  TEST_ASSERT(RDKit::feq(eigVecs2.getVal(0,0),0.523,0.001));
+}
+
+void test2SubspaceSolver() {
+  // degenerate eigenvalues
+  unsigned int N = 5;
+  DoubleSymmMatrix mat(N, 0.0);
+  double x = 1.0;
+  mat.setVal(1,0,x);
+  mat.setVal(2,0,x); mat.setVal(2,1,x);
+  mat.setVal(3,0,x); mat.setVal(3,1,x); mat.setVal(3,2,x);
+  mat.setVal(4,0,x); mat.setVal(4,1,x); mat.setVal(4,2,x); mat.setVal(4,3,x);
+  
+  DoubleVector eigVals(N);
+  DoubleSquareMatrix eigVecs(N);
+  bool converge = subspaceEigenSolver(N, mat, eigVals, eigVecs, 100);
+  TEST_ASSERT(converge);
+  TEST_ASSERT(RDKit::feq(eigVals[0],4.000,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[1],-1.0,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[2],-1.0,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[3],-1.0,0.001));
+  TEST_ASSERT(RDKit::feq(eigVals[4],-1.0,0.001));
+  TEST_ASSERT(RDKit::feq(eigVecs.getVal(0,0),0.447,0.001));
+  for(unsigned int i=0;i<N;++i){
+    DoubleVector evi(N);
+    eigVecs.getRow(i, evi);
+    for(unsigned int j=0;j<i;++j){
+      DoubleVector evj(N);
+      eigVecs.getRow(j, evj);
+      TEST_ASSERT(RDKit::feq(evi.dotProduct(evj), 0.0, 0.001));
+    }
+  }
+}
+
 int main() {
   std::cout << "-----------------------------------------\n";
   std::cout << "Testing EigenSolvers code\n";
@@ -89,6 +166,14 @@ int main() {
   std::cout << "---------------------------------------\n";
   std::cout << "\t test2PowerSolver\n";
   test2PowerSolver();
+
+  std::cout << "---------------------------------------\n";
+  std::cout << "\t testSubspaceSolver\n";
+  testSubspaceSolver();
+
+  std::cout << "---------------------------------------\n";
+  std::cout << "\t test2SubspaceSolver\n";
+  test2SubspaceSolver();
   std::cout << "---------------------------------------\n";
   return (0);
 }
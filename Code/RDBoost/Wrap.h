@@ -99,6 +99,22 @@ void RegisterListConverter(bool noproxy=false){
   }
 }
 
+//! \brief Releases the Python global interpreter lock for the lifetime
+//!        of the object.
+//! Use this around long-running C++ code that neither calls the Python
+//!    API nor creates or destroys Python objects, so that other Python
+//!    threads can run in the meantime. The lock is reacquired when the
+//!    object goes out of scope, including when an exception is thrown.
+class NOGIL {
+public:
+  NOGIL() : dp_state(PyEval_SaveThread()) {};
+  ~NOGIL() { PyEval_RestoreThread(dp_state); };
+private:
+  NOGIL(const NOGIL &);
+  NOGIL &operator=(const NOGIL &);
+  PyThreadState *dp_state;
+};
+
 template <typename T>
 std::vector<T> *pythonObjectToVect(const python::object &obj,T maxV){
   std::vector<T> *res=0;
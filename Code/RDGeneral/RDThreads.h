@@ -0,0 +1,46 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//  @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+//
+#ifndef _RD_THREADS_H
+#define _RD_THREADS_H
+
+#ifdef RDK_THREADSAFE_SSS
+#include <boost/thread.hpp>
+#endif
+
+namespace RDKit{
+  //! returns the number of threads to be used for a parallel operation
+  /*!
+    \param target : the requested number of threads. Values >0 are used
+                    directly, values <=0 are interpreted relative to the
+                    number of hardware threads available (so 0 means
+                    "use them all" and -1 means "all but one").
+
+    Without thread support (RDK_THREADSAFE_SSS not defined) this always
+    returns 1.
+  */
+  inline unsigned int getNumThreadsToUse(int target){
+#ifdef RDK_THREADSAFE_SSS
+    if(target>=1){
+      return static_cast<unsigned int>(target);
+    }
+    int res=static_cast<int>(boost::thread::hardware_concurrency());
+    if(res+target>=1){
+      return static_cast<unsigned int>(res+target);
+    } else {
+      return 1;
+    }
+#else
+    return 1;
+#endif
+  }
+}
+
+#endif
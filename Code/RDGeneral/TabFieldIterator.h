@@ -0,0 +1,116 @@
+//
+//  Copyright (C) 2014 Greg Landrum
+//
+//  @@ All Rights Reserved @@
+//  This file is part of the RDKit.
+//  The contents are covered by the terms of the BSD license
+//  which is included in the file license.txt, found at the root
+//  of the RDKit source tree.
+//
+//
+#ifndef _RD_TABFIELDITERATOR_H
+#define _RD_TABFIELDITERATOR_H
+
+#include <string>
+#include <cstdlib>
+#include <clocale>
+#include <limits>
+#include <boost/lexical_cast.hpp>
+
+namespace RDKit{
+  //! iterates over the tab-separated fields of a line without copying them
+  /*!
+    This is a light-weight replacement for a boost::tokenizer with a
+    "\t" char_separator, intended for reading the (large) embedded
+    parameter tables. Dereferencing the iterator returns a pointer to the
+    start of the current field inside the line; the field extends to the
+    next tab (or the end of the line). As with the tokenizer, empty
+    fields are skipped.
+
+    <b>Notes:</b>
+      - the line must outlive the iterator
+  */
+  class TabFieldIterator {
+  public:
+    explicit TabFieldIterator(const std::string &line) : dp_pos(line.c_str()) {
+      skipTabs();
+    }
+    const char *operator*() const { return dp_pos; }
+    TabFieldIterator &operator++() {
+      while(*dp_pos && *dp_pos!='\t') ++dp_pos;
+      skipTabs();
+      return *this;
+    }
+    //! returns whether or not there is a current field
+    bool atEnd() const { return !(*dp_pos); }
+  private:
+    const char *dp_pos;
+    void skipTabs() {
+      while(*dp_pos=='\t') ++dp_pos;
+    }
+  };
+
+  //! returns the field starting at \c field as a string
+  inline std::string fieldToString(const char *field){
+    const char *end=field;
+    while(*end && *end!='\t') ++end;
+    return std::string(field,end-field);
+  }
+
+  namespace detail {
+    inline bool isFieldEnd(char c){
+      return c=='\0' || c=='\t';
+    }
+  }
+  //! converts the field starting at \c field to an unsigned int
+  /*!
+    throws a boost::bad_lexical_cast if the field is not a number, so
+    callers behave as they did with boost::lexical_cast. Unlike
+    strtoul(), this does not accept whitespace, signs or values that
+    overflow.
+  */
+  inline unsigned int fieldToUInt(const char *field){
+    const char *end=field;
+    unsigned long res=0;
+    while(*end>='0' && *end<='9'){
+      res=res*10+(*end-'0');
+      if(res>std::numeric_limits<unsigned int>::max()){
+        throw boost::bad_lexical_cast();
+      }
+      ++end;
+    }
+    if(end==field || !detail::isFieldEnd(*end)){
+      throw boost::bad_lexical_cast();
+    }
+    return static_cast<unsigned int>(res);
+  }
+  //! converts the field starting at \c field to a double
+  /*!
+    throws a boost::bad_lexical_cast if the field is not a number, so
+    callers behave as they did with boost::lexical_cast. Unlike
+    strtod(), this does not accept whitespace, hexadecimal numbers,
+    infinities or NaNs.
+  */
+  inline double fieldToDouble(const char *field){
+    const char *end=field;
+    while(!detail::isFieldEnd(*end)){
+      if(!((*end>='0' && *end<='9') || *end=='.' || *end=='e' || *end=='E' ||
+           *end=='+' || *end=='-')){
+        throw boost::bad_lexical_cast();
+      }
+      ++end;
+    }
+    // strtod() honors the C locale, lexical_cast does not:
+    if(*std::localeconv()->decimal_point!='.'){
+      return boost::lexical_cast<double>(std::string(field,end-field));
+    }
+    char *numEnd;
+    double res=std::strtod(field,&numEnd);
+    if(end==field || numEnd!=end){
+      throw boost::bad_lexical_cast();
+    }
+    return res;
+  }
+}
+
+#endif
@@ -11,13 +11,7 @@
 #include "HierarchicalClusterPicker.h"
 #include <RDGeneral/Invariant.h>
 #include <RDGeneral/types.h>
-
-
-typedef double real;
-extern "C" void distdriver_(long int *n,long int *len,
-                 real *dists,
-                 long int *toggle,
-                 long int *ia,long int *ib,real *crit);
+#include <ML/Cluster/Murtagh/HierarchicalClustering.h>
 
 namespace RDPickers {
 
@@ -29,24 +23,15 @@ namespace RDPickers {
                  "pickSize cannot be larger than the poolSize");
 
     // Do the clustering 
-    long int method = (long int)d_method;
-    long int len = poolSize*(poolSize-1);
-    long int *ia = (long int *)calloc(poolSize, sizeof(long int));
-    long int *ib = (long int *)calloc(poolSize, sizeof(long int));
-    real *crit = (real *)calloc(poolSize,sizeof(real));
-    CHECK_INVARIANT(ia,"failed to allocate memory");
-    CHECK_INVARIANT(ib,"failed to allocate memory");
-    CHECK_INVARIANT(crit,"failed to allocate memory");
-    long int poolSize2=static_cast<long int>(poolSize);
-    
-    distdriver_(&poolSize2, // number of items in the pool
-                &len, // number of entries in the distance matrix
-                (real *)distMat, // distance matrix
-                &method, // the clustering method (ward, slink etc.)
-                ia, // int vector with clustering history
-                ib, // one more clustering history matrix
-                crit // I believe this is a vector the difference in heights of two clusters
-                );
+    std::vector<int> ia,ib;
+    std::vector<double> crit;
+    RDClustering::hierarchicalCluster(const_cast<double *>(distMat), // distance matrix
+                                      poolSize, // number of items in the pool
+                                      static_cast<RDClustering::ClusterMethod>(d_method),
+                                      ia, // int vector with clustering history
+                                      ib, // one more clustering history vector
+                                      crit, // the dissimilarities of the merges
+                                      d_numThreads);
 
     // we have the clusters now merge then until the number of clusters is same
     // as the number of picks we need
@@ -79,9 +64,6 @@ namespace RDPickers {
       // mark the second cluster as removed
       removed.push_back(cx2);
     }
-    free(ia);
-    free(ib);
-    free(crit);
 
     // sort removed so that looping will be easier later
     std::sort(removed.begin(), removed.end());
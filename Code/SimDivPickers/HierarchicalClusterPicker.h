@@ -18,8 +18,8 @@ namespace RDPickers {
   /*! \brief Diversity picker based on hierarchical clustering
    *  
    *  This class inherits from DistPicker since it uses the distance matrix
-   *  for diversity picking. The clustering itself is done using the Murtagh 
-   *  code in $RDBASE/Code/ML/Cluster/Mutagh/
+   *  for diversity picking. The clustering itself is done using the code
+   *  in $RDBASE/Code/ML/Cluster/Murtagh/
    */
   class HierarchicalClusterPicker : public DistPicker {
   public:
@@ -37,9 +37,11 @@ namespace RDPickers {
 
     /*! \brief Constructor - takes a ClusterMethod as an argument
      *
-     * Sets the hierarch clustering method
+     * Sets the hierarch clustering method and the number of threads used
+     * to update the distance matrix (see getNumThreadsToUse())
      */
-    explicit HierarchicalClusterPicker(ClusterMethod clusterMethod) : d_method(clusterMethod) {;};
+    explicit HierarchicalClusterPicker(ClusterMethod clusterMethod,int numThreads=1) :
+      d_method(clusterMethod),d_numThreads(numThreads) {;};
 
     /*! \brief This is the function that does the picking
      *
@@ -84,6 +86,7 @@ namespace RDPickers {
 
   private:
     ClusterMethod d_method;
+    int d_numThreads;
   };
 };
 
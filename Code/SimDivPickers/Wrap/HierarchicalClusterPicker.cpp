@@ -42,7 +42,11 @@ namespace RDPickers {
     copy = (PyArrayObject *)PyArray_CopyFromObject(distMat.ptr(), 
 						   PyArray_DOUBLE, 1,1);
     double *dMat = (double *)copy->data;
-    RDKit::INT_VECT res=picker->pick(dMat, poolSize, pickSize);
+    RDKit::INT_VECT res;
+    {
+      NOGIL gil;
+      res=picker->pick(dMat, poolSize, pickSize);
+    }
     Py_DECREF(copy);
     return res;
   }
@@ -66,7 +70,11 @@ namespace RDPickers {
 						   PyArray_DOUBLE, 1,1);
     double *dMat = (double *)copy->data;
 
-    RDKit::VECT_INT_VECT res=picker->cluster(dMat, poolSize, pickSize);
+    RDKit::VECT_INT_VECT res;
+    {
+      NOGIL gil;
+      res=picker->cluster(dMat, poolSize, pickSize);
+    }
     Py_DECREF(copy);
     return res;
   }
@@ -76,8 +84,9 @@ namespace RDPickers {
       std::string docString = "A class for diversity picking of items using Hierarchical Clustering\n";
       python::class_<HierarchicalClusterPicker>("HierarchicalClusterPicker",
                                                 docString.c_str(),
-                                                python::init<HierarchicalClusterPicker::ClusterMethod>
-                                                (python::args("clusterMethod")))
+                                                python::init<HierarchicalClusterPicker::ClusterMethod,
+                                                python::optional<int> >
+                                                (python::args("clusterMethod","numThreads")))
         .def("Pick", HierarchicalPicks,
              "Pick a diverse subset of items from a pool of items using hierarchical clustering\n"
              "\n"
@@ -48,7 +48,12 @@ namespace RDPickers {
     for(unsigned int i=0;i<python::extract<unsigned int>(firstPicks.attr("__len__")());++i){
       firstPickVect.push_back(python::extract<int>(firstPicks[i]));
     }
-    RDKit::INT_VECT res=picker->pick(dMat, poolSize, pickSize,firstPickVect,seed);
+    RDKit::INT_VECT res;
+    {
+      // the picking itself doesn't touch any python objects
+      NOGIL gil;
+      res=picker->pick(dMat, poolSize, pickSize,firstPickVect,seed);
+    }
     Py_DECREF(copy);
     return res;
   }